@@ -379,6 +379,7 @@ printf("MasterVecFile\n\t'%s'\nMasterMaskFile USED ONLY if 'has_masks' %d is 1\n
          { printf("Failed to store 'in memory' database to %s: %s\n", MasterDBname, sqlite3_errmsg(db)); sqlite3_close(db); exit(EXIT_FAILURE); }
       }
 
+   SQLStmtCacheFinalize(db);
    sqlite3_close(db);
 
    return 0;
@@ -301,6 +301,7 @@ int main(int argc, char **argv)
    ProcessChallenges(MAX_STRING_LEN, db, design_index, ChallengeSetName, num_PIs, num_POs, challenge_num_vecpairs, challenge_num_rise_vecpairs, 
       challenge_first_vecs_b, challenge_second_vecs_b, challenge_masks, do_timing_val_check);
 
+   SQLStmtCacheFinalize(db);
    sqlite3_close(db);
 
    return 0;
@@ -19,10 +19,12 @@
 // SQL commands depend on the structure of the tables in the database. Keeping these all in one place where possible.
 const char *SQL_PUFDesign_get_index_cmd = "SELECT id FROM PUFDesign WHERE netlist_name = ? AND synthesis_name = ?;";
 const char *SQL_PUFDesign_insert_into_cmd = "INSERT INTO PUFDesign (netlist_name, synthesis_name, num_PIs, num_POs) VALUES (?, ?, ?, ?);";
+const char *SQL_PUFDesign_get_num_PIs_POs_cmd = "SELECT num_PIs, num_POs FROM PUFDesign WHERE id = ?;";
 
 const char *SQL_PUFInstance_get_index_cmd = "SELECT id FROM PUFInstance WHERE Instance_name = ? AND Dev = ? AND Placement = ?;";
 const char *SQL_PUFInstance_insert_into_cmd = "INSERT INTO PUFInstance (Instance_name, Dev, Placement, EnrollDate, PUFDesign_id) VALUES (?, ?, ?, ?, ?);";
 const char *SQL_PUFInstance_delete_cmd = "DELETE FROM PUFInstance WHERE id = ?;";
+const char *SQL_PUFInstance_get_info_cmd = "SELECT Instance_name, Dev, Placement FROM PUFInstance WHERE id = ?;";
 
 const char *SQL_Vectors_insert_into_cmd = "INSERT INTO Vectors (vector) VALUES (?);";
 const char *SQL_Vectors_read_vector_cmd = "SELECT vector FROM Vectors WHERE id = ?;";
@@ -30,19 +32,441 @@ const char *SQL_Vectors_get_index_cmd = "SELECT id FROM Vectors WHERE vector = ?
 
 const char *SQL_VecPairs_insert_into_cmd = "INSERT INTO VecPairs (R_F_str, VA, VB, NumPNs, PUFDesign_id) VALUES (?, ?, ?, ?, ?);";
 const char *SQL_VecPairs_get_index_cmd = "SELECT id FROM VecPairs WHERE VA = ? AND VB = ? AND PUFDesign_id = ?;";
+const char *SQL_VecPairs_get_NumPNs_cmd = "SELECT NumPNs FROM VecPairs WHERE id = ?;";
+const char *SQL_VecPairs_get_R_F_str_cmd = "SELECT R_F_str FROM VecPairs WHERE id = ?;";
+const char *SQL_VecPairs_update_NumPNs_cmd = "UPDATE VecPairs SET NumPNs = ? WHERE id = ?;";
 
 const char *SQL_TimingVals_insert_into_cmd = "INSERT INTO TimingVals (VecPair, PO, Ave, TSig, PUFInstance) VALUES (?, ?, ?, ?, ?);";
+const char *SQL_TimingVals_get_Ave_cmd = "SELECT Ave FROM TimingVals WHERE PUFInstance = ? AND VecPair = ? AND PO = ?;";
+const char *SQL_TimingVals_get_TSig_cmd = "SELECT TSig FROM TimingVals WHERE PUFInstance = ? AND VecPair = ? AND PO = ?;";
 
 const char *SQL_PathSelectMasks_insert_into_cmd = "INSERT INTO PathSelectMasks (vector_str) VALUES (?);";
 const char *SQL_PathSelectMasks_get_index_cmd = "SELECT id FROM PathSelectMasks WHERE vector_str = ?;";
 
 const char *SQL_Challenges_insert_into_cmd = "INSERT INTO Challenges (Name, NumVecs, NumRiseVecs, NumPNs, NumRisePNs, PUFDesign_id) VALUES (?, ?, ?, ?, ?, ?);";
 const char *SQL_Challenges_get_index_cmd = "SELECT id FROM Challenges WHERE Name = ?;";
+const char *SQL_Challenges_get_NumVecs_NumPNs_cmd = "SELECT NumVecs, NumRiseVecs, NumPNs, NumRisePNs FROM Challenges WHERE id = ?;";
+const char *SQL_Challenges_update_NumVecs_cmd = "UPDATE Challenges SET NumVecs = ?, NumRiseVecs = ? WHERE id = ?;";
+const char *SQL_Challenges_update_NumPNs_cmd = "UPDATE Challenges SET NumPNs = ?, NumRisePNs = ? WHERE id = ?;";
 
 const char *SQL_ChallengeVecPairs_insert_into_cmd = "INSERT INTO ChallengeVecPairs (Chlng, VecPair, PSM) VALUES (?, ?, ?);";
 const char *SQL_ChallengeVecPairs_get_index_cmd = "SELECT id FROM ChallengeVecPairs WHERE Chlng = ? AND VecPair = ? AND PSM = ?;";
 
 
+// Prepared statement caches, one per thread. See SQLStmtAcquire(). The registry lists every thread's cache so that
+// SQLStmtCacheFinalize() can reach the statements of all threads. It is only locked when a thread creates or drops its 
+// cache and by SQLStmtCacheFinalize(), never on the query path.
+static pthread_key_t SQLStmtCache_key;
+static pthread_once_t SQLStmtCache_key_once = PTHREAD_ONCE_INIT;
+static SQLStmtCacheStruct *SQLStmtCache_registry = NULL;
+static pthread_mutex_t SQLStmtCache_registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+// ========================================================================================================
+// ========================================================================================================
+// FNV-1a hash of the SQL text, mixed with the connection pointer.
+
+static unsigned int SQLStmtHash(sqlite3 *db, const char *SQL_cmd)
+   {
+   unsigned int hash = 2166136261U;
+   uintptr_t db_bits = (uintptr_t)db;
+
+   while ( *SQL_cmd != '\0' )
+      {
+      hash ^= (unsigned char)*SQL_cmd++;
+      hash *= 16777619U;
+      }
+   hash ^= (unsigned int)(db_bits >> 4);
+   hash *= 16777619U;
+
+   return hash;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Rebuild the bucket chains of a cache after entries have been removed or moved. Called with the cache 
+// mutex held.
+
+static void SQLStmtCacheRehash(SQLStmtCacheStruct *SC_ptr)
+   {
+   int entry_num, bucket;
+
+   for ( bucket = 0; bucket < SQL_STMT_CACHE_BUCKETS; bucket++ )
+      SC_ptr->buckets[bucket] = -1;
+   for ( entry_num = 0; entry_num < SC_ptr->num_entries; entry_num++ )
+      {
+      bucket = SC_ptr->entries[entry_num].hash % SQL_STMT_CACHE_BUCKETS;
+      SC_ptr->entries[entry_num].next = SC_ptr->buckets[bucket];
+      SC_ptr->buckets[bucket] = entry_num;
+      }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Thread exit: finalize the thread's statements and drop its cache from the registry.
+
+static void SQLStmtCacheThreadExit(void *arg)
+   {
+   SQLStmtCacheStruct *SC_ptr = (SQLStmtCacheStruct *)arg;
+   SQLStmtCacheStruct **link_ptr;
+   int entry_num;
+
+   pthread_mutex_lock(&SQLStmtCache_registry_mutex);
+   for ( link_ptr = &SQLStmtCache_registry; *link_ptr != NULL; link_ptr = &((*link_ptr)->next) )
+      if ( *link_ptr == SC_ptr )
+         {
+         *link_ptr = SC_ptr->next;
+         break;
+         }
+   pthread_mutex_unlock(&SQLStmtCache_registry_mutex);
+
+   for ( entry_num = 0; entry_num < SC_ptr->num_entries; entry_num++ )
+      {
+      sqlite3_finalize(SC_ptr->entries[entry_num].pStmt);
+      free(SC_ptr->entries[entry_num].SQL_cmd);
+      }
+   pthread_mutex_destroy(&(SC_ptr->mutex));
+   free(SC_ptr);
+
+   return;
+   }
+
+
+static void SQLStmtCacheMakeKey()
+   {
+   if ( pthread_key_create(&SQLStmtCache_key, SQLStmtCacheThreadExit) != 0 )
+      { printf("ERROR: SQLStmtCacheMakeKey(): Failed to create the thread key!\n"); exit(EXIT_FAILURE); }
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// The calling thread's cache, created on first use.
+
+static SQLStmtCacheStruct *SQLStmtCacheGet()
+   {
+   SQLStmtCacheStruct *SC_ptr;
+
+   pthread_once(&SQLStmtCache_key_once, SQLStmtCacheMakeKey);
+   if ( (SC_ptr = (SQLStmtCacheStruct *)pthread_getspecific(SQLStmtCache_key)) != NULL )
+      return SC_ptr;
+
+   if ( (SC_ptr = (SQLStmtCacheStruct *)calloc(1, sizeof(SQLStmtCacheStruct))) == NULL )
+      { printf("ERROR: SQLStmtCacheGet(): Failed to allocate the statement cache!\n"); exit(EXIT_FAILURE); }
+   pthread_mutex_init(&(SC_ptr->mutex), NULL);
+   SQLStmtCacheRehash(SC_ptr);
+   pthread_setspecific(SQLStmtCache_key, SC_ptr);
+
+   pthread_mutex_lock(&SQLStmtCache_registry_mutex);
+   SC_ptr->next = SQLStmtCache_registry;
+   SQLStmtCache_registry = SC_ptr;
+   pthread_mutex_unlock(&SQLStmtCache_registry_mutex);
+
+   return SC_ptr;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Check out a prepared statement for 'SQL_cmd' on connection 'db'. Each thread has its own cache, a hash 
+// table keyed by connection and SQL text, so sqlite3_prepare_v2() runs once per thread, connection and SQL 
+// command rather than once per query and threads never contend for a cache. The statement is marked in use 
+// until SQLStmtRelease() is called. When the same query is already checked out by this thread (nested use), 
+// or every cache entry is in use, an uncached statement is returned and SQLStmtRelease() finalizes it. The 
+// cache keeps its own copy of 'SQL_cmd' since callers may build it in a stack buffer. NOTE: Call 
+// SQLStmtCacheFinalize() before sqlite3_close(), otherwise the close fails with SQLITE_BUSY.
+
+sqlite3_stmt *SQLStmtAcquire(sqlite3 *db, const char *SQL_cmd, char *calling_routine_str)
+   {
+   SQLStmtCacheStruct *SC_ptr = SQLStmtCacheGet();
+   SQLStmtCacheEntryStruct *entry_ptr;
+   sqlite3_stmt *pStmt;
+   unsigned int hash;
+   int entry_num, evict_num, found_busy;
+   int rc;
+
+   hash = SQLStmtHash(db, SQL_cmd);
+
+// The mutex is only contended while SQLStmtCacheFinalize() runs in another thread.
+   pthread_mutex_lock(&(SC_ptr->mutex));
+   SC_ptr->use_cnt++;
+   found_busy = 0;
+   for ( entry_num = SC_ptr->buckets[hash % SQL_STMT_CACHE_BUCKETS]; entry_num != -1; entry_num = entry_ptr->next )
+      {
+      entry_ptr = &(SC_ptr->entries[entry_num]);
+      if ( entry_ptr->hash == hash && entry_ptr->db == db && strcmp(entry_ptr->SQL_cmd, SQL_cmd) == 0 )
+         {
+         if ( entry_ptr->in_use == 1 )
+            {
+            found_busy = 1;
+            break;
+            }
+         entry_ptr->in_use = 1;
+         entry_ptr->last_used = SC_ptr->use_cnt;
+         pthread_mutex_unlock(&(SC_ptr->mutex));
+         return entry_ptr->pStmt;
+         }
+      }
+   pthread_mutex_unlock(&(SC_ptr->mutex));
+
+// Cache miss. Compile the statement without holding the cache mutex.
+   rc = sqlite3_prepare_v2(db, SQL_cmd, strlen(SQL_cmd) + 1, &pStmt, 0);
+   if ( rc != SQLITE_OK )
+      { 
+      printf("ERROR: %s: 'sqlite3_prepare_v2' failed with %d for '%s': %s\n", calling_routine_str, rc, SQL_cmd, sqlite3_errmsg(db)); 
+      exit(EXIT_FAILURE); 
+      }
+   if ( found_busy == 1 )
+      return pStmt;
+
+// Add it to the cache, replacing the least recently used free entry if the cache is full. 
+   pthread_mutex_lock(&(SC_ptr->mutex));
+   if ( SC_ptr->num_entries < SQL_STMT_CACHE_MAX )
+      entry_num = SC_ptr->num_entries++;
+   else
+      {
+      evict_num = -1;
+      for ( entry_num = 0; entry_num < SC_ptr->num_entries; entry_num++ )
+         if ( SC_ptr->entries[entry_num].in_use == 0 && (evict_num == -1 || SC_ptr->entries[entry_num].last_used < SC_ptr->entries[evict_num].last_used) )
+            evict_num = entry_num;
+      entry_num = evict_num;
+      if ( entry_num != -1 )
+         {
+         sqlite3_finalize(SC_ptr->entries[entry_num].pStmt);
+         free(SC_ptr->entries[entry_num].SQL_cmd);
+         }
+      }
+
+   if ( entry_num != -1 )
+      {
+      entry_ptr = &(SC_ptr->entries[entry_num]);
+      entry_ptr->db = db;
+      if ( (entry_ptr->SQL_cmd = (char *)malloc(strlen(SQL_cmd) + 1)) == NULL )
+         { printf("ERROR: %s: Failed to allocate storage for cached SQL command!\n", calling_routine_str); exit(EXIT_FAILURE); }
+      strcpy(entry_ptr->SQL_cmd, SQL_cmd);
+      entry_ptr->hash = hash;
+      entry_ptr->pStmt = pStmt;
+      entry_ptr->in_use = 1;
+      entry_ptr->last_used = SC_ptr->use_cnt;
+      SQLStmtCacheRehash(SC_ptr);
+      }
+   pthread_mutex_unlock(&(SC_ptr->mutex));
+
+#ifdef DEBUG
+printf("SQLStmtAcquire(): %s: Prepared '%s' in cache entry %d\n", calling_routine_str, SQL_cmd, entry_num); fflush(stdout);
+#endif
+
+   return pStmt;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Return a statement obtained from SQLStmtAcquire() by the same thread. The statement is reset and its bindings 
+// cleared so that no pointers to the caller's (SQLITE_STATIC) text or blob buffers are kept. Uncached statements 
+// are finalized.
+
+void SQLStmtRelease(sqlite3_stmt *pStmt)
+   {
+   SQLStmtCacheStruct *SC_ptr = SQLStmtCacheGet();
+   SQLStmtCacheEntryStruct *entry_ptr;
+   unsigned int hash;
+   int entry_num;
+
+// Errors from the last sqlite3_step() are returned again by sqlite3_reset(). The caller already handled them.
+   sqlite3_reset(pStmt);
+   sqlite3_clear_bindings(pStmt);
+
+// sqlite3_sql() returns the text the statement was prepared from, which hashes to the statement's bucket.
+   hash = SQLStmtHash(sqlite3_db_handle(pStmt), sqlite3_sql(pStmt));
+
+   pthread_mutex_lock(&(SC_ptr->mutex));
+   for ( entry_num = SC_ptr->buckets[hash % SQL_STMT_CACHE_BUCKETS]; entry_num != -1; entry_num = entry_ptr->next )
+      {
+      entry_ptr = &(SC_ptr->entries[entry_num]);
+      if ( entry_ptr->pStmt == pStmt )
+         break;
+      }
+   if ( entry_num != -1 )
+      SC_ptr->entries[entry_num].in_use = 0;
+   pthread_mutex_unlock(&(SC_ptr->mutex));
+
+   if ( entry_num == -1 )
+      sqlite3_finalize(pStmt);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Finalize the cached statements of every thread that belong to 'db' (or all of them if 'db' is NULL). MUST 
+// be called before sqlite3_close(). No statement for 'db' may be checked out when this is called.
+
+void SQLStmtCacheFinalize(sqlite3 *db)
+   {
+   SQLStmtCacheStruct *SC_ptr;
+   int entry_num, num_kept;
+
+   pthread_mutex_lock(&SQLStmtCache_registry_mutex);
+   for ( SC_ptr = SQLStmtCache_registry; SC_ptr != NULL; SC_ptr = SC_ptr->next )
+      {
+      pthread_mutex_lock(&(SC_ptr->mutex));
+      num_kept = 0;
+      for ( entry_num = 0; entry_num < SC_ptr->num_entries; entry_num++ )
+         {
+         if ( db == NULL || SC_ptr->entries[entry_num].db == db )
+            {
+            if ( SC_ptr->entries[entry_num].in_use == 1 )
+               { printf("ERROR: SQLStmtCacheFinalize(): Statement '%s' is still in use!\n", SC_ptr->entries[entry_num].SQL_cmd); exit(EXIT_FAILURE); }
+            sqlite3_finalize(SC_ptr->entries[entry_num].pStmt);
+            free(SC_ptr->entries[entry_num].SQL_cmd);
+            }
+         else
+            SC_ptr->entries[num_kept++] = SC_ptr->entries[entry_num];
+         }
+      SC_ptr->num_entries = num_kept;
+      SQLStmtCacheRehash(SC_ptr);
+      pthread_mutex_unlock(&(SC_ptr->mutex));
+      }
+   pthread_mutex_unlock(&SQLStmtCache_registry_mutex);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Typed bind routines for statements from SQLStmtAcquire(). Text and blobs are bound SQLITE_STATIC, so the 
+// caller's buffer MUST remain valid until SQLStmtRelease() is called.
+
+void SQLStmtBindInt(sqlite3_stmt *pStmt, int param_num, int val, char *calling_routine_str)
+   {
+   int rc;
+
+   if ( (rc = sqlite3_bind_int(pStmt, param_num, val)) != SQLITE_OK )
+      { printf("ERROR: %s: Failed to bind integer %d to parameter %d: %d\n", calling_routine_str, val, param_num, rc); exit(EXIT_FAILURE); }
+   return;
+   }
+
+void SQLStmtBindText(sqlite3_stmt *pStmt, int param_num, const char *text, char *calling_routine_str)
+   {
+   int rc;
+
+   if ( (rc = sqlite3_bind_text(pStmt, param_num, text, -1, SQLITE_STATIC)) != SQLITE_OK )
+      { printf("ERROR: %s: Failed to bind text to parameter %d: %d\n", calling_routine_str, param_num, rc); exit(EXIT_FAILURE); }
+   return;
+   }
+
+void SQLStmtBindBlob(sqlite3_stmt *pStmt, int param_num, const unsigned char *blob, int blob_size_bytes, char *calling_routine_str)
+   {
+   int rc;
+
+   if ( (rc = sqlite3_bind_blob(pStmt, param_num, blob, blob_size_bytes, SQLITE_STATIC)) != SQLITE_OK )
+      { printf("ERROR: %s: Failed to bind blob of %d bytes to parameter %d: %d\n", calling_routine_str, blob_size_bytes, param_num, rc); exit(EXIT_FAILURE); }
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Step a statement from SQLStmtAcquire(). Returns 1 when a row is available and 0 when the query is done.
+// Any other return code from sqlite3_step() is an error.
+
+int SQLStmtStep(sqlite3_stmt *pStmt, char *calling_routine_str)
+   {
+   int rc;
+
+   rc = sqlite3_step(pStmt);
+   if ( rc == SQLITE_ROW )
+      return 1;
+   else if ( rc == SQLITE_DONE )
+      return 0;
+
+   printf("ERROR: %s: Return code for 'sqlite3_step' not SQLITE_DONE or SQLITE_ROW => %d: %s\n", calling_routine_str, rc, 
+      sqlite3_errmsg(sqlite3_db_handle(pStmt))); 
+   exit(EXIT_FAILURE);
+
+   return -1;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Typed column routines for the current row of a statement from SQLStmtAcquire(). These replace the string
+// conversions done by GetRowResultInt(), GetRowResultFloat() and GetRowResultString().
+
+int SQLStmtColumnInt(sqlite3_stmt *pStmt, int col_index, char *calling_routine_str)
+   {
+   if ( sqlite3_column_type(pStmt, col_index) != SQLITE_INTEGER )
+      { printf("ERROR: %s: Column %d (%s) is not an integer!\n", calling_routine_str, col_index, sqlite3_column_name(pStmt, col_index)); exit(EXIT_FAILURE); }
+   return sqlite3_column_int(pStmt, col_index);
+   }
+
+float SQLStmtColumnFloat(sqlite3_stmt *pStmt, int col_index, char *calling_routine_str)
+   {
+   int col_type;
+
+   col_type = sqlite3_column_type(pStmt, col_index);
+   if ( col_type != SQLITE_INTEGER && col_type != SQLITE_FLOAT )
+      { printf("ERROR: %s: Column %d (%s) is not numeric!\n", calling_routine_str, col_index, sqlite3_column_name(pStmt, col_index)); exit(EXIT_FAILURE); }
+   return (float)sqlite3_column_double(pStmt, col_index);
+   }
+
+void SQLStmtColumnString(sqlite3_stmt *pStmt, int col_index, int required_string_len, int max_string_len, char *field_val_str, 
+   char *calling_routine_str)
+   {
+   const unsigned char *col_text;
+   int col_len;
+
+   if ( (col_text = sqlite3_column_text(pStmt, col_index)) == NULL )
+      { printf("ERROR: %s: Column %d (%s) is NULL!\n", calling_routine_str, col_index, sqlite3_column_name(pStmt, col_index)); exit(EXIT_FAILURE); }
+   col_len = sqlite3_column_bytes(pStmt, col_index);
+   if ( required_string_len != -1 && col_len != required_string_len )
+      { printf("ERROR: %s: Length of string %d expected to be %d\n", calling_routine_str, col_len, required_string_len); exit(EXIT_FAILURE); }
+   if ( col_len >= max_string_len )
+      { printf("ERROR: %s: Length of string %d exceeds buffer size %d\n", calling_routine_str, col_len, max_string_len); exit(EXIT_FAILURE); }
+   memcpy(field_val_str, col_text, col_len + 1);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Open and close an explicit transaction. Without one, every INSERT and UPDATE is its own autocommit 
+// transaction, which costs a journal sync per row on a filesystem database. NOTE: 'PRAGMA foreign_keys' 
+// is a no-op inside a transaction, so it MUST be set before calling SQLBeginTransaction().
+
+void SQLBeginTransaction(sqlite3 *db)
+   {
+   char *zErrMsg = 0;
+   int fc;
+
+   fc = sqlite3_exec(db, "BEGIN TRANSACTION;", NULL, 0, &zErrMsg);
+   if ( fc != SQLITE_OK )
+      { printf("ERROR: SQLBeginTransaction(): SQL ERROR: %s\n", zErrMsg); sqlite3_free(zErrMsg); exit(EXIT_FAILURE); }
+   return;
+   }
+
+void SQLCommitTransaction(sqlite3 *db)
+   {
+   char *zErrMsg = 0;
+   int fc;
+
+   fc = sqlite3_exec(db, "COMMIT;", NULL, 0, &zErrMsg);
+   if ( fc != SQLITE_OK )
+      { printf("ERROR: SQLCommitTransaction(): SQL ERROR: %s\n", zErrMsg); sqlite3_free(zErrMsg); exit(EXIT_FAILURE); }
+   return;
+   }
+
+
+
 // ===========================================================================================================
 // ===========================================================================================================
 // Got this from https://www.sqlite.org/backup.html. This function is used to load the contents of a database 
@@ -495,24 +919,17 @@ printf("GetAllocateListOfInts(): Called!\n"); fflush(stdout);
 
 void UpdateVecPairsNumPNsField(int max_string_len, sqlite3 *db, int num_vals_per_vecpair, int vecpair_index)
    {
-   char sql_command_str[max_string_len];
-   char *zErrMsg = 0;
-   int fc;
+   sqlite3_stmt *pStmt;
 
 #ifdef DEBUG
 printf("UpdateVecPairsNumPNsField(): Replacing NumPNs for vecpair_index %d with %d\n", vecpair_index, num_vals_per_vecpair); fflush(stdout);
 #endif
 
-   sprintf(sql_command_str, "UPDATE VecPairs SET NumPNs = %d WHERE id = %d;", num_vals_per_vecpair, vecpair_index);
-
-// 'sqlite3_exec' calls sqlite3_prepare_v2(), sqlite3_step(), and sqlite3_finalize(), and can process multiple ';' separated SQL statements. 
-// 'callback' function is called for each row produced in the result set. 4th arg is user-specified data. If an error occurs, 'zErrMesg' is 
-// filled in, otherwise is NULL (if error, it must be freed).
-
-// NOTE: There is no need to have a callback function (is NULL here) because 'UPDATE' does NOT return any result rows.
-   fc = sqlite3_exec(db, sql_command_str, NULL, 0, &zErrMsg);
-   if ( fc != SQLITE_OK )
-      { printf("SQL ERROR: %s\n", zErrMsg); sqlite3_free(zErrMsg); exit(EXIT_FAILURE); }
+   pStmt = SQLStmtAcquire(db, SQL_VecPairs_update_NumPNs_cmd, "UpdateVecPairsNumPNsField()");
+   SQLStmtBindInt(pStmt, 1, num_vals_per_vecpair, "UpdateVecPairsNumPNsField()");
+   SQLStmtBindInt(pStmt, 2, vecpair_index, "UpdateVecPairsNumPNsField()");
+   SQLStmtStep(pStmt, "UpdateVecPairsNumPNsField()");
+   SQLStmtRelease(pStmt);
 
    return;
    }
@@ -524,15 +941,15 @@ printf("UpdateVecPairsNumPNsField(): Replacing NumPNs for vecpair_index %d with
 
 int GetVecPairsNumPNsField(int max_string_len, sqlite3 *db, int vecpair_index)
    {
-   SQLRowStringsStruct row_strings_struct;
-   char sql_command_str[max_string_len];
+   sqlite3_stmt *pStmt;
    int num_PNs_per_vecpair = -1;
-   char *col1_name = "NumPNs";
 
-   sprintf(sql_command_str, "SELECT %s FROM VecPairs WHERE id = %d;", col1_name, vecpair_index);
-   GetStringsDataForRow(max_string_len, db, sql_command_str, &row_strings_struct);
-   GetRowResultInt(&row_strings_struct, "GetVecPairsNumPNsField()", 1, 0, col1_name, &num_PNs_per_vecpair);
-   FreeStringsDataForRow(&row_strings_struct);
+   pStmt = SQLStmtAcquire(db, SQL_VecPairs_get_NumPNs_cmd, "GetVecPairsNumPNsField()");
+   SQLStmtBindInt(pStmt, 1, vecpair_index, "GetVecPairsNumPNsField()");
+   if ( SQLStmtStep(pStmt, "GetVecPairsNumPNsField()") == 0 )
+      { printf("ERROR: GetVecPairsNumPNsField(): No VecPairs row for vecpair_index %d!\n", vecpair_index); exit(EXIT_FAILURE); }
+   num_PNs_per_vecpair = SQLStmtColumnInt(pStmt, 0, "GetVecPairsNumPNsField()");
+   SQLStmtRelease(pStmt);
 
 #ifdef DEBUG
 printf("GetVecPairsNumPNsField(): Got %d for NumPNs for vecpair_index %d\n", num_PNs_per_vecpair, vecpair_index); fflush(stdout);
@@ -548,30 +965,28 @@ printf("GetVecPairsNumPNsField(): Got %d for NumPNs for vecpair_index %d\n", num
 
 int GetVecPairsRiseFallStrField(int max_string_len, sqlite3 *db, int vecpair_index)
    {
-   SQLRowStringsStruct row_strings_struct;
-   char sql_command_str[max_string_len];
-   char rise_fall_str[max_string_len];
-   char *col1_name = "R_F_str";
+   sqlite3_stmt *pStmt;
+   char rise_fall_str[2];
 
-   sprintf(sql_command_str, "SELECT %s FROM VecPairs WHERE id = %d;", col1_name, vecpair_index);
-   row_strings_struct.num_cols = 0;
-   GetStringsDataForRow(max_string_len, db, sql_command_str, &row_strings_struct);
-   GetRowResultString(&row_strings_struct, "GetVecPairsRiseFallStrField()", 1, 0, col1_name, 1, rise_fall_str);
+   pStmt = SQLStmtAcquire(db, SQL_VecPairs_get_R_F_str_cmd, "GetVecPairsRiseFallStrField()");
+   SQLStmtBindInt(pStmt, 1, vecpair_index, "GetVecPairsRiseFallStrField()");
+   if ( SQLStmtStep(pStmt, "GetVecPairsRiseFallStrField()") == 0 )
+      { printf("ERROR: GetVecPairsRiseFallStrField(): No VecPairs row for vecpair_index %d!\n", vecpair_index); exit(EXIT_FAILURE); }
+   SQLStmtColumnString(pStmt, 0, 1, 2, rise_fall_str, "GetVecPairsRiseFallStrField()");
+   SQLStmtRelease(pStmt);
 
 #ifdef DEBUG
-printf("GetVecPairsNumPNsField(): Got %s for R_F_str for vecpair_index %d\n", row_strings_struct.ColStringVals[0], vecpair_index); fflush(stdout);
+printf("GetVecPairsRiseFallStrField(): Got %s for R_F_str for vecpair_index %d\n", rise_fall_str, vecpair_index); fflush(stdout);
 #endif
 
-   FreeStringsDataForRow(&row_strings_struct);
-
 // Sanity check on the expected value for this field.
-   if ( strcmp(rise_fall_str, "R") != 0 && strcmp(rise_fall_str, "F") != 0 )
+   if ( rise_fall_str[0] != 'R' && rise_fall_str[0] != 'F' )
       { 
-      printf("ERROR: GetVecPairsNumPNsField(): Expected to find 'R' or 'F', found %s instead!\n", rise_fall_str); 
+      printf("ERROR: GetVecPairsRiseFallStrField(): Expected to find 'R' or 'F', found %s instead!\n", rise_fall_str); 
       exit(EXIT_FAILURE); 
       }
 
-   if ( strcmp(rise_fall_str, "R") == 0 )
+   if ( rise_fall_str[0] == 'R' )
       return 0;
    else
       return 1;
@@ -584,22 +999,19 @@ printf("GetVecPairsNumPNsField(): Got %s for R_F_str for vecpair_index %d\n", ro
 
 void UpdateChallengesNumVecFields(int max_string_len, sqlite3 *db, int challenge_index, int tot_vecs, int tot_rise_vecs)
    {
-   char sql_command_str[max_string_len];
-   char *zErrMsg = 0;
-   int fc;
+   sqlite3_stmt *pStmt;
 
 #ifdef DEBUG
 printf("UpdateChallengesNumVecFields(): Replacing NumVecs and NumRiseVecs for challenge %d with %d and %d\n", challenge_index, 
    tot_vecs, tot_rise_vecs); fflush(stdout);
 #endif
 
-   sprintf(sql_command_str, "UPDATE Challenges SET NumVecs = %d, NumRiseVecs = %d WHERE id = %d;", tot_vecs, tot_rise_vecs, 
-      challenge_index);
-
-// NOTE: There is no need to have a callback function (is NULL here) because 'UPDATE' does NOT return any result rows.
-   fc = sqlite3_exec(db, sql_command_str, NULL, 0, &zErrMsg);
-   if ( fc != SQLITE_OK )
-      { printf("SQL ERROR: %s\n", zErrMsg); sqlite3_free(zErrMsg); exit(EXIT_FAILURE); }
+   pStmt = SQLStmtAcquire(db, SQL_Challenges_update_NumVecs_cmd, "UpdateChallengesNumVecFields()");
+   SQLStmtBindInt(pStmt, 1, tot_vecs, "UpdateChallengesNumVecFields()");
+   SQLStmtBindInt(pStmt, 2, tot_rise_vecs, "UpdateChallengesNumVecFields()");
+   SQLStmtBindInt(pStmt, 3, challenge_index, "UpdateChallengesNumVecFields()");
+   SQLStmtStep(pStmt, "UpdateChallengesNumVecFields()");
+   SQLStmtRelease(pStmt);
 
    return;
    }
@@ -611,22 +1023,19 @@ printf("UpdateChallengesNumVecFields(): Replacing NumVecs and NumRiseVecs for ch
 
 void UpdateChallengesNumPNFields(int max_string_len, sqlite3 *db, int challenge_index, int tot_PNs, int tot_rise_PNs)
    {
-   char sql_command_str[max_string_len];
-   char *zErrMsg = 0;
-   int fc;
+   sqlite3_stmt *pStmt;
 
 #ifdef DEBUG
 printf("UpdateChallengesNumPNFields(): Replacing NumPNs and NumRisePNs for challenge %d with %d and %d\n", challenge_index, 
    tot_PNs, tot_rise_PNs); fflush(stdout);
 #endif
 
-   sprintf(sql_command_str, "UPDATE Challenges SET NumPNs = %d, NumRisePNs = %d WHERE id = %d;", tot_PNs, tot_rise_PNs, 
-      challenge_index);
-
-// NOTE: There is no need to have a callback function (is NULL here) because 'UPDATE' does NOT return any result rows.
-   fc = sqlite3_exec(db, sql_command_str, NULL, 0, &zErrMsg);
-   if ( fc != SQLITE_OK )
-      { printf("SQL ERROR: %s\n", zErrMsg); sqlite3_free(zErrMsg); exit(EXIT_FAILURE); }
+   pStmt = SQLStmtAcquire(db, SQL_Challenges_update_NumPNs_cmd, "UpdateChallengesNumPNFields()");
+   SQLStmtBindInt(pStmt, 1, tot_PNs, "UpdateChallengesNumPNFields()");
+   SQLStmtBindInt(pStmt, 2, tot_rise_PNs, "UpdateChallengesNumPNFields()");
+   SQLStmtBindInt(pStmt, 3, challenge_index, "UpdateChallengesNumPNFields()");
+   SQLStmtStep(pStmt, "UpdateChallengesNumPNFields()");
+   SQLStmtRelease(pStmt);
 
    return;
    }
@@ -639,21 +1048,17 @@ printf("UpdateChallengesNumPNFields(): Replacing NumPNs and NumRisePNs for chall
 void GetChallengeNumVecsNumPNs(int max_string_len, sqlite3 *db, int *num_vecpairs_ptr, int *num_rising_vecpairs_ptr,
    int *num_PNs_ptr, int *num_rising_PNs_ptr, int challenge_index)
    {
-   SQLRowStringsStruct row_strings_struct;
-   char sql_command_str[max_string_len];
-   char *col1_name = "NumVecs";
-   char *col2_name = "NumRiseVecs";
-   char *col3_name = "NumPNs";
-   char *col4_name = "NumRisePNs";
-
-   sprintf(sql_command_str, "SELECT %s, %s, %s, %s FROM Challenges WHERE id = %d;", col1_name, col2_name, col3_name, col4_name, 
-      challenge_index);
-   GetStringsDataForRow(max_string_len, db, sql_command_str, &row_strings_struct);
-   GetRowResultInt(&row_strings_struct, "GetChallengeNumVecsNumPNs()", 4, 0, col1_name, num_vecpairs_ptr);
-   GetRowResultInt(&row_strings_struct, "GetChallengeNumVecsNumPNs()", 4, 1, col2_name, num_rising_vecpairs_ptr);
-   GetRowResultInt(&row_strings_struct, "GetChallengeNumVecsNumPNs()", 4, 2, col3_name, num_PNs_ptr);
-   GetRowResultInt(&row_strings_struct, "GetChallengeNumVecsNumPNs()", 4, 3, col4_name, num_rising_PNs_ptr);
-   FreeStringsDataForRow(&row_strings_struct);
+   sqlite3_stmt *pStmt;
+
+   pStmt = SQLStmtAcquire(db, SQL_Challenges_get_NumVecs_NumPNs_cmd, "GetChallengeNumVecsNumPNs()");
+   SQLStmtBindInt(pStmt, 1, challenge_index, "GetChallengeNumVecsNumPNs()");
+   if ( SQLStmtStep(pStmt, "GetChallengeNumVecsNumPNs()") == 0 )
+      { printf("ERROR: GetChallengeNumVecsNumPNs(): No Challenges row for challenge index %d!\n", challenge_index); exit(EXIT_FAILURE); }
+   *num_vecpairs_ptr = SQLStmtColumnInt(pStmt, 0, "GetChallengeNumVecsNumPNs()");
+   *num_rising_vecpairs_ptr = SQLStmtColumnInt(pStmt, 1, "GetChallengeNumVecsNumPNs()");
+   *num_PNs_ptr = SQLStmtColumnInt(pStmt, 2, "GetChallengeNumVecsNumPNs()");
+   *num_rising_PNs_ptr = SQLStmtColumnInt(pStmt, 3, "GetChallengeNumVecsNumPNs()");
+   SQLStmtRelease(pStmt);
 
 #ifdef DEBUG
 printf("GetChallengeNumVecsNumPNs(): Got num_vecpairs %d, num_rising_vecpairs %d, num_PNs %d and num_rising_PNs %d for Challenge index %d\n", 
@@ -696,17 +1101,23 @@ void GetChallengeParams(int max_string_len, sqlite3 *db, char *ChallengeSetName,
 
 float GetTimingValsAveField(int max_string_len, sqlite3 *db, int PUF_instance_index, int vecpair_index, int PO_num)
    {
-   SQLRowStringsStruct row_strings_struct;
-   char sql_command_str[max_string_len];
-   char *col1_name = "Ave";
-   float ave_val; 
-
-   sprintf(sql_command_str, "SELECT %s FROM TimingVals WHERE PUFInstance = %d AND VecPair = %d AND PO = %d;", col1_name, 
-      PUF_instance_index, vecpair_index, PO_num);
+   sqlite3_stmt *pStmt;
+   float ave_val;
 
-   GetStringsDataForRow(max_string_len, db, sql_command_str, &row_strings_struct);
-   GetRowResultFloat(&row_strings_struct, "GetTimingValsAveField()", 1, 0, col1_name, &ave_val);
-   FreeStringsDataForRow(&row_strings_struct);
+   pStmt = SQLStmtAcquire(db, SQL_TimingVals_get_Ave_cmd, "GetTimingValsAveField()");
+   SQLStmtBindInt(pStmt, 1, PUF_instance_index, "GetTimingValsAveField()");
+   SQLStmtBindInt(pStmt, 2, vecpair_index, "GetTimingValsAveField()");
+   SQLStmtBindInt(pStmt, 3, PO_num, "GetTimingValsAveField()");
+   if ( SQLStmtStep(pStmt, "GetTimingValsAveField()") == 0 )
+      { 
+      printf("ERROR: GetTimingValsAveField(): No TimingVals row for PUFInstance ID %d, vecpair index %d, PO %d!\n", PUF_instance_index, 
+         vecpair_index, PO_num); 
+      exit(EXIT_FAILURE); 
+      }
+   ave_val = SQLStmtColumnFloat(pStmt, 0, "GetTimingValsAveField()");
+   if ( SQLStmtStep(pStmt, "GetTimingValsAveField()") == 1 )
+      { printf("ERROR: GetTimingValsAveField(): More than 1 row matched in table!\n"); exit(EXIT_FAILURE); }
+   SQLStmtRelease(pStmt);
 
 // FIXED POINT
    ave_val /= 16.0;
@@ -728,18 +1139,25 @@ printf("GetTimingValsAveField(): Got %f for Ave for PUFInstance ID %d, vecpair i
 
 float GetTimingValsTSigField(int max_string_len, sqlite3 *db, int PUF_instance_index, int vecpair_index, int PO_num)
    {
-   SQLRowStringsStruct row_strings_struct;
-   char sql_command_str[max_string_len];
+   sqlite3_stmt *pStmt;
    float tsig_val = -1.0;
-   char *col1_name = "TSig";
 
-   sprintf(sql_command_str, "SELECT %s FROM TimingVals WHERE PUFInstance = %d AND VecPair = %d AND PO = %d;", col1_name, 
-      PUF_instance_index, vecpair_index, PO_num);
-   row_strings_struct.num_cols = 0;
-   GetStringsDataForRow(max_string_len, db, sql_command_str, &row_strings_struct);
-   GetRowResultFloat(&row_strings_struct, "GetTimingValsTSigField()", 1, 0, col1_name, &tsig_val);
-   FreeStringsDataForRow(&row_strings_struct);
+   pStmt = SQLStmtAcquire(db, SQL_TimingVals_get_TSig_cmd, "GetTimingValsTSigField()");
+   SQLStmtBindInt(pStmt, 1, PUF_instance_index, "GetTimingValsTSigField()");
+   SQLStmtBindInt(pStmt, 2, vecpair_index, "GetTimingValsTSigField()");
+   SQLStmtBindInt(pStmt, 3, PO_num, "GetTimingValsTSigField()");
+   if ( SQLStmtStep(pStmt, "GetTimingValsTSigField()") == 0 )
+      { 
+      printf("ERROR: GetTimingValsTSigField(): No TimingVals row for PUFInstance ID %d, vecpair index %d, PO %d!\n", PUF_instance_index, 
+         vecpair_index, PO_num); 
+      exit(EXIT_FAILURE); 
+      }
+   tsig_val = SQLStmtColumnFloat(pStmt, 0, "GetTimingValsTSigField()");
+   if ( SQLStmtStep(pStmt, "GetTimingValsTSigField()") == 1 )
+      { printf("ERROR: GetTimingValsTSigField(): More than 1 row matched in table!\n"); exit(EXIT_FAILURE); }
+   SQLStmtRelease(pStmt);
 
+// FIXED POINT
    tsig_val /= 16.0;
 
 #ifdef DEBUG
@@ -779,19 +1197,16 @@ void GetPUFInstanceIDsForInstanceName(int max_string_len, sqlite3 *db, SQLIntStr
 void GetPUFInstanceInfoForID(int max_string_len, sqlite3 *db, int PUFInstance_id, char *Instance_name, char *Dev, 
    char *Placement)
    {
-   SQLRowStringsStruct row_strings_struct;
-   char sql_command_str[max_string_len];
-   char *col1_name = "Instance_name";
-   char *col2_name = "Dev";
-   char *col3_name = "Placement";
-
-   sprintf(sql_command_str, "SELECT %s, %s, %s FROM PUFInstance WHERE id = %d;", col1_name, col2_name, col3_name, PUFInstance_id);
-   GetStringsDataForRow(max_string_len, db, sql_command_str, &row_strings_struct);
+   sqlite3_stmt *pStmt;
 
-   GetRowResultString(&row_strings_struct, "GetPUFInstanceInfoForID", 3, 0, col1_name, -1, Instance_name);
-   GetRowResultString(&row_strings_struct, "GetPUFInstanceInfoForID", 3, 1, col2_name, -1, Dev);
-   GetRowResultString(&row_strings_struct, "GetPUFInstanceInfoForID", 3, 2, col3_name, -1, Placement);
-   FreeStringsDataForRow(&row_strings_struct);
+   pStmt = SQLStmtAcquire(db, SQL_PUFInstance_get_info_cmd, "GetPUFInstanceInfoForID()");
+   SQLStmtBindInt(pStmt, 1, PUFInstance_id, "GetPUFInstanceInfoForID()");
+   if ( SQLStmtStep(pStmt, "GetPUFInstanceInfoForID()") == 0 )
+      { printf("ERROR: GetPUFInstanceInfoForID(): No PUFInstance row for ID %d!\n", PUFInstance_id); exit(EXIT_FAILURE); }
+   SQLStmtColumnString(pStmt, 0, -1, max_string_len, Instance_name, "GetPUFInstanceInfoForID()");
+   SQLStmtColumnString(pStmt, 1, -1, max_string_len, Dev, "GetPUFInstanceInfoForID()");
+   SQLStmtColumnString(pStmt, 2, -1, max_string_len, Placement, "GetPUFInstanceInfoForID()");
+   SQLStmtRelease(pStmt);
 
    return;
    }
@@ -803,16 +1218,15 @@ void GetPUFInstanceInfoForID(int max_string_len, sqlite3 *db, int PUFInstance_id
 
 void GetPUFDesignNumPIPOFields(int max_string_len, sqlite3 *db, int *num_PIs_ptr, int *num_POs_ptr, int design_index)
    {
-   SQLRowStringsStruct row_strings_struct;
-   char sql_command_str[max_string_len];
-   char *col1_name = "num_PIs";
-   char *col2_name = "num_POs";
+   sqlite3_stmt *pStmt;
 
-   sprintf(sql_command_str, "SELECT %s, %s FROM PUFDesign WHERE id = %d;", col1_name, col2_name, design_index);
-   GetStringsDataForRow(max_string_len, db, sql_command_str, &row_strings_struct);
-   GetRowResultInt(&row_strings_struct, "GetPUFDesignNumPIPOFields()", 2, 0, col1_name, num_PIs_ptr);
-   GetRowResultInt(&row_strings_struct, "GetPUFDesignNumPIPOFields()", 2, 1, col2_name, num_POs_ptr);
-   FreeStringsDataForRow(&row_strings_struct);
+   pStmt = SQLStmtAcquire(db, SQL_PUFDesign_get_num_PIs_POs_cmd, "GetPUFDesignNumPIPOFields()");
+   SQLStmtBindInt(pStmt, 1, design_index, "GetPUFDesignNumPIPOFields()");
+   if ( SQLStmtStep(pStmt, "GetPUFDesignNumPIPOFields()") == 0 )
+      { printf("ERROR: GetPUFDesignNumPIPOFields(): No PUFDesign row for design index %d!\n", design_index); exit(EXIT_FAILURE); }
+   *num_PIs_ptr = SQLStmtColumnInt(pStmt, 0, "GetPUFDesignNumPIPOFields()");
+   *num_POs_ptr = SQLStmtColumnInt(pStmt, 1, "GetPUFDesignNumPIPOFields()");
+   SQLStmtRelease(pStmt);
 
 #ifdef DEBUG
 printf("GetPUFDesignNumPIPOFields(): Got num_PIs %d and num_POs %d for PUFDesign index %d\n", *num_PIs_ptr, *num_POs_ptr, design_index); fflush(stdout);
@@ -867,55 +1281,43 @@ int ReadBinaryBlob(sqlite3 *db, const char *sql_command_str, int id, unsigned ch
       binary_blob[0] = '\0';
       }
 
-// Compile the SELECT statement into a virtual machine.
-   do 
-      {
-      rc = sqlite3_prepare_v2(db, sql_command_str, strlen(sql_command_str) + 1, &pStmt, 0);
-      if( rc != SQLITE_OK )
-         { printf("ERROR: ReadBinaryBlob(): 'sqlite3_prepare_v2' failed\n"); exit(EXIT_FAILURE); }
-
-// Bind the Blob, e.g., binary vector, to the SQL variable.
-      sqlite3_bind_int(pStmt, 1, id);
+// Get the prepared SELECT statement from the statement cache and bind the id to the SQL variable.
+   pStmt = SQLStmtAcquire(db, sql_command_str, "ReadBinaryBlob()");
+   SQLStmtBindInt(pStmt, 1, id, "ReadBinaryBlob()");
 
 // Run the virtual machine. The SQL statement prepared MUST return at most 1 row of data since we call sqlite3_step() ONLY once
 // here. Normally, we would keep calling sqlite3_step until it returned something other than SQLITE_ROW, e.g., SQLITE_DONE. 
 // Multiple kinds of errors can occur as well -- see doc.
-      rc = sqlite3_step(pStmt);
-      if ( rc == SQLITE_ROW )
-         {
+   rc = sqlite3_step(pStmt);
+   if ( rc == SQLITE_ROW )
+      {
 
 // The pointer returned by sqlite3_column_blob() points to memory that is owned by the statement handle (pStmt). It is only good
-// until the next call to an sqlite3_XXX() function (e.g. the sqlite3_finalize() below) that involves the statement handle. 
+// until the next call to an sqlite3_XXX() function (e.g. the SQLStmtRelease() below) that involves the statement handle. 
 // So we need to make a copy of the blob into memory obtained from malloc() to return to the caller.
-         num_bytes_binary_blob = sqlite3_column_bytes(pStmt, 0);
-
-// Added 5/3/2019 for HOST
-         if ( allocate_storage == 0 )
-            {
-            if ( num_bytes_binary_blob != expected_size )
-               { printf("ERROR: ReadBinaryBlob(): UNEXPECTED return size from vector! %d vs expected %d\n", num_bytes_binary_blob, expected_size); exit(EXIT_FAILURE); }
-            memcpy(binary_blob, sqlite3_column_blob(pStmt, 0), num_bytes_binary_blob);
-            }
-         else 
-            {
-            if ( (*binary_blob_ptr = (unsigned char *)calloc(num_bytes_binary_blob, sizeof(unsigned char))) == NULL )
-               { printf("ReadBinaryBlob(): ERROR: Failed to allocate storage for binary_blob of %d bytes\n", num_bytes_binary_blob); exit(EXIT_FAILURE); }
-            memcpy(*binary_blob_ptr, sqlite3_column_blob(pStmt, 0), num_bytes_binary_blob);
-            }
+      num_bytes_binary_blob = sqlite3_column_bytes(pStmt, 0);
+
+// Added 5/3/2019 for HOST
+      if ( allocate_storage == 0 )
+         {
+         if ( num_bytes_binary_blob != expected_size )
+            { printf("ERROR: ReadBinaryBlob(): UNEXPECTED return size from vector! %d vs expected %d\n", num_bytes_binary_blob, expected_size); exit(EXIT_FAILURE); }
+         memcpy(binary_blob, sqlite3_column_blob(pStmt, 0), num_bytes_binary_blob);
+         }
+      else 
+         {
+         if ( (*binary_blob_ptr = (unsigned char *)calloc(num_bytes_binary_blob, sizeof(unsigned char))) == NULL )
+            { printf("ReadBinaryBlob(): ERROR: Failed to allocate storage for binary_blob of %d bytes\n", num_bytes_binary_blob); exit(EXIT_FAILURE); }
+         memcpy(*binary_blob_ptr, sqlite3_column_blob(pStmt, 0), num_bytes_binary_blob);
          }
+      }
 
 // NOT the only possibility, SQLITE_BUSY, SQLITE_DONE, etc. are possible.
-      else
-         { printf("ReadBinaryBlob(): ERROR: UNEXPECTED return value for sqlite3_step() -- More than one row in the results perhaps? %d\n", rc); exit(EXIT_FAILURE); }
-
-// Finalize the statement (this releases resources allocated by sqlite3_prepare() ).
-      rc = sqlite3_finalize(pStmt);
-
-// If sqlite3_finalize() returned SQLITE_SCHEMA, then try to execute the statement all over again.
-      } while( rc == SQLITE_SCHEMA );
+   else
+      { printf("ReadBinaryBlob(): ERROR: UNEXPECTED return value for sqlite3_step() -- More than one row in the results perhaps? %d\n", rc); exit(EXIT_FAILURE); }
 
-   if ( rc != SQLITE_OK )
-      { printf("ReadBinaryBlob(): ERROR: Some other error condition %d\n", rc); exit(EXIT_FAILURE); }
+// Reset the statement and return it to the cache.
+   SQLStmtRelease(pStmt);
 
    return num_bytes_binary_blob;
    }
@@ -929,47 +1331,45 @@ int GetIndexFromTable(int max_string_len, sqlite3 *db, char *Table, const char *
    int blob_size_bytes, char *text1, char *text2, char *text3, char *text4, int int1, int int2, int int3)
    {
    sqlite3_stmt *pStmt;
-   int rc, fc;
+   int rc;
    int index;
 
 #ifdef DEBUG
 printf("GetIndexFromTable(): SQL cmd %s\n", SQL_cmd); fflush(stdout);
 #endif
 
-// Prepare 'pStmt' with SQL query.
-   rc = sqlite3_prepare_v2(db, SQL_cmd, strlen(SQL_cmd) + 1, &pStmt, 0);
-   if( rc != SQLITE_OK )
-      { printf("ERROR: GetIndexFromTable(): 'sqlite3_prepare_v2' failed with %d\n", rc); exit(EXIT_FAILURE); }
+// Get the prepared statement for 'SQL_cmd' from the statement cache.
+   pStmt = SQLStmtAcquire(db, SQL_cmd, "GetIndexFromTable()");
 
 // Bind the variables to '?' in 'SQL_cmd'.
    if ( strcmp(Table, "PUFDesign") == 0 )
       {
-      sqlite3_bind_text(pStmt, 1, text1, -1, SQLITE_STATIC);
-      sqlite3_bind_text(pStmt, 2, text2, -1, SQLITE_STATIC);
+      SQLStmtBindText(pStmt, 1, text1, "GetIndexFromTable()");
+      SQLStmtBindText(pStmt, 2, text2, "GetIndexFromTable()");
       }
    else if ( strcmp(Table, "PUFInstance") == 0 )
       {
-      sqlite3_bind_text(pStmt, 1, text1, -1, SQLITE_STATIC);
-      sqlite3_bind_text(pStmt, 2, text2, -1, SQLITE_STATIC);
-      sqlite3_bind_text(pStmt, 3, text3, -1, SQLITE_STATIC);
+      SQLStmtBindText(pStmt, 1, text1, "GetIndexFromTable()");
+      SQLStmtBindText(pStmt, 2, text2, "GetIndexFromTable()");
+      SQLStmtBindText(pStmt, 3, text3, "GetIndexFromTable()");
       }
    else if ( strcmp(Table, "VecPairs") == 0 )
       {
-      sqlite3_bind_int(pStmt, 1, int1);
-      sqlite3_bind_int(pStmt, 2, int2);
-      sqlite3_bind_int(pStmt, 3, int3);
+      SQLStmtBindInt(pStmt, 1, int1, "GetIndexFromTable()");
+      SQLStmtBindInt(pStmt, 2, int2, "GetIndexFromTable()");
+      SQLStmtBindInt(pStmt, 3, int3, "GetIndexFromTable()");
       }
    else if ( strcmp(Table, "Vectors") == 0 )
-      sqlite3_bind_blob(pStmt, 1, blob, blob_size_bytes, SQLITE_STATIC);
+      SQLStmtBindBlob(pStmt, 1, blob, blob_size_bytes, "GetIndexFromTable()");
    else if ( strcmp(Table, "PathSelectMasks") == 0 )
-      sqlite3_bind_text(pStmt, 1, text1, -1, SQLITE_STATIC);
+      SQLStmtBindText(pStmt, 1, text1, "GetIndexFromTable()");
    else if ( strcmp(Table, "Challenges") == 0 )
-      sqlite3_bind_text(pStmt, 1, text1, -1, SQLITE_STATIC);
+      SQLStmtBindText(pStmt, 1, text1, "GetIndexFromTable()");
    else if ( strcmp(Table, "ChallengeVecPairs") == 0 )
       {
-      sqlite3_bind_int(pStmt, 1, int1);
-      sqlite3_bind_int(pStmt, 2, int2);
-      sqlite3_bind_int(pStmt, 3, int3);
+      SQLStmtBindInt(pStmt, 1, int1, "GetIndexFromTable()");
+      SQLStmtBindInt(pStmt, 2, int2, "GetIndexFromTable()");
+      SQLStmtBindInt(pStmt, 3, int3, "GetIndexFromTable()");
       }
    else
       { printf("ERROR: GetIndexFromTable(): Unknown Table '%s'\n", Table); exit(EXIT_FAILURE); }
@@ -986,8 +1386,7 @@ printf("GetIndexFromTable(): Table '%s', Column type %d => Integer type %d\n", T
 
    index = sqlite3_column_int64(pStmt, 0);
 
-   if ( (fc = sqlite3_finalize(pStmt)) != 0 )
-      { printf("ERROR: GetIndexFromTable(): Finalize failed %d for Table '%s'\n", fc, Table); exit(EXIT_FAILURE); }
+   SQLStmtRelease(pStmt);
 
 // Classify the return code. 'DONE' means search failed while 'ROW' means it found the item.
    if ( rc == SQLITE_DONE )
@@ -1015,78 +1414,74 @@ int InsertIntoTable(int max_string_len, sqlite3 *db, char *Table, const char *SQ
    int int3, int int4, int int5, float float1, float float2)
    {
    sqlite3_stmt *pStmt;
-   int rc, fc;
+   int rc;
 
 #ifdef DEBUG
 printf("InsertIntoTable(): SQL cmd %s\n", SQL_cmd); fflush(stdout);
 #endif
 
-// Prepare 'pStmt' with SQL query.
-   rc = sqlite3_prepare_v2(db, SQL_cmd, strlen(SQL_cmd) + 1, &pStmt, 0);
-   if( rc != SQLITE_OK )
-      { printf("ERROR: InsertIntoTable(): 'sqlite3_prepare_v2' failed with %d\n", rc); exit(EXIT_FAILURE); }
+// Get the prepared statement for 'SQL_cmd' from the statement cache.
+   pStmt = SQLStmtAcquire(db, SQL_cmd, "InsertIntoTable()");
 
 // Insert the Netlist_name into PUFDesign
    if ( strcmp(Table, "PUFDesign") == 0 )
       {
-      sqlite3_bind_text(pStmt, 1, text1, -1, SQLITE_STATIC);
-      sqlite3_bind_text(pStmt, 2, text2, -1, SQLITE_STATIC);
-      sqlite3_bind_int(pStmt, 3, int1);
-      sqlite3_bind_int(pStmt, 4, int2);
+      SQLStmtBindText(pStmt, 1, text1, "InsertIntoTable()");
+      SQLStmtBindText(pStmt, 2, text2, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 3, int1, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 4, int2, "InsertIntoTable()");
       }
    else if ( strcmp(Table, "PUFInstance") == 0 )
       {
-      sqlite3_bind_text(pStmt, 1, text1, -1, SQLITE_STATIC);
-      sqlite3_bind_text(pStmt, 2, text2, -1, SQLITE_STATIC);
-      sqlite3_bind_text(pStmt, 3, text3, -1, SQLITE_STATIC);
-      sqlite3_bind_text(pStmt, 4, text4, -1, SQLITE_STATIC);
-      sqlite3_bind_int(pStmt, 5, int1);
+      SQLStmtBindText(pStmt, 1, text1, "InsertIntoTable()");
+      SQLStmtBindText(pStmt, 2, text2, "InsertIntoTable()");
+      SQLStmtBindText(pStmt, 3, text3, "InsertIntoTable()");
+      SQLStmtBindText(pStmt, 4, text4, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 5, int1, "InsertIntoTable()");
       }
    else if ( strcmp(Table, "VecPairs") == 0 )
       {
-      sqlite3_bind_text(pStmt, 1, text1, -1, SQLITE_STATIC);
-      sqlite3_bind_int(pStmt, 2, int1);
-      sqlite3_bind_int(pStmt, 3, int2);
-      sqlite3_bind_int(pStmt, 4, int3);
-      sqlite3_bind_int(pStmt, 5, int4);
+      SQLStmtBindText(pStmt, 1, text1, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 2, int1, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 3, int2, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 4, int3, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 5, int4, "InsertIntoTable()");
       }
 
 // FIXED POINT. On 9/28/2018, I converted the 'real' fields (double) here to scaled integer to save space. Note that there
 // was a bug prior to this where I wasn't actually storing the 3 sigma value (TSig) but rather the Ave value twice...
    else if ( strcmp(Table, "TimingTable") == 0 )
       {
-      sqlite3_bind_int(pStmt, 1, int1);
-      sqlite3_bind_int(pStmt, 2, int2);
-      sqlite3_bind_int(pStmt, 3, (int)(float1*16.0));
-      sqlite3_bind_int(pStmt, 4, (int)(float2*16.0));
-      sqlite3_bind_int(pStmt, 5, int3);
+      SQLStmtBindInt(pStmt, 1, int1, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 2, int2, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 3, (int)(float1*16.0), "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 4, (int)(float2*16.0), "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 5, int3, "InsertIntoTable()");
       }
    else if ( strcmp(Table, "Challenges") == 0 )
       {
-      sqlite3_bind_text(pStmt, 1, text1, -1, SQLITE_STATIC);
-      sqlite3_bind_int(pStmt, 2, int1);
-      sqlite3_bind_int(pStmt, 3, int2);
-      sqlite3_bind_int(pStmt, 4, int3);
-      sqlite3_bind_int(pStmt, 5, int4);
-      sqlite3_bind_int(pStmt, 6, int5);
+      SQLStmtBindText(pStmt, 1, text1, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 2, int1, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 3, int2, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 4, int3, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 5, int4, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 6, int5, "InsertIntoTable()");
       }
    else if ( strcmp(Table, "Vectors") == 0 )
-      sqlite3_bind_blob(pStmt, 1, vector, vector_size_bytes, SQLITE_STATIC);
+      SQLStmtBindBlob(pStmt, 1, vector, vector_size_bytes, "InsertIntoTable()");
    else if ( strcmp(Table, "PathSelectMasks") == 0 )
-      sqlite3_bind_text(pStmt, 1, text1, -1, SQLITE_STATIC);
+      SQLStmtBindText(pStmt, 1, text1, "InsertIntoTable()");
    else if ( strcmp(Table, "ChallengeVecPairs") == 0 )
       {
-      sqlite3_bind_int(pStmt, 1, int1);
-      sqlite3_bind_int(pStmt, 2, int2);
-      sqlite3_bind_int(pStmt, 3, int3);
+      SQLStmtBindInt(pStmt, 1, int1, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 2, int2, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 3, int3, "InsertIntoTable()");
       }
    else
       { printf("ERROR: InsertIntoTable(): Unknown Table '%s'\n", Table); exit(EXIT_FAILURE); }
 
    rc = sqlite3_step(pStmt);
-
-   if ( (fc = sqlite3_finalize(pStmt)) != 0 && fc != SQLITE_CONSTRAINT )
-      { printf("ERROR: InsertIntoTable(): Finalize failed %d for Table '%s'\n", fc, Table); exit(EXIT_FAILURE); }
+   SQLStmtRelease(pStmt);
 
 // FIX ME AT SOME POINT. Return 1 if successful and 0 if unsuccessful (flip these around -- did this for 
 // InsertIntoTable_RT in PUFCash V3.0).
@@ -1234,44 +1629,83 @@ but challenge mask selects this PO with %c\n", PUF_instance_index, vecpair_index
 
 // ========================================================================================================
 // ========================================================================================================
-// Read in the enrollment data from a Chip/placement file, e.g., C1_V1_KG_FU_... Modified 8/3/2019 to handle
-// TDC enrollment files.
+// Grow the per-PN arrays of an EnrollPNsStruct so it can hold at least 'num_PNX' PNs with 'num_sams' samples
+// each. Capacity is doubled to keep the number of reallocs logarithmic in the number of PNs.
 
-int ReadChipEnrollPNs(int max_string_len, char ChipEnrollDatafile[max_string_len], float **PNX_ptr, 
-   float **PNX_Tsig_ptr, int **rise_fall_ptr, int **vec_pairs_ptr, int **POs_ptr, int *num_PNX_ptr, 
-   int num_POs, int has_masks, int num_vec_pairs, char **master_masks, int debug_flag)
+void GrowEnrollPNs(EnrollPNsStruct *EP_ptr, int num_PNX, int num_sams)
+   {
+   int new_alloc;
+
+   if ( num_PNX <= EP_ptr->num_alloc_PNX )
+      return;
+
+   new_alloc = EP_ptr->num_alloc_PNX == 0 ? 1024 : EP_ptr->num_alloc_PNX;
+   while ( new_alloc < num_PNX )
+      new_alloc *= 2;
+
+   if ( (EP_ptr->vec_pairs = (int *)realloc(EP_ptr->vec_pairs, sizeof(int)*new_alloc)) == NULL )
+      { printf("ERROR: GrowEnrollPNs(): Failed to re-allocate storage for vec_pairs!\n"); exit(EXIT_FAILURE); }
+   if ( (EP_ptr->POs = (int *)realloc(EP_ptr->POs, sizeof(int)*new_alloc)) == NULL )
+      { printf("ERROR: GrowEnrollPNs(): Failed to re-allocate storage for POs!\n"); exit(EXIT_FAILURE); }
+   if ( (EP_ptr->samples = (float *)realloc(EP_ptr->samples, sizeof(float)*new_alloc*num_sams)) == NULL )
+      { printf("ERROR: GrowEnrollPNs(): Failed to re-allocate storage for samples!\n"); exit(EXIT_FAILURE); }
+
+   EP_ptr->num_alloc_PNX = new_alloc;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Release the storage of an EnrollPNsStruct, which is either heap allocated (text parser) or a read-only 
+// mapping of a binary enrollment file.
+
+void FreeEnrollPNs(EnrollPNsStruct *EP_ptr)
+   {
+   if ( EP_ptr->map_base != NULL )
+      munmap(EP_ptr->map_base, EP_ptr->map_size);
+   else
+      {
+      if ( EP_ptr->vec_pairs != NULL )
+         free(EP_ptr->vec_pairs);
+      if ( EP_ptr->POs != NULL )
+         free(EP_ptr->POs);
+      if ( EP_ptr->samples != NULL )
+         free(EP_ptr->samples);
+      }
+   memset(EP_ptr, 0, sizeof(EnrollPNsStruct));
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Parse the raw samples from a text Chip/placement enrollment file, e.g., C1_V1_KG_FU_... Modified 8/3/2019 
+// to handle TDC enrollment files. When 'has_masks' is set, paths that are not selected by the masks are 
+// skipped. Returns the number of rising PNs.
+
+int ParseChipEnrollPNsText(int max_string_len, char *ChipEnrollDatafile, EnrollPNsStruct *EP_ptr, int num_POs, 
+   int has_masks, int num_vec_pairs, char **master_masks)
    {
-   int rise_fall, num_sams, sam_num, num_PNR, vec_pair, PO;
+   int rise_fall, num_sams, sam_num, vec_pair, PO;
    int num_allocated_PN_vals = 0;
    char line[max_string_len];
-   float PN_mean, PN_Tsig;
    float *PN_vals = NULL;
    int first_skip_MPS;
    char *char_ptr;
    FILE *INFILE;
 
    if ( (INFILE = fopen(ChipEnrollDatafile, "r")) == NULL )
-      { printf("ERROR: ReadChipEnrollPNs(): Could not open PNs database file %s\n", ChipEnrollDatafile); exit(EXIT_FAILURE); }
+      { printf("ERROR: ParseChipEnrollPNsText(): Could not open PNs database file %s\n", ChipEnrollDatafile); exit(EXIT_FAILURE); }
+
+   memset(EP_ptr, 0, sizeof(EnrollPNsStruct));
 
    rise_fall = 0;
    num_sams = 0;
-   num_PNR = 0;
-
-// Make sure all of these are set to NULL since we realloc depends on it below.
-   *PNX_ptr = NULL;
-   *PNX_Tsig_ptr = NULL;
-   *rise_fall_ptr = NULL;
-   *vec_pairs_ptr = NULL;
-   *POs_ptr = NULL;
-   *num_PNX_ptr = 0;
 
    first_skip_MPS = 1;
    int state = 0;
    while ( fgets(line, max_string_len, INFILE) != NULL )
       {
 
-//printf("ReadChipEnrollPNs(): Processing '%s'\n", line); fflush(stdout);
-
 // 8/3/2019: Added this to handle TDC enrollment files which contain calibration data at the beginning of the file.
 // ONLY process lines that begin with 'V:' AND '0:' AND 'C:'. This should skip ALL of the calibration data lines.
 // 	'V: 0	O: 0	C: 0	MPS1: 3	MPS2: 3	 316 316 316 316 316 316 316 316 316 316 316 316 316 316 316 316'
@@ -1283,14 +1717,9 @@ int ReadChipEnrollPNs(int max_string_len, char ChipEnrollDatafile[max_string_len
       else
          state = 1;
 
-// There are blank lines between the rise and fall PNs. 
+// There are blank lines between the rise and fall PNs. Invert rise_fall flag. 
       if ( strlen(line) == 0 || strlen(line) == 1 )
          {
-
-// DEBUG
-//printf("ReadChipEnrollPNs(): Flipping current value of rise_fall flag %d\n", rise_fall); fflush(stdout);
-
-// Invert rise_fall flag. Note that we now use separate arrays for the rise and fall PNs.
          rise_fall++; 
          continue;
          }
@@ -1298,38 +1727,38 @@ int ReadChipEnrollPNs(int max_string_len, char ChipEnrollDatafile[max_string_len
 // If the while condition above does not fail after reading the blank line at the end of the file, then there's more data.
 // This routine assumes each file has data for ONE CHIP.
       if ( rise_fall > 1 )
-         { printf("ERROR: ReadChipEnrollPNs(): Datafile has data for more than 1 chip!\n"); exit(EXIT_FAILURE); }
+         { printf("ERROR: ParseChipEnrollPNsText(): Datafile has data for more than 1 chip!\n"); exit(EXIT_FAILURE); }
 
 // Header information is ignored (for now)
       if ((char_ptr = strtok(line, " \t")) == NULL )
-         { printf("ERROR: ReadChipEnrollPNs(): No ' ' found in data line for 'V:'!\n"); exit(EXIT_FAILURE); }
+         { printf("ERROR: ParseChipEnrollPNsText(): No ' ' found in data line for 'V:'!\n"); exit(EXIT_FAILURE); }
       if ( strcmp(char_ptr, "V:") != 0 )
-         { printf("ERROR: ReadChipEnrollPNs(): Expected 'V:' as first token!\n"); exit(EXIT_FAILURE); }
+         { printf("ERROR: ParseChipEnrollPNsText(): Expected 'V:' as first token!\n"); exit(EXIT_FAILURE); }
 
       if ((char_ptr = strtok(NULL, " \t")) == NULL )
-         { printf("ERROR: ReadChipEnrollPNs(): No ' ' found in data line for vector number!\n"); exit(EXIT_FAILURE); }
-      sscanf(char_ptr, "%d", &vec_pair);
+         { printf("ERROR: ParseChipEnrollPNsText(): No ' ' found in data line for vector number!\n"); exit(EXIT_FAILURE); }
+      vec_pair = (int)strtol(char_ptr, NULL, 10);
 
       if ((char_ptr = strtok(NULL, " \t")) == NULL )
-         { printf("ERROR: ReadChipEnrollPNs(): No ' ' found in data line for 'O:'!\n"); exit(EXIT_FAILURE); }
+         { printf("ERROR: ParseChipEnrollPNsText(): No ' ' found in data line for 'O:'!\n"); exit(EXIT_FAILURE); }
       if ( strcmp(char_ptr, "O:") != 0 )
-         { printf("ERROR: ReadChipEnrollPNs(): Expected 'O:' as third token => '%s'!\n", char_ptr); exit(EXIT_FAILURE); }
+         { printf("ERROR: ParseChipEnrollPNsText(): Expected 'O:' as third token => '%s'!\n", char_ptr); exit(EXIT_FAILURE); }
 
       if ((char_ptr = strtok(NULL, " \t")) == NULL )
-         { printf("ERROR: ReadChipEnrollPNs(): No ' ' found in data line for output number!\n"); exit(EXIT_FAILURE); }
-      sscanf(char_ptr, "%d", &PO);
+         { printf("ERROR: ParseChipEnrollPNsText(): No ' ' found in data line for output number!\n"); exit(EXIT_FAILURE); }
+      PO = (int)strtol(char_ptr, NULL, 10);
 
       if ((char_ptr = strtok(NULL, " \t")) == NULL )
-         { printf("ERROR: ReadChipEnrollPNs(): No ' ' found in data line for 'C:'!\n"); exit(EXIT_FAILURE); }
+         { printf("ERROR: ParseChipEnrollPNsText(): No ' ' found in data line for 'C:'!\n"); exit(EXIT_FAILURE); }
       if ( strcmp(char_ptr, "C:") != 0 )
-         { printf("ERROR: ReadChipEnrollPNs(): Expected 'C:' as fifth token => '%s'!\n", char_ptr); exit(EXIT_FAILURE); }
+         { printf("ERROR: ParseChipEnrollPNsText(): Expected 'C:' as fifth token => '%s'!\n", char_ptr); exit(EXIT_FAILURE); }
 
       if ((char_ptr = strtok(NULL, " \t")) == NULL )
-         { printf("ERROR: ReadChipEnrollPNs(): No ' ' found in data line for PN cnter!\n"); exit(EXIT_FAILURE); }
+         { printf("ERROR: ParseChipEnrollPNsText(): No ' ' found in data line for PN cnter!\n"); exit(EXIT_FAILURE); }
 
 // Sanity check
       if ( PO < 0 || PO >= num_POs )
-         { printf("ERROR: ReadChipEnrollPNs(): PO number read from file %d is outside range of 0 to num_POs - 1 %d!\n", PO, num_POs - 1); exit(EXIT_FAILURE); }
+         { printf("ERROR: ParseChipEnrollPNsText(): PO number read from file %d is outside range of 0 to num_POs - 1 %d!\n", PO, num_POs - 1); exit(EXIT_FAILURE); }
 
 // 9/30/2018: Skip paths that are not selected by the masks, if the mask file exists. This is to allow smaller databases to be created with
 // fewer than the number of enrollment PNs.
@@ -1338,7 +1767,7 @@ int ReadChipEnrollPNs(int max_string_len, char ChipEnrollDatafile[max_string_len
 
 // Sanity check
          if ( vec_pair >= num_vec_pairs )
-            { printf("ERROR: ReadChipEnrollPNs(): Vector number recorded in file %d larger than number of masks %d!\n", vec_pair, num_vec_pairs); exit(EXIT_FAILURE); }
+            { printf("ERROR: ParseChipEnrollPNsText(): Vector number recorded in file %d larger than number of masks %d!\n", vec_pair, num_vec_pairs); exit(EXIT_FAILURE); }
    
 // Check if this path is selected, continue if not (either 0 or 'u' for unqualitied'. Be sure to reverse the numbering, low order addresses in masks store high order 
 // mask bits.
@@ -1362,26 +1791,27 @@ int ReadChipEnrollPNs(int max_string_len, char ChipEnrollDatafile[max_string_len
                { printf("Skipping MPSx data on line!\n"); fflush(stdout); }
             first_skip_MPS = 0;
             if ( (char_ptr = strtok(NULL, " \t")) == NULL )
-               { printf("ERROR: ReadChipEnrollPNs(): Expected MPS data!\n"); exit(EXIT_FAILURE); }
+               { printf("ERROR: ParseChipEnrollPNsText(): Expected MPS data!\n"); exit(EXIT_FAILURE); }
             if ( (char_ptr = strtok(NULL, " \t")) == NULL )
-               { printf("ERROR: ReadChipEnrollPNs(): Expected MPS data!\n"); exit(EXIT_FAILURE); }
+               { printf("ERROR: ParseChipEnrollPNsText(): Expected MPS data!\n"); exit(EXIT_FAILURE); }
             if ( strstr(char_ptr, "MPS2:") == NULL )
-               { printf("ERROR: ReadChipEnrollPNs(): Expected 'MPS2:' !\n"); exit(EXIT_FAILURE); }
+               { printf("ERROR: ParseChipEnrollPNsText(): Expected 'MPS2:' !\n"); exit(EXIT_FAILURE); }
             if ( (char_ptr = strtok(NULL, " \t")) == NULL )
-               { printf("ERROR: ReadChipEnrollPNs(): Expected MPS data!\n"); exit(EXIT_FAILURE); }
+               { printf("ERROR: ParseChipEnrollPNsText(): Expected MPS data!\n"); exit(EXIT_FAILURE); }
             if ( (char_ptr = strtok(NULL, " \t")) == NULL )
-               { printf("ERROR: ReadChipEnrollPNs(): Expected sample data!\n"); exit(EXIT_FAILURE); }
+               { printf("ERROR: ParseChipEnrollPNsText(): Expected sample data!\n"); exit(EXIT_FAILURE); }
             }
 
-// Allocate storage ONLY when processing the first line. We will re-use this storage over-and-over again for each subsequent line.
+// The line buffer is reused for every line so double its size when it fills up.
          if ( sam_num == num_allocated_PN_vals )
             {
-            if ( (PN_vals = (float *)realloc(PN_vals, sizeof(float) * (num_allocated_PN_vals + 1))) == NULL )
-               { printf("ERROR: ReadChipEnrollPNs(): Failed to re-allocate storage for PN_vals!\n"); exit(EXIT_FAILURE); }
-            num_allocated_PN_vals++; 
+            num_allocated_PN_vals = num_allocated_PN_vals == 0 ? 64 : 2*num_allocated_PN_vals;
+            if ( (PN_vals = (float *)realloc(PN_vals, sizeof(float) * num_allocated_PN_vals)) == NULL )
+               { printf("ERROR: ParseChipEnrollPNsText(): Failed to re-allocate storage for PN_vals!\n"); exit(EXIT_FAILURE); }
             }
 
-         sscanf(char_ptr, "%f", &(PN_vals[sam_num]));
+// strtof() converts exactly as sscanf("%f") does, without the format string overhead.
+         PN_vals[sam_num] = strtof(char_ptr, NULL);
          sam_num++;
          }
 
@@ -1391,12 +1821,195 @@ int ReadChipEnrollPNs(int max_string_len, char ChipEnrollDatafile[max_string_len
          {
          num_sams = sam_num;
          if ( num_sams == 0 )
-            { printf("ERROR: ReadChipEnrollPNs(): Number of samples is 0!\n"); exit(EXIT_FAILURE); }
+            { printf("ERROR: ParseChipEnrollPNsText(): Number of samples is 0!\n"); exit(EXIT_FAILURE); }
+         EP_ptr->num_sams = num_sams;
          }
       else if ( num_sams != sam_num )
-         { printf("ERROR: ReadChipEnrollPNs(): Sample number mismatch across PN lines!\n"); exit(EXIT_FAILURE); }
+         { printf("ERROR: ParseChipEnrollPNsText(): Sample number mismatch across PN lines!\n"); exit(EXIT_FAILURE); }
+
+      GrowEnrollPNs(EP_ptr, EP_ptr->num_PNX + 1, num_sams);
+      EP_ptr->vec_pairs[EP_ptr->num_PNX] = vec_pair;
+      EP_ptr->POs[EP_ptr->num_PNX] = PO;
+      memcpy(&(EP_ptr->samples[(size_t)EP_ptr->num_PNX * num_sams]), PN_vals, sizeof(float)*num_sams);
+
+      EP_ptr->num_PNX++;
+      if ( rise_fall == 0 )
+         EP_ptr->num_PNR++;
+      }
+
+   fclose(INFILE);
+
+   if ( PN_vals != NULL )
+      free(PN_vals);
+
+   return EP_ptr->num_PNR;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Returns 1 if the file starts with the binary enrollment magic string, 0 otherwise (text format).
+
+int IsChipEnrollPNsBinary(char *ChipEnrollDatafile)
+   {
+   char magic[ENROLL_PNS_BIN_MAGIC_LEN];
+   FILE *INFILE;
+   int is_binary;
+
+   if ( (INFILE = fopen(ChipEnrollDatafile, "rb")) == NULL )
+      { printf("ERROR: IsChipEnrollPNsBinary(): Could not open PNs database file %s\n", ChipEnrollDatafile); exit(EXIT_FAILURE); }
+
+   is_binary = fread(magic, 1, ENROLL_PNS_BIN_MAGIC_LEN, INFILE) == ENROLL_PNS_BIN_MAGIC_LEN && 
+      memcmp(magic, ENROLL_PNS_BIN_MAGIC, ENROLL_PNS_BIN_MAGIC_LEN) == 0;
+
+   fclose(INFILE);
+   return is_binary;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Write the raw samples to a binary enrollment file. Layout: EnrollPNsBinHeaderStruct, then num_PNX vector 
+// numbers, num_PNX PO numbers and num_PNX*num_sams samples, all 4-byte native-endian. The first num_PNR PNs 
+// are rising. Mask filtering is NOT applied to the binary file, it is done when the file is loaded.
+
+void WriteChipEnrollPNsBinary(char *ChipEnrollBinfile, EnrollPNsStruct *EP_ptr, int num_POs)
+   {
+   EnrollPNsBinHeaderStruct header;
+   FILE *OUTFILE;
+
+   memset(&header, 0, sizeof(EnrollPNsBinHeaderStruct));
+   memcpy(header.magic, ENROLL_PNS_BIN_MAGIC, ENROLL_PNS_BIN_MAGIC_LEN);
+   header.version = ENROLL_PNS_BIN_VERSION;
+   header.num_POs = num_POs;
+   header.num_sams = EP_ptr->num_sams;
+   header.num_PNR = EP_ptr->num_PNR;
+   header.num_PNX = EP_ptr->num_PNX;
+
+   if ( (OUTFILE = fopen(ChipEnrollBinfile, "wb")) == NULL )
+      { printf("ERROR: WriteChipEnrollPNsBinary(): Could not open %s for writing!\n", ChipEnrollBinfile); exit(EXIT_FAILURE); }
+
+   if ( fwrite(&header, sizeof(EnrollPNsBinHeaderStruct), 1, OUTFILE) != 1 ||
+      fwrite(EP_ptr->vec_pairs, sizeof(int), EP_ptr->num_PNX, OUTFILE) != EP_ptr->num_PNX ||
+      fwrite(EP_ptr->POs, sizeof(int), EP_ptr->num_PNX, OUTFILE) != EP_ptr->num_PNX ||
+      fwrite(EP_ptr->samples, sizeof(float), (size_t)EP_ptr->num_PNX*EP_ptr->num_sams, OUTFILE) != (size_t)EP_ptr->num_PNX*EP_ptr->num_sams )
+      { printf("ERROR: WriteChipEnrollPNsBinary(): Failed to write %s!\n", ChipEnrollBinfile); exit(EXIT_FAILURE); }
+
+   if ( fclose(OUTFILE) != 0 )
+      { printf("ERROR: WriteChipEnrollPNsBinary(): Failed to close %s!\n", ChipEnrollBinfile); exit(EXIT_FAILURE); }
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Map a binary enrollment file read-only. The EnrollPNsStruct arrays point directly into the mapping, so no 
+// parsing or copying is done. Returns the number of rising PNs.
+
+int LoadChipEnrollPNsBinary(char *ChipEnrollBinfile, EnrollPNsStruct *EP_ptr, int num_POs)
+   {
+   EnrollPNsBinHeaderStruct *header_ptr;
+   struct stat file_stat;
+   size_t expected_size;
+   unsigned char *base;
+   int fd;
+
+   memset(EP_ptr, 0, sizeof(EnrollPNsStruct));
+
+   if ( (fd = open(ChipEnrollBinfile, O_RDONLY)) < 0 )
+      { printf("ERROR: LoadChipEnrollPNsBinary(): Could not open PNs database file %s\n", ChipEnrollBinfile); exit(EXIT_FAILURE); }
+   if ( fstat(fd, &file_stat) != 0 || file_stat.st_size < (off_t)sizeof(EnrollPNsBinHeaderStruct) )
+      { printf("ERROR: LoadChipEnrollPNsBinary(): File %s is too small to hold a header!\n", ChipEnrollBinfile); exit(EXIT_FAILURE); }
+
+   if ( (base = (unsigned char *)mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED )
+      { printf("ERROR: LoadChipEnrollPNsBinary(): mmap of %s failed!\n", ChipEnrollBinfile); exit(EXIT_FAILURE); }
+   close(fd);
+   madvise(base, file_stat.st_size, MADV_SEQUENTIAL);
+
+// Sanity checks on the header. 
+   header_ptr = (EnrollPNsBinHeaderStruct *)base;
+   if ( memcmp(header_ptr->magic, ENROLL_PNS_BIN_MAGIC, ENROLL_PNS_BIN_MAGIC_LEN) != 0 || header_ptr->version != ENROLL_PNS_BIN_VERSION )
+      { printf("ERROR: LoadChipEnrollPNsBinary(): %s is not a version %d binary enrollment file!\n", ChipEnrollBinfile, ENROLL_PNS_BIN_VERSION); exit(EXIT_FAILURE); }
+   if ( header_ptr->num_POs != num_POs )
+      { printf("ERROR: LoadChipEnrollPNsBinary(): File num_POs %u does not match num_POs %d!\n", header_ptr->num_POs, num_POs); exit(EXIT_FAILURE); }
+   if ( header_ptr->num_sams == 0 || header_ptr->num_PNR > header_ptr->num_PNX )
+      { printf("ERROR: LoadChipEnrollPNsBinary(): Corrupt header in %s!\n", ChipEnrollBinfile); exit(EXIT_FAILURE); }
+
+   expected_size = sizeof(EnrollPNsBinHeaderStruct) + (size_t)header_ptr->num_PNX*(2*sizeof(int) + header_ptr->num_sams*sizeof(float));
+   if ( (size_t)file_stat.st_size != expected_size )
+      { printf("ERROR: LoadChipEnrollPNsBinary(): File size %ld of %s does not match header => expected %lu!\n", 
+         (long)file_stat.st_size, ChipEnrollBinfile, (unsigned long)expected_size); exit(EXIT_FAILURE); }
+
+   EP_ptr->num_PNX = header_ptr->num_PNX;
+   EP_ptr->num_PNR = header_ptr->num_PNR;
+   EP_ptr->num_sams = header_ptr->num_sams;
+   EP_ptr->vec_pairs = (int *)(base + sizeof(EnrollPNsBinHeaderStruct));
+   EP_ptr->POs = EP_ptr->vec_pairs + EP_ptr->num_PNX;
+   EP_ptr->samples = (float *)(EP_ptr->POs + EP_ptr->num_PNX);
+   EP_ptr->map_base = base;
+   EP_ptr->map_size = file_stat.st_size;
+
+   return EP_ptr->num_PNR;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Read in the enrollment data from a Chip/placement file, e.g., C1_V1_KG_FU_... The file is either the original
+// text format or the binary format written by WriteChipEnrollPNsBinary(), determined from the magic string.
+// The mean and three sigma of each PN's samples are returned in PNX and PNX_Tsig.
+
+int ReadChipEnrollPNs(int max_string_len, char ChipEnrollDatafile[max_string_len], float **PNX_ptr, 
+   float **PNX_Tsig_ptr, int **rise_fall_ptr, int **vec_pairs_ptr, int **POs_ptr, int *num_PNX_ptr, 
+   int num_POs, int has_masks, int num_vec_pairs, char **master_masks, int debug_flag)
+   {
+   int PN_num, rise_fall, num_sams, num_PNR, vec_pair, PO;
+   EnrollPNsStruct EP;
+   float PN_mean, PN_Tsig;
+   float *PN_vals;
+   int is_binary;
+
+// The text parser applies the masks as it reads. The binary file holds every PN so filter here.
+   if ( (is_binary = IsChipEnrollPNsBinary(ChipEnrollDatafile)) == 1 )
+      LoadChipEnrollPNsBinary(ChipEnrollDatafile, &EP, num_POs);
+   else
+      ParseChipEnrollPNsText(max_string_len, ChipEnrollDatafile, &EP, num_POs, has_masks, num_vec_pairs, master_masks);
+
+   num_sams = EP.num_sams;
+   num_PNR = 0;
+   *num_PNX_ptr = 0;
+
+   if ( (*PNX_ptr = (float *)malloc(sizeof(float)*(EP.num_PNX + 1))) == NULL )
+      { printf("ERROR: ReadChipEnrollPNs(): Failed to allocate storage for PNX!\n"); exit(EXIT_FAILURE); }
+   if ( (*PNX_Tsig_ptr = (float *)malloc(sizeof(float)*(EP.num_PNX + 1))) == NULL )
+      { printf("ERROR: ReadChipEnrollPNs(): Failed to allocate storage for PNX_Tsig!\n"); exit(EXIT_FAILURE); }
+   if ( (*rise_fall_ptr = (int *)malloc(sizeof(int)*(EP.num_PNX + 1))) == NULL )
+      { printf("ERROR: ReadChipEnrollPNs(): Failed to allocate storage for rise_fall!\n"); exit(EXIT_FAILURE); }
+   if ( (*vec_pairs_ptr = (int *)malloc(sizeof(int)*(EP.num_PNX + 1))) == NULL )
+      { printf("ERROR: ReadChipEnrollPNs(): Failed to allocate storage for vec_pairs!\n"); exit(EXIT_FAILURE); }
+   if ( (*POs_ptr = (int *)malloc(sizeof(int)*(EP.num_PNX + 1))) == NULL )
+      { printf("ERROR: ReadChipEnrollPNs(): Failed to allocate storage for POs!\n"); exit(EXIT_FAILURE); }
+
+   for ( PN_num = 0; PN_num < EP.num_PNX; PN_num++ )
+      {
+      vec_pair = EP.vec_pairs[PN_num];
+      PO = EP.POs[PN_num];
+      rise_fall = PN_num >= EP.num_PNR;
+
+      if ( is_binary == 1 )
+         {
+         if ( PO < 0 || PO >= num_POs )
+            { printf("ERROR: ReadChipEnrollPNs(): PO number read from file %d is outside range of 0 to num_POs - 1 %d!\n", PO, num_POs - 1); exit(EXIT_FAILURE); }
+         if ( has_masks == 1 )
+            {
+            if ( vec_pair >= num_vec_pairs )
+               { printf("ERROR: ReadChipEnrollPNs(): Vector number recorded in file %d larger than number of masks %d!\n", vec_pair, num_vec_pairs); exit(EXIT_FAILURE); }
+            if ( master_masks[vec_pair][num_POs - PO - 1] == '0' || master_masks[vec_pair][num_POs - PO - 1] == 'u' )
+               continue;
+            }
+         }
 
 // Compute the mean and three sig.
+      PN_vals = &(EP.samples[(size_t)PN_num * num_sams]);
       PN_mean = ComputeMean(num_sams, PN_vals);
       if ( num_sams > 1 )
          PN_Tsig = 3*ComputeStdDev(num_sams, PN_mean, PN_vals);
@@ -1410,25 +2023,8 @@ int ReadChipEnrollPNs(int max_string_len, char ChipEnrollDatafile[max_string_len
             rise_fall, *num_PNX_ptr, PN_Tsig, MAX_TSIG); fflush(stdout); 
          }
 
-// NULL assignment above forces realloc to behave as malloc on the first call. 
-      if ( (*PNX_ptr = (float *)realloc(*PNX_ptr, sizeof(float)*(*num_PNX_ptr + 1))) == NULL )
-         { printf("ERROR: ReadChipEnrollPNs(): Failed to re-allocate storage for PNX!\n"); exit(EXIT_FAILURE); }
-      if ( (*PNX_Tsig_ptr = (float *)realloc(*PNX_Tsig_ptr, sizeof(float)*(*num_PNX_ptr + 1))) == NULL )
-         { printf("ERROR: ReadChipEnrollPNs(): Failed to re-allocate storage for PNX!\n"); exit(EXIT_FAILURE); }
-      if ( (*rise_fall_ptr = (int *)realloc(*rise_fall_ptr, sizeof(int)*(*num_PNX_ptr + 1))) == NULL )
-         { printf("ERROR: ReadChipEnrollPNs(): Failed to re-allocate storage for rise_fall!\n"); exit(EXIT_FAILURE); }
-      if ( (*vec_pairs_ptr = (int *)realloc(*vec_pairs_ptr, sizeof(int)*(*num_PNX_ptr + 1))) == NULL )
-         { printf("ERROR: ReadChipEnrollPNs(): Failed to re-allocate storage for vec_pairs!\n"); exit(EXIT_FAILURE); }
-      if ( (*POs_ptr = (int *)realloc(*POs_ptr, sizeof(int)*(*num_PNX_ptr + 1))) == NULL )
-         { printf("ERROR: ReadChipEnrollPNs(): Failed to re-allocate storage for POs!\n"); exit(EXIT_FAILURE); }
-
-// Compute the average value and store in the array.
       (*PNX_ptr)[*num_PNX_ptr] = PN_mean;
-      if ( num_sams > 1 )
-         (*PNX_Tsig_ptr)[*num_PNX_ptr] = PN_Tsig;
-      else
-         (*PNX_Tsig_ptr)[*num_PNX_ptr] = 0.0;
-
+      (*PNX_Tsig_ptr)[*num_PNX_ptr] = PN_Tsig;
       (*rise_fall_ptr)[*num_PNX_ptr] = rise_fall;
       (*vec_pairs_ptr)[*num_PNX_ptr] = vec_pair;
       (*POs_ptr)[*num_PNX_ptr] = PO;
@@ -1438,7 +2034,7 @@ int ReadChipEnrollPNs(int max_string_len, char ChipEnrollDatafile[max_string_len
          num_PNR++;
       }
 
-   fclose(INFILE);
+   FreeEnrollPNs(&EP);
 
 printf("\tReadChipEnrollPNs(): Num PNR %d\tNum PNF %d\tNum sams %d\n", num_PNR, *num_PNX_ptr - num_PNR, num_sams); fflush(stdout);
 
@@ -1454,18 +2050,13 @@ printf("\tReadChipEnrollPNs(): Num PNR %d\tNum PNF %d\tNum sams %d\n", num_PNR,
 int DeletePUFInstance(int max_string_len, sqlite3 *db, const char *SQL_cmd, int instance_index)
    {
    sqlite3_stmt *pStmt;
-   int rc, fc;
-
-// Prepare 'pStmt' with SQL query.
-   rc = sqlite3_prepare_v2(db, SQL_cmd, strlen(SQL_cmd) + 1, &pStmt, 0);
-   if( rc != SQLITE_OK )
-      { printf("ERROR: DeletePUFInstance(): 'sqlite3_prepare_v2' failed with %d\n", rc); exit(EXIT_FAILURE); }
+   int rc;
 
-   sqlite3_bind_int(pStmt, 1, instance_index);
+   pStmt = SQLStmtAcquire(db, SQL_cmd, "DeletePUFInstance()");
+   SQLStmtBindInt(pStmt, 1, instance_index, "DeletePUFInstance()");
 
    rc = sqlite3_step(pStmt);
-   if ( (fc = sqlite3_finalize(pStmt)) != 0 && fc != SQLITE_CONSTRAINT )
-      { printf("ERROR: DeletePUFInstance(): Finalize failed %d\n", fc); exit(EXIT_FAILURE); }
+   SQLStmtRelease(pStmt);
 
    if ( rc == SQLITE_DONE )
       return 0;
@@ -1596,6 +2187,8 @@ int AddTimingDataToDB(int max_string_len, sqlite3 *db, const char *SQL_TimingVal
    int *POs, int num_PNR, int num_PNX, int master_num_rise_vec_pairs, int num_POs)
    {
    int num_PNs_per_vecpair, PN_num;
+   sqlite3_stmt *pStmt;
+   int rc;
 
 // 'vec_pair_num' corresponds to the number stored in the enrollment data file under 'V:', which is stored in the 'vec_pairs' 
 // array.  Keep adding timing values until the value for an array element in 'vecpairs' is not equal to 'vec_pair_num'.
@@ -1604,6 +2197,9 @@ int AddTimingDataToDB(int max_string_len, sqlite3 *db, const char *SQL_TimingVal
    while ( PN_num < num_PNX && vec_pair_num != vec_pairs[PN_num] )
       PN_num++;
 
+// The INSERT is bound and stepped once per timing value on the same prepared statement.
+   pStmt = SQLStmtAcquire(db, SQL_TimingVals_insert_into_cmd, "AddTimingDataToDB()");
+
    num_PNs_per_vecpair = 0;
    while ( PN_num < num_PNX && vec_pair_num == vec_pairs[PN_num] )
       {
@@ -1622,10 +2218,17 @@ int AddTimingDataToDB(int max_string_len, sqlite3 *db, const char *SQL_TimingVal
             vec_pair_num, PN_num, PNX[PN_num], PNX_Tsig[PN_num]); exit(EXIT_FAILURE); 
          }
 
-// Store the timing value as an element in the TimingTable. NOTE: THIS routine scales the floating point value to a integer (FIXED POINT) by
-// multiplying by 16 before storing the data into the TABLE.
-      InsertIntoTable(max_string_len, db, "TimingTable", SQL_TimingVals_insert_into_cmd, NULL, 0, NULL, NULL, NULL, NULL, NULL, vecpair_index, 
-         POs[PN_num], instance_index, -1, -1, PNX[PN_num], PNX_Tsig[PN_num]);
+// Store the timing value as an element in the TimingTable. NOTE: The floating point value is scaled to an integer (FIXED POINT) by 
+// multiplying by 16 before storing the data into the TABLE, as InsertIntoTable() does for "TimingTable".
+      SQLStmtBindInt(pStmt, 1, vecpair_index, "AddTimingDataToDB()");
+      SQLStmtBindInt(pStmt, 2, POs[PN_num], "AddTimingDataToDB()");
+      SQLStmtBindInt(pStmt, 3, (int)(PNX[PN_num]*16.0), "AddTimingDataToDB()");
+      SQLStmtBindInt(pStmt, 4, (int)(PNX_Tsig[PN_num]*16.0), "AddTimingDataToDB()");
+      SQLStmtBindInt(pStmt, 5, instance_index, "AddTimingDataToDB()");
+      rc = sqlite3_step(pStmt);
+      sqlite3_reset(pStmt);
+      if ( rc != SQLITE_DONE && rc != SQLITE_CONSTRAINT )
+         { printf("ERROR: AddTimingDataToDB(): Return code => %d for vecpair_index %d: %s\n", rc, vecpair_index, sqlite3_errmsg(db)); exit(EXIT_FAILURE); }
 
 #ifdef DEBUG
 printf("AddTimingDataToDB(): InsertIntoTimingTable return val %d\n", rc);
@@ -1640,6 +2243,7 @@ printf("AddTimingDataToDB(): InsertIntoTimingTable return val %d\n", rc);
       PN_num++;
       num_PNs_per_vecpair++;
       }
+   SQLStmtRelease(pStmt);
 
 #ifdef DEBUG
 printf("AddTimingDataToDB(): Number of timing values added for vec_pair_num %d is %d\n", vec_pair_num, num_PNs_per_vecpair); fflush(stdout);
@@ -1651,165 +2255,81 @@ printf("AddTimingDataToDB(): Number of timing values added for vec_pair_num %d i
 
 // ========================================================================================================
 // ========================================================================================================
-// Add master vectors to the Vectors table, and then vector pairs to the VecPairs table, and then the timing 
-// data to the TimingVals table. It is common for this routine to issue constraint violations because vectors 
-// or vector pairs already exist in the tables. Timing values are deleted and then re-added if they already 
-// exist b/c the user must first decide if the PUFInstance is to be preserved or replaced. This is 
-// accomplished because a foreign key and ON DELETE CASCADE is set on the TimingVals database to the PUFInstance 
-// table.
+// Add an element to the Vectors or VecPairs table if it does not already exist and return its id. A new row
+// gets its id from sqlite3_last_insert_rowid(), so the SELECT is only issued when the INSERT hits the unique 
+// index, i.e., the element was enrolled by an earlier run.
 
-void ProcessMasterVecsAndTimingData(int max_string_len, sqlite3 *db, int design_index, int instance_index,
-   int master_num_vec_pairs, int master_num_rise_vec_pairs, unsigned char **master_first_vecs_b, 
-   unsigned char **master_second_vecs_b, float *PNX, float *PNX_Tsig, int *rise_fall, int *vec_pairs, 
-   int *POs, int num_PNR, int num_PNX, int num_PIs, int num_POs)
+int InsertOrGetIndex(int max_string_len, sqlite3 *db, char *Table, const char *SQL_insert_cmd, const char *SQL_get_index_cmd, 
+   unsigned char *blob, int blob_size_bytes, char *text1, int int1, int int2, int int3)
    {
-   int vecpair_index, num_PNs_per_vecpair;
-   char rise_fall_str[200];
-   int vec_num, vec_len_bytes;
+   int index;
 
-   int first_vec_index, second_vec_index;
+   if ( InsertIntoTable(max_string_len, db, Table, SQL_insert_cmd, blob, blob_size_bytes, text1, NULL, NULL, NULL, NULL, int1, 
+      int2, -1, int3, -1, -1.0, -1.0) == 0 )
+      index = (int)sqlite3_last_insert_rowid(db);
+   else
+      index = GetIndexFromTable(max_string_len, db, Table, SQL_get_index_cmd, blob, blob_size_bytes, NULL, NULL, NULL, NULL, 
+         int1, int2, int3);
 
-   int tot_TVs;
+   return index;
+   }
 
-   vec_len_bytes = num_PIs/8;
 
-#ifdef DEBUG
-struct timeval t1, t2;
-long elapsed; 
-#endif
+// ========================================================================================================
+// ========================================================================================================
+// Add master vectors to the Vectors table and vector pairs to the VecPairs table and record their ids in
+// 'ID_map_ptr'. The master vectors are the same for every chip that is enrolled, so this is done once per 
+// process and ProcessMasterVecsAndTimingData() uses the map for the remaining chips instead of issuing a
+// SELECT per vector and vector pair. It is common for vectors or vector pairs to already exist in the tables. 
+// The map stays valid because deleting a PUFInstance only cascades to its TimingVals.
+
+void GetCreateEnrollIDMap(int max_string_len, sqlite3 *db, int design_index, int master_num_vec_pairs, 
+   int master_num_rise_vec_pairs, unsigned char **master_first_vecs_b, unsigned char **master_second_vecs_b, 
+   int num_PIs, EnrollIDMapStruct *ID_map_ptr)
+   {
+   int vec_num, vec_len_bytes;
+   char rise_fall_str[2];
 
-printf("ENROLL:\tPUFDesign %d: PUFInstance %d\tFor Num Vectors %d\n", design_index, instance_index, master_num_vec_pairs); fflush(stdout);
-#ifdef DEBUG
-#endif
+// The map is reused if it was built for the same design and master vector set.
+   if ( ID_map_ptr->vecpair_ids != NULL && ID_map_ptr->design_index == design_index && ID_map_ptr->num_vec_pairs == master_num_vec_pairs )
+      return;
 
-// ---------------------------------------------------------
-   tot_TVs = 0;
+   FreeEnrollIDMap(ID_map_ptr);
+   if ( (ID_map_ptr->first_vec_ids = (int *)malloc(sizeof(int) * master_num_vec_pairs)) == NULL ||
+      (ID_map_ptr->second_vec_ids = (int *)malloc(sizeof(int) * master_num_vec_pairs)) == NULL ||
+      (ID_map_ptr->vecpair_ids = (int *)malloc(sizeof(int) * master_num_vec_pairs)) == NULL )
+      { printf("ERROR: GetCreateEnrollIDMap(): Failed to allocate storage for %d vector pair ids!\n", master_num_vec_pairs); exit(EXIT_FAILURE); }
+   ID_map_ptr->design_index = design_index;
+   ID_map_ptr->num_vec_pairs = master_num_vec_pairs;
+
+   vec_len_bytes = num_PIs/8;
    for ( vec_num = 0; vec_num < master_num_vec_pairs; vec_num++ )
       {
-#ifdef DEBUG
-gettimeofday(&t2, 0);
-#endif
-
-#ifdef DEBUG
-printf("\n\nPROCESSING vector %d of %d\n", vec_num, master_num_vec_pairs); fflush(stdout);
-#endif
-
-#ifdef DEBUG
-printf("SQL Query '%s'\n", SQL_Vectors_insert_into_cmd);
-#endif
-
-#ifdef DEBUG
-printf("\tWriting 1st vector number %d\n", vec_num);
-#endif
-
-// Insert first vector of vector pair into Vectors table if it does already exist. It is common for vectors to already exist
-// as enrollment data for new chips is added.
-      InsertIntoTable(max_string_len, db, "Vectors", SQL_Vectors_insert_into_cmd, master_first_vecs_b[vec_num], vec_len_bytes, 
-         NULL, NULL, NULL, NULL, NULL, -1, -1, -1, -1, -1, -1.0, -1.0);
-
-#ifdef DEBUG
-gettimeofday(&t1, 0); elapsed = (t1.tv_sec-t2.tv_sec)*1000000 + t1.tv_usec-t2.tv_usec; printf("\tElapsed %ld us\n\n", (long)elapsed);
-gettimeofday(&t2, 0);
-#endif
-
-#ifdef DEBUG
-printf("\tWriting 2nd vector number %d\n", vec_num);
-#endif
-
-// Insert second vector of vector pair.
-      InsertIntoTable(max_string_len, db, "Vectors", SQL_Vectors_insert_into_cmd, master_second_vecs_b[vec_num], vec_len_bytes, 
-         NULL, NULL, NULL, NULL, NULL, -1, -1, -1, -1, -1, -1.0, -1.0);
-
-#ifdef DEBUG
-gettimeofday(&t1, 0); elapsed = (t1.tv_sec-t2.tv_sec)*1000000 + t1.tv_usec-t2.tv_usec; printf("\tElapsed %ld us\n\n", (long)elapsed);
-gettimeofday(&t2, 0);
-#endif
-
-// ------------------------------------------------------------------------------------------------------------
-// For each pair of vectors that have been added, add a row to the VecPairs table. First find the vectors in the
-// Vectors table (that were either just added or already existed). Since only unique vectors are added, these number 
-// can jump around because the calls above may not add a vector (if it is not unique).
-
-#ifdef DEBUG
-printf("\nProcessMasterVecsAndTimingData(): Find first vector!\n"); fflush(stdout);
-#endif
 
-// Get index for first vector of the vector pair from the Vectors table.
-      if ( (first_vec_index = GetIndexFromTable(max_string_len, db, "Vectors", SQL_Vectors_get_index_cmd, master_first_vecs_b[vec_num], 
-         vec_len_bytes, NULL, NULL, NULL, NULL, -1, -1, -1)) == -1 )
+// Insert the two vectors of the vector pair into the Vectors table if they do not already exist and get their indexes. Since only 
+// unique vectors are added, these numbers can jump around.
+      if ( (ID_map_ptr->first_vec_ids[vec_num] = InsertOrGetIndex(max_string_len, db, "Vectors", SQL_Vectors_insert_into_cmd, 
+         SQL_Vectors_get_index_cmd, master_first_vecs_b[vec_num], vec_len_bytes, NULL, -1, -1, -1)) == -1 )
          { 
-         printf("ERROR: ProcessMasterVecsAndTimingData(): Failed to find first_vec_index for vec_num %d in Vectors table!\n", vec_num); 
+         printf("ERROR: GetCreateEnrollIDMap(): Failed to find first_vec_index for vec_num %d in Vectors table!\n", vec_num); 
          exit(EXIT_FAILURE); 
          }
-
-#ifdef DEBUG
-printf("Vec %d, First vector index %d\n", vec_num, first_vec_index); fflush(stdout);
-gettimeofday(&t1, 0); elapsed = (t1.tv_sec-t2.tv_sec)*1000000 + t1.tv_usec-t2.tv_usec; printf("\tElapsed %ld us\n\n", (long)elapsed);
-gettimeofday(&t2, 0);
-#endif
-
-#ifdef DEBUG
-// Sanity check. Read back the first vector and check it against array values.
-      int byte_num;
-      unsigned char temp_vec[vec_len_bytes];
-      ReadBinaryBlob(db, SQL_Vectors_read_vector_cmd, first_vec_index, temp_vec, vec_len_bytes, 0, NULL);
-
-// printf("Stored and retrieved vector %d => size is %d:\n\t\t", vec_num, vec_len_bytes); fflush(stdout);
-      for ( byte_num = 0; byte_num < vec_len_bytes; byte_num++ ) 
-         {
-         printf("%02X <=> %02X  ", master_first_vecs_b[vec_num][byte_num], temp_vec[byte_num]); 
-         if ( (byte_num + 1) % 16 == 0 )
-            printf("\n\t\t");
-         if ( master_first_vecs_b[vec_num][byte_num] != temp_vec[byte_num] )
-            {
-            printf("ERROR: ProcessMasterVecsAndTimingData(): Master Vector byte %02X does NOT equal stored vector byte %02X!\n", 
-               master_first_vecs_b[vec_num][byte_num], temp_vec[byte_num]); 
-            exit(EXIT_FAILURE);
-            }
-         }
-      printf("\n"); fflush(stdout);
-#endif
-
-#ifdef DEBUG
-printf("\nProcessMasterVecsAndTimingData(): Find second vector!\n"); fflush(stdout);
-#endif
-
-// Get index for second vector of the vector pair from the Vectors table.
-      if ( (second_vec_index = GetIndexFromTable(max_string_len, db, "Vectors", SQL_Vectors_get_index_cmd, master_second_vecs_b[vec_num], 
-         vec_len_bytes, NULL, NULL, NULL, NULL, -1, -1, -1)) == -1 )
+      if ( (ID_map_ptr->second_vec_ids[vec_num] = InsertOrGetIndex(max_string_len, db, "Vectors", SQL_Vectors_insert_into_cmd, 
+         SQL_Vectors_get_index_cmd, master_second_vecs_b[vec_num], vec_len_bytes, NULL, -1, -1, -1)) == -1 )
          { 
-         printf("ERROR: ProcessMasterVecsAndTimingData(): Failed to find second_vec_index for vec_num %d in Vectors table!\n", vec_num); 
+         printf("ERROR: GetCreateEnrollIDMap(): Failed to find second_vec_index for vec_num %d in Vectors table!\n", vec_num); 
          exit(EXIT_FAILURE); 
          }
 
 #ifdef DEBUG
-printf("Vec %d, Second vector index %d\n", vec_num, second_vec_index); fflush(stdout);
-gettimeofday(&t1, 0); elapsed = (t1.tv_sec-t2.tv_sec)*1000000 + t1.tv_usec-t2.tv_usec; printf("\tElapsed %ld us\n\n", (long)elapsed);
-gettimeofday(&t2, 0);
-#endif
-
-#ifdef DEBUG
-printf("\tWrote binary vectors into Vector Table for %d with 1st vector index %d and 2nd vector index %d\n", vec_num, first_vec_index, second_vec_index); fflush(stdout);
-#endif
-
-#ifdef DEBUG
-// Sanity check. Read back the second vector and check it against array values.
-      ReadBinaryBlob(db, SQL_Vectors_read_vector_cmd, second_vec_index, temp_vec, vec_len_bytes, 0, NULL);
-
-// printf("Stored and retrieved vector %d => size is %d:\n\t\t", vec_num, vec_len_bytes); fflush(stdout);
-      for ( byte_num = 0; byte_num < vec_len_bytes; byte_num++ ) 
-         {
-         printf("%02X <=> %02X  ", master_second_vecs_b[vec_num][byte_num], temp_vec[byte_num]); 
-         if ( (byte_num + 1) % 16 == 0 )
-            printf("\n\t\t");
-         if ( master_second_vecs_b[vec_num][byte_num] != temp_vec[byte_num] )
-            {
-            printf("ERROR: ProcessMasterVecsAndTimingData(): Master Vector byte %02X does NOT equal stored vector byte %02X!\n", 
-               master_second_vecs_b[vec_num][byte_num], temp_vec[byte_num]); 
-            exit(EXIT_FAILURE);
-            }
-         }
-      printf("\n"); fflush(stdout);
+// Sanity check. Read back the vectors and check them against array values.
+      unsigned char temp_vec[vec_len_bytes];
+      ReadBinaryBlob(db, SQL_Vectors_read_vector_cmd, ID_map_ptr->first_vec_ids[vec_num], temp_vec, vec_len_bytes, 0, NULL);
+      if ( memcmp(master_first_vecs_b[vec_num], temp_vec, vec_len_bytes) != 0 )
+         { printf("ERROR: GetCreateEnrollIDMap(): Master first vector %d does NOT equal stored vector!\n", vec_num); exit(EXIT_FAILURE); }
+      ReadBinaryBlob(db, SQL_Vectors_read_vector_cmd, ID_map_ptr->second_vec_ids[vec_num], temp_vec, vec_len_bytes, 0, NULL);
+      if ( memcmp(master_second_vecs_b[vec_num], temp_vec, vec_len_bytes) != 0 )
+         { printf("ERROR: GetCreateEnrollIDMap(): Master second vector %d does NOT equal stored vector!\n", vec_num); exit(EXIT_FAILURE); }
 #endif
 
 // We automatically detected when reading vectors and mask files which vectors are rising and counted them (and also made sure they
@@ -1820,42 +2340,80 @@ printf("\tWrote binary vectors into Vector Table for %d with 1st vector index %d
       else
          strcpy(rise_fall_str, "F");
 
-#ifdef DEBUG
-printf("Creating/Adding VecPair for vec_num %d, R/F %s, 1st vec index %d, 2nd vec index %d and design index %d!\n",
-   vec_num, rise_fall_str, first_vec_index, second_vec_index, design_index); fflush(stdout);
-#endif
-
 // Add a vector pair to VecPair table. NOTE: a 'unique' index is setup on VecPair that uses 'first_vec_index', 'second_vec_index' and
-// 'design_index', so if the VecPair already exists, it is NOT added again. ALSO NOTE: We will fill in NumPNs after we add and count the 
-// timing values below.
-      InsertIntoTable(max_string_len, db, "VecPairs", SQL_VecPairs_insert_into_cmd, NULL, 0, rise_fall_str, NULL, NULL, NULL, NULL, first_vec_index, 
-         second_vec_index, -1, design_index, -1, -1.0, -1.0);
-
-#ifdef DEBUG
-gettimeofday(&t1, 0); elapsed = (t1.tv_sec-t2.tv_sec)*1000000 + t1.tv_usec-t2.tv_usec; printf("\tElapsed %ld us\n\n", (long)elapsed);
-gettimeofday(&t2, 0);
-printf("Getting index from VecPair Table\n"); fflush(stdout);
-#endif
-
-// Get the index for this newly added VecPair.
-      if ( (vecpair_index = GetIndexFromTable(max_string_len, db, "VecPairs", SQL_VecPairs_get_index_cmd, NULL, 0, NULL, NULL, NULL, NULL, 
-         first_vec_index, second_vec_index, design_index)) == -1 )
+// 'design_index', so if the VecPair already exists, it is NOT added again. ALSO NOTE: NumPNs is filled in after the timing values 
+// are added and counted.
+      if ( (ID_map_ptr->vecpair_ids[vec_num] = InsertOrGetIndex(max_string_len, db, "VecPairs", SQL_VecPairs_insert_into_cmd, 
+         SQL_VecPairs_get_index_cmd, NULL, 0, rise_fall_str, ID_map_ptr->first_vec_ids[vec_num], ID_map_ptr->second_vec_ids[vec_num], 
+         design_index)) == -1 )
          {
-         printf("ERROR: ProcessMasterVecsAndTimingData(): Failed to find vecpair_index for vec_num %d in VecPairs table!\n", vec_num); 
+         printf("ERROR: GetCreateEnrollIDMap(): Failed to find vecpair_index for vec_num %d in VecPairs table!\n", vec_num); 
          exit(EXIT_FAILURE); 
          }
 
 #ifdef DEBUG
-printf("\tWrote VecPair with index %d\n", vecpair_index); fflush(stdout);
+printf("GetCreateEnrollIDMap(): Vec %d: 1st vector index %d, 2nd vector index %d, VecPair index %d\n", vec_num, 
+   ID_map_ptr->first_vec_ids[vec_num], ID_map_ptr->second_vec_ids[vec_num], ID_map_ptr->vecpair_ids[vec_num]); fflush(stdout);
 #endif
+      }
 
-#ifdef DEBUG
-gettimeofday(&t1, 0); elapsed = (t1.tv_sec-t2.tv_sec)*1000000 + t1.tv_usec-t2.tv_usec; printf("\tElapsed %ld us\n\n", (long)elapsed);
-gettimeofday(&t2, 0);
-printf("Saving timing data to TimingVals table\n"); fflush(stdout);
-#endif
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Free the storage in the EnrollIDMapStruct. The structure can be passed to GetCreateEnrollIDMap() again.
+
+void FreeEnrollIDMap(EnrollIDMapStruct *ID_map_ptr)
+   {
+   if ( ID_map_ptr->first_vec_ids != NULL )
+      free(ID_map_ptr->first_vec_ids);
+   if ( ID_map_ptr->second_vec_ids != NULL )
+      free(ID_map_ptr->second_vec_ids);
+   if ( ID_map_ptr->vecpair_ids != NULL )
+      free(ID_map_ptr->vecpair_ids);
+   ID_map_ptr->first_vec_ids = NULL;
+   ID_map_ptr->second_vec_ids = NULL;
+   ID_map_ptr->vecpair_ids = NULL;
+   ID_map_ptr->num_vec_pairs = 0;
+   ID_map_ptr->design_index = -1;
 
-// Add the timing data for this PUFInstance and VecPair. Unlike above, this should never find that the TimingVal exists. 
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Add master vectors to the Vectors table, and then vector pairs to the VecPairs table, and then the timing 
+// data to the TimingVals table. The vectors and vector pairs are handled by GetCreateEnrollIDMap(), which
+// does the work only for the first chip enrolled with 'ID_map_ptr'. Timing values are deleted and then 
+// re-added if they already exist b/c the user must first decide if the PUFInstance is to be preserved or 
+// replaced. This is accomplished because a foreign key and ON DELETE CASCADE is set on the TimingVals database 
+// to the PUFInstance table. The caller should wrap each chip in SQLBeginTransaction()/SQLCommitTransaction().
+
+void ProcessMasterVecsAndTimingData(int max_string_len, sqlite3 *db, int design_index, int instance_index,
+   int master_num_vec_pairs, int master_num_rise_vec_pairs, unsigned char **master_first_vecs_b, 
+   unsigned char **master_second_vecs_b, float *PNX, float *PNX_Tsig, int *rise_fall, int *vec_pairs, 
+   int *POs, int num_PNR, int num_PNX, int num_PIs, int num_POs, EnrollIDMapStruct *ID_map_ptr)
+   {
+   int vecpair_index, num_PNs_per_vecpair;
+   int vec_num;
+   int tot_TVs;
+
+printf("ENROLL:\tPUFDesign %d: PUFInstance %d\tFor Num Vectors %d\n", design_index, instance_index, master_num_vec_pairs); fflush(stdout);
+
+// Get the ids of the vectors and vector pairs, adding them to the database if needed.
+   GetCreateEnrollIDMap(max_string_len, db, design_index, master_num_vec_pairs, master_num_rise_vec_pairs, master_first_vecs_b, 
+      master_second_vecs_b, num_PIs, ID_map_ptr);
+
+// ---------------------------------------------------------
+   tot_TVs = 0;
+   for ( vec_num = 0; vec_num < master_num_vec_pairs; vec_num++ )
+      {
+      vecpair_index = ID_map_ptr->vecpair_ids[vec_num];
+
+// Add the timing data for this PUFInstance and VecPair. Unlike the vectors, this should never find that the TimingVal exists. 
       num_PNs_per_vecpair = AddTimingDataToDB(max_string_len, db, SQL_TimingVals_insert_into_cmd, vec_num, instance_index, vecpair_index, 
          PNX, PNX_Tsig, rise_fall, vec_pairs, POs, num_PNR, num_PNX, master_num_rise_vec_pairs, num_POs);
 
@@ -1863,19 +2421,12 @@ printf("Saving timing data to TimingVals table\n"); fflush(stdout);
       UpdateVecPairsNumPNsField(max_string_len, db, num_PNs_per_vecpair, vecpair_index);
 
 #ifdef DEBUG
-printf("\tWrote TimingVals with %d elements\n", num_PNs_per_vecpair); fflush(stdout);
+printf("\tWrote TimingVals for VecPair %d with %d elements\n", vecpair_index, num_PNs_per_vecpair); fflush(stdout);
 #endif
       tot_TVs += num_PNs_per_vecpair;
-
-#ifdef DEBUG
-gettimeofday(&t1, 0); elapsed = (t1.tv_sec-t2.tv_sec)*1000000 + t1.tv_usec-t2.tv_usec; printf("\tElapsed %ld us\n\n", (long)elapsed);
-fflush(stdout);
-#endif
       }
 
 printf("\tWrote Total TimingVals %d\n", tot_TVs); fflush(stdout);
-#ifdef DEBUG
-#endif
 
    return;
    }
@@ -3596,18 +4147,24 @@ printf("Getting %d PNR/PNF (or tsig) data for PUF_instance_index %d\n", num_VPPO
 // Tried a couple things here to speed up the direct database access method but none of my attempts resulted in any speedup. Returning all timing values 
 // associated with a vector pair using GetAllocateListOfFloats also isn't going to work since we would then need to select a small subset from those returned
 // (see bckup/extra).
-            char sql_command_str[max_string_len];
-            char *zErrMsg = 0;
+// The statement comes from the prepared statement cache, so no SQL is compiled per PN. A missing row leaves the -50000.0 marker.
+            sqlite3_stmt *pStmt;
             float ave_val;
-            int fc;
 
-// For error check in callback.
             ave_val = -50000.0;
-            sprintf(sql_command_str, "SELECT Ave FROM TimingVals WHERE PUFInstance = %d AND VecPair = %d AND PO = %d;", 
-               PUF_instance_index, vecpair_id_PO[vppo_num].vecpair_id, vecpair_id_PO[vppo_num].PO_num);
-            fc = sqlite3_exec(db, sql_command_str, SQL_GetTimingValsOpt_callback, &ave_val, &zErrMsg);
-            if ( fc != SQLITE_OK )
-               { printf("SQL ERROR: %s\n", zErrMsg); sqlite3_free(zErrMsg); exit(EXIT_FAILURE); }
+            pStmt = SQLStmtAcquire(db, SQL_TimingVals_get_Ave_cmd, "GetPUFInstanceTimingInfoUsingVecPairPOStruct()");
+            SQLStmtBindInt(pStmt, 1, PUF_instance_index, "GetPUFInstanceTimingInfoUsingVecPairPOStruct()");
+            SQLStmtBindInt(pStmt, 2, vecpair_id_PO[vppo_num].vecpair_id, "GetPUFInstanceTimingInfoUsingVecPairPOStruct()");
+            SQLStmtBindInt(pStmt, 3, vecpair_id_PO[vppo_num].PO_num, "GetPUFInstanceTimingInfoUsingVecPairPOStruct()");
+            if ( SQLStmtStep(pStmt, "GetPUFInstanceTimingInfoUsingVecPairPOStruct()") == 1 )
+               {
+
+// Divide the database stored integer value by 16 to make it a FIXED POINT value.
+               ave_val = SQLStmtColumnFloat(pStmt, 0, "GetPUFInstanceTimingInfoUsingVecPairPOStruct()")/16.0;
+               if ( SQLStmtStep(pStmt, "GetPUFInstanceTimingInfoUsingVecPairPOStruct()") == 1 )
+                  { printf("ERROR: GetPUFInstanceTimingInfoUsingVecPairPOStruct(): More than 1 row matched in table!\n"); exit(EXIT_FAILURE); }
+               }
+            SQLStmtRelease(pStmt);
 
             if ( doing_rise_PNs == 1 )
                (*PNR_TSig_ptr)[num_rise_PNs - 1] = ave_val;
@@ -20,6 +20,7 @@
 #include <stdio.h>
 #include <string.h>  
 #include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -32,6 +33,7 @@
 #include <math.h>
 
 #include <pthread.h>
+#include <stdint.h>
 
 #include <sqlite3.h>
 
@@ -44,12 +46,25 @@
 #define NUM_RISE_REQUIRED_PNS (NUM_REQUIRED_PNDIFFS)
 #define NUM_FALL_REQUIRED_PNS (NUM_REQUIRED_PNDIFFS)
 
+// Maximum number of prepared statements kept open by SQLStmtAcquire() per thread, across all database connections, and the number
+// of hash buckets of a thread's cache. Statements are keyed by connection and SQL text and are checked out for the duration of one 
+// query, so a connection shared by several threads (opened with SQLITE_OPEN_FULLMUTEX) gets one handle per thread.
+#define SQL_STMT_CACHE_MAX 64
+#define SQL_STMT_CACHE_BUCKETS 128
+
+// Binary chip enrollment file, see WriteChipEnrollPNsBinary().
+#define ENROLL_PNS_BIN_MAGIC "HELPPNB\n"
+#define ENROLL_PNS_BIN_MAGIC_LEN 8
+#define ENROLL_PNS_BIN_VERSION 1
+
 extern const char *SQL_PUFDesign_get_index_cmd;
 extern const char *SQL_PUFDesign_insert_into_cmd;
+extern const char *SQL_PUFDesign_get_num_PIs_POs_cmd;
 
 extern const char *SQL_PUFInstance_get_index_cmd;
 extern const char *SQL_PUFInstance_insert_into_cmd;
 extern const char *SQL_PUFInstance_delete_cmd;
+extern const char *SQL_PUFInstance_get_info_cmd;
 
 extern const char *SQL_Vectors_insert_into_cmd;
 extern const char *SQL_Vectors_read_vector_cmd;
@@ -57,14 +72,22 @@ extern const char *SQL_Vectors_get_index_cmd;
 
 extern const char *SQL_VecPairs_insert_into_cmd;
 extern const char *SQL_VecPairs_get_index_cmd;
+extern const char *SQL_VecPairs_get_NumPNs_cmd;
+extern const char *SQL_VecPairs_get_R_F_str_cmd;
+extern const char *SQL_VecPairs_update_NumPNs_cmd;
 
 extern const char *SQL_TimingVals_insert_into_cmd;
+extern const char *SQL_TimingVals_get_Ave_cmd;
+extern const char *SQL_TimingVals_get_TSig_cmd;
 
 extern const char *SQL_PathSelectMasks_insert_into_cmd;
 extern const char *SQL_PathSelectMasks_get_index_cmd;
 
 extern const char *SQL_Challenges_insert_into_cmd;
 extern const char *SQL_Challenges_get_index_cmd;
+extern const char *SQL_Challenges_get_NumVecs_NumPNs_cmd;
+extern const char *SQL_Challenges_update_NumVecs_cmd;
+extern const char *SQL_Challenges_update_NumPNs_cmd;
 
 extern const char *SQL_ChallengeVecPairs_insert_into_cmd;
 extern const char *SQL_ChallengeVecPairs_get_index_cmd;
@@ -105,11 +128,85 @@ typedef struct
    int vecpair_id;
    int PO_num;
    } VecPairPOStruct; 
+
+typedef struct
+   {
+   sqlite3 *db;
+   char *SQL_cmd;
+   unsigned int hash;
+   sqlite3_stmt *pStmt;
+   int in_use;
+   int next;
+   unsigned long last_used;
+   } SQLStmtCacheEntryStruct;
+
+// Statement cache of one thread. 'buckets' holds the first entry of each hash chain (-1 when empty), linked through 'next'. 
+// 'mutex' is only contended by SQLStmtCacheFinalize() and 'next' links the caches of all threads.
+typedef struct SQLStmtCacheStruct
+   {
+   pthread_mutex_t mutex;
+   SQLStmtCacheEntryStruct entries[SQL_STMT_CACHE_MAX];
+   int buckets[SQL_STMT_CACHE_BUCKETS];
+   int num_entries;
+   unsigned long use_cnt;
+   struct SQLStmtCacheStruct *next;
+   } SQLStmtCacheStruct;
+
+// Database ids of the master vectors and vector pairs, filled in by GetCreateEnrollIDMap(). A zero-initialized structure is empty.
+typedef struct
+   {
+   int design_index;
+   int num_vec_pairs;
+   int *first_vec_ids;
+   int *second_vec_ids;
+   int *vecpair_ids;
+   } EnrollIDMapStruct;
+
+// Header of a binary chip enrollment file (32 bytes). All fields are native-endian.
+typedef struct
+   {
+   char magic[ENROLL_PNS_BIN_MAGIC_LEN];
+   unsigned int version;
+   unsigned int num_POs;
+   unsigned int num_sams;
+   unsigned int num_PNR;
+   unsigned int num_PNX;
+   unsigned int reserved;
+   } EnrollPNsBinHeaderStruct;
+
+// Raw enrollment samples for one chip, num_sams per PN with the rising PNs first. The arrays are heap allocated by 
+// the text parser or point into a read-only mapping (map_base != NULL) for binary files. 
+typedef struct
+   {
+   int num_PNX;
+   int num_PNR;
+   int num_sams;
+   int num_alloc_PNX;
+   int *vec_pairs;
+   int *POs;
+   float *samples;
+   void *map_base;
+   size_t map_size;
+   } EnrollPNsStruct;
 #define DATABASE_STRUCTS
 #endif
 
 int LoadOrSaveDb(sqlite3 *pInMemory, const char *zFilename, int isSave);
 
+sqlite3_stmt *SQLStmtAcquire(sqlite3 *db, const char *SQL_cmd, char *calling_routine_str);
+void SQLStmtRelease(sqlite3_stmt *pStmt);
+void SQLStmtCacheFinalize(sqlite3 *db);
+void SQLStmtBindInt(sqlite3_stmt *pStmt, int param_num, int val, char *calling_routine_str);
+void SQLStmtBindText(sqlite3_stmt *pStmt, int param_num, const char *text, char *calling_routine_str);
+void SQLStmtBindBlob(sqlite3_stmt *pStmt, int param_num, const unsigned char *blob, int blob_size_bytes, char *calling_routine_str);
+int SQLStmtStep(sqlite3_stmt *pStmt, char *calling_routine_str);
+int SQLStmtColumnInt(sqlite3_stmt *pStmt, int col_index, char *calling_routine_str);
+float SQLStmtColumnFloat(sqlite3_stmt *pStmt, int col_index, char *calling_routine_str);
+void SQLStmtColumnString(sqlite3_stmt *pStmt, int col_index, int required_string_len, int max_string_len, char *field_val_str, 
+   char *calling_routine_str);
+void SQLBeginTransaction(sqlite3 *db);
+void SQLCommitTransaction(sqlite3 *db);
+
 void Get_IDs(int max_string_len, sqlite3 *db, char *table_name, SQLIntStruct *index_struct_ptr);
 void Delete_ForID(int max_string_len, sqlite3 *db, char *table_name, int index);
 
@@ -126,6 +223,7 @@ void FreeStringsDataForRow(SQLRowStringsStruct *row_strings_struct_ptr);
 void UpdateVecPairsNumPNsField(int max_string_len, sqlite3 *db, int num_vals_per_vecpair, int vecpair_index);
 int GetVecPairsRiseFallStrField(int max_string_len, sqlite3 *db, int vecpair_index);
 int GetVecPairsNumPNsField(int max_string_len, sqlite3 *db, int vecpair_index);
+float GetTimingValsAveField(int max_string_len, sqlite3 *db, int PUF_instance_index, int vecpair_index, int PO_num);
 
 void UpdateChallengesNumPNFields(int max_string_len, sqlite3 *db, int challenge_index, int tot_PNs, int tot_rise_PNs);
 void UpdateChallengesNumVecFields(int max_string_len, sqlite3 *db, int challenge_index, int tot_vecs, int tot_rise_vecs);
@@ -158,6 +256,14 @@ void DetermineNumSelectedPOsInMask(char *mask, int num_POs, int *num_no_trans_pt
 
 int DeletePUFInstance(int max_string_len, sqlite3 *db, const char *SQL_cmd, int instance_index);
 
+void GrowEnrollPNs(EnrollPNsStruct *EP_ptr, int num_PNX, int num_sams);
+void FreeEnrollPNs(EnrollPNsStruct *EP_ptr);
+int ParseChipEnrollPNsText(int max_string_len, char *ChipEnrollDatafile, EnrollPNsStruct *EP_ptr, int num_POs, 
+   int has_masks, int num_vec_pairs, char **master_masks);
+int IsChipEnrollPNsBinary(char *ChipEnrollDatafile);
+void WriteChipEnrollPNsBinary(char *ChipEnrollBinfile, EnrollPNsStruct *EP_ptr, int num_POs);
+int LoadChipEnrollPNsBinary(char *ChipEnrollBinfile, EnrollPNsStruct *EP_ptr, int num_POs);
+
 int ReadChipEnrollPNs(int max_string_len, char *ChipEnrollDatafile, float **PNX_ptr, 
    float **PNX_Tsig_ptr, int **rise_fall_ptr, int **vec_pairs_ptr, int **POs_ptr, int *num_PNX_ptr, 
    int num_POs, int has_masks, int num_vec_pairs, char **master_masks, int debug_flag);
@@ -166,10 +272,18 @@ void GetCreatePUFDesignAndInstance(int max_string_len, sqlite3 *db, char *Netlis
    char *Chip_name, char *Device_name, char *Placement_name, int *design_index_ptr, int *instance_index_ptr, 
    int num_PIs, int num_POs);
 
+int InsertOrGetIndex(int max_string_len, sqlite3 *db, char *Table, const char *SQL_insert_cmd, const char *SQL_get_index_cmd, 
+   unsigned char *blob, int blob_size_bytes, char *text1, int int1, int int2, int int3);
+
+void GetCreateEnrollIDMap(int max_string_len, sqlite3 *db, int design_index, int master_num_vec_pairs, 
+   int master_num_rise_vec_pairs, unsigned char **master_first_vecs_b, unsigned char **master_second_vecs_b, 
+   int num_PIs, EnrollIDMapStruct *ID_map_ptr);
+void FreeEnrollIDMap(EnrollIDMapStruct *ID_map_ptr);
+
 void ProcessMasterVecsAndTimingData(int max_string_len, sqlite3 *db, int design_index, int instance_index,
    int master_num_vec_pairs, int master_num_rise_vec_pairs, unsigned char **master_first_vecs_b, 
    unsigned char **master_second_vecs_b, float *PNX, float *PNX_Tsig, int *rise_fall, int *vec_pairs, 
-   int *POs, int num_PNR, int num_PNX, int num_PIs, int num_POs);
+   int *POs, int num_PNR, int num_PNX, int num_PIs, int num_POs, EnrollIDMapStruct *ID_map_ptr);
 
 void CheckMaskIsConsistentWithVecPairTimingVals(int max_string_len, sqlite3 *db, int vecpair_index, 
    char *challenge_mask, int num_POs);
@@ -0,0 +1,63 @@
+// ========================================================================================================
+// ========================================================================================================
+// ***************************************** convert_enrollPNs.c ******************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+// 
+// Functions covered by License and Copyright: All 
+//--------------------------------------------------------------------------------
+
+#include "commonDB.h"
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Convert a text chip enrollment file into the binary format read by ReadChipEnrollPNs(). The binary file 
+// holds every PN in the text file (no mask filtering), so it can be used with or without masks by enrollDB.
+// The binary file is read back and compared against the text data before returning.
+
+int main(int argc, char *argv[])
+   {
+   EnrollPNsStruct text_EP, bin_EP;
+   int num_POs;
+
+   if ( argc != 4 )
+      { 
+      printf("ERROR: %s: num outputs (32) -- Text enroll file (C50_SR_RFM_V4_MMCM_P1_25C_1.00V_NCs_2000_E_PUFNums.txt) -- \
+Binary enroll file (C50_SR_RFM_V4_MMCM_P1_25C_1.00V_NCs_2000_E_PUFNums.bin)\n", argv[0]); 
+      exit(EXIT_FAILURE); 
+      }
+
+   sscanf(argv[1], "%d", &num_POs);
+
+   if ( IsChipEnrollPNsBinary(argv[2]) == 1 )
+      { printf("ERROR: %s: '%s' is already a binary enrollment file!\n", argv[0], argv[2]); exit(EXIT_FAILURE); }
+
+   ParseChipEnrollPNsText(MAX_STRING_LEN, argv[2], &text_EP, num_POs, 0, 0, NULL);
+   if ( text_EP.num_PNX == 0 )
+      { printf("ERROR: %s: No PN data found in '%s'!\n", argv[0], argv[2]); exit(EXIT_FAILURE); }
+
+   WriteChipEnrollPNsBinary(argv[3], &text_EP, num_POs);
+
+// Read back and check.
+   LoadChipEnrollPNsBinary(argv[3], &bin_EP, num_POs);
+   if ( bin_EP.num_PNX != text_EP.num_PNX || bin_EP.num_PNR != text_EP.num_PNR || bin_EP.num_sams != text_EP.num_sams ||
+      memcmp(bin_EP.vec_pairs, text_EP.vec_pairs, sizeof(int)*text_EP.num_PNX) != 0 ||
+      memcmp(bin_EP.POs, text_EP.POs, sizeof(int)*text_EP.num_PNX) != 0 ||
+      memcmp(bin_EP.samples, text_EP.samples, sizeof(float)*(size_t)text_EP.num_PNX*text_EP.num_sams) != 0 )
+      { printf("ERROR: %s: Read back of '%s' does not match '%s'!\n", argv[0], argv[3], argv[2]); exit(EXIT_FAILURE); }
+
+   printf("Converted '%s' => '%s'\tNum PNR %d\tNum PNF %d\tNum sams %d\n", argv[2], argv[3], text_EP.num_PNR, 
+      text_EP.num_PNX - text_EP.num_PNR, text_EP.num_sams); fflush(stdout);
+
+   FreeEnrollPNs(&bin_EP);
+   FreeEnrollPNs(&text_EP);
+
+   return 0;
+   }
@@ -14,6 +14,8 @@
 // Functions covered by License and Copyright: All 
 //--------------------------------------------------------------------------------
 
+#include <dirent.h>
+
 #include "commonDB.h"
 
 
@@ -39,52 +41,174 @@ char MasterVecPrefix[MAX_STRING_LEN];
 char MasterVecFile[MAX_STRING_LEN];
 char MasterMaskFile[MAX_STRING_LEN];
 
+// Directory mode: every file in EnrollDir named <Chip>_<Netlist>_<Placement><EnrollFileSuffix> is enrolled.
+char EnrollDir[MAX_STRING_LEN];
+char EnrollFileSuffix[MAX_STRING_LEN];
+
+// Vector and VecPair ids, looked up for the first chip and reused for the rest.
+EnrollIDMapStruct ID_map;
 
-int main(int argc, char **argv)
-   {
-   int master_num_vec_pairs, master_num_rise_vec_pairs;
 
+// ========================================================================================================
+// ========================================================================================================
+// Enroll one chip/placement. All of the rows for the chip are added in one transaction.
+
+void EnrollChip(int max_string_len, sqlite3 *db, char *Chip_name, char *Placement_name, char *ChipEnrollDatafile, 
+   int master_num_vec_pairs, int master_num_rise_vec_pairs, int has_masks, int num_PIs, int num_POs, int DEBUG_FLAG)
+   {
    int *rise_fall, *vec_pairs, *POs;
    float *PNX, *PNX_Tsig;
    int num_PNX, num_PNR;
+
+   int design_index;
+   int instance_index;
+
+   printf("Chip name '%s'\tPlacement name '%s'\n\tChip enroll datafile '%s'\n", Chip_name, Placement_name, ChipEnrollDatafile); fflush(stdout);
+
+// Read timing data from Chip's enrollment data file. Timing data has a blank line that separates the rising and falling PN.
+   num_PNR = ReadChipEnrollPNs(max_string_len, ChipEnrollDatafile, &PNX, &PNX_Tsig, &rise_fall, &vec_pairs, &POs, &num_PNX, 
+      num_POs, has_masks, master_num_vec_pairs, master_masks, DEBUG_FLAG);
+   printf("\n\tNumber of PNR read %d\tNumber of PNF read %d\n", num_PNR, num_PNX - num_PNR);
+
+#ifdef DEBUG
+int i;
+for ( i = 0; i < 10; i++ )
+   printf("PNR %d\tM: %f\tTSig: %f\n", i, PNX[i], PNX_Tsig[i]);
+for ( i = num_PNR; i < num_PNR + 10; i++ )
+   printf("PNF %d\tM: %f\tTSig: %f\n", i, PNX[i], PNX_Tsig[i]);
+fflush(stdout);
+#endif
+
+   SQLBeginTransaction(db);
+
+// ----------------------------------
+// Get/create the PUFDesign index and PUFInstance index.
+   GetCreatePUFDesignAndInstance(max_string_len, db, Netlist_name, Synthesis_name, Chip_name, Device_name, Placement_name, &design_index,
+      &instance_index, num_PIs, num_POs);
+
+// ----------------------------------
+// Add master vectors to the Vectors table in the database, and then vector pairs to the VecPairs table, and then the timing data to the TimingVals
+// table. Vectors and vector pairs usually already exist in the tables, and their ids are looked up only for the first chip (see ID_map). Timing 
+// values are deleted and then re-added if they already exist b/c the user must first decide if the PUFInstance is to be preserved or replaced. This 
+// is accomplished because a foreign key and ON DELETE CASCADE is set on the TimingVals database to the PUFInstance table.
+   ProcessMasterVecsAndTimingData(max_string_len, db, design_index, instance_index, master_num_vec_pairs, master_num_rise_vec_pairs, master_first_vecs_b, 
+      master_second_vecs_b, PNX, PNX_Tsig, rise_fall, vec_pairs, POs, num_PNR, num_PNX, num_PIs, num_POs, &ID_map);
+
+   SQLCommitTransaction(db);
+
+   free(PNX);
+   free(PNX_Tsig);
+   free(rise_fall);
+   free(vec_pairs);
+   free(POs);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Split an enrollment file name of the form <Chip>_<Netlist>_<Placement><EnrollFileSuffix>, e.g., 
+// 'C38_SR_RFM_V4_TDC_P1_25C_1.00V_NCs_2000_E_PUFNums.txt' with suffix '_25C_1.00V_NCs_2000_E_PUFNums.txt', into
+// the chip and placement names. Chip names may contain '_', so the LAST occurrence of the netlist name is used.
+// Returns 0 if the file name does not have this form.
+
+int ParseEnrollFileName(int max_string_len, char *file_name, char *Netlist_name, char *EnrollFileSuffix, char *Chip_name, 
+   char *Placement_name)
+   {
+   char base_name[max_string_len];
+   char netlist_str[max_string_len];
+   char *netlist_ptr, *search_ptr;
+   int base_len, suffix_len;
+
+   base_len = strlen(file_name);
+   suffix_len = strlen(EnrollFileSuffix);
+   if ( base_len <= suffix_len || base_len >= max_string_len || strcmp(&(file_name[base_len - suffix_len]), EnrollFileSuffix) != 0 )
+      return 0;
+   strcpy(base_name, file_name);
+   base_name[base_len - suffix_len] = '\0';
+
+   sprintf(netlist_str, "_%s_", Netlist_name);
+   netlist_ptr = NULL;
+   search_ptr = base_name;
+   while ( (search_ptr = strstr(search_ptr, netlist_str)) != NULL )
+      {
+      netlist_ptr = search_ptr;
+      search_ptr++;
+      }
+   if ( netlist_ptr == NULL || netlist_ptr == base_name || netlist_ptr[strlen(netlist_str)] == '\0' )
+      return 0;
+
+   strcpy(Placement_name, netlist_ptr + strlen(netlist_str));
+   *netlist_ptr = '\0';
+   strcpy(Chip_name, base_name);
+
+   return 1;
+   }
+
+
+int main(int argc, char **argv)
+   {
+   int master_num_vec_pairs, master_num_rise_vec_pairs;
    int has_masks;
 
    sqlite3 *db;
    int rc;
 
-   int design_index;
-   int instance_index;
-
    int num_PIs, num_POs;
    int read_db_into_memory;
 
    int rise_fall_bit_pos;
 
+   int directory_mode;
+   struct dirent **dir_entries;
+   int num_dir_entries, entry_num, num_chips_enrolled;
+   char *zErrMsg = 0;
+   int fc;
+
    int DEBUG_FLAG;
 
 // ===============================================================================
-   if ( argc != 12 )
+   if ( argc != 12 && argc != 11 )
       { 
       printf("ERROR: %s: Master Database (NAT_Master.db) -- Netlist name (SR_RFM_V4_MMCM) -- Synthesis name (SRFSyn1) -- Device name (ZYBO) -- Placement name (P1) -- Chip name (C50) -- \
 num inputs (784) -- num outputs (32) -- MasterVecFilePrefix (challenges/SR_RFM_V4_MMCM_Random_Rise_1000Vs_Fall_1000Vs_NumSeeds_10_vecs) -- has_masks (0/1) -- \
-Enroll path file (/borg_data/FPGAs/ZYBO/SR_RFM/ANALYSIS/data/7_19_2021/C50_SR_RFM_V4_MMCM_P1_25C_1.00V_NCs_2000_E_PUFNums.txt)\n", argv[0]); 
+Enroll path file (/borg_data/FPGAs/ZYBO/SR_RFM/ANALYSIS/data/7_19_2021/C50_SR_RFM_V4_MMCM_P1_25C_1.00V_NCs_2000_E_PUFNums.txt)\n\
+OR directory mode: Master Database -- Netlist name -- Synthesis name -- Device name -- num inputs -- num outputs -- MasterVecFilePrefix -- has_masks -- \
+Enroll directory (../ProvisionData) -- Enroll file suffix (_25C_1.00V_NCs_2000_E_PUFNums.txt), which enrolls every <Chip>_<Netlist>_<Placement><suffix> file\n", argv[0]); 
       exit(EXIT_FAILURE); 
       }
 
+   directory_mode = (argc == 11);
    strcpy(MasterDBname, argv[1]);
    strcpy(Netlist_name, argv[2]);
    strcpy(Synthesis_name, argv[3]);
    strcpy(Device_name, argv[4]);
-   strcpy(Placement_name, argv[5]);
-   strcpy(Chip_name, argv[6]);
-   sscanf(argv[7], "%d", &num_PIs);
-   sscanf(argv[8], "%d", &num_POs);
-   strcpy(MasterVecPrefix, argv[9]);
-   sscanf(argv[10], "%d", &has_masks);
-   strcpy(ChipEnrollDatafile, argv[11]);
-
-   printf("Master DB '%s'\tNetlist name '%s'\tSynthesis name '%s'\tDevice name '%s'\tPlacement name '%s'\tChip name '%s'\n\tMasterVecPrefix '%s'\n\tChip enroll datafile '%s'\n\n", 
-      MasterDBname, Netlist_name, Synthesis_name, Device_name, Placement_name, Chip_name, MasterVecPrefix, ChipEnrollDatafile); fflush(stdout);
+   if ( directory_mode == 0 )
+      {
+      strcpy(Placement_name, argv[5]);
+      strcpy(Chip_name, argv[6]);
+      sscanf(argv[7], "%d", &num_PIs);
+      sscanf(argv[8], "%d", &num_POs);
+      strcpy(MasterVecPrefix, argv[9]);
+      sscanf(argv[10], "%d", &has_masks);
+      strcpy(ChipEnrollDatafile, argv[11]);
+
+      printf("Master DB '%s'\tNetlist name '%s'\tSynthesis name '%s'\tDevice name '%s'\tPlacement name '%s'\tChip name '%s'\n\tMasterVecPrefix '%s'\n\tChip enroll datafile '%s'\n\n", 
+         MasterDBname, Netlist_name, Synthesis_name, Device_name, Placement_name, Chip_name, MasterVecPrefix, ChipEnrollDatafile); fflush(stdout);
+      }
+   else
+      {
+      sscanf(argv[5], "%d", &num_PIs);
+      sscanf(argv[6], "%d", &num_POs);
+      strcpy(MasterVecPrefix, argv[7]);
+      sscanf(argv[8], "%d", &has_masks);
+      strcpy(EnrollDir, argv[9]);
+      strcpy(EnrollFileSuffix, argv[10]);
+
+      printf("Master DB '%s'\tNetlist name '%s'\tSynthesis name '%s'\tDevice name '%s'\n\tMasterVecPrefix '%s'\n\tEnroll directory '%s'\tEnroll file suffix '%s'\n\n", 
+         MasterDBname, Netlist_name, Synthesis_name, Device_name, MasterVecPrefix, EnrollDir, EnrollFileSuffix); fflush(stdout);
+      }
 
 // ====================================================== PARAMETERS ====================================================
 // This is currently the bit position in the configuration vector that indicates rise and fall, with '1' indicating rise
@@ -134,38 +258,55 @@ printf("MasterVecFile\n\t'%s'\nMasterMaskFile USED ONLY if 'has_masks' %d is 1\n
          { printf("Failed to open and copy into memory the Master Database: %s\n", sqlite3_errmsg(db)); sqlite3_close(db); exit(EXIT_FAILURE); }
       }
 
+// Enable CASCADE mode before any transaction is opened. 'PRAGMA foreign_keys' is a no-op inside a transaction, and DeletePUFInstance() 
+// depends on it to remove the timing data of a PUFInstance that is overwritten.
+   fc = sqlite3_exec(db, "PRAGMA foreign_keys = ON", NULL, 0, &zErrMsg);
+   if ( fc != SQLITE_OK )
+      { printf("SQL error: %s\n", zErrMsg); sqlite3_free(zErrMsg); }
+
 // Read the MasterVecFile 
    master_num_vec_pairs = ReadVectorAndASCIIMaskFiles(MAX_STRING_LEN, MasterVecFile, &master_num_rise_vec_pairs, &master_first_vecs_b, 
       &master_second_vecs_b, has_masks, MasterMaskFile, &master_masks, num_PIs, num_POs, rise_fall_bit_pos);
    printf("\n\tNumber of MASTER vectors read %d\tNumber of rising vectors %d\n", master_num_vec_pairs, master_num_rise_vec_pairs);
 
-// Read timing data from Chip's enrollment data file. Timing data has a blank line that separates the rising and falling PN.
-   num_PNR = ReadChipEnrollPNs(MAX_STRING_LEN, ChipEnrollDatafile, &PNX, &PNX_Tsig, &rise_fall, &vec_pairs, &POs, &num_PNX, 
-      num_POs, has_masks, master_num_vec_pairs, master_masks, DEBUG_FLAG);
-   printf("\n\tNumber of PNR read %d\tNumber of PNF read %d\n", num_PNR, num_PNX - num_PNR);
-
+   if ( directory_mode == 0 )
+      EnrollChip(MAX_STRING_LEN, db, Chip_name, Placement_name, ChipEnrollDatafile, master_num_vec_pairs, master_num_rise_vec_pairs, 
+         has_masks, num_PIs, num_POs, DEBUG_FLAG);
 
-#ifdef DEBUG
-int i;
-for ( i = 0; i < 10; i++ )
-   printf("PNR %d\tM: %f\tTSig: %f\n", i, PNX[i], PNX_Tsig[i]);
-for ( i = num_PNR; i < num_PNR + 10; i++ )
-   printf("PNF %d\tM: %f\tTSig: %f\n", i, PNX[i], PNX_Tsig[i]);
-fflush(stdout);
-#endif
-
-// ----------------------------------
-// Get/create the PUFDesign index and PUFInstance index.
-   GetCreatePUFDesignAndInstance(MAX_STRING_LEN, db, Netlist_name, Synthesis_name, Chip_name, Device_name, Placement_name, &design_index,
-      &instance_index, num_PIs, num_POs);
-
-// ----------------------------------
-// Add master vectors to the Vectors table in the database, and then vector pairs to the VecPairs table, and then the timing data to the TimingVals
-// table. It is common for this routine to issue constraint violations because vectors or vector pairs already exist in the tables. Timing values
-// are deleted and then re-added if they already exist b/c the user must first decide if the PUFInstance is to be preserved or replaced. This is
-// accomplished because a foreign key and ON DELETE CASCADE is set on the TimingVals database to the PUFInstance table.
-   ProcessMasterVecsAndTimingData(MAX_STRING_LEN, db, design_index, instance_index, master_num_vec_pairs, master_num_rise_vec_pairs, master_first_vecs_b, 
-      master_second_vecs_b, PNX, PNX_Tsig, rise_fall, vec_pairs, POs, num_PNR, num_PNX, num_PIs, num_POs);
+// Enroll every matching file in the directory, in sorted order, in this process. The master vectors are read once, the vector ids are 
+// looked up once and the database is saved once at the end.
+   else
+      {
+      if ( (num_dir_entries = scandir(EnrollDir, &dir_entries, NULL, alphasort)) < 0 )
+         { printf("ERROR: Failed to read enroll directory '%s'!\n", EnrollDir); exit(EXIT_FAILURE); }
+
+      num_chips_enrolled = 0;
+      for ( entry_num = 0; entry_num < num_dir_entries; entry_num++ )
+         {
+         if ( ParseEnrollFileName(MAX_STRING_LEN, dir_entries[entry_num]->d_name, Netlist_name, EnrollFileSuffix, Chip_name, Placement_name) == 1 )
+            {
+            if ( snprintf(ChipEnrollDatafile, sizeof(ChipEnrollDatafile), "%s/%s", EnrollDir, dir_entries[entry_num]->d_name) >=
+               (int)sizeof(ChipEnrollDatafile) )
+               {
+               printf("ERROR: Path of enroll file '%s' in '%s' is longer than %d characters!\n", dir_entries[entry_num]->d_name, EnrollDir,
+                  (int)sizeof(ChipEnrollDatafile) - 1);
+               exit(EXIT_FAILURE);
+               }
+            printf("\n========================= Enrolling chip file %d: '%s' =========================\n", num_chips_enrolled + 1, 
+               dir_entries[entry_num]->d_name); 
+            EnrollChip(MAX_STRING_LEN, db, Chip_name, Placement_name, ChipEnrollDatafile, master_num_vec_pairs, master_num_rise_vec_pairs, 
+               has_masks, num_PIs, num_POs, DEBUG_FLAG);
+            num_chips_enrolled++;
+            }
+         free(dir_entries[entry_num]);
+         }
+      free(dir_entries);
+
+      printf("\nEnrolled %d chip/placement files from '%s'\n", num_chips_enrolled, EnrollDir); fflush(stdout);
+      if ( num_chips_enrolled == 0 )
+         { printf("ERROR: No files in '%s' match <Chip>_%s_<Placement>%s!\n", EnrollDir, Netlist_name, EnrollFileSuffix); exit(EXIT_FAILURE); }
+      }
+   FreeEnrollIDMap(&ID_map);
 
 // If we read the database into memory, and updated it with data then we need to store it back.
    if ( read_db_into_memory == 1 )
@@ -175,6 +316,7 @@ fflush(stdout);
          { printf("Failed to store 'in memory' database to %s: %s\n", MasterDBname, sqlite3_errmsg(db)); sqlite3_close(db); exit(EXIT_FAILURE); }
       }
 
+   SQLStmtCacheFinalize(db);
    sqlite3_close(db);
 
    return 0;
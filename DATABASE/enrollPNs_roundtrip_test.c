@@ -0,0 +1,280 @@
+// ========================================================================================================
+// ========================================================================================================
+// ************************************** enrollPNs_roundtrip_test.c **************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//
+// Functions covered by License and Copyright: All
+//--------------------------------------------------------------------------------
+
+// Round-trip test of the binary chip enrollment format. Random text enrollment files (plain and TDC style,
+// with calibration lines and MPS fields) are parsed, written in binary with WriteChipEnrollPNsBinary() as
+// convert_enrollPNs does, mapped back, written out as text again and parsed a second time. The vector numbers,
+// PO numbers and samples MUST be identical at every step. ReadChipEnrollPNs() MUST also return the same PNs
+// for the text and the binary file, with and without masks.
+//
+// Usage: enrollPNs_roundtrip_test [num_files] [temp file prefix]
+
+#include "commonDB.h"
+
+#define RT_NUM_POS 32
+#define RT_NUM_VEC_PAIRS 64
+
+static unsigned long long RT_rng_state = 0x9E3779B97F4A7C15ULL;
+
+
+// ========================================================================================================
+// ========================================================================================================
+// xorshift64 for the test data.
+
+static unsigned int RTRand()
+   {
+   RT_rng_state ^= RT_rng_state >> 12;
+   RT_rng_state ^= RT_rng_state << 25;
+   RT_rng_state ^= RT_rng_state >> 27;
+   return (unsigned int)((RT_rng_state * 0x2545F4914F6CDD1DULL) >> 32);
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Write 'EP_ptr' as a text enrollment file: the rising PNs, a blank line, the falling PNs and a blank line.
+// In TDC style, calibration lines come first and every PN line carries MPS fields. Samples are printed with
+// %.9g so strtof() recovers the exact float.
+
+static void RTWriteText(char *filename, EnrollPNsStruct *EP_ptr, int TDC_style)
+   {
+   int PN_num, sam_num, cal_num;
+   FILE *OUTFILE;
+
+   if ( (OUTFILE = fopen(filename, "w")) == NULL )
+      { printf("ERROR: RTWriteText(): Could not open '%s' for writing!\n", filename); exit(EXIT_FAILURE); }
+
+   if ( TDC_style == 1 )
+      for ( cal_num = 0; cal_num < 3; cal_num++ )
+         fprintf(OUTFILE, "Calibration %d\tTap %d\tDelay %d\n", cal_num, (int)(RTRand() % 64), (int)(RTRand() % 1000));
+
+   for ( PN_num = 0; PN_num < EP_ptr->num_PNX; PN_num++ )
+      {
+      if ( PN_num == EP_ptr->num_PNR )
+         fprintf(OUTFILE, "\n");
+      fprintf(OUTFILE, "V: %d\tO: %d\tC: %d\t", EP_ptr->vec_pairs[PN_num], EP_ptr->POs[PN_num], PN_num);
+      if ( TDC_style == 1 )
+         fprintf(OUTFILE, "MPS1: %d\tMPS2: %d\t", (int)(RTRand() % 8), (int)(RTRand() % 8));
+      for ( sam_num = 0; sam_num < EP_ptr->num_sams; sam_num++ )
+         fprintf(OUTFILE, " %.9g", EP_ptr->samples[(size_t)PN_num*EP_ptr->num_sams + sam_num]);
+      fprintf(OUTFILE, "\n");
+      }
+   if ( EP_ptr->num_PNR == EP_ptr->num_PNX )
+      fprintf(OUTFILE, "\n");
+   fprintf(OUTFILE, "\n");
+
+   if ( fclose(OUTFILE) != 0 )
+      { printf("ERROR: RTWriteText(): Failed to close '%s'!\n", filename); exit(EXIT_FAILURE); }
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Random enrollment data. Samples are mostly integer counts as in the hardware files, with some fractional
+// and negative values so that the float formatting is exercised too.
+
+static void RTGenEnrollPNs(EnrollPNsStruct *EP_ptr, int num_PNX, int num_PNR, int num_sams)
+   {
+   int PN_num, sam_num;
+   float base;
+
+   memset(EP_ptr, 0, sizeof(EnrollPNsStruct));
+   GrowEnrollPNs(EP_ptr, num_PNX, num_sams);
+   EP_ptr->num_PNX = num_PNX;
+   EP_ptr->num_PNR = num_PNR;
+   EP_ptr->num_sams = num_sams;
+   for ( PN_num = 0; PN_num < num_PNX; PN_num++ )
+      {
+      EP_ptr->vec_pairs[PN_num] = (int)(RTRand() % RT_NUM_VEC_PAIRS);
+      EP_ptr->POs[PN_num] = (int)(RTRand() % RT_NUM_POS);
+      base = (float)(200 + RTRand() % 400);
+      for ( sam_num = 0; sam_num < num_sams; sam_num++ )
+         {
+         if ( RTRand() % 8 == 0 )
+            EP_ptr->samples[(size_t)PN_num*num_sams + sam_num] = (float)((int)(RTRand() % 20000) - 10000)/(float)(1 + RTRand() % 1000);
+         else
+            EP_ptr->samples[(size_t)PN_num*num_sams + sam_num] = base + (float)(RTRand() % 9) - 4.0;
+         }
+      }
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Number of differences between two sets of enrollment data.
+
+static int RTCompareEnrollPNs(char *what_str, EnrollPNsStruct *EP_A_ptr, EnrollPNsStruct *EP_B_ptr)
+   {
+   int num_errors = 0;
+
+   if ( EP_A_ptr->num_PNX != EP_B_ptr->num_PNX || EP_A_ptr->num_PNR != EP_B_ptr->num_PNR || EP_A_ptr->num_sams != EP_B_ptr->num_sams )
+      {
+      printf("\t%s: num_PNX %d/%d\tnum_PNR %d/%d\tnum_sams %d/%d\n", what_str, EP_A_ptr->num_PNX, EP_B_ptr->num_PNX, EP_A_ptr->num_PNR,
+         EP_B_ptr->num_PNR, EP_A_ptr->num_sams, EP_B_ptr->num_sams);
+      return 1;
+      }
+   if ( memcmp(EP_A_ptr->vec_pairs, EP_B_ptr->vec_pairs, sizeof(int)*EP_A_ptr->num_PNX) != 0 )
+      { printf("\t%s: vector numbers differ!\n", what_str); num_errors++; }
+   if ( memcmp(EP_A_ptr->POs, EP_B_ptr->POs, sizeof(int)*EP_A_ptr->num_PNX) != 0 )
+      { printf("\t%s: PO numbers differ!\n", what_str); num_errors++; }
+   if ( memcmp(EP_A_ptr->samples, EP_B_ptr->samples, sizeof(float)*(size_t)EP_A_ptr->num_PNX*EP_A_ptr->num_sams) != 0 )
+      { printf("\t%s: samples differ!\n", what_str); num_errors++; }
+
+   return num_errors;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// ReadChipEnrollPNs() on the text and the binary file MUST return the same PNs. Returns the number of
+// differences.
+
+static int RTCompareReadChipEnrollPNs(char *text_filename, char *bin_filename, int has_masks, char **masks)
+   {
+   float *PNX[2], *PNX_Tsig[2];
+   int *rise_fall[2], *vec_pairs[2], *POs[2];
+   int num_PNX[2], num_PNR[2];
+   int file_num, num_errors;
+
+   num_PNR[0] = ReadChipEnrollPNs(MAX_STRING_LEN, text_filename, &PNX[0], &PNX_Tsig[0], &rise_fall[0], &vec_pairs[0], &POs[0], &num_PNX[0],
+      RT_NUM_POS, has_masks, RT_NUM_VEC_PAIRS, masks, 0);
+   num_PNR[1] = ReadChipEnrollPNs(MAX_STRING_LEN, bin_filename, &PNX[1], &PNX_Tsig[1], &rise_fall[1], &vec_pairs[1], &POs[1], &num_PNX[1],
+      RT_NUM_POS, has_masks, RT_NUM_VEC_PAIRS, masks, 0);
+
+   num_errors = 0;
+   if ( num_PNX[0] != num_PNX[1] || num_PNR[0] != num_PNR[1] )
+      {
+      printf("\tReadChipEnrollPNs() masks %d: text num_PNX %d num_PNR %d -- binary num_PNX %d num_PNR %d\n", has_masks, num_PNX[0],
+         num_PNR[0], num_PNX[1], num_PNR[1]);
+      num_errors++;
+      }
+   else if ( memcmp(PNX[0], PNX[1], sizeof(float)*num_PNX[0]) != 0 || memcmp(PNX_Tsig[0], PNX_Tsig[1], sizeof(float)*num_PNX[0]) != 0 ||
+      memcmp(rise_fall[0], rise_fall[1], sizeof(int)*num_PNX[0]) != 0 || memcmp(vec_pairs[0], vec_pairs[1], sizeof(int)*num_PNX[0]) != 0 ||
+      memcmp(POs[0], POs[1], sizeof(int)*num_PNX[0]) != 0 )
+      {
+      printf("\tReadChipEnrollPNs() masks %d: text and binary PNs differ!\n", has_masks);
+      num_errors++;
+      }
+
+   for ( file_num = 0; file_num < 2; file_num++ )
+      {
+      free(PNX[file_num]);
+      free(PNX_Tsig[file_num]);
+      free(rise_fall[file_num]);
+      free(vec_pairs[file_num]);
+      free(POs[file_num]);
+      }
+
+   return num_errors;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+
+int main(int argc, char *argv[])
+   {
+   char text_filename[MAX_STRING_LEN], bin_filename[MAX_STRING_LEN], text2_filename[MAX_STRING_LEN];
+   char temp_prefix[MAX_STRING_LEN];
+   int num_files;
+
+   EnrollPNsStruct gen_EP, text_EP, bin_EP, text2_EP;
+   char *masks[RT_NUM_VEC_PAIRS];
+   int file_num, vec_num, PO_num, num_PNX, num_PNR, num_sams, TDC_style;
+   int num_errors, num_failed;
+
+   num_files = 20;
+   snprintf(temp_prefix, sizeof(temp_prefix), "/tmp/enrollPNs_rt_%d", (int)getpid());
+   if ( argc > 1 )
+      num_files = atoi(argv[1]);
+   if ( argc > 2 && snprintf(temp_prefix, sizeof(temp_prefix), "%s", argv[2]) >= (int)sizeof(temp_prefix) )
+      { printf("ERROR: main(): Temp file prefix is too long!\n"); exit(EXIT_FAILURE); }
+   if ( num_files <= 0 )
+      { printf("ERROR: main(): Number of files must be positive!\n"); exit(EXIT_FAILURE); }
+
+   if ( snprintf(text_filename, sizeof(text_filename), "%s.txt", temp_prefix) >= (int)sizeof(text_filename) ||
+      snprintf(bin_filename, sizeof(bin_filename), "%s.bin", temp_prefix) >= (int)sizeof(bin_filename) ||
+      snprintf(text2_filename, sizeof(text2_filename), "%s_2.txt", temp_prefix) >= (int)sizeof(text2_filename) )
+      { printf("ERROR: main(): Temp file names are too long!\n"); exit(EXIT_FAILURE); }
+
+// Random masks in the verifier format: '0', '1', 'u' or 'q' per PO, high order PO first.
+   for ( vec_num = 0; vec_num < RT_NUM_VEC_PAIRS; vec_num++ )
+      {
+      if ( (masks[vec_num] = (char *)malloc(RT_NUM_POS + 1)) == NULL )
+         { printf("ERROR: main(): Failed to allocate storage for the masks!\n"); exit(EXIT_FAILURE); }
+      for ( PO_num = 0; PO_num < RT_NUM_POS; PO_num++ )
+         masks[vec_num][PO_num] = "01uq"[RTRand() % 4];
+      masks[vec_num][RT_NUM_POS] = '\0';
+      }
+
+   num_failed = 0;
+   for ( file_num = 0; file_num < num_files; file_num++ )
+      {
+
+// The first files cover one PN, one sample and no falling PNs.
+      num_PNX = 1 + (int)(RTRand() % 3000);
+      num_sams = 1 + (int)(RTRand() % 32);
+      if ( file_num == 0 )
+         { num_PNX = 1; num_sams = 1; }
+      num_PNR = (int)(RTRand() % (num_PNX + 1));
+      if ( file_num == 1 )
+         num_PNR = num_PNX;
+      if ( num_PNR == 0 )
+         num_PNR = 1;
+      TDC_style = file_num % 2;
+
+      RTGenEnrollPNs(&gen_EP, num_PNX, num_PNR, num_sams);
+      RTWriteText(text_filename, &gen_EP, TDC_style);
+
+// text -> binary -> text
+      ParseChipEnrollPNsText(MAX_STRING_LEN, text_filename, &text_EP, RT_NUM_POS, 0, 0, NULL);
+      WriteChipEnrollPNsBinary(bin_filename, &text_EP, RT_NUM_POS);
+      LoadChipEnrollPNsBinary(bin_filename, &bin_EP, RT_NUM_POS);
+      RTWriteText(text2_filename, &bin_EP, TDC_style);
+      ParseChipEnrollPNsText(MAX_STRING_LEN, text2_filename, &text2_EP, RT_NUM_POS, 0, 0, NULL);
+
+      num_errors = 0;
+      if ( IsChipEnrollPNsBinary(text_filename) != 0 || IsChipEnrollPNsBinary(bin_filename) != 1 )
+         { printf("\tIsChipEnrollPNsBinary() misclassified the files!\n"); num_errors++; }
+      num_errors += RTCompareEnrollPNs("generated/text", &gen_EP, &text_EP);
+      num_errors += RTCompareEnrollPNs("text/binary", &text_EP, &bin_EP);
+      num_errors += RTCompareEnrollPNs("binary/text", &bin_EP, &text2_EP);
+      num_errors += RTCompareReadChipEnrollPNs(text_filename, bin_filename, 0, masks);
+      num_errors += RTCompareReadChipEnrollPNs(text_filename, bin_filename, 1, masks);
+
+      FreeEnrollPNs(&gen_EP);
+      FreeEnrollPNs(&text_EP);
+      FreeEnrollPNs(&bin_EP);
+      FreeEnrollPNs(&text2_EP);
+
+      if ( num_errors != 0 )
+         num_failed++;
+      printf("File %3d\t%s\tNum PNR %4d\tNum PNF %4d\tNum sams %2d\t%s\n", file_num, TDC_style == 1 ? "TDC  " : "plain", num_PNR,
+         num_PNX - num_PNR, num_sams, num_errors == 0 ? "PASS" : "FAIL");
+      fflush(stdout);
+      }
+
+   unlink(text_filename);
+   unlink(bin_filename);
+   unlink(text2_filename);
+   for ( vec_num = 0; vec_num < RT_NUM_VEC_PAIRS; vec_num++ )
+      free(masks[vec_num]);
+
+   if ( num_failed != 0 )
+      { printf("ERROR: main(): %d round trips FAILED!\n", num_failed); exit(EXIT_FAILURE); }
+   printf("All round trips PASSED\n");
+
+   return 0;
+   }
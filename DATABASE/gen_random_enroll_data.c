@@ -88,6 +88,9 @@ char SampleChipEnrollDatafile[MAX_STRING_LEN];
 char MasterVecFile[MAX_STRING_LEN];
 char MasterMaskFile[MAX_STRING_LEN];
 
+// Vector and VecPair ids, looked up for the first PUFInstance and reused for the rest.
+EnrollIDMapStruct ID_map;
+
 int main(int argc, char *argv[])
    {
    sqlite3 *db = NULL;
@@ -224,6 +227,9 @@ int main(int argc, char *argv[])
 
    printf("Num Qualified RISE PNs %d\tNum Qualified FALL PNs %d\n\n", num_qualified_rise_PNs, num_qualified_fall_PNs); fflush(stdout);
 
+// Report the footprint of the verifier PN cache (float and compact layouts) for the fleet this run produces.
+   PrintTimingValsCacheFootprint("synthetic fleet", num_TVC_arr, num_chips + num_PUFInstances_to_add, NUM_REQUIRED_PNS);
+
 // Free up the cache -- we are done with it after computing the Median values.
    if ( TVC_arr != NULL )
       {
@@ -302,9 +308,13 @@ printf("%d) Median val %f\tRandom val add to FALL Median %2d\tFinal val %f\n", P
 
       printf("New instance index %d\n", instance_index); fflush(stdout);
 
+// The vector and VecPair ids are looked up for the first instance only. Each instance is added in one transaction.
+      SQLBeginTransaction(db);
       ProcessMasterVecsAndTimingData(MAX_STRING_LEN, db, design_index2, instance_index, master_num_vec_pairs, master_num_rise_vec_pairs, master_first_vecs_b, 
-         master_second_vecs_b, PNX, PNX_Tsig, rise_fall, vec_pairs, POs, num_PNR, num_PNX, num_PIs, num_POs);
+         master_second_vecs_b, PNX, PNX_Tsig, rise_fall, vec_pairs, POs, num_PNR, num_PNX, num_PIs, num_POs, &ID_map);
+      SQLCommitTransaction(db);
       }
+   FreeEnrollIDMap(&ID_map);
 
 // If we read the database into memory, and updated it with data then we need to store it back.
    if ( read_db_into_memory == 1 )
@@ -314,6 +324,7 @@ printf("%d) Median val %f\tRandom val add to FALL Median %2d\tFinal val %f\n", P
          { printf("Failed to store 'in memory' database to %s: %s\n", MasterDB_name, sqlite3_errmsg(db)); sqlite3_close(db); exit(EXIT_FAILURE); }
       }
 
+   SQLStmtCacheFinalize(db);
    sqlite3_close(db);
 
    return 0;
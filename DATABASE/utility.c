@@ -14,6 +14,7 @@
 // Functions covered by License and Copyright: All 
 //--------------------------------------------------------------------------------
 
+#include <stdint.h>
 #include "utility.h"
 
 
@@ -226,3 +227,30 @@ printf("\n"); fflush(stdout);
    return;
    }
 
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Print the memory footprint of the TVC for num_chips chips and num_TVC_arr qualified PNs, with the float layout 
+// (one float array per TVC element) and the compact layout (int16_t, contiguous per chip). The PNR/PNF arrays 
+// of num_chlng_PNs floats per chip that are allocated for every challenge are listed separately since both 
+// layouts convert to float on read. NOTE: The sizes are computed from the element counts and the structure 
+// sizes, not measured: malloc overhead and the resident set of the process are not included.
+
+void PrintTimingValsCacheFootprint(char *label, int num_TVC_arr, int num_chips, int num_chlng_PNs)
+   {
+   double keys_MB, float_MB, compact_MB, chlng_MB;
+
+   keys_MB = (double)num_TVC_arr * sizeof(TimingValCacheStruct)/(1024.0*1024.0);
+   float_MB = (double)num_TVC_arr * num_chips * sizeof(float)/(1024.0*1024.0);
+   compact_MB = (double)num_TVC_arr * num_chips * sizeof(int16_t)/(1024.0*1024.0);
+   chlng_MB = ((double)num_chips * num_chlng_PNs * sizeof(float) + 2.0 * num_chips * sizeof(float *))/(1024.0*1024.0);
+
+   printf("TVC footprint %s: %d chips x %d PNs\n", label, num_chips, num_TVC_arr);
+   printf("\tFloat layout:\t%10.2f MB (PNs %.2f MB + elements %.2f MB)\n", float_MB + keys_MB, float_MB, keys_MB);
+   printf("\tCompact layout:\t%10.2f MB (PNs %.2f MB + elements %.2f MB)\t%.1f%% of float\n", compact_MB + keys_MB, compact_MB, keys_MB, 
+      100.0*(compact_MB + keys_MB)/(float_MB + keys_MB));
+   printf("\tPer challenge PNR/PNF (both layouts): %.2f MB\n", chlng_MB);
+   fflush(stdout);
+
+   return;
+   }
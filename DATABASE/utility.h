@@ -46,5 +46,7 @@ float ComputeStdDev(int num_vals, float mean, float *vals);
 int GetBitFromByte(unsigned char byte, int bit_pos);
 void SetBitInByte(unsigned char *byte_ptr, int bit_val, int bit_pos);
 
+void PrintTimingValsCacheFootprint(char *label, int num_TVC_arr, int num_chips, int num_chlng_PNs);
+
 void ConvertBinVecMaskToASCII(int num_PI_POs, unsigned char *vec_mask_bin, char *vec_mask_asc);
 void ConvertASCIIVecMaskToBinary(int num_PI_POs, char *vec_mask_asc, unsigned char *vec_mask_bin);
@@ -0,0 +1,416 @@
+// ========================================================================================================
+// ========================================================================================================
+// ******************************************** bitstring_test.c ******************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+//
+// Randomized differential test of the word-level bitstring routines in utility.c against reference loops built on
+// GetBitFromByte() and SetBitInByte(), the bit-at-a-time code they replaced in JoinBytePackedBitStrings(),
+// EliminatePackedBitsFromBS(), KEK_FSB_SKE() and the nonce compares. Bit positions run from 0 to 127 so every byte
+// and word alignment is hit, lengths cross one or more 64-bit word boundaries, and the data and masks are random,
+// sparse, dense, all 0's and all 1's:
+//
+//    BitStringLoadBits() MUST return the bits in order. BitStringStoreBits(), BitStringCopyBits() (also in place
+//    toward position 0) and BitStringClearBits() MUST change exactly the bits in range.
+//    BitStringExtractWord() and BitStringExtractWordPortable() MUST match a bit-at-a-time PEXT. The portable version
+//    is checked on its own, so its word and run boundaries are covered even in a -mbmi2 build where
+//    BitStringExtractWord() is the PEXT instruction.
+//    BitStringExtractMasked(), BitStringCountMismatches(), BitStringFindFirstMismatch() and BitStringMajorityVote()
+//    (voted bits, minority and reference mismatch counts for every odd XMR) MUST match the reference loops.
+//
+// Usage: bitstring_test [num_trials]
+
+#include "utility.h"
+
+#define TEST_BS_NUM_BYTES 2048
+#define TEST_MAX_BIT_POS 127
+#define TEST_MAX_LEN 320
+#define TEST_MAX_GROUPS 200
+
+#define PATTERN_RANDOM 0
+#define PATTERN_SPARSE 1
+#define PATTERN_DENSE 2
+#define PATTERN_ZEROS 3
+#define PATTERN_ONES 4
+#define NUM_PATTERNS 5
+
+static char *Pattern_names[] = { "random", "sparse", "dense", "zeros", "ones" };
+static unsigned long long Test_rng_state = 0x9E3779B97F4A7C15ULL;
+
+
+// ========================================================================================================
+// ========================================================================================================
+// xorshift64 for the test data.
+
+static uint64_t TestRand64()
+   {
+   Test_rng_state ^= Test_rng_state >> 12;
+   Test_rng_state ^= Test_rng_state << 25;
+   Test_rng_state ^= Test_rng_state >> 27;
+   return (uint64_t)(Test_rng_state * 0x2545F4914F6CDD1DULL);
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Random integer from 0 to max_val.
+
+static int TestRandInt(int max_val)
+   { return (int)((TestRand64() >> 33) % (uint64_t)(max_val + 1)); }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// A 64-bit word in one of the patterns.
+
+static uint64_t TestGenWord(int pattern)
+   {
+   if ( pattern == PATTERN_SPARSE )
+      return TestRand64() & TestRand64() & TestRand64();
+   if ( pattern == PATTERN_DENSE )
+      return TestRand64() | TestRand64() | TestRand64();
+   if ( pattern == PATTERN_ZEROS )
+      return 0;
+   if ( pattern == PATTERN_ONES )
+      return ~(uint64_t)0;
+   return TestRand64();
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Fill 'num_bytes' bytes of a bitstring with one of the patterns.
+
+static void TestGenBitstring(int pattern, unsigned char *bs, int num_bytes)
+   {
+   uint64_t word = 0;
+   int byte_num;
+
+   for ( byte_num = 0; byte_num < num_bytes; byte_num++ )
+      {
+      if ( (byte_num % 8) == 0 )
+         word = TestGenWord(pattern);
+      bs[byte_num] = (unsigned char)(word >> (8*(byte_num % 8)));
+      }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Reference bit-at-a-time PEXT.
+
+static uint64_t RefExtractWord(uint64_t word, uint64_t mask)
+   {
+   uint64_t result = 0;
+   int bit_num, out_pos = 0;
+
+   for ( bit_num = 0; bit_num < 64; bit_num++ )
+      if ( (mask >> bit_num) & 1 )
+         result |= ((word >> bit_num) & 1) << out_pos++;
+
+   return result;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Load, store, copy (separate and in place) and clear at random positions and lengths. Returns the number of
+// mismatches.
+
+static int TestMoveBits(int pattern)
+   {
+   unsigned char src[TEST_BS_NUM_BYTES/8], dest[TEST_BS_NUM_BYTES/8], ref[TEST_BS_NUM_BYTES/8];
+   int bit_pos, src_bit_pos, num_bits, i, num_errors;
+   uint64_t word, ref_word;
+
+   num_errors = 0;
+   TestGenBitstring(pattern, src, sizeof(src));
+   TestGenBitstring(PATTERN_RANDOM, dest, sizeof(dest));
+
+// Load.
+   bit_pos = TestRandInt(TEST_MAX_BIT_POS);
+   num_bits = 1 + TestRandInt(63);
+   ref_word = 0;
+   for ( i = 0; i < num_bits; i++ )
+      ref_word |= (uint64_t)GetBitFromByte(src[(bit_pos + i)/8], (bit_pos + i) % 8) << i;
+   if ( (word = BitStringLoadBits(src, bit_pos, num_bits)) != ref_word )
+      {
+      printf("\t%s: BitStringLoadBits() pos %d bits %d returned %016llx -- expected %016llx\n", Pattern_names[pattern], bit_pos,
+         num_bits, (unsigned long long)word, (unsigned long long)ref_word);
+      num_errors++;
+      }
+
+// Store.
+   bit_pos = TestRandInt(TEST_MAX_BIT_POS);
+   num_bits = 1 + TestRandInt(63);
+   word = TestGenWord(pattern);
+   memcpy(ref, dest, sizeof(dest));
+   for ( i = 0; i < num_bits; i++ )
+      SetBitInByte(&(ref[(bit_pos + i)/8]), (int)((word >> i) & 1), (bit_pos + i) % 8);
+   BitStringStoreBits(dest, bit_pos, num_bits, word);
+   if ( memcmp(dest, ref, sizeof(dest)) != 0 )
+      {
+      printf("\t%s: BitStringStoreBits() pos %d bits %d changed the wrong bits\n", Pattern_names[pattern], bit_pos, num_bits);
+      num_errors++;
+      }
+
+// Copy between bitstrings.
+   bit_pos = TestRandInt(TEST_MAX_BIT_POS);
+   src_bit_pos = TestRandInt(TEST_MAX_BIT_POS);
+   num_bits = TestRandInt(TEST_MAX_LEN);
+   memcpy(ref, dest, sizeof(dest));
+   for ( i = 0; i < num_bits; i++ )
+      SetBitInByte(&(ref[(bit_pos + i)/8]), GetBitFromByte(src[(src_bit_pos + i)/8], (src_bit_pos + i) % 8), (bit_pos + i) % 8);
+   BitStringCopyBits(dest, bit_pos, src, src_bit_pos, num_bits);
+   if ( memcmp(dest, ref, sizeof(dest)) != 0 )
+      {
+      printf("\t%s: BitStringCopyBits() dest %d src %d bits %d does not match\n", Pattern_names[pattern], bit_pos, src_bit_pos, num_bits);
+      num_errors++;
+      }
+
+// Copy in place toward position 0, as EliminatePackedBitsFromBS() does.
+   src_bit_pos = TestRandInt(TEST_MAX_BIT_POS);
+   bit_pos = TestRandInt(src_bit_pos);
+   num_bits = TestRandInt(TEST_MAX_LEN);
+   memcpy(ref, dest, sizeof(dest));
+   for ( i = 0; i < num_bits; i++ )
+      SetBitInByte(&(ref[(bit_pos + i)/8]), GetBitFromByte(ref[(src_bit_pos + i)/8], (src_bit_pos + i) % 8), (bit_pos + i) % 8);
+   BitStringCopyBits(dest, bit_pos, dest, src_bit_pos, num_bits);
+   if ( memcmp(dest, ref, sizeof(dest)) != 0 )
+      {
+      printf("\t%s: BitStringCopyBits() in place dest %d src %d bits %d does not match\n", Pattern_names[pattern], bit_pos,
+         src_bit_pos, num_bits);
+      num_errors++;
+      }
+
+// Clear.
+   memcpy(dest, src, sizeof(src));
+   bit_pos = TestRandInt(TEST_MAX_BIT_POS);
+   num_bits = TestRandInt(TEST_MAX_LEN);
+   memcpy(ref, dest, sizeof(dest));
+   for ( i = 0; i < num_bits; i++ )
+      SetBitInByte(&(ref[(bit_pos + i)/8]), 0, (bit_pos + i) % 8);
+   BitStringClearBits(dest, bit_pos, num_bits);
+   if ( memcmp(dest, ref, sizeof(dest)) != 0 )
+      {
+      printf("\t%s: BitStringClearBits() pos %d bits %d does not match\n", Pattern_names[pattern], bit_pos, num_bits);
+      num_errors++;
+      }
+
+   return num_errors;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Word extract (PEXT or portable, and always the portable version) and the masked compaction. Returns the number
+// of mismatches.
+
+static int TestExtract(int pattern)
+   {
+   unsigned char src[TEST_BS_NUM_BYTES/8], mask_bs[TEST_BS_NUM_BYTES/8], dest[TEST_BS_NUM_BYTES/8], ref[TEST_BS_NUM_BYTES/8];
+   int num_bits, dest_bit_pos, num_extracted, ref_num_extracted, bit_num, num_errors;
+   uint64_t word, mask, ref_word;
+
+   num_errors = 0;
+
+// The mask takes the pattern so the all 0's, all 1's and run boundaries of the portable version are hit.
+   word = TestRand64();
+   mask = TestGenWord(pattern);
+   ref_word = RefExtractWord(word, mask);
+   if ( BitStringExtractWord(word, mask) != ref_word || BitStringExtractWordPortable(word, mask) != ref_word )
+      {
+      printf("\t%s: BitStringExtractWord() %016llx or BitStringExtractWordPortable() %016llx of %016llx mask %016llx -- expected %016llx\n",
+         Pattern_names[pattern], (unsigned long long)BitStringExtractWord(word, mask),
+         (unsigned long long)BitStringExtractWordPortable(word, mask), (unsigned long long)word, (unsigned long long)mask,
+         (unsigned long long)ref_word);
+      num_errors++;
+      }
+
+   TestGenBitstring(PATTERN_RANDOM, src, sizeof(src));
+   TestGenBitstring(pattern, mask_bs, sizeof(mask_bs));
+   TestGenBitstring(PATTERN_RANDOM, dest, sizeof(dest));
+   memcpy(ref, dest, sizeof(dest));
+
+   num_bits = 1 + TestRandInt(TEST_MAX_LEN);
+   dest_bit_pos = TestRandInt(TEST_MAX_BIT_POS);
+   ref_num_extracted = 0;
+   for ( bit_num = 0; bit_num < num_bits; bit_num++ )
+      if ( GetBitFromByte(mask_bs[bit_num/8], bit_num % 8) == 1 )
+         {
+         SetBitInByte(&(ref[(dest_bit_pos + ref_num_extracted)/8]), GetBitFromByte(src[bit_num/8], bit_num % 8),
+            (dest_bit_pos + ref_num_extracted) % 8);
+         ref_num_extracted++;
+         }
+   num_extracted = BitStringExtractMasked(num_bits, src, mask_bs, dest, dest_bit_pos);
+   if ( num_extracted != ref_num_extracted || memcmp(dest, ref, sizeof(dest)) != 0 )
+      {
+      printf("\t%s: BitStringExtractMasked() bits %d dest pos %d extracted %d -- expected %d (or the bits do not match)\n",
+         Pattern_names[pattern], num_bits, dest_bit_pos, num_extracted, ref_num_extracted);
+      num_errors++;
+      }
+
+   return num_errors;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Mismatch count and first mismatch. bs2 is bs1 with the pattern XOR'ed in (no flips for all 0's, every bit for
+// all 1's) plus, half the time, a single flipped bit near the end of the range. Returns the number of mismatches.
+
+static int TestCompare(int pattern)
+   {
+   unsigned char bs1[TEST_BS_NUM_BYTES/8], bs2[TEST_BS_NUM_BYTES/8], flips[TEST_BS_NUM_BYTES/8];
+   int bit_pos1, bit_pos2, num_bits, bit_num, num_mismatches, ref_num_mismatches, first_mismatch, ref_first_mismatch;
+   int num_errors, flip_bit, i;
+
+   num_errors = 0;
+   TestGenBitstring(PATTERN_RANDOM, bs1, sizeof(bs1));
+   TestGenBitstring(pattern, flips, sizeof(flips));
+   bit_pos1 = TestRandInt(TEST_MAX_BIT_POS);
+   bit_pos2 = TestRandInt(TEST_MAX_BIT_POS);
+   num_bits = TestRandInt(TEST_MAX_LEN);
+
+   memset(bs2, 0, sizeof(bs2));
+   for ( i = 0; i < num_bits; i++ )
+      SetBitInByte(&(bs2[(bit_pos2 + i)/8]), GetBitFromByte(bs1[(bit_pos1 + i)/8], (bit_pos1 + i) % 8) ^
+         GetBitFromByte(flips[i/8], i % 8), (bit_pos2 + i) % 8);
+   if ( num_bits > 0 && TestRandInt(1) == 1 )
+      {
+      flip_bit = bit_pos2 + num_bits - 1 - TestRandInt(num_bits < 70 ? num_bits - 1 : 69);
+      SetBitInByte(&(bs2[flip_bit/8]), 1 - GetBitFromByte(bs2[flip_bit/8], flip_bit % 8), flip_bit % 8);
+      }
+
+   ref_num_mismatches = 0;
+   ref_first_mismatch = -1;
+   for ( bit_num = 0; bit_num < num_bits; bit_num++ )
+      if ( GetBitFromByte(bs1[(bit_pos1 + bit_num)/8], (bit_pos1 + bit_num) % 8) !=
+         GetBitFromByte(bs2[(bit_pos2 + bit_num)/8], (bit_pos2 + bit_num) % 8) )
+         {
+         if ( ref_first_mismatch == -1 )
+            ref_first_mismatch = bit_num;
+         ref_num_mismatches++;
+         }
+
+   num_mismatches = BitStringCountMismatches(bs1, bit_pos1, bs2, bit_pos2, num_bits);
+   first_mismatch = BitStringFindFirstMismatch(bs1, bit_pos1, bs2, bit_pos2, num_bits);
+   if ( num_mismatches != ref_num_mismatches || first_mismatch != ref_first_mismatch )
+      {
+      printf("\t%s: pos %d and %d bits %d: BitStringCountMismatches() %d BitStringFindFirstMismatch() %d -- expected %d and %d\n",
+         Pattern_names[pattern], bit_pos1, bit_pos2, num_bits, num_mismatches, first_mismatch, ref_num_mismatches, ref_first_mismatch);
+      num_errors++;
+      }
+
+   return num_errors;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Majority vote of 'num_groups' groups of XMR copies with the minority and reference mismatch counts, against the
+// per-group loop KEK_FSB_SKE() used. Returns the number of mismatches.
+
+static int TestMajorityVote(int pattern, int XMR)
+   {
+   unsigned char copies[TEST_BS_NUM_BYTES], voted[TEST_BS_NUM_BYTES/8], ref_voted[TEST_BS_NUM_BYTES/8], ref_bs[TEST_BS_NUM_BYTES/8];
+   int num_groups, voted_bit_pos, ref_bit_pos, group_num, copy_num, num_ones, bit_num, ref_bit, voted_bit;
+   int num_minority, ref_num_minority, num_ref_mismatches, ref_num_ref_mismatches;
+
+   num_groups = 1 + TestRandInt(TEST_MAX_GROUPS - 1);
+   voted_bit_pos = TestRandInt(TEST_MAX_BIT_POS);
+   ref_bit_pos = TestRandInt(TEST_MAX_BIT_POS);
+   TestGenBitstring(pattern, copies, (num_groups*XMR + 7)/8);
+   TestGenBitstring(PATTERN_RANDOM, voted, sizeof(voted));
+   TestGenBitstring(PATTERN_RANDOM, ref_bs, sizeof(ref_bs));
+   memcpy(ref_voted, voted, sizeof(voted));
+
+   ref_num_minority = 0;
+   ref_num_ref_mismatches = 0;
+   for ( group_num = 0; group_num < num_groups; group_num++ )
+      {
+      num_ones = 0;
+      for ( copy_num = 0; copy_num < XMR; copy_num++ )
+         {
+         bit_num = group_num*XMR + copy_num;
+         num_ones += GetBitFromByte(copies[bit_num/8], bit_num % 8);
+         }
+      voted_bit = (num_ones > XMR/2);
+      SetBitInByte(&(ref_voted[(voted_bit_pos + group_num)/8]), voted_bit, (voted_bit_pos + group_num) % 8);
+      ref_num_minority += (voted_bit == 1) ? XMR - num_ones : num_ones;
+      ref_bit = GetBitFromByte(ref_bs[(ref_bit_pos + group_num)/8], (ref_bit_pos + group_num) % 8);
+      ref_num_ref_mismatches += (ref_bit == 1) ? XMR - num_ones : num_ones;
+      }
+
+// The counts are added to, so start them off non-zero.
+   num_minority = 7;
+   num_ref_mismatches = 11;
+   BitStringMajorityVote(XMR, num_groups, copies, voted, voted_bit_pos, &num_minority, ref_bs, ref_bit_pos, &num_ref_mismatches);
+   if ( memcmp(voted, ref_voted, sizeof(voted)) != 0 || num_minority - 7 != ref_num_minority ||
+      num_ref_mismatches - 11 != ref_num_ref_mismatches )
+      {
+      printf("\t%s: BitStringMajorityVote() XMR %d groups %d pos %d: minority %d ref mismatches %d -- expected %d and %d (or the votes differ)\n",
+         Pattern_names[pattern], XMR, num_groups, voted_bit_pos, num_minority - 7, num_ref_mismatches - 11, ref_num_minority,
+         ref_num_ref_mismatches);
+      return 1;
+      }
+
+   return 0;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+
+int main(int argc, char *argv[])
+   {
+   int num_trials;
+
+   int pattern, trial_num, XMR, num_errors, num_failed;
+
+   num_trials = 2000;
+   if ( argc > 1 )
+      num_trials = atoi(argv[1]);
+   if ( num_trials <= 0 )
+      { printf("ERROR: main(): Number of trials MUST be positive!\n"); exit(EXIT_FAILURE); }
+
+#if defined(__BMI2__) && defined(__x86_64__)
+   printf("BitStringExtractWord(): BMI2 PEXT (the portable version is checked separately)\n");
+#else
+   printf("BitStringExtractWord(): portable\n");
+#endif
+
+   num_failed = 0;
+   for ( pattern = 0; pattern < NUM_PATTERNS; pattern++ )
+      {
+      num_errors = 0;
+      for ( trial_num = 0; trial_num < num_trials; trial_num++ )
+         {
+         num_errors += TestMoveBits(pattern);
+         num_errors += TestExtract(pattern);
+         num_errors += TestCompare(pattern);
+         }
+      for ( XMR = 1; XMR <= BITSTRING_MAX_XMR; XMR += 2 )
+         for ( trial_num = 0; trial_num < num_trials/20 + 1; trial_num++ )
+            num_errors += TestMajorityVote(pattern, XMR);
+      if ( num_errors != 0 )
+         num_failed++;
+      printf("Pattern %-8s\t%d trials\t%s\n", Pattern_names[pattern], num_trials, num_errors == 0 ? "PASS" : "FAIL");
+      fflush(stdout);
+      }
+
+   if ( num_failed != 0 )
+      { printf("ERROR: main(): %d tests FAILED!\n", num_failed); exit(EXIT_FAILURE); }
+   printf("All tests PASSED\n");
+
+   return 0;
+   }
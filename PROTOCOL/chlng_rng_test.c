@@ -0,0 +1,117 @@
+// ========================================================================================================
+// ========================================================================================================
+// ******************************************* chlng_rng_test.c *******************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+//
+// Compatibility test of the reentrant challenge generator in commonDB.c. Deployed devices select challenges
+// with srand(Seed)/rand(), so in CHLNG_RNG_GLIBC_COMPAT mode ChallengeRNGSeed()/ChallengeRNGNext() MUST return
+// exactly the sequence of the C library. For each seed (0, 1, small, large and random ones), 'num_draws' values
+// are compared with rand(). The xoshiro mode is checked to stay in 0 to RAND_MAX and to be reproducible.
+//
+// Usage: chlng_rng_test [num_draws]
+
+#include "commonDB.h"
+
+static unsigned int Test_seeds[] = { 0, 1, 2, 42, 12345, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF };
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Compare 'num_draws' values of the generator in glibc mode with rand() for one seed. Returns the index of
+// the first mismatch or -1.
+
+static int TestGlibcSeed(unsigned int Seed, int num_draws)
+   {
+   ChallengeRNGStruct RNG;
+   int draw_num, expected, got;
+
+   srand(Seed);
+   ChallengeRNGSeed(&RNG, CHLNG_RNG_GLIBC_COMPAT, Seed);
+   for ( draw_num = 0; draw_num < num_draws; draw_num++ )
+      {
+      expected = rand();
+      got = ChallengeRNGNext(&RNG);
+      if ( got != expected )
+         {
+         printf("\tSeed %u: draw %d: ChallengeRNGNext() %d -- rand() %d!\n", Seed, draw_num, got, expected);
+         return draw_num;
+         }
+      }
+
+   return -1;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Two generators in xoshiro mode seeded alike MUST agree and every value MUST be in range. Returns the number
+// of errors.
+
+static int TestXoshiroSeed(unsigned int Seed, int num_draws)
+   {
+   ChallengeRNGStruct RNG_A, RNG_B;
+   int draw_num, val_A, val_B;
+
+   ChallengeRNGSeed(&RNG_A, CHLNG_RNG_XOSHIRO, Seed);
+   ChallengeRNGSeed(&RNG_B, CHLNG_RNG_XOSHIRO, Seed);
+   for ( draw_num = 0; draw_num < num_draws; draw_num++ )
+      {
+      val_A = ChallengeRNGNext(&RNG_A);
+      val_B = ChallengeRNGNext(&RNG_B);
+      if ( val_A != val_B || val_A < 0 || val_A > RAND_MAX )
+         {
+         printf("\tSeed %u: draw %d: xoshiro values %d and %d!\n", Seed, draw_num, val_A, val_B);
+         return 1;
+         }
+      }
+
+   return 0;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+
+int main(int argc, char *argv[])
+   {
+   int num_draws, num_failed;
+
+   int num_fixed_seeds = sizeof(Test_seeds)/sizeof(unsigned int);
+   int num_random_seeds = 8;
+   int seed_num, seed_failed;
+   unsigned int Seed;
+
+   num_draws = 1000000;
+   if ( argc > 1 )
+      num_draws = atoi(argv[1]);
+   if ( num_draws <= 0 )
+      { printf("ERROR: main(): Number of draws must be positive!\n"); exit(EXIT_FAILURE); }
+
+   num_failed = 0;
+   for ( seed_num = 0; seed_num < num_fixed_seeds + num_random_seeds; seed_num++ )
+      {
+      if ( seed_num < num_fixed_seeds )
+         Seed = Test_seeds[seed_num];
+      else
+         Seed = ((unsigned int)time(NULL) + (unsigned int)seed_num) * 2654435761U;
+
+      seed_failed = TestGlibcSeed(Seed, num_draws) != -1 || TestXoshiroSeed(Seed, num_draws) != 0;
+      num_failed += seed_failed;
+      printf("Seed %10u\t%d draws\t%s\n", Seed, num_draws, seed_failed == 0 ? "PASS" : "FAIL");
+      fflush(stdout);
+      }
+
+   if ( num_failed != 0 )
+      { printf("ERROR: main(): %d seeds FAILED!\n", num_failed); exit(EXIT_FAILURE); }
+   printf("All seeds PASSED\n");
+
+   return 0;
+   }
@@ -702,6 +702,390 @@ printf("Connected host IP %s has sent another message!\n" , client_IP); fflush(s
    }
 
 
+// ========================================================================================================
+// ========================================================================================================
+// Open the listen socket of the epoll connection server. The listen socket is non-blocking and registered 
+// edge-triggered. 'max_connections' caps the number of connections that are open at the same time (accepted 
+// but not yet released by a thread). Connections beyond the cap wait in the kernel listen queue.
+
+void EpollServerOpen(EpollServerStruct *ES_ptr, char *server_IP, int port_number, int max_connections)
+   {
+   struct epoll_event event;
+   struct sockaddr_in address;
+   int opt = TRUE;
+
+   ES_ptr->max_connections = max_connections;
+   ES_ptr->num_connections = 0;
+   ES_ptr->accept_pending = 0;
+   ES_ptr->ready_head = 0;
+   ES_ptr->ready_count = 0;
+   if ( (ES_ptr->client_sockets = (int *)calloc(max_connections, sizeof(int))) == NULL || 
+      (ES_ptr->ready_slots = (int *)calloc(max_connections, sizeof(int))) == NULL )
+      { printf("ERROR: EpollServerOpen(): Failed to allocate storage for %d connections!\n", max_connections); exit(EXIT_FAILURE); }
+   pthread_mutex_init(&(ES_ptr->mutex), NULL);
+
+   if ( (ES_ptr->master_socket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0)) < 0 )
+      { perror("EpollServerOpen(): socket failed"); exit(EXIT_FAILURE); }
+   if ( setsockopt(ES_ptr->master_socket, SOL_SOCKET, SO_REUSEADDR, (char *)&opt, sizeof(opt)) < 0 )
+      { perror("EpollServerOpen(): setsockopt"); exit(EXIT_FAILURE); }
+
+   memset(&address, 0, sizeof(address));
+   address.sin_family = AF_INET;
+   address.sin_addr.s_addr = inet_addr(server_IP);
+   address.sin_port = htons(port_number);
+   if ( bind(ES_ptr->master_socket, (struct sockaddr *)&address, sizeof(address)) < 0 )
+      { perror("EpollServerOpen(): bind failed"); exit(EXIT_FAILURE); }
+
+// The kernel silently caps the backlog at net.core.somaxconn.
+   if ( listen(ES_ptr->master_socket, max_connections) < 0 )
+      { perror("EpollServerOpen(): listen"); exit(EXIT_FAILURE); }
+
+// The eventfd is written by EpollServerReleaseSlot() so a server blocked at the connection cap wakes up.
+   if ( (ES_ptr->epoll_fd = epoll_create1(0)) < 0 )
+      { perror("EpollServerOpen(): epoll_create1"); exit(EXIT_FAILURE); }
+   if ( (ES_ptr->slot_event_fd = eventfd(0, EFD_NONBLOCK)) < 0 )
+      { perror("EpollServerOpen(): eventfd"); exit(EXIT_FAILURE); }
+
+// The event data is the slot number. The listen socket and the eventfd use max_connections and max_connections + 1.
+   event.events = EPOLLIN | EPOLLET;
+   event.data.u32 = max_connections;
+   if ( epoll_ctl(ES_ptr->epoll_fd, EPOLL_CTL_ADD, ES_ptr->master_socket, &event) < 0 )
+      { perror("EpollServerOpen(): epoll_ctl listen socket"); exit(EXIT_FAILURE); }
+   event.events = EPOLLIN | EPOLLET;
+   event.data.u32 = max_connections + 1;
+   if ( epoll_ctl(ES_ptr->epoll_fd, EPOLL_CTL_ADD, ES_ptr->slot_event_fd, &event) < 0 )
+      { perror("EpollServerOpen(): epoll_ctl eventfd"); exit(EXIT_FAILURE); }
+
+   printf("EpollServerOpen(): Listener on port %d\tMax connections %d\n", port_number, max_connections); fflush(stdout);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Block (without a timeout) until a socket is ready to be handed to a thread, i.e., a new connection or a 
+// re-armed connection with data to read. Returns the socket descriptor, its slot in client_index_ptr and the 
+// peer IP in client_IP. Only the main thread calls this routine.
+
+int EpollServerWait(EpollServerStruct *ES_ptr, char *client_IP, int *client_index_ptr)
+   {
+   struct epoll_event events[EPOLL_SERVER_MAX_EVENTS];
+   struct sockaddr_in address;
+   socklen_t addrlen;
+   uint64_t num_released;
+   int num_events, event_num, slot, new_socket, at_cap;
+
+   while ( ES_ptr->ready_count == 0 )
+      {
+
+// Drain the listen queue. With edge-triggered notification we MUST accept until EAGAIN, unless the connection cap is 
+// reached. In that case, accepting continues after a thread releases a slot.
+      while ( ES_ptr->accept_pending == 1 )
+         {
+         pthread_mutex_lock(&(ES_ptr->mutex));
+         at_cap = (ES_ptr->num_connections >= ES_ptr->max_connections);
+         pthread_mutex_unlock(&(ES_ptr->mutex));
+         if ( at_cap == 1 )
+            break;
+
+// Accepted sockets do NOT inherit O_NONBLOCK from the listen socket, which is what the threads expect.
+         addrlen = sizeof(address);
+         if ( (new_socket = accept(ES_ptr->master_socket, (struct sockaddr *)&address, &addrlen)) < 0 )
+            {
+            if ( errno == EAGAIN || errno == EWOULDBLOCK )
+               ES_ptr->accept_pending = 0;
+            else if ( errno != EINTR && errno != ECONNABORTED )
+               { perror("EpollServerWait(): accept"); exit(EXIT_FAILURE); }
+            continue;
+            }
+
+         pthread_mutex_lock(&(ES_ptr->mutex));
+         for ( slot = 0; slot < ES_ptr->max_connections; slot++ )
+            if ( ES_ptr->client_sockets[slot] == 0 )
+               break;
+         ES_ptr->client_sockets[slot] = new_socket;
+         ES_ptr->num_connections++;
+         pthread_mutex_unlock(&(ES_ptr->mutex));
+
+         ES_ptr->ready_slots[(ES_ptr->ready_head + ES_ptr->ready_count) % ES_ptr->max_connections] = slot;
+         ES_ptr->ready_count++;
+         }
+      if ( ES_ptr->ready_count > 0 )
+         break;
+
+      if ( (num_events = epoll_wait(ES_ptr->epoll_fd, events, EPOLL_SERVER_MAX_EVENTS, -1)) < 0 )
+         {
+         if ( errno == EINTR )
+            continue;
+         perror("EpollServerWait(): epoll_wait"); exit(EXIT_FAILURE);
+         }
+
+      for ( event_num = 0; event_num < num_events; event_num++ )
+         {
+         slot = (int)events[event_num].data.u32;
+         if ( slot == ES_ptr->max_connections )
+            ES_ptr->accept_pending = 1;
+         else if ( slot == ES_ptr->max_connections + 1 )
+            {
+            if ( read(ES_ptr->slot_event_fd, &num_released, sizeof(num_released)) < 0 && errno != EAGAIN )
+               { perror("EpollServerWait(): read eventfd"); exit(EXIT_FAILURE); }
+            }
+         else
+            {
+            ES_ptr->ready_slots[(ES_ptr->ready_head + ES_ptr->ready_count) % ES_ptr->max_connections] = slot;
+            ES_ptr->ready_count++;
+            }
+         }
+      }
+
+   slot = ES_ptr->ready_slots[ES_ptr->ready_head];
+   ES_ptr->ready_head = (ES_ptr->ready_head + 1) % ES_ptr->max_connections;
+   ES_ptr->ready_count--;
+
+   pthread_mutex_lock(&(ES_ptr->mutex));
+   new_socket = ES_ptr->client_sockets[slot];
+   pthread_mutex_unlock(&(ES_ptr->mutex));
+
+   addrlen = sizeof(address);
+   if ( getpeername(new_socket, (struct sockaddr *)&address, &addrlen) == 0 )
+      inet_ntop(AF_INET, &(address.sin_addr), client_IP, INET_ADDRSTRLEN);
+   else
+      strcpy(client_IP, "0.0.0.0");
+
+#ifdef DEBUG
+printf("EpollServerWait(): Socket %d from IP %s is ready in slot %d\tOpen connections %d\n", new_socket, client_IP, slot, 
+   ES_ptr->num_connections); fflush(stdout);
+#endif
+
+   *client_index_ptr = slot;
+   return new_socket;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Called by a thread once it has closed the socket in 'client_index'. Frees the slot and wakes up the server
+// in case it is blocked at the connection cap.
+
+void EpollServerReleaseSlot(EpollServerStruct *ES_ptr, int client_index)
+   {
+   uint64_t one = 1;
+
+   pthread_mutex_lock(&(ES_ptr->mutex));
+   ES_ptr->client_sockets[client_index] = 0;
+   ES_ptr->num_connections--;
+   pthread_mutex_unlock(&(ES_ptr->mutex));
+
+   if ( write(ES_ptr->slot_event_fd, &one, sizeof(one)) != sizeof(one) )
+      { perror("EpollServerReleaseSlot(): write eventfd"); exit(EXIT_FAILURE); }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Called by a thread that keeps its connection open (TTPs). The socket is watched (one-shot) for the next 
+// message, which makes the slot ready in EpollServerWait() again.
+
+void EpollServerRearmSlot(EpollServerStruct *ES_ptr, int client_index, int socket_desc)
+   {
+   struct epoll_event event;
+
+   pthread_mutex_lock(&(ES_ptr->mutex));
+   ES_ptr->client_sockets[client_index] = socket_desc;
+   pthread_mutex_unlock(&(ES_ptr->mutex));
+
+   event.events = EPOLLIN | EPOLLONESHOT;
+   event.data.u32 = client_index;
+   if ( epoll_ctl(ES_ptr->epoll_fd, EPOLL_CTL_MOD, socket_desc, &event) < 0 )
+      {
+      if ( errno != ENOENT || epoll_ctl(ES_ptr->epoll_fd, EPOLL_CTL_ADD, socket_desc, &event) < 0 )
+         { perror("EpollServerRearmSlot(): epoll_ctl"); exit(EXIT_FAILURE); }
+      }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Initialize a bounded work queue that holds up to 'capacity' items.
+
+void WorkQueueInit(WorkQueueStruct *WQ_ptr, int capacity)
+   {
+   if ( capacity <= 0 )
+      { printf("ERROR: WorkQueueInit(): Capacity %d MUST be positive!\n", capacity); exit(EXIT_FAILURE); }
+   if ( (WQ_ptr->items = (WorkItemStruct *)calloc(capacity, sizeof(WorkItemStruct))) == NULL )
+      { printf("ERROR: WorkQueueInit(): Failed to allocate storage for %d items!\n", capacity); exit(EXIT_FAILURE); }
+
+   WQ_ptr->capacity = capacity;
+   WQ_ptr->head = 0;
+   WQ_ptr->count = 0;
+   WQ_ptr->closed = 0;
+   pthread_mutex_init(&(WQ_ptr->mutex), NULL);
+   pthread_cond_init(&(WQ_ptr->not_empty), NULL);
+   pthread_cond_init(&(WQ_ptr->not_full), NULL);
+
+   WQ_ptr->num_pushed = 0;
+   WQ_ptr->num_popped = 0;
+   WQ_ptr->interval_start_popped = 0;
+   WQ_ptr->num_push_blocked = 0;
+   WQ_ptr->max_depth = 0;
+   WQ_ptr->tot_wait_us = 0.0;
+   WQ_ptr->max_wait_us = 0.0;
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Add an item to the tail of the queue. Blocks while the queue is full. The enqueue time is recorded for 
+// the wait time metrics. Pushing to a closed queue is an error.
+
+void WorkQueuePush(WorkQueueStruct *WQ_ptr, WorkItemStruct *item_ptr)
+   {
+   pthread_mutex_lock(&(WQ_ptr->mutex));
+   if ( WQ_ptr->count == WQ_ptr->capacity )
+      WQ_ptr->num_push_blocked++;
+   while ( WQ_ptr->count == WQ_ptr->capacity && WQ_ptr->closed == 0 )
+      pthread_cond_wait(&(WQ_ptr->not_full), &(WQ_ptr->mutex));
+   if ( WQ_ptr->closed == 1 )
+      { printf("ERROR: WorkQueuePush(): The queue is closed!\n"); exit(EXIT_FAILURE); }
+
+   gettimeofday(&(item_ptr->enqueue_time), NULL);
+   WQ_ptr->items[(WQ_ptr->head + WQ_ptr->count) % WQ_ptr->capacity] = *item_ptr;
+   WQ_ptr->count++;
+   WQ_ptr->num_pushed++;
+   if ( WQ_ptr->count > WQ_ptr->max_depth )
+      WQ_ptr->max_depth = WQ_ptr->count;
+
+   pthread_cond_signal(&(WQ_ptr->not_empty));
+   pthread_mutex_unlock(&(WQ_ptr->mutex));
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Remove the item at the head of the queue. Blocks while the queue is empty, for at most 'timeout_ms' 
+// milliseconds if 'timeout_ms' is positive. Returns 1 if an item was removed, 0 on a timeout and -1 once the
+// queue is closed and empty.
+
+int WorkQueuePop(WorkQueueStruct *WQ_ptr, WorkItemStruct *item_ptr, int timeout_ms)
+   {
+   struct timespec deadline;
+   struct timeval now;
+   double wait_us;
+
+   if ( timeout_ms > 0 )
+      {
+      gettimeofday(&now, NULL);
+      deadline.tv_sec = now.tv_sec + timeout_ms/1000;
+      deadline.tv_nsec = (long)now.tv_usec*1000 + (long)(timeout_ms % 1000) * 1000000;
+      if ( deadline.tv_nsec >= 1000000000 )
+         { deadline.tv_sec++; deadline.tv_nsec -= 1000000000; }
+      }
+
+   pthread_mutex_lock(&(WQ_ptr->mutex));
+   while ( WQ_ptr->count == 0 )
+      {
+      if ( WQ_ptr->closed == 1 )
+         { pthread_mutex_unlock(&(WQ_ptr->mutex)); return -1; }
+      if ( timeout_ms > 0 )
+         {
+         if ( pthread_cond_timedwait(&(WQ_ptr->not_empty), &(WQ_ptr->mutex), &deadline) == ETIMEDOUT && WQ_ptr->count == 0 )
+            { pthread_mutex_unlock(&(WQ_ptr->mutex)); return 0; }
+         }
+      else
+         pthread_cond_wait(&(WQ_ptr->not_empty), &(WQ_ptr->mutex));
+      }
+
+   *item_ptr = WQ_ptr->items[WQ_ptr->head];
+   WQ_ptr->head = (WQ_ptr->head + 1) % WQ_ptr->capacity;
+   WQ_ptr->count--;
+   WQ_ptr->num_popped++;
+
+   gettimeofday(&now, NULL);
+   wait_us = (double)(now.tv_sec - item_ptr->enqueue_time.tv_sec)*1000000.0 + (double)(now.tv_usec - item_ptr->enqueue_time.tv_usec);
+   WQ_ptr->tot_wait_us += wait_us;
+   if ( wait_us > WQ_ptr->max_wait_us )
+      WQ_ptr->max_wait_us = wait_us;
+
+   pthread_cond_signal(&(WQ_ptr->not_full));
+   pthread_mutex_unlock(&(WQ_ptr->mutex));
+
+   return 1;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Refuse further pushes and wake up every waiting thread. The consumers still pop the items already queued and 
+// then get -1 from WorkQueuePop().
+
+void WorkQueueClose(WorkQueueStruct *WQ_ptr)
+   {
+   pthread_mutex_lock(&(WQ_ptr->mutex));
+   WQ_ptr->closed = 1;
+   pthread_cond_broadcast(&(WQ_ptr->not_empty));
+   pthread_cond_broadcast(&(WQ_ptr->not_full));
+   pthread_mutex_unlock(&(WQ_ptr->mutex));
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Current number of items in the queue.
+
+int WorkQueueDepth(WorkQueueStruct *WQ_ptr)
+   {
+   int depth;
+
+   pthread_mutex_lock(&(WQ_ptr->mutex));
+   depth = WQ_ptr->count;
+   pthread_mutex_unlock(&(WQ_ptr->mutex));
+
+   return depth;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Snapshot of the queue metrics. The wait time is the time an item spent in the queue. With 'reset' set to 1, 
+// the max depth, max wait and the wait sum are restarted, so each call reports a separate interval.
+
+void WorkQueueGetMetrics(WorkQueueStruct *WQ_ptr, int reset, int *depth_ptr, int *max_depth_ptr, long *num_popped_ptr, 
+   long *num_push_blocked_ptr, double *ave_wait_us_ptr, double *max_wait_us_ptr)
+   {
+   long interval_popped;
+
+   pthread_mutex_lock(&(WQ_ptr->mutex));
+   interval_popped = WQ_ptr->num_popped - WQ_ptr->interval_start_popped;
+   *depth_ptr = WQ_ptr->count;
+   *max_depth_ptr = WQ_ptr->max_depth;
+   *num_popped_ptr = WQ_ptr->num_popped;
+   *num_push_blocked_ptr = WQ_ptr->num_push_blocked;
+   *ave_wait_us_ptr = (interval_popped > 0) ? WQ_ptr->tot_wait_us/interval_popped : 0.0;
+   *max_wait_us_ptr = WQ_ptr->max_wait_us;
+   if ( reset == 1 )
+      {
+      WQ_ptr->interval_start_popped = WQ_ptr->num_popped;
+      WQ_ptr->max_depth = WQ_ptr->count;
+      WQ_ptr->tot_wait_us = 0.0;
+      WQ_ptr->max_wait_us = 0.0;
+      }
+   pthread_mutex_unlock(&(WQ_ptr->mutex));
+
+   return;
+   }
+
+
 // ========================================================================================================
 // ========================================================================================================
 // Open up a socket and listen for connections from clients 
@@ -886,23 +1270,165 @@ printf("Checking\n"); fflush(stdout);
    }
 
 
+// ========================================================================================================
+// ========================================================================================================
+// Per-connection receive buffers for SockGetB(), indexed by socket descriptor. A connection is serviced by one thread at
+// a time so a slot is never touched concurrently. The buffers are allocated on first attach and reused when the kernel
+// hands out the same descriptor number again.
+
+static SockReaderStruct *SockReaders[SOCK_READER_MAX_FDS];
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Attach a receive buffer to 'socket_desc'. Must be called right after the connection is accepted or opened (before 
+// any SockGetB()), and paired with SockReaderDetach() before the descriptor is closed. Descriptors beyond the table 
+// silently fall back to unbuffered reads.
+
+void SockReaderAttach(int socket_desc)
+   {
+   SockReaderStruct *SR_ptr;
+
+   if ( socket_desc < 0 || socket_desc >= SOCK_READER_MAX_FDS )
+      return;
+
+   if ( (SR_ptr = SockReaders[socket_desc]) == NULL )
+      {
+      if ( (SR_ptr = (SockReaderStruct *)malloc(sizeof(SockReaderStruct))) == NULL )
+         { printf("ERROR: SockReaderAttach(): Failed to allocate reader for socket %d!\n", socket_desc); exit(EXIT_FAILURE); }
+      SockReaders[socket_desc] = SR_ptr;
+      }
+
+   SR_ptr->start = 0;
+   SR_ptr->end = 0;
+   SR_ptr->attached = 1;
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Detach the receive buffer from 'socket_desc'. Any bytes still buffered belong to the connection being closed and 
+// are discarded. 
+
+void SockReaderDetach(int socket_desc)
+   {
+   if ( socket_desc < 0 || socket_desc >= SOCK_READER_MAX_FDS || SockReaders[socket_desc] == NULL )
+      return;
+
+   SockReaders[socket_desc]->attached = 0;
+   SockReaders[socket_desc]->start = 0;
+   SockReaders[socket_desc]->end = 0;
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Read exactly 'num_bytes' from the socket into 'dest'. With a reader attached, buffered bytes are consumed first and 
+// the buffer is refilled with whatever the kernel has ready (possibly several frames). Returns 'num_bytes', or -1 on 
+// error or when the peer closes the connection early.
+
+static int SockReadBytes(int socket_desc, SockReaderStruct *SR_ptr, unsigned char *dest, int num_bytes)
+   {
+   int num_copied, num_avail, num_recv;
+
+   num_copied = 0;
+   while ( num_copied < num_bytes )
+      {
+      if ( SR_ptr != NULL && (num_avail = SR_ptr->end - SR_ptr->start) > 0 )
+         {
+         if ( num_avail > num_bytes - num_copied )
+            num_avail = num_bytes - num_copied;
+         memcpy(&dest[num_copied], &SR_ptr->buffer[SR_ptr->start], num_avail);
+         SR_ptr->start += num_avail;
+         num_copied += num_avail;
+         continue;
+         }
+
+// Buffer is empty (or absent). Large remainders go straight into the caller's buffer, small ones refill the buffer.
+      if ( SR_ptr == NULL || num_bytes - num_copied >= SOCK_READER_BUFFER_SIZE )
+         num_recv = recv(socket_desc, &dest[num_copied], num_bytes - num_copied, 0);
+      else
+         {
+         SR_ptr->start = 0;
+         SR_ptr->end = 0;
+         num_recv = recv(socket_desc, SR_ptr->buffer, SOCK_READER_BUFFER_SIZE, 0);
+         }
+
+      if ( num_recv < 0 && errno == EINTR )
+         continue;
+      if ( num_recv <= 0 )
+         return -1;
+
+      if ( SR_ptr == NULL || num_bytes - num_copied >= SOCK_READER_BUFFER_SIZE )
+         num_copied += num_recv;
+      else
+         SR_ptr->end = num_recv;
+      }
+
+   return num_copied;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Write all iovecs, resuming after partial writes. Returns 0 on success or -1 on error.
+
+static int SockWritevAll(int socket_desc, struct iovec *iov, int num_iov)
+   {
+   ssize_t num_written;
+
+   while ( num_iov > 0 )
+      {
+      if ( (num_written = writev(socket_desc, iov, num_iov)) < 0 )
+         {
+         if ( errno == EINTR )
+            continue;
+         return -1;
+         }
+
+// Skip over the iovecs that were fully written and advance into the partially written one.
+      while ( num_iov > 0 && num_written >= (ssize_t)iov->iov_len )
+         {
+         num_written -= iov->iov_len;
+         iov++;
+         num_iov--;
+         }
+      if ( num_iov > 0 )
+         {
+         iov->iov_base = (unsigned char *)iov->iov_base + num_written;
+         iov->iov_len -= num_written;
+         }
+      }
+
+   return 0;
+   }
+
+
 // ========================================================================================================
 // ========================================================================================================
 // This function is designed to buffer data but in kernel space. It allows binary data to be transmitted. 
-// To accomplish this, the first two bytes are interpreted as the length of the binary byte stream that follows.
+// To accomplish this, the first three bytes are interpreted as the length of the binary byte stream that follows.
+// If SockReaderAttach() was called on the socket, reads are served from the per-connection buffer. 
 
 int SockGetB(unsigned char *buffer, int buffer_size, int socket_desc)
    {
-   int tot_bytes_received, target_num_bytes;
-   unsigned char buffer_num_bytes[4];
+   SockReaderStruct *SR_ptr;
+   int target_num_bytes;
+   unsigned char buffer_num_bytes[SOCK_FRAME_HEADER_LEN];
 
-// Call until two bytes are returned. The 2-byte buffer represents a number that is to be interpreted as the exact 
-// number of binary bytes that will follow in the socket.
-   target_num_bytes = 3;
-   tot_bytes_received = 0;
-   while ( tot_bytes_received < target_num_bytes )
-      if ( (tot_bytes_received += recv(socket_desc, &buffer_num_bytes[tot_bytes_received], target_num_bytes - tot_bytes_received, 0)) < 0 )
-         { printf("ERROR: SockGetB(): Error in receiving three byte cnt!\n"); fflush(stdout); return -1; }
+   SR_ptr = NULL;
+   if ( socket_desc >= 0 && socket_desc < SOCK_READER_MAX_FDS && SockReaders[socket_desc] != NULL && 
+      SockReaders[socket_desc]->attached == 1 )
+      SR_ptr = SockReaders[socket_desc];
+
+// Fetch the 3-byte header, which represents a number that is to be interpreted as the exact number of binary bytes that 
+// will follow in the socket.
+   if ( SockReadBytes(socket_desc, SR_ptr, buffer_num_bytes, SOCK_FRAME_HEADER_LEN) < 0 )
+      { printf("ERROR: SockGetB(): Error in receiving three byte cnt!\n"); fflush(stdout); return -1; }
 
 // Translate the binary bytes into an integer.
    target_num_bytes = (int)(buffer_num_bytes[2] << 16) + (int)(buffer_num_bytes[1] << 8) + (int)buffer_num_bytes[0];
@@ -917,46 +1443,114 @@ int SockGetB(unsigned char *buffer, int buffer_size, int socket_desc)
          target_num_bytes, buffer_size); fflush(stdout); return -1;
       }
 
-// Now start reading binary bytes from the socket
-   tot_bytes_received = 0;
-   while ( tot_bytes_received < target_num_bytes )
-      if ( (tot_bytes_received += recv(socket_desc, &buffer[tot_bytes_received], target_num_bytes - tot_bytes_received, 0)) < 0 )
-         { printf("ERROR: SockGetB(): Error in receiving transmitted data!\n"); fflush(stdout); return -1; }
-
-// Sanity check
-   if ( tot_bytes_received != target_num_bytes )
-      { 
-      printf("ERROR: SockGetB(): Read more bytes then requested -- 'tot_bytes_received' %d is larger than target %d\n", 
-         tot_bytes_received, target_num_bytes); fflush(stdout); return -1; 
-      }
+// Now read the binary bytes.
+   if ( SockReadBytes(socket_desc, SR_ptr, buffer, target_num_bytes) < 0 )
+      { printf("ERROR: SockGetB(): Error in receiving transmitted data!\n"); fflush(stdout); return -1; }
 
 // DEBUG
-//printf("SockGetB(): received %d bytes\n", tot_bytes_received); fflush(stdout);
+//printf("SockGetB(): received %d bytes\n", target_num_bytes); fflush(stdout);
 
-   return tot_bytes_received;
+   return target_num_bytes;
    }
 
 
 // ========================================================================================================
 // ========================================================================================================
 // This function sends binary or ASCII data of 'buffer_size' unsigned characters through the socket. It first 
-// sends two binary bytes that represent the length of the binary or ASCII byte stream that follows.
+// sends three binary bytes that represent the length of the binary or ASCII byte stream that follows. Header and 
+// payload go out in one writev() so Nagle never holds the payload back waiting for the ACK of the header.
 
 int SockSendB(unsigned char *buffer, int buffer_size, int socket_desc)
    {
-   unsigned char num_bytes[3];
+   unsigned char num_bytes[SOCK_FRAME_HEADER_LEN];
+   struct iovec iov[2];
 
 // Sanity check. Don't yet support transfers larger than 16,777,215 bytes.
-   if ( buffer_size > 16777215 )
+   if ( buffer_size > SOCK_FRAME_MAX_PAYLOAD )
       { printf("ERROR: SockSendB(): Size of buffer %d larger than max (16777215)!\n", buffer_size); fflush(stdout); return -1; }
 
    num_bytes[2] = (unsigned char)((buffer_size & 0x00FF0000) >> 16);
    num_bytes[1] = (unsigned char)((buffer_size & 0x0000FF00) >> 8);
    num_bytes[0] = (unsigned char)(buffer_size & 0x000000FF);
-   if ( send(socket_desc, num_bytes, 3, 0) < 0 )
-      { printf("ERROR: SockSendB(): Send 'num_bytes' %d failed\n", buffer_size); fflush(stdout); return -1; }
-   if ( send(socket_desc, buffer, buffer_size, 0) < 0 )
-      { printf("ERROR: SockSendB(): Send failed\n"); fflush(stdout); return -1; }
+
+   iov[0].iov_base = num_bytes;
+   iov[0].iov_len = SOCK_FRAME_HEADER_LEN;
+   iov[1].iov_base = buffer;
+   iov[1].iov_len = buffer_size;
+   if ( SockWritevAll(socket_desc, iov, 2) < 0 )
+      { printf("ERROR: SockSendB(): Send of %d bytes failed\n", buffer_size); fflush(stdout); return -1; }
+
+   return 0;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Send 'num_frames' consecutive frames with as few syscalls as possible. The bytes on the wire are identical to calling 
+// SockSendB() once per frame, so the receiver still uses SockGetB() per frame. 
+
+int SockSendFrames(int num_frames, unsigned char **buffers, int *buffer_sizes, int socket_desc)
+   {
+   unsigned char headers[SOCK_FRAMES_PER_WRITEV][SOCK_FRAME_HEADER_LEN];
+   struct iovec iov[2*SOCK_FRAMES_PER_WRITEV];
+   int frame_num, num_in_batch, i;
+
+   for ( frame_num = 0; frame_num < num_frames; frame_num += num_in_batch )
+      {
+      num_in_batch = num_frames - frame_num;
+      if ( num_in_batch > SOCK_FRAMES_PER_WRITEV )
+         num_in_batch = SOCK_FRAMES_PER_WRITEV;
+
+      for ( i = 0; i < num_in_batch; i++ )
+         {
+         int size = buffer_sizes[frame_num + i];
+
+         if ( size > SOCK_FRAME_MAX_PAYLOAD )
+            { printf("ERROR: SockSendFrames(): Size of frame %d (%d) larger than max (16777215)!\n", frame_num + i, size); fflush(stdout); return -1; }
+
+         headers[i][2] = (unsigned char)((size & 0x00FF0000) >> 16);
+         headers[i][1] = (unsigned char)((size & 0x0000FF00) >> 8);
+         headers[i][0] = (unsigned char)(size & 0x000000FF);
+
+         iov[2*i].iov_base = headers[i];
+         iov[2*i].iov_len = SOCK_FRAME_HEADER_LEN;
+         iov[2*i + 1].iov_base = buffers[frame_num + i];
+         iov[2*i + 1].iov_len = size;
+         }
+
+      if ( SockWritevAll(socket_desc, iov, 2*num_in_batch) < 0 )
+         { printf("ERROR: SockSendFrames(): Send of frames %d to %d failed\n", frame_num, frame_num + num_in_batch - 1); fflush(stdout); return -1; }
+      }
+
+   return 0;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Enable/disable TCP_NODELAY. With framing done in a single write per message (or batch), Nagle only adds latency to 
+// the request/response exchanges. Returns 0 on success or -1 on error.
+
+int SockSetNoDelay(int socket_desc, int enable)
+   {
+   if ( setsockopt(socket_desc, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable)) < 0 )
+      { perror("WARNING: SockSetNoDelay(): setsockopt TCP_NODELAY"); return -1; }
+
+   return 0;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Cork/uncork the socket (Linux TCP_CORK). While corked, the kernel holds back partial segments so several separate 
+// sends leave as full segments. Uncorking flushes immediately. Returns 0 on success or -1 on error.
+
+int SockSetCork(int socket_desc, int enable)
+   {
+#ifdef TCP_CORK
+   if ( setsockopt(socket_desc, IPPROTO_TCP, TCP_CORK, &enable, sizeof(enable)) < 0 )
+      { perror("WARNING: SockSetCork(): setsockopt TCP_CORK"); return -1; }
+#endif
 
    return 0;
    }
@@ -1133,7 +1727,9 @@ void SendVectorsAndMasks(int max_string_len, int num_vecs, int device_socket_des
    unsigned char **first_vecs_b, unsigned char **second_vecs_b, int has_masks, int num_POs, unsigned char **masks)
    {
    char num_vecs_str[max_string_len];
-   int i;
+   unsigned char *frame_buffers[SOCK_FRAMES_PER_WRITEV];
+   int frame_sizes[SOCK_FRAMES_PER_WRITEV];
+   int num_frames, i;
 
 // Send num_vecs first. 
    sprintf(num_vecs_str, "%d %d %d", num_vecs, num_rise_vecs, has_masks);
@@ -1142,21 +1738,34 @@ void SendVectorsAndMasks(int max_string_len, int num_vecs, int device_socket_des
 printf("Sending '%s'\n to device\n", num_vecs_str); fflush(stdout);
 #endif
 
-// Send num_bytes of string as two-binary bytes. When sending ASCII character strings, be sure to add one to include 
-// the NULL termination character (+ 1) so the receiver can treat this as a string. 
-   if ( SockSendB((unsigned char *)num_vecs_str, strlen(num_vecs_str) + 1, device_socket_desc) < 0 )
-      { printf("ERROR: SendVectorsAndMasks(): Send '%s' failed\n", num_vecs_str); exit(EXIT_FAILURE); }
-
-// Send first_vecs and second_vecs to remote server
+// Send the count string followed by every vector (and mask) frame. The frames are batched into SockSendFrames() calls 
+// instead of one SockSendB() per vector. When sending ASCII character strings, be sure to add one to include the NULL 
+// termination character (+ 1) so the receiver can treat this as a string. 
+   frame_buffers[0] = (unsigned char *)num_vecs_str;
+   frame_sizes[0] = strlen(num_vecs_str) + 1;
+   num_frames = 1;
    for ( i = 0; i < num_vecs; i++ )
       {
-      if ( SockSendB(first_vecs_b[i], num_PIs/8, device_socket_desc) < 0 )
-         { printf("ERROR: SendVectorsAndMasks(): Send 'first_vecs_b[%d]' failed!\n", i); exit(EXIT_FAILURE); }
-      if ( SockSendB(second_vecs_b[i], num_PIs/8, device_socket_desc) < 0 )
-         { printf("ERROR: SendVectorsAndMasks(): Send 'second_vecs_b[%d]' failed!\n", i); exit(EXIT_FAILURE); }
-      if ( has_masks == 1 && SockSendB(masks[i], num_POs/8, device_socket_desc) < 0 )
-         { printf("ERROR: SendVectorsAndMasks(): Send 'masks[%d]' failed!\n", i); exit(EXIT_FAILURE); }
+      frame_buffers[num_frames] = first_vecs_b[i];
+      frame_sizes[num_frames++] = num_PIs/8;
+      frame_buffers[num_frames] = second_vecs_b[i];
+      frame_sizes[num_frames++] = num_PIs/8;
+      if ( has_masks == 1 )
+         {
+         frame_buffers[num_frames] = masks[i];
+         frame_sizes[num_frames++] = num_POs/8;
+         }
+
+// Flush when the batch cannot hold another vector's frames, and after the last vector.
+      if ( num_frames > SOCK_FRAMES_PER_WRITEV - 3 || i == num_vecs - 1 )
+         {
+         if ( SockSendFrames(num_frames, frame_buffers, frame_sizes, device_socket_desc) < 0 )
+            { printf("ERROR: SendVectorsAndMasks(): Send of vectors ending at %d failed!\n", i); exit(EXIT_FAILURE); }
+         num_frames = 0;
+         }
       }
+   if ( num_frames > 0 && SockSendFrames(num_frames, frame_buffers, frame_sizes, device_socket_desc) < 0 )
+      { printf("ERROR: SendVectorsAndMasks(): Send '%s' failed\n", num_vecs_str); exit(EXIT_FAILURE); }
 
 #ifdef DEBUG
 printf("SendVectorsAndMasks(): Sent %d vector pairs!\n", num_vecs); fflush(stdout);
@@ -1691,7 +2300,7 @@ printf("\n\n");
 
 int JoinBytePackedBitStrings(int num_bits1, unsigned char **bs1_ptr, int num_bits2, unsigned char *bs2)
    {
-   int num_bytes1, new_num_bits, new_num_bytes, i, j;
+   int num_bytes1, new_num_bits, new_num_bytes;
 
 // Sanity checks
    if ( bs2 == NULL )
@@ -1723,9 +2332,8 @@ int JoinBytePackedBitStrings(int num_bits1, unsigned char **bs1_ptr, int num_bit
       if ( (*bs1_ptr = (unsigned char *)realloc(*bs1_ptr, sizeof(unsigned char)*new_num_bytes)) == NULL )
          { printf("ERROR: JoinBytePackedBitStrings(): Failed to realloc *bs1_ptr to new size!\n"); exit(EXIT_FAILURE); }
 
-// Now transfer the bits from bs2 to *bs1_ptr
-   for ( i = num_bits1, j = 0; i < new_num_bits; i++, j++ )
-      SetBitInByte(&((*bs1_ptr)[i/8]), GetBitFromByte(bs2[j/8], j % 8), i % 8);
+// Now transfer the bits from bs2 to *bs1_ptr, 64 at a time.
+   BitStringCopyBits(*bs1_ptr, num_bits1, bs2, 0, num_bits2);
 
    return new_num_bits;
    }
@@ -1738,7 +2346,7 @@ int JoinBytePackedBitStrings(int num_bits1, unsigned char **bs1_ptr, int num_bit
 
 int EliminatePackedBitsFromBS(int num_bits, unsigned char *bs, int bit_pos)
    {
-   int i, j, new_bs_len;
+   int new_bs_len;
 
 // Sanity checks
    if ( bs == NULL )
@@ -1761,13 +2369,11 @@ int EliminatePackedBitsFromBS(int num_bits, unsigned char *bs, int bit_pos)
    if ( new_bs_len < 0 )
       { printf("ERROR: EliminatePackedBitsFromBS(): New bitstring length is < 0!\n"); exit(EXIT_FAILURE); }
 
-// Now move the bits. If bit_pos == num_bits, this moves NOTHING.
-   for ( i = 0, j = bit_pos; j < num_bits; i++, j++ )
-      SetBitInByte(&(bs[i/8]), GetBitFromByte(bs[j/8], j % 8), i % 8);
+// Now move the bits. If bit_pos == num_bits, this moves NOTHING. Copying toward position 0 is safe in place.
+   BitStringCopyBits(bs, 0, bs, bit_pos, new_bs_len);
 
 // Zero out bits above the new length of the bitstring, e.g, bits 6, 7, 8 and 9.
-   for ( i = new_bs_len; i < num_bits; i++ )
-      SetBitInByte(&(bs[i/8]), 0, i % 8);
+   BitStringClearBits(bs, new_bs_len, num_bits - new_bs_len);
 
    return new_bs_len; 
    }
@@ -1809,11 +2415,14 @@ int EliminatePackedBitsFromBS(int num_bits, unsigned char *bs, int bit_pos)
 // where the number of disagreeing bits in the majority vote is actually the majority. It does this by comparing the regenerated
 // response bit with the actual bit in the KEK_enroll_key (if NON-NULL) and adds in the complement of the minority_bit_flips
 // if the super-strong response bits disagree.
+//
+// strong_bits is caller-provided scratch of at least (max_bits + 7)/8 bytes, used ONLY during regeneration (it can be NULL 
+// for enrollment). This routine runs for every chip in the device authentication search, so it does not allocate.
 
 int KEK_FSB_SKE(int max_bits, int XMR, unsigned char *SBG_SHD, unsigned char *SBG_SBS, unsigned char *XMR_SHD, 
    int num_nonce_bits, unsigned char *Nonce_or_XMR_SBS, int enroll_or_regen, int do_minority_bit_flip_analysis, 
    int *num_minority_bit_flips_ptr, int start_actual_bit_pos, unsigned char *KEK_enroll_key, 
-   int *true_minority_bit_flips_ptr, int FSB_or_SKE, int chip_num, int TV_num)
+   int *true_minority_bit_flips_ptr, int FSB_or_SKE, int chip_num, int TV_num, unsigned char *strong_bits)
    {
    int num_zeros, num_ones, XMR_copy_cnt, tot_wasted_strong, tot_strong, SBS_tracker;
    int bit_num_of_last_fully_encoded_bit; 
@@ -1828,12 +2437,51 @@ printf("Running KEK_FSB_SKE(): chip %d\tTV_num %d\n", chip_num, TV_num); fflush(
    if ( (XMR % 2) == 0 )
       { printf("ERROR: KEK_FSB_SKE(): XMR MUST BE odd %d\n", XMR); exit(EXIT_FAILURE); }
 
+// Regeneration. The raw bitstring has ALL max_bits bits (weak and strong) so the strong bits are simply the SBG_SBS bits at the positions 
+// where the enrollment XMR helper data is 1, and no strong bit is ever wasted. Compact them with the helper data as a mask and then take 
+// the majority vote of each group of XMR consecutive strong bits, a word at a time. In SKE mode we stop after 'num_nonce_bits' bits. 
+   if ( enroll_or_regen == 1 )
+      {
+      if ( strong_bits == NULL )
+         { printf("ERROR: KEK_FSB_SKE(): Regeneration requires the strong_bits scratch!\n"); exit(EXIT_FAILURE); }
+
+      tot_strong = BitStringExtractMasked(max_bits, SBG_SBS, SBG_SHD, strong_bits, 0);
+      strong_bit_num = tot_strong/XMR;
+      if ( FSB_or_SKE == 1 && num_nonce_bits > 0 && strong_bit_num > num_nonce_bits )
+         strong_bit_num = num_nonce_bits;
+
+// The minority count adds the number of losing bits in each majority vote (0 when all XMR copies agree). The true minority count needs 
+// the actual key and adds, for each group, the number of copies that disagree with the key bit. This is the minority count when the vote 
+// reproduces the key bit and its complement (XMR - minority) when it does not, e.g., all 5 copies of a 5MR bit agree but on the wrong value.
+      if ( do_minority_bit_flip_analysis == 1 )
+         BitStringMajorityVote(XMR, strong_bit_num, strong_bits, Nonce_or_XMR_SBS, 0, num_minority_bit_flips_ptr, KEK_enroll_key, 
+            start_actual_bit_pos, true_minority_bit_flips_ptr);
+      else
+         BitStringMajorityVote(XMR, strong_bit_num, strong_bits, Nonce_or_XMR_SBS, 0, NULL, NULL, 0, NULL);
+
+// Sanity check: Assuming we ALWAYS succeed in encoding at least a couple bits, this should NEVER BE 0.
+      if ( strong_bit_num == 0 )
+         { printf("WARNING: KEK_FSB_SKE(): 'bit_num_of_last_fully_encoded_bit' is -1!\n"); }
+
+#ifdef DEBUG
+printf("\tKEK_FSB_SKE(): Regen: Chip %d\tTV %d\tXMR %d\tTotal strong bits %d\tFinal size of strong bitstring %d\n", 
+   chip_num, TV_num, XMR, tot_strong, strong_bit_num); 
+printf("KEK_FSB_SKE(): returning!\n"); fflush(stdout);
+#endif
+
+      return strong_bit_num;
+      }
+
+// Enrollment from here on. Start with XMR_SHD equal to the enrollment helper data (SBG_SHD). We update this below by overwriting a '1' 
+// with a '0' when it is necessary to eliminate strong bits that do NOT match the bit that is searched for.
+   BitStringCopyBits(XMR_SHD, 0, SBG_SHD, 0, max_bits);
+
 // For statistics. Just count the number of times we find a strong bit of the 'wrong' value. This number should equal
 // 2 times the size of the strong bitstring with 3MR, 4 times for 5MR, etc.
    tot_wasted_strong = 0;
    tot_strong = 0;
 
-// Initialize regen and XMR variables.
+// Initialize XMR variables.
    num_zeros = 0;
    num_ones = 0;
    XMR_copy_cnt = 0;
@@ -1844,23 +2492,9 @@ printf("Running KEK_FSB_SKE(): chip %d\tTV_num %d\n", chip_num, TV_num); fflush(
    for ( bit_num = 0; bit_num < max_bits; bit_num++ )
       {
 
-// During enrollment, copy the Enrollment helper data (SBG_SHD) into the XMR_SHD. We will update this by writing potentially
-// overwriting a '1' that may be stored here to the XMR_SHD below when it is necessary to eliminate strong bits that do NOT match 
-// the bit that is searched for. 
-      if ( enroll_or_regen == 0 )
-         SetBitInByte(&(XMR_SHD[bit_num/8]), GetBitFromByte(SBG_SHD[bit_num/8], bit_num % 8), bit_num % 8);
-
-// During enrollment, skip weak bits. During regeneration, skip all bits not deemed strong during the earlier call to this routine
-// for enrollment.
+// Skip weak bits. For enrollment, we ONLY have the strong bits in the BS (it is the SBS), so SBS_tracker is NOT incremented.
       if ( GetBitFromByte(SBG_SHD[bit_num/8], bit_num % 8) == 0 )
-         {
-
-// For enrollment, we ONLY have the strong bits in the BS (it is the SBS). For regeneration, BS has ALL 2048 bits (weak and strong).
-// Increment SBS_tracker after EVERY helper data bit processed during regeneration.
-         if ( enroll_or_regen == 1 )
-            SBS_tracker++; 
          continue;
-         }
 
 // Get the strong bit. NOTE: We INCREMENT SBS_tracker here (as we do in the VHDL state machine) since we do NOT reference SBG_SBS
 // again below (we've stored the strong_bit here).
@@ -1872,34 +2506,31 @@ printf("Running KEK_FSB_SKE(): chip %d\tTV_num %d\n", chip_num, TV_num); fflush(
 printf("\t\tKEK_FSB_SKE(): Strong bit %d found at index %d\n", strong_bit, bit_num); fflush(stdout);
 #endif
 
-// If 'enrollment' then we are generating the XMR_SHD that will be used during regeneration, so update the XMR_SHD.
-      if ( enroll_or_regen == 0 )
+// We are generating the XMR_SHD that will be used during regeneration, so update the XMR_SHD.
+      if ( XMR_copy_cnt == 0 )
          {
-         if ( XMR_copy_cnt == 0 )
+         if ( FSB_or_SKE == 0 )
+            bit_to_match = strong_bit;
+         else
             {
-            if ( FSB_or_SKE == 0 )
-               bit_to_match = strong_bit;
-            else
-               {
-               bit_to_match = GetBitFromByte(Nonce_or_XMR_SBS[strong_bit_num/8], strong_bit_num % 8);
+            bit_to_match = GetBitFromByte(Nonce_or_XMR_SBS[strong_bit_num/8], strong_bit_num % 8);
         
 #ifdef DEBUG
 printf("KEK_FSB_SKE(): NEW bit at pos %d to encode => %d!\n", strong_bit_num, bit_to_match); fflush(stdout);
 #endif
-               }
             }
+         }
 
 // Compare the current 'strong' bit with the value bit_to_match. If it doesn't match, zero the helper data and skip this strong bit.
-         if ( bit_to_match != strong_bit )
-            { 
-            SetBitInByte(&(XMR_SHD[bit_num/8]), 0, bit_num % 8);
+      if ( bit_to_match != strong_bit )
+         { 
+         SetBitInByte(&(XMR_SHD[bit_num/8]), 0, bit_num % 8);
 
 #ifdef DEBUG
 printf("\t\tKEK_FSB_SKE(): Eliminating strong bit at %d because of MISMATCH %d\n", bit_num, strong_bit); fflush(stdout);
 #endif
-            tot_wasted_strong++; 
-            continue; 
-            }
+         tot_wasted_strong++; 
+         continue; 
          }
 
 // Keep track of how many of each bit value we have across the XMR of the bit. 
@@ -1924,62 +2555,16 @@ printf("\t\tKEK_FSB_SKE(): Enroll/Regen? %d\tFINAL: XMR_copy_cnt %d: Num zeros %
    enroll_or_regen, XMR_copy_cnt, num_zeros, num_ones, strong_bit, bit_num); fflush(stdout);
 #endif
 
-// Store the strong_bit in the strong bit (FSB mode) or regenerated Nonce bit (SKE mode) during regeneration (we ALSO do this now for 
-// SKE enrollment which SIMPLY re-writes the nonce bit with the SAME value). The SBS or Nonce bitstring IS the OUTPUT of KEK_FSB_SKE 
-// during regeneration. 
+// Store the strong_bit in the strong bit (FSB mode). For SKE enrollment this SIMPLY re-writes the nonce bit with the SAME value. 
          SetBitInByte(&(Nonce_or_XMR_SBS[strong_bit_num/8]), strong_bit, strong_bit_num % 8);
 
-// If BOTH of num_zeros or num_ones are NON-zero, then there was disagreement and majority vote decided the output. Add the number of bits in the losing majority
-// to the counter. This may be important in helping with selecting the correct chip in a database search by the server for this authentication function.
-// If XMR is 5, and num_zeros is 2 and num_ones is 3, then num_ones is selected in the majority vote. We want to add 2 to the counter here in this case.
-// Note: If num_zeros is 0 and num_ones is 5, then this adds nothing. Also note that num_zeros NEVER equals num_ones.
-         if ( enroll_or_regen == 1 && do_minority_bit_flip_analysis == 1 )
-            {
-            int cur_num_minority_bit_flips;
-            if ( num_zeros < num_ones )
-               cur_num_minority_bit_flips = XMR - num_ones;
-            else
-               cur_num_minority_bit_flips = XMR - num_zeros; 
-            *num_minority_bit_flips_ptr += cur_num_minority_bit_flips;
-
-// Need to know how many mismatches are actually occurring for privacy-preserving authentication. The metric above on num_minority_bit_flips does not
-// work. If I have a majority vote mismatch with the actual nonce bit, it may happen that all 5 bits in 5MR agree with the majority vote. In this case,
-// num_minority_bit_flips will be 0 and should be 5!
-
-// If the actual bit agrees with the super strong XMR bit just encoded, then add in current number of minority bit flips to the true_minority_bit_flips_ptr. NOTE: We
-// may NOT have the enrollment key in some cases so don't do this if that parameter is NULL.
-            if ( KEK_enroll_key != NULL )
-               {
-               if ( strong_bit == GetBitFromByte(KEK_enroll_key[(start_actual_bit_pos + strong_bit_num)/8], (start_actual_bit_pos + strong_bit_num) % 8) )
-                  {
-                  *true_minority_bit_flips_ptr += cur_num_minority_bit_flips;
-#ifdef DEBUG
-if ( cur_num_minority_bit_flips != 0 )
-   printf("\t\tStrong bit num %d has minority bit flip error with %d bit flips!\n", start_actual_bit_pos + strong_bit_num, cur_num_minority_bit_flips); 
-fflush(stdout);
-#endif
-                  }
-
-// Otherwise, add in the complement of the current number of minority bit flips
-               else 
-                  {
-                  *true_minority_bit_flips_ptr += (XMR - cur_num_minority_bit_flips);
-#ifdef DEBUG
-if ( XMR - cur_num_minority_bit_flips != 0 )
-   printf("\t\tKEY BIT FLIP ERROR at position %d\tCorrect strong bit count is minority %d!\n", start_actual_bit_pos + strong_bit_num, XMR - cur_num_minority_bit_flips); 
-fflush(stdout);
-#endif
-                  }
-               }
-            }
-
-// Increment the strong_bit_num index here -- NOTE: THIS IS AN INDEX, NOT a count of the number of strong bits encoded. During enrollment, this will select the 
-// next bit to encode (if there are any remaining). During regeneration, this allows us to exit once we've reproduced the number of required bits.
+// Increment the strong_bit_num index here -- NOTE: THIS IS AN INDEX, NOT a count of the number of strong bits encoded. This will select the 
+// next bit to encode (if there are any remaining).
          strong_bit_num++;
 
 // Store the bit_num index into the XMR_SHD that is associated with the last fully encoded 'bit_to_match' so we can eliminate '1' in XMR_SHD that partially
 // encode the next bit but fail to fully encode it because we ran out -- note we have just completed a full encoding of a bit here and bit_num points to the last
-// XMR_SHD bit that is set to 1 to enable this. So below, WE MUST INCREMENT ONE BEYOND THIS bit_num index and THEN start zeroing out. ONLY USED DURING ENROLLMENT.
+// XMR_SHD bit that is set to 1 to enable this. So below, WE MUST INCREMENT ONE BEYOND THIS bit_num index and THEN start zeroing out.
          bit_num_of_last_fully_encoded_bit = bit_num;
 
 // SKE mode ONLY: Increment to the next bit to encode if doing enrollment. 
@@ -2013,24 +2598,11 @@ printf("\t\tKEK_FSB_SKE(): REDUNDANT: XMR_copy_cnt %d: Num zeros %d\tNum ones %d
    if ( bit_num_of_last_fully_encoded_bit == -1 )
       { printf("WARNING: KEK_FSB_SKE(): 'bit_num_of_last_fully_encoded_bit' is -1!\n"); }
 
-// SKE mode ONLY: If we exit the loop early, reset XMR_SHD bits that are 1 for the last partial encoding of the last strong bit. This will ensure 
+// If we exit the loop early, reset XMR_SHD bits that are 1 for the last partial encoding of the last strong bit. This will ensure 
 // that the XMR_SHD has EXACTLY 'num_nonce_bits'*XMR_val helper data bits set to 1. This is NOT needed but I think if XMR helper data leaks anything, 
 // then this will reduce the leakage even further. Remember, the XMR_SHD IS the 'product' of this routine during enrollment, while the 
 // Nonce_or_XMR_SBS is the 'product' during regeneration -- in fact, XMR_SHD is NULL during regeneration. 
-   if ( enroll_or_regen == 0 )
-      for ( bit_num = bit_num_of_last_fully_encoded_bit + 1; bit_num < max_bits; bit_num++ )
-         SetBitInByte(&(XMR_SHD[bit_num/8]), 0, bit_num % 8);
-
-// Sanity check
-   if ( enroll_or_regen == 1 && tot_wasted_strong != 0 )
-      { printf("ERROR: KEK_FSB_SKE(): Regeneration requires tot_wasted_strong %d MUST BE 0!\n", tot_wasted_strong); exit(EXIT_FAILURE); }
-
-// Sanity check
-   if ( enroll_or_regen == 1 && tot_strong/XMR != strong_bit_num )
-      { 
-      printf("ERROR: KEK_FSB_SKE(): Regeneration requires total number of strong bits %d MUST BE equal to ALL strong bits div XMR %d!\n", 
-         strong_bit_num, tot_strong/XMR); exit(EXIT_FAILURE); 
-      }
+   BitStringClearBits(XMR_SHD, bit_num_of_last_fully_encoded_bit + 1, max_bits - (bit_num_of_last_fully_encoded_bit + 1));
 
 #ifdef DEBUG
 if ( XMR != 1 )
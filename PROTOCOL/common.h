@@ -34,6 +34,11 @@
 
 #include <pthread.h>
 
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <netinet/tcp.h>
+
 #include "utility.h"
 
 // 10_10_2022: THIS MUST BE LARGER THAN THE NUMBER OF CHIPS IN THE DB. Used in verifier_regen_funcs.c in Cobra authentication function
@@ -169,6 +174,10 @@
 #define CC_SKE_AUTHEN_THRESHOLD 5.0
 #define PCC_SKE_AUTHEN_THRESHOLD 25.0
 
+// Multi-threaded device authentication search. The chip range is handed out to the BankThread and the search pool helpers in chunks 
+// of DA_SEARCH_CHUNK_CHIPS. All chips are always scored.
+#define DA_SEARCH_CHUNK_CHIPS 64
+
 // 11_5_2022: Trying more iterations for Cobra
 #define NUM_COBRA_ITERATIONS 2
 #define PCC_COBRA_AUTHEN_THRESHOLD 15.0
@@ -180,6 +189,11 @@
 // Number of devices that can simultaneously connect
 #define MAX_CLIENTS 100
 
+// Default cap on the number of connections open at the same time in the epoll server (see EpollServerOpen), and the 
+// number of events fetched per epoll_wait() call.
+#define EPOLL_SERVER_MAX_CONNECTIONS 4096
+#define EPOLL_SERVER_MAX_EVENTS 64
+
 // Number of DA attempts that are allowed.
 #define MAX_DA_RETRIES 5
 
@@ -231,6 +245,78 @@
 #define LARGEST_POS_VAL ((16384/16) - 1)
 #define LARGEST_NEG_VAL -LARGEST_POS_VAL
 
+// State of the epoll connection server. A connection occupies a slot in 'client_sockets' from accept() until the thread 
+// that services it calls EpollServerReleaseSlot(). Slot values: 0 free, -1 handed to a thread, otherwise the socket 
+// descriptor. Ready slots are queued in 'ready_slots' until EpollServerWait() hands them out. 
+typedef struct
+   {
+   int epoll_fd;
+   int master_socket;
+   int slot_event_fd;
+   int max_connections;
+   int num_connections;
+   int accept_pending;
+   int *client_sockets;
+   int *ready_slots;
+   int ready_head;
+   int ready_count;
+   pthread_mutex_t mutex;
+   } EpollServerStruct;
+
+// One request handed from the connection server to a worker thread. 
+typedef struct
+   {
+   int socket_desc;
+   int client_index;
+   int TTP_request;
+   int TTP_num;
+   int iteration_cnt;
+   struct timeval enqueue_time;
+   } WorkItemStruct;
+
+// Bounded multi-producer/multi-consumer queue of WorkItemStruct. Push blocks while the queue is full, pop blocks (with an 
+// optional timeout) while it is empty. Once 'closed' is set by WorkQueueClose(), pushes are refused and pops drain the items 
+// left before reporting the close. The counters below are updated under 'mutex' and read by WorkQueueGetMetrics().
+typedef struct
+   {
+   WorkItemStruct *items;
+   int capacity;
+   int head;
+   int count;
+   int closed;
+   pthread_mutex_t mutex;
+   pthread_cond_t not_empty;
+   pthread_cond_t not_full;
+
+   long num_pushed;
+   long num_popped;
+   long interval_start_popped;
+   long num_push_blocked;
+   int max_depth;
+   double tot_wait_us;
+   double max_wait_us;
+   } WorkQueueStruct;
+
+// Framed socket I/O. Every message on the wire is a 3-byte little-endian length followed by the payload. SockSendB() and 
+// SockSendFrames() write the header and payload of one or more frames with a single writev(). The receive side can attach
+// a per-connection buffer so SockGetB() pulls the header and (small) payload of several frames in one recv(). Payloads at 
+// least as large as the buffer bypass it and are received directly into the caller's buffer.
+#define SOCK_FRAME_HEADER_LEN 3
+#define SOCK_FRAME_MAX_PAYLOAD 16777215
+#define SOCK_READER_BUFFER_SIZE 16384
+#define SOCK_READER_MAX_FDS 1024
+
+// Number of frames handed to one writev() by SockSendFrames(). Two iovecs per frame, well under IOV_MAX (1024 on Linux).
+#define SOCK_FRAMES_PER_WRITEV 256
+
+typedef struct
+   {
+   int attached;
+   int start;
+   int end;
+   unsigned char buffer[SOCK_READER_BUFFER_SIZE];
+   } SockReaderStruct;
+
 // =====================================================================================================================
 // =====================================================================================================================
 void StringCreateAndCopy(char **dest, const char *src);
@@ -266,6 +352,19 @@ void GetMyIPAddr(int max_string_len, const char *target_interface_name, char **I
 int OpenMultipleSocketServer(int max_string_len, int *master_socket_ptr, char *server_IP, int port_number, char *client_IP, 
    int max_clients, int *client_sockets, int *client_index_ptr, int initialize);
 
+void EpollServerOpen(EpollServerStruct *ES_ptr, char *server_IP, int port_number, int max_connections);
+int EpollServerWait(EpollServerStruct *ES_ptr, char *client_IP, int *client_index_ptr);
+void EpollServerReleaseSlot(EpollServerStruct *ES_ptr, int client_index);
+void EpollServerRearmSlot(EpollServerStruct *ES_ptr, int client_index, int socket_desc);
+
+void WorkQueueInit(WorkQueueStruct *WQ_ptr, int capacity);
+void WorkQueuePush(WorkQueueStruct *WQ_ptr, WorkItemStruct *item_ptr);
+int WorkQueuePop(WorkQueueStruct *WQ_ptr, WorkItemStruct *item_ptr, int timeout_ms);
+void WorkQueueClose(WorkQueueStruct *WQ_ptr);
+int WorkQueueDepth(WorkQueueStruct *WQ_ptr);
+void WorkQueueGetMetrics(WorkQueueStruct *WQ_ptr, int reset, int *depth_ptr, int *max_depth_ptr, long *num_popped_ptr, 
+   long *num_push_blocked_ptr, double *ave_wait_us_ptr, double *max_wait_us_ptr);
+
 int OpenSocketServer(int max_string_len, int *server_socket_desc_ptr, char *server_IP, int port_number, int *client_socket_desc_ptr, 
    struct sockaddr_in *client_addr_ptr, int accept_only, int check_and_return);
 
@@ -278,6 +377,14 @@ int SockGetB(unsigned char *buffer, int buffer_size, int socket_desc);
 
 int SockSendB(unsigned char *buffer, int buffer_size, int socket_desc);
 
+int SockSendFrames(int num_frames, unsigned char **buffers, int *buffer_sizes, int socket_desc);
+
+void SockReaderAttach(int socket_desc);
+void SockReaderDetach(int socket_desc);
+
+int SockSetNoDelay(int socket_desc, int enable);
+int SockSetCork(int socket_desc, int enable);
+
 void PrintHeaderAndHexVals(char *header_str, int num_vals, unsigned char *vals, int max_vals_per_row);
 
 void PrintHeaderAndBinVals(char *header_str, int num_vals, unsigned char *vals, int max_vals_per_row);
@@ -324,7 +431,7 @@ int EliminatePackedBitsFromBS(int num_bits1, unsigned char *bs, int bit_pos);
 int KEK_FSB_SKE(int max_bits, int XMR, unsigned char *SBG_SHD, unsigned char *SBG_SBS, unsigned char *XMR_SHD, 
    int num_nonce_bits, unsigned char *Nonce_or_XMR_SBS, int enroll_or_regen, int do_minority_bit_flip_analysis, 
    int *num_minority_bit_flips_ptr, int start_actual_bit_pos, unsigned char *KEK_enroll_key, 
-   int *true_minority_bit_flips_ptr, int FSB_or_SKE, int chip_num, int TV_num);
+   int *true_minority_bit_flips_ptr, int FSB_or_SKE, int chip_num, int TV_num, unsigned char *strong_bits);
 
 // =========================
 #define ECT_NUM_BYTES 16
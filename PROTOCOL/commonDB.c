@@ -16,10 +16,12 @@
 // SQL commands depend on the structure of the tables in the database. Keeping these all in one place where possible.
 const char *SQL_PUFDesign_get_index_cmd = "SELECT id FROM PUFDesign WHERE netlist_name = ? AND synthesis_name = ?;";
 const char *SQL_PUFDesign_insert_into_cmd = "INSERT INTO PUFDesign (netlist_name, synthesis_name, num_PIs, num_POs) VALUES (?, ?, ?, ?);";
+const char *SQL_PUFDesign_get_num_PIs_POs_cmd = "SELECT num_PIs, num_POs FROM PUFDesign WHERE id = ?;";
 
 const char *SQL_PUFInstance_get_index_cmd = "SELECT id FROM PUFInstance WHERE Instance_name = ? AND Dev = ? AND Placement = ?;";
 const char *SQL_PUFInstance_insert_into_cmd = "INSERT INTO PUFInstance (Instance_name, Dev, Placement, EnrollDate, PUFDesign_id) VALUES (?, ?, ?, ?, ?);";
 const char *SQL_PUFInstance_delete_cmd = "DELETE FROM PUFInstance WHERE id = ?;";
+const char *SQL_PUFInstance_get_info_cmd = "SELECT Instance_name, Dev, Placement FROM PUFInstance WHERE id = ?;";
 
 const char *SQL_Vectors_insert_into_cmd = "INSERT INTO Vectors (vector) VALUES (?);";
 const char *SQL_Vectors_read_vector_cmd = "SELECT vector FROM Vectors WHERE id = ?;";
@@ -27,19 +29,443 @@ const char *SQL_Vectors_get_index_cmd = "SELECT id FROM Vectors WHERE vector = ?
 
 const char *SQL_VecPairs_insert_into_cmd = "INSERT INTO VecPairs (R_F_str, VA, VB, NumPNs, PUFDesign_id) VALUES (?, ?, ?, ?, ?);";
 const char *SQL_VecPairs_get_index_cmd = "SELECT id FROM VecPairs WHERE VA = ? AND VB = ? AND PUFDesign_id = ?;";
+const char *SQL_VecPairs_get_NumPNs_cmd = "SELECT NumPNs FROM VecPairs WHERE id = ?;";
+const char *SQL_VecPairs_get_R_F_str_cmd = "SELECT R_F_str FROM VecPairs WHERE id = ?;";
+const char *SQL_VecPairs_update_NumPNs_cmd = "UPDATE VecPairs SET NumPNs = ? WHERE id = ?;";
 
 const char *SQL_TimingVals_insert_into_cmd = "INSERT INTO TimingVals (VecPair, PO, Ave, TSig, PUFInstance) VALUES (?, ?, ?, ?, ?);";
+const char *SQL_TimingVals_get_challenge_Aves_cmd = "SELECT VecPair, PO, Ave FROM TimingVals WHERE PUFInstance = ? AND VecPair IN "
+   "(SELECT VecPair FROM ChallengeVecPairs WHERE Chlng = ?) ORDER BY VecPair, PO;";
+const char *SQL_TimingVals_get_Ave_cmd = "SELECT Ave FROM TimingVals WHERE PUFInstance = ? AND VecPair = ? AND PO = ?;";
+const char *SQL_TimingVals_get_TSig_cmd = "SELECT TSig FROM TimingVals WHERE PUFInstance = ? AND VecPair = ? AND PO = ?;";
 
 const char *SQL_PathSelectMasks_insert_into_cmd = "INSERT INTO PathSelectMasks (vector_str) VALUES (?);";
 const char *SQL_PathSelectMasks_get_index_cmd = "SELECT id FROM PathSelectMasks WHERE vector_str = ?;";
 
 const char *SQL_Challenges_insert_into_cmd = "INSERT INTO Challenges (Name, NumVecs, NumRiseVecs, NumPNs, NumRisePNs, PUFDesign_id) VALUES (?, ?, ?, ?, ?, ?);";
 const char *SQL_Challenges_get_index_cmd = "SELECT id FROM Challenges WHERE Name = ?;";
+const char *SQL_Challenges_get_NumVecs_NumPNs_cmd = "SELECT NumVecs, NumRiseVecs, NumPNs, NumRisePNs FROM Challenges WHERE id = ?;";
+const char *SQL_Challenges_update_NumVecs_cmd = "UPDATE Challenges SET NumVecs = ?, NumRiseVecs = ? WHERE id = ?;";
+const char *SQL_Challenges_update_NumPNs_cmd = "UPDATE Challenges SET NumPNs = ?, NumRisePNs = ? WHERE id = ?;";
 
 const char *SQL_ChallengeVecPairs_insert_into_cmd = "INSERT INTO ChallengeVecPairs (Chlng, VecPair, PSM) VALUES (?, ?, ?);";
 const char *SQL_ChallengeVecPairs_get_index_cmd = "SELECT id FROM ChallengeVecPairs WHERE Chlng = ? AND VecPair = ? AND PSM = ?;";
 
 
+// Prepared statement caches, one per thread. See SQLStmtAcquire(). The registry lists every thread's cache so that
+// SQLStmtCacheFinalize() can reach the statements of all threads. It is only locked when a thread creates or drops its 
+// cache and by SQLStmtCacheFinalize(), never on the query path.
+static pthread_key_t SQLStmtCache_key;
+static pthread_once_t SQLStmtCache_key_once = PTHREAD_ONCE_INIT;
+static SQLStmtCacheStruct *SQLStmtCache_registry = NULL;
+static pthread_mutex_t SQLStmtCache_registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+// ========================================================================================================
+// ========================================================================================================
+// FNV-1a hash of the SQL text, mixed with the connection pointer.
+
+static unsigned int SQLStmtHash(sqlite3 *db, const char *SQL_cmd)
+   {
+   unsigned int hash = 2166136261U;
+   uintptr_t db_bits = (uintptr_t)db;
+
+   while ( *SQL_cmd != '\0' )
+      {
+      hash ^= (unsigned char)*SQL_cmd++;
+      hash *= 16777619U;
+      }
+   hash ^= (unsigned int)(db_bits >> 4);
+   hash *= 16777619U;
+
+   return hash;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Rebuild the bucket chains of a cache after entries have been removed or moved. Called with the cache 
+// mutex held.
+
+static void SQLStmtCacheRehash(SQLStmtCacheStruct *SC_ptr)
+   {
+   int entry_num, bucket;
+
+   for ( bucket = 0; bucket < SQL_STMT_CACHE_BUCKETS; bucket++ )
+      SC_ptr->buckets[bucket] = -1;
+   for ( entry_num = 0; entry_num < SC_ptr->num_entries; entry_num++ )
+      {
+      bucket = SC_ptr->entries[entry_num].hash % SQL_STMT_CACHE_BUCKETS;
+      SC_ptr->entries[entry_num].next = SC_ptr->buckets[bucket];
+      SC_ptr->buckets[bucket] = entry_num;
+      }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Thread exit: finalize the thread's statements and drop its cache from the registry.
+
+static void SQLStmtCacheThreadExit(void *arg)
+   {
+   SQLStmtCacheStruct *SC_ptr = (SQLStmtCacheStruct *)arg;
+   SQLStmtCacheStruct **link_ptr;
+   int entry_num;
+
+   pthread_mutex_lock(&SQLStmtCache_registry_mutex);
+   for ( link_ptr = &SQLStmtCache_registry; *link_ptr != NULL; link_ptr = &((*link_ptr)->next) )
+      if ( *link_ptr == SC_ptr )
+         {
+         *link_ptr = SC_ptr->next;
+         break;
+         }
+   pthread_mutex_unlock(&SQLStmtCache_registry_mutex);
+
+   for ( entry_num = 0; entry_num < SC_ptr->num_entries; entry_num++ )
+      {
+      sqlite3_finalize(SC_ptr->entries[entry_num].pStmt);
+      free(SC_ptr->entries[entry_num].SQL_cmd);
+      }
+   pthread_mutex_destroy(&(SC_ptr->mutex));
+   free(SC_ptr);
+
+   return;
+   }
+
+
+static void SQLStmtCacheMakeKey()
+   {
+   if ( pthread_key_create(&SQLStmtCache_key, SQLStmtCacheThreadExit) != 0 )
+      { printf("ERROR: SQLStmtCacheMakeKey(): Failed to create the thread key!\n"); exit(EXIT_FAILURE); }
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// The calling thread's cache, created on first use.
+
+static SQLStmtCacheStruct *SQLStmtCacheGet()
+   {
+   SQLStmtCacheStruct *SC_ptr;
+
+   pthread_once(&SQLStmtCache_key_once, SQLStmtCacheMakeKey);
+   if ( (SC_ptr = (SQLStmtCacheStruct *)pthread_getspecific(SQLStmtCache_key)) != NULL )
+      return SC_ptr;
+
+   if ( (SC_ptr = (SQLStmtCacheStruct *)calloc(1, sizeof(SQLStmtCacheStruct))) == NULL )
+      { printf("ERROR: SQLStmtCacheGet(): Failed to allocate the statement cache!\n"); exit(EXIT_FAILURE); }
+   pthread_mutex_init(&(SC_ptr->mutex), NULL);
+   SQLStmtCacheRehash(SC_ptr);
+   pthread_setspecific(SQLStmtCache_key, SC_ptr);
+
+   pthread_mutex_lock(&SQLStmtCache_registry_mutex);
+   SC_ptr->next = SQLStmtCache_registry;
+   SQLStmtCache_registry = SC_ptr;
+   pthread_mutex_unlock(&SQLStmtCache_registry_mutex);
+
+   return SC_ptr;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Check out a prepared statement for 'SQL_cmd' on connection 'db'. Each thread has its own cache, a hash 
+// table keyed by connection and SQL text, so sqlite3_prepare_v2() runs once per thread, connection and SQL 
+// command rather than once per query and threads never contend for a cache. The statement is marked in use 
+// until SQLStmtRelease() is called. When the same query is already checked out by this thread (nested use), 
+// or every cache entry is in use, an uncached statement is returned and SQLStmtRelease() finalizes it. The 
+// cache keeps its own copy of 'SQL_cmd' since callers may build it in a stack buffer. NOTE: Call 
+// SQLStmtCacheFinalize() before sqlite3_close(), otherwise the close fails with SQLITE_BUSY.
+
+sqlite3_stmt *SQLStmtAcquire(sqlite3 *db, const char *SQL_cmd, char *calling_routine_str)
+   {
+   SQLStmtCacheStruct *SC_ptr = SQLStmtCacheGet();
+   SQLStmtCacheEntryStruct *entry_ptr;
+   sqlite3_stmt *pStmt;
+   unsigned int hash;
+   int entry_num, evict_num, found_busy;
+   int rc;
+
+   hash = SQLStmtHash(db, SQL_cmd);
+
+// The mutex is only contended while SQLStmtCacheFinalize() runs in another thread.
+   pthread_mutex_lock(&(SC_ptr->mutex));
+   SC_ptr->use_cnt++;
+   found_busy = 0;
+   for ( entry_num = SC_ptr->buckets[hash % SQL_STMT_CACHE_BUCKETS]; entry_num != -1; entry_num = entry_ptr->next )
+      {
+      entry_ptr = &(SC_ptr->entries[entry_num]);
+      if ( entry_ptr->hash == hash && entry_ptr->db == db && strcmp(entry_ptr->SQL_cmd, SQL_cmd) == 0 )
+         {
+         if ( entry_ptr->in_use == 1 )
+            {
+            found_busy = 1;
+            break;
+            }
+         entry_ptr->in_use = 1;
+         entry_ptr->last_used = SC_ptr->use_cnt;
+         pthread_mutex_unlock(&(SC_ptr->mutex));
+         return entry_ptr->pStmt;
+         }
+      }
+   pthread_mutex_unlock(&(SC_ptr->mutex));
+
+// Cache miss. Compile the statement without holding the cache mutex.
+   rc = sqlite3_prepare_v2(db, SQL_cmd, strlen(SQL_cmd) + 1, &pStmt, 0);
+   if ( rc != SQLITE_OK )
+      { 
+      printf("ERROR: %s: 'sqlite3_prepare_v2' failed with %d for '%s': %s\n", calling_routine_str, rc, SQL_cmd, sqlite3_errmsg(db)); 
+      exit(EXIT_FAILURE); 
+      }
+   if ( found_busy == 1 )
+      return pStmt;
+
+// Add it to the cache, replacing the least recently used free entry if the cache is full. 
+   pthread_mutex_lock(&(SC_ptr->mutex));
+   if ( SC_ptr->num_entries < SQL_STMT_CACHE_MAX )
+      entry_num = SC_ptr->num_entries++;
+   else
+      {
+      evict_num = -1;
+      for ( entry_num = 0; entry_num < SC_ptr->num_entries; entry_num++ )
+         if ( SC_ptr->entries[entry_num].in_use == 0 && (evict_num == -1 || SC_ptr->entries[entry_num].last_used < SC_ptr->entries[evict_num].last_used) )
+            evict_num = entry_num;
+      entry_num = evict_num;
+      if ( entry_num != -1 )
+         {
+         sqlite3_finalize(SC_ptr->entries[entry_num].pStmt);
+         free(SC_ptr->entries[entry_num].SQL_cmd);
+         }
+      }
+
+   if ( entry_num != -1 )
+      {
+      entry_ptr = &(SC_ptr->entries[entry_num]);
+      entry_ptr->db = db;
+      if ( (entry_ptr->SQL_cmd = (char *)malloc(strlen(SQL_cmd) + 1)) == NULL )
+         { printf("ERROR: %s: Failed to allocate storage for cached SQL command!\n", calling_routine_str); exit(EXIT_FAILURE); }
+      strcpy(entry_ptr->SQL_cmd, SQL_cmd);
+      entry_ptr->hash = hash;
+      entry_ptr->pStmt = pStmt;
+      entry_ptr->in_use = 1;
+      entry_ptr->last_used = SC_ptr->use_cnt;
+      SQLStmtCacheRehash(SC_ptr);
+      }
+   pthread_mutex_unlock(&(SC_ptr->mutex));
+
+#ifdef DEBUG
+printf("SQLStmtAcquire(): %s: Prepared '%s' in cache entry %d\n", calling_routine_str, SQL_cmd, entry_num); fflush(stdout);
+#endif
+
+   return pStmt;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Return a statement obtained from SQLStmtAcquire() by the same thread. The statement is reset and its bindings 
+// cleared so that no pointers to the caller's (SQLITE_STATIC) text or blob buffers are kept. Uncached statements 
+// are finalized.
+
+void SQLStmtRelease(sqlite3_stmt *pStmt)
+   {
+   SQLStmtCacheStruct *SC_ptr = SQLStmtCacheGet();
+   SQLStmtCacheEntryStruct *entry_ptr;
+   unsigned int hash;
+   int entry_num;
+
+// Errors from the last sqlite3_step() are returned again by sqlite3_reset(). The caller already handled them.
+   sqlite3_reset(pStmt);
+   sqlite3_clear_bindings(pStmt);
+
+// sqlite3_sql() returns the text the statement was prepared from, which hashes to the statement's bucket.
+   hash = SQLStmtHash(sqlite3_db_handle(pStmt), sqlite3_sql(pStmt));
+
+   pthread_mutex_lock(&(SC_ptr->mutex));
+   for ( entry_num = SC_ptr->buckets[hash % SQL_STMT_CACHE_BUCKETS]; entry_num != -1; entry_num = entry_ptr->next )
+      {
+      entry_ptr = &(SC_ptr->entries[entry_num]);
+      if ( entry_ptr->pStmt == pStmt )
+         break;
+      }
+   if ( entry_num != -1 )
+      SC_ptr->entries[entry_num].in_use = 0;
+   pthread_mutex_unlock(&(SC_ptr->mutex));
+
+   if ( entry_num == -1 )
+      sqlite3_finalize(pStmt);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Finalize the cached statements of every thread that belong to 'db' (or all of them if 'db' is NULL). MUST 
+// be called before sqlite3_close(). No statement for 'db' may be checked out when this is called.
+
+void SQLStmtCacheFinalize(sqlite3 *db)
+   {
+   SQLStmtCacheStruct *SC_ptr;
+   int entry_num, num_kept;
+
+   pthread_mutex_lock(&SQLStmtCache_registry_mutex);
+   for ( SC_ptr = SQLStmtCache_registry; SC_ptr != NULL; SC_ptr = SC_ptr->next )
+      {
+      pthread_mutex_lock(&(SC_ptr->mutex));
+      num_kept = 0;
+      for ( entry_num = 0; entry_num < SC_ptr->num_entries; entry_num++ )
+         {
+         if ( db == NULL || SC_ptr->entries[entry_num].db == db )
+            {
+            if ( SC_ptr->entries[entry_num].in_use == 1 )
+               { printf("ERROR: SQLStmtCacheFinalize(): Statement '%s' is still in use!\n", SC_ptr->entries[entry_num].SQL_cmd); exit(EXIT_FAILURE); }
+            sqlite3_finalize(SC_ptr->entries[entry_num].pStmt);
+            free(SC_ptr->entries[entry_num].SQL_cmd);
+            }
+         else
+            SC_ptr->entries[num_kept++] = SC_ptr->entries[entry_num];
+         }
+      SC_ptr->num_entries = num_kept;
+      SQLStmtCacheRehash(SC_ptr);
+      pthread_mutex_unlock(&(SC_ptr->mutex));
+      }
+   pthread_mutex_unlock(&SQLStmtCache_registry_mutex);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Typed bind routines for statements from SQLStmtAcquire(). Text and blobs are bound SQLITE_STATIC, so the 
+// caller's buffer MUST remain valid until SQLStmtRelease() is called.
+
+void SQLStmtBindInt(sqlite3_stmt *pStmt, int param_num, int val, char *calling_routine_str)
+   {
+   int rc;
+
+   if ( (rc = sqlite3_bind_int(pStmt, param_num, val)) != SQLITE_OK )
+      { printf("ERROR: %s: Failed to bind integer %d to parameter %d: %d\n", calling_routine_str, val, param_num, rc); exit(EXIT_FAILURE); }
+   return;
+   }
+
+void SQLStmtBindText(sqlite3_stmt *pStmt, int param_num, const char *text, char *calling_routine_str)
+   {
+   int rc;
+
+   if ( (rc = sqlite3_bind_text(pStmt, param_num, text, -1, SQLITE_STATIC)) != SQLITE_OK )
+      { printf("ERROR: %s: Failed to bind text to parameter %d: %d\n", calling_routine_str, param_num, rc); exit(EXIT_FAILURE); }
+   return;
+   }
+
+void SQLStmtBindBlob(sqlite3_stmt *pStmt, int param_num, const unsigned char *blob, int blob_size_bytes, char *calling_routine_str)
+   {
+   int rc;
+
+   if ( (rc = sqlite3_bind_blob(pStmt, param_num, blob, blob_size_bytes, SQLITE_STATIC)) != SQLITE_OK )
+      { printf("ERROR: %s: Failed to bind blob of %d bytes to parameter %d: %d\n", calling_routine_str, blob_size_bytes, param_num, rc); exit(EXIT_FAILURE); }
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Step a statement from SQLStmtAcquire(). Returns 1 when a row is available and 0 when the query is done.
+// Any other return code from sqlite3_step() is an error.
+
+int SQLStmtStep(sqlite3_stmt *pStmt, char *calling_routine_str)
+   {
+   int rc;
+
+   rc = sqlite3_step(pStmt);
+   if ( rc == SQLITE_ROW )
+      return 1;
+   else if ( rc == SQLITE_DONE )
+      return 0;
+
+   printf("ERROR: %s: Return code for 'sqlite3_step' not SQLITE_DONE or SQLITE_ROW => %d: %s\n", calling_routine_str, rc, 
+      sqlite3_errmsg(sqlite3_db_handle(pStmt))); 
+   exit(EXIT_FAILURE);
+
+   return -1;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Typed column routines for the current row of a statement from SQLStmtAcquire(). These replace the string
+// conversions done by GetRowResultInt(), GetRowResultFloat() and GetRowResultString().
+
+int SQLStmtColumnInt(sqlite3_stmt *pStmt, int col_index, char *calling_routine_str)
+   {
+   if ( sqlite3_column_type(pStmt, col_index) != SQLITE_INTEGER )
+      { printf("ERROR: %s: Column %d (%s) is not an integer!\n", calling_routine_str, col_index, sqlite3_column_name(pStmt, col_index)); exit(EXIT_FAILURE); }
+   return sqlite3_column_int(pStmt, col_index);
+   }
+
+float SQLStmtColumnFloat(sqlite3_stmt *pStmt, int col_index, char *calling_routine_str)
+   {
+   int col_type;
+
+   col_type = sqlite3_column_type(pStmt, col_index);
+   if ( col_type != SQLITE_INTEGER && col_type != SQLITE_FLOAT )
+      { printf("ERROR: %s: Column %d (%s) is not numeric!\n", calling_routine_str, col_index, sqlite3_column_name(pStmt, col_index)); exit(EXIT_FAILURE); }
+   return (float)sqlite3_column_double(pStmt, col_index);
+   }
+
+void SQLStmtColumnString(sqlite3_stmt *pStmt, int col_index, int required_string_len, int max_string_len, char *field_val_str, 
+   char *calling_routine_str)
+   {
+   const unsigned char *col_text;
+   int col_len;
+
+   if ( (col_text = sqlite3_column_text(pStmt, col_index)) == NULL )
+      { printf("ERROR: %s: Column %d (%s) is NULL!\n", calling_routine_str, col_index, sqlite3_column_name(pStmt, col_index)); exit(EXIT_FAILURE); }
+   col_len = sqlite3_column_bytes(pStmt, col_index);
+   if ( required_string_len != -1 && col_len != required_string_len )
+      { printf("ERROR: %s: Length of string %d expected to be %d\n", calling_routine_str, col_len, required_string_len); exit(EXIT_FAILURE); }
+   if ( col_len >= max_string_len )
+      { printf("ERROR: %s: Length of string %d exceeds buffer size %d\n", calling_routine_str, col_len, max_string_len); exit(EXIT_FAILURE); }
+   memcpy(field_val_str, col_text, col_len + 1);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Open and close an explicit transaction. Without one, every INSERT and UPDATE is its own autocommit 
+// transaction, which costs a journal sync per row on a filesystem database. NOTE: 'PRAGMA foreign_keys' 
+// is a no-op inside a transaction, so it MUST be set before calling SQLBeginTransaction().
+
+void SQLBeginTransaction(sqlite3 *db)
+   {
+   char *zErrMsg = 0;
+   int fc;
+
+   fc = sqlite3_exec(db, "BEGIN TRANSACTION;", NULL, 0, &zErrMsg);
+   if ( fc != SQLITE_OK )
+      { printf("ERROR: SQLBeginTransaction(): SQL ERROR: %s\n", zErrMsg); sqlite3_free(zErrMsg); exit(EXIT_FAILURE); }
+   return;
+   }
+
+void SQLCommitTransaction(sqlite3 *db)
+   {
+   char *zErrMsg = 0;
+   int fc;
+
+   fc = sqlite3_exec(db, "COMMIT;", NULL, 0, &zErrMsg);
+   if ( fc != SQLITE_OK )
+      { printf("ERROR: SQLCommitTransaction(): SQL ERROR: %s\n", zErrMsg); sqlite3_free(zErrMsg); exit(EXIT_FAILURE); }
+   return;
+   }
+
+
+
 // ===========================================================================================================
 // ===========================================================================================================
 // Got this from https://www.sqlite.org/backup.html. This function is used to load the contents of a database 
@@ -492,24 +918,17 @@ printf("GetAllocateListOfInts(): Called!\n"); fflush(stdout);
 
 void UpdateVecPairsNumPNsField(int max_string_len, sqlite3 *db, int num_vals_per_vecpair, int vecpair_index)
    {
-   char sql_command_str[max_string_len];
-   char *zErrMsg = 0;
-   int fc;
+   sqlite3_stmt *pStmt;
 
 #ifdef DEBUG
 printf("UpdateVecPairsNumPNsField(): Replacing NumPNs for vecpair_index %d with %d\n", vecpair_index, num_vals_per_vecpair); fflush(stdout);
 #endif
 
-   sprintf(sql_command_str, "UPDATE VecPairs SET NumPNs = %d WHERE id = %d;", num_vals_per_vecpair, vecpair_index);
-
-// 'sqlite3_exec' calls sqlite3_prepare_v2(), sqlite3_step(), and sqlite3_finalize(), and can process multiple ';' separated SQL statements. 
-// 'callback' function is called for each row produced in the result set. 4th arg is user-specified data. If an error occurs, 'zErrMesg' is 
-// filled in, otherwise is NULL (if error, it must be freed).
-
-// NOTE: There is no need to have a callback function (is NULL here) because 'UPDATE' does NOT return any result rows.
-   fc = sqlite3_exec(db, sql_command_str, NULL, 0, &zErrMsg);
-   if ( fc != SQLITE_OK )
-      { printf("SQL ERROR: %s\n", zErrMsg); sqlite3_free(zErrMsg); exit(EXIT_FAILURE); }
+   pStmt = SQLStmtAcquire(db, SQL_VecPairs_update_NumPNs_cmd, "UpdateVecPairsNumPNsField()");
+   SQLStmtBindInt(pStmt, 1, num_vals_per_vecpair, "UpdateVecPairsNumPNsField()");
+   SQLStmtBindInt(pStmt, 2, vecpair_index, "UpdateVecPairsNumPNsField()");
+   SQLStmtStep(pStmt, "UpdateVecPairsNumPNsField()");
+   SQLStmtRelease(pStmt);
 
    return;
    }
@@ -521,15 +940,15 @@ printf("UpdateVecPairsNumPNsField(): Replacing NumPNs for vecpair_index %d with
 
 int GetVecPairsNumPNsField(int max_string_len, sqlite3 *db, int vecpair_index)
    {
-   SQLRowStringsStruct row_strings_struct;
-   char sql_command_str[max_string_len];
+   sqlite3_stmt *pStmt;
    int num_PNs_per_vecpair = -1;
-   char *col1_name = "NumPNs";
 
-   sprintf(sql_command_str, "SELECT %s FROM VecPairs WHERE id = %d;", col1_name, vecpair_index);
-   GetStringsDataForRow(max_string_len, db, sql_command_str, &row_strings_struct);
-   GetRowResultInt(&row_strings_struct, "GetVecPairsNumPNsField()", 1, 0, col1_name, &num_PNs_per_vecpair);
-   FreeStringsDataForRow(&row_strings_struct);
+   pStmt = SQLStmtAcquire(db, SQL_VecPairs_get_NumPNs_cmd, "GetVecPairsNumPNsField()");
+   SQLStmtBindInt(pStmt, 1, vecpair_index, "GetVecPairsNumPNsField()");
+   if ( SQLStmtStep(pStmt, "GetVecPairsNumPNsField()") == 0 )
+      { printf("ERROR: GetVecPairsNumPNsField(): No VecPairs row for vecpair_index %d!\n", vecpair_index); exit(EXIT_FAILURE); }
+   num_PNs_per_vecpair = SQLStmtColumnInt(pStmt, 0, "GetVecPairsNumPNsField()");
+   SQLStmtRelease(pStmt);
 
 #ifdef DEBUG
 printf("GetVecPairsNumPNsField(): Got %d for NumPNs for vecpair_index %d\n", num_PNs_per_vecpair, vecpair_index); fflush(stdout);
@@ -545,30 +964,28 @@ printf("GetVecPairsNumPNsField(): Got %d for NumPNs for vecpair_index %d\n", num
 
 int GetVecPairsRiseFallStrField(int max_string_len, sqlite3 *db, int vecpair_index)
    {
-   SQLRowStringsStruct row_strings_struct;
-   char sql_command_str[max_string_len];
-   char rise_fall_str[max_string_len];
-   char *col1_name = "R_F_str";
+   sqlite3_stmt *pStmt;
+   char rise_fall_str[2];
 
-   sprintf(sql_command_str, "SELECT %s FROM VecPairs WHERE id = %d;", col1_name, vecpair_index);
-   row_strings_struct.num_cols = 0;
-   GetStringsDataForRow(max_string_len, db, sql_command_str, &row_strings_struct);
-   GetRowResultString(&row_strings_struct, "GetVecPairsRiseFallStrField()", 1, 0, col1_name, 1, rise_fall_str);
+   pStmt = SQLStmtAcquire(db, SQL_VecPairs_get_R_F_str_cmd, "GetVecPairsRiseFallStrField()");
+   SQLStmtBindInt(pStmt, 1, vecpair_index, "GetVecPairsRiseFallStrField()");
+   if ( SQLStmtStep(pStmt, "GetVecPairsRiseFallStrField()") == 0 )
+      { printf("ERROR: GetVecPairsRiseFallStrField(): No VecPairs row for vecpair_index %d!\n", vecpair_index); exit(EXIT_FAILURE); }
+   SQLStmtColumnString(pStmt, 0, 1, 2, rise_fall_str, "GetVecPairsRiseFallStrField()");
+   SQLStmtRelease(pStmt);
 
 #ifdef DEBUG
-printf("GetVecPairsNumPNsField(): Got %s for R_F_str for vecpair_index %d\n", row_strings_struct.ColStringVals[0], vecpair_index); fflush(stdout);
+printf("GetVecPairsRiseFallStrField(): Got %s for R_F_str for vecpair_index %d\n", rise_fall_str, vecpair_index); fflush(stdout);
 #endif
 
-   FreeStringsDataForRow(&row_strings_struct);
-
 // Sanity check on the expected value for this field.
-   if ( strcmp(rise_fall_str, "R") != 0 && strcmp(rise_fall_str, "F") != 0 )
+   if ( rise_fall_str[0] != 'R' && rise_fall_str[0] != 'F' )
       { 
-      printf("ERROR: GetVecPairsNumPNsField(): Expected to find 'R' or 'F', found %s instead!\n", rise_fall_str); 
+      printf("ERROR: GetVecPairsRiseFallStrField(): Expected to find 'R' or 'F', found %s instead!\n", rise_fall_str); 
       exit(EXIT_FAILURE); 
       }
 
-   if ( strcmp(rise_fall_str, "R") == 0 )
+   if ( rise_fall_str[0] == 'R' )
       return 0;
    else
       return 1;
@@ -581,22 +998,19 @@ printf("GetVecPairsNumPNsField(): Got %s for R_F_str for vecpair_index %d\n", ro
 
 void UpdateChallengesNumVecFields(int max_string_len, sqlite3 *db, int challenge_index, int tot_vecs, int tot_rise_vecs)
    {
-   char sql_command_str[max_string_len];
-   char *zErrMsg = 0;
-   int fc;
+   sqlite3_stmt *pStmt;
 
 #ifdef DEBUG
 printf("UpdateChallengesNumVecFields(): Replacing NumVecs and NumRiseVecs for challenge %d with %d and %d\n", challenge_index, 
    tot_vecs, tot_rise_vecs); fflush(stdout);
 #endif
 
-   sprintf(sql_command_str, "UPDATE Challenges SET NumVecs = %d, NumRiseVecs = %d WHERE id = %d;", tot_vecs, tot_rise_vecs, 
-      challenge_index);
-
-// NOTE: There is no need to have a callback function (is NULL here) because 'UPDATE' does NOT return any result rows.
-   fc = sqlite3_exec(db, sql_command_str, NULL, 0, &zErrMsg);
-   if ( fc != SQLITE_OK )
-      { printf("SQL ERROR: %s\n", zErrMsg); sqlite3_free(zErrMsg); exit(EXIT_FAILURE); }
+   pStmt = SQLStmtAcquire(db, SQL_Challenges_update_NumVecs_cmd, "UpdateChallengesNumVecFields()");
+   SQLStmtBindInt(pStmt, 1, tot_vecs, "UpdateChallengesNumVecFields()");
+   SQLStmtBindInt(pStmt, 2, tot_rise_vecs, "UpdateChallengesNumVecFields()");
+   SQLStmtBindInt(pStmt, 3, challenge_index, "UpdateChallengesNumVecFields()");
+   SQLStmtStep(pStmt, "UpdateChallengesNumVecFields()");
+   SQLStmtRelease(pStmt);
 
    return;
    }
@@ -608,22 +1022,19 @@ printf("UpdateChallengesNumVecFields(): Replacing NumVecs and NumRiseVecs for ch
 
 void UpdateChallengesNumPNFields(int max_string_len, sqlite3 *db, int challenge_index, int tot_PNs, int tot_rise_PNs)
    {
-   char sql_command_str[max_string_len];
-   char *zErrMsg = 0;
-   int fc;
+   sqlite3_stmt *pStmt;
 
 #ifdef DEBUG
 printf("UpdateChallengesNumPNFields(): Replacing NumPNs and NumRisePNs for challenge %d with %d and %d\n", challenge_index, 
    tot_PNs, tot_rise_PNs); fflush(stdout);
 #endif
 
-   sprintf(sql_command_str, "UPDATE Challenges SET NumPNs = %d, NumRisePNs = %d WHERE id = %d;", tot_PNs, tot_rise_PNs, 
-      challenge_index);
-
-// NOTE: There is no need to have a callback function (is NULL here) because 'UPDATE' does NOT return any result rows.
-   fc = sqlite3_exec(db, sql_command_str, NULL, 0, &zErrMsg);
-   if ( fc != SQLITE_OK )
-      { printf("SQL ERROR: %s\n", zErrMsg); sqlite3_free(zErrMsg); exit(EXIT_FAILURE); }
+   pStmt = SQLStmtAcquire(db, SQL_Challenges_update_NumPNs_cmd, "UpdateChallengesNumPNFields()");
+   SQLStmtBindInt(pStmt, 1, tot_PNs, "UpdateChallengesNumPNFields()");
+   SQLStmtBindInt(pStmt, 2, tot_rise_PNs, "UpdateChallengesNumPNFields()");
+   SQLStmtBindInt(pStmt, 3, challenge_index, "UpdateChallengesNumPNFields()");
+   SQLStmtStep(pStmt, "UpdateChallengesNumPNFields()");
+   SQLStmtRelease(pStmt);
 
    return;
    }
@@ -636,21 +1047,17 @@ printf("UpdateChallengesNumPNFields(): Replacing NumPNs and NumRisePNs for chall
 void GetChallengeNumVecsNumPNs(int max_string_len, sqlite3 *db, int *num_vecpairs_ptr, int *num_rising_vecpairs_ptr,
    int *num_PNs_ptr, int *num_rising_PNs_ptr, int challenge_index)
    {
-   SQLRowStringsStruct row_strings_struct;
-   char sql_command_str[max_string_len];
-   char *col1_name = "NumVecs";
-   char *col2_name = "NumRiseVecs";
-   char *col3_name = "NumPNs";
-   char *col4_name = "NumRisePNs";
-
-   sprintf(sql_command_str, "SELECT %s, %s, %s, %s FROM Challenges WHERE id = %d;", col1_name, col2_name, col3_name, col4_name, 
-      challenge_index);
-   GetStringsDataForRow(max_string_len, db, sql_command_str, &row_strings_struct);
-   GetRowResultInt(&row_strings_struct, "GetChallengeNumVecsNumPNs()", 4, 0, col1_name, num_vecpairs_ptr);
-   GetRowResultInt(&row_strings_struct, "GetChallengeNumVecsNumPNs()", 4, 1, col2_name, num_rising_vecpairs_ptr);
-   GetRowResultInt(&row_strings_struct, "GetChallengeNumVecsNumPNs()", 4, 2, col3_name, num_PNs_ptr);
-   GetRowResultInt(&row_strings_struct, "GetChallengeNumVecsNumPNs()", 4, 3, col4_name, num_rising_PNs_ptr);
-   FreeStringsDataForRow(&row_strings_struct);
+   sqlite3_stmt *pStmt;
+
+   pStmt = SQLStmtAcquire(db, SQL_Challenges_get_NumVecs_NumPNs_cmd, "GetChallengeNumVecsNumPNs()");
+   SQLStmtBindInt(pStmt, 1, challenge_index, "GetChallengeNumVecsNumPNs()");
+   if ( SQLStmtStep(pStmt, "GetChallengeNumVecsNumPNs()") == 0 )
+      { printf("ERROR: GetChallengeNumVecsNumPNs(): No Challenges row for challenge index %d!\n", challenge_index); exit(EXIT_FAILURE); }
+   *num_vecpairs_ptr = SQLStmtColumnInt(pStmt, 0, "GetChallengeNumVecsNumPNs()");
+   *num_rising_vecpairs_ptr = SQLStmtColumnInt(pStmt, 1, "GetChallengeNumVecsNumPNs()");
+   *num_PNs_ptr = SQLStmtColumnInt(pStmt, 2, "GetChallengeNumVecsNumPNs()");
+   *num_rising_PNs_ptr = SQLStmtColumnInt(pStmt, 3, "GetChallengeNumVecsNumPNs()");
+   SQLStmtRelease(pStmt);
 
 #ifdef DEBUG
 printf("GetChallengeNumVecsNumPNs(): Got num_vecpairs %d, num_rising_vecpairs %d, num_PNs %d and num_rising_PNs %d for Challenge index %d\n", 
@@ -693,17 +1100,23 @@ void GetChallengeParams(int max_string_len, sqlite3 *db, char *ChallengeSetName,
 
 float GetTimingValsAveField(int max_string_len, sqlite3 *db, int PUF_instance_index, int vecpair_index, int PO_num)
    {
-   SQLRowStringsStruct row_strings_struct;
-   char sql_command_str[max_string_len];
-   char *col1_name = "Ave";
-   float ave_val; 
-
-   sprintf(sql_command_str, "SELECT %s FROM TimingVals WHERE PUFInstance = %d AND VecPair = %d AND PO = %d;", col1_name, 
-      PUF_instance_index, vecpair_index, PO_num);
+   sqlite3_stmt *pStmt;
+   float ave_val;
 
-   GetStringsDataForRow(max_string_len, db, sql_command_str, &row_strings_struct);
-   GetRowResultFloat(&row_strings_struct, "GetTimingValsAveField()", 1, 0, col1_name, &ave_val);
-   FreeStringsDataForRow(&row_strings_struct);
+   pStmt = SQLStmtAcquire(db, SQL_TimingVals_get_Ave_cmd, "GetTimingValsAveField()");
+   SQLStmtBindInt(pStmt, 1, PUF_instance_index, "GetTimingValsAveField()");
+   SQLStmtBindInt(pStmt, 2, vecpair_index, "GetTimingValsAveField()");
+   SQLStmtBindInt(pStmt, 3, PO_num, "GetTimingValsAveField()");
+   if ( SQLStmtStep(pStmt, "GetTimingValsAveField()") == 0 )
+      { 
+      printf("ERROR: GetTimingValsAveField(): No TimingVals row for PUFInstance ID %d, vecpair index %d, PO %d!\n", PUF_instance_index, 
+         vecpair_index, PO_num); 
+      exit(EXIT_FAILURE); 
+      }
+   ave_val = SQLStmtColumnFloat(pStmt, 0, "GetTimingValsAveField()");
+   if ( SQLStmtStep(pStmt, "GetTimingValsAveField()") == 1 )
+      { printf("ERROR: GetTimingValsAveField(): More than 1 row matched in table!\n"); exit(EXIT_FAILURE); }
+   SQLStmtRelease(pStmt);
 
 // FIXED POINT
    ave_val /= 16.0;
@@ -725,18 +1138,25 @@ printf("GetTimingValsAveField(): Got %f for Ave for PUFInstance ID %d, vecpair i
 
 float GetTimingValsTSigField(int max_string_len, sqlite3 *db, int PUF_instance_index, int vecpair_index, int PO_num)
    {
-   SQLRowStringsStruct row_strings_struct;
-   char sql_command_str[max_string_len];
+   sqlite3_stmt *pStmt;
    float tsig_val = -1.0;
-   char *col1_name = "TSig";
 
-   sprintf(sql_command_str, "SELECT %s FROM TimingVals WHERE PUFInstance = %d AND VecPair = %d AND PO = %d;", col1_name, 
-      PUF_instance_index, vecpair_index, PO_num);
-   row_strings_struct.num_cols = 0;
-   GetStringsDataForRow(max_string_len, db, sql_command_str, &row_strings_struct);
-   GetRowResultFloat(&row_strings_struct, "GetTimingValsTSigField()", 1, 0, col1_name, &tsig_val);
-   FreeStringsDataForRow(&row_strings_struct);
+   pStmt = SQLStmtAcquire(db, SQL_TimingVals_get_TSig_cmd, "GetTimingValsTSigField()");
+   SQLStmtBindInt(pStmt, 1, PUF_instance_index, "GetTimingValsTSigField()");
+   SQLStmtBindInt(pStmt, 2, vecpair_index, "GetTimingValsTSigField()");
+   SQLStmtBindInt(pStmt, 3, PO_num, "GetTimingValsTSigField()");
+   if ( SQLStmtStep(pStmt, "GetTimingValsTSigField()") == 0 )
+      { 
+      printf("ERROR: GetTimingValsTSigField(): No TimingVals row for PUFInstance ID %d, vecpair index %d, PO %d!\n", PUF_instance_index, 
+         vecpair_index, PO_num); 
+      exit(EXIT_FAILURE); 
+      }
+   tsig_val = SQLStmtColumnFloat(pStmt, 0, "GetTimingValsTSigField()");
+   if ( SQLStmtStep(pStmt, "GetTimingValsTSigField()") == 1 )
+      { printf("ERROR: GetTimingValsTSigField(): More than 1 row matched in table!\n"); exit(EXIT_FAILURE); }
+   SQLStmtRelease(pStmt);
 
+// FIXED POINT
    tsig_val /= 16.0;
 
 #ifdef DEBUG
@@ -776,19 +1196,16 @@ void GetPUFInstanceIDsForInstanceName(int max_string_len, sqlite3 *db, SQLIntStr
 void GetPUFInstanceInfoForID(int max_string_len, sqlite3 *db, int PUFInstance_id, char *Instance_name, char *Dev, 
    char *Placement)
    {
-   SQLRowStringsStruct row_strings_struct;
-   char sql_command_str[max_string_len];
-   char *col1_name = "Instance_name";
-   char *col2_name = "Dev";
-   char *col3_name = "Placement";
-
-   sprintf(sql_command_str, "SELECT %s, %s, %s FROM PUFInstance WHERE id = %d;", col1_name, col2_name, col3_name, PUFInstance_id);
-   GetStringsDataForRow(max_string_len, db, sql_command_str, &row_strings_struct);
+   sqlite3_stmt *pStmt;
 
-   GetRowResultString(&row_strings_struct, "GetPUFInstanceInfoForID", 3, 0, col1_name, -1, Instance_name);
-   GetRowResultString(&row_strings_struct, "GetPUFInstanceInfoForID", 3, 1, col2_name, -1, Dev);
-   GetRowResultString(&row_strings_struct, "GetPUFInstanceInfoForID", 3, 2, col3_name, -1, Placement);
-   FreeStringsDataForRow(&row_strings_struct);
+   pStmt = SQLStmtAcquire(db, SQL_PUFInstance_get_info_cmd, "GetPUFInstanceInfoForID()");
+   SQLStmtBindInt(pStmt, 1, PUFInstance_id, "GetPUFInstanceInfoForID()");
+   if ( SQLStmtStep(pStmt, "GetPUFInstanceInfoForID()") == 0 )
+      { printf("ERROR: GetPUFInstanceInfoForID(): No PUFInstance row for ID %d!\n", PUFInstance_id); exit(EXIT_FAILURE); }
+   SQLStmtColumnString(pStmt, 0, -1, max_string_len, Instance_name, "GetPUFInstanceInfoForID()");
+   SQLStmtColumnString(pStmt, 1, -1, max_string_len, Dev, "GetPUFInstanceInfoForID()");
+   SQLStmtColumnString(pStmt, 2, -1, max_string_len, Placement, "GetPUFInstanceInfoForID()");
+   SQLStmtRelease(pStmt);
 
    return;
    }
@@ -800,16 +1217,15 @@ void GetPUFInstanceInfoForID(int max_string_len, sqlite3 *db, int PUFInstance_id
 
 void GetPUFDesignNumPIPOFields(int max_string_len, sqlite3 *db, int *num_PIs_ptr, int *num_POs_ptr, int design_index)
    {
-   SQLRowStringsStruct row_strings_struct;
-   char sql_command_str[max_string_len];
-   char *col1_name = "num_PIs";
-   char *col2_name = "num_POs";
+   sqlite3_stmt *pStmt;
 
-   sprintf(sql_command_str, "SELECT %s, %s FROM PUFDesign WHERE id = %d;", col1_name, col2_name, design_index);
-   GetStringsDataForRow(max_string_len, db, sql_command_str, &row_strings_struct);
-   GetRowResultInt(&row_strings_struct, "GetPUFDesignNumPIPOFields()", 2, 0, col1_name, num_PIs_ptr);
-   GetRowResultInt(&row_strings_struct, "GetPUFDesignNumPIPOFields()", 2, 1, col2_name, num_POs_ptr);
-   FreeStringsDataForRow(&row_strings_struct);
+   pStmt = SQLStmtAcquire(db, SQL_PUFDesign_get_num_PIs_POs_cmd, "GetPUFDesignNumPIPOFields()");
+   SQLStmtBindInt(pStmt, 1, design_index, "GetPUFDesignNumPIPOFields()");
+   if ( SQLStmtStep(pStmt, "GetPUFDesignNumPIPOFields()") == 0 )
+      { printf("ERROR: GetPUFDesignNumPIPOFields(): No PUFDesign row for design index %d!\n", design_index); exit(EXIT_FAILURE); }
+   *num_PIs_ptr = SQLStmtColumnInt(pStmt, 0, "GetPUFDesignNumPIPOFields()");
+   *num_POs_ptr = SQLStmtColumnInt(pStmt, 1, "GetPUFDesignNumPIPOFields()");
+   SQLStmtRelease(pStmt);
 
 #ifdef DEBUG
 printf("GetPUFDesignNumPIPOFields(): Got num_PIs %d and num_POs %d for PUFDesign index %d\n", *num_PIs_ptr, *num_POs_ptr, design_index); fflush(stdout);
@@ -864,55 +1280,43 @@ int ReadBinaryBlob(sqlite3 *db, const char *sql_command_str, int id, unsigned ch
       binary_blob[0] = '\0';
       }
 
-// Compile the SELECT statement into a virtual machine.
-   do 
-      {
-      rc = sqlite3_prepare_v2(db, sql_command_str, strlen(sql_command_str) + 1, &pStmt, 0);
-      if( rc != SQLITE_OK )
-         { printf("ERROR: ReadBinaryBlob(): 'sqlite3_prepare_v2' failed\n"); exit(EXIT_FAILURE); }
-
-// Bind the Blob, e.g., binary vector, to the SQL variable.
-      sqlite3_bind_int(pStmt, 1, id);
+// Get the prepared SELECT statement from the statement cache and bind the id to the SQL variable.
+   pStmt = SQLStmtAcquire(db, sql_command_str, "ReadBinaryBlob()");
+   SQLStmtBindInt(pStmt, 1, id, "ReadBinaryBlob()");
 
 // Run the virtual machine. The SQL statement prepared MUST return at most 1 row of data since we call sqlite3_step() ONLY once
 // here. Normally, we would keep calling sqlite3_step until it returned something other than SQLITE_ROW, e.g., SQLITE_DONE. 
 // Multiple kinds of errors can occur as well -- see doc.
-      rc = sqlite3_step(pStmt);
-      if ( rc == SQLITE_ROW )
-         {
+   rc = sqlite3_step(pStmt);
+   if ( rc == SQLITE_ROW )
+      {
 
 // The pointer returned by sqlite3_column_blob() points to memory that is owned by the statement handle (pStmt). It is only good
-// until the next call to an sqlite3_XXX() function (e.g. the sqlite3_finalize() below) that involves the statement handle. 
+// until the next call to an sqlite3_XXX() function (e.g. the SQLStmtRelease() below) that involves the statement handle. 
 // So we need to make a copy of the blob into memory obtained from malloc() to return to the caller.
-         num_bytes_binary_blob = sqlite3_column_bytes(pStmt, 0);
+      num_bytes_binary_blob = sqlite3_column_bytes(pStmt, 0);
 
 // Added 5/3/2019 for HOST
-         if ( allocate_storage == 0 )
-            {
-            if ( num_bytes_binary_blob != expected_size )
-               { printf("ERROR: ReadBinaryBlob(): UNEXPECTED return size from vector! %d vs expected %d\n", num_bytes_binary_blob, expected_size); exit(EXIT_FAILURE); }
-            memcpy(binary_blob, sqlite3_column_blob(pStmt, 0), num_bytes_binary_blob);
-            }
-         else 
-            {
-            if ( (*binary_blob_ptr = (unsigned char *)calloc(num_bytes_binary_blob, sizeof(unsigned char))) == NULL )
-               { printf("ReadBinaryBlob(): ERROR: Failed to allocate storage for binary_blob of %d bytes\n", num_bytes_binary_blob); exit(EXIT_FAILURE); }
-            memcpy(*binary_blob_ptr, sqlite3_column_blob(pStmt, 0), num_bytes_binary_blob);
-            }
+      if ( allocate_storage == 0 )
+         {
+         if ( num_bytes_binary_blob != expected_size )
+            { printf("ERROR: ReadBinaryBlob(): UNEXPECTED return size from vector! %d vs expected %d\n", num_bytes_binary_blob, expected_size); exit(EXIT_FAILURE); }
+         memcpy(binary_blob, sqlite3_column_blob(pStmt, 0), num_bytes_binary_blob);
          }
+      else 
+         {
+         if ( (*binary_blob_ptr = (unsigned char *)calloc(num_bytes_binary_blob, sizeof(unsigned char))) == NULL )
+            { printf("ReadBinaryBlob(): ERROR: Failed to allocate storage for binary_blob of %d bytes\n", num_bytes_binary_blob); exit(EXIT_FAILURE); }
+         memcpy(*binary_blob_ptr, sqlite3_column_blob(pStmt, 0), num_bytes_binary_blob);
+         }
+      }
 
 // NOT the only possibility, SQLITE_BUSY, SQLITE_DONE, etc. are possible.
-      else
-         { printf("ReadBinaryBlob(): ERROR: UNEXPECTED return value for sqlite3_step() -- More than one row in the results perhaps? %d\n", rc); exit(EXIT_FAILURE); }
-
-// Finalize the statement (this releases resources allocated by sqlite3_prepare() ).
-      rc = sqlite3_finalize(pStmt);
-
-// If sqlite3_finalize() returned SQLITE_SCHEMA, then try to execute the statement all over again.
-      } while( rc == SQLITE_SCHEMA );
+   else
+      { printf("ReadBinaryBlob(): ERROR: UNEXPECTED return value for sqlite3_step() -- More than one row in the results perhaps? %d\n", rc); exit(EXIT_FAILURE); }
 
-   if ( rc != SQLITE_OK )
-      { printf("ReadBinaryBlob(): ERROR: Some other error condition %d\n", rc); exit(EXIT_FAILURE); }
+// Reset the statement and return it to the cache.
+   SQLStmtRelease(pStmt);
 
    return num_bytes_binary_blob;
    }
@@ -926,47 +1330,45 @@ int GetIndexFromTable(int max_string_len, sqlite3 *db, char *Table, const char *
    int blob_size_bytes, char *text1, char *text2, char *text3, char *text4, int int1, int int2, int int3)
    {
    sqlite3_stmt *pStmt;
-   int rc, fc;
+   int rc;
    int index;
 
 #ifdef DEBUG
 printf("GetIndexFromTable(): SQL cmd %s\n", SQL_cmd); fflush(stdout);
 #endif
 
-// Prepare 'pStmt' with SQL query.
-   rc = sqlite3_prepare_v2(db, SQL_cmd, strlen(SQL_cmd) + 1, &pStmt, 0);
-   if( rc != SQLITE_OK )
-      { printf("ERROR: GetIndexFromTable(): 'sqlite3_prepare_v2' failed with %d\n", rc); exit(EXIT_FAILURE); }
+// Get the prepared statement for 'SQL_cmd' from the statement cache.
+   pStmt = SQLStmtAcquire(db, SQL_cmd, "GetIndexFromTable()");
 
 // Bind the variables to '?' in 'SQL_cmd'.
    if ( strcmp(Table, "PUFDesign") == 0 )
       {
-      sqlite3_bind_text(pStmt, 1, text1, -1, SQLITE_STATIC);
-      sqlite3_bind_text(pStmt, 2, text2, -1, SQLITE_STATIC);
+      SQLStmtBindText(pStmt, 1, text1, "GetIndexFromTable()");
+      SQLStmtBindText(pStmt, 2, text2, "GetIndexFromTable()");
       }
    else if ( strcmp(Table, "PUFInstance") == 0 )
       {
-      sqlite3_bind_text(pStmt, 1, text1, -1, SQLITE_STATIC);
-      sqlite3_bind_text(pStmt, 2, text2, -1, SQLITE_STATIC);
-      sqlite3_bind_text(pStmt, 3, text3, -1, SQLITE_STATIC);
+      SQLStmtBindText(pStmt, 1, text1, "GetIndexFromTable()");
+      SQLStmtBindText(pStmt, 2, text2, "GetIndexFromTable()");
+      SQLStmtBindText(pStmt, 3, text3, "GetIndexFromTable()");
       }
    else if ( strcmp(Table, "VecPairs") == 0 )
       {
-      sqlite3_bind_int(pStmt, 1, int1);
-      sqlite3_bind_int(pStmt, 2, int2);
-      sqlite3_bind_int(pStmt, 3, int3);
+      SQLStmtBindInt(pStmt, 1, int1, "GetIndexFromTable()");
+      SQLStmtBindInt(pStmt, 2, int2, "GetIndexFromTable()");
+      SQLStmtBindInt(pStmt, 3, int3, "GetIndexFromTable()");
       }
    else if ( strcmp(Table, "Vectors") == 0 )
-      sqlite3_bind_blob(pStmt, 1, blob, blob_size_bytes, SQLITE_STATIC);
+      SQLStmtBindBlob(pStmt, 1, blob, blob_size_bytes, "GetIndexFromTable()");
    else if ( strcmp(Table, "PathSelectMasks") == 0 )
-      sqlite3_bind_text(pStmt, 1, text1, -1, SQLITE_STATIC);
+      SQLStmtBindText(pStmt, 1, text1, "GetIndexFromTable()");
    else if ( strcmp(Table, "Challenges") == 0 )
-      sqlite3_bind_text(pStmt, 1, text1, -1, SQLITE_STATIC);
+      SQLStmtBindText(pStmt, 1, text1, "GetIndexFromTable()");
    else if ( strcmp(Table, "ChallengeVecPairs") == 0 )
       {
-      sqlite3_bind_int(pStmt, 1, int1);
-      sqlite3_bind_int(pStmt, 2, int2);
-      sqlite3_bind_int(pStmt, 3, int3);
+      SQLStmtBindInt(pStmt, 1, int1, "GetIndexFromTable()");
+      SQLStmtBindInt(pStmt, 2, int2, "GetIndexFromTable()");
+      SQLStmtBindInt(pStmt, 3, int3, "GetIndexFromTable()");
       }
    else
       { printf("ERROR: GetIndexFromTable(): Unknown Table '%s'\n", Table); exit(EXIT_FAILURE); }
@@ -983,8 +1385,7 @@ printf("GetIndexFromTable(): Table '%s', Column type %d => Integer type %d\n", T
 
    index = sqlite3_column_int64(pStmt, 0);
 
-   if ( (fc = sqlite3_finalize(pStmt)) != 0 )
-      { printf("ERROR: GetIndexFromTable(): Finalize failed %d for Table '%s'\n", fc, Table); exit(EXIT_FAILURE); }
+   SQLStmtRelease(pStmt);
 
 // Classify the return code. 'DONE' means search failed while 'ROW' means it found the item.
    if ( rc == SQLITE_DONE )
@@ -1012,78 +1413,74 @@ int InsertIntoTable(int max_string_len, sqlite3 *db, char *Table, const char *SQ
    int int3, int int4, int int5, float float1, float float2)
    {
    sqlite3_stmt *pStmt;
-   int rc, fc;
+   int rc;
 
 #ifdef DEBUG
 printf("InsertIntoTable(): SQL cmd %s\n", SQL_cmd); fflush(stdout);
 #endif
 
-// Prepare 'pStmt' with SQL query.
-   rc = sqlite3_prepare_v2(db, SQL_cmd, strlen(SQL_cmd) + 1, &pStmt, 0);
-   if( rc != SQLITE_OK )
-      { printf("ERROR: InsertIntoTable(): 'sqlite3_prepare_v2' failed with %d\n", rc); exit(EXIT_FAILURE); }
+// Get the prepared statement for 'SQL_cmd' from the statement cache.
+   pStmt = SQLStmtAcquire(db, SQL_cmd, "InsertIntoTable()");
 
 // Insert the Netlist_name into PUFDesign
    if ( strcmp(Table, "PUFDesign") == 0 )
       {
-      sqlite3_bind_text(pStmt, 1, text1, -1, SQLITE_STATIC);
-      sqlite3_bind_text(pStmt, 2, text2, -1, SQLITE_STATIC);
-      sqlite3_bind_int(pStmt, 3, int1);
-      sqlite3_bind_int(pStmt, 4, int2);
+      SQLStmtBindText(pStmt, 1, text1, "InsertIntoTable()");
+      SQLStmtBindText(pStmt, 2, text2, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 3, int1, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 4, int2, "InsertIntoTable()");
       }
    else if ( strcmp(Table, "PUFInstance") == 0 )
       {
-      sqlite3_bind_text(pStmt, 1, text1, -1, SQLITE_STATIC);
-      sqlite3_bind_text(pStmt, 2, text2, -1, SQLITE_STATIC);
-      sqlite3_bind_text(pStmt, 3, text3, -1, SQLITE_STATIC);
-      sqlite3_bind_text(pStmt, 4, text4, -1, SQLITE_STATIC);
-      sqlite3_bind_int(pStmt, 5, int1);
+      SQLStmtBindText(pStmt, 1, text1, "InsertIntoTable()");
+      SQLStmtBindText(pStmt, 2, text2, "InsertIntoTable()");
+      SQLStmtBindText(pStmt, 3, text3, "InsertIntoTable()");
+      SQLStmtBindText(pStmt, 4, text4, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 5, int1, "InsertIntoTable()");
       }
    else if ( strcmp(Table, "VecPairs") == 0 )
       {
-      sqlite3_bind_text(pStmt, 1, text1, -1, SQLITE_STATIC);
-      sqlite3_bind_int(pStmt, 2, int1);
-      sqlite3_bind_int(pStmt, 3, int2);
-      sqlite3_bind_int(pStmt, 4, int3);
-      sqlite3_bind_int(pStmt, 5, int4);
+      SQLStmtBindText(pStmt, 1, text1, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 2, int1, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 3, int2, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 4, int3, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 5, int4, "InsertIntoTable()");
       }
 
 // FIXED POINT. On 9/28/2018, I converted the 'real' fields (double) here to scaled integer to save space. Note that there
 // was a bug prior to this where I wasn't actually storing the 3 sigma value (TSig) but rather the Ave value twice...
    else if ( strcmp(Table, "TimingTable") == 0 )
       {
-      sqlite3_bind_int(pStmt, 1, int1);
-      sqlite3_bind_int(pStmt, 2, int2);
-      sqlite3_bind_int(pStmt, 3, (int)(float1*16.0));
-      sqlite3_bind_int(pStmt, 4, (int)(float2*16.0));
-      sqlite3_bind_int(pStmt, 5, int3);
+      SQLStmtBindInt(pStmt, 1, int1, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 2, int2, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 3, (int)(float1*16.0), "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 4, (int)(float2*16.0), "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 5, int3, "InsertIntoTable()");
       }
    else if ( strcmp(Table, "Challenges") == 0 )
       {
-      sqlite3_bind_text(pStmt, 1, text1, -1, SQLITE_STATIC);
-      sqlite3_bind_int(pStmt, 2, int1);
-      sqlite3_bind_int(pStmt, 3, int2);
-      sqlite3_bind_int(pStmt, 4, int3);
-      sqlite3_bind_int(pStmt, 5, int4);
-      sqlite3_bind_int(pStmt, 6, int5);
+      SQLStmtBindText(pStmt, 1, text1, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 2, int1, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 3, int2, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 4, int3, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 5, int4, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 6, int5, "InsertIntoTable()");
       }
    else if ( strcmp(Table, "Vectors") == 0 )
-      sqlite3_bind_blob(pStmt, 1, vector, vector_size_bytes, SQLITE_STATIC);
+      SQLStmtBindBlob(pStmt, 1, vector, vector_size_bytes, "InsertIntoTable()");
    else if ( strcmp(Table, "PathSelectMasks") == 0 )
-      sqlite3_bind_text(pStmt, 1, text1, -1, SQLITE_STATIC);
+      SQLStmtBindText(pStmt, 1, text1, "InsertIntoTable()");
    else if ( strcmp(Table, "ChallengeVecPairs") == 0 )
       {
-      sqlite3_bind_int(pStmt, 1, int1);
-      sqlite3_bind_int(pStmt, 2, int2);
-      sqlite3_bind_int(pStmt, 3, int3);
+      SQLStmtBindInt(pStmt, 1, int1, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 2, int2, "InsertIntoTable()");
+      SQLStmtBindInt(pStmt, 3, int3, "InsertIntoTable()");
       }
    else
       { printf("ERROR: InsertIntoTable(): Unknown Table '%s'\n", Table); exit(EXIT_FAILURE); }
 
    rc = sqlite3_step(pStmt);
-
-   if ( (fc = sqlite3_finalize(pStmt)) != 0 && fc != SQLITE_CONSTRAINT )
-      { printf("ERROR: InsertIntoTable(): Finalize failed %d for Table '%s'\n", fc, Table); exit(EXIT_FAILURE); }
+   SQLStmtRelease(pStmt);
 
 // FIX ME AT SOME POINT. Return 1 if successful and 0 if unsuccessful (flip these around -- did this for 
 // InsertIntoTable_RT in PUFCash V3.0).
@@ -1451,18 +1848,13 @@ printf("\tReadChipEnrollPNs(): Num PNR %d\tNum PNF %d\tNum sams %d\n", num_PNR,
 int DeletePUFInstance(int max_string_len, sqlite3 *db, const char *SQL_cmd, int instance_index)
    {
    sqlite3_stmt *pStmt;
-   int rc, fc;
-
-// Prepare 'pStmt' with SQL query.
-   rc = sqlite3_prepare_v2(db, SQL_cmd, strlen(SQL_cmd) + 1, &pStmt, 0);
-   if( rc != SQLITE_OK )
-      { printf("ERROR: DeletePUFInstance(): 'sqlite3_prepare_v2' failed with %d\n", rc); exit(EXIT_FAILURE); }
+   int rc;
 
-   sqlite3_bind_int(pStmt, 1, instance_index);
+   pStmt = SQLStmtAcquire(db, SQL_cmd, "DeletePUFInstance()");
+   SQLStmtBindInt(pStmt, 1, instance_index, "DeletePUFInstance()");
 
    rc = sqlite3_step(pStmt);
-   if ( (fc = sqlite3_finalize(pStmt)) != 0 && fc != SQLITE_CONSTRAINT )
-      { printf("ERROR: DeletePUFInstance(): Finalize failed %d\n", fc); exit(EXIT_FAILURE); }
+   SQLStmtRelease(pStmt);
 
    if ( rc == SQLITE_DONE )
       return 0;
@@ -1593,6 +1985,8 @@ int AddTimingDataToDB(int max_string_len, sqlite3 *db, const char *SQL_TimingVal
    int *POs, int num_PNR, int num_PNX, int master_num_rise_vec_pairs, int num_POs)
    {
    int num_PNs_per_vecpair, PN_num;
+   sqlite3_stmt *pStmt;
+   int rc;
 
 // 'vec_pair_num' corresponds to the number stored in the enrollment data file under 'V:', which is stored in the 'vec_pairs' 
 // array.  Keep adding timing values until the value for an array element in 'vecpairs' is not equal to 'vec_pair_num'.
@@ -1601,6 +1995,9 @@ int AddTimingDataToDB(int max_string_len, sqlite3 *db, const char *SQL_TimingVal
    while ( PN_num < num_PNX && vec_pair_num != vec_pairs[PN_num] )
       PN_num++;
 
+// The INSERT is bound and stepped once per timing value on the same prepared statement.
+   pStmt = SQLStmtAcquire(db, SQL_TimingVals_insert_into_cmd, "AddTimingDataToDB()");
+
    num_PNs_per_vecpair = 0;
    while ( PN_num < num_PNX && vec_pair_num == vec_pairs[PN_num] )
       {
@@ -1619,10 +2016,17 @@ int AddTimingDataToDB(int max_string_len, sqlite3 *db, const char *SQL_TimingVal
             vec_pair_num, PN_num, PNX[PN_num], PNX_Tsig[PN_num]); exit(EXIT_FAILURE); 
          }
 
-// Store the timing value as an element in the TimingTable. NOTE: THIS routine scales the floating point value to a integer (FIXED POINT) by
-// multiplying by 16 before storing the data into the TABLE.
-      InsertIntoTable(max_string_len, db, "TimingTable", SQL_TimingVals_insert_into_cmd, NULL, 0, NULL, NULL, NULL, NULL, NULL, vecpair_index, 
-         POs[PN_num], instance_index, -1, -1, PNX[PN_num], PNX_Tsig[PN_num]);
+// Store the timing value as an element in the TimingTable. NOTE: The floating point value is scaled to an integer (FIXED POINT) by 
+// multiplying by 16 before storing the data into the TABLE, as InsertIntoTable() does for "TimingTable".
+      SQLStmtBindInt(pStmt, 1, vecpair_index, "AddTimingDataToDB()");
+      SQLStmtBindInt(pStmt, 2, POs[PN_num], "AddTimingDataToDB()");
+      SQLStmtBindInt(pStmt, 3, (int)(PNX[PN_num]*16.0), "AddTimingDataToDB()");
+      SQLStmtBindInt(pStmt, 4, (int)(PNX_Tsig[PN_num]*16.0), "AddTimingDataToDB()");
+      SQLStmtBindInt(pStmt, 5, instance_index, "AddTimingDataToDB()");
+      rc = sqlite3_step(pStmt);
+      sqlite3_reset(pStmt);
+      if ( rc != SQLITE_DONE && rc != SQLITE_CONSTRAINT )
+         { printf("ERROR: AddTimingDataToDB(): Return code => %d for vecpair_index %d: %s\n", rc, vecpair_index, sqlite3_errmsg(db)); exit(EXIT_FAILURE); }
 
 #ifdef DEBUG
 printf("AddTimingDataToDB(): InsertIntoTimingTable return val %d\n", rc);
@@ -1637,6 +2041,7 @@ printf("AddTimingDataToDB(): InsertIntoTimingTable return val %d\n", rc);
       PN_num++;
       num_PNs_per_vecpair++;
       }
+   SQLStmtRelease(pStmt);
 
 #ifdef DEBUG
 printf("AddTimingDataToDB(): Number of timing values added for vec_pair_num %d is %d\n", vec_pair_num, num_PNs_per_vecpair); fflush(stdout);
@@ -1648,165 +2053,81 @@ printf("AddTimingDataToDB(): Number of timing values added for vec_pair_num %d i
 
 // ========================================================================================================
 // ========================================================================================================
-// Add master vectors to the Vectors table, and then vector pairs to the VecPairs table, and then the timing 
-// data to the TimingVals table. It is common for this routine to issue constraint violations because vectors 
-// or vector pairs already exist in the tables. Timing values are deleted and then re-added if they already 
-// exist b/c the user must first decide if the PUFInstance is to be preserved or replaced. This is 
-// accomplished because a foreign key and ON DELETE CASCADE is set on the TimingVals database to the PUFInstance 
-// table.
+// Add an element to the Vectors or VecPairs table if it does not already exist and return its id. A new row
+// gets its id from sqlite3_last_insert_rowid(), so the SELECT is only issued when the INSERT hits the unique 
+// index, i.e., the element was enrolled by an earlier run.
 
-void ProcessMasterVecsAndTimingData(int max_string_len, sqlite3 *db, int design_index, int instance_index,
-   int master_num_vec_pairs, int master_num_rise_vec_pairs, unsigned char **master_first_vecs_b, 
-   unsigned char **master_second_vecs_b, float *PNX, float *PNX_Tsig, int *rise_fall, int *vec_pairs, 
-   int *POs, int num_PNR, int num_PNX, int num_PIs, int num_POs)
+int InsertOrGetIndex(int max_string_len, sqlite3 *db, char *Table, const char *SQL_insert_cmd, const char *SQL_get_index_cmd, 
+   unsigned char *blob, int blob_size_bytes, char *text1, int int1, int int2, int int3)
    {
-   int vecpair_index, num_PNs_per_vecpair;
-   char rise_fall_str[200];
-   int vec_num, vec_len_bytes;
+   int index;
 
-   int first_vec_index, second_vec_index;
+   if ( InsertIntoTable(max_string_len, db, Table, SQL_insert_cmd, blob, blob_size_bytes, text1, NULL, NULL, NULL, NULL, int1, 
+      int2, -1, int3, -1, -1.0, -1.0) == 0 )
+      index = (int)sqlite3_last_insert_rowid(db);
+   else
+      index = GetIndexFromTable(max_string_len, db, Table, SQL_get_index_cmd, blob, blob_size_bytes, NULL, NULL, NULL, NULL, 
+         int1, int2, int3);
 
-   int tot_TVs;
+   return index;
+   }
 
-   vec_len_bytes = num_PIs/8;
 
-#ifdef DEBUG
-struct timeval t1, t2;
-long elapsed; 
-#endif
+// ========================================================================================================
+// ========================================================================================================
+// Add master vectors to the Vectors table and vector pairs to the VecPairs table and record their ids in
+// 'ID_map_ptr'. The master vectors are the same for every chip that is enrolled, so this is done once per 
+// process and ProcessMasterVecsAndTimingData() uses the map for the remaining chips instead of issuing a
+// SELECT per vector and vector pair. It is common for vectors or vector pairs to already exist in the tables. 
+// The map stays valid because deleting a PUFInstance only cascades to its TimingVals.
+
+void GetCreateEnrollIDMap(int max_string_len, sqlite3 *db, int design_index, int master_num_vec_pairs, 
+   int master_num_rise_vec_pairs, unsigned char **master_first_vecs_b, unsigned char **master_second_vecs_b, 
+   int num_PIs, EnrollIDMapStruct *ID_map_ptr)
+   {
+   int vec_num, vec_len_bytes;
+   char rise_fall_str[2];
 
-printf("ENROLL:\tPUFDesign %d: PUFInstance %d\tFor Num Vectors %d\n", design_index, instance_index, master_num_vec_pairs); fflush(stdout);
-#ifdef DEBUG
-#endif
+// The map is reused if it was built for the same design and master vector set.
+   if ( ID_map_ptr->vecpair_ids != NULL && ID_map_ptr->design_index == design_index && ID_map_ptr->num_vec_pairs == master_num_vec_pairs )
+      return;
 
-// ---------------------------------------------------------
-   tot_TVs = 0;
+   FreeEnrollIDMap(ID_map_ptr);
+   if ( (ID_map_ptr->first_vec_ids = (int *)malloc(sizeof(int) * master_num_vec_pairs)) == NULL ||
+      (ID_map_ptr->second_vec_ids = (int *)malloc(sizeof(int) * master_num_vec_pairs)) == NULL ||
+      (ID_map_ptr->vecpair_ids = (int *)malloc(sizeof(int) * master_num_vec_pairs)) == NULL )
+      { printf("ERROR: GetCreateEnrollIDMap(): Failed to allocate storage for %d vector pair ids!\n", master_num_vec_pairs); exit(EXIT_FAILURE); }
+   ID_map_ptr->design_index = design_index;
+   ID_map_ptr->num_vec_pairs = master_num_vec_pairs;
+
+   vec_len_bytes = num_PIs/8;
    for ( vec_num = 0; vec_num < master_num_vec_pairs; vec_num++ )
       {
-#ifdef DEBUG
-gettimeofday(&t2, 0);
-#endif
-
-#ifdef DEBUG
-printf("\n\nPROCESSING vector %d of %d\n", vec_num, master_num_vec_pairs); fflush(stdout);
-#endif
-
-#ifdef DEBUG
-printf("SQL Query '%s'\n", SQL_Vectors_insert_into_cmd);
-#endif
-
-#ifdef DEBUG
-printf("\tWriting 1st vector number %d\n", vec_num);
-#endif
-
-// Insert first vector of vector pair into Vectors table if it does already exist. It is common for vectors to already exist
-// as enrollment data for new chips is added.
-      InsertIntoTable(max_string_len, db, "Vectors", SQL_Vectors_insert_into_cmd, master_first_vecs_b[vec_num], vec_len_bytes, 
-         NULL, NULL, NULL, NULL, NULL, -1, -1, -1, -1, -1, -1.0, -1.0);
-
-#ifdef DEBUG
-gettimeofday(&t1, 0); elapsed = (t1.tv_sec-t2.tv_sec)*1000000 + t1.tv_usec-t2.tv_usec; printf("\tElapsed %ld us\n\n", (long)elapsed);
-gettimeofday(&t2, 0);
-#endif
-
-#ifdef DEBUG
-printf("\tWriting 2nd vector number %d\n", vec_num);
-#endif
 
-// Insert second vector of vector pair.
-      InsertIntoTable(max_string_len, db, "Vectors", SQL_Vectors_insert_into_cmd, master_second_vecs_b[vec_num], vec_len_bytes, 
-         NULL, NULL, NULL, NULL, NULL, -1, -1, -1, -1, -1, -1.0, -1.0);
-
-#ifdef DEBUG
-gettimeofday(&t1, 0); elapsed = (t1.tv_sec-t2.tv_sec)*1000000 + t1.tv_usec-t2.tv_usec; printf("\tElapsed %ld us\n\n", (long)elapsed);
-gettimeofday(&t2, 0);
-#endif
-
-// ------------------------------------------------------------------------------------------------------------
-// For each pair of vectors that have been added, add a row to the VecPairs table. First find the vectors in the
-// Vectors table (that were either just added or already existed). Since only unique vectors are added, these number 
-// can jump around because the calls above may not add a vector (if it is not unique).
-
-#ifdef DEBUG
-printf("\nProcessMasterVecsAndTimingData(): Find first vector!\n"); fflush(stdout);
-#endif
-
-// Get index for first vector of the vector pair from the Vectors table.
-      if ( (first_vec_index = GetIndexFromTable(max_string_len, db, "Vectors", SQL_Vectors_get_index_cmd, master_first_vecs_b[vec_num], 
-         vec_len_bytes, NULL, NULL, NULL, NULL, -1, -1, -1)) == -1 )
+// Insert the two vectors of the vector pair into the Vectors table if they do not already exist and get their indexes. Since only 
+// unique vectors are added, these numbers can jump around.
+      if ( (ID_map_ptr->first_vec_ids[vec_num] = InsertOrGetIndex(max_string_len, db, "Vectors", SQL_Vectors_insert_into_cmd, 
+         SQL_Vectors_get_index_cmd, master_first_vecs_b[vec_num], vec_len_bytes, NULL, -1, -1, -1)) == -1 )
          { 
-         printf("ERROR: ProcessMasterVecsAndTimingData(): Failed to find first_vec_index for vec_num %d in Vectors table!\n", vec_num); 
+         printf("ERROR: GetCreateEnrollIDMap(): Failed to find first_vec_index for vec_num %d in Vectors table!\n", vec_num); 
          exit(EXIT_FAILURE); 
          }
-
-#ifdef DEBUG
-printf("Vec %d, First vector index %d\n", vec_num, first_vec_index); fflush(stdout);
-gettimeofday(&t1, 0); elapsed = (t1.tv_sec-t2.tv_sec)*1000000 + t1.tv_usec-t2.tv_usec; printf("\tElapsed %ld us\n\n", (long)elapsed);
-gettimeofday(&t2, 0);
-#endif
-
-#ifdef DEBUG
-// Sanity check. Read back the first vector and check it against array values.
-      int byte_num;
-      unsigned char temp_vec[vec_len_bytes];
-      ReadBinaryBlob(db, SQL_Vectors_read_vector_cmd, first_vec_index, temp_vec, vec_len_bytes, 0, NULL);
-
-// printf("Stored and retrieved vector %d => size is %d:\n\t\t", vec_num, vec_len_bytes); fflush(stdout);
-      for ( byte_num = 0; byte_num < vec_len_bytes; byte_num++ ) 
-         {
-         printf("%02X <=> %02X  ", master_first_vecs_b[vec_num][byte_num], temp_vec[byte_num]); 
-         if ( (byte_num + 1) % 16 == 0 )
-            printf("\n\t\t");
-         if ( master_first_vecs_b[vec_num][byte_num] != temp_vec[byte_num] )
-            {
-            printf("ERROR: ProcessMasterVecsAndTimingData(): Master Vector byte %02X does NOT equal stored vector byte %02X!\n", 
-               master_first_vecs_b[vec_num][byte_num], temp_vec[byte_num]); 
-            exit(EXIT_FAILURE);
-            }
-         }
-      printf("\n"); fflush(stdout);
-#endif
-
-#ifdef DEBUG
-printf("\nProcessMasterVecsAndTimingData(): Find second vector!\n"); fflush(stdout);
-#endif
-
-// Get index for second vector of the vector pair from the Vectors table.
-      if ( (second_vec_index = GetIndexFromTable(max_string_len, db, "Vectors", SQL_Vectors_get_index_cmd, master_second_vecs_b[vec_num], 
-         vec_len_bytes, NULL, NULL, NULL, NULL, -1, -1, -1)) == -1 )
+      if ( (ID_map_ptr->second_vec_ids[vec_num] = InsertOrGetIndex(max_string_len, db, "Vectors", SQL_Vectors_insert_into_cmd, 
+         SQL_Vectors_get_index_cmd, master_second_vecs_b[vec_num], vec_len_bytes, NULL, -1, -1, -1)) == -1 )
          { 
-         printf("ERROR: ProcessMasterVecsAndTimingData(): Failed to find second_vec_index for vec_num %d in Vectors table!\n", vec_num); 
+         printf("ERROR: GetCreateEnrollIDMap(): Failed to find second_vec_index for vec_num %d in Vectors table!\n", vec_num); 
          exit(EXIT_FAILURE); 
          }
 
 #ifdef DEBUG
-printf("Vec %d, Second vector index %d\n", vec_num, second_vec_index); fflush(stdout);
-gettimeofday(&t1, 0); elapsed = (t1.tv_sec-t2.tv_sec)*1000000 + t1.tv_usec-t2.tv_usec; printf("\tElapsed %ld us\n\n", (long)elapsed);
-gettimeofday(&t2, 0);
-#endif
-
-#ifdef DEBUG
-printf("\tWrote binary vectors into Vector Table for %d with 1st vector index %d and 2nd vector index %d\n", vec_num, first_vec_index, second_vec_index); fflush(stdout);
-#endif
-
-#ifdef DEBUG
-// Sanity check. Read back the second vector and check it against array values.
-      ReadBinaryBlob(db, SQL_Vectors_read_vector_cmd, second_vec_index, temp_vec, vec_len_bytes, 0, NULL);
-
-// printf("Stored and retrieved vector %d => size is %d:\n\t\t", vec_num, vec_len_bytes); fflush(stdout);
-      for ( byte_num = 0; byte_num < vec_len_bytes; byte_num++ ) 
-         {
-         printf("%02X <=> %02X  ", master_second_vecs_b[vec_num][byte_num], temp_vec[byte_num]); 
-         if ( (byte_num + 1) % 16 == 0 )
-            printf("\n\t\t");
-         if ( master_second_vecs_b[vec_num][byte_num] != temp_vec[byte_num] )
-            {
-            printf("ERROR: ProcessMasterVecsAndTimingData(): Master Vector byte %02X does NOT equal stored vector byte %02X!\n", 
-               master_second_vecs_b[vec_num][byte_num], temp_vec[byte_num]); 
-            exit(EXIT_FAILURE);
-            }
-         }
-      printf("\n"); fflush(stdout);
+// Sanity check. Read back the vectors and check them against array values.
+      unsigned char temp_vec[vec_len_bytes];
+      ReadBinaryBlob(db, SQL_Vectors_read_vector_cmd, ID_map_ptr->first_vec_ids[vec_num], temp_vec, vec_len_bytes, 0, NULL);
+      if ( memcmp(master_first_vecs_b[vec_num], temp_vec, vec_len_bytes) != 0 )
+         { printf("ERROR: GetCreateEnrollIDMap(): Master first vector %d does NOT equal stored vector!\n", vec_num); exit(EXIT_FAILURE); }
+      ReadBinaryBlob(db, SQL_Vectors_read_vector_cmd, ID_map_ptr->second_vec_ids[vec_num], temp_vec, vec_len_bytes, 0, NULL);
+      if ( memcmp(master_second_vecs_b[vec_num], temp_vec, vec_len_bytes) != 0 )
+         { printf("ERROR: GetCreateEnrollIDMap(): Master second vector %d does NOT equal stored vector!\n", vec_num); exit(EXIT_FAILURE); }
 #endif
 
 // We automatically detected when reading vectors and mask files which vectors are rising and counted them (and also made sure they
@@ -1817,42 +2138,80 @@ printf("\tWrote binary vectors into Vector Table for %d with 1st vector index %d
       else
          strcpy(rise_fall_str, "F");
 
-#ifdef DEBUG
-printf("Creating/Adding VecPair for vec_num %d, R/F %s, 1st vec index %d, 2nd vec index %d and design index %d!\n",
-   vec_num, rise_fall_str, first_vec_index, second_vec_index, design_index); fflush(stdout);
-#endif
-
 // Add a vector pair to VecPair table. NOTE: a 'unique' index is setup on VecPair that uses 'first_vec_index', 'second_vec_index' and
-// 'design_index', so if the VecPair already exists, it is NOT added again. ALSO NOTE: We will fill in NumPNs after we add and count the 
-// timing values below.
-      InsertIntoTable(max_string_len, db, "VecPairs", SQL_VecPairs_insert_into_cmd, NULL, 0, rise_fall_str, NULL, NULL, NULL, NULL, first_vec_index, 
-         second_vec_index, -1, design_index, -1, -1.0, -1.0);
-
-#ifdef DEBUG
-gettimeofday(&t1, 0); elapsed = (t1.tv_sec-t2.tv_sec)*1000000 + t1.tv_usec-t2.tv_usec; printf("\tElapsed %ld us\n\n", (long)elapsed);
-gettimeofday(&t2, 0);
-printf("Getting index from VecPair Table\n"); fflush(stdout);
-#endif
-
-// Get the index for this newly added VecPair.
-      if ( (vecpair_index = GetIndexFromTable(max_string_len, db, "VecPairs", SQL_VecPairs_get_index_cmd, NULL, 0, NULL, NULL, NULL, NULL, 
-         first_vec_index, second_vec_index, design_index)) == -1 )
+// 'design_index', so if the VecPair already exists, it is NOT added again. ALSO NOTE: NumPNs is filled in after the timing values 
+// are added and counted.
+      if ( (ID_map_ptr->vecpair_ids[vec_num] = InsertOrGetIndex(max_string_len, db, "VecPairs", SQL_VecPairs_insert_into_cmd, 
+         SQL_VecPairs_get_index_cmd, NULL, 0, rise_fall_str, ID_map_ptr->first_vec_ids[vec_num], ID_map_ptr->second_vec_ids[vec_num], 
+         design_index)) == -1 )
          {
-         printf("ERROR: ProcessMasterVecsAndTimingData(): Failed to find vecpair_index for vec_num %d in VecPairs table!\n", vec_num); 
+         printf("ERROR: GetCreateEnrollIDMap(): Failed to find vecpair_index for vec_num %d in VecPairs table!\n", vec_num); 
          exit(EXIT_FAILURE); 
          }
 
 #ifdef DEBUG
-printf("\tWrote VecPair with index %d\n", vecpair_index); fflush(stdout);
+printf("GetCreateEnrollIDMap(): Vec %d: 1st vector index %d, 2nd vector index %d, VecPair index %d\n", vec_num, 
+   ID_map_ptr->first_vec_ids[vec_num], ID_map_ptr->second_vec_ids[vec_num], ID_map_ptr->vecpair_ids[vec_num]); fflush(stdout);
 #endif
+      }
 
-#ifdef DEBUG
-gettimeofday(&t1, 0); elapsed = (t1.tv_sec-t2.tv_sec)*1000000 + t1.tv_usec-t2.tv_usec; printf("\tElapsed %ld us\n\n", (long)elapsed);
-gettimeofday(&t2, 0);
-printf("Saving timing data to TimingVals table\n"); fflush(stdout);
-#endif
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Free the storage in the EnrollIDMapStruct. The structure can be passed to GetCreateEnrollIDMap() again.
+
+void FreeEnrollIDMap(EnrollIDMapStruct *ID_map_ptr)
+   {
+   if ( ID_map_ptr->first_vec_ids != NULL )
+      free(ID_map_ptr->first_vec_ids);
+   if ( ID_map_ptr->second_vec_ids != NULL )
+      free(ID_map_ptr->second_vec_ids);
+   if ( ID_map_ptr->vecpair_ids != NULL )
+      free(ID_map_ptr->vecpair_ids);
+   ID_map_ptr->first_vec_ids = NULL;
+   ID_map_ptr->second_vec_ids = NULL;
+   ID_map_ptr->vecpair_ids = NULL;
+   ID_map_ptr->num_vec_pairs = 0;
+   ID_map_ptr->design_index = -1;
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Add master vectors to the Vectors table, and then vector pairs to the VecPairs table, and then the timing 
+// data to the TimingVals table. The vectors and vector pairs are handled by GetCreateEnrollIDMap(), which
+// does the work only for the first chip enrolled with 'ID_map_ptr'. Timing values are deleted and then 
+// re-added if they already exist b/c the user must first decide if the PUFInstance is to be preserved or 
+// replaced. This is accomplished because a foreign key and ON DELETE CASCADE is set on the TimingVals database 
+// to the PUFInstance table. The caller should wrap each chip in SQLBeginTransaction()/SQLCommitTransaction().
+
+void ProcessMasterVecsAndTimingData(int max_string_len, sqlite3 *db, int design_index, int instance_index,
+   int master_num_vec_pairs, int master_num_rise_vec_pairs, unsigned char **master_first_vecs_b, 
+   unsigned char **master_second_vecs_b, float *PNX, float *PNX_Tsig, int *rise_fall, int *vec_pairs, 
+   int *POs, int num_PNR, int num_PNX, int num_PIs, int num_POs, EnrollIDMapStruct *ID_map_ptr)
+   {
+   int vecpair_index, num_PNs_per_vecpair;
+   int vec_num;
+   int tot_TVs;
+
+printf("ENROLL:\tPUFDesign %d: PUFInstance %d\tFor Num Vectors %d\n", design_index, instance_index, master_num_vec_pairs); fflush(stdout);
+
+// Get the ids of the vectors and vector pairs, adding them to the database if needed.
+   GetCreateEnrollIDMap(max_string_len, db, design_index, master_num_vec_pairs, master_num_rise_vec_pairs, master_first_vecs_b, 
+      master_second_vecs_b, num_PIs, ID_map_ptr);
+
+// ---------------------------------------------------------
+   tot_TVs = 0;
+   for ( vec_num = 0; vec_num < master_num_vec_pairs; vec_num++ )
+      {
+      vecpair_index = ID_map_ptr->vecpair_ids[vec_num];
 
-// Add the timing data for this PUFInstance and VecPair. Unlike above, this should never find that the TimingVal exists. 
+// Add the timing data for this PUFInstance and VecPair. Unlike the vectors, this should never find that the TimingVal exists. 
       num_PNs_per_vecpair = AddTimingDataToDB(max_string_len, db, SQL_TimingVals_insert_into_cmd, vec_num, instance_index, vecpair_index, 
          PNX, PNX_Tsig, rise_fall, vec_pairs, POs, num_PNR, num_PNX, master_num_rise_vec_pairs, num_POs);
 
@@ -1860,19 +2219,12 @@ printf("Saving timing data to TimingVals table\n"); fflush(stdout);
       UpdateVecPairsNumPNsField(max_string_len, db, num_PNs_per_vecpair, vecpair_index);
 
 #ifdef DEBUG
-printf("\tWrote TimingVals with %d elements\n", num_PNs_per_vecpair); fflush(stdout);
+printf("\tWrote TimingVals for VecPair %d with %d elements\n", vecpair_index, num_PNs_per_vecpair); fflush(stdout);
 #endif
       tot_TVs += num_PNs_per_vecpair;
-
-#ifdef DEBUG
-gettimeofday(&t1, 0); elapsed = (t1.tv_sec-t2.tv_sec)*1000000 + t1.tv_usec-t2.tv_usec; printf("\tElapsed %ld us\n\n", (long)elapsed);
-fflush(stdout);
-#endif
       }
 
 printf("\tWrote Total TimingVals %d\n", tot_TVs); fflush(stdout);
-#ifdef DEBUG
-#endif
 
    return;
    }
@@ -2383,13 +2735,105 @@ int PathInfoRandomOrderNumberCompareFunc(const void *v1, const void *v2)
    }
 
 
+// ============================================================================================================================
+// ============================================================================================================================
+// Seed the reentrant challenge generator. In CHLNG_RNG_GLIBC_COMPAT mode, this follows glibc's srandom_r() for the default TYPE_3 
+// generator: the state is filled using the 16807 multiplicative LCG and the first CHLNG_RNG_GLIBC_DISCARD outputs are dropped, so the 
+// sequence returned by ChallengeRNGNext() is identical to srand(Seed) followed by rand() calls. In CHLNG_RNG_XOSHIRO mode, the four
+// state words of xoshiro128** are generated from the seed with splitmix64.
+
+void ChallengeRNGSeed(ChallengeRNGStruct *RNG_ptr, int mode, unsigned int Seed)
+   {
+   int i;
+
+   RNG_ptr->mode = mode;
+   if ( mode == CHLNG_RNG_GLIBC_COMPAT )
+      {
+      int32_t word, hi, lo;
+
+// glibc treats a seed of 0 as 1.
+      word = (int32_t)(Seed == 0 ? 1 : Seed);
+      RNG_ptr->glibc_state[0] = (uint32_t)word;
+      for ( i = 1; i < CHLNG_RNG_GLIBC_DEG; i++ )
+         {
+         hi = word / 127773;
+         lo = word % 127773;
+         word = 16807 * lo - 2836 * hi;
+         if ( word < 0 )
+            word += 2147483647;
+         RNG_ptr->glibc_state[i] = (uint32_t)word;
+         }
+      RNG_ptr->glibc_index = CHLNG_RNG_GLIBC_SEP;
+      for ( i = 0; i < CHLNG_RNG_GLIBC_DISCARD; i++ )
+         ChallengeRNGNext(RNG_ptr);
+      }
+   else if ( mode == CHLNG_RNG_XOSHIRO )
+      {
+      uint64_t x = (uint64_t)Seed, z;
+
+      for ( i = 0; i < 4; i += 2 )
+         {
+         z = (x += 0x9E3779B97F4A7C15ULL);
+         z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+         z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+         z ^= z >> 31;
+         RNG_ptr->xoshiro_state[i] = (uint32_t)z;
+         RNG_ptr->xoshiro_state[i+1] = (uint32_t)(z >> 32);
+         }
+      }
+   else
+      { printf("ERROR: ChallengeRNGSeed(): Unknown generator mode %d!\n", mode); exit(EXIT_FAILURE); }
+
+   return;
+   }
+
+
+// ============================================================================================================================
+// ============================================================================================================================
+// Next value of the reentrant challenge generator, in the range 0 to 2^31 - 1 (RAND_MAX for glibc) in both modes. 
+
+int ChallengeRNGNext(ChallengeRNGStruct *RNG_ptr)
+   {
+   uint32_t result;
+
+   if ( RNG_ptr->mode == CHLNG_RNG_GLIBC_COMPAT )
+      {
+      uint32_t *r = RNG_ptr->glibc_state;
+      int i = RNG_ptr->glibc_index;
+
+// r[n] = r[n-31] + r[n-3] over a circular buffer of the last 31 values. Slot 'i' holds r[n-31] before it is overwritten and
+// glibc starts with 'i' at CHLNG_RNG_GLIBC_SEP.
+      r[i] += r[(i + CHLNG_RNG_GLIBC_DEG - CHLNG_RNG_GLIBC_SEP) % CHLNG_RNG_GLIBC_DEG];
+      result = r[i] >> 1;
+      RNG_ptr->glibc_index = (i + 1) % CHLNG_RNG_GLIBC_DEG;
+      }
+   else
+      {
+      uint32_t *s = RNG_ptr->xoshiro_state;
+      uint32_t t = s[1] << 9;
+
+      result = s[1] * 5;
+      result = ((result << 7) | (result >> 25)) * 9;
+      s[2] ^= s[0];
+      s[3] ^= s[1];
+      s[1] ^= s[2];
+      s[0] ^= s[3];
+      s[2] ^= t;
+      s[3] = (s[3] << 11) | (s[3] >> 21);
+      result >>= 1;
+      }
+
+   return (int)result;
+   }
+
+
 // ============================================================================================================================
 // ============================================================================================================================
 // Original brute force method that randomly chooses PN without regard to how many vecpairs are needed to generate those qualified
 // PN. When the set of qualified PN is only slightly larger than the number needed, e.g., 3500 qualified and need 2048, then
 // this algorithm can produce a smaller set of required vecpairs then OptVec above.
 
-void SelectRandomBruteForce(int max_string_len, int num_rise_qualified_PNs, int num_fall_qualified_PNs, 
+void SelectRandomBruteForce(int max_string_len, ChallengeRNGStruct *RNG_ptr, int num_rise_qualified_PNs, int num_fall_qualified_PNs, 
    PathInfoStruct *qualified_path_info, int num_rise_required_PNs, int num_fall_required_PNs, int *rise_indexes, int *fall_indexes, 
    int num_rising_vecpairs, int num_falling_vecpairs, int *bruteforce_num_rise_vecpairs_ptr, int *bruteforce_num_fall_vecpairs_ptr)
    {
@@ -2415,7 +2859,7 @@ void SelectRandomBruteForce(int max_string_len, int num_rise_qualified_PNs, int
    num_selected_rising_vectors = 0;
    while ( PN_num < num_rise_required_PNs )
       {
-      temp_rand = rand() % num_rise_qualified_PNs;
+      temp_rand = ChallengeRNGNext(RNG_ptr) % num_rise_qualified_PNs;
 
 // Sanity check
       if ( temp_rand >= num_rise_qualified_PNs + num_fall_qualified_PNs )
@@ -2454,7 +2898,7 @@ printf("Rise random index choosen %d (Max is %d)\n", temp_rand, num_rise_qualifi
    num_selected_falling_vectors = 0;
    while ( PN_num < num_fall_required_PNs )
       {
-      temp_rand = (rand() % num_fall_qualified_PNs) + num_rise_qualified_PNs;
+      temp_rand = (ChallengeRNGNext(RNG_ptr) % num_fall_qualified_PNs) + num_rise_qualified_PNs;
 
 // Sanity check
       if ( temp_rand >= num_rise_qualified_PNs + num_fall_qualified_PNs )
@@ -2509,7 +2953,7 @@ printf("\nSUMMARY: SelectRandomBruteForce: Num selected rising vecpairs %d\tNum
 // minimize the number of vectors selected, but fails sometimes, especially if the number of qualifying
 // paths is close to the number required, e.g., 3500 qualifying and 2048 need to be selected.
 
-int SelectRandomOptVec(int max_string_len, int num_rise_qualified_PNs, int num_fall_qualified_PNs, 
+int SelectRandomOptVec(int max_string_len, ChallengeRNGStruct *RNG_ptr, int num_rise_qualified_PNs, int num_fall_qualified_PNs, 
    PathInfoStruct *qualified_path_info, int num_rise_required_PNs, int num_fall_required_PNs, int *rise_indexes, 
    int *fall_indexes, int num_rising_vecpairs, int num_falling_vecpairs, int *optvec_num_rise_vecpairs_ptr, 
    int *optvec_num_fall_vecpairs_ptr, int NUM_QUAL_PATH_LOWER_BOUND, int FRACTION_TO_SELECT_LOWER_BOUND, 
@@ -2602,7 +3046,7 @@ printf("INFO: SelectRandomOptVec(): RISING: Ran out of rising vecpairs before we
          }
 
 // Randomly select a rising vector.
-      vec_pair = rand() % num_rising_vecpairs;
+      vec_pair = ChallengeRNGNext(RNG_ptr) % num_rising_vecpairs;
 
 // Check if this vector is already being used. If so, try another.
       for ( i = 0; i < num_selected_rising_vectors; i++ )
@@ -2681,7 +3125,7 @@ printf("INFO: SelectRandomOptVec(): RISING: Vecpair %d has %d qualifying paths -
          }
 
 // Randomly choose a percentage.
-      random_fraction = (rand() % (100 - FRACTION_TO_SELECT_LOWER_BOUND)) + FRACTION_TO_SELECT_LOWER_BOUND;
+      random_fraction = (ChallengeRNGNext(RNG_ptr) % (100 - FRACTION_TO_SELECT_LOWER_BOUND)) + FRACTION_TO_SELECT_LOWER_BOUND;
       fraction_PNs_needed_for_vecpair = (int)(num_qualifying_for_vecpair*(float)random_fraction/100);
 
 #ifdef DEBUG
@@ -2718,7 +3162,7 @@ printf("INFO: SelectRandomOptVec(): RISING: Vecpair %d has %d qualifying paths r
       num_randomly_selected_for_vecpair = 0;
       while ( PN_num < num_rise_required_PNs && num_randomly_selected_for_vecpair < fraction_PNs_needed_for_vecpair )
          {
-         random_PN = (rand() % num_qualifying_for_vecpair) + qpi_low_index;
+         random_PN = (ChallengeRNGNext(RNG_ptr) % num_qualifying_for_vecpair) + qpi_low_index;
 
 // Check to make sure this index (path) is NOT already selected.
          for ( i = 0; i < PN_num; i++ )
@@ -2763,7 +3207,7 @@ printf("INFO: SelectRandomOptVec(): FALLING: Ran out of falling vecpairs before
          }
 
 // Randomly select a falling vector. Note that falling vectors following rising vectors and do NOT start at 0 but rather continue numbering.
-      vec_pair = (rand() % num_falling_vecpairs) + num_rising_vecpairs;
+      vec_pair = (ChallengeRNGNext(RNG_ptr) % num_falling_vecpairs) + num_rising_vecpairs;
 
 // Check if this vector is already being used. If so, try another.
       for ( i = 0; i < num_selected_falling_vectors; i++ )
@@ -2842,7 +3286,7 @@ printf("INFO: SelectRandomOptVec(): FALLING: Vecpair %d has %d qualifying paths
          }
 
 // Randomly choose a percentage.
-      random_fraction = (rand() % (100 - FRACTION_TO_SELECT_LOWER_BOUND)) + FRACTION_TO_SELECT_LOWER_BOUND;
+      random_fraction = (ChallengeRNGNext(RNG_ptr) % (100 - FRACTION_TO_SELECT_LOWER_BOUND)) + FRACTION_TO_SELECT_LOWER_BOUND;
       fraction_PNs_needed_for_vecpair = (int)(num_qualifying_for_vecpair*(float)random_fraction/100);
 
 #ifdef DEBUG
@@ -2881,7 +3325,7 @@ printf("INFO: SelectRandomOptVec(): FALLING: Vecpair %d has %d qualifying paths
          {
 
 // qpi_low_index is an index of a qualified_path_info element and handles the offset needed.
-         random_PN = (rand() % num_qualifying_for_vecpair) + qpi_low_index; 
+         random_PN = (ChallengeRNGNext(RNG_ptr) % num_qualifying_for_vecpair) + qpi_low_index; 
 
 // Check to make sure this index (path) is NOT already selected.
          for ( i = 0; i < PN_num; i++ )
@@ -2928,9 +3372,9 @@ printf("\tNum selected rising vecpairs %d\tNum selected falling vecpairs %d\tTot
 // ===========================================================================================================
 // ===========================================================================================================
 // Randomly select a subset of 'num_xxx_required_PNs' from the number that is 'qualified' using a Seed parameter
-// to the C rand function.
+// to the reentrant challenge generator in mode 'chlng_rng_mode'.
 
-int SelectRandomSubset(int max_string_len, unsigned int Seed, int num_rise_qualified_PNs, int num_fall_qualified_PNs, 
+int SelectRandomSubset(int max_string_len, unsigned int Seed, int chlng_rng_mode, int num_rise_qualified_PNs, int num_fall_qualified_PNs, 
    PathInfoStruct *qualified_path_info, int num_rise_required_PNs, int num_fall_required_PNs, int *rise_indexes1, 
    int *fall_indexes1, int *rise_indexes2, int *fall_indexes2, int num_rising_vecpairs, int num_falling_vecpairs, 
    int num_tested_PNs, PathInfoStruct *tested_path_info, int NUM_QUAL_PATH_LOWER_BOUND, int FRACTION_TO_SELECT_LOWER_BOUND, 
@@ -2941,6 +3385,7 @@ int SelectRandomSubset(int max_string_len, unsigned int Seed, int num_rise_quali
    int *rise_indexes_final, *fall_indexes_final;
    int PN_num_tested, PN_num_qualified;
    int optvec_succeed = 0;
+   ChallengeRNGStruct Chlng_RNG;
 
 #ifdef DEBUG
 struct timeval t1, t2;
@@ -2952,7 +3397,7 @@ long elapsed;
    if ( num_rise_qualified_PNs < num_rise_required_PNs || num_fall_qualified_PNs < num_fall_required_PNs )
       { printf("ERROR: SelectRandomSubset(): Number of 'qualified_rise/fall_PNs LESS THAN the number required!\n"); exit(EXIT_FAILURE); }
 
-   srand(Seed);
+   ChallengeRNGSeed(&Chlng_RNG, chlng_rng_mode, Seed);
 
 #ifdef DEBUG
 gettimeofday(&t2, 0);
@@ -2970,7 +3415,7 @@ gettimeofday(&t2, 0);
          { printf("ERROR: SelectRandomSubset(): Expected sorted list on 'vecpair_num' to be in 'path_num' order!\n"); exit(EXIT_FAILURE); }
 
 // This is the original brute force algorithm that does NOT track vecpair usage. 
-   SelectRandomBruteForce(max_string_len, num_rise_qualified_PNs, num_fall_qualified_PNs, qualified_path_info, num_rise_required_PNs, num_fall_required_PNs, 
+   SelectRandomBruteForce(max_string_len, &Chlng_RNG, num_rise_qualified_PNs, num_fall_qualified_PNs, qualified_path_info, num_rise_required_PNs, num_fall_required_PNs, 
       rise_indexes1, fall_indexes1, num_rising_vecpairs, num_falling_vecpairs, &bruteforce_num_rise_vecpairs, &bruteforce_num_fall_vecpairs);
    rise_indexes_final = rise_indexes1;
    fall_indexes_final = fall_indexes1;
@@ -2983,7 +3428,7 @@ gettimeofday(&t2, 0);
 // This is one of the algorithms that is designed to optimally select qualifying paths. This algorithm attempts to minimize the number 
 // of vectors selected, but fails sometimes, especially if the number of qualifying paths is close to the number required, e.g., 
 // 3500 qualifying and 2048 need to be selected. 
-   if ( (optvec_succeed = SelectRandomOptVec(max_string_len, num_rise_qualified_PNs, num_fall_qualified_PNs, qualified_path_info, num_rise_required_PNs, 
+   if ( (optvec_succeed = SelectRandomOptVec(max_string_len, &Chlng_RNG, num_rise_qualified_PNs, num_fall_qualified_PNs, qualified_path_info, num_rise_required_PNs, 
       num_fall_required_PNs, rise_indexes2, fall_indexes2, num_rising_vecpairs, num_falling_vecpairs, &optvec_num_rise_vecpairs,
       &optvec_num_fall_vecpairs, NUM_QUAL_PATH_LOWER_BOUND, FRACTION_TO_SELECT_LOWER_BOUND, FRACTION_NUM_QUAL_PATH_LOWER_BOUND, num_POs)) == 1 )
       {
@@ -3497,41 +3942,23 @@ void SaveChallengeBinaryVectorsAndMasks(int max_string_len, char *outfile_vecs,
    }
 
 
-// ========================================================================================================
-// ========================================================================================================
-// Callback for optimized TimingVal retrieval.
-
-int SQL_GetTimingValsOpt_callback(void *UserSpecifiedData, int argc, char **argv, char **azColName)
-   {
-   float *float_val_ptr = (float *)UserSpecifiedData;
-
-// Sanity check. Make sure this callback was called ONLY ONCE.
-   if ( *float_val_ptr != -50000.0 )
-      { printf("ERROR: SQL_GetTimingValsOpt_callback(): More than 1 row matched in table!\n"); exit(EXIT_FAILURE); }
-
-   if ( sscanf(argv[0], "%f", float_val_ptr) != 1 )
-      { printf("ERROR: SQL_GetTimingValsOpt_callback(): Failed to Ave value %s!\n", argv[0]); exit(EXIT_FAILURE); }
-
-// Divide the database stored integer value (returned in argv[0]) by 16 to make it a FIXED POINT value before returning.
-   *float_val_ptr /= 16.0;
-
-   return 0;
-   }
-
-
 // ===========================================================================================================
 // ===========================================================================================================
 // This routine fetches the the timing data for a PUFInstance given by the index parameter. The timing data
 // is stored in a dynamically allocated array in the order given by the VecPairPO structure. Each element
 // of this structure contains a vecpair-PO combination. Note that vecpair is repeated for multiple PO as
-// dictated by the challenge.
+// dictated by the challenge. With the cache, TVC_nums gives the TVC element of each vecpair-PO (see 
+// MapVecPairPOToTimingValsCache). When TVCC_ptr is not NULL and holds PNs16, the cached timing values are read 
+// from the compact layout and converted to float here.
 
 void GetPUFInstanceTimingInfoUsingVecPairPOStruct(int max_string_len, sqlite3 *db, int PUF_instance_index, int timing_or_tsig,
    VecPairPOStruct *vecpair_id_PO, int num_VPPO_eles, int allocate_float_arrs, float **PNR_TSig_ptr, float **PNF_TSig_ptr,
-   TimingValCacheStruct *TVC_arr, int num_TVC_arr, int use_TVC_cache, int TVC_chip_num)
+   TimingValCacheStruct *TVC_arr, int num_TVC_arr, TimingValCacheCompactStruct *TVCC_ptr, int *TVC_nums, int use_TVC_cache, 
+   int TVC_chip_num)
    {
    int vppo_num, num_rise_PNs, num_fall_PNs, rise_fall_vec, doing_rise_PNs;
-   int TVC_arr_num;
+   int16_t *chip_PNs16;
+   int half_num_VPPO;
 
 // Illegal combo
    if ( timing_or_tsig == 1 && use_TVC_cache == 1 )
@@ -3553,136 +3980,119 @@ printf("Getting %d PNR/PNF (or tsig) data for PUF_instance_index %d\n", num_VPPO
          { printf("ERROR: GetPUFInstanceTimingInfoUsingVecPairPOStruct(): Failed to allocate storage PNF_TSig_ptr pointer!\n"); exit(EXIT_FAILURE); }
       }
 
+// The TVC element of each (vecpair, PO) was found once for the challenge by MapVecPairPOToTimingValsCache(), which also checked that 
+// the first half are rise PNs and the second half fall PNs. The compact layout is read from one contiguous block per chip.
+   if ( use_TVC_cache == 1 )
+      {
+      half_num_VPPO = num_VPPO_eles/2;
+      if ( TVCC_ptr != NULL && TVCC_ptr->PNs16 != NULL )
+         {
+         if ( TVCC_ptr->num_TVC_arr != num_TVC_arr || TVC_chip_num < 0 || TVC_chip_num >= TVCC_ptr->num_chips )
+            { 
+            printf("PROGRAM ERROR: GetPUFInstanceTimingInfoUsingVecPairPOStruct(): Compact cache (%d PNs, %d chips) does not match TVC_arr (%d PNs) or chip %d!\n",
+               TVCC_ptr->num_TVC_arr, TVCC_ptr->num_chips, num_TVC_arr, TVC_chip_num); 
+            exit(EXIT_FAILURE); 
+            }
+         chip_PNs16 = &(TVCC_ptr->PNs16[(size_t)TVC_chip_num * num_TVC_arr]);
+         for ( vppo_num = 0; vppo_num < half_num_VPPO; vppo_num++ )
+            (*PNR_TSig_ptr)[vppo_num] = (chip_PNs16[TVC_nums[vppo_num]] == TVC_COMPACT_MISSING) ? -50000.0 : 
+               (float)chip_PNs16[TVC_nums[vppo_num]]/TVC_COMPACT_SCALE;
+         for ( vppo_num = 0; vppo_num < half_num_VPPO; vppo_num++ )
+            (*PNF_TSig_ptr)[vppo_num] = (chip_PNs16[TVC_nums[half_num_VPPO + vppo_num]] == TVC_COMPACT_MISSING) ? -50000.0 : 
+               (float)chip_PNs16[TVC_nums[half_num_VPPO + vppo_num]]/TVC_COMPACT_SCALE;
+         }
+      else
+         {
+         for ( vppo_num = 0; vppo_num < half_num_VPPO; vppo_num++ )
+            (*PNR_TSig_ptr)[vppo_num] = TVC_arr[TVC_nums[vppo_num]].PNs[TVC_chip_num];
+         for ( vppo_num = 0; vppo_num < half_num_VPPO; vppo_num++ )
+            (*PNF_TSig_ptr)[vppo_num] = TVC_arr[TVC_nums[half_num_VPPO + vppo_num]].PNs[TVC_chip_num];
+         }
+      return;
+      }
+
 // Get one timing value for each element in the stucture.
    num_rise_PNs = 0;
    num_fall_PNs = 0;
    doing_rise_PNs = 1;
-   TVC_arr_num = 0;
    for ( vppo_num = 0; vppo_num < num_VPPO_eles; vppo_num++ )
       {
 
-// This is true when all data is to be derived from the database directly (and not the PN cache).
-      if ( use_TVC_cache == 0 )
-         {
 // Get rise_fall status of vecpair_id. Note that GetChallengeBinaryVecsFromDB above already checked that all rise vectors preceed all fall vectors.
-         if ( (rise_fall_vec = GetVecPairsRiseFallStrField(max_string_len, db, vecpair_id_PO[vppo_num].vecpair_id)) == 0 )
-            {
-            num_rise_PNs++;
+      if ( (rise_fall_vec = GetVecPairsRiseFallStrField(max_string_len, db, vecpair_id_PO[vppo_num].vecpair_id)) == 0 )
+         {
+         num_rise_PNs++;
 
 // Sanity check
-            if ( doing_rise_PNs == 0 )
-               { printf("ERROR: GetPUFInstanceTimingInfoUsingVecPairPOStruct(): ALL Rise PNS MUST preceed ALL Fall PNS!\n"); exit(EXIT_FAILURE); }
-            }
-         else
-            {
-            num_fall_PNs++;
-            doing_rise_PNs = 0;
-            }
+         if ( doing_rise_PNs == 0 )
+            { printf("ERROR: GetPUFInstanceTimingInfoUsingVecPairPOStruct(): ALL Rise PNS MUST preceed ALL Fall PNS!\n"); exit(EXIT_FAILURE); }
+         }
+      else
+         {
+         num_fall_PNs++;
+         doing_rise_PNs = 0;
+         }
 
 // Sanity check
-         if ( num_rise_PNs > num_VPPO_eles/2 || num_fall_PNs > num_VPPO_eles/2 )
-            { 
-            printf("ERROR: GetPUFInstanceTimingInfoUsingVecPairPOStruct(): Number of rise PNs %d or fall PNs %d larger than expected %d!\n", num_rise_PNs, num_fall_PNs, num_VPPO_eles/2); 
-            exit(EXIT_FAILURE); 
-            }
+      if ( num_rise_PNs > num_VPPO_eles/2 || num_fall_PNs > num_VPPO_eles/2 )
+         { 
+         printf("ERROR: GetPUFInstanceTimingInfoUsingVecPairPOStruct(): Number of rise PNs %d or fall PNs %d larger than expected %d!\n", num_rise_PNs, num_fall_PNs, num_VPPO_eles/2); 
+         exit(EXIT_FAILURE); 
+         }
 
 // Get timing value or three sig from database. Split into two arrays.
-         if ( timing_or_tsig == 0 )
-            {
+      if ( timing_or_tsig == 0 )
+         {
 
 // Tried a couple things here to speed up the direct database access method but none of my attempts resulted in any speedup. Returning all timing values 
 // associated with a vector pair using GetAllocateListOfFloats also isn't going to work since we would then need to select a small subset from those returned
 // (see bckup/extra).
-            char sql_command_str[max_string_len];
-            char *zErrMsg = 0;
-            float ave_val;
-            int fc;
-
-// For error check in callback.
-            ave_val = -50000.0;
-            sprintf(sql_command_str, "SELECT Ave FROM TimingVals WHERE PUFInstance = %d AND VecPair = %d AND PO = %d;", 
-               PUF_instance_index, vecpair_id_PO[vppo_num].vecpair_id, vecpair_id_PO[vppo_num].PO_num);
-            fc = sqlite3_exec(db, sql_command_str, SQL_GetTimingValsOpt_callback, &ave_val, &zErrMsg);
-            if ( fc != SQLITE_OK )
-               { printf("SQL ERROR: %s\n", zErrMsg); sqlite3_free(zErrMsg); exit(EXIT_FAILURE); }
-
-            if ( doing_rise_PNs == 1 )
-               (*PNR_TSig_ptr)[num_rise_PNs - 1] = ave_val;
-            else
-               (*PNF_TSig_ptr)[num_fall_PNs - 1] = ave_val;
+// The statement comes from the prepared statement cache, so no SQL is compiled per PN. A missing row leaves the -50000.0 marker.
+         sqlite3_stmt *pStmt;
+         float ave_val;
 
-#ifdef DEBUG
-printf("PI %d\tVP %d\tPO %d\tAve %f\n", PUF_instance_index, vecpair_id_PO[vppo_num].vecpair_id, vecpair_id_PO[vppo_num].PO_num, ave_val);
-#endif
+         ave_val = -50000.0;
+         pStmt = SQLStmtAcquire(db, SQL_TimingVals_get_Ave_cmd, "GetPUFInstanceTimingInfoUsingVecPairPOStruct()");
+         SQLStmtBindInt(pStmt, 1, PUF_instance_index, "GetPUFInstanceTimingInfoUsingVecPairPOStruct()");
+         SQLStmtBindInt(pStmt, 2, vecpair_id_PO[vppo_num].vecpair_id, "GetPUFInstanceTimingInfoUsingVecPairPOStruct()");
+         SQLStmtBindInt(pStmt, 3, vecpair_id_PO[vppo_num].PO_num, "GetPUFInstanceTimingInfoUsingVecPairPOStruct()");
+         if ( SQLStmtStep(pStmt, "GetPUFInstanceTimingInfoUsingVecPairPOStruct()") == 1 )
+            {
 
-// Original method
-//         if ( doing_rise_PNs == 1 )
+// Divide the database stored integer value by 16 to make it a FIXED POINT value.
+            ave_val = SQLStmtColumnFloat(pStmt, 0, "GetPUFInstanceTimingInfoUsingVecPairPOStruct()")/16.0;
+            if ( SQLStmtStep(pStmt, "GetPUFInstanceTimingInfoUsingVecPairPOStruct()") == 1 )
+               { printf("ERROR: GetPUFInstanceTimingInfoUsingVecPairPOStruct(): More than 1 row matched in table!\n"); exit(EXIT_FAILURE); }
+            }
+         SQLStmtRelease(pStmt);
+
+         if ( doing_rise_PNs == 1 )
+            (*PNR_TSig_ptr)[num_rise_PNs - 1] = ave_val;
+         else
+            (*PNF_TSig_ptr)[num_fall_PNs - 1] = ave_val;
+
+#ifdef DEBUG
+printf("PI %d\tVP %d\tPO %d\tAve %f\n", PUF_instance_index, vecpair_id_PO[vppo_num].vecpair_id, vecpair_id_PO[vppo_num].PO_num, ave_val);
+#endif
+
+// Original method
+//         if ( doing_rise_PNs == 1 )
 //            (*PNR_TSig_ptr)[num_rise_PNs - 1] = GetTimingValsAveField(max_string_len, db, PUF_instance_index, vecpair_id_PO[vppo_num].vecpair_id, 
 //               vecpair_id_PO[vppo_num].PO_num);
 //         else
 //            (*PNF_TSig_ptr)[num_fall_PNs - 1] = GetTimingValsAveField(max_string_len, db, PUF_instance_index, vecpair_id_PO[vppo_num].vecpair_id, 
 //               vecpair_id_PO[vppo_num].PO_num);
-            }
-
-// Three Sig values
-         else
-            {
-            if ( doing_rise_PNs == 1 )
-               (*PNR_TSig_ptr)[num_rise_PNs - 1] = GetTimingValsTSigField(max_string_len, db, PUF_instance_index, vecpair_id_PO[vppo_num].vecpair_id, 
-                  vecpair_id_PO[vppo_num].PO_num);
-            else
-               (*PNF_TSig_ptr)[num_fall_PNs - 1] = GetTimingValsTSigField(max_string_len, db, PUF_instance_index, vecpair_id_PO[vppo_num].vecpair_id, 
-                  vecpair_id_PO[vppo_num].PO_num);
-            }
          }
 
-// The data stored in the TVC_arr is a super-set of the 2048 rise and 2048 fall PNs that are identifed by the vecpair_id_PO elements as participating
-// in the current challenge. The data in both arrays is ordered in the same fashion, from vecpair_id and then PO in ascending order. So we just need
-// to keep moving forward in the TVC_arr until we find the next element, i.e., we don't need to start the search from the beginning of the TVC_arr
-// on every iteration of this loop.
+// Three Sig values
       else
          {
-
-// Increment TVC_arr_num forward until we find a match between vecpair_ids and PO_nums in the two data structures.
-         while ( TVC_arr_num < num_TVC_arr && 
-            !(TVC_arr[TVC_arr_num].vecpair_id == vecpair_id_PO[vppo_num].vecpair_id && TVC_arr[TVC_arr_num].PO_num == vecpair_id_PO[vppo_num].PO_num) )
-            TVC_arr_num++;
-
-// Program error if this occurs.
-         if ( TVC_arr_num == num_TVC_arr )
-            { 
-            printf("PROGRAM ERROR: GetPUFInstanceTimingInfoUsingVecPairPOStruct(): Failed to find vecpair_id %d and PO_num %d in TVC_arr (cache)!\n",
-               vecpair_id_PO[vppo_num].vecpair_id, vecpair_id_PO[vppo_num].PO_num); 
-            exit(EXIT_FAILURE); 
-            }
-
-// Split the values into rise and fall timing value arrays.
-         if ( TVC_arr[TVC_arr_num].rise_or_fall == 0 )
-            {
-            num_rise_PNs++;
-
-// Sanity check
-            if ( doing_rise_PNs == 0 )
-               { printf("ERROR: GetPUFInstanceTimingInfoUsingVecPairPOStruct(): ALL Rise PNS MUST preceed ALL Fall PNS!\n"); exit(EXIT_FAILURE); }
-            }
-         else
-            {
-            num_fall_PNs++;
-            doing_rise_PNs = 0;
-            }
-
-// Sanity check
-         if ( num_rise_PNs > num_VPPO_eles/2 || num_fall_PNs > num_VPPO_eles/2 )
-            { 
-            printf("ERROR: GetPUFInstanceTimingInfoUsingVecPairPOStruct(): Number of rise PNs %d or fall PNs %d larger than expected %d!\n", num_rise_PNs, num_fall_PNs, num_VPPO_eles/2); 
-            exit(EXIT_FAILURE); 
-            }
-
-// Transfer the timing value to the output arrays. NOTE: PUF_instance_index IS NOT a zero based index (counter).
          if ( doing_rise_PNs == 1 )
-            (*PNR_TSig_ptr)[num_rise_PNs - 1] = TVC_arr[TVC_arr_num].PNs[TVC_chip_num];
+            (*PNR_TSig_ptr)[num_rise_PNs - 1] = GetTimingValsTSigField(max_string_len, db, PUF_instance_index, vecpair_id_PO[vppo_num].vecpair_id, 
+               vecpair_id_PO[vppo_num].PO_num);
          else
-            (*PNF_TSig_ptr)[num_fall_PNs - 1] = TVC_arr[TVC_arr_num].PNs[TVC_chip_num];
+            (*PNF_TSig_ptr)[num_fall_PNs - 1] = GetTimingValsTSigField(max_string_len, db, PUF_instance_index, vecpair_id_PO[vppo_num].vecpair_id, 
+               vecpair_id_PO[vppo_num].PO_num);
          }
       }
 
@@ -3710,15 +4120,25 @@ printf("GetPUFInstanceTimingInfoUsingVecPairPOStruct(): DONE\n"); fflush(stdout)
 
 void GetAllPUFInstanceTimingValsForChallenge(int max_string_len, sqlite3 *db, VecPairPOStruct *challenge_vecpair_id_PO_arr, 
    int num_challenge_vecpair_id_PO, char *PUF_instance_name_to_match, float ***PNR_ptr, float ***PNF_ptr, int *num_chips_ptr,
-   TimingValCacheStruct *TVC_arr, int num_TVC_arr, int use_TVC_cache)
+   TimingValCacheStruct *TVC_arr, int num_TVC_arr, TimingValCacheCompactStruct *TVCC_ptr, TimingValCacheIndexStruct *TVCI_ptr, 
+   int use_TVC_cache, float *PN_block, int PN_block_num_chips)
    {
    SQLIntStruct PUF_instance_index_struct;
+   int TVC_nums[num_challenge_vecpair_id_PO];
    int chip_num;
 
 // We need to do this to compute population offsets below. Get timing data for all PUFInstances (or a subset).
 // First get the a list of PUFInstance IDs that match the string 'PUF_instance_name_to_match', which can be '%' to
-// match all. Use '%' for * and '_' for ?
-   GetPUFInstanceIDsForInstanceName(max_string_len, db, &PUF_instance_index_struct, PUF_instance_name_to_match);
+// match all. Use '%' for * and '_' for ? When the PN cache and a caller PN_block are both used, the PUFInstance IDs 
+// are not needed (the cache is indexed by chip number) and the block was sized from the cache's number of chips, 
+// so the database query is skipped.
+   if ( use_TVC_cache == 1 && PN_block != NULL )
+      {
+      PUF_instance_index_struct.int_arr = NULL;
+      PUF_instance_index_struct.num_ints = PN_block_num_chips;
+      }
+   else
+      GetPUFInstanceIDsForInstanceName(max_string_len, db, &PUF_instance_index_struct, PUF_instance_name_to_match);
 
 // Sanity check
    if ( PUF_instance_index_struct.num_ints == 0 )
@@ -3729,11 +4149,30 @@ printf("GetAllPUFInstanceTimingValsForChallenge(): Number of PUFInstances fetche
    PUF_instance_index_struct.num_ints); fflush(stdout);
 #endif
 
-// Allocate arrays to add the new dynamically allocated subarrays, one pointer for each PUFInstance (chip).
-   if ( (*PNR_ptr = (float **)malloc(sizeof(float *) * PUF_instance_index_struct.num_ints)) == NULL )
-      { printf("ERROR: GetAllPUFInstanceTimingValsForChallenge(): Failed to allocate storage for PNR!\n"); exit(EXIT_FAILURE); }
-   if ( (*PNF_ptr = (float **)malloc(sizeof(float *) * PUF_instance_index_struct.num_ints)) == NULL )
-      { printf("ERROR: GetAllPUFInstanceTimingValsForChallenge(): Failed to allocate storage for PNF!\n"); exit(EXIT_FAILURE); }
+// Allocate arrays to add the new dynamically allocated subarrays, one pointer for each PUFInstance (chip). When the caller supplies 
+// PN_block, *PNR_ptr and *PNF_ptr are its row arrays (PN_block_num_chips each) and the rows are carved out of PN_block, which holds 
+// num_challenge_vecpair_id_PO floats per chip. Nothing is allocated in that case.
+   if ( PN_block != NULL )
+      {
+      if ( *PNR_ptr == NULL || *PNF_ptr == NULL || PUF_instance_index_struct.num_ints > PN_block_num_chips )
+         { 
+         printf("PROGRAM ERROR: GetAllPUFInstanceTimingValsForChallenge(): Caller PN_block for %d chips can not hold %d chips!\n", 
+            PN_block_num_chips, PUF_instance_index_struct.num_ints); 
+         exit(EXIT_FAILURE); 
+         }
+      for ( chip_num = 0; chip_num < PUF_instance_index_struct.num_ints; chip_num++ )
+         {
+         (*PNR_ptr)[chip_num] = &(PN_block[(size_t)chip_num * num_challenge_vecpair_id_PO]);
+         (*PNF_ptr)[chip_num] = &(PN_block[(size_t)chip_num * num_challenge_vecpair_id_PO + num_challenge_vecpair_id_PO/2]);
+         }
+      }
+   else
+      {
+      if ( (*PNR_ptr = (float **)malloc(sizeof(float *) * PUF_instance_index_struct.num_ints)) == NULL )
+         { printf("ERROR: GetAllPUFInstanceTimingValsForChallenge(): Failed to allocate storage for PNR!\n"); exit(EXIT_FAILURE); }
+      if ( (*PNF_ptr = (float **)malloc(sizeof(float *) * PUF_instance_index_struct.num_ints)) == NULL )
+         { printf("ERROR: GetAllPUFInstanceTimingValsForChallenge(): Failed to allocate storage for PNF!\n"); exit(EXIT_FAILURE); }
+      }
 
 struct timeval t0, t1;
 long elapsed; 
@@ -3741,11 +4180,16 @@ gettimeofday(&t0, 0);
 #ifdef DEBUG
 #endif
 
+// Find the TVC element of each (vecpair, PO) of the challenge once. The same elements are gathered for every chip.
+   if ( use_TVC_cache == 1 )
+      MapVecPairPOToTimingValsCache(challenge_vecpair_id_PO_arr, num_challenge_vecpair_id_PO, TVC_arr, TVCI_ptr, TVC_nums);
+
 // Get dynamically allocated arrays, one for each PUF instance and add to PNR and PNF arrays.
    for ( chip_num = 0; chip_num < PUF_instance_index_struct.num_ints; chip_num++ )
-      GetPUFInstanceTimingInfoUsingVecPairPOStruct(max_string_len, db, PUF_instance_index_struct.int_arr[chip_num],
-         0, challenge_vecpair_id_PO_arr, num_challenge_vecpair_id_PO, 1, &((*PNR_ptr)[chip_num]), &((*PNF_ptr)[chip_num]),
-         TVC_arr, num_TVC_arr, use_TVC_cache, chip_num);
+      GetPUFInstanceTimingInfoUsingVecPairPOStruct(max_string_len, db, 
+         (PUF_instance_index_struct.int_arr != NULL) ? PUF_instance_index_struct.int_arr[chip_num] : -1,
+         0, challenge_vecpair_id_PO_arr, num_challenge_vecpair_id_PO, (PN_block == NULL), &((*PNR_ptr)[chip_num]), &((*PNF_ptr)[chip_num]),
+         TVC_arr, num_TVC_arr, TVCC_ptr, TVC_nums, use_TVC_cache, chip_num);
          
 #ifdef DEBUG
 printf("HERE\n");
@@ -3766,6 +4210,9 @@ printf("GetAllPUFInstanceTimingValsForChallenge(): Fetched %d PNR and PNF Timing
 // Return the number of timing data sets fetched from the database.
    *num_chips_ptr = PUF_instance_index_struct.num_ints;
 
+   if ( PUF_instance_index_struct.int_arr != NULL )
+      free(PUF_instance_index_struct.int_arr);
+
    return;
    }
 
@@ -3787,7 +4234,7 @@ printf("GetAllPUFInstanceTimingValsForChallenge(): Fetched %d PNR and PNF Timing
 
 int GenChallengeDB(int max_string_len, sqlite3 *db, int design_index, char *ChallengeSetName, unsigned int Seed, int save_vecs_masks, 
    char *outfile_vecs, char *outfile_masks, unsigned char ***vecs1_bin_ptr, unsigned char ***vecs2_bin_ptr, 
-   unsigned char ***masks_bin_ptr, int *num_vecs_masks_ptr, int *num_rise_vecs_masks_ptr, pthread_mutex_t *GenChallenge_mutex_ptr,
+   unsigned char ***masks_bin_ptr, int *num_vecs_masks_ptr, int *num_rise_vecs_masks_ptr, int chlng_rng_mode,
    int *num_challenge_vecpair_id_PO_ptr, VecPairPOStruct **challenge_vecpair_id_PO_ptr)
    {
    int challenge_index;
@@ -3943,29 +4390,14 @@ gettimeofday(&t2, 0);
 // field in tested_path_info array elements before returning so we know which tested_path_info are going to be used). 
 //   optvec_succeed = SelectRandomSubset(max_string_len, Seed, num_rise_qualified_PNs, num_fall_qualified_PNs, qualified_path_info, NUM_RISE_REQUIRED_PNS, 
 
-#ifdef DEBUG
-printf("Setting ChallengeDB mutex!\n");
-#endif
-
 // 10_31_2021: We are now using a seed to specify the vector sequence on the device, TTP and verifier. When challenges are selected, we depend
-// on the sequence returned by rand() to be the same no matter where this routine runs, device, TT or verifier. The verifier and TTP are multi-threaded
-// and therefore it is possible that multiple threads call this routine simultaneously, interrupting the sequence generated by rand() (rand is NOT re-entrant).
-// If this occurs, then the vector challenges used by the, e.g., verifier and device will be different and the security function will fail. When the device
-// calls this function, the mutex is NULL. This function is the only place where rand() is called.
-   if ( GenChallenge_mutex_ptr != NULL )
-      pthread_mutex_lock(GenChallenge_mutex_ptr);
-
-   SelectRandomSubset(max_string_len, Seed, num_rise_qualified_PNs, num_fall_qualified_PNs, qualified_path_info, NUM_RISE_REQUIRED_PNS, 
+// on the generator sequence to be the same no matter where this routine runs, device, TTP or verifier. The generator state is local to 
+// SelectRandomSubset, so the multi-threaded verifier and TTP can run this routine in parallel without interrupting each other's sequence. 
+// All parties MUST use the same 'chlng_rng_mode'.
+   SelectRandomSubset(max_string_len, Seed, chlng_rng_mode, num_rise_qualified_PNs, num_fall_qualified_PNs, qualified_path_info, NUM_RISE_REQUIRED_PNS, 
       NUM_FALL_REQUIRED_PNS, rise_indexes1, fall_indexes1, rise_indexes2, fall_indexes2, num_rising_vecpairs, num_falling_vecpairs, num_tested_PNs, tested_path_info, 
       NUM_QUAL_PATH_LOWER_BOUND, FRACTION_TO_SELECT_LOWER_BOUND, FRACTION_NUM_QUAL_PATH_LOWER_BOUND, num_POs);
 
-   if ( GenChallenge_mutex_ptr != NULL )
-      pthread_mutex_unlock(GenChallenge_mutex_ptr);
-
-#ifdef DEBUG
-printf("Releasing ChallengeDB mutex!\n");
-#endif
-
 #ifdef DEBUG
 gettimeofday(&t1, 0); elapsed = (t1.tv_sec-t2.tv_sec)*1000000 + t1.tv_usec-t2.tv_usec; printf("\tELAPSED TIME: Select random subset %ld us\n\n", (long)elapsed);
 gettimeofday(&t2, 0);
@@ -4208,6 +4640,216 @@ void GetVecPairPOStructForBinaryVecsMasks(int max_string_len, sqlite3 *db, int n
    }
 
 
+// ===========================================================================================================
+// ===========================================================================================================
+// TVCKey compare function for C lib qsort function. Sorts on vecpair_id and then PO_num, both low-to-high, which 
+// is the order in which SQL_TimingVals_get_challenge_Aves_cmd returns rows.
+
+int TVCKeyVecPairPOCompareFunc(const void *v1, const void *v2)
+   {
+   TVCKeyStruct *k1 = (TVCKeyStruct *)v1;
+   TVCKeyStruct *k2 = (TVCKeyStruct *)v2;
+
+   if ( k1->vecpair_id != k2->vecpair_id )
+      return k1->vecpair_id - k2->vecpair_id;
+   return k1->PO_num - k2->PO_num; 
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Build the lookup index of the TVC array: the TVC elements sorted by vecpair_id and PO and a direct-address table 
+// over the VecPair IDs that gives the first sorted element of each VecPair. Done once when the cache is created. An
+// empty TVC array gives an empty index, in which every lookup fails.
+
+void CreateTimingValsCacheIndex(TimingValCacheStruct *TVC_arr, int num_TVC_arr, TimingValCacheIndexStruct *TVCI_ptr)
+   {
+   int key_num, vecpair_num, max_vecpair_id;
+
+   TVCI_ptr->min_vecpair_id = 0;
+   TVCI_ptr->num_vecpair_ids = 0;
+   TVCI_ptr->vecpair_starts = NULL;
+   TVCI_ptr->keys = NULL;
+   if ( num_TVC_arr <= 0 )
+      return;
+
+   if ( (TVCI_ptr->keys = (TVCKeyStruct *)malloc(sizeof(TVCKeyStruct) * num_TVC_arr)) == NULL )
+      { printf("ERROR: CreateTimingValsCacheIndex(): Failed to allocate storage for 'keys'!\n"); exit(EXIT_FAILURE); }
+   for ( key_num = 0; key_num < num_TVC_arr; key_num++ )
+      {
+      TVCI_ptr->keys[key_num].vecpair_id = TVC_arr[key_num].vecpair_id;
+      TVCI_ptr->keys[key_num].PO_num = TVC_arr[key_num].PO_num;
+      TVCI_ptr->keys[key_num].TVC_index = key_num;
+      }
+   qsort(TVCI_ptr->keys, num_TVC_arr, sizeof(TVCKeyStruct), TVCKeyVecPairPOCompareFunc);
+
+   TVCI_ptr->min_vecpair_id = TVCI_ptr->keys[0].vecpair_id;
+   max_vecpair_id = TVCI_ptr->keys[num_TVC_arr - 1].vecpair_id;
+   TVCI_ptr->num_vecpair_ids = max_vecpair_id - TVCI_ptr->min_vecpair_id + 1;
+
+// VecPairs with no TVC elements get an empty range.
+   if ( (TVCI_ptr->vecpair_starts = (int *)malloc(sizeof(int) * (TVCI_ptr->num_vecpair_ids + 1))) == NULL )
+      { printf("ERROR: CreateTimingValsCacheIndex(): Failed to allocate storage for 'vecpair_starts'!\n"); exit(EXIT_FAILURE); }
+   key_num = 0;
+   for ( vecpair_num = 0; vecpair_num <= TVCI_ptr->num_vecpair_ids; vecpair_num++ )
+      {
+      while ( key_num < num_TVC_arr && TVCI_ptr->keys[key_num].vecpair_id - TVCI_ptr->min_vecpair_id < vecpair_num )
+         key_num++;
+      TVCI_ptr->vecpair_starts[vecpair_num] = key_num;
+      }
+
+   return;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Free the storage in the TimingValCacheIndexStruct, leaving an empty index.
+
+void FreeTimingValsCacheIndex(TimingValCacheIndexStruct *TVCI_ptr)
+   {
+   if ( TVCI_ptr->keys != NULL )
+      free(TVCI_ptr->keys);
+   if ( TVCI_ptr->vecpair_starts != NULL )
+      free(TVCI_ptr->vecpair_starts);
+   TVCI_ptr->keys = NULL;
+   TVCI_ptr->vecpair_starts = NULL;
+   TVCI_ptr->min_vecpair_id = 0;
+   TVCI_ptr->num_vecpair_ids = 0;
+
+   return;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Find the TVC element of each (vecpair, PO) of a challenge using the index built by CreateTimingValsCacheIndex.
+// The TVC_nums array MUST have num_VPPO_eles elements. The first half of the elements MUST be rise PNs and the 
+// second half fall PNs, which GetPUFInstanceTimingInfoUsingVecPairPOStruct depends on.
+
+void MapVecPairPOToTimingValsCache(VecPairPOStruct *vecpair_id_PO, int num_VPPO_eles, TimingValCacheStruct *TVC_arr, 
+   TimingValCacheIndexStruct *TVCI_ptr, int *TVC_nums)
+   {
+   int vppo_num, vecpair_num, key_num, key_end;
+
+   for ( vppo_num = 0; vppo_num < num_VPPO_eles; vppo_num++ )
+      {
+      vecpair_num = vecpair_id_PO[vppo_num].vecpair_id - TVCI_ptr->min_vecpair_id;
+      key_num = key_end = 0;
+      if ( vecpair_num >= 0 && vecpair_num < TVCI_ptr->num_vecpair_ids )
+         {
+         key_num = TVCI_ptr->vecpair_starts[vecpair_num];
+         key_end = TVCI_ptr->vecpair_starts[vecpair_num + 1];
+         while ( key_num < key_end && TVCI_ptr->keys[key_num].PO_num != vecpair_id_PO[vppo_num].PO_num )
+            key_num++;
+         }
+
+// Program error if this occurs.
+      if ( key_num == key_end )
+         { 
+         printf("PROGRAM ERROR: MapVecPairPOToTimingValsCache(): Failed to find vecpair_id %d and PO_num %d in TVC_arr (cache)!\n",
+            vecpair_id_PO[vppo_num].vecpair_id, vecpair_id_PO[vppo_num].PO_num); 
+         exit(EXIT_FAILURE); 
+         }
+      TVC_nums[vppo_num] = TVCI_ptr->keys[key_num].TVC_index;
+
+// Sanity check
+      if ( TVC_arr[TVC_nums[vppo_num]].rise_or_fall != (vppo_num >= num_VPPO_eles/2) )
+         { 
+         printf("ERROR: MapVecPairPOToTimingValsCache(): ALL %d Rise PNS MUST preceed ALL %d Fall PNS (element %d)!\n", num_VPPO_eles/2, 
+            num_VPPO_eles/2, vppo_num); 
+         exit(EXIT_FAILURE); 
+         }
+      }
+
+   return;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Fill in the PNs arrays of the TVC array for all chips. One prepared statement is bound to each PUFInstance ID in 
+// turn and returns all TimingVals rows for the VecPairs of the challenge in (VecPair, PO) order, which the 
+// (PUFInstance, VecPair, PO, Ave) index on TimingVals delivers without a sort. The rows are merged against the
+// TVC elements sorted in the same order. Rows for POs that are NOT qualified in the challenge masks are skipped. 
+// PNs that have no row in the database are left at -50000.0, as before.
+
+void LoadTimingValsCacheAves(sqlite3 *db, int challenge_index, SQLIntStruct *PUF_instance_index_struct_ptr, 
+   TimingValCacheStruct *TVC_arr, int num_TVC_arr)
+   {
+   TVCKeyStruct *TVC_keys;
+   sqlite3_stmt *pStmt;
+   int vecpair_id, PO_num, key_num, key_ele;
+   int chip_num, rc;
+   float ave_val;
+
+   if ( (TVC_keys = (TVCKeyStruct *)malloc(sizeof(TVCKeyStruct) * num_TVC_arr)) == NULL )
+      { printf("ERROR: LoadTimingValsCacheAves(): Failed to allocate storage for 'TVC_keys'!\n"); exit(EXIT_FAILURE); }
+   for ( key_num = 0; key_num < num_TVC_arr; key_num++ )
+      {
+      TVC_keys[key_num].vecpair_id = TVC_arr[key_num].vecpair_id;
+      TVC_keys[key_num].PO_num = TVC_arr[key_num].PO_num;
+      TVC_keys[key_num].TVC_index = key_num;
+      }
+   qsort(TVC_keys, num_TVC_arr, sizeof(TVCKeyStruct), TVCKeyVecPairPOCompareFunc);
+
+   rc = sqlite3_prepare_v2(db, SQL_TimingVals_get_challenge_Aves_cmd, -1, &pStmt, 0);
+   if ( rc != SQLITE_OK )
+      { printf("ERROR: LoadTimingValsCacheAves(): 'sqlite3_prepare_v2' failed with %d: %s\n", rc, sqlite3_errmsg(db)); exit(EXIT_FAILURE); }
+
+   for ( chip_num = 0; chip_num < PUF_instance_index_struct_ptr->num_ints; chip_num++ )
+      {
+
+#ifdef DEBUG
+if ( ((chip_num + 1) % 100) == 0 )
+printf("LoadTimingValsCacheAves(): Reading PNR/PNF for chip %d of %d\n", chip_num + 1, PUF_instance_index_struct_ptr->num_ints); fflush(stdout);
+#endif
+
+      for ( key_num = 0; key_num < num_TVC_arr; key_num++ )
+         TVC_arr[key_num].PNs[chip_num] = -50000.0;
+
+      sqlite3_reset(pStmt);
+      sqlite3_bind_int(pStmt, 1, PUF_instance_index_struct_ptr->int_arr[chip_num]);
+      sqlite3_bind_int(pStmt, 2, challenge_index);
+
+      key_num = 0;
+      while ( (rc = sqlite3_step(pStmt)) == SQLITE_ROW )
+         {
+         vecpair_id = sqlite3_column_int(pStmt, 0);
+         PO_num = sqlite3_column_int(pStmt, 1);
+
+// Divide the database stored integer value by 16 to make it a FIXED POINT value.
+         ave_val = (float)sqlite3_column_double(pStmt, 2);
+         ave_val /= 16.0;
+
+// Skip the TVC elements that precede this row. Assign the row to every TVC element with this VecPair and PO.
+         while ( key_num < num_TVC_arr && (TVC_keys[key_num].vecpair_id < vecpair_id || 
+            (TVC_keys[key_num].vecpair_id == vecpair_id && TVC_keys[key_num].PO_num < PO_num)) )
+            key_num++;
+         for ( key_ele = key_num; key_ele < num_TVC_arr && TVC_keys[key_ele].vecpair_id == vecpair_id && 
+            TVC_keys[key_ele].PO_num == PO_num; key_ele++ )
+            {
+            if ( TVC_arr[TVC_keys[key_ele].TVC_index].PNs[chip_num] != -50000.0 )
+               { 
+               printf("ERROR: LoadTimingValsCacheAves(): More than 1 row matched in table for PUFInstance %d, VecPair %d, PO %d!\n", 
+                  PUF_instance_index_struct_ptr->int_arr[chip_num], vecpair_id, PO_num); exit(EXIT_FAILURE); 
+               }
+            TVC_arr[TVC_keys[key_ele].TVC_index].PNs[chip_num] = ave_val;
+            }
+         }
+      if ( rc != SQLITE_DONE )
+         { printf("ERROR: LoadTimingValsCacheAves(): 'sqlite3_step' failed with %d: %s\n", rc, sqlite3_errmsg(db)); exit(EXIT_FAILURE); }
+      }
+
+   if ( (rc = sqlite3_finalize(pStmt)) != SQLITE_OK )
+      { printf("ERROR: LoadTimingValsCacheAves(): Finalize failed %d\n", rc); exit(EXIT_FAILURE); }
+
+   free(TVC_keys);
+
+   return;
+   }
+
+
 // ===========================================================================================================
 // ===========================================================================================================
 // This routine does what GenChallengeDB does initially, i.e., find all VecPairs that are 'qualified' by the
@@ -4234,7 +4876,7 @@ int CreateTimingValsCacheFromChallengeSet(int max_string_len, sqlite3 *db, int d
 
    SQLIntStruct PUF_instance_index_struct;
 
-   int qPN_num, chip_num; 
+   int qPN_num; 
 
 #ifdef DEBUG
 struct timeval t1, t2;
@@ -4303,40 +4945,18 @@ printf("CreateTimingValsCacheFromChallengeSet(): Number of PUFInstances fetched
    for ( qPN_num = 0; qPN_num < num_qualified_PNs; qPN_num++ )
       {
 
-if ( ((qPN_num + 1) % 100) == 0 )
-printf("CreateTimingValsCacheFromChallengeSet(): Reading %d PNR/PNF from DB of %d\n", qPN_num, num_qualified_PNs); 
-fflush(stdout);
-#ifdef DEBUG
-#endif
-
 // FindQualifyingPaths creates one vecpair_id for each vector pair that is part of the challenge set. It actual vecpair id is found using the vecpair_num
 // field of the qualified_path_info structure.
       (*TVC_arr_ptr)[qPN_num].vecpair_id = vecpair_ids[qualified_path_info[qPN_num].vecpair_num];
       (*TVC_arr_ptr)[qPN_num].PO_num = qualified_path_info[qPN_num].PO_num;
       (*TVC_arr_ptr)[qPN_num].rise_or_fall = qualified_path_info[qPN_num].rise_or_fall;
-      for ( chip_num = 0; chip_num < PUF_instance_index_struct.num_ints; chip_num++ )
-         {
-         char sql_command_str[max_string_len];
-         char *zErrMsg = 0;
-         float ave_val;
-         int fc;
-
-// Look up the timing value for this PUF instance. This is the slow operation that we do ONLY once at the beginning of the protocol run
-// for a given ChallengeSetName. NOTE: THIS ROUTINE SCALES the FIXED POINT data in the database by dividing by 16 to create a floating
-// point value from the stored integer before returning.
-//         (*TVC_arr_ptr)[qPN_num].PNs[chip_num] = GetTimingValsAveField(max_string_len, db, PUF_instance_index_struct.int_arr[chip_num], 
-//            (*TVC_arr_ptr)[qPN_num].vecpair_id, (*TVC_arr_ptr)[qPN_num].PO_num);
-
-         ave_val = -50000.0;
-         sprintf(sql_command_str, "SELECT Ave FROM TimingVals WHERE PUFInstance = %d AND VecPair = %d AND PO = %d;",
-            PUF_instance_index_struct.int_arr[chip_num], (*TVC_arr_ptr)[qPN_num].vecpair_id, (*TVC_arr_ptr)[qPN_num].PO_num);
-         fc = sqlite3_exec(db, sql_command_str, SQL_GetTimingValsOpt_callback, &ave_val, &zErrMsg);
-         if ( fc != SQLITE_OK )
-            { printf("SQL ERROR: %s\n", zErrMsg); sqlite3_free(zErrMsg); exit(EXIT_FAILURE); }
-         (*TVC_arr_ptr)[qPN_num].PNs[chip_num] = ave_val;
-         }
       }
 
+// Look up the timing values for all PUF instances. This is the slow operation that we do ONLY once at the beginning of the protocol run
+// for a given ChallengeSetName. It used to be one SELECT per PN and chip. NOTE: the FIXED POINT data in the database is scaled by dividing 
+// by 16 to create a floating point value from the stored integer.
+   LoadTimingValsCacheAves(db, challenge_index, &PUF_instance_index_struct, *TVC_arr_ptr, num_qualified_PNs);
+
 // Return the size of the array of TVC structures for sanity checks.
    *num_TVC_arr_ptr = num_qualified_PNs;
 
@@ -4359,3 +4979,313 @@ gettimeofday(&t1, 0); elapsed = (t1.tv_sec-t2.tv_sec)*1000000 + t1.tv_usec-t2.tv
 // Return number of chips.
    return PUF_instance_index_struct.num_ints;
    }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Build the compact layout of the TVC, i.e., the PNs as int16_t (times 16), num_TVC_arr values per chip stored
+// contiguously. Every cached PN is the TimingVals Ave integer divided by 16, so the conversion is exact. PNs with 
+// no row in the database (-50000.0) are stored as TVC_COMPACT_MISSING. The float PNs of TVC_arr are NOT freed.
+
+void CreateTimingValsCacheCompact(TimingValCacheStruct *TVC_arr, int num_TVC_arr, int num_chips, TimingValCacheCompactStruct *TVCC_ptr)
+   {
+   int TVC_num, chip_num;
+   int16_t *PNs16;
+   float PN_scaled;
+
+   if ( (PNs16 = (int16_t *)malloc(sizeof(int16_t) * (size_t)num_TVC_arr * num_chips)) == NULL )
+      { printf("ERROR: CreateTimingValsCacheCompact(): Failed to allocate storage for 'PNs16'!\n"); exit(EXIT_FAILURE); }
+
+   for ( TVC_num = 0; TVC_num < num_TVC_arr; TVC_num++ )
+      for ( chip_num = 0; chip_num < num_chips; chip_num++ )
+         {
+         if ( TVC_arr[TVC_num].PNs[chip_num] == -50000.0 )
+            {
+            PNs16[(size_t)chip_num * num_TVC_arr + TVC_num] = TVC_COMPACT_MISSING;
+            continue;
+            }
+
+// Sanity check. A value with more than 4 binary digits of precision or outside of the int16_t range can not be stored.
+         PN_scaled = TVC_arr[TVC_num].PNs[chip_num] * TVC_COMPACT_SCALE;
+         if ( PN_scaled != (float)(int)PN_scaled || PN_scaled <= TVC_COMPACT_MISSING || PN_scaled > INT16_MAX )
+            { 
+            printf("ERROR: CreateTimingValsCacheCompact(): PN %f of chip %d is not a 16-bit fixed point value -- disable the compact cache!\n", 
+               TVC_arr[TVC_num].PNs[chip_num], chip_num); 
+            exit(EXIT_FAILURE); 
+            }
+         PNs16[(size_t)chip_num * num_TVC_arr + TVC_num] = (int16_t)PN_scaled;
+         }
+
+   TVCC_ptr->num_TVC_arr = num_TVC_arr;
+   TVCC_ptr->num_chips = num_chips;
+   TVCC_ptr->PNs16 = PNs16;
+
+   return;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// 64-bit FNV-1a style hash, applied to 8-byte words (the tail bytes are hashed one at a time). Used for the 
+// TVC snapshot payload checksum and the database content hash. NOT cryptographic.
+
+uint64_t HashBuffer64(uint64_t hash, const unsigned char *buffer, size_t num_bytes)
+   {
+   uint64_t word;
+   size_t byte_num;
+
+   for ( byte_num = 0; byte_num + 8 <= num_bytes; byte_num += 8 )
+      {
+      memcpy(&word, &(buffer[byte_num]), 8);
+      hash ^= word;
+      hash *= TVC_SNAPSHOT_FNV_PRIME;
+      }
+   for ( ; byte_num < num_bytes; byte_num++ )
+      {
+      hash ^= buffer[byte_num];
+      hash *= TVC_SNAPSHOT_FNV_PRIME;
+      }
+
+   return hash;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Hash the contents of the database file. The TVC snapshot is only valid for the exact database it was created
+// from. Returns 0 if the file can not be read.
+
+uint64_t HashFileContents(char *filename)
+   {
+   unsigned char buffer[65536];
+   uint64_t hash;
+   size_t num_read;
+   FILE *INFILE;
+
+   if ( (INFILE = fopen(filename, "rb")) == NULL )
+      return 0;
+
+   hash = TVC_SNAPSHOT_FNV_OFFSET;
+   while ( (num_read = fread(buffer, 1, sizeof(buffer), INFILE)) > 0 )
+      hash = HashBuffer64(hash, buffer, num_read);
+   fclose(INFILE);
+
+   return hash;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Write the TVC array as a binary snapshot. Layout: TVCSnapshotHeaderStruct, then num_TVC_arr TVCSnapshotRecordStruct, 
+// then the PNs in the compact layout, i.e., num_chips rows of num_TVC_arr int16_t. The checksum covers everything after the 
+// header. The file is written under a temporary name and renamed so another verifier process never maps a partial file. 
+// Returns 0 on success and -1 on failure (the verifier keeps running with the cache in memory).
+
+int SaveTimingValsCacheSnapshot(char *snapshot_filename, uint64_t DB_hash, char *ChallengeSetName, 
+   char *PUF_instance_name_to_match, TimingValCacheStruct *TVC_arr, TimingValCacheCompactStruct *TVCC_ptr)
+   {
+   char temp_filename[strlen(snapshot_filename) + 32];
+   TVCSnapshotHeaderStruct header;
+   TVCSnapshotRecordStruct *records;
+   unsigned char *payload;
+   size_t payload_size, PNs_size;
+   FILE *OUTFILE;
+   int TVC_num;
+
+// Build the payload in one buffer. HashBuffer64 depends on how the data is split, so the checksum MUST be computed over 
+// the payload as one contiguous block, exactly as LoadTimingValsCacheSnapshot sees it.
+   PNs_size = (size_t)TVCC_ptr->num_TVC_arr * TVCC_ptr->num_chips * sizeof(int16_t);
+   payload_size = (size_t)TVCC_ptr->num_TVC_arr * sizeof(TVCSnapshotRecordStruct) + PNs_size;
+   if ( (payload = (unsigned char *)malloc(payload_size)) == NULL )
+      { printf("WARNING: SaveTimingValsCacheSnapshot(): Failed to allocate storage for snapshot payload!\n"); return -1; }
+   records = (TVCSnapshotRecordStruct *)payload;
+   for ( TVC_num = 0; TVC_num < TVCC_ptr->num_TVC_arr; TVC_num++ )
+      {
+      records[TVC_num].vecpair_id = TVC_arr[TVC_num].vecpair_id;
+      records[TVC_num].PO_num = TVC_arr[TVC_num].PO_num;
+      records[TVC_num].rise_or_fall = TVC_arr[TVC_num].rise_or_fall;
+      }
+   memcpy(payload + (size_t)TVCC_ptr->num_TVC_arr * sizeof(TVCSnapshotRecordStruct), TVCC_ptr->PNs16, PNs_size);
+
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, TVC_SNAPSHOT_MAGIC, sizeof(header.magic));
+   header.version = TVC_SNAPSHOT_VERSION;
+   header.header_size = sizeof(TVCSnapshotHeaderStruct);
+   header.DB_hash = DB_hash;
+   header.checksum = HashBuffer64(TVC_SNAPSHOT_FNV_OFFSET, payload, payload_size);
+   header.num_TVC_arr = TVCC_ptr->num_TVC_arr;
+   header.num_chips = TVCC_ptr->num_chips;
+   strcpy(header.ChallengeSetName, ChallengeSetName);
+   strcpy(header.PUF_instance_name_to_match, PUF_instance_name_to_match);
+
+   sprintf(temp_filename, "%s.tmp.%d", snapshot_filename, (int)getpid());
+   if ( (OUTFILE = fopen(temp_filename, "wb")) == NULL )
+      { printf("WARNING: SaveTimingValsCacheSnapshot(): Could not open '%s' for writing!\n", temp_filename); free(payload); return -1; }
+
+   if ( fwrite(&header, sizeof(header), 1, OUTFILE) != 1 || fwrite(payload, 1, payload_size, OUTFILE) != payload_size )
+      { fclose(OUTFILE); unlink(temp_filename); free(payload); return -1; }
+   free(payload);
+   if ( fclose(OUTFILE) != 0 )
+      { unlink(temp_filename); return -1; }
+
+   if ( rename(temp_filename, snapshot_filename) != 0 )
+      { printf("WARNING: SaveTimingValsCacheSnapshot(): Could not rename '%s' to '%s'!\n", temp_filename, snapshot_filename); unlink(temp_filename); return -1; }
+
+   return 0;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Map a TVC snapshot read-only and build the TVC array from it. When TVCC_ptr is not NULL, its PNs16 field points 
+// directly into the mapping, which is never unmapped, so all BankThreads (and all verifier processes on this host) 
+// share one page cache copy, and the PNs fields of the TVC array are NULL. Otherwise the PNs are converted into float 
+// arrays and the mapping is released. Returns the number of chips, or -1 if the file is missing, from a different 
+// version, database or challenge set, or fails the checksum. 
+
+int LoadTimingValsCacheSnapshot(char *snapshot_filename, uint64_t DB_hash, char *ChallengeSetName, 
+   char *PUF_instance_name_to_match, TimingValCacheStruct **TVC_arr_ptr, int *num_TVC_arr_ptr, TimingValCacheCompactStruct *TVCC_ptr)
+   {
+   TVCSnapshotHeaderStruct *header_ptr;
+   TVCSnapshotRecordStruct *records;
+   unsigned char *map_base;
+   struct stat file_stat;
+   size_t expected_size;
+   int16_t *PNs16_base;
+   int TVC_num, chip_num, fd;
+   int num_TVC_arr, num_chips;
+
+   if ( (fd = open(snapshot_filename, O_RDONLY)) == -1 )
+      return -1;
+   if ( fstat(fd, &file_stat) != 0 || (size_t)file_stat.st_size < sizeof(TVCSnapshotHeaderStruct) )
+      { close(fd); return -1; }
+
+   map_base = (unsigned char *)mmap(NULL, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   if ( map_base == MAP_FAILED )
+      return -1;
+
+   header_ptr = (TVCSnapshotHeaderStruct *)map_base;
+   expected_size = sizeof(TVCSnapshotHeaderStruct) + (size_t)header_ptr->num_TVC_arr * sizeof(TVCSnapshotRecordStruct) + 
+      (size_t)header_ptr->num_TVC_arr * header_ptr->num_chips * sizeof(int16_t);
+
+   if ( memcmp(header_ptr->magic, TVC_SNAPSHOT_MAGIC, sizeof(header_ptr->magic)) != 0 || header_ptr->version != TVC_SNAPSHOT_VERSION || 
+      header_ptr->header_size != sizeof(TVCSnapshotHeaderStruct) || header_ptr->DB_hash != DB_hash || 
+      header_ptr->num_TVC_arr <= 0 || header_ptr->num_chips <= 0 || (size_t)file_stat.st_size != expected_size ||
+      strncmp(header_ptr->ChallengeSetName, ChallengeSetName, sizeof(header_ptr->ChallengeSetName)) != 0 || 
+      strncmp(header_ptr->PUF_instance_name_to_match, PUF_instance_name_to_match, sizeof(header_ptr->PUF_instance_name_to_match)) != 0 || 
+      HashBuffer64(TVC_SNAPSHOT_FNV_OFFSET, map_base + sizeof(TVCSnapshotHeaderStruct), expected_size - sizeof(TVCSnapshotHeaderStruct)) != header_ptr->checksum )
+      { 
+      printf("WARNING: LoadTimingValsCacheSnapshot(): Snapshot '%s' is stale or corrupt -- rebuilding from database\n", snapshot_filename); 
+      munmap(map_base, file_stat.st_size); 
+      return -1; 
+      }
+
+   num_TVC_arr = header_ptr->num_TVC_arr;
+   num_chips = header_ptr->num_chips;
+   records = (TVCSnapshotRecordStruct *)(map_base + sizeof(TVCSnapshotHeaderStruct));
+   PNs16_base = (int16_t *)(map_base + sizeof(TVCSnapshotHeaderStruct) + (size_t)num_TVC_arr * sizeof(TVCSnapshotRecordStruct));
+
+   if ( (*TVC_arr_ptr = (TimingValCacheStruct *)malloc(sizeof(TimingValCacheStruct) * num_TVC_arr)) == NULL )
+      { printf("ERROR: LoadTimingValsCacheSnapshot(): Failed to allocate storage for TVC structure array!\n"); exit(EXIT_FAILURE); }
+   for ( TVC_num = 0; TVC_num < num_TVC_arr; TVC_num++ )
+      {
+      (*TVC_arr_ptr)[TVC_num].vecpair_id = records[TVC_num].vecpair_id;
+      (*TVC_arr_ptr)[TVC_num].PO_num = records[TVC_num].PO_num;
+      (*TVC_arr_ptr)[TVC_num].rise_or_fall = (char)records[TVC_num].rise_or_fall;
+      (*TVC_arr_ptr)[TVC_num].PNs = NULL;
+      }
+
+   if ( TVCC_ptr != NULL )
+      {
+      TVCC_ptr->num_TVC_arr = num_TVC_arr;
+      TVCC_ptr->num_chips = num_chips;
+      TVCC_ptr->PNs16 = PNs16_base;
+      }
+
+// Float layout requested. Convert the PNs and drop the mapping.
+   else
+      {
+      for ( TVC_num = 0; TVC_num < num_TVC_arr; TVC_num++ )
+         {
+         if ( ((*TVC_arr_ptr)[TVC_num].PNs = (float *)malloc(sizeof(float) * num_chips)) == NULL )
+            { printf("ERROR: LoadTimingValsCacheSnapshot(): Failed to allocate storage for PNs!\n"); exit(EXIT_FAILURE); }
+         for ( chip_num = 0; chip_num < num_chips; chip_num++ )
+            {
+            if ( PNs16_base[(size_t)chip_num * num_TVC_arr + TVC_num] == TVC_COMPACT_MISSING )
+               (*TVC_arr_ptr)[TVC_num].PNs[chip_num] = -50000.0;
+            else
+               (*TVC_arr_ptr)[TVC_num].PNs[chip_num] = (float)PNs16_base[(size_t)chip_num * num_TVC_arr + TVC_num]/TVC_COMPACT_SCALE;
+            }
+         }
+      munmap(map_base, file_stat.st_size);
+      }
+
+   *num_TVC_arr_ptr = num_TVC_arr;
+
+   return num_chips;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Front end to CreateTimingValsCacheFromChallengeSet. When 'use_snapshot' is 1, the snapshot file '<DB_filename>.<ChallengeSetName>.tvc'
+// is used if it matches the content hash of DB_filename and the ChallengeSetName, otherwise the cache is built from the database and 
+// the snapshot (re)written. When TVCC_ptr is not NULL, the PNs are returned in the compact layout in TVCC_ptr and the PNs fields of the 
+// TVC array are NULL. The lookup index of the TVC array is returned in TVCI_ptr. Returns the number of chips.
+
+int CreateOrLoadTimingValsCache(int max_string_len, sqlite3 *db, char *DB_filename, int design_index, char *ChallengeSetName, 
+   char *PUF_instance_name_to_match, TimingValCacheStruct **TVC_arr_ptr, int *num_TVC_arr_ptr, int use_snapshot, 
+   TimingValCacheCompactStruct *TVCC_ptr, TimingValCacheIndexStruct *TVCI_ptr) 
+   {
+   char snapshot_filename[max_string_len];
+   TimingValCacheCompactStruct TVCC;
+   uint64_t DB_hash;
+   int num_chips, TVC_num;
+
+   if ( use_snapshot == 1 && (strlen(ChallengeSetName) >= TVC_SNAPSHOT_MAX_NAME_LEN || 
+      strlen(PUF_instance_name_to_match) >= TVC_SNAPSHOT_MAX_MATCH_LEN || (int)(strlen(DB_filename) + strlen(ChallengeSetName) + 6) > max_string_len ||
+      (DB_hash = HashFileContents(DB_filename)) == 0) )
+      use_snapshot = 0;
+
+   if ( use_snapshot == 1 )
+      {
+      sprintf(snapshot_filename, "%s.%s.tvc", DB_filename, ChallengeSetName);
+
+      if ( (num_chips = LoadTimingValsCacheSnapshot(snapshot_filename, DB_hash, ChallengeSetName, PUF_instance_name_to_match, 
+         TVC_arr_ptr, num_TVC_arr_ptr, TVCC_ptr)) != -1 )
+         {
+         printf("\n\nMapped PN cache snapshot '%s' with %d values for each of %d chips\n\n", snapshot_filename, *num_TVC_arr_ptr, num_chips); fflush(stdout);
+         CreateTimingValsCacheIndex(*TVC_arr_ptr, *num_TVC_arr_ptr, TVCI_ptr);
+         return num_chips;
+         }
+      }
+
+   num_chips = CreateTimingValsCacheFromChallengeSet(max_string_len, db, design_index, ChallengeSetName, PUF_instance_name_to_match, 
+      TVC_arr_ptr, num_TVC_arr_ptr);
+   CreateTimingValsCacheIndex(*TVC_arr_ptr, *num_TVC_arr_ptr, TVCI_ptr);
+
+   if ( use_snapshot == 0 && TVCC_ptr == NULL )
+      return num_chips;
+
+// The snapshot stores the compact layout, so it is built even when the caller keeps the float PNs.
+   CreateTimingValsCacheCompact(*TVC_arr_ptr, *num_TVC_arr_ptr, num_chips, &TVCC);
+
+   if ( use_snapshot == 1 && SaveTimingValsCacheSnapshot(snapshot_filename, DB_hash, ChallengeSetName, PUF_instance_name_to_match, 
+      *TVC_arr_ptr, &TVCC) == 0 )
+      { printf("Saved PN cache snapshot '%s'\n\n", snapshot_filename); fflush(stdout); }
+
+   if ( TVCC_ptr != NULL )
+      {
+      *TVCC_ptr = TVCC;
+      for ( TVC_num = 0; TVC_num < *num_TVC_arr_ptr; TVC_num++ )
+         {
+         free((*TVC_arr_ptr)[TVC_num].PNs);
+         (*TVC_arr_ptr)[TVC_num].PNs = NULL;
+         }
+      }
+   else
+      free(TVCC.PNs16);
+
+   return num_chips;
+   }
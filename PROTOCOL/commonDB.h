@@ -28,6 +28,8 @@
 
 #include <math.h>
 #include <pthread.h>
+#include <stdint.h>
+#include <sys/stat.h>
 
 #include <sqlite3.h>
 #include "utility.h"
@@ -39,12 +41,37 @@
 #define NUM_RISE_REQUIRED_PNS (NUM_REQUIRED_PNDIFFS)
 #define NUM_FALL_REQUIRED_PNS (NUM_REQUIRED_PNDIFFS)
 
+// Binary snapshot of the TimingValCacheStruct array. Bump the version when the layout of the structures below changes.
+#define TVC_SNAPSHOT_MAGIC "HELPTVC"
+#define TVC_SNAPSHOT_VERSION 2
+#define TVC_SNAPSHOT_MAX_NAME_LEN 256
+#define TVC_SNAPSHOT_MAX_MATCH_LEN 64
+#define TVC_SNAPSHOT_FNV_OFFSET 0xcbf29ce484222325ULL
+#define TVC_SNAPSHOT_FNV_PRIME 0x100000001b3ULL
+
+// Pseudo-random generators available to GenChallengeDB() for selecting the challenge from the seed. The device, TTP and verifier 
+// MUST use the same mode. CHLNG_RNG_GLIBC_COMPAT reproduces the srand()/rand() sequence of glibc (TYPE_3 additive feedback 
+// generator) used by deployed devices. CHLNG_RNG_XOSHIRO uses xoshiro128** seeded through splitmix64.
+#define CHLNG_RNG_GLIBC_COMPAT 0
+#define CHLNG_RNG_XOSHIRO 1
+#define CHLNG_RNG_GLIBC_DEG 31
+#define CHLNG_RNG_GLIBC_SEP 3
+#define CHLNG_RNG_GLIBC_DISCARD 310
+
+// Maximum number of prepared statements kept open by SQLStmtAcquire() per thread, across all database connections, and the number
+// of hash buckets of a thread's cache. Statements are keyed by connection and SQL text and are checked out for the duration of one 
+// query, so a connection shared by several threads (opened with SQLITE_OPEN_FULLMUTEX) gets one handle per thread.
+#define SQL_STMT_CACHE_MAX 64
+#define SQL_STMT_CACHE_BUCKETS 128
+
 extern const char *SQL_PUFDesign_get_index_cmd;
 extern const char *SQL_PUFDesign_insert_into_cmd;
+extern const char *SQL_PUFDesign_get_num_PIs_POs_cmd;
 
 extern const char *SQL_PUFInstance_get_index_cmd;
 extern const char *SQL_PUFInstance_insert_into_cmd;
 extern const char *SQL_PUFInstance_delete_cmd;
+extern const char *SQL_PUFInstance_get_info_cmd;
 
 extern const char *SQL_Vectors_insert_into_cmd;
 extern const char *SQL_Vectors_read_vector_cmd;
@@ -52,14 +79,23 @@ extern const char *SQL_Vectors_get_index_cmd;
 
 extern const char *SQL_VecPairs_insert_into_cmd;
 extern const char *SQL_VecPairs_get_index_cmd;
+extern const char *SQL_VecPairs_get_NumPNs_cmd;
+extern const char *SQL_VecPairs_get_R_F_str_cmd;
+extern const char *SQL_VecPairs_update_NumPNs_cmd;
 
 extern const char *SQL_TimingVals_insert_into_cmd;
+extern const char *SQL_TimingVals_get_challenge_Aves_cmd;
+extern const char *SQL_TimingVals_get_Ave_cmd;
+extern const char *SQL_TimingVals_get_TSig_cmd;
 
 extern const char *SQL_PathSelectMasks_insert_into_cmd;
 extern const char *SQL_PathSelectMasks_get_index_cmd;
 
 extern const char *SQL_Challenges_insert_into_cmd;
 extern const char *SQL_Challenges_get_index_cmd;
+extern const char *SQL_Challenges_get_NumVecs_NumPNs_cmd;
+extern const char *SQL_Challenges_update_NumVecs_cmd;
+extern const char *SQL_Challenges_update_NumPNs_cmd;
 
 extern const char *SQL_ChallengeVecPairs_insert_into_cmd;
 extern const char *SQL_ChallengeVecPairs_get_index_cmd;
@@ -100,11 +136,105 @@ typedef struct
    int vecpair_id;
    int PO_num;
    } VecPairPOStruct; 
+
+// Used to merge TimingVals rows into the TimingValCacheStruct array, which is NOT sorted by vecpair_id and PO.
+typedef struct
+   {
+   int vecpair_id;
+   int PO_num;
+   int TVC_index;
+   } TVCKeyStruct; 
+
+// Lookup index over the TimingValCacheStruct array. 'keys' holds the TVC elements sorted by vecpair_id and PO and the elements of VecPair 
+// 'vecpair_id' are keys[vecpair_starts[vecpair_id - min_vecpair_id]] up to (not including) keys[vecpair_starts[vecpair_id - min_vecpair_id + 1]].
+typedef struct
+   {
+   int min_vecpair_id;
+   int num_vecpair_ids;
+   int *vecpair_starts;
+   TVCKeyStruct *keys;
+   } TimingValCacheIndexStruct; 
+
+typedef struct
+   {
+   char magic[8];
+   uint32_t version;
+   uint32_t header_size;
+   uint64_t DB_hash;
+   uint64_t checksum;
+   int32_t num_TVC_arr;
+   int32_t num_chips;
+   char ChallengeSetName[TVC_SNAPSHOT_MAX_NAME_LEN];
+   char PUF_instance_name_to_match[TVC_SNAPSHOT_MAX_MATCH_LEN];
+   } TVCSnapshotHeaderStruct; 
+
+typedef struct
+   {
+   int32_t vecpair_id;
+   int32_t PO_num;
+   int32_t rise_or_fall;
+   } TVCSnapshotRecordStruct; 
+
+// Reentrant generator state. Each call to SelectRandomSubset() seeds its own copy on the stack, so challenge generation needs no lock.
+typedef struct
+   {
+   int mode;
+   int glibc_index;
+   uint32_t glibc_state[CHLNG_RNG_GLIBC_DEG];
+   uint32_t xoshiro_state[4];
+   } ChallengeRNGStruct;
+
+typedef struct
+   {
+   sqlite3 *db;
+   char *SQL_cmd;
+   unsigned int hash;
+   sqlite3_stmt *pStmt;
+   int in_use;
+   int next;
+   unsigned long last_used;
+   } SQLStmtCacheEntryStruct;
+
+// Statement cache of one thread. 'buckets' holds the first entry of each hash chain (-1 when empty), linked through 'next'. 
+// 'mutex' is only contended by SQLStmtCacheFinalize() and 'next' links the caches of all threads.
+typedef struct SQLStmtCacheStruct
+   {
+   pthread_mutex_t mutex;
+   SQLStmtCacheEntryStruct entries[SQL_STMT_CACHE_MAX];
+   int buckets[SQL_STMT_CACHE_BUCKETS];
+   int num_entries;
+   unsigned long use_cnt;
+   struct SQLStmtCacheStruct *next;
+   } SQLStmtCacheStruct;
+
+// Database ids of the master vectors and vector pairs, filled in by GetCreateEnrollIDMap(). A zero-initialized structure is empty.
+typedef struct
+   {
+   int design_index;
+   int num_vec_pairs;
+   int *first_vec_ids;
+   int *second_vec_ids;
+   int *vecpair_ids;
+   } EnrollIDMapStruct;
 #define DATABASE_STRUCTS
 #endif
 
 int LoadOrSaveDb(sqlite3 *pInMemory, const char *zFilename, int isSave);
 
+sqlite3_stmt *SQLStmtAcquire(sqlite3 *db, const char *SQL_cmd, char *calling_routine_str);
+void SQLStmtRelease(sqlite3_stmt *pStmt);
+void SQLStmtCacheFinalize(sqlite3 *db);
+void SQLStmtBindInt(sqlite3_stmt *pStmt, int param_num, int val, char *calling_routine_str);
+void SQLStmtBindText(sqlite3_stmt *pStmt, int param_num, const char *text, char *calling_routine_str);
+void SQLStmtBindBlob(sqlite3_stmt *pStmt, int param_num, const unsigned char *blob, int blob_size_bytes, char *calling_routine_str);
+int SQLStmtStep(sqlite3_stmt *pStmt, char *calling_routine_str);
+int SQLStmtColumnInt(sqlite3_stmt *pStmt, int col_index, char *calling_routine_str);
+float SQLStmtColumnFloat(sqlite3_stmt *pStmt, int col_index, char *calling_routine_str);
+void SQLStmtColumnString(sqlite3_stmt *pStmt, int col_index, int required_string_len, int max_string_len, char *field_val_str, 
+   char *calling_routine_str);
+void SQLBeginTransaction(sqlite3 *db);
+void SQLCommitTransaction(sqlite3 *db);
+
 void Get_IDs(int max_string_len, sqlite3 *db, char *table_name, SQLIntStruct *index_struct_ptr);
 void Delete_ForID(int max_string_len, sqlite3 *db, char *table_name, int index);
 
@@ -121,6 +251,7 @@ void FreeStringsDataForRow(SQLRowStringsStruct *row_strings_struct_ptr);
 void UpdateVecPairsNumPNsField(int max_string_len, sqlite3 *db, int num_vals_per_vecpair, int vecpair_index);
 int GetVecPairsRiseFallStrField(int max_string_len, sqlite3 *db, int vecpair_index);
 int GetVecPairsNumPNsField(int max_string_len, sqlite3 *db, int vecpair_index);
+float GetTimingValsAveField(int max_string_len, sqlite3 *db, int PUF_instance_index, int vecpair_index, int PO_num);
 
 void UpdateChallengesNumPNFields(int max_string_len, sqlite3 *db, int challenge_index, int tot_PNs, int tot_rise_PNs);
 void UpdateChallengesNumVecFields(int max_string_len, sqlite3 *db, int challenge_index, int tot_vecs, int tot_rise_vecs);
@@ -161,10 +292,18 @@ void GetCreatePUFDesignAndInstance(int max_string_len, sqlite3 *db, char *Netlis
    char *Chip_name, char *Device_name, char *Placement_name, int *design_index_ptr, int *instance_index_ptr, 
    int num_PIs, int num_POs);
 
+int InsertOrGetIndex(int max_string_len, sqlite3 *db, char *Table, const char *SQL_insert_cmd, const char *SQL_get_index_cmd, 
+   unsigned char *blob, int blob_size_bytes, char *text1, int int1, int int2, int int3);
+
+void GetCreateEnrollIDMap(int max_string_len, sqlite3 *db, int design_index, int master_num_vec_pairs, 
+   int master_num_rise_vec_pairs, unsigned char **master_first_vecs_b, unsigned char **master_second_vecs_b, 
+   int num_PIs, EnrollIDMapStruct *ID_map_ptr);
+void FreeEnrollIDMap(EnrollIDMapStruct *ID_map_ptr);
+
 void ProcessMasterVecsAndTimingData(int max_string_len, sqlite3 *db, int design_index, int instance_index,
    int master_num_vec_pairs, int master_num_rise_vec_pairs, unsigned char **master_first_vecs_b, 
    unsigned char **master_second_vecs_b, float *PNX, float *PNX_Tsig, int *rise_fall, int *vec_pairs, 
-   int *POs, int num_PNR, int num_PNX, int num_PIs, int num_POs);
+   int *POs, int num_PNR, int num_PNX, int num_PIs, int num_POs, EnrollIDMapStruct *ID_map_ptr);
 
 void CheckMaskIsConsistentWithVecPairTimingVals(int max_string_len, sqlite3 *db, int vecpair_index, 
    char *challenge_mask, int num_POs);
@@ -185,15 +324,20 @@ void CreateVecsMasks(int max_string_len, sqlite3 *db, char *outfile_vecs, char *
 
 void GetPUFInstanceTimingInfoUsingVecPairPOStruct(int max_string_len, sqlite3 *db, int PUF_instance_index, int timing_or_tsig,
    VecPairPOStruct *vecpair_id_PO, int num_VPPO_eles, int allocate_float_arrs, float **PNR_TSig_ptr, float **PNF_TSig_ptr,
-   TimingValCacheStruct *TVC_arr, int num_TVC_arr, int use_TVC_cache, int TVC_chip_num);
+   TimingValCacheStruct *TVC_arr, int num_TVC_arr, TimingValCacheCompactStruct *TVCC_ptr, int *TVC_nums, int use_TVC_cache, 
+   int TVC_chip_num);
 
 void GetAllPUFInstanceTimingValsForChallenge(int max_string_len, sqlite3 *db, VecPairPOStruct *challenge_vecpair_id_PO_arr, 
    int num_challenge_vecpair_id_PO, char *PUF_instance_name_to_match, float ***PNR_ptr, float ***PNF_ptr, int *num_chips_ptr,
-   TimingValCacheStruct *TVC_arr, int num_TVC_arr, int use_TVC_cache);
+   TimingValCacheStruct *TVC_arr, int num_TVC_arr, TimingValCacheCompactStruct *TVCC_ptr, TimingValCacheIndexStruct *TVCI_ptr, 
+   int use_TVC_cache, float *PN_block, int PN_block_num_chips);
+
+void ChallengeRNGSeed(ChallengeRNGStruct *RNG_ptr, int mode, unsigned int Seed);
+int ChallengeRNGNext(ChallengeRNGStruct *RNG_ptr);
 
 int GenChallengeDB(int max_string_len, sqlite3 *db, int design_index, char *ChallengeSetName, unsigned int Seed, int save_vecs_masks, 
    char *outfile_vecs, char *outfile_masks, unsigned char ***vecs1_bin_ptr, unsigned char ***vecs2_bin_ptr, 
-   unsigned char ***masks_bin_ptr, int *num_vecs_masks_ptr, int *num_rise_vecs_masks_ptr, pthread_mutex_t *GenChallenge_mutex_ptr,
+   unsigned char ***masks_bin_ptr, int *num_vecs_masks_ptr, int *num_rise_vecs_masks_ptr, int chlng_rng_mode,
    int *num_challenge_vecpair_id_PO_ptr, VecPairPOStruct **challenge_vecpair_id_PO_ptr);
 
 void GetVectorAndVecPairIndexesForBinaryVectors(int max_string_len, sqlite3 *db, int design_index, int vec_len_bytes, 
@@ -204,5 +348,23 @@ void GetVecPairPOStructForBinaryVecsMasks(int max_string_len, sqlite3 *db, int n
    unsigned char **vecs1_bin, unsigned char **vecs2_bin, unsigned char **masks_bin, int num_vecs_masks, 
    int num_rise_vecs_masks, int *num_challenge_vecpair_id_PO_ptr, VecPairPOStruct **challenge_vecpair_id_PO_ptr);
 
+int TVCKeyVecPairPOCompareFunc(const void *v1, const void *v2);
+void CreateTimingValsCacheIndex(TimingValCacheStruct *TVC_arr, int num_TVC_arr, TimingValCacheIndexStruct *TVCI_ptr);
+void FreeTimingValsCacheIndex(TimingValCacheIndexStruct *TVCI_ptr);
+void MapVecPairPOToTimingValsCache(VecPairPOStruct *vecpair_id_PO, int num_VPPO_eles, TimingValCacheStruct *TVC_arr, 
+   TimingValCacheIndexStruct *TVCI_ptr, int *TVC_nums);
+void LoadTimingValsCacheAves(sqlite3 *db, int challenge_index, SQLIntStruct *PUF_instance_index_struct_ptr, 
+   TimingValCacheStruct *TVC_arr, int num_TVC_arr);
 int CreateTimingValsCacheFromChallengeSet(int max_string_len, sqlite3 *db, int design_index, char *ChallengeSetName, 
    char *PUF_instance_name_to_match, TimingValCacheStruct **TVC_ptr, int *num_TVC_ptr);
+void CreateTimingValsCacheCompact(TimingValCacheStruct *TVC_arr, int num_TVC_arr, int num_chips, TimingValCacheCompactStruct *TVCC_ptr);
+
+uint64_t HashBuffer64(uint64_t hash, const unsigned char *buffer, size_t num_bytes);
+uint64_t HashFileContents(char *filename);
+int SaveTimingValsCacheSnapshot(char *snapshot_filename, uint64_t DB_hash, char *ChallengeSetName, 
+   char *PUF_instance_name_to_match, TimingValCacheStruct *TVC_arr, TimingValCacheCompactStruct *TVCC_ptr);
+int LoadTimingValsCacheSnapshot(char *snapshot_filename, uint64_t DB_hash, char *ChallengeSetName, 
+   char *PUF_instance_name_to_match, TimingValCacheStruct **TVC_arr_ptr, int *num_TVC_arr_ptr, TimingValCacheCompactStruct *TVCC_ptr);
+int CreateOrLoadTimingValsCache(int max_string_len, sqlite3 *db, char *DB_filename, int design_index, char *ChallengeSetName, 
+   char *PUF_instance_name_to_match, TimingValCacheStruct **TVC_arr_ptr, int *num_TVC_arr_ptr, int use_snapshot, 
+   TimingValCacheCompactStruct *TVCC_ptr, TimingValCacheIndexStruct *TVCI_ptr);
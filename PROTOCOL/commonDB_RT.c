@@ -14,6 +14,9 @@
 #include "common.h"
 #include "commonDB_RT.h"
 
+extern struct tm *localtime_r (const time_t *__restrict __timer,
+			       struct tm *__restrict __tp) __THROW;
+
 
 // ========================================================================================================
 // ========================================================================================================
@@ -222,49 +225,30 @@ printf("CreationData %s for Bitstring %d is %s\n", (*CreationDate_ptr)[bs_num],
 
 // ========================================================================================================
 // ========================================================================================================
-// Save the bitstrings from device/verifier authentication and session encryption to a database as they are
-// generated so we can later compute stats.
+// Fill in a Bitstrings row for the bitstring from device/verifier authentication and session encryption. 
+// Returns 0 without filling anything in when SAP_ptr->chip_num is negative (a failed DA or VA). The caller 
+// frees record_ptr->Bitstring.
 
-#define MAX_BSTRING_CMD_LEN 30000
-char SQL_BStrings_insert_into_cmd[MAX_BSTRING_CMD_LEN];
-
-void SaveDBBitstringInfo(int max_string_len, SRFAlgoParamsStruct *SAP_ptr, unsigned char *XMR_SHD, 
-   int num_XMR_SHD_bytes, int current_function)
+int BuildDBBitstringRecord(int max_string_len, SRFAlgoParamsStruct *SAP_ptr, unsigned char *XMR_SHD, 
+   int num_XMR_SHD_bytes, int current_function, RTBitstringRecordStruct *record_ptr)
    {
    SQLIntStruct PUF_instance_index_struct;
-   char InstanceName[500];
-   char Dev[500];
-   char Placement[500];
-
-   char date_str[500];
-   struct tm *tmp;
+   struct tm tm_now;
    time_t t;
-
-   char cur_func_str[20];
-   char fix_params_str[20];
-
-   char *BitstringASCII;
-
-   char *zErrMsg = 0;
-   int fc;
-
-#ifdef DEBUG
-printf("SaveDBBitstringInfo(): CALLED!\n"); fflush(stdout); 
-#endif
+   int num_bits;
 
 // Sanity check. Negative is usually -1, and indicates DA or VA failure.
    if ( SAP_ptr->chip_num < 0 )
       { 
-      printf("WARNING: SaveDBBitstringInfo(): chip_num stored in SAP_ptr is negative %d!\n", SAP_ptr->chip_num); fflush(stdout); 
-      return;
+      printf("WARNING: BuildDBBitstringRecord(): chip_num stored in SAP_ptr is negative %d!\n", SAP_ptr->chip_num); fflush(stdout); 
+      return 0;
       }
 
-// Get the current date/time. Only 500 characters allocated for this string above.
+// Get the current date/time. localtime_r() since the workers no longer hold the RT_DB mutex here.
    t = time(NULL);
-   tmp = localtime(&t);
-   if (tmp == NULL) 
+   if ( localtime_r(&t, &tm_now) == NULL ) 
       { printf("localtime FAILED!\n"); exit(EXIT_FAILURE); }
-   if ( strftime(date_str, sizeof(date_str), "%Y-%m-%d %H:%M", tmp) == 0 ) 
+   if ( strftime(record_ptr->CreationDate, RT_BSTRING_NAME_LEN, "%Y-%m-%d %H:%M", &tm_now) == 0 ) 
       { printf("strftime FAILED!\n"); exit(EXIT_FAILURE); }
 
 // Get the PUFInstance name using the chip_num stored in the SAP_ptr (which is the chip_num associated with the bitstring). First get 
@@ -273,112 +257,356 @@ printf("SaveDBBitstringInfo(): CALLED!\n"); fflush(stdout);
 
 // Sanity check
    if ( PUF_instance_index_struct.num_ints == 0 )
-      { printf("ERROR: SaveDBBitstringInfo(): No PUFInstances found!\n"); exit(EXIT_FAILURE); }
+      { printf("ERROR: BuildDBBitstringRecord(): No PUFInstances found!\n"); exit(EXIT_FAILURE); }
 
 // The chip name is stored in the PUFInstance database under the following id. Get the string information from the PUFInstance table.
-// ONLY 500 characters allocated for these strings above.
-   GetPUFInstanceInfoForID(max_string_len, SAP_ptr->database_NAT, PUF_instance_index_struct.int_arr[SAP_ptr->chip_num], InstanceName, 
-      Dev, Placement);
+// ONLY RT_BSTRING_NAME_LEN characters allocated for these strings.
+   record_ptr->PUFInstance_ID = PUF_instance_index_struct.int_arr[SAP_ptr->chip_num];
+   GetPUFInstanceInfoForID(max_string_len, SAP_ptr->database_NAT, record_ptr->PUFInstance_ID, record_ptr->InstanceName, 
+      record_ptr->Dev, record_ptr->Placement);
+   free(PUF_instance_index_struct.int_arr); 
 
 // Create string from current function. 
    if ( current_function == FUNC_RB )
-      strcpy(cur_func_str, "RB");
+      strcpy(record_ptr->SecurityFunction, "RB");
    else if ( current_function == FUNC_DA )
-      strcpy(cur_func_str, "DA");
+      strcpy(record_ptr->SecurityFunction, "DA");
    else if ( current_function == FUNC_VA )
-      strcpy(cur_func_str, "VA");
+      strcpy(record_ptr->SecurityFunction, "VA");
    else if ( current_function == FUNC_SE )
-      strcpy(cur_func_str, "SE");
+      strcpy(record_ptr->SecurityFunction, "SE");
    else if ( current_function == FUNC_LL_ENROLL )
-      strcpy(cur_func_str, "LLE");
+      strcpy(record_ptr->SecurityFunction, "LLE");
 
 // This never occurs because regeneration is done only on the device, in stand-alone mode
    else if ( current_function == FUNC_LL_REGEN )
-      strcpy(cur_func_str, "LLR");
+      strcpy(record_ptr->SecurityFunction, "LLR");
    else
-      { printf("ERROR: SaveDBBitstringInfo(): Unknown 'current function' %d!\n", current_function); exit(EXIT_FAILURE); }
+      { printf("ERROR: BuildDBBitstringRecord(): Unknown 'current function' %d!\n", current_function); exit(EXIT_FAILURE); }
 
-// Only 2 characters allocated for this string above.
    if ( SAP_ptr->fix_params == 0 )
-      strcpy(fix_params_str, "N");
+      strcpy(record_ptr->FixParams, "N");
+   else
+      strcpy(record_ptr->FixParams, "Y");
+
+   record_ptr->design_index = SAP_ptr->design_index;
+   snprintf(record_ptr->Netlist_name, RT_BSTRING_NAME_LEN, "%s", SAP_ptr->Netlist_name);
+   snprintf(record_ptr->Synthesis_name, RT_BSTRING_NAME_LEN, "%s", SAP_ptr->Synthesis_name);
+   snprintf(record_ptr->ChallengeSetName, RT_BSTRING_NAME_LEN, "%s", SAP_ptr->ChallengeSetName_NAT);
+   record_ptr->LFSR_seed_low = SAP_ptr->param_LFSR_seed_low;
+   record_ptr->LFSR_seed_high = SAP_ptr->param_LFSR_seed_high;
+   record_ptr->RangeConstant = SAP_ptr->param_RangeConstant;
+   record_ptr->SpreadConstant = SAP_ptr->param_SpreadConstant;
+   record_ptr->Threshold = SAP_ptr->param_Threshold;
+
+// The ASCII bitstring is the raw bitstring (RB), the XMR_SHD for device and verifier authentication, the session key (SE) or the KEK 
+// enrollment key (LLE). We do NOT have the KEK key on the verifier, ONLY ON THE DEVICE. So I'll need to transmit it over from the device 
+// in order to save it here. Session key generation in this PUF-Cash V3.0 version uses FSB mode of KEK so we really don't need 'FUNC_LL_ENROLL'.
+   if ( current_function == FUNC_RB )
+      num_bits = SAP_ptr->DHD_SBS_num_bits;
+   else if ( current_function == FUNC_DA || current_function == FUNC_VA )   
+      num_bits = num_XMR_SHD_bytes * 8;
+   else if ( current_function == FUNC_SE )
+      num_bits = SAP_ptr->SE_target_num_key_bits;
+   else if ( current_function == FUNC_LL_ENROLL )
+      num_bits = SAP_ptr->KEK_target_num_key_bits;
    else
-      strcpy(fix_params_str, "Y");
+      { printf("ERROR: BuildDBBitstringRecord(): Unknown 'current_function' %d\n", current_function); exit(EXIT_FAILURE); }
+
+   if ( (record_ptr->Bitstring = (char *)malloc((num_bits + 1) * sizeof(char))) == NULL )
+      { printf("ERROR: BuildDBBitstringRecord(): Failed to allocated storage for Bitstring!\n"); exit(EXIT_FAILURE); }
 
-// Size of the ASCII bitstring for Raw is 2048 ASCII characters currently.
-   BitstringASCII = NULL;
    if ( current_function == FUNC_RB )
-      {
-      if ( (BitstringASCII = (char *)malloc(SAP_ptr->num_required_PNDiffs * sizeof(char))) == NULL )
-         { printf("ERROR: SaveDBBitstringInfo(): Failed to allocated storage for BitstringASCII!\n"); exit(EXIT_FAILURE); }
+      ConvertBinVecMaskToASCII(num_bits, SAP_ptr->verifier_DHD_SBS, record_ptr->Bitstring);
+   else if ( current_function == FUNC_DA || current_function == FUNC_VA )   
+      ConvertBinVecMaskToASCII(num_bits, XMR_SHD, record_ptr->Bitstring);
+   else if ( current_function == FUNC_SE )
+      ConvertBinVecMaskToASCII(num_bits, SAP_ptr->SE_final_key, record_ptr->Bitstring);
+   else 
+      ConvertBinVecMaskToASCII(num_bits, SAP_ptr->KEK_final_enroll_key, record_ptr->Bitstring);
 
-// Convert the unsigned char array into an ASCII string of 0's and 1's.
-      ConvertBinVecMaskToASCII(SAP_ptr->DHD_SBS_num_bits, SAP_ptr->verifier_DHD_SBS, BitstringASCII);
-      }
+   return 1;
+   }
 
-// Size of the ASCII bitstring for device and verifier authentication is num_XMR_SHD_bytes*8 ASCII characters 
-   else if ( current_function == FUNC_DA || current_function  == FUNC_VA )   
-      {
-      if ( (BitstringASCII = (char *)malloc(num_XMR_SHD_bytes * 8 * sizeof(char))) == NULL )
-         { printf("ERROR: SaveDBBitstringInfo(): Failed to allocated storage for BitstringASCII!\n"); exit(EXIT_FAILURE); }
-      ConvertBinVecMaskToASCII(num_XMR_SHD_bytes * 8, XMR_SHD, BitstringASCII);
 
-// Sanity check
-      if ( strlen(BitstringASCII) != num_XMR_SHD_bytes * 8 )
-         { 
-         printf("ERROR: SaveDBBitstringInfo(): String len of VA or TA BitstringASCII %d NOT equal to requirement %d!\n", 
-            (int)strlen(BitstringASCII), num_XMR_SHD_bytes * 8); exit(EXIT_FAILURE); 
-         }
-      }
+// ========================================================================================================
+// ========================================================================================================
+// Insert one Bitstrings row with a prepared statement. Outside a transaction this is an autocommit insert.
 
-// Session key generation in this PUF-Cash V3.0 version uses FSB mode of KEK so we really don't need 'FUNC_LL_ENROLL' below.
-   else if ( current_function == FUNC_SE )
+#define SQL_BSTRINGS_INSERT_CMD "INSERT INTO Bitstrings (DesignIndex, NetlistName, SynthesisName, InstanceName, Dev, Placement, \
+PUFInstanceID, ChallengeSetName, CreationDate, SecurityFunction, FixParams, LFSRSeedLow, LFSRSeedHigh, RangeConstant, SpreadConstant, \
+Threshold, Bitstring) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"
+
+void InsertDBBitstringRecord(sqlite3 *db, RTBitstringRecordStruct *record_ptr)
+   {
+   sqlite3_stmt *pStmt;
+   char *routine_str = "InsertDBBitstringRecord()";
+
+   pStmt = SQLStmtAcquire(db, SQL_BSTRINGS_INSERT_CMD, routine_str);
+   SQLStmtBindInt(pStmt, 1, record_ptr->design_index, routine_str);
+   SQLStmtBindText(pStmt, 2, record_ptr->Netlist_name, routine_str);
+   SQLStmtBindText(pStmt, 3, record_ptr->Synthesis_name, routine_str);
+   SQLStmtBindText(pStmt, 4, record_ptr->InstanceName, routine_str);
+   SQLStmtBindText(pStmt, 5, record_ptr->Dev, routine_str);
+   SQLStmtBindText(pStmt, 6, record_ptr->Placement, routine_str);
+   SQLStmtBindInt(pStmt, 7, record_ptr->PUFInstance_ID, routine_str);
+   SQLStmtBindText(pStmt, 8, record_ptr->ChallengeSetName, routine_str);
+   SQLStmtBindText(pStmt, 9, record_ptr->CreationDate, routine_str);
+   SQLStmtBindText(pStmt, 10, record_ptr->SecurityFunction, routine_str);
+   SQLStmtBindText(pStmt, 11, record_ptr->FixParams, routine_str);
+   SQLStmtBindInt(pStmt, 12, record_ptr->LFSR_seed_low, routine_str);
+   SQLStmtBindInt(pStmt, 13, record_ptr->LFSR_seed_high, routine_str);
+   SQLStmtBindInt(pStmt, 14, record_ptr->RangeConstant, routine_str);
+   SQLStmtBindInt(pStmt, 15, record_ptr->SpreadConstant, routine_str);
+   SQLStmtBindInt(pStmt, 16, record_ptr->Threshold, routine_str);
+   SQLStmtBindText(pStmt, 17, record_ptr->Bitstring, routine_str);
+   SQLStmtStep(pStmt, routine_str);
+   SQLStmtRelease(pStmt);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Run a statement that returns no rows, e.g., BEGIN, COMMIT or a PRAGMA.
+
+static void RTExec(sqlite3 *db, char *SQL_cmd)
+   {
+   char *zErrMsg = 0;
+
+   if ( sqlite3_exec(db, SQL_cmd, NULL, 0, &zErrMsg) != SQLITE_OK )
+      { printf("ERROR: RTExec(): '%s' failed: %s\n", SQL_cmd, zErrMsg); sqlite3_free(zErrMsg); exit(EXIT_FAILURE); }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Writer thread. Waits for records, gives a group up to commit_interval_ms to reach batch_size (unless a flush
+// or shutdown is pending) and then inserts everything queued in one transaction. Exits once 'stop' is set and 
+// the queue is empty.
+
+static void *RTBitstringWriterThread(void *arg)
+   {
+   RTBitstringWriterStruct *RTW_ptr = (RTBitstringWriterStruct *)arg;
+   RTBitstringRecordStruct *batch[RT_WRITER_QUEUE_SIZE];
+   struct timespec deadline;
+   struct timeval now;
+   int num_recs, rec_num;
+
+   pthread_mutex_lock(&(RTW_ptr->mutex));
+   while (1)
       {
-      if ( (BitstringASCII = (char *)malloc(SAP_ptr->SE_target_num_key_bits * sizeof(char))) == NULL )
-         { printf("ERROR: SaveDBBitstringInfo(): Failed to allocated storage for BitstringASCII!\n"); exit(EXIT_FAILURE); }
-      ConvertBinVecMaskToASCII(SAP_ptr->SE_target_num_key_bits, SAP_ptr->SE_final_key, BitstringASCII);
+      while ( RTW_ptr->num_queued == 0 && RTW_ptr->stop == 0 )
+         pthread_cond_wait(&(RTW_ptr->not_empty_cond), &(RTW_ptr->mutex));
+      if ( RTW_ptr->num_queued == 0 && RTW_ptr->stop == 1 )
+         break;
+
+// Group commit. Let more records arrive unless the batch is full or somebody is waiting on the data.
+      gettimeofday(&now, NULL);
+      deadline.tv_sec = now.tv_sec + RTW_ptr->commit_interval_ms/1000;
+      deadline.tv_nsec = (now.tv_usec + (long)(RTW_ptr->commit_interval_ms % 1000)*1000)*1000;
+      if ( deadline.tv_nsec >= 1000000000 )
+         { deadline.tv_sec++; deadline.tv_nsec -= 1000000000; }
+      while ( RTW_ptr->num_queued < RTW_ptr->batch_size && RTW_ptr->stop == 0 && RTW_ptr->num_flush_requests == 0 )
+         if ( pthread_cond_timedwait(&(RTW_ptr->not_empty_cond), &(RTW_ptr->mutex), &deadline) != 0 )
+            break;
+
+// Take everything queued so far. The workers can keep queueing while the transaction runs.
+      num_recs = RTW_ptr->num_queued;
+      for ( rec_num = 0; rec_num < num_recs; rec_num++ )
+         batch[rec_num] = RTW_ptr->queue[(RTW_ptr->head + rec_num) % RT_WRITER_QUEUE_SIZE];
+      RTW_ptr->head = (RTW_ptr->head + num_recs) % RT_WRITER_QUEUE_SIZE;
+      RTW_ptr->num_queued = 0;
+      pthread_cond_broadcast(&(RTW_ptr->not_full_cond));
+      pthread_mutex_unlock(&(RTW_ptr->mutex));
+
+      RTExec(RTW_ptr->db, "BEGIN");
+      for ( rec_num = 0; rec_num < num_recs; rec_num++ )
+         InsertDBBitstringRecord(RTW_ptr->db, batch[rec_num]);
+      RTExec(RTW_ptr->db, "COMMIT");
+
+      for ( rec_num = 0; rec_num < num_recs; rec_num++ )
+         {
+         free(batch[rec_num]->Bitstring);
+         free(batch[rec_num]);
+         }
+
+      pthread_mutex_lock(&(RTW_ptr->mutex));
+      RTW_ptr->num_inserted += num_recs;
+      RTW_ptr->num_commits++;
+      pthread_cond_broadcast(&(RTW_ptr->inserted_cond));
       }
+   pthread_mutex_unlock(&(RTW_ptr->mutex));
 
-// We do NOT have the KEK key on the verifier, ONLY ON THE DEVICE. So I'll need to transmit it over from the device in order to save it here.
-// Also, regeneration regenerates the SAME key over and over again, so unless we do enrollment over and over again, no sense saving it here.
-   else if ( current_function == FUNC_LL_ENROLL )
+   return NULL;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Open the RunTime DB (which MUST already have the Bitstrings table) in WAL mode on the writer's own connection
+// and start the writer thread. With WAL and synchronous=NORMAL a commit appends to the log without an fsync, 
+// and readers (the analysis programs) are not blocked by the writer.
+
+void RTBitstringWriterInit(RTBitstringWriterStruct *RTW_ptr, char *DB_name_RunTime, int batch_size, int commit_interval_ms)
+   {
+   int rc, err;
+
+   if ( batch_size < 1 || batch_size > RT_WRITER_QUEUE_SIZE )
+      { printf("ERROR: RTBitstringWriterInit(): batch_size %d MUST be between 1 and %d!\n", batch_size, RT_WRITER_QUEUE_SIZE); exit(EXIT_FAILURE); }
+   if ( commit_interval_ms < 1 )
+      { printf("ERROR: RTBitstringWriterInit(): commit_interval_ms %d MUST be >= 1!\n", commit_interval_ms); exit(EXIT_FAILURE); }
+
+   rc = sqlite3_open_v2(DB_name_RunTime, &(RTW_ptr->db), SQLITE_OPEN_READWRITE | SQLITE_OPEN_FULLMUTEX, NULL);
+   if ( rc != SQLITE_OK )
+      { printf("ERROR: RTBitstringWriterInit(): Failed to open RunTime Database '%s': %s\n", DB_name_RunTime, sqlite3_errmsg(RTW_ptr->db)); exit(EXIT_FAILURE); }
+   RTExec(RTW_ptr->db, "PRAGMA journal_mode=WAL");
+   RTExec(RTW_ptr->db, "PRAGMA synchronous=NORMAL");
+
+   RTW_ptr->batch_size = batch_size;
+   RTW_ptr->commit_interval_ms = commit_interval_ms;
+   RTW_ptr->head = 0;
+   RTW_ptr->num_queued = 0;
+   RTW_ptr->stop = 0;
+   RTW_ptr->num_flush_requests = 0;
+   RTW_ptr->num_enqueued = 0;
+   RTW_ptr->num_inserted = 0;
+   RTW_ptr->num_commits = 0;
+   RTW_ptr->num_rejected = 0;
+   pthread_mutex_init(&(RTW_ptr->mutex), NULL);
+   pthread_cond_init(&(RTW_ptr->not_empty_cond), NULL);
+   pthread_cond_init(&(RTW_ptr->not_full_cond), NULL);
+   pthread_cond_init(&(RTW_ptr->inserted_cond), NULL);
+
+   if ( (err = pthread_create(&(RTW_ptr->writer_thread), NULL, RTBitstringWriterThread, (void *)RTW_ptr)) != 0 )
+      { printf("ERROR: RTBitstringWriterInit(): Failed to create writer thread: %d\n", err); exit(EXIT_FAILURE); }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Queue a record. The writer takes ownership of the record and its Bitstring, both of which MUST be allocated.
+// Waits only when the queue is full. Once RTBitstringWriterShutdown() has set 'stop' the writer thread may already 
+// be gone, so the record is freed and counted as rejected instead.
+
+void RTBitstringWriterEnqueue(RTBitstringWriterStruct *RTW_ptr, RTBitstringRecordStruct *record_ptr)
+   {
+   pthread_mutex_lock(&(RTW_ptr->mutex));
+   while ( RTW_ptr->num_queued == RT_WRITER_QUEUE_SIZE && RTW_ptr->stop == 0 )
+      pthread_cond_wait(&(RTW_ptr->not_full_cond), &(RTW_ptr->mutex));
+   if ( RTW_ptr->stop == 1 )
       {
-      if ( (BitstringASCII = (char *)malloc(SAP_ptr->KEK_target_num_key_bits * sizeof(char))) == NULL )
-         { printf("ERROR: SaveDBBitstringInfo(): Failed to allocated storage for BitstringASCII!\n"); exit(EXIT_FAILURE); }
-      ConvertBinVecMaskToASCII(SAP_ptr->KEK_target_num_key_bits, SAP_ptr->KEK_final_enroll_key, BitstringASCII);
+      RTW_ptr->num_rejected++;
+      pthread_mutex_unlock(&(RTW_ptr->mutex));
+      free(record_ptr->Bitstring);
+      free(record_ptr);
+      return;
       }
-   else
-      { printf("ERROR: SaveDBBitstringInfo(): Unknown 'current_function' %d\n", current_function); exit(EXIT_FAILURE); }
+   RTW_ptr->queue[(RTW_ptr->head + RTW_ptr->num_queued) % RT_WRITER_QUEUE_SIZE] = record_ptr;
+   RTW_ptr->num_queued++;
+   RTW_ptr->num_enqueued++;
+   if ( RTW_ptr->num_queued == 1 || RTW_ptr->num_queued >= RTW_ptr->batch_size )
+      pthread_cond_signal(&(RTW_ptr->not_empty_cond));
+   pthread_mutex_unlock(&(RTW_ptr->mutex));
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Wait until every record queued before the call is committed.
+
+void RTBitstringWriterFlush(RTBitstringWriterStruct *RTW_ptr)
+   {
+   unsigned long target;
+
+   pthread_mutex_lock(&(RTW_ptr->mutex));
+   target = RTW_ptr->num_enqueued;
+   RTW_ptr->num_flush_requests++;
+   pthread_cond_signal(&(RTW_ptr->not_empty_cond));
+   while ( RTW_ptr->num_inserted < target )
+      pthread_cond_wait(&(RTW_ptr->inserted_cond), &(RTW_ptr->mutex));
+   RTW_ptr->num_flush_requests--;
+   pthread_mutex_unlock(&(RTW_ptr->mutex));
+
+   return;
+   }
 
-// Sanity check. We need 1000 additional bytes for the rest of the SQL_BStrings_insert_into_cnd below.
-   if ( strlen(BitstringASCII) > MAX_BSTRING_CMD_LEN - 1000 )
-      { printf("ERROR: SaveDBBitstringInfo(): SQL insert command %d is LARGER than MAX %d!\n", (int)strlen(SQL_BStrings_insert_into_cmd), MAX_BSTRING_CMD_LEN); exit(EXIT_FAILURE); }
 
-   sprintf(SQL_BStrings_insert_into_cmd, "INSERT INTO Bitstrings (DesignIndex, NetlistName, SynthesisName, InstanceName, Dev, Placement, PUFInstanceID, ChallengeSetName, \
-      CreationDate, SecurityFunction, FixParams, LFSRSeedLow, LFSRSeedHigh, RangeConstant, SpreadConstant, Threshold, Bitstring) VALUES \
-      (%d, '%s', '%s', '%s', '%s', '%s', %d, '%s', '%s', '%s', '%s', %d, %d, %d, %d, %d, '%s')", 
-      SAP_ptr->design_index, SAP_ptr->Netlist_name, SAP_ptr->Synthesis_name, InstanceName, Dev, Placement, PUF_instance_index_struct.int_arr[SAP_ptr->chip_num], 
-      SAP_ptr->ChallengeSetName_NAT, date_str, cur_func_str, fix_params_str, SAP_ptr->param_LFSR_seed_low, SAP_ptr->param_LFSR_seed_high, 
-      SAP_ptr->param_RangeConstant, SAP_ptr->param_SpreadConstant, SAP_ptr->param_Threshold, BitstringASCII);
+// ========================================================================================================
+// ========================================================================================================
+// Commit everything still queued, stop the writer thread, close its connection and destroy the locks. Every 
+// producer MUST be done with the writer before this returns; the struct is not usable afterwards.
+
+void RTBitstringWriterShutdown(RTBitstringWriterStruct *RTW_ptr)
+   {
+   pthread_mutex_lock(&(RTW_ptr->mutex));
+   RTW_ptr->stop = 1;
+   pthread_cond_signal(&(RTW_ptr->not_empty_cond));
+   pthread_cond_broadcast(&(RTW_ptr->not_full_cond));
+   pthread_mutex_unlock(&(RTW_ptr->mutex));
+   pthread_join(RTW_ptr->writer_thread, NULL);
+
+   printf("RTBitstringWriterShutdown(): %lu bitstrings inserted in %lu transactions, %lu rejected after stop\n", RTW_ptr->num_inserted, 
+      RTW_ptr->num_commits, RTW_ptr->num_rejected); 
+   fflush(stdout);
+
+   SQLStmtCacheFinalize(RTW_ptr->db);
+   sqlite3_close(RTW_ptr->db);
+   RTW_ptr->db = NULL;
+
+   pthread_cond_destroy(&(RTW_ptr->inserted_cond));
+   pthread_cond_destroy(&(RTW_ptr->not_full_cond));
+   pthread_cond_destroy(&(RTW_ptr->not_empty_cond));
+   pthread_mutex_destroy(&(RTW_ptr->mutex));
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Save the bitstrings from device/verifier authentication and session encryption to a database as they are
+// generated so we can later compute stats. With the RunTime DB writer (SAP_ptr->RTW_ptr), the row is queued 
+// and inserted in the background. Otherwise it is inserted here into SAP_ptr->database_RT, and the caller 
+// MUST hold the RT_DB mutex.
+
+void SaveDBBitstringInfo(int max_string_len, SRFAlgoParamsStruct *SAP_ptr, unsigned char *XMR_SHD, 
+   int num_XMR_SHD_bytes, int current_function)
+   {
+   RTBitstringRecordStruct *record_ptr;
 
 #ifdef DEBUG
-printf("SQL cmd: '%s'\n", SQL_BStrings_insert_into_cmd); fflush(stdout);
+printf("SaveDBBitstringInfo(): CALLED!\n"); fflush(stdout); 
 #endif
 
-// No callback for insert operation.
-   fc = sqlite3_exec(SAP_ptr->database_RT, SQL_BStrings_insert_into_cmd, NULL, 0, &zErrMsg);
-   if ( fc != SQLITE_OK )
-      { printf("ERROR: SaveDBBitstringInfo(): Function %s\tSQL ERROR: %s\n", cur_func_str, zErrMsg); sqlite3_free(zErrMsg); exit(EXIT_FAILURE); }
+   if ( (record_ptr = (RTBitstringRecordStruct *)malloc(sizeof(RTBitstringRecordStruct))) == NULL )
+      { printf("ERROR: SaveDBBitstringInfo(): Failed to allocate storage for record!\n"); exit(EXIT_FAILURE); }
+
+   if ( BuildDBBitstringRecord(max_string_len, SAP_ptr, XMR_SHD, num_XMR_SHD_bytes, current_function, record_ptr) == 0 )
+      {
+      free(record_ptr);
+      return;
+      }
+
+   if ( SAP_ptr->RTW_ptr != NULL )
+      RTBitstringWriterEnqueue(SAP_ptr->RTW_ptr, record_ptr);
+   else
+      {
+      InsertDBBitstringRecord(SAP_ptr->database_RT, record_ptr);
+      free(record_ptr->Bitstring);
+      free(record_ptr);
+      }
 
 #ifdef DEBUG
 printf("SaveDBBitstringInfo(): DONE!\n"); fflush(stdout); 
 #endif
 
-   if ( BitstringASCII != NULL )
-      free(BitstringASCII); 
-   if ( PUF_instance_index_struct.int_arr != NULL )
-      free(PUF_instance_index_struct.int_arr); 
-
    return;
    }
-
-
@@ -43,6 +43,15 @@ void GetAllUniqueChipsForDesignIndexAndFunctionName(int max_string_len, sqlite3
 int GetBitstringsCreationDateForChipNum(int max_string_len, sqlite3 *db, int design_index, char *chip_name, char *placement_name, 
    char *function_name, char ***Bitstrings_ptr, char ***CreationDate_ptr);
 
+int BuildDBBitstringRecord(int max_string_len, SRFAlgoParamsStruct *SAP_ptr, unsigned char *XMR_SHD, 
+   int num_XMR_SHD_bytes, int current_function, RTBitstringRecordStruct *record_ptr);
+void InsertDBBitstringRecord(sqlite3 *db, RTBitstringRecordStruct *record_ptr);
+
+void RTBitstringWriterInit(RTBitstringWriterStruct *RTW_ptr, char *DB_name_RunTime, int batch_size, int commit_interval_ms);
+void RTBitstringWriterEnqueue(RTBitstringWriterStruct *RTW_ptr, RTBitstringRecordStruct *record_ptr);
+void RTBitstringWriterFlush(RTBitstringWriterStruct *RTW_ptr);
+void RTBitstringWriterShutdown(RTBitstringWriterStruct *RTW_ptr);
+
 void SaveDBBitstringInfo(int max_string_len, SRFAlgoParamsStruct *SAP_ptr, unsigned char *XMR_SHD, 
    int num_XMR_SHD_bytes, int current_function);
 
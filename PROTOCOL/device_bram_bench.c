@@ -0,0 +1,244 @@
+// ========================================================================================================
+// ========================================================================================================
+// ****************************************** device_bram_bench.c *****************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+//
+// Integrity self-test and throughput benchmark of the block transfer backends in device_bram_xfer.c, run
+// against the word-level BRAM port of the software PL model (make sim). Each backend's transfer code runs
+// unchanged, the model playing the engine side of the GPIO handshake or of the mailbox BRAM. The blocks are
+// the ones moved during one KEK authentication:
+//
+//    SF load    : 2048 SpreadFactors, one 16-bit word each.
+//    SF unload  : the updated SpreadFactors.
+//    nonce load : the 16 byte KEK authentication nonce.
+//    SHD unload : 256 bytes of helper data or strong bitstring (done 4 times per authentication).
+//
+// The self-test moves random blocks (plus the empty and single word blocks) and compares both ends. The times
+// measure the device-side software cost per block, i.e., the number of register accesses and waits, and not
+// the AXI latency of a real board.
+//
+// Usage: device_bram_bench [num_iterations]
+
+#include "common.h"
+#include "device_hardware.h"
+#include "device_common.h"
+#include "device_hw_wait.h"
+#include "device_bram_xfer.h"
+#include "device_sim_PL.h"
+
+typedef struct
+   {
+   char *name;
+   int num_vals;
+   int load_or_unload;
+   int byte_or_word_data;
+   } BenchBlockStruct;
+
+static BenchBlockStruct Bench_blocks[] =
+   {
+   { "SF load", NUM_REQUIRED_PNDIFFS, 0, 1 },
+   { "SF unload", NUM_REQUIRED_PNDIFFS, 1, 1 },
+   { "nonce load", KEK_AUTHEN_NUM_NONCE_BITS/8, 0, 0 },
+   { "SHD unload", NUM_REQUIRED_PNDIFFS/8, 1, 0 },
+   };
+
+static DeviceSimPLStruct SimPL;
+static unsigned long long Bench_rng_state = 0x2545F4914F6CDD1DULL;
+
+
+// ========================================================================================================
+// ========================================================================================================
+// xorshift64 for the test patterns.
+
+static unsigned int BenchRand()
+   {
+   Bench_rng_state ^= Bench_rng_state >> 12;
+   Bench_rng_state ^= Bench_rng_state << 25;
+   Bench_rng_state ^= Bench_rng_state >> 27;
+   return (unsigned int)((Bench_rng_state * 0x2545F4914F6CDD1DULL) >> 32);
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Move one block with the current backend through the model's port. 'words' holds the 16-bit words the engine
+// side sees (what an unload returns). For loads the words the model received are left in SimPL.port_data.
+
+static void BenchTransfer(BenchBlockStruct *block_ptr, int num_vals, unsigned char *ByteData, signed short *WordData,
+   unsigned short *words)
+   {
+   volatile unsigned int *DataRegA = SimPL.regs;
+   volatile unsigned int *CtrlRegA = SimPL.regs + 2;
+   int num_words, port_mode, mailbox;
+
+   num_words = num_vals;
+   if ( block_ptr->byte_or_word_data == 0 )
+      num_words = num_vals/2;
+
+   mailbox = DeviceBRAMXferBackend() == BRAM_XFER_MMAP;
+   if ( block_ptr->load_or_unload == 0 )
+      port_mode = mailbox == 1 ? DEVICE_SIM_PORT_MAILBOX_LOAD : DEVICE_SIM_PORT_GPIO_LOAD;
+   else
+      port_mode = mailbox == 1 ? DEVICE_SIM_PORT_MAILBOX_UNLOAD : DEVICE_SIM_PORT_GPIO_UNLOAD;
+
+   DeviceSimPLArmPort(&SimPL, port_mode, words, num_words);
+   DeviceBRAMXfer(num_vals, CtrlRegA, DataRegA, 0, ByteData, WordData, block_ptr->load_or_unload, block_ptr->byte_or_word_data);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Self-test of one block type with 'num_vals' values of random data. Returns the number of mismatches.
+
+static int BenchSelfTest(BenchBlockStruct *block_ptr, int num_vals)
+   {
+   unsigned char ByteData[2*DEVICE_SIM_PORT_WORDS];
+   signed short WordData[DEVICE_SIM_PORT_WORDS];
+   unsigned short words[DEVICE_SIM_PORT_WORDS], expected;
+   int num_words, word_num, num_errors;
+
+   num_words = num_vals;
+   if ( block_ptr->byte_or_word_data == 0 )
+      num_words = num_vals/2;
+
+   for ( word_num = 0; word_num < num_words; word_num++ )
+      {
+      words[word_num] = (unsigned short)(BenchRand() & 0x0000FFFF);
+      ByteData[2*word_num] = (unsigned char)(BenchRand() & 0x000000FF);
+      ByteData[2*word_num+1] = (unsigned char)(BenchRand() & 0x000000FF);
+      WordData[word_num] = (signed short)(BenchRand() & 0x0000FFFF);
+      }
+
+   BenchTransfer(block_ptr, num_vals, ByteData, WordData, words);
+
+// Loads: the model MUST have received exactly the device's words. Unloads: the device MUST have exactly the model's words.
+   num_errors = 0;
+   if ( block_ptr->load_or_unload == 0 && SimPL.port_index != num_words )
+      {
+      printf("\t%s: %d values: model received %d words -- expected %d!\n", block_ptr->name, num_vals, SimPL.port_index, num_words);
+      num_errors++;
+      }
+   for ( word_num = 0; word_num < num_words; word_num++ )
+      {
+      if ( block_ptr->load_or_unload == 0 )
+         {
+         if ( block_ptr->byte_or_word_data == 0 )
+            expected = (unsigned short)(ByteData[2*word_num] | (ByteData[2*word_num+1] << 8));
+         else
+            expected = (unsigned short)WordData[word_num];
+         if ( SimPL.port_data[word_num] != expected )
+            num_errors++;
+         }
+      else
+         {
+         if ( block_ptr->byte_or_word_data == 0 )
+            {
+            if ( ByteData[2*word_num] != (words[word_num] & 0x00FF) || ByteData[2*word_num+1] != (words[word_num] >> 8) )
+               num_errors++;
+            }
+         else if ( (unsigned short)WordData[word_num] != words[word_num] )
+            num_errors++;
+         }
+      }
+
+   return num_errors;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Self-test and time every block type with the current backend. Returns the number of failed self-tests.
+
+static int BenchBackend(int num_iterations)
+   {
+   int num_blocks = sizeof(Bench_blocks)/sizeof(BenchBlockStruct);
+   unsigned char ByteData[2*DEVICE_SIM_PORT_WORDS];
+   signed short WordData[DEVICE_SIM_PORT_WORDS];
+   unsigned short words[DEVICE_SIM_PORT_WORDS];
+   int block_num, iter_num, test_num, num_failed, num_errors, num_words;
+   int test_sizes[4];
+   struct timeval t0, t1;
+   double elapsed_us;
+   BenchBlockStruct *block_ptr;
+   const char *backend_name = DeviceBRAMXferBackendName(DeviceBRAMXferBackend());
+
+   memset(ByteData, 0x5A, sizeof(ByteData));
+   memset(WordData, 0x5A, sizeof(WordData));
+   memset(words, 0xA5, sizeof(words));
+
+   num_failed = 0;
+   for ( block_num = 0; block_num < num_blocks; block_num++ )
+      {
+      block_ptr = &Bench_blocks[block_num];
+
+// Self-test: the empty block, one word, the full block and the full block again (new random data).
+      test_sizes[0] = 0;
+      test_sizes[1] = block_ptr->byte_or_word_data == 0 ? 2 : 1;
+      test_sizes[2] = block_ptr->num_vals;
+      test_sizes[3] = block_ptr->num_vals;
+      num_errors = 0;
+      for ( test_num = 0; test_num < 4; test_num++ )
+         num_errors += BenchSelfTest(block_ptr, test_sizes[test_num]);
+      if ( num_errors != 0 )
+         num_failed++;
+
+// Throughput
+      gettimeofday(&t0, 0);
+      for ( iter_num = 0; iter_num < num_iterations; iter_num++ )
+         BenchTransfer(block_ptr, block_ptr->num_vals, ByteData, WordData, words);
+      gettimeofday(&t1, 0);
+      elapsed_us = (double)((t1.tv_sec - t0.tv_sec)*1000000 + t1.tv_usec - t0.tv_usec);
+
+      num_words = block_ptr->num_vals;
+      if ( block_ptr->byte_or_word_data == 0 )
+         num_words = block_ptr->num_vals/2;
+      printf("%-5s  %-11s  words %5d\tself-test %s\tave %9.2f us/block\t%7.1f ns/word\t%8.2f MB/s\n", backend_name, block_ptr->name,
+         num_words, num_errors == 0 ? "PASS" : "FAIL", elapsed_us/num_iterations, elapsed_us*1000.0/num_iterations/num_words,
+         (double)num_words*2.0*num_iterations/elapsed_us);
+      fflush(stdout);
+      }
+
+   return num_failed;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+
+int main(int argc, char *argv[])
+   {
+   int num_iterations, num_failed;
+
+   num_iterations = 200;
+   if ( argc > 1 )
+      num_iterations = atoi(argv[1]);
+   if ( num_iterations <= 0 )
+      { printf("ERROR: main(): Number of iterations must be positive!\n"); exit(EXIT_FAILURE); }
+
+// The port of the model is the only part used: no database, the engine idle.
+   memset(&SimPL, 0, sizeof(DeviceSimPLStruct));
+   SimPL.regs[0] = (1 << IN_SM_READY);
+
+   num_failed = 0;
+   DeviceBRAMXferInit(BRAM_XFER_GPIO, NULL, 0);
+   num_failed += BenchBackend(num_iterations);
+   DeviceBRAMXferInit(BRAM_XFER_MMAP, SimPL.window, DEVICE_SIM_PORT_WORDS);
+   num_failed += BenchBackend(num_iterations);
+
+   DeviceHWWaitPrintStats("HW WAITS: ");
+   if ( num_failed != 0 )
+      { printf("ERROR: main(): %d self-tests FAILED!\n", num_failed); exit(EXIT_FAILURE); }
+   printf("All self-tests PASSED\n");
+
+   return 0;
+   }
@@ -0,0 +1,244 @@
+// ========================================================================================================
+// ========================================================================================================
+// ****************************************** device_bram_xfer.c ******************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+//
+// Block transfers of the SpreadFactors, nonces and helper data between the device and the PNL BRAM, called
+// by LoadUnloadBRAM(). There are three backends:
+//
+//    BRAM_XFER_GPIO: The original transfer through CtrlRegA/DataRegA with a full handshake per 16-bit word.
+//    BRAM_XFER_MMAP: The block is copied to or from a mailbox BRAM mapped into the address space (an AXI BRAM
+//       controller, one 16-bit word per 32-bit location) and the whole block is handed over with ONE
+//       handshake, which carries the number of words in the low 16 bits of CtrlRegA together with
+//       OUT_CP_LM_ULM_DONE. Requires a bitstream with the mailbox BRAM; the engine moves the block between the
+//       mailbox and the PNL BRAM itself.
+//    BRAM_XFER_SIM: The software PL model of the device simulator takes or returns the whole block at once.
+//
+// An AXI DMA engine was not used: the blocks are at most a few KB, where setting up a DMA transfer costs more
+// than copying through the mapping.
+
+#include "common.h"
+#include "device_hardware.h"
+#include "device_common.h"
+#include "device_hw_wait.h"
+#include "device_bram_xfer.h"
+
+#ifdef DEVICE_SIM
+#include "device_sim_PL.h"
+#endif
+
+// Set once by DeviceBRAMXferInit(). The simulator builds default to the model.
+#ifdef DEVICE_SIM
+static DeviceBRAMXferStruct BRAMXfer = {BRAM_XFER_SIM, NULL, 0};
+#else
+static DeviceBRAMXferStruct BRAMXfer = {BRAM_XFER_GPIO, NULL, 0};
+#endif
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Select the backend. 'BRAM_window' is the mapped mailbox BRAM of 'BRAM_num_words' 32-bit locations, only
+// used (and required) by BRAM_XFER_MMAP.
+
+void DeviceBRAMXferInit(int backend, volatile unsigned int *BRAM_window, int BRAM_num_words)
+   {
+   if ( backend != BRAM_XFER_GPIO && backend != BRAM_XFER_MMAP && backend != BRAM_XFER_SIM )
+      { printf("ERROR: DeviceBRAMXferInit(): Unknown backend %d!\n", backend); exit(EXIT_FAILURE); }
+
+#ifndef DEVICE_SIM
+   if ( backend == BRAM_XFER_SIM )
+      { printf("ERROR: DeviceBRAMXferInit(): The '%s' backend is only available in the simulator build!\n", DeviceBRAMXferBackendName(backend)); exit(EXIT_FAILURE); }
+#endif
+
+   if ( backend == BRAM_XFER_MMAP && (BRAM_window == NULL || BRAM_num_words < BRAM_XFER_MAX_WORDS) )
+      {
+      printf("ERROR: DeviceBRAMXferInit(): The '%s' backend needs a mailbox BRAM of at least %d words -- got %d!\n",
+         DeviceBRAMXferBackendName(backend), BRAM_XFER_MAX_WORDS, BRAM_num_words);
+      exit(EXIT_FAILURE);
+      }
+
+   BRAMXfer.backend = backend;
+   BRAMXfer.BRAM_window = BRAM_window;
+   BRAMXfer.BRAM_num_words = BRAM_num_words;
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// The current backend and the backend names for messages.
+
+int DeviceBRAMXferBackend()
+   {
+   return BRAMXfer.backend;
+   }
+
+
+const char *DeviceBRAMXferBackendName(int backend)
+   {
+   if ( backend == BRAM_XFER_GPIO )
+      return "gpio";
+   else if ( backend == BRAM_XFER_MMAP )
+      return "mmap";
+   else if ( backend == BRAM_XFER_SIM )
+      return "sim";
+   return "unknown";
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// GPIO backend. A full handshake per 16-bit word: wait for 'stopped' (IN_SM_HANDSHAKE), put the word on
+// CtrlRegA (load) or read it from DataRegA (unload) and assert 'continue' (OUT_CP_HANDSHAKE), wait for
+// 'stopped' to go low, then de-assert 'continue', asserting OUT_CP_LM_ULM_DONE with the last word.
+
+static void DeviceBRAMXferGPIO(int num_vals, volatile unsigned int *CtrlRegA, volatile unsigned int *DataRegA, unsigned int ctrl_mask,
+   unsigned char *ByteData, signed short *WordData, int load_or_unload, int byte_or_word_data)
+   {
+   int val_num, increment;
+
+   if ( byte_or_word_data == 0 )
+      increment = 2;
+   else
+      increment = 1;
+
+   for ( val_num = 0; val_num < num_vals; val_num += increment )
+      {
+
+#ifdef DEBUG
+printf("%4d) Load/unload %d\t\n", val_num, load_or_unload); fflush(stdout);
+#endif
+
+// Wait for 'stopped' from hardware to be asserted, which indicates that the hardware is ready to receive a byte. The wait warns
+// periodically if it never comes (Locked UP?).
+      DeviceHWWaitBits(DataRegA, 1 << IN_SM_HANDSHAKE, 1 << IN_SM_HANDSHAKE, HW_WAIT_FOREVER);
+
+// Put the data bytes into the register and assert 'continue' (OUT_CP_HANDSHAKE). iSpreadFactors are loaded one in each 16-bit word of PNL BRAM, so
+// byte_or_word_data is set to 1 for SpreadFactor loads/unloads
+      if ( load_or_unload == 0 )
+         {
+         if ( byte_or_word_data == 0 )
+            *CtrlRegA = ctrl_mask | (1 << OUT_CP_HANDSHAKE) | (0x000000FF & ByteData[val_num]) | (0x0000FF00 & (ByteData[val_num+1] << 8));
+         else
+            *CtrlRegA = ctrl_mask | (1 << OUT_CP_HANDSHAKE) | (0x0000FFFF & WordData[val_num]);
+         }
+
+// When 'stopped' is asserted, the data is ready on the output register from the PNL BRAM -- get it.
+      else
+         {
+         if ( byte_or_word_data == 0 )
+            {
+            ByteData[val_num] = (0x000000FF & *DataRegA);
+            ByteData[val_num+1] = ((0x0000FF00 & *DataRegA) >> 8);
+            }
+         else
+            WordData[val_num] = (0x0000FFFF & *DataRegA);
+
+         *CtrlRegA = ctrl_mask | (1 << OUT_CP_HANDSHAKE);
+         }
+
+// Wait for hardware to de-assert 'stopped' (it got the byte).
+      DeviceHWWaitBits(DataRegA, 1 << IN_SM_HANDSHAKE, 0, HW_WAIT_FOREVER);
+
+// De-assert 'continue'. ALSO, assert 'done' (OUT_CP_LM_ULM_DONE) SIMULTANEOUSLY to tell hardware this is the last word.
+      if ( val_num == num_vals - increment )
+         *CtrlRegA = ctrl_mask | (1 << OUT_CP_LM_ULM_DONE);
+      else
+         *CtrlRegA = ctrl_mask;
+      }
+
+// Handle case where 'num_vals' is 0.
+   if ( num_vals == 0 )
+      *CtrlRegA = ctrl_mask | (1 << OUT_CP_LM_ULM_DONE);
+
+// De-assert 'OUT_CP_LM_ULM_DONE'
+   *CtrlRegA = ctrl_mask;
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// mmap backend. Wait for 'stopped' as for the first word of the GPIO transfer, at which point the engine is
+// ready for the block (load) or has staged it in the mailbox (unload). Copy the block, then hand it over with
+// one handshake that carries the number of 16-bit words. Byte data is packed two bytes per word, low-order
+// byte first, as in the GPIO transfer.
+
+static void DeviceBRAMXferMMAP(int num_vals, volatile unsigned int *CtrlRegA, volatile unsigned int *DataRegA, unsigned int ctrl_mask,
+   unsigned char *ByteData, signed short *WordData, int load_or_unload, int byte_or_word_data)
+   {
+   volatile unsigned int *window = BRAMXfer.BRAM_window;
+   int num_words, word_num;
+   unsigned int word;
+
+   if ( byte_or_word_data == 0 )
+      num_words = num_vals/2;
+   else
+      num_words = num_vals;
+
+   if ( num_words > BRAMXfer.BRAM_num_words )
+      { printf("ERROR: DeviceBRAMXferMMAP(): Block of %d words larger than the mailbox BRAM (%d words)!\n", num_words, BRAMXfer.BRAM_num_words); exit(EXIT_FAILURE); }
+
+   DeviceHWWaitBits(DataRegA, 1 << IN_SM_HANDSHAKE, 1 << IN_SM_HANDSHAKE, HW_WAIT_FOREVER);
+
+   if ( load_or_unload == 0 )
+      {
+      if ( byte_or_word_data == 0 )
+         for ( word_num = 0; word_num < num_words; word_num++ )
+            window[word_num] = (0x000000FF & ByteData[2*word_num]) | (0x0000FF00 & (ByteData[2*word_num+1] << 8));
+      else
+         for ( word_num = 0; word_num < num_words; word_num++ )
+            window[word_num] = 0x0000FFFF & WordData[word_num];
+      }
+   else
+      {
+      for ( word_num = 0; word_num < num_words; word_num++ )
+         {
+         word = window[word_num];
+         if ( byte_or_word_data == 0 )
+            {
+            ByteData[2*word_num] = (0x000000FF & word);
+            ByteData[2*word_num+1] = ((0x0000FF00 & word) >> 8);
+            }
+         else
+            WordData[word_num] = (0x0000FFFF & word);
+         }
+      }
+
+   *CtrlRegA = ctrl_mask | (1 << OUT_CP_HANDSHAKE) | (1 << OUT_CP_LM_ULM_DONE) | (0x0000FFFF & num_words);
+   DeviceHWWaitBits(DataRegA, 1 << IN_SM_HANDSHAKE, 0, HW_WAIT_FOREVER);
+   *CtrlRegA = ctrl_mask;
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Transfer 'num_vals' values into (load_or_unload 0) or out of (1) the PNL BRAM with the current backend.
+// 'byte_or_word_data' 0 moves ByteData two bytes per 16-bit word ('num_vals' MUST be even), 1 moves WordData.
+
+void DeviceBRAMXfer(int num_vals, volatile unsigned int *CtrlRegA, volatile unsigned int *DataRegA, unsigned int ctrl_mask,
+   unsigned char *ByteData, signed short *WordData, int load_or_unload, int byte_or_word_data)
+   {
+   if ( BRAMXfer.backend == BRAM_XFER_GPIO )
+      DeviceBRAMXferGPIO(num_vals, CtrlRegA, DataRegA, ctrl_mask, ByteData, WordData, load_or_unload, byte_or_word_data);
+   else if ( BRAMXfer.backend == BRAM_XFER_MMAP )
+      DeviceBRAMXferMMAP(num_vals, CtrlRegA, DataRegA, ctrl_mask, ByteData, WordData, load_or_unload, byte_or_word_data);
+#ifdef DEVICE_SIM
+   else
+      DeviceSimPLTransferBRAM(DeviceSimPLFromRegs(DataRegA), num_vals, ByteData, WordData, load_or_unload, byte_or_word_data);
+#endif
+
+   return;
+   }
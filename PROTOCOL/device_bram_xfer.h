@@ -0,0 +1,32 @@
+// ========================================================================================================
+// ========================================================================================================
+// ****************************************** device_bram_xfer.h ******************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+
+#ifndef DEVICE_BRAM_XFER_INCLUDED
+
+// Backends
+#define BRAM_XFER_GPIO 0
+#define BRAM_XFER_MMAP 1
+#define BRAM_XFER_SIM 2
+
+// Largest block, the SpreadFactors (one 16-bit word each). The mailbox BRAM MUST hold at least this many words.
+#define BRAM_XFER_MAX_WORDS NUM_REQUIRED_PNDIFFS
+
+#define DEVICE_BRAM_XFER_INCLUDED
+#endif
+
+void DeviceBRAMXferInit(int backend, volatile unsigned int *BRAM_window, int BRAM_num_words);
+int DeviceBRAMXferBackend();
+const char *DeviceBRAMXferBackendName(int backend);
+
+void DeviceBRAMXfer(int num_vals, volatile unsigned int *CtrlRegA, volatile unsigned int *DataRegA, unsigned int ctrl_mask,
+   unsigned char *ByteData, signed short *WordData, int load_or_unload, int byte_or_word_data);
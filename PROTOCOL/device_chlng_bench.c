@@ -0,0 +1,179 @@
+// ========================================================================================================
+// ========================================================================================================
+// ***************************************** device_chlng_bench.c *****************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+//
+// Correctness test and benchmark of the challenge loading in CollectPNs() against the register-level vector
+// interface of the software PL model (make sim). Random challenges and masks are delivered with the vectors
+// loaded as they are requested (stage 0) and with the double-buffered staging at several chunk sizes, including
+// chunks that do not divide the number of vectors and a chunk larger than the challenge. The model takes
+// 'vec_latency_us' to measure each vector, so the time CollectPNs() spends beyond num_vecs * vec_latency_us is the
+// device-side cost on the critical path. Every vector and mask the model received is compared with the one sent.
+//
+// Usage: device_chlng_bench [num_vecs] [vec_latency_us] [num_iterations]
+
+#include "common.h"
+#include "device_hardware.h"
+#include "device_common.h"
+#include "device_hw_wait.h"
+#include "device_regen_funcs.h"
+#include "device_sim_PL.h"
+
+static DeviceSimPLStruct SimPL;
+static unsigned long long Bench_rng_state = 0x2545F4914F6CDD1DULL;
+
+
+// ========================================================================================================
+// ========================================================================================================
+// xorshift64 for the test challenges.
+
+static unsigned char BenchRandByte()
+   {
+   Bench_rng_state ^= Bench_rng_state >> 12;
+   Bench_rng_state ^= Bench_rng_state << 25;
+   Bench_rng_state ^= Bench_rng_state >> 27;
+   return (unsigned char)((Bench_rng_state * 0x2545F4914F6CDD1DULL) >> 56);
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Number of vectors whose challenge or mask received by the model differs from the one sent.
+
+static int BenchCompareVecs(int num_vecs, int num_PIs, int num_POs, unsigned char **first_vecs_b, unsigned char **second_vecs_b,
+   unsigned char **masks_b, unsigned char **PL_first_vecs_b, unsigned char **PL_second_vecs_b, unsigned char **PL_masks_b)
+   {
+   int vec_num, num_errors;
+
+   num_errors = 0;
+   for ( vec_num = 0; vec_num < num_vecs; vec_num++ )
+      if ( memcmp(first_vecs_b[vec_num], PL_first_vecs_b[vec_num], num_PIs/8) != 0 ||
+         memcmp(second_vecs_b[vec_num], PL_second_vecs_b[vec_num], num_PIs/8) != 0 ||
+         memcmp(masks_b[vec_num], PL_masks_b[vec_num], num_POs/8) != 0 )
+         num_errors++;
+
+   return num_errors;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+
+int main(int argc, char *argv[])
+   {
+   int num_vecs, num_PIs, num_POs, num_iterations, num_failed;
+   long vec_latency_us;
+
+   int stage_sizes[6];
+   int num_stage_sizes = 6;
+   int stage_num, iter_num, vec_num, byte_num, num_errors;
+   unsigned char **first_vecs_b, **second_vecs_b, **masks_b;
+   unsigned char **PL_first_vecs_b, **PL_second_vecs_b, **PL_masks_b;
+   int PL_num_vecs, PL_num_rise_vecs;
+   unsigned char device_n1[MAX_GENERATED_NONCE_BYTES];
+
+   struct timeval t0, t1;
+   long elapsed, tot_elapsed, min_elapsed;
+
+   num_vecs = 300;
+   vec_latency_us = 20;
+   num_iterations = 3;
+   if ( argc > 1 )
+      num_vecs = atoi(argv[1]);
+   if ( argc > 2 )
+      vec_latency_us = atol(argv[2]);
+   if ( argc > 3 )
+      num_iterations = atoi(argv[3]);
+   if ( num_vecs <= 0 || vec_latency_us < 0 || num_iterations <= 0 )
+      { printf("ERROR: main(): Number of vectors and iterations must be positive and the latency >= 0!\n"); exit(EXIT_FAILURE); }
+
+   num_PIs = NUM_PIS;
+   num_POs = NUM_POS;
+
+// Stage 0 is the original loading. The others: one vector, a chunk that does not divide the number of vectors, the default, and
+// chunks of half and more than all of the vectors.
+   stage_sizes[0] = 0;
+   stage_sizes[1] = 1;
+   stage_sizes[2] = 7;
+   stage_sizes[3] = CHLNG_STAGE_VECS;
+   stage_sizes[4] = num_vecs/2 + 1;
+   stage_sizes[5] = num_vecs + 5;
+
+   if ( (first_vecs_b = (unsigned char **)malloc(sizeof(unsigned char *) * num_vecs)) == NULL ||
+      (second_vecs_b = (unsigned char **)malloc(sizeof(unsigned char *) * num_vecs)) == NULL ||
+      (masks_b = (unsigned char **)malloc(sizeof(unsigned char *) * num_vecs)) == NULL )
+      { printf("ERROR: main(): Failed to allocate storage for the vectors!\n"); exit(EXIT_FAILURE); }
+   for ( vec_num = 0; vec_num < num_vecs; vec_num++ )
+      {
+      if ( (first_vecs_b[vec_num] = (unsigned char *)malloc(num_PIs/8)) == NULL || (second_vecs_b[vec_num] = (unsigned char *)malloc(num_PIs/8)) == NULL ||
+         (masks_b[vec_num] = (unsigned char *)malloc(num_POs/8)) == NULL )
+         { printf("ERROR: main(): Failed to allocate storage for vector %d!\n", vec_num); exit(EXIT_FAILURE); }
+      for ( byte_num = 0; byte_num < num_PIs/8; byte_num++ )
+         {
+         first_vecs_b[vec_num][byte_num] = BenchRandByte();
+         second_vecs_b[vec_num][byte_num] = BenchRandByte();
+         }
+      for ( byte_num = 0; byte_num < num_POs/8; byte_num++ )
+         masks_b[vec_num][byte_num] = BenchRandByte();
+      }
+
+// Only the registers and the vector interface of the model are used: no database, the engine idle.
+   memset(&SimPL, 0, sizeof(DeviceSimPLStruct));
+   SimPL.regs[0] = (1 << IN_SM_READY);
+   SimPL.vec_latency_us = vec_latency_us;
+
+   printf("PARAMETERS: Vectors %d\tPIs %d\tPOs %d\tMeasure latency %ld us/vector\tIterations %d\n", num_vecs, num_PIs, num_POs,
+      vec_latency_us, num_iterations); fflush(stdout);
+
+   num_failed = 0;
+   for ( stage_num = 0; stage_num < num_stage_sizes; stage_num++ )
+      {
+      num_errors = 0;
+      tot_elapsed = 0;
+      min_elapsed = 0;
+      for ( iter_num = 0; iter_num < num_iterations; iter_num++ )
+         {
+         DeviceSimPLArmVecs(&SimPL, num_vecs, num_PIs, num_POs, 1);
+         gettimeofday(&t0, 0);
+         CollectPNs(MAX_STRING_LEN, num_POs, num_PIs, CHLNG_CHUNK_SIZE, stage_sizes[stage_num], MAX_GENERATED_NONCE_BYTES, SimPL.regs + 2,
+            SimPL.regs, 0, num_vecs, num_vecs/2, 1, first_vecs_b, second_vecs_b, masks_b, device_n1, 0, 0);
+         gettimeofday(&t1, 0);
+         elapsed = (t1.tv_sec - t0.tv_sec)*1000000 + t1.tv_usec - t0.tv_usec;
+         tot_elapsed += elapsed;
+         if ( iter_num == 0 || elapsed < min_elapsed )
+            min_elapsed = elapsed;
+
+         DeviceSimPLGetVecs(&SimPL, num_PIs, num_POs, 1, &PL_first_vecs_b, &PL_second_vecs_b, &PL_masks_b);
+         num_errors += BenchCompareVecs(num_vecs, num_PIs, num_POs, first_vecs_b, second_vecs_b, masks_b, PL_first_vecs_b, PL_second_vecs_b,
+            PL_masks_b);
+         PL_num_vecs = num_vecs;
+         PL_num_rise_vecs = 0;
+         FreeVectorsAndMasks(&PL_num_vecs, &PL_num_rise_vecs, &PL_first_vecs_b, &PL_second_vecs_b, &PL_masks_b);
+         }
+      if ( num_errors != 0 )
+         num_failed++;
+
+      printf("Stage vecs %4d\tcorrectness %s (%d bad vectors)\tave %9.1f us\tmin %8ld us\tdevice-side %7.2f us/vector\n", stage_sizes[stage_num],
+         num_errors == 0 ? "PASS" : "FAIL", num_errors, (double)tot_elapsed/num_iterations, min_elapsed,
+         (double)(min_elapsed - num_vecs*vec_latency_us)/num_vecs);
+      fflush(stdout);
+      }
+
+   FreeVectorsAndMasks(&num_vecs, &num_vecs, &first_vecs_b, &second_vecs_b, &masks_b);
+   DeviceSimPLClose(&SimPL);
+
+   DeviceHWWaitPrintStats("HW WAITS: ");
+   if ( num_failed != 0 )
+      { printf("ERROR: main(): %d correctness tests FAILED!\n", num_failed); exit(EXIT_FAILURE); }
+   printf("All correctness tests PASSED\n");
+
+   return 0;
+   }
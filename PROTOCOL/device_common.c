@@ -15,6 +15,7 @@
 #include "device_hardware.h"
 #include "device_common.h"
 #include "device_regen_funcs.h"
+#include "device_hw_wait.h"
 
 // ========================================================================================================
 // ========================================================================================================
@@ -207,10 +208,8 @@ void LoadChlngAndMask(int max_string_len, volatile unsigned int *CtrlRegA, volat
    if ( (num_chlng_bits % chlng_chunk_size) != 0 )
       { printf("ERROR: LoadChlngAndMask(): Challenge size %d must be evenly divisible by %d!\n", num_chlng_bits, chlng_chunk_size); exit(EXIT_FAILURE); }
 
-// Reset the VHDL pointers to the challenge buffers. 
-   *CtrlRegA = ctrl_mask | (1 << OUT_CP_DTO_RESTART);
-   usleep(1000);
-   *CtrlRegA = ctrl_mask;
+// Reset the VHDL pointers to the challenge buffers. There is no acknowledge for the restart so it is held for the minimum pulse width.
+   DeviceHWPulse(CtrlRegA, DataRegA, ctrl_mask, OUT_CP_DTO_RESTART, 0, 0, HW_WAIT_SETTLE);
 
 #ifdef DEBUG
 printf("LoadChlngAndMask(): Reset VHDL challenge pointers!\n"); fflush(stdout);
@@ -260,7 +259,7 @@ printf("LoadChlngAndMask(): 16-bit chunk %d in hex '%04X'\n", word_num, chlng_va
 // 2) Wait for 'done_reading to go to 1 (it is low by default). State machine latches data in 2 clk cycles. 
 //    Maintain 1 on 'data_ready' and continue to hold 16-bit binary chunk.
 // printf("LoadChlngAndMask(): Waiting state machine 'done_reading' to be set to '1'\n"); fflush(stdout);
-         while ( (*DataRegA & (1 << IN_SM_DTO_DONE_READING)) == 0 );
+         DeviceHWWaitBits(DataRegA, 1 << IN_SM_DTO_DONE_READING, 1 << IN_SM_DTO_DONE_READING, HW_WAIT_FOREVER);
 
 // 3) Once 'done_reading' goes to 1, set 'data_ready' to 0 and remove chunk;
 // printf("LoadChlngAndMask(): De-asserting 'data_ready'\n"); fflush(stdout);
@@ -268,7 +267,7 @@ printf("LoadChlngAndMask(): 16-bit chunk %d in hex '%04X'\n", word_num, chlng_va
 
 // 4) Wait for 'done_reading to go to 0.
 // printf("LoadChlngAndMask(): Waiting state machine 'done_reading' to be set to '0'\n"); fflush(stdout);
-         while ( (*DataRegA & (1 << IN_SM_DTO_DONE_READING)) != 0 );
+         DeviceHWWaitBits(DataRegA, 1 << IN_SM_DTO_DONE_READING, 0, HW_WAIT_FOREVER);
 
 // printf("LoadChlngAndMask(): Done handshake associated with challenge chunk transfer\n"); fflush(stdout);
          }
@@ -282,6 +281,77 @@ printf("LoadChlngAndMask(): 16-bit chunk %d in hex '%04X'\n", word_num, chlng_va
    }
 
 
+// ========================================================================================================
+// ========================================================================================================
+// Stage a challenge plus optionally a mask for LoadStagedChlngAndMask(): the CtrlRegA values of step 1 of the
+// handshake ('data_ready' plus the 16-bit chunk), in the order LoadChlngAndMask() sends them. The challenge is
+// the first vector followed by the second, as joined by ConvertVecsToChallenge(). Returns the number of words.
+
+int StageChlngAndMask(int num_PIs, unsigned char *first_vec_b, unsigned char *second_vec_b, int has_masks, int num_POs, 
+   unsigned char *mask_b, unsigned int ctrl_mask, int chlng_chunk_size, unsigned int *staged_words)
+   {
+   int num_chlng_bits = num_PIs * 2;
+   int num_vec_bytes = num_PIs/8;
+   int word_num, num_words, byte_num, i;
+   unsigned char chlng_bytes[2];
+
+// Sanity check
+   if ( (num_chlng_bits % chlng_chunk_size) != 0 || (has_masks == 1 && (num_POs % chlng_chunk_size) != 0) )
+      { printf("ERROR: StageChlngAndMask(): Challenge size %d and mask size %d must be evenly divisible by %d!\n", num_chlng_bits, num_POs, chlng_chunk_size); exit(EXIT_FAILURE); }
+
+   num_words = 0;
+   for ( word_num = 0; word_num < num_chlng_bits/chlng_chunk_size; word_num++ )
+      {
+      for ( i = 0; i < 2; i++ )
+         {
+         byte_num = word_num*2 + i;
+         if ( byte_num < num_vec_bytes )
+            chlng_bytes[i] = first_vec_b[byte_num];
+         else
+            chlng_bytes[i] = second_vec_b[byte_num - num_vec_bytes];
+         }
+      staged_words[num_words++] = ctrl_mask | (1 << OUT_CP_DTO_DATA_READY) | (chlng_bytes[1] << 8) | chlng_bytes[0];
+      }
+
+   if ( has_masks == 1 )
+      for ( word_num = 0; word_num < num_POs/chlng_chunk_size; word_num++ )
+         staged_words[num_words++] = ctrl_mask | (1 << OUT_CP_DTO_DATA_READY) | (mask_b[word_num*2 + 1] << 8) | mask_b[word_num*2];
+
+   return num_words;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Transfer a challenge (and mask) staged by StageChlngAndMask() through the GPIO to the VHDL side. Same
+// protocol as LoadChlngAndMask() with nothing left to compute between the handshakes.
+
+void LoadStagedChlngAndMask(volatile unsigned int *CtrlRegA, volatile unsigned int *DataRegA, unsigned int ctrl_mask, 
+   int num_words, unsigned int *staged_words)
+   {
+   int word_num;
+
+// Reset the VHDL pointers to the challenge buffers.
+   DeviceHWPulse(CtrlRegA, DataRegA, ctrl_mask, OUT_CP_DTO_RESTART, 0, 0, HW_WAIT_SETTLE);
+
+// Four step protocol per 16-bit chunk: assert 'data_ready' with the chunk, wait for 'done_reading', de-assert 'data_ready', wait for 
+// 'done_reading' to go low.
+   for ( word_num = 0; word_num < num_words; word_num++ )
+      {
+      *CtrlRegA = staged_words[word_num];
+      DeviceHWWaitBits(DataRegA, 1 << IN_SM_DTO_DONE_READING, 1 << IN_SM_DTO_DONE_READING, HW_WAIT_FOREVER);
+      *CtrlRegA = ctrl_mask;
+      DeviceHWWaitBits(DataRegA, 1 << IN_SM_DTO_DONE_READING, 0, HW_WAIT_FOREVER);
+      }
+
+// Tell CollectPNs that the challenge and possibly a mask have been loaded.
+   *CtrlRegA = ctrl_mask | (1 << OUT_CP_DTO_VEC_LOADED);
+   *CtrlRegA = ctrl_mask;
+
+   return;
+   }
+
+
 // ========================================================================================================
 // ========================================================================================================
 // DEBUG ROUTINE. Check that the vectors received are precisely the same as the ones stored in the file on 
@@ -393,7 +463,7 @@ int GoGetVectors(int max_string_len, int num_POs, int num_PIs, int verifier_sock
    int *has_masks_ptr, unsigned char ***first_vecs_b_ptr, unsigned char ***second_vecs_b_ptr, 
    unsigned char ***masks_b_ptr, int send_GO, int use_database_chlngs, sqlite3 *DB, int DB_design_index,
    char *DB_ChallengeSetName, int gen_or_use_challenge_seed, unsigned int *DB_ChallengeGen_seed_ptr, 
-   pthread_mutex_t *GenChallenge_mutex_ptr, int debug_flag)
+   int chlng_rng_mode, int debug_flag)
    {
    int num_vecs;
 
@@ -459,7 +529,7 @@ fflush(stdout);
 // challenges. It returns a set of binary vectors and masks as well as a data structure that allows the enrollment timing values 
 // that are tested by these vectors to be looked up by the caller.
       GenChallengeDB(max_string_len, DB, DB_design_index, DB_ChallengeSetName, *DB_ChallengeGen_seed_ptr, 0, NULL, NULL, 
-         first_vecs_b_ptr, second_vecs_b_ptr, masks_b_ptr, &num_vecs, num_rise_vecs_ptr, GenChallenge_mutex_ptr,
+         first_vecs_b_ptr, second_vecs_b_ptr, masks_b_ptr, &num_vecs, num_rise_vecs_ptr, chlng_rng_mode,
          &num_challenge_vecpair_id_PO, &challenge_vecpair_id_PO_arr);
 
 // We always generate masks during the database vector selection process.
@@ -87,6 +87,7 @@ typedef struct
    int DB_design_index;
    char *DB_ChallengeSetName;
    unsigned int DB_ChallengeGen_seed;
+   int chlng_rng_mode;
 
 // MAKE protocol
    sqlite3 *DB_MAKE_PT_AT;
@@ -142,6 +143,9 @@ typedef struct
    int max_generated_nonce_bytes; 
 
    int vec_chunk_size;
+
+// Number of vectors per chunk of the double-buffered challenge pipeline in CollectPNs(). 0 loads each vector as it is requested.
+   int chlng_stage_vecs;
    int XMR_val;
 
    unsigned char AES_IV[AES_IV_NUM_BYTES];
@@ -208,17 +212,137 @@ typedef struct
    int total_bits; 
    int iteration; 
 
-   pthread_mutex_t *GenChallenge_mutex_ptr;
-
    int do_COBRA;
 
    int DUMP_BITSTRINGS; 
    int DEBUG_FLAG; 
    } SRFHardwareParamsStruct;
 
+// Software model of the PL side used by the host-native device simulator (DEVICE_SIM, device_sim_PL.c). 'regs' MUST be
+// the first field: the device code is given DataRegA = regs and CtrlRegA = regs + 2 in place of the GPIO mmap, and the
+// simulator hooks find the model from DataRegA. The PNs of one PUFInstance are served from the NAT timing database plus
+// Gaussian noise and the SRF engine runs in software with the verifier's fixed-point primitives.
+#define DEVICE_SIM_NUM_REGS 4
+#define DEVICE_SIM_NUM_PARAMS 14
+#define DEVICE_SIM_PORT_WORDS NUM_REQUIRED_PNDIFFS
+
+typedef struct
+   {
+   volatile unsigned int regs[DEVICE_SIM_NUM_REGS];
+
+   sqlite3 *DB_NAT;
+   int design_index;
+   char *ChallengeSetName;
+   char *PUF_instance_name;
+   int PUF_instance_index;
+
+// Standard deviation of the noise added to every enrolled PN, in the PN units of the TimingVals (1/16 resolution).
+   float noise_sigma;
+   unsigned long long rng_state;
+
+   int16_t PNR16[NUM_REQUIRED_PNDIFFS];
+   int16_t PNF16[NUM_REQUIRED_PNDIFFS];
+   int16_t SF16[NUM_REQUIRED_PNDIFFS];
+   int16_t PND16[NUM_REQUIRED_PNDIFFS];
+   int16_t PNDc16[NUM_REQUIRED_PNDIFFS];
+   int16_t PNDco16[NUM_REQUIRED_PNDIFFS];
+   int PNs_collected;
+
+// Parameters in the order SelectSetParams() transfers them, and the state of the engine for the current parameters.
+   unsigned short params[DEVICE_SIM_NUM_PARAMS];
+   int num_params_loaded;
+   int SRF_done;
+
+// KEK SKE enrollment outputs, unloaded in the order SBG SHD, SBG SBS, XMR SHD, XMR SBS.
+   unsigned char nonce[KEK_AUTHEN_NUM_NONCE_BITS/8];
+   unsigned char SBG_SHD[NUM_REQUIRED_PNDIFFS/8];
+   unsigned char SBG_SBS[NUM_REQUIRED_PNDIFFS/8];
+   unsigned char XMR_SHD[NUM_REQUIRED_PNDIFFS/8];
+   unsigned char XMR_SBS[NUM_REQUIRED_PNDIFFS/8];
+   int num_SBG_SBS_bits;
+   int num_encoded_bits;
+   int num_unloads;
+
+// One PN set is collected per DA attempt. PL_usecs is the wall time spent computing in the model and first_PNs_tv is when the 
+// first PN set was ready, for the per-phase timings of the load generator.
+   int num_authen_PN_sets;
+   int num_SRF_runs;
+   long PL_usecs;
+   struct timeval first_PNs_tv;
+
+// Register-level behaviour seen by the polling loops (DeviceSimPLPoll): a rising edge of OUT_CP_PUF_START or a run of the SRF
+// engine takes the engine out of idle and IN_SM_READY returns 'ready_latency_us' later.
+   unsigned int last_ctrl;
+   long ready_latency_us;
+   struct timeval busy_tv;
+
+// Word-level BRAM port used by the block transfer benchmark (DeviceSimPLArmPort): the per-word GPIO handshake or the mailbox
+// 'window' of the mmap backend. 'port_num_words' is the number of words transferred once the port is back to idle.
+   int port_mode;
+   int port_index;
+   int port_num_words;
+   unsigned short port_data[DEVICE_SIM_PORT_WORDS];
+   volatile unsigned int window[DEVICE_SIM_PORT_WORDS];
+
+// Vector interface of the CollectPNs engine (DeviceSimPLArmVecs): IN_SM_LOAD_VEC_PAIR requests a vector, which is received one
+// 16-bit word per DTO handshake into 'vec_words' ('vec_words_per_vec' words each), then the vector is 'measured' for 'vec_latency_us'.
+   int vec_state;
+   int vec_num;
+   int vec_num_vecs;
+   int vec_word_num;
+   int vec_words_per_vec;
+   unsigned short *vec_words;
+   long vec_latency_us;
+   struct timeval vec_tv;
+   int debug_flag;
+   } DeviceSimPLStruct;
+
+// Adaptive wait on the PL status register (device_hw_wait.c). A wait polls DataRegA 'spin_polls' times, then yields the core
+// for 'yield_polls' polls and then sleeps with exponential backoff from 'min_sleep_us' to 'max_sleep_us', or, when 'uio_fd' is
+// open, blocks on the UIO interrupt of the GPIO instead of sleeping. 'settle_timeout_us' bounds the waits that replaced the
+// fixed usleep() calls and unbounded waits warn every 'lockup_warn_us'. 'min_pulse_us' is the width of control pulses that have
+// no acknowledge bit.
+typedef struct
+   {
+   int spin_polls;
+   int yield_polls;
+   int min_sleep_us;
+   int max_sleep_us;
+   long settle_timeout_us;
+   long lockup_warn_us;
+   int min_pulse_us;
+   int uio_fd;
+   volatile unsigned int *GPIO_regs;
+   } DeviceHWWaitStruct;
+
+// Block transfers between the device and the PNL BRAM (device_bram_xfer.c). 'backend' is the GPIO handshake (one 16-bit word per
+// handshake), the mmap'd mailbox BRAM (BRAM_window, one 16-bit word per 32-bit location, one handshake per block) or the software
+// PL model.
+typedef struct
+   {
+   int backend;
+   volatile unsigned int *BRAM_window;
+   int BRAM_num_words;
+   } DeviceBRAMXferStruct;
+
+// Per-thread counts of the waits by the phase they completed in, and the time spent past the spin phase.
+typedef struct
+   {
+   long num_waits;
+   long num_spin;
+   long num_yield;
+   long num_sleep;
+   long num_irq_wakeups;
+   long num_timeouts;
+   long blocked_usecs;
+   } DeviceHWWaitStatsStruct;
+
 // MAX that the SRF Engine can generate before overflow (where further nonce bytes are ignored). 
 #define MAX_GENERATED_NONCE_BYTES 1000
 
+// Default number of vectors per chunk staged by CollectPNs() while the PL measures the previous chunk.
+#define CHLNG_STAGE_VECS 8
+
 int ReceiveVectors(int str_length, int verifier_socket_desc, unsigned char ***first_vecs_b_ptr, 
    unsigned char ***second_vecs_b_ptr, int num_PIs, int *num_rise_vecs_ptr, int *has_masks_ptr, int num_POs, 
    unsigned char ***masks_b_ptr);
@@ -229,6 +353,10 @@ int ReceiveChlngsAndMasks(int max_string_len, int verifier_socket_desc, unsigned
 void LoadChlngAndMask(int max_string_len, volatile unsigned int *CtrlRegA, volatile unsigned int *DataRegA, int chlng_num, 
    unsigned char **challenges_b, int ctrl_mask, int num_chlng_bits, int chlng_chunk_size, int has_masks, int num_POs, 
    unsigned char **masks_b);
+int StageChlngAndMask(int num_PIs, unsigned char *first_vec_b, unsigned char *second_vec_b, int has_masks, int num_POs, 
+   unsigned char *mask_b, unsigned int ctrl_mask, int chlng_chunk_size, unsigned int *staged_words);
+void LoadStagedChlngAndMask(volatile unsigned int *CtrlRegA, volatile unsigned int *DataRegA, unsigned int ctrl_mask, 
+   int num_words, unsigned int *staged_words);
 
 void SaveASCIIVectors(int max_string_len, int num_vecs, unsigned char **first_vecs_b, unsigned char **second_vecs_b, 
    int num_PIs, int has_masks, int num_POs, unsigned char **masks_b);
@@ -237,7 +365,7 @@ int GoGetVectors(int max_string_len, int num_POs, int num_PIs, int verifier_sock
    int *has_masks_ptr, unsigned char ***first_vecs_b_ptr, unsigned char ***second_vecs_b_ptr, 
    unsigned char ***masks_b_ptr, int send_GO, int use_database_chlngs, sqlite3 *DB, int DB_design_index,
    char *DB_ChallengeSetName, int gen_or_use_challenge_seed, unsigned int *DB_ChallengeGen_seed_ptr, 
-   pthread_mutex_t *GenChallenge_mutex_ptr, int debug_flag);
+   int chlng_rng_mode, int debug_flag);
 
 
 int ReadFileHexASCIIToUnsignedChar(int max_string_len, char *file_name, unsigned char **bin_arr_ptr);
@@ -74,4 +74,17 @@
 #define CTRL_DIRECTION_MASK 0x00
 #define DATA_DIRECTION_MASK 0xFFFFFFFF
 
+// AXI GPIO interrupt registers (word offsets from the GPIO base). Only present when the bitstream's GPIO is built with its
+// interrupt enabled. Channel 1 is DataRegA, and its interrupt fires on any change of the status bits.
+#define GPIO_GIER_WORD (0x11C/4)
+#define GPIO_ISR_WORD (0x120/4)
+#define GPIO_IER_WORD (0x128/4)
+#define GPIO_GIER_ENABLE 0x80000000
+#define GPIO_CH1_INTR 0x00000001
+
+// Mailbox BRAM of the 'mmap' BRAM transfer backend (device_bram_xfer.c): an AXI BRAM controller, one 16-bit word per 32-bit
+// location. Only present in bitstreams built with the mailbox.
+#define BRAM_MAILBOX_BASE_ADDR 0x40000000
+#define BRAM_MAILBOX_NUM_WORDS 2048
+
 #endif
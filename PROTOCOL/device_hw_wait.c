@@ -0,0 +1,338 @@
+// ========================================================================================================
+// ========================================================================================================
+// ******************************************* device_hw_wait.c *******************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+//
+// Waits on the status bits of the PL (DataRegA). The handshakes with the hardware state machines normally
+// complete within a few PL clock cycles, so a wait first spins on the register. If the bits have not arrived
+// it yields the core, and then sleeps with exponential backoff, which is what the long waits (the engine
+// computing, the TRNG running) reach. When the bitstream's GPIO has its interrupt connected and the device
+// tree binds it to the generic UIO driver, the sleep is replaced by a blocking read on the UIO device that
+// wakes on the next change of the status bits.
+//
+// In the device simulator (DEVICE_SIM) every poll also steps the software PL model (DeviceSimPLPoll), which
+// acknowledges the start pulses and returns to idle after its configured latency, so all of the phases run
+// against the model.
+
+#include "common.h"
+#include "device_hardware.h"
+#include "device_common.h"
+#include "device_hw_wait.h"
+
+#include <sched.h>
+#include <poll.h>
+
+#ifdef DEVICE_SIM
+#include "device_sim_PL.h"
+#endif
+
+// Set once by DeviceHWWaitInit() before any waits. The counts are per thread since the load generator runs several
+// simulated devices in one process.
+static DeviceHWWaitStruct HWWait = {HW_WAIT_SPIN_POLLS, HW_WAIT_YIELD_POLLS, HW_WAIT_MIN_SLEEP_US, HW_WAIT_MAX_SLEEP_US,
+   HW_WAIT_SETTLE_TIMEOUT_US, HW_WAIT_LOCKUP_WARN_US, HW_WAIT_MIN_PULSE_US, -1, NULL};
+static __thread DeviceHWWaitStatsStruct HWWaitStats;
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Set the wait parameters and, if 'uio_dev_name' is not empty, open the UIO device of the GPIO and enable its
+// channel 1 interrupt. 'DataRegA' is the start of the mapped GPIO registers.
+
+void DeviceHWWaitInit(volatile unsigned int *DataRegA, int spin_polls, int yield_polls, int min_sleep_us, int max_sleep_us,
+   long settle_timeout_us, long lockup_warn_us, int min_pulse_us, char *uio_dev_name)
+   {
+
+// Sanity checks
+   if ( spin_polls < 0 || yield_polls < 0 || min_sleep_us <= 0 || max_sleep_us < min_sleep_us || settle_timeout_us < 0 ||
+      lockup_warn_us < 0 || min_pulse_us < 0 )
+      {
+      printf("ERROR: DeviceHWWaitInit(): Spin %d and yield %d polls MUST be >= 0, sleep %d to %d us MUST be > 0 and increasing, settle %ld, lockup %ld and pulse %d us MUST be >= 0!\n",
+         spin_polls, yield_polls, min_sleep_us, max_sleep_us, settle_timeout_us, lockup_warn_us, min_pulse_us);
+      exit(EXIT_FAILURE);
+      }
+
+   HWWait.spin_polls = spin_polls;
+   HWWait.yield_polls = yield_polls;
+   HWWait.min_sleep_us = min_sleep_us;
+   HWWait.max_sleep_us = max_sleep_us;
+   HWWait.settle_timeout_us = settle_timeout_us;
+   HWWait.lockup_warn_us = lockup_warn_us;
+   HWWait.min_pulse_us = min_pulse_us;
+   HWWait.uio_fd = -1;
+   HWWait.GPIO_regs = DataRegA;
+
+   if ( uio_dev_name == NULL || uio_dev_name[0] == '\0' )
+      return;
+
+#ifdef DEVICE_SIM
+   printf("ERROR: DeviceHWWaitInit(): The simulated PL has no UIO interrupt -- leave the UIO device name empty!\n"); exit(EXIT_FAILURE);
+#endif
+
+   if ( (HWWait.uio_fd = open(uio_dev_name, O_RDWR)) < 0 )
+      { printf("ERROR: DeviceHWWaitInit(): Failed to open UIO device '%s'!\n", uio_dev_name); exit(EXIT_FAILURE); }
+
+// Clear anything pending, then enable the channel 1 interrupt. The UIO driver masks the interrupt line each time it fires and
+// it is unmasked again by writing 1 to the device before each blocking wait.
+   if ( (HWWait.GPIO_regs[GPIO_ISR_WORD] & GPIO_CH1_INTR) != 0 )
+      HWWait.GPIO_regs[GPIO_ISR_WORD] = GPIO_CH1_INTR;
+   HWWait.GPIO_regs[GPIO_IER_WORD] = GPIO_CH1_INTR;
+   HWWait.GPIO_regs[GPIO_GIER_WORD] = GPIO_GIER_ENABLE;
+
+   printf("DeviceHWWaitInit(): Using interrupts from UIO device '%s'\n", uio_dev_name); fflush(stdout);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Disable the GPIO interrupt and close the UIO device, if open.
+
+void DeviceHWWaitClose()
+   {
+   if ( HWWait.uio_fd < 0 )
+      return;
+
+   HWWait.GPIO_regs[GPIO_GIER_WORD] = 0;
+   HWWait.GPIO_regs[GPIO_IER_WORD] = 0;
+   close(HWWait.uio_fd);
+   HWWait.uio_fd = -1;
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Microseconds since 't0'.
+
+static long DeviceHWWaitElapsed(struct timeval *t0)
+   {
+   struct timeval t1;
+
+   gettimeofday(&t1, 0);
+   return (t1.tv_sec - t0->tv_sec)*1000000 + t1.tv_usec - t0->tv_usec;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Clear the GPIO interrupt status and unmask the interrupt in the UIO driver. The caller re-reads the status
+// bits before blocking so a change between the last poll and the unmask is not missed.
+
+static void DeviceHWWaitArmIRQ()
+   {
+   int irq_enable = 1;
+
+   if ( (HWWait.GPIO_regs[GPIO_ISR_WORD] & GPIO_CH1_INTR) != 0 )
+      HWWait.GPIO_regs[GPIO_ISR_WORD] = GPIO_CH1_INTR;
+   if ( write(HWWait.uio_fd, &irq_enable, sizeof(irq_enable)) != sizeof(irq_enable) )
+      { printf("ERROR: DeviceHWWaitArmIRQ(): Failed to unmask the UIO interrupt!\n"); exit(EXIT_FAILURE); }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Wait until the bits in 'mask' equal 'value' ('match_any' 0) or until any bit in 'mask' is set ('match_any'
+// 1). Gives up after 'timeout_us' past the spin phase (never when HW_WAIT_FOREVER, in which case a warning is
+// printed every 'lockup_warn_us'). Returns 1 on a match, 0 on a timeout, and the last value read in
+// 'reg_val_ptr'.
+
+static int DeviceHWWait(volatile unsigned int *DataRegA, unsigned int mask, unsigned int value, int match_any, long timeout_us,
+   unsigned int *reg_val_ptr)
+   {
+   unsigned int reg_val, irq_count;
+   int poll_num, sleep_us, irq_armed, matched;
+   long elapsed, next_warn_us, remaining_us;
+   struct timeval t0;
+   struct timespec req_ts;
+   struct pollfd uio_pfd;
+
+   if ( timeout_us == HW_WAIT_SETTLE )
+      timeout_us = HWWait.settle_timeout_us;
+
+   HWWaitStats.num_waits++;
+
+   sleep_us = HWWait.min_sleep_us;
+   next_warn_us = HWWait.lockup_warn_us;
+   irq_armed = 0;
+   elapsed = 0;
+   matched = 0;
+   for ( poll_num = 0; ; poll_num++ )
+      {
+      reg_val = *DataRegA;
+      if ( (match_any == 1 && (reg_val & mask) != 0) || (match_any == 0 && (reg_val & mask) == value) )
+         { matched = 1; break; }
+
+#ifdef DEVICE_SIM
+      DeviceSimPLPoll(DeviceSimPLFromRegs(DataRegA));
+#endif
+
+// Spin phase. The clock is started when it ends so the fast handshakes do not pay for it.
+      if ( poll_num < HWWait.spin_polls )
+         continue;
+      if ( poll_num == HWWait.spin_polls )
+         gettimeofday(&t0, 0);
+
+      elapsed = DeviceHWWaitElapsed(&t0);
+      if ( timeout_us >= 0 && elapsed >= timeout_us )
+         break;
+      if ( timeout_us < 0 && HWWait.lockup_warn_us > 0 && elapsed >= next_warn_us )
+         {
+         printf("WARNING: DeviceHWWait(): Waiting %ld us for status bits %08X (currently %08X) -- Locked UP?\n", elapsed, mask, reg_val);
+         fflush(stdout);
+         next_warn_us += HWWait.lockup_warn_us;
+         }
+
+// Yield phase.
+      if ( poll_num < HWWait.spin_polls + HWWait.yield_polls )
+         {
+         sched_yield();
+         continue;
+         }
+
+// Sleep phase, never past the timeout.
+      remaining_us = sleep_us;
+      if ( timeout_us >= 0 && timeout_us - elapsed < remaining_us )
+         remaining_us = timeout_us - elapsed;
+
+      if ( HWWait.uio_fd >= 0 )
+         {
+
+// Arm, then go around once more to re-read the status bits before blocking. The poll timeout covers a lost interrupt.
+         if ( irq_armed == 0 )
+            {
+            DeviceHWWaitArmIRQ();
+            irq_armed = 1;
+            continue;
+            }
+         uio_pfd.fd = HWWait.uio_fd;
+         uio_pfd.events = POLLIN;
+         if ( poll(&uio_pfd, 1, (int)((remaining_us + 999)/1000)) > 0 )
+            {
+            if ( read(HWWait.uio_fd, &irq_count, sizeof(irq_count)) == sizeof(irq_count) )
+               HWWaitStats.num_irq_wakeups++;
+            }
+         irq_armed = 0;
+         }
+      else
+         {
+         req_ts.tv_sec = remaining_us/1000000;
+         req_ts.tv_nsec = (remaining_us % 1000000)*1000;
+         nanosleep(&req_ts, NULL);
+         }
+
+      sleep_us *= 2;
+      if ( sleep_us > HWWait.max_sleep_us )
+         sleep_us = HWWait.max_sleep_us;
+      }
+
+   if ( matched == 0 )
+      HWWaitStats.num_timeouts++;
+   else if ( poll_num <= HWWait.spin_polls )
+      HWWaitStats.num_spin++;
+   else if ( poll_num <= HWWait.spin_polls + HWWait.yield_polls )
+      HWWaitStats.num_yield++;
+   else
+      HWWaitStats.num_sleep++;
+
+   if ( poll_num > HWWait.spin_polls )
+      HWWaitStats.blocked_usecs += DeviceHWWaitElapsed(&t0);
+
+   *reg_val_ptr = reg_val;
+   return matched;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Wait for the bits in 'mask' to equal 'value'. Returns 1, or 0 if 'timeout_us' (HW_WAIT_SETTLE for the
+// configured settle timeout) expired first.
+
+int DeviceHWWaitBits(volatile unsigned int *DataRegA, unsigned int mask, unsigned int value, long timeout_us)
+   {
+   unsigned int reg_val;
+
+   return DeviceHWWait(DataRegA, mask, value, 0, timeout_us, &reg_val);
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Wait for any of the bits in 'mask' to be set. Returns the value of DataRegA that satisfied the wait, which
+// has none of the bits in 'mask' set if 'timeout_us' expired first.
+
+unsigned int DeviceHWWaitAnyBit(volatile unsigned int *DataRegA, unsigned int mask, long timeout_us)
+   {
+   unsigned int reg_val;
+
+   DeviceHWWait(DataRegA, mask, 0, 1, timeout_us, &reg_val);
+   return reg_val;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Assert 'out_bit' on top of 'ctrl_mask' until the hardware acknowledges it (the bits in 'ack_mask' equal
+// 'ack_value'), or for 'min_pulse_us' when there is no acknowledge bit ('ack_mask' 0), then de-assert it.
+// Returns 0 if the acknowledge timed out.
+
+int DeviceHWPulse(volatile unsigned int *CtrlRegA, volatile unsigned int *DataRegA, unsigned int ctrl_mask, int out_bit,
+   unsigned int ack_mask, unsigned int ack_value, long timeout_us)
+   {
+   int acked;
+   struct timeval t0;
+
+   *CtrlRegA = ctrl_mask | (1 << out_bit);
+   if ( ack_mask != 0 )
+      acked = DeviceHWWaitBits(DataRegA, ack_mask, ack_value, timeout_us);
+   else
+      {
+
+// Reading the status register also makes sure the write has reached the GPIO.
+      gettimeofday(&t0, 0);
+      do
+         (void)*DataRegA;
+      while ( DeviceHWWaitElapsed(&t0) < HWWait.min_pulse_us );
+      acked = 1;
+      }
+   *CtrlRegA = ctrl_mask;
+
+   return acked;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Counts for the calling thread.
+
+void DeviceHWWaitGetStats(DeviceHWWaitStatsStruct *stats_ptr)
+   {
+   *stats_ptr = HWWaitStats;
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// One line with the counts of the calling thread, e.g., to compare the wait parameters on the hardware.
+
+void DeviceHWWaitPrintStats(char *header_str)
+   {
+   printf("%sWaits %ld\tSpin %ld\tYield %ld\tSleep %ld\tIRQ wakeups %ld\tTimeouts %ld\tBlocked %ld us\n", header_str,
+      HWWaitStats.num_waits, HWWaitStats.num_spin, HWWaitStats.num_yield, HWWaitStats.num_sleep, HWWaitStats.num_irq_wakeups,
+      HWWaitStats.num_timeouts, HWWaitStats.blocked_usecs);
+   fflush(stdout);
+
+   return;
+   }
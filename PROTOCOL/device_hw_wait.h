@@ -0,0 +1,44 @@
+// ========================================================================================================
+// ========================================================================================================
+// ******************************************* device_hw_wait.h *******************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+
+#ifndef DEVICE_HW_WAIT_INCLUDED
+
+// Defaults used until DeviceHWWaitInit() is called. A GPIO read over AXI takes roughly 150-200 ns on the Zynq, so the
+// handshakes, which complete within a few PL clock cycles, finish in the spin phase. The settle timeout is the fixed usleep()
+// the ready-bit waits replaced, so a bitstream that never raises the bit behaves as before.
+#define HW_WAIT_SPIN_POLLS 200
+#define HW_WAIT_YIELD_POLLS 50
+#define HW_WAIT_MIN_SLEEP_US 10
+#define HW_WAIT_MAX_SLEEP_US 1000
+#define HW_WAIT_SETTLE_TIMEOUT_US 1000
+#define HW_WAIT_LOCKUP_WARN_US 1000000
+#define HW_WAIT_MIN_PULSE_US 10
+
+// Special 'timeout_us' values.
+#define HW_WAIT_FOREVER -1
+#define HW_WAIT_SETTLE -2
+
+#define DEVICE_HW_WAIT_INCLUDED
+#endif
+
+void DeviceHWWaitInit(volatile unsigned int *DataRegA, int spin_polls, int yield_polls, int min_sleep_us, int max_sleep_us,
+   long settle_timeout_us, long lockup_warn_us, int min_pulse_us, char *uio_dev_name);
+void DeviceHWWaitClose();
+
+int DeviceHWWaitBits(volatile unsigned int *DataRegA, unsigned int mask, unsigned int value, long timeout_us);
+unsigned int DeviceHWWaitAnyBit(volatile unsigned int *DataRegA, unsigned int mask, long timeout_us);
+int DeviceHWPulse(volatile unsigned int *CtrlRegA, volatile unsigned int *DataRegA, unsigned int ctrl_mask, int out_bit,
+   unsigned int ack_mask, unsigned int ack_value, long timeout_us);
+
+void DeviceHWWaitGetStats(DeviceHWWaitStatsStruct *stats_ptr);
+void DeviceHWWaitPrintStats(char *header_str);
@@ -0,0 +1,699 @@
+// ========================================================================================================
+// ========================================================================================================
+// ******************************************* device_load_gen.c ******************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+//
+// Load generator for the verifier. 'Num concurrent' simulated devices (device_sim_PL.c) authenticate with a
+// running verifier_regeneration at the same time until 'Num authentications' are done. Each authentication is
+// one of:
+//
+//    genuine  : a PUFInstance of the NAT DB (the verifier's NAT DB), PN noise 'Noise sigma'.
+//    impostor : a PUFInstance of the impostor DB, i.e., a chip the verifier has not enrolled, PN noise 'Noise sigma'.
+//    noisy    : a genuine PUFInstance with PN noise 'Noisy sigma', which exercises the MAX_DA_RETRIES loop of
+//               KEK_ClientServerAuthen().
+//
+// The class and chip of authentication 'n' depend only on 'n' and the seed, so runs against different builds of
+// the verifier make the same requests. Each session runs the unmodified device protocol (KEK_ClientServerAuthen())
+// on its own thread, since that code blocks on its socket. A genuine chip is accepted when the verifier reports
+// its chip number, which is its position in the NAT DB (PUFInstance ID order).
+//
+// Two files are written: <Results prefix>_sessions.txt with one tab-separated line per authentication and
+// <Results prefix>_summary.txt with one 'name<TAB>value' line per statistic. Latencies are in microseconds. The 
+// output of the device protocol goes to <Results prefix>_device.log.
+//
+// Usage: device_load_gen Bank_IP NAT_DB Impostor_DB Num_concurrent Num_authentications Impostor_% Noisy_%
+//           Noise_sigma Noisy_sigma Results_prefix
+
+#include "common.h"
+#include "device_hardware.h"
+#include "device_common.h"
+#include "device_regen_funcs.h"
+
+#include <sqlite3.h>
+#include "commonDB.h"
+#include "device_sim_PL.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+extern int usleep (__useconds_t __useconds);
+
+#define LOAD_GEN_CLASS_GENUINE 0
+#define LOAD_GEN_CLASS_IMPOSTOR 1
+#define LOAD_GEN_CLASS_NOISY 2
+#define LOAD_GEN_NUM_CLASSES 3
+
+#define LOAD_GEN_MAX_THREADS 1000
+
+// Timing phases of one authentication: connect to the Bank, send the request and get the 'ACK'; from the 'ACK' until the
+// first PN set is collected (SKE request, nonces and challenge); from then on until the verifier's decision arrives (all DA
+// attempts). The wall time the PL model spends computing is reported separately.
+#define LOAD_GEN_PHASE_CONNECT 0
+#define LOAD_GEN_PHASE_CHALLENGE 1
+#define LOAD_GEN_PHASE_AUTHEN 2
+#define LOAD_GEN_PHASE_DEVICE 3
+#define LOAD_GEN_PHASE_TOTAL 4
+#define LOAD_GEN_NUM_PHASES 5
+
+static const char *LoadGen_class_names[LOAD_GEN_NUM_CLASSES] = { "genuine", "impostor", "noisy" };
+static const char *LoadGen_phase_names[LOAD_GEN_NUM_PHASES] = { "connect", "challenge", "authen", "device", "total" };
+
+// One PUFInstance the generator can simulate.
+typedef struct
+   {
+   int ID;
+   char Instance_name[MAX_STRING_LEN];
+   } LoadGenChipStruct;
+
+// The outcome of one authentication.
+typedef struct
+   {
+   int class_num;
+   int chip_pos;
+   int expected_chip_num;
+   int reported_chip_num;
+   int passed;
+   int attempts;
+   long phase_usecs[LOAD_GEN_NUM_PHASES];
+   } LoadGenSessionStruct;
+
+typedef struct
+   {
+   char *Bank_IP;
+   int port_number;
+
+   sqlite3 *DB_Challenges;
+   int design_index;
+   char *ChallengeSetName;
+   int chlng_rng_mode;
+
+// The PL models of the genuine and noisy chips read from DB_NAT, those of the impostors from DB_impostor.
+   sqlite3 *DB_NAT;
+   int NAT_design_index;
+   LoadGenChipStruct *genuine_chips;
+   int num_genuine_chips;
+
+   sqlite3 *DB_impostor;
+   int impostor_design_index;
+   LoadGenChipStruct *impostor_chips;
+   int num_impostor_chips;
+
+   int impostor_pct;
+   int noisy_pct;
+   float noise_sigma;
+   float noisy_sigma;
+   unsigned int seed;
+
+   int num_authens;
+   int next_authen_num;
+   pthread_mutex_t next_authen_mutex;
+   LoadGenSessionStruct *sessions;
+   } LoadGenStruct;
+
+
+// ========================================================================================================
+// ========================================================================================================
+// splitmix64. Gives the class, chip and noise seed of an authentication from its number.
+
+static unsigned long long LoadGenHash(unsigned long long x)
+   {
+   x += 0x9E3779B97F4A7C15ULL;
+   x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+   x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+   return x ^ (x >> 31);
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Read every PUFInstance of 'db' (in ID order, which is the verifier's chip number order).
+
+static int LoadGenGetChips(int max_string_len, sqlite3 *db, LoadGenChipStruct **chips_ptr)
+   {
+   SQLIntStruct PUF_instance_index_struct;
+   char Dev[max_string_len], Placement[max_string_len];
+   int chip_num;
+
+   GetPUFInstanceIDsForInstanceName(max_string_len, db, &PUF_instance_index_struct, "%");
+   if ( PUF_instance_index_struct.num_ints == 0 )
+      { printf("ERROR: LoadGenGetChips(): Database has NO PUFInstances!\n"); exit(EXIT_FAILURE); }
+
+   if ( (*chips_ptr = (LoadGenChipStruct *)calloc(PUF_instance_index_struct.num_ints, sizeof(LoadGenChipStruct))) == NULL )
+      { printf("ERROR: LoadGenGetChips(): Failed to allocate storage for chips!\n"); exit(EXIT_FAILURE); }
+   for ( chip_num = 0; chip_num < PUF_instance_index_struct.num_ints; chip_num++ )
+      {
+      (*chips_ptr)[chip_num].ID = PUF_instance_index_struct.int_arr[chip_num];
+      GetPUFInstanceInfoForID(max_string_len, db, (*chips_ptr)[chip_num].ID, (*chips_ptr)[chip_num].Instance_name, Dev, Placement);
+      }
+   free(PUF_instance_index_struct.int_arr);
+
+   return chip_num;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Load a database into memory and look up its PUFDesign.
+
+static sqlite3 *LoadGenOpenDB(int max_string_len, char *DB_name, char *Netlist_name, char *Synthesis_name, int *design_index_ptr)
+   {
+   sqlite3 *db;
+   int num_PIs_DB, num_POs_DB;
+   int num_PIs = NUM_PIS;
+   int num_POs = NUM_POS;
+
+   if ( sqlite3_open(":memory:", &db) != 0 )
+      { printf("ERROR: LoadGenOpenDB(): Failed to open in-memory database: %s\n", sqlite3_errmsg(db)); sqlite3_close(db); exit(EXIT_FAILURE); }
+   printf("Reading filesystem database '%s' into memory!\n", DB_name); fflush(stdout);
+   if ( LoadOrSaveDb(db, DB_name, 0) != 0 )
+      { printf("ERROR: LoadGenOpenDB(): Failed to copy '%s' into memory: %s\n", DB_name, sqlite3_errmsg(db)); sqlite3_close(db); exit(EXIT_FAILURE); }
+
+   if ( GetPUFDesignParams(max_string_len, db, Netlist_name, Synthesis_name, design_index_ptr, &num_PIs_DB, &num_POs_DB) != 0 )
+      { printf("ERROR: LoadGenOpenDB(): PUFDesign index NOT found in '%s' for '%s', '%s'!\n", DB_name, Netlist_name, Synthesis_name); exit(EXIT_FAILURE); }
+   if ( num_PIs_DB != num_PIs || num_POs_DB != num_POs )
+      { printf("ERROR: LoadGenOpenDB(): Number of PIs %d or POs %d in '%s' do NOT match common.h!\n", num_PIs_DB, num_POs_DB, DB_name); exit(EXIT_FAILURE); }
+
+   return db;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Device parameters for KEK SKE authentication, as set up by main() in device_regeneration.c. The registers
+// are those of the session's PL model.
+
+static void LoadGenInitSHP(LoadGenStruct *LG_ptr, SRFHardwareParamsStruct *SHP_ptr, DeviceSimPLStruct *SimPL_ptr)
+   {
+   memset(SHP_ptr, 0, sizeof(SRFHardwareParamsStruct));
+
+   SHP_ptr->DataRegA = SimPL_ptr->regs;
+   SHP_ptr->CtrlRegA = SimPL_ptr->regs + 2;
+   SHP_ptr->ctrl_mask = (0 << OUT_CP_NUM_SAM1) | (1 << OUT_CP_NUM_SAM0);
+
+   StringCreateAndCopy(&(SHP_ptr->My_IP), "127.0.0.1");
+   SHP_ptr->chip_num = -1;
+   SHP_ptr->anon_chip_num = -1;
+
+   SHP_ptr->DB_Challenges = LG_ptr->DB_Challenges;
+   SHP_ptr->use_database_chlngs = 1;
+   SHP_ptr->DB_design_index = LG_ptr->design_index;
+   SHP_ptr->DB_ChallengeSetName = LG_ptr->ChallengeSetName;
+   SHP_ptr->chlng_rng_mode = LG_ptr->chlng_rng_mode;
+   SHP_ptr->eCt_num_bytes = ECT_NUM_BYTES;
+
+   SHP_ptr->num_PIs = NUM_PIS;
+   SHP_ptr->num_POs = NUM_POS;
+   SHP_ptr->num_required_PNDiffs = NUM_REQUIRED_PNDIFFS;
+   SHP_ptr->num_SF_bytes = NUM_REQUIRED_PNDIFFS * SF_WORDS_TO_BYTES_MULT;
+   SHP_ptr->num_SF_words = NUM_REQUIRED_PNDIFFS;
+   if ( TRIMCODE_CONSTANT <= 32 )
+      SHP_ptr->iSpreadFactorScaler = 2;
+   else
+      SHP_ptr->iSpreadFactorScaler = 1;
+
+   if ( (SHP_ptr->iSpreadFactors = (signed char *)calloc(SHP_ptr->num_SF_words, sizeof(signed char))) == NULL ||
+      (SHP_ptr->verifier_SHD = (unsigned char *)calloc(NUM_REQUIRED_PNDIFFS/8, sizeof(unsigned char))) == NULL ||
+      (SHP_ptr->verifier_SBS = (unsigned char *)calloc(NUM_REQUIRED_PNDIFFS/8, sizeof(unsigned char))) == NULL ||
+      (SHP_ptr->device_SHD = (unsigned char *)calloc(NUM_REQUIRED_PNDIFFS/8, sizeof(unsigned char))) == NULL ||
+      (SHP_ptr->device_SBS = (unsigned char *)calloc(NUM_REQUIRED_PNDIFFS/8, sizeof(unsigned char))) == NULL )
+      { printf("ERROR: LoadGenInitSHP(): Failed to allocate storage for SpreadFactors/SHD/SBS!\n"); exit(EXIT_FAILURE); }
+
+   SHP_ptr->max_generated_nonce_bytes = MAX_GENERATED_NONCE_BYTES;
+   SHP_ptr->num_required_nonce_bytes = NUM_XOR_NONCE_BYTES;
+   if ( (SHP_ptr->device_n1 = (unsigned char *)calloc(MAX_GENERATED_NONCE_BYTES, sizeof(unsigned char))) == NULL ||
+      (SHP_ptr->verifier_n2 = (unsigned char *)calloc(NUM_XOR_NONCE_BYTES, sizeof(unsigned char))) == NULL ||
+      (SHP_ptr->XOR_nonce = (unsigned char *)calloc(NUM_XOR_NONCE_BYTES, sizeof(unsigned char))) == NULL ||
+      (SHP_ptr->KEK_XOR_nonce = (unsigned char *)calloc(NUM_XOR_NONCE_BYTES, sizeof(unsigned char))) == NULL )
+      { printf("ERROR: LoadGenInitSHP(): Failed to allocate storage for nonces!\n"); exit(EXIT_FAILURE); }
+
+   SHP_ptr->vec_chunk_size = CHLNG_CHUNK_SIZE;
+   SHP_ptr->chlng_stage_vecs = CHLNG_STAGE_VECS;
+   SHP_ptr->XMR_val = XMR_VAL;
+   SHP_ptr->SE_target_num_key_bits = SE_TARGET_NUM_KEY_BITS;
+   SHP_ptr->authen_min_bitstring_size = AUTHEN_MIN_BITSTRING_SIZE;
+   SHP_ptr->KEK_target_num_key_bits = KEK_TARGET_NUM_KEY_BITS;
+   SHP_ptr->KEK_has_masks = 1;
+   SHP_ptr->num_direction_chlng_bits = NUM_DIRECTION_CHLNG_BITS;
+
+   if ( (SHP_ptr->KEK_authentication_nonce = (unsigned char *)calloc(KEK_AUTHEN_NUM_NONCE_BITS/8, sizeof(unsigned char))) == NULL ||
+      (SHP_ptr->KEK_authen_XMR_SHD_chunk = (unsigned char *)calloc(NUM_REQUIRED_PNDIFFS/8, sizeof(unsigned char))) == NULL )
+      { printf("ERROR: LoadGenInitSHP(): Failed to allocate storage for KEK authentication nonce/XMR_SHD!\n"); exit(EXIT_FAILURE); }
+   SHP_ptr->num_KEK_authen_nonce_bits = KEK_AUTHEN_NUM_NONCE_BITS;
+   SHP_ptr->num_KEK_authen_nonce_bits_remaining = KEK_AUTHEN_NUM_NONCE_BITS;
+
+   SHP_ptr->has_masks = 1;
+   SHP_ptr->param_RangeConstant = RANGE_CONSTANT;
+   SHP_ptr->param_SpreadConstant = SPREAD_CONSTANT;
+   SHP_ptr->param_Threshold = THRESHOLD_CONSTANT;
+   SHP_ptr->param_TrimCodeConstant = TRIMCODE_CONSTANT;
+   SHP_ptr->param_PCR_or_PBD_or_PO = 0;
+   SHP_ptr->MyScalingConstant = 1 << SCALING_PRECISION_NB;
+
+   SHP_ptr->TRNG_LFSR_seed = 1;
+   SHP_ptr->do_COBRA = 0;
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+
+static void LoadGenFreeSHP(SRFHardwareParamsStruct *SHP_ptr)
+   {
+   free(SHP_ptr->My_IP);
+   free(SHP_ptr->iSpreadFactors);
+   free(SHP_ptr->verifier_SHD);
+   free(SHP_ptr->verifier_SBS);
+   free(SHP_ptr->device_SHD);
+   free(SHP_ptr->device_SBS);
+   free(SHP_ptr->device_n1);
+   free(SHP_ptr->verifier_n2);
+   free(SHP_ptr->XOR_nonce);
+   free(SHP_ptr->KEK_XOR_nonce);
+   free(SHP_ptr->KEK_authentication_nonce);
+   free(SHP_ptr->KEK_authen_XMR_SHD_chunk);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Microseconds from 't0' to 't1'.
+
+static long LoadGenUsecs(struct timeval *t0, struct timeval *t1)
+   {
+   return (t1->tv_sec - t0->tv_sec)*1000000 + t1->tv_usec - t0->tv_usec;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// One authentication: pick the class and chip, then run the device side exactly as device_regeneration.c
+// does.
+
+static void LoadGenRunSession(int max_string_len, LoadGenStruct *LG_ptr, SRFHardwareParamsStruct *SHP_ptr,
+   DeviceSimPLStruct *SimPL_ptr, int authen_num)
+   {
+   LoadGenSessionStruct *session_ptr = &(LG_ptr->sessions[authen_num]);
+   unsigned long long hash;
+   LoadGenChipStruct *chip_ptr;
+   sqlite3 *DB_chip;
+   int design_index, Bank_socket_desc;
+   float sigma;
+
+   char my_info_str[max_string_len];
+   char ack_str[max_string_len];
+   struct timeval t0, t_ack, t1;
+
+   hash = LoadGenHash(((unsigned long long)LG_ptr->seed << 32) ^ (unsigned long long)authen_num);
+   if ( (int)(hash % 100) < LG_ptr->impostor_pct )
+      session_ptr->class_num = LOAD_GEN_CLASS_IMPOSTOR;
+   else if ( (int)(hash % 100) < LG_ptr->impostor_pct + LG_ptr->noisy_pct )
+      session_ptr->class_num = LOAD_GEN_CLASS_NOISY;
+   else
+      session_ptr->class_num = LOAD_GEN_CLASS_GENUINE;
+
+   hash = LoadGenHash(hash);
+   if ( session_ptr->class_num == LOAD_GEN_CLASS_IMPOSTOR )
+      {
+      session_ptr->chip_pos = (int)(hash % (unsigned long long)LG_ptr->num_impostor_chips);
+      session_ptr->expected_chip_num = -1;
+      chip_ptr = &(LG_ptr->impostor_chips[session_ptr->chip_pos]);
+      DB_chip = LG_ptr->DB_impostor;
+      design_index = LG_ptr->impostor_design_index;
+      sigma = LG_ptr->noise_sigma;
+      }
+   else
+      {
+      session_ptr->chip_pos = (int)(hash % (unsigned long long)LG_ptr->num_genuine_chips);
+      session_ptr->expected_chip_num = session_ptr->chip_pos;
+      chip_ptr = &(LG_ptr->genuine_chips[session_ptr->chip_pos]);
+      DB_chip = LG_ptr->DB_NAT;
+      design_index = LG_ptr->NAT_design_index;
+      if ( session_ptr->class_num == LOAD_GEN_CLASS_NOISY )
+         sigma = LG_ptr->noisy_sigma;
+      else
+         sigma = LG_ptr->noise_sigma;
+      }
+
+   DeviceSimPLOpen(max_string_len, SimPL_ptr, DB_chip, design_index, LG_ptr->ChallengeSetName, chip_ptr->Instance_name, sigma,
+      (unsigned int)LoadGenHash(hash), 0);
+   SHP_ptr->chip_num = -1;
+
+   gettimeofday(&t0, 0);
+   while ( OpenSocketClient(max_string_len, LG_ptr->Bank_IP, LG_ptr->port_number, &Bank_socket_desc) < 0 )
+      usleep(10000);
+
+   SockReaderAttach(Bank_socket_desc);
+   SockSetNoDelay(Bank_socket_desc, 1);
+
+   sprintf(my_info_str, "%d %f %s %d", SHP_ptr->chip_num, 1.0, SHP_ptr->My_IP, 0);
+   unsigned char *request_frames[2] = { (unsigned char *)"CLIENT-AUTHENTICATION", (unsigned char *)my_info_str };
+   int request_frame_sizes[2] = { strlen("CLIENT-AUTHENTICATION") + 1, strlen(my_info_str) + 1 };
+   if ( SockSendFrames(2, request_frames, request_frame_sizes, Bank_socket_desc) < 0 )
+      { printf("ERROR: LoadGenRunSession(): Failed to send 'CLIENT-AUTHENTICATION' to Bank!\n"); exit(EXIT_FAILURE); }
+   if ( SockGetB((unsigned char *)ack_str, max_string_len, Bank_socket_desc) != 4 || strcmp(ack_str, "ACK") != 0 )
+      { printf("ERROR: LoadGenRunSession(): Failed to get 'ACK' from Bank!\n"); exit(EXIT_FAILURE); }
+   gettimeofday(&t_ack, 0);
+
+   TRNG(max_string_len, SHP_ptr, FUNC_INT_TRNG, 0, 0, NULL);
+
+   session_ptr->passed = KEK_ClientServerAuthen(max_string_len, SHP_ptr, Bank_socket_desc);
+   session_ptr->reported_chip_num = SHP_ptr->chip_num;
+   session_ptr->attempts = SimPL_ptr->num_authen_PN_sets;
+
+   SockReaderDetach(Bank_socket_desc);
+   close(Bank_socket_desc);
+   gettimeofday(&t1, 0);
+
+   session_ptr->phase_usecs[LOAD_GEN_PHASE_CONNECT] = LoadGenUsecs(&t0, &t_ack);
+   session_ptr->phase_usecs[LOAD_GEN_PHASE_CHALLENGE] = LoadGenUsecs(&t_ack, &(SimPL_ptr->first_PNs_tv));
+   session_ptr->phase_usecs[LOAD_GEN_PHASE_AUTHEN] = LoadGenUsecs(&(SimPL_ptr->first_PNs_tv), &t1);
+   session_ptr->phase_usecs[LOAD_GEN_PHASE_DEVICE] = SimPL_ptr->PL_usecs;
+   session_ptr->phase_usecs[LOAD_GEN_PHASE_TOTAL] = LoadGenUsecs(&t0, &t1);
+
+   DeviceSimPLClose(SimPL_ptr);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// One simulated device. Runs authentications until all 'num_authens' are taken.
+
+static void *LoadGenThread(void *arg)
+   {
+   LoadGenStruct *LG_ptr = (LoadGenStruct *)arg;
+   SRFHardwareParamsStruct SHP;
+   DeviceSimPLStruct *SimPL_ptr;
+   int authen_num;
+
+   if ( (SimPL_ptr = (DeviceSimPLStruct *)calloc(1, sizeof(DeviceSimPLStruct))) == NULL )
+      { printf("ERROR: LoadGenThread(): Failed to allocate storage for the PL model!\n"); exit(EXIT_FAILURE); }
+   LoadGenInitSHP(LG_ptr, &SHP, SimPL_ptr);
+
+   while ( 1 )
+      {
+      pthread_mutex_lock(&(LG_ptr->next_authen_mutex));
+      authen_num = LG_ptr->next_authen_num++;
+      pthread_mutex_unlock(&(LG_ptr->next_authen_mutex));
+      if ( authen_num >= LG_ptr->num_authens )
+         break;
+
+      LoadGenRunSession(MAX_STRING_LEN, LG_ptr, &SHP, SimPL_ptr, authen_num);
+      }
+
+   LoadGenFreeSHP(&SHP);
+   free(SimPL_ptr);
+
+   return NULL;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+
+static int LoadGenCompareLong(const void *a, const void *b)
+   {
+   long x = *(const long *)a, y = *(const long *)b;
+
+   return (x > y) - (x < y);
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Nearest-rank percentile of the sorted 'vals'.
+
+static long LoadGenPercentile(int num_vals, long *vals, float pct)
+   {
+   int index;
+
+   if ( num_vals == 0 )
+      return 0;
+   index = (int)ceil(pct/100.0 * num_vals) - 1;
+   if ( index < 0 )
+      index = 0;
+   if ( index >= num_vals )
+      index = num_vals - 1;
+
+   return vals[index];
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Write the per-authentication lines and the summary. The summary is also printed.
+
+static void LoadGenReport(int max_string_len, LoadGenStruct *LG_ptr, char *results_prefix, int num_concurrent, long wall_usecs)
+   {
+   char outfile_name[max_string_len];
+   FILE *OUTFILE;
+   int authen_num, phase_num, class_num, num_vals;
+   LoadGenSessionStruct *session_ptr;
+   long *vals, sum;
+
+   int class_cnts[LOAD_GEN_NUM_CLASSES] = {0}, class_attempts[LOAD_GEN_NUM_CLASSES] = {0}, class_retried[LOAD_GEN_NUM_CLASSES] = {0};
+   int true_accepts = 0, false_rejects = 0, false_accepts = 0, true_rejects = 0, misidentified = 0;
+
+   sprintf(outfile_name, "%s_sessions.txt", results_prefix);
+   if ( (OUTFILE = fopen(outfile_name, "w")) == NULL )
+      { printf("ERROR: LoadGenReport(): Could not open '%s' for writing!\n", outfile_name); exit(EXIT_FAILURE); }
+   fprintf(OUTFILE, "authen\tclass\tchip\texpected_chip_num\treported_chip_num\tpassed\tattempts");
+   for ( phase_num = 0; phase_num < LOAD_GEN_NUM_PHASES; phase_num++ )
+      fprintf(OUTFILE, "\t%s_us", LoadGen_phase_names[phase_num]);
+   fprintf(OUTFILE, "\n");
+
+   for ( authen_num = 0; authen_num < LG_ptr->num_authens; authen_num++ )
+      {
+      session_ptr = &(LG_ptr->sessions[authen_num]);
+      fprintf(OUTFILE, "%d\t%s\t%s\t%d\t%d\t%d\t%d", authen_num, LoadGen_class_names[session_ptr->class_num],
+         session_ptr->class_num == LOAD_GEN_CLASS_IMPOSTOR ? LG_ptr->impostor_chips[session_ptr->chip_pos].Instance_name :
+         LG_ptr->genuine_chips[session_ptr->chip_pos].Instance_name, session_ptr->expected_chip_num, session_ptr->reported_chip_num,
+         session_ptr->passed, session_ptr->attempts);
+      for ( phase_num = 0; phase_num < LOAD_GEN_NUM_PHASES; phase_num++ )
+         fprintf(OUTFILE, "\t%ld", session_ptr->phase_usecs[phase_num]);
+      fprintf(OUTFILE, "\n");
+
+      class_cnts[session_ptr->class_num]++;
+      class_attempts[session_ptr->class_num] += session_ptr->attempts;
+      if ( session_ptr->attempts > 1 )
+         class_retried[session_ptr->class_num]++;
+
+// An impostor that passes, or a genuine chip that passes as another chip, is a false accept.
+      if ( session_ptr->class_num == LOAD_GEN_CLASS_IMPOSTOR )
+         {
+         if ( session_ptr->passed == 1 )
+            false_accepts++;
+         else
+            true_rejects++;
+         }
+      else if ( session_ptr->passed == 0 )
+         false_rejects++;
+      else if ( session_ptr->reported_chip_num != session_ptr->expected_chip_num )
+         { false_accepts++; misidentified++; }
+      else
+         true_accepts++;
+      }
+   fclose(OUTFILE);
+
+   sprintf(outfile_name, "%s_summary.txt", results_prefix);
+   if ( (OUTFILE = fopen(outfile_name, "w")) == NULL )
+      { printf("ERROR: LoadGenReport(): Could not open '%s' for writing!\n", outfile_name); exit(EXIT_FAILURE); }
+
+   fprintf(OUTFILE, "num_concurrent\t%d\n", num_concurrent);
+   fprintf(OUTFILE, "num_authentications\t%d\n", LG_ptr->num_authens);
+   fprintf(OUTFILE, "wall_us\t%ld\n", wall_usecs);
+   fprintf(OUTFILE, "throughput_authen_per_s\t%.3f\n", (double)LG_ptr->num_authens * 1000000.0/(double)wall_usecs);
+   fprintf(OUTFILE, "true_accepts\t%d\n", true_accepts);
+   fprintf(OUTFILE, "false_rejects\t%d\n", false_rejects);
+   fprintf(OUTFILE, "false_accepts\t%d\n", false_accepts);
+   fprintf(OUTFILE, "misidentified\t%d\n", misidentified);
+   fprintf(OUTFILE, "true_rejects\t%d\n", true_rejects);
+   for ( class_num = 0; class_num < LOAD_GEN_NUM_CLASSES; class_num++ )
+      {
+      fprintf(OUTFILE, "%s_authentications\t%d\n", LoadGen_class_names[class_num], class_cnts[class_num]);
+      fprintf(OUTFILE, "%s_mean_attempts\t%.3f\n", LoadGen_class_names[class_num],
+         class_cnts[class_num] == 0 ? 0.0 : (float)class_attempts[class_num]/(float)class_cnts[class_num]);
+      fprintf(OUTFILE, "%s_retried\t%d\n", LoadGen_class_names[class_num], class_retried[class_num]);
+      }
+
+   if ( (vals = (long *)malloc(sizeof(long) * LG_ptr->num_authens)) == NULL )
+      { printf("ERROR: LoadGenReport(): Failed to allocate storage for vals!\n"); exit(EXIT_FAILURE); }
+   for ( phase_num = 0; phase_num < LOAD_GEN_NUM_PHASES; phase_num++ )
+      {
+      sum = 0;
+      for ( num_vals = 0; num_vals < LG_ptr->num_authens; num_vals++ )
+         {
+         vals[num_vals] = LG_ptr->sessions[num_vals].phase_usecs[phase_num];
+         sum += vals[num_vals];
+         }
+      qsort(vals, num_vals, sizeof(long), LoadGenCompareLong);
+
+      fprintf(OUTFILE, "%s_mean_us\t%ld\n", LoadGen_phase_names[phase_num], sum/num_vals);
+      fprintf(OUTFILE, "%s_p50_us\t%ld\n", LoadGen_phase_names[phase_num], LoadGenPercentile(num_vals, vals, 50.0));
+      fprintf(OUTFILE, "%s_p99_us\t%ld\n", LoadGen_phase_names[phase_num], LoadGenPercentile(num_vals, vals, 99.0));
+      fprintf(OUTFILE, "%s_p999_us\t%ld\n", LoadGen_phase_names[phase_num], LoadGenPercentile(num_vals, vals, 99.9));
+      fprintf(OUTFILE, "%s_max_us\t%ld\n", LoadGen_phase_names[phase_num], vals[num_vals - 1]);
+      }
+   free(vals);
+   fclose(OUTFILE);
+
+   printf("SUMMARY: Concurrent %d\tAuthentications %d\tThroughput %.2f authentications/s\tTA %d\tFR %d\tFA %d\tTR %d\n", num_concurrent,
+      LG_ptr->num_authens, (double)LG_ptr->num_authens * 1000000.0/(double)wall_usecs, true_accepts, false_rejects, false_accepts, true_rejects);
+   printf("\tResults in '%s_sessions.txt' and '%s_summary.txt'\n", results_prefix, results_prefix);
+   fflush(stdout);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// ========================================================================================================
+
+int main(int argc, char *argv[])
+   {
+   LoadGenStruct LG;
+   pthread_t *threads;
+   int num_concurrent, thread_num, log_device_output, stdout_fd, log_fd;
+   char log_file_name[MAX_STRING_LEN];
+
+   char *DB_name_Challenges, *DB_name_NAT, *DB_name_impostor, *results_prefix;
+   char *Netlist_name, *Synthesis_name;
+   struct timeval t0, t1;
+
+   memset(&LG, 0, sizeof(LoadGenStruct));
+
+   Allocate1DString(&(LG.Bank_IP), MAX_STRING_LEN);
+   Allocate1DString(&(LG.ChallengeSetName), MAX_STRING_LEN);
+   Allocate1DString(&DB_name_Challenges, MAX_STRING_LEN);
+   Allocate1DString(&DB_name_NAT, MAX_STRING_LEN);
+   Allocate1DString(&DB_name_impostor, MAX_STRING_LEN);
+   Allocate1DString(&results_prefix, MAX_STRING_LEN);
+   Allocate1DString(&Netlist_name, MAX_STRING_LEN);
+   Allocate1DString(&Synthesis_name, MAX_STRING_LEN);
+
+// ======================================================================================================================
+// COMMAND LINE
+// ======================================================================================================================
+   if ( argc != 11 )
+      {
+      printf("Parameters: Bank IP (127.0.0.1) -- NAT DB (NAT_Master_TDC.db) -- Impostor DB (Impostors.db or 'none') -- Num concurrent (100) -- Num authentications (1000) -- Impostor %% (10) -- Noisy %% (10) -- Noise sigma (0.5) -- Noisy sigma (40.0) -- Results prefix (LoadGen)\n");
+      exit(EXIT_FAILURE);
+      }
+
+   strcpy(LG.Bank_IP, argv[1]);
+   strcpy(DB_name_NAT, argv[2]);
+   strcpy(DB_name_impostor, argv[3]);
+   sscanf(argv[4], "%d", &num_concurrent);
+   sscanf(argv[5], "%d", &(LG.num_authens));
+   sscanf(argv[6], "%d", &(LG.impostor_pct));
+   sscanf(argv[7], "%d", &(LG.noisy_pct));
+   sscanf(argv[8], "%f", &(LG.noise_sigma));
+   sscanf(argv[9], "%f", &(LG.noisy_sigma));
+   strcpy(results_prefix, argv[10]);
+
+   if ( num_concurrent <= 0 || num_concurrent > LOAD_GEN_MAX_THREADS )
+      { printf("ERROR: 'Num concurrent' MUST be > 0 and <= %d!\n", LOAD_GEN_MAX_THREADS); exit(EXIT_FAILURE); }
+   if ( LG.num_authens <= 0 )
+      { printf("ERROR: 'Num authentications' MUST be > 0!\n"); exit(EXIT_FAILURE); }
+   if ( LG.impostor_pct < 0 || LG.noisy_pct < 0 || LG.impostor_pct + LG.noisy_pct > 100 )
+      { printf("ERROR: 'Impostor %%' and 'Noisy %%' MUST be >= 0 and sum to <= 100!\n"); exit(EXIT_FAILURE); }
+   if ( LG.impostor_pct > 0 && strcmp(DB_name_impostor, "none") == 0 )
+      { printf("ERROR: 'Impostor %%' is %d but there is NO impostor DB!\n", LG.impostor_pct); exit(EXIT_FAILURE); }
+
+// ====================================================== PARAMETERS ====================================================
+// Must match device_regeneration.c and the verifier.
+   strcpy(DB_name_Challenges, "Challenges.db");
+   strcpy(Netlist_name, "SR_RFM_V4_TDC");
+   strcpy(Synthesis_name, "SRFSyn1");
+   strcpy(LG.ChallengeSetName, "Master1_OptKEK_TVN_0.00_WID_1.75");
+   LG.chlng_rng_mode = CHLNG_RNG_GLIBC_COMPAT;
+   LG.port_number = 8888;
+
+// Seed of the class/chip selection and of the PN noise. Keep it fixed to compare builds of the verifier.
+   LG.seed = 1;
+
+// The device protocol prints many lines per authentication. Send them to <Results prefix>_device.log while the sessions
+// run so the console does not limit the throughput. Errors that end the run are at the end of the log.
+   log_device_output = 1;
+// ====================================================== PARAMETERS ====================================================
+
+   LG.DB_Challenges = LoadGenOpenDB(MAX_STRING_LEN, DB_name_Challenges, Netlist_name, Synthesis_name, &(LG.design_index));
+   LG.DB_NAT = LoadGenOpenDB(MAX_STRING_LEN, DB_name_NAT, Netlist_name, Synthesis_name, &(LG.NAT_design_index));
+   LG.num_genuine_chips = LoadGenGetChips(MAX_STRING_LEN, LG.DB_NAT, &(LG.genuine_chips));
+   if ( strcmp(DB_name_impostor, "none") != 0 )
+      {
+      LG.DB_impostor = LoadGenOpenDB(MAX_STRING_LEN, DB_name_impostor, Netlist_name, Synthesis_name, &(LG.impostor_design_index));
+      LG.num_impostor_chips = LoadGenGetChips(MAX_STRING_LEN, LG.DB_impostor, &(LG.impostor_chips));
+      }
+
+   printf("PARAMETERS: Bank IP %s\tGenuine chips %d\tImpostor chips %d\tConcurrent %d\tAuthentications %d\tImpostor %d%%\tNoisy %d%%\tSigma %.3f\tNoisy sigma %.3f\n",
+      LG.Bank_IP, LG.num_genuine_chips, LG.num_impostor_chips, num_concurrent, LG.num_authens, LG.impostor_pct, LG.noisy_pct,
+      LG.noise_sigma, LG.noisy_sigma);
+   fflush(stdout);
+
+   if ( (LG.sessions = (LoadGenSessionStruct *)calloc(LG.num_authens, sizeof(LoadGenSessionStruct))) == NULL )
+      { printf("ERROR: Failed to allocate storage for sessions!\n"); exit(EXIT_FAILURE); }
+   if ( (threads = (pthread_t *)malloc(sizeof(pthread_t) * num_concurrent)) == NULL )
+      { printf("ERROR: Failed to allocate storage for threads!\n"); exit(EXIT_FAILURE); }
+   pthread_mutex_init(&(LG.next_authen_mutex), NULL);
+
+   stdout_fd = -1;
+   if ( log_device_output == 1 )
+      {
+      sprintf(log_file_name, "%s_device.log", results_prefix);
+      if ( (stdout_fd = dup(STDOUT_FILENO)) < 0 || (log_fd = open(log_file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0 )
+         { printf("ERROR: Failed to redirect the device output to '%s'!\n", log_file_name); exit(EXIT_FAILURE); }
+      dup2(log_fd, STDOUT_FILENO);
+      close(log_fd);
+      }
+
+   gettimeofday(&t0, 0);
+   for ( thread_num = 0; thread_num < num_concurrent; thread_num++ )
+      if ( pthread_create(&(threads[thread_num]), NULL, LoadGenThread, (void *)&LG) != 0 )
+         { fprintf(stderr, "ERROR: Failed to create device thread %d!\n", thread_num); exit(EXIT_FAILURE); }
+   for ( thread_num = 0; thread_num < num_concurrent; thread_num++ )
+      pthread_join(threads[thread_num], NULL);
+   gettimeofday(&t1, 0);
+
+   if ( stdout_fd >= 0 )
+      {
+      fflush(stdout);
+      dup2(stdout_fd, STDOUT_FILENO);
+      close(stdout_fd);
+      }
+
+   LoadGenReport(MAX_STRING_LEN, &LG, results_prefix, num_concurrent, LoadGenUsecs(&t0, &t1));
+
+   pthread_mutex_destroy(&(LG.next_authen_mutex));
+   free(threads);
+   free(LG.sessions);
+   free(LG.genuine_chips);
+   if ( LG.impostor_chips != NULL )
+      free(LG.impostor_chips);
+
+   SQLStmtCacheFinalize(LG.DB_Challenges);
+   SQLStmtCacheFinalize(LG.DB_NAT);
+   sqlite3_close(LG.DB_Challenges);
+   sqlite3_close(LG.DB_NAT);
+   if ( LG.DB_impostor != NULL )
+      {
+      SQLStmtCacheFinalize(LG.DB_impostor);
+      sqlite3_close(LG.DB_impostor);
+      }
+
+   return 0;
+   }
@@ -15,11 +15,17 @@
 #include "device_hardware.h"
 #include "device_common.h"
 #include "device_regen_funcs.h"
+#include "device_hw_wait.h"
+#include "device_bram_xfer.h"
 
 // ====================== DATABASE STUFF =========================
 #include <sqlite3.h>
 #include "commonDB.h"
 
+#ifdef DEVICE_SIM
+#include "device_sim_PL.h"
+#endif
+
 
 // ========================================================================================================
 // ========================================================================================================
@@ -75,11 +81,33 @@ unsigned char **ConvertVecsToChallenge(int max_string_len, int num_vecs, int num
    }
 
 
+// ========================================================================================================
+// ========================================================================================================
+// Stage the vectors 'start_vec_num' up to 'start_vec_num' + 'chlng_stage_vecs' (or the last vector) into
+// 'staged_words', 'words_per_vec' words per vector.
+
+static void StageChlngChunk(int num_PIs, int num_POs, int vec_chunk_size, unsigned int ctrl_mask, int num_vecs, int start_vec_num, 
+   int chlng_stage_vecs, int words_per_vec, int has_masks, unsigned char **first_vecs_b, unsigned char **second_vecs_b, 
+   unsigned char **masks_b, unsigned int *staged_words)
+   {
+   int vec_num;
+
+   for ( vec_num = start_vec_num; vec_num < num_vecs && vec_num < start_vec_num + chlng_stage_vecs; vec_num++ )
+      StageChlngAndMask(num_PIs, first_vecs_b[vec_num], second_vecs_b[vec_num], has_masks, num_POs, has_masks == 1 ? masks_b[vec_num] : NULL,
+         ctrl_mask, vec_chunk_size, staged_words + (vec_num - start_vec_num)*words_per_vec);
+
+   return;
+   }
+
+
 // ========================================================================================================
 // ========================================================================================================
 // Collect all PNs. This is the longer operation associated with SRF (depending on the number of samples).
+// With 'chlng_stage_vecs' > 0, the vectors are staged in chunks of 'chlng_stage_vecs' in two buffers: the
+// next chunk is staged while the PL measures the first vector of the current one, so a request is answered
+// with the handshakes only.
 
-int CollectPNs(int max_string_len, int num_POs, int num_PIs, int vec_chunk_size, int max_generated_nonce_bytes, 
+int CollectPNs(int max_string_len, int num_POs, int num_PIs, int vec_chunk_size, int chlng_stage_vecs, int max_generated_nonce_bytes, 
    volatile unsigned int *CtrlRegA, volatile unsigned int *DataRegA, unsigned int ctrl_mask, int num_vecs, 
    int num_rise_vecs, int has_masks, unsigned char **first_vecs_b, unsigned char **second_vecs_b, 
    unsigned char **masks_b, unsigned char *device_n1, int DUMP_BITSTRINGS, int debug_flag)
@@ -88,7 +116,11 @@ int CollectPNs(int max_string_len, int num_POs, int num_PIs, int vec_chunk_size,
 
 // *** VEC_CHLNG ***
    int num_chlng_bits = num_PIs * 2;
-   unsigned char **challenges_b;
+   unsigned char **challenges_b = NULL;
+
+// Double-buffered challenge staging. Chunk 'vec_num/chlng_stage_vecs' lives in buffer (vec_num/chlng_stage_vecs) % 2.
+   unsigned int *staged_words = NULL;
+   int words_per_vec, buffer_num, slot_num;
 
    struct timeval t0, t1;
    long elapsed; 
@@ -108,22 +140,36 @@ int CollectPNs(int max_string_len, int num_POs, int num_PIs, int vec_chunk_size,
 // this C code executes the main while loop BEFORE MstCtrl has a chance to start CollectPNs, then you would get all zeros for the timing 
 // data (no vectors would have been delivered). This is prevented with this additional while loop check, which waits for IN_SM_DONE_ALL_VECS 
 // to got low.
-   while ( ((*DataRegA) & (1 << IN_SM_DONE_ALL_VECS)) != 0 );
+   DeviceHWWaitBits(DataRegA, 1 << IN_SM_DONE_ALL_VECS, 0, HW_WAIT_FOREVER);
 
 // I store the challenges in the database as two vector sequences even though for SRF, there is only ONE configuration challenge. 
 // I'll eventually change the database structure, but right now, I simply split the one challenge into two pieces and store
 // the first half in first_vecs_b and the second half in second_vecs_b. This routine simply joins these vectors pairs and
 // returns 'challenges_b'.
 // *** VEC_CHLNG ***
-   challenges_b = ConvertVecsToChallenge(max_string_len, num_vecs, num_PIs, first_vecs_b, second_vecs_b, num_chlng_bits);
+// When staged, the vectors are joined as the chunks are staged, and the first chunk is staged here.
+   words_per_vec = num_chlng_bits/vec_chunk_size;
+   if ( has_masks == 1 )
+      words_per_vec += num_POs/vec_chunk_size;
+   if ( chlng_stage_vecs == 0 )
+      challenges_b = ConvertVecsToChallenge(max_string_len, num_vecs, num_PIs, first_vecs_b, second_vecs_b, num_chlng_bits);
+   else
+      {
+      if ( (staged_words = (unsigned int *)malloc(sizeof(unsigned int) * 2 * chlng_stage_vecs * words_per_vec)) == NULL )
+         { printf("ERROR: CollectPNs(): Failed to allocate storage for staged challenges!\n"); exit(EXIT_FAILURE); }
+      StageChlngChunk(num_PIs, num_POs, vec_chunk_size, ctrl_mask, num_vecs, 0, chlng_stage_vecs, words_per_vec, has_masks, first_vecs_b, 
+         second_vecs_b, masks_b, staged_words);
+      }
 
 // Vectors are requested as needed by the CollectPNs.vhd routine (no internal vector storage).
    generated_device_num_n1_bytes = 0;
 
 // Nasty BUG 6_3_2016 here -- VHDL was setting IN_SM_DONE_ALL_VECS BEFORE the last potential NONCE byte was generated and was hanging the 
 // VHDL/C code. 
+// Each pass waits for the next vector request, nonce word or the PN termination condition instead of spinning on DataRegA.
    vec_num = 0;
-   while ( ((*DataRegA) & (1 << IN_SM_DONE_ALL_VECS)) == 0 )
+   while ( (DeviceHWWaitAnyBit(DataRegA, (1 << IN_SM_LOAD_VEC_PAIR) | (1 << IN_SM_HANDSHAKE) | (1 << IN_SM_DONE_ALL_VECS), 
+      HW_WAIT_FOREVER) & (1 << IN_SM_DONE_ALL_VECS)) == 0 )
       {
 
 // Transfer a vector to VHDL registers once it is requested. NOTE: It is the responsibility of the verifier to provide exactly enough rising vectors 
@@ -155,8 +201,20 @@ printf("CollectPNs(): CPN ready %d\tPNDiff ready %d\tSHD_BG ready %d\tLM_ULM rea
             }
 
 // *** VEC_CHLNG ***
-         LoadChlngAndMask(max_string_len, CtrlRegA, DataRegA, vec_num, challenges_b, ctrl_mask, num_chlng_bits, vec_chunk_size, 
-            has_masks, num_POs, masks_b);
+         if ( chlng_stage_vecs == 0 )
+            LoadChlngAndMask(max_string_len, CtrlRegA, DataRegA, vec_num, challenges_b, ctrl_mask, num_chlng_bits, vec_chunk_size, 
+               has_masks, num_POs, masks_b);
+         else
+            {
+            buffer_num = (vec_num/chlng_stage_vecs) % 2;
+            slot_num = vec_num % chlng_stage_vecs;
+            LoadStagedChlngAndMask(CtrlRegA, DataRegA, ctrl_mask, words_per_vec, staged_words + (buffer_num*chlng_stage_vecs + slot_num)*words_per_vec);
+
+// The PL is measuring the first vector of this chunk. Stage the next chunk into the other buffer (its chunk is all loaded) meanwhile.
+            if ( slot_num == 0 )
+               StageChlngChunk(num_PIs, num_POs, vec_chunk_size, ctrl_mask, num_vecs, vec_num + chlng_stage_vecs, chlng_stage_vecs, words_per_vec, 
+                  has_masks, first_vecs_b, second_vecs_b, masks_b, staged_words + (1 - buffer_num)*chlng_stage_vecs*words_per_vec);
+            }
 
 #ifdef DEBUG
 PrintHeaderAndBinVals("", num_POs, masks_b[vec_num], 32);
@@ -195,7 +253,7 @@ printf("Got nonce word (16-bits) -- current number of nonce bytes %d\n", generat
 #endif
 
          *CtrlRegA = ctrl_mask | (1 << OUT_CP_HANDSHAKE);
-         while ( ((*DataRegA) & (1 << IN_SM_HANDSHAKE)) != 0 );
+         DeviceHWWaitBits(DataRegA, 1 << IN_SM_HANDSHAKE, 0, HW_WAIT_FOREVER);
          *CtrlRegA = ctrl_mask;
          }
       }
@@ -254,9 +312,12 @@ for ( i = 0; i < 4096; i++ )
 
 // Free up the challenges_b.
 // *** VEC_CHLNG ***
-   for ( vec_num = 0; vec_num < num_vecs; vec_num++ )
-      if ( challenges_b[vec_num] != NULL )
-         free(challenges_b[vec_num]);
+   if ( challenges_b != NULL )
+      for ( vec_num = 0; vec_num < num_vecs; vec_num++ )
+         if ( challenges_b[vec_num] != NULL )
+            free(challenges_b[vec_num]);
+   if ( staged_words != NULL )
+      free(staged_words);
 
 // Check for errors in overflow
    if ( ((*DataRegA) & (1 << IN_PNDIFF_OVERFLOW_ERR)) != 0 )
@@ -365,18 +426,16 @@ void SetSRFReuseModeStartSRFRequestSpreadFactors(int max_string_len, SRFHardware
    struct timeval t0, t1;
    long elapsed; 
 
-// Sanity check. PUF engine MUST be 'ready'
-   if ( (*(SHP_ptr->DataRegA) & (1 << IN_SM_READY)) == 0 )
+// Sanity check. PUF engine MUST be 'ready' (allowing it the settle time to return to idle).
+   if ( DeviceHWWaitBits(SHP_ptr->DataRegA, 1 << IN_SM_READY, 1 << IN_SM_READY, HW_WAIT_SETTLE) == 0 )
       { printf("ERROR: SetSRFReuseModeStartSRFRequestSpreadFactors(): PUF Engine is NOT ready!\n"); exit(EXIT_FAILURE); }
 
-// Re-start the PUF engine with the next LFSR seed. NOTE: This is not confirmed via a handshake, which it should be. Adding a usleep to make 
-// sure a 'slow' version of the hardware state machine sees the start signal.
+// Re-start the PUF engine with the next LFSR seed. The start signal is held until the state machine leaves idle (READY goes low), 
+// which makes sure a 'slow' version of the hardware state machine sees it, or for at most the settle time.
    SHP_ptr->ctrl_mask = SHP_ptr->ctrl_mask | (1 << OUT_CP_REUSE_PNS_MODE);
 
 // Start SRF
-   *(SHP_ptr->CtrlRegA) = SHP_ptr->ctrl_mask | (1 << OUT_CP_PUF_START); 
-   usleep(1000);
-   *(SHP_ptr->CtrlRegA) = SHP_ptr->ctrl_mask;
+   DeviceHWPulse(SHP_ptr->CtrlRegA, SHP_ptr->DataRegA, SHP_ptr->ctrl_mask, OUT_CP_PUF_START, 1 << IN_SM_READY, 0, HW_WAIT_SETTLE);
 
 #ifdef DEBUG
 printf("SetSRFReuseModeStartSRFRequestSpreadFactors(): RESTARTING PUF(): Sending SpreadFactors request!\n"); fflush(stdout);
@@ -613,7 +672,9 @@ printf("\tLFSR low %4u  high %4u  RC %3d  SC %3d  TH %2u  TCC %2u SCC %5d XMR %2
 
 // NOTE: RangeConstant is an unsigned integer no bigger than the number of hardware bits in PNL_BRAM for the integer portion, i.e., 11 bits can hold 
 // (-1023 to +1023).
-      if ( ((*DataRegA) & (1 << IN_SM_HANDSHAKE)) != 0 )
+#ifndef DEVICE_SIM
+      if ( DeviceHWWaitBits(DataRegA, 1 << IN_SM_HANDSHAKE, 1 << IN_SM_HANDSHAKE, HW_WAIT_FOREVER) == 1 )
+#endif
          {
          if ( param_num == 0 )
             out_val = LFSR_seed_low;
@@ -656,14 +717,20 @@ printf("\tLFSR low %4u  high %4u  RC %3d  SC %3d  TH %2u  TCC %2u SCC %5d XMR %2
             out_val = ScalingConstant;
 
 // 'OR' in the value into the low order 16 bits preserving the signed/unsigned nature of the value.
+#ifdef DEVICE_SIM
+         DeviceSimPLSetParam(DeviceSimPLFromRegs(DataRegA), param_num, out_val);
+#else
          *CtrlRegA = ctrl_mask | (1 << OUT_CP_HANDSHAKE) | (0x0000FFFF & out_val);
-         while ( ((*DataRegA) & (1 << IN_SM_HANDSHAKE)) != 0 );
+         DeviceHWWaitBits(DataRegA, 1 << IN_SM_HANDSHAKE, 0, HW_WAIT_FOREVER);
          *CtrlRegA = ctrl_mask;
+#endif
          param_num++; 
          }
       }
 
-   usleep(1000);
+// Give the hardware up to the settle time to flag a parameter error. It is done with the parameters once it asks for the 
+// SpreadFactors or the first output word (HANDSHAKE) or is back to idle.
+   DeviceHWWaitAnyBit(DataRegA, (1 << IN_PARAM_ERR) | (1 << IN_SM_HANDSHAKE) | (1 << IN_SM_READY), HW_WAIT_SETTLE);
    if ( ((*DataRegA) & (1 << IN_PARAM_ERR)) != 0 )
       { printf("ERROR: SelectSetParams(): Parameter error in hardware!\n"); exit(EXIT_FAILURE); }
 
@@ -688,7 +755,6 @@ void LoadUnloadBRAM(int max_string_len, int num_vals, volatile unsigned int *Ctr
    unsigned int ctrl_mask, unsigned char *ByteData, signed short *WordData, int load_or_unload, int byte_or_word_data, 
    int debug_flag)
    {
-   int val_num, locked_up, increment;
 
 // BYTE-TO-WORD
 // Sanity check. When byte_or_word_data is 0, then we are transferring in byte data two bytes at-a-time, i.e., we transfer 16-bits at a time 
@@ -706,71 +772,8 @@ void LoadUnloadBRAM(int max_string_len, int num_vals, volatile unsigned int *Ctr
          printf("LB.1) UnLoading BRAM: Number of values to unload %d\n", num_vals); 
       }
 
-   if ( byte_or_word_data == 0 )
-      increment = 2;
-   else
-      increment = 1;
-
-   for ( val_num = 0; val_num < num_vals; val_num += increment )
-      {
-
-#ifdef DEBUG
-printf("%4d) Load/unload %d\t\n", val_num, load_or_unload); fflush(stdout);
-#endif
-
-// Wait for 'stopped' from hardware to be asserted, which indicates that the hardware is ready to receive a byte.
-      locked_up = 0;
-      while ( ((*DataRegA) & (1 << IN_SM_HANDSHAKE)) == 0 )
-         {
-         locked_up++;
-         if ( locked_up > 10000000 )
-            { 
-            printf("ERROR: LoadUnloadBRAM(): 'stopped' has not been asserted for the threshold number of cycles -- Locked UP?\n"); 
-            fflush(stdout); 
-            locked_up = 0;
-            }
-         }
-
-// Put the data bytes into the register and assert 'continue' (OUT_CP_HANDSHAKE). iSpreadFactors are loaded one in each 16-bit word of PNL BRAM, so 
-// byte_or_word_data is set to 1 for SpreadFactor loads/unloads
-      if ( load_or_unload == 0 )
-         {
-         if ( byte_or_word_data == 0 )
-            *CtrlRegA = ctrl_mask | (1 << OUT_CP_HANDSHAKE) | (0x000000FF & ByteData[val_num]) | (0x0000FF00 & (ByteData[val_num+1] << 8));
-         else
-            *CtrlRegA = ctrl_mask | (1 << OUT_CP_HANDSHAKE) | (0x0000FFFF & WordData[val_num]);
-         }
-
-// When 'stopped' is asserted, the data is ready on the output register from the PNL BRAM -- get it.
-      else
-         {
-         if ( byte_or_word_data == 0 )
-            {
-            ByteData[val_num] = (0x000000FF & *DataRegA);
-            ByteData[val_num+1] = ((0x0000FF00 & *DataRegA) >> 8);
-            }
-         else
-            WordData[val_num] = (0x0000FFFF & *DataRegA);
-
-         *CtrlRegA = ctrl_mask | (1 << OUT_CP_HANDSHAKE); 
-         }
-
-// Wait for hardware to de-assert 'stopped' (it got the byte).
-      while ( ((*DataRegA) & (1 << IN_SM_HANDSHAKE)) != 0 );
-
-// De-assert 'continue'. ALSO, assert 'done' (OUT_CP_LM_ULM_DONE) SIMULTANEOUSLY to tell hardware this is the last word.
-      if ( val_num == num_vals - increment )
-         *CtrlRegA = ctrl_mask | (1 << OUT_CP_LM_ULM_DONE);
-      else
-         *CtrlRegA = ctrl_mask;
-      }
-
-// Handle case where 'num_vals' is 0.
-   if ( num_vals == 0 )
-      *CtrlRegA = ctrl_mask | (1 << OUT_CP_LM_ULM_DONE);
-
-// De-assert 'OUT_CP_LM_ULM_DONE'
-   *CtrlRegA = ctrl_mask;
+// Per-word GPIO handshake, mmap'd mailbox BRAM or the simulator's PL model, as selected with DeviceBRAMXferInit().
+   DeviceBRAMXfer(num_vals, CtrlRegA, DataRegA, ctrl_mask, ByteData, WordData, load_or_unload, byte_or_word_data);
 
    fflush(stdout);
 
@@ -916,8 +919,10 @@ fflush(stdout);
 // ****************************************
 // Check error flags. Should be done after full computation is completed but no way of knowing that at this point. Should be checked at the
 // end of a function. 'PNDIFF' errors can result in PNs or PNDiffs exceeding max. GPEVCal includes errors related to failing to find the bounds
-// of the distribution + parameter errors (range of 0)
-   usleep(1000);
+// of the distribution + parameter errors (range of 0). Wait up to the settle time for an error flag or for the engine to ask for
+// the next transfer (HANDSHAKE) or return to idle.
+   DeviceHWWaitAnyBit(DataRegA, (1 << IN_PNDIFF_OVERFLOW_ERR) | (1 << IN_GPEVCAL_ERR) | (1 << IN_SM_HANDSHAKE) | (1 << IN_SM_READY), 
+      HW_WAIT_SETTLE);
    if ( ((*DataRegA) & (1 << IN_PNDIFF_OVERFLOW_ERR)) != 0 )
       { printf("ERROR: RunSRFEngine(): PNDiff Overflow error in hardware!\n"); exit(EXIT_FAILURE); }
    if ( ((*DataRegA) & (1 << IN_GPEVCAL_ERR)) != 0 )
@@ -1135,15 +1140,13 @@ void CommonCore(int max_string_len, SRFHardwareParamsStruct *SHP_ptr, int verifi
    int force_threshold_zero, int do_all_calls, int current_function)
    {
 
-// Sanity check. PUF engine MUST be 'ready'
-   if ( (*(SHP_ptr->DataRegA) & (1 << IN_SM_READY)) == 0 )
+// Sanity check. PUF engine MUST be 'ready' (allowing it the settle time to return to idle).
+   if ( DeviceHWWaitBits(SHP_ptr->DataRegA, 1 << IN_SM_READY, 1 << IN_SM_READY, HW_WAIT_SETTLE) == 0 )
       { printf("ERROR: CommonCore(): PUF Engine is NOT ready!\n"); exit(EXIT_FAILURE); }
 
-// Start the PUF engine. NOTE: This is not confirmed via a handshake, which it should be. Adding a usleep to make sure a 'slow' version of
-// the hardware state machine sees the start signal.
-   *(SHP_ptr->CtrlRegA) = SHP_ptr->ctrl_mask | (1 << OUT_CP_PUF_START); 
-   usleep(1000);
-   *(SHP_ptr->CtrlRegA) = SHP_ptr->ctrl_mask;
+// Start the PUF engine. The start signal is held until the state machine leaves idle (READY goes low), which makes sure a 'slow' version 
+// of the hardware state machine sees it, or for at most the settle time.
+   DeviceHWPulse(SHP_ptr->CtrlRegA, SHP_ptr->DataRegA, SHP_ptr->ctrl_mask, OUT_CP_PUF_START, 1 << IN_SM_READY, 0, HW_WAIT_SETTLE);
 
 // Get vectors and masks from verifier (or a seed to read them from the DB_Challenges DB when 'use_database_chlngs' is 1) -- allocate memory 
 // for them dynamically. Assume previous allocation (if any) have been freed already. The flag 'gen_or_use_challenge_seed' must be 0 here
@@ -1154,7 +1157,7 @@ void CommonCore(int max_string_len, SRFHardwareParamsStruct *SHP_ptr, int verifi
    SHP_ptr->num_vecs = GoGetVectors(max_string_len, SHP_ptr->num_POs, SHP_ptr->num_PIs, verifier_socket_desc, &(SHP_ptr->num_rise_vecs),
       &(SHP_ptr->has_masks), &(SHP_ptr->first_vecs_b), &(SHP_ptr->second_vecs_b), &(SHP_ptr->masks_b), send_GO_request, 
       SHP_ptr->use_database_chlngs, SHP_ptr->DB_Challenges, SHP_ptr->DB_design_index, SHP_ptr->DB_ChallengeSetName, gen_or_use_challenge_seed,
-      &(SHP_ptr->DB_ChallengeGen_seed), SHP_ptr->GenChallenge_mutex_ptr, SHP_ptr->DEBUG_FLAG);
+      &(SHP_ptr->DB_ChallengeGen_seed), SHP_ptr->chlng_rng_mode, SHP_ptr->DEBUG_FLAG);
 
 #ifdef DEBUG
 SaveASCIIVectors(max_string_len, SHP_ptr->num_vecs, SHP_ptr->first_vecs_b, SHP_ptr->second_vecs_b, SHP_ptr->num_PIs, 
@@ -1163,10 +1166,28 @@ SaveASCIIVectors(max_string_len, SHP_ptr->num_vecs, SHP_ptr->first_vecs_b, SHP_p
 
 // Set this global variable to prevent Ctrl-C from exiting while the SRF PUF is running. Record the number of hardware generated nonce bytes.
    SAFE_TO_QUIT = 0;
-   SHP_ptr->num_device_n1_nonces = CollectPNs(max_string_len, SHP_ptr->num_POs, SHP_ptr->num_PIs, SHP_ptr->vec_chunk_size, 
+#ifdef DEVICE_SIM
+// The vectors go through the CollectPNs() loop to the vector interface of the software PL model, which then looks up the PNs of this 
+// challenge from the seed and checks the vectors and masks it received against it. The nonce bytes come from the model.
+   DeviceSimPLStruct *SimPL_ptr = DeviceSimPLFromRegs(SHP_ptr->DataRegA);
+   int sim_num_vecs = SHP_ptr->num_vecs, sim_num_rise_vecs = SHP_ptr->num_rise_vecs;
+   unsigned char **sim_first_vecs_b, **sim_second_vecs_b, **sim_masks_b;
+
+   DeviceSimPLArmVecs(SimPL_ptr, SHP_ptr->num_vecs, SHP_ptr->num_PIs, SHP_ptr->num_POs, SHP_ptr->has_masks);
+   CollectPNs(max_string_len, SHP_ptr->num_POs, SHP_ptr->num_PIs, SHP_ptr->vec_chunk_size, SHP_ptr->chlng_stage_vecs, 
+      SHP_ptr->max_generated_nonce_bytes, SHP_ptr->CtrlRegA, SHP_ptr->DataRegA, SHP_ptr->ctrl_mask, SHP_ptr->num_vecs, SHP_ptr->num_rise_vecs, 
+      SHP_ptr->has_masks, SHP_ptr->first_vecs_b, SHP_ptr->second_vecs_b, SHP_ptr->masks_b, SHP_ptr->device_n1, 0, SHP_ptr->DEBUG_FLAG);
+   DeviceSimPLGetVecs(SimPL_ptr, SHP_ptr->num_PIs, SHP_ptr->num_POs, SHP_ptr->has_masks, &sim_first_vecs_b, &sim_second_vecs_b, &sim_masks_b);
+   SHP_ptr->num_device_n1_nonces = DeviceSimPLCollectPNs(max_string_len, SimPL_ptr, SHP_ptr->DB_ChallengeGen_seed, 
+      SHP_ptr->chlng_rng_mode, SHP_ptr->num_vecs, SHP_ptr->num_PIs, SHP_ptr->num_POs, sim_first_vecs_b, sim_second_vecs_b, 
+      SHP_ptr->has_masks == 1 ? sim_masks_b : SHP_ptr->masks_b, SHP_ptr->max_generated_nonce_bytes, SHP_ptr->device_n1);
+   FreeVectorsAndMasks(&sim_num_vecs, &sim_num_rise_vecs, &sim_first_vecs_b, &sim_second_vecs_b, &sim_masks_b);
+#else
+   SHP_ptr->num_device_n1_nonces = CollectPNs(max_string_len, SHP_ptr->num_POs, SHP_ptr->num_PIs, SHP_ptr->vec_chunk_size, SHP_ptr->chlng_stage_vecs, 
       SHP_ptr->max_generated_nonce_bytes, SHP_ptr->CtrlRegA, SHP_ptr->DataRegA, SHP_ptr->ctrl_mask, SHP_ptr->num_vecs, SHP_ptr->num_rise_vecs, 
       SHP_ptr->has_masks, SHP_ptr->first_vecs_b, SHP_ptr->second_vecs_b, SHP_ptr->masks_b, SHP_ptr->device_n1, SHP_ptr->DUMP_BITSTRINGS, 
       SHP_ptr->DEBUG_FLAG);
+#endif
    SAFE_TO_QUIT = 1;
 
 printf("Finished CollectPNs\n"); fflush(stdout);
@@ -1525,8 +1546,8 @@ printf("\tNum nonce bits %d\tNumber of iterations %d\n", SHP_ptr->num_KEK_authen
    if ( SockSendB(KEK_authen_XMR_SHD, current_XMR_SHD_num_bytes, verifier_socket_desc) < 0 )
       { printf("ERROR: KEK_DeviceAuthentication_SKE(): Send KEK_authen_XMR_SHD failed\n"); exit(EXIT_FAILURE); }
 
-// Sanity check. PUF engine MUST be 'ready'
-   if ( (*(SHP_ptr->DataRegA) & (1 << IN_SM_READY)) == 0 )
+// Sanity check. PUF engine MUST be 'ready' (allowing it the settle time to return to idle).
+   if ( DeviceHWWaitBits(SHP_ptr->DataRegA, 1 << IN_SM_READY, 1 << IN_SM_READY, HW_WAIT_SETTLE) == 0 )
       { printf("ERROR: KEK_DeviceAuthentication_SKE(): PUF Engine is NOT ready!\n"); exit(EXIT_FAILURE); }
 
 // ----------------------------------------
@@ -1625,8 +1646,8 @@ int TRNG(int max_string_len, SRFHardwareParamsStruct *SHP_ptr, int int_or_ext_mo
 //      *CtrlRegA = ctrl_mask;
 //      }
 
-// Sanity check. PUF engine MUST be 'ready'
-   if ( (*DataRegA & (1 << IN_SM_READY)) == 0 )
+// Sanity check. PUF engine MUST be 'ready' (allowing it the settle time to return to idle).
+   if ( DeviceHWWaitBits(DataRegA, 1 << IN_SM_READY, 1 << IN_SM_READY, HW_WAIT_SETTLE) == 0 )
       { printf("ERROR: TRNG(): PUF Engine is NOT ready!\n"); exit(EXIT_FAILURE); }
 
 // Start the PUF engine.
@@ -1698,14 +1719,9 @@ PrintHeaderAndHexVals("Random Bitstring\n", SHP_ptr->num_required_PNDiffs/8, SHP
    else
       {
 
-// Need to wait for READY here.
-      while ( (*DataRegA & (1 << IN_SM_READY)) == 0 )
-         {
-         usleep(100000);
-         if ( ((*DataRegA) & (1 << IN_PARAM_ERR)) != 0 )
-            { printf("ERROR: TRNG(): Parameter error in hardware!\n"); exit(EXIT_FAILURE); }
-//         printf("TRNG(): Internal: Waiting for TRNG to finish!\n"); fflush(stdout);
-         }
+// Need to wait for READY here (or a parameter error). This used to poll every 100 ms.
+      if ( (DeviceHWWaitAnyBit(DataRegA, (1 << IN_SM_READY) | (1 << IN_PARAM_ERR), HW_WAIT_FOREVER) & (1 << IN_SM_READY)) == 0 )
+         { printf("ERROR: TRNG(): Parameter error in hardware!\n"); exit(EXIT_FAILURE); }
 
 printf("INT TRNG DONE!\n"); fflush(stdout);
 #ifdef DEBUG
@@ -21,7 +21,7 @@ int FetchTransSHD_SBS(int max_string_len, int target_bytes, volatile unsigned in
    volatile unsigned int *DataRegA, unsigned int ctrl_mask, int verifier_socket_desc, unsigned char *SHD_SBS, 
    int also_do_transfer, int SHD_or_SBS, int TA_or_KEK, int DUMP_BITSTRINGS, int DEBUG);
 
-int CollectPNs(int max_string_len, int num_POs, int num_PIs, int vec_chunk_size, int max_generated_nonce_bytes, 
+int CollectPNs(int max_string_len, int num_POs, int num_PIs, int vec_chunk_size, int chlng_stage_vecs, int max_generated_nonce_bytes, 
    volatile unsigned int *CtrlRegA, volatile unsigned int *DataRegA, unsigned int ctrl_mask, int num_vecs, 
    int num_rise_vecs, int has_masks, unsigned char **first_vecs_b, unsigned char **second_vecs_b, 
    unsigned char **masks_b, unsigned char *device_n1, int DUMP_BITSTRINGS, int DEBUG);
@@ -17,11 +17,17 @@
 #include "device_hardware.h"
 #include "device_common.h"
 #include "device_regen_funcs.h"
+#include "device_hw_wait.h"
+#include "device_bram_xfer.h"
 
 // ====================== DATABASE STUFF =========================
 #include <sqlite3.h>
 #include "commonDB.h"
 
+#ifdef DEVICE_SIM
+#include "device_sim_PL.h"
+#endif
+
 extern int usleep (__useconds_t __useconds);
 extern int getpagesize (void)  __THROW __attribute__ ((__const__));
 
@@ -30,6 +36,10 @@ extern int getpagesize (void)  __THROW __attribute__ ((__const__));
 // ========================================================================================================
 SRFHardwareParamsStruct SHP;
 
+#ifdef DEVICE_SIM
+DeviceSimPLStruct SimPL;
+#endif
+
 int main(int argc, char *argv[])
    {
    volatile unsigned int *CtrlRegA;
@@ -70,6 +80,7 @@ int main(int argc, char *argv[])
    char *DB_name_Challenges;
    Allocate1DString(&DB_name_Challenges, MAX_STRING_LEN);
    int use_database_chlngs; 
+   int chlng_rng_mode; 
 
    char *Netlist_name;
    char *Synthesis_name;
@@ -82,6 +93,38 @@ int main(int argc, char *argv[])
 
    float command_line_SC;
 
+// Adaptive waits on the PL status bits (device_hw_wait.c).
+   int hw_wait_spin_polls, hw_wait_yield_polls, hw_wait_min_sleep_us, hw_wait_max_sleep_us, hw_wait_min_pulse_us;
+   long hw_wait_settle_timeout_us, hw_wait_lockup_warn_us;
+   char *hw_wait_UIO_dev_name;
+   Allocate1DString(&hw_wait_UIO_dev_name, MAX_STRING_LEN);
+
+// Backend of the SpreadFactor, nonce and helper data transfers to/from the PNL BRAM (device_bram_xfer.c).
+   int bram_xfer_backend;
+   volatile unsigned int *BRAM_window = NULL;
+
+// Vectors per chunk of the double-buffered challenge staging in CollectPNs().
+   int chlng_stage_vecs;
+
+// Number of back-to-back authentications with the Bank. Always 1 on the hardware.
+   int num_authens = 1;
+   int num_failed_authens = 0;
+   struct timeval t0, t1;
+   long elapsed, min_elapsed = 0, max_elapsed = 0, tot_elapsed = 0;
+
+#ifdef DEVICE_SIM
+   sqlite3 *DB_NAT;
+   char *DB_name_NAT;
+   char *PUF_instance_name;
+   int NAT_design_index;
+   float noise_sigma;
+   unsigned int sim_noise_seed;
+   long sim_ready_latency_us;
+   long sim_vec_latency_us;
+   Allocate1DString(&DB_name_NAT, MAX_STRING_LEN);
+   Allocate1DString(&PUF_instance_name, MAX_STRING_LEN);
+#endif
+
    Allocate1DString(&MyName, MAX_STRING_LEN);
    Allocate1DString(&My_IP, MAX_STRING_LEN);
    Allocate1DString(&Bank_IP, MAX_STRING_LEN);
@@ -89,16 +132,33 @@ int main(int argc, char *argv[])
 // ======================================================================================================================
 // COMMAND LINE
 // ======================================================================================================================
+#ifdef DEVICE_SIM
+   if ( argc != 8 )
+      {
+      printf("Parameters: MyName (Alice/Bob/Jim/Cyrus/George) -- Device IP (127.0.0.1) -- Bank IP (127.0.0.1) -- NAT DB (NAT_Master_TDC.db) -- PUFInstance name (C_Jim_204) -- Noise sigma (0.5) -- Num authentications (100)\n");
+      exit(EXIT_FAILURE);
+      }
+#else
    if ( argc != 4 )
       {
       printf("Parameters: MyName (Alice/Bob/Jim/Cyrus/George) -- Device IP (192.168.1.10) -- Bank IP (192.168.1.20)\n");
       exit(EXIT_FAILURE);
       }
+#endif
 
    strcpy(MyName, argv[1]);
    strcpy(My_IP, argv[2]);
    strcpy(Bank_IP, argv[3]);
 
+#ifdef DEVICE_SIM
+   strcpy(DB_name_NAT, argv[4]);
+   strcpy(PUF_instance_name, argv[5]);
+   sscanf(argv[6], "%f", &noise_sigma);
+   sscanf(argv[7], "%d", &num_authens);
+   if ( num_authens <= 0 )
+      { printf("ERROR: 'Num authentications' MUST be > 0!\n"); exit(EXIT_FAILURE); }
+#endif
+
    fix_params = 0;
    num_sams = 4;
    PCR_or_PBD_or_PO = 0;
@@ -135,6 +195,10 @@ int main(int argc, char *argv[])
    use_database_chlngs = 0;
    ChallengeGen_seed = 1;
 
+// Generator used to select the challenge from ChallengeGen_seed. MUST match the verifier's 'chlng_rng_mode'. CHLNG_RNG_GLIBC_COMPAT
+// reproduces the challenges of devices deployed with the original srand()/rand() based selection.
+   chlng_rng_mode = CHLNG_RNG_GLIBC_COMPAT;
+
 // SET TO WHATEVER bitstream you program with.
    int my_bitstream;
    my_bitstream = 0;
@@ -144,6 +208,43 @@ int main(int argc, char *argv[])
 // The PL-side TRNG_LFSR is 64 bits. 
    TRNG_LFSR_seed = 1;
 
+#ifdef DEVICE_SIM
+// Seed of the simulated PL's noise and nonce generator. Fixed so runs are repeatable (the verifier's nonces still differ from run to run).
+   sim_noise_seed = 1;
+
+// Time the simulated PL takes to return to idle (READY) after a start pulse. Makes the waits in device_hw_wait.c go through their
+// yield and sleep phases.
+   sim_ready_latency_us = 200;
+
+// Time the simulated PL takes to measure one vector before it requests the next, the window CollectPNs() stages challenges in.
+   sim_vec_latency_us = 20;
+#endif
+
+// Waits on the PL status bits: spin, then yield, then sleep with backoff from the min to the max sleep. The settle timeout bounds the
+// ready-bit waits after the start pulses and parameter/SpreadFactor transfers. Set the UIO device (e.g., "/dev/uio0") ONLY when the
+// bitstream's GPIO has its interrupt connected and the device tree binds it to generic-uio -- the sleeps then block on the interrupt.
+   hw_wait_spin_polls = HW_WAIT_SPIN_POLLS;
+   hw_wait_yield_polls = HW_WAIT_YIELD_POLLS;
+   hw_wait_min_sleep_us = HW_WAIT_MIN_SLEEP_US;
+   hw_wait_max_sleep_us = HW_WAIT_MAX_SLEEP_US;
+   hw_wait_settle_timeout_us = HW_WAIT_SETTLE_TIMEOUT_US;
+   hw_wait_lockup_warn_us = HW_WAIT_LOCKUP_WARN_US;
+   hw_wait_min_pulse_us = HW_WAIT_MIN_PULSE_US;
+   strcpy(hw_wait_UIO_dev_name, "");
+
+// Transfers to/from the PNL BRAM: BRAM_XFER_GPIO handshakes each 16-bit word through the GPIO registers. BRAM_XFER_MMAP copies the
+// block through the mapped mailbox BRAM and hands it over with one handshake -- ONLY with a bitstream that has the mailbox. The
+// simulator build moves the block directly into the PL model (BRAM_XFER_SIM).
+#ifdef DEVICE_SIM
+   bram_xfer_backend = BRAM_XFER_SIM;
+#else
+   bram_xfer_backend = BRAM_XFER_GPIO;
+#endif
+
+// CollectPNs() stages the next chunk of this many vectors (joined challenges and masks, ready for the handshakes) while the PL measures
+// the current chunk. 0 joins all vectors up front and loads each one when it is requested.
+   chlng_stage_vecs = CHLNG_STAGE_VECS;
+
 // NOTE: ASSUMPTION:
 //    NUM_XOR_NONCE_BYTES   <=  num_eCt_nonce_bytes   <=   SE_TARGET_NUM_KEY_BITS/8   <=   NUM_REQUIRED_PNDIFFS/8
 //           8                         16                            32                              256
@@ -200,6 +301,25 @@ int main(int argc, char *argv[])
 // When we save output file, this tells us what we used.
    printf("PARAMETERS: PCR/PBD %d\tSE Target Num Bits %d\n\n", PCR_or_PBD_or_PO, SE_TARGET_NUM_KEY_BITS); fflush(stdout);
 
+#ifdef DEVICE_SIM
+// The software PL model stands in for the hardware. Its registers take the place of the GPIO registers and it serves the PNs of 
+// 'PUF_instance_name' from the NAT timing database, which has its own PUFDesign index.
+   rc = sqlite3_open(":memory:", &DB_NAT);
+   if ( rc != 0 )
+      { printf("Failed to open NAT Database: %s\n", sqlite3_errmsg(DB_NAT)); sqlite3_close(DB_NAT); exit(EXIT_FAILURE); }
+   printf("Reading filesystem database '%s' into memory!\n", DB_name_NAT); fflush(stdout);
+   if ( LoadOrSaveDb(DB_NAT, DB_name_NAT, 0) != 0 )
+      { printf("Failed to open and copy into memory '%s': ERR: %s\n", DB_name_NAT, sqlite3_errmsg(DB_NAT)); sqlite3_close(DB_NAT); exit(EXIT_FAILURE); }
+   if ( GetPUFDesignParams(MAX_STRING_LEN, DB_NAT, Netlist_name, Synthesis_name, &NAT_design_index, &num_PIs_DB, &num_POs_DB) != 0 )
+      { printf("ERROR: PUFDesign index NOT found in NAT DB for '%s', '%s'!\n", Netlist_name, Synthesis_name); exit(EXIT_FAILURE); }
+
+   DeviceSimPLOpen(MAX_STRING_LEN, &SimPL, DB_NAT, NAT_design_index, ChallengeSetName, PUF_instance_name, noise_sigma, sim_noise_seed, 
+      DEBUG_FLAG);
+   SimPL.ready_latency_us = sim_ready_latency_us;
+   SimPL.vec_latency_us = sim_vec_latency_us;
+   DataRegA = SimPL.regs;
+   CtrlRegA = DataRegA + 2;
+#else
 // Open up the memory mapped device so we can access the GPIO registers.
    int fd = open("/dev/mem", O_RDWR|O_SYNC);
    if (fd < 0) 
@@ -209,6 +329,20 @@ int main(int argc, char *argv[])
    DataRegA = (volatile unsigned int *)mmap(0, getpagesize(), PROT_READ|PROT_WRITE, MAP_SHARED, fd, GPIO_0_BASE_ADDR);
    CtrlRegA = DataRegA + 2;
 
+   if ( bram_xfer_backend == BRAM_XFER_MMAP )
+      {
+      BRAM_window = (volatile unsigned int *)mmap(0, BRAM_MAILBOX_NUM_WORDS*sizeof(unsigned int), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 
+         BRAM_MAILBOX_BASE_ADDR);
+      if ( BRAM_window == MAP_FAILED )
+         { printf("ERROR: Mailbox BRAM at 0x%08X could NOT be mapped!\n", BRAM_MAILBOX_BASE_ADDR); exit(EXIT_FAILURE); }
+      }
+#endif
+
+   DeviceHWWaitInit(DataRegA, hw_wait_spin_polls, hw_wait_yield_polls, hw_wait_min_sleep_us, hw_wait_max_sleep_us, hw_wait_settle_timeout_us, 
+      hw_wait_lockup_warn_us, hw_wait_min_pulse_us, hw_wait_UIO_dev_name);
+   DeviceBRAMXferInit(bram_xfer_backend, BRAM_window, BRAM_window == NULL ? 0 : BRAM_MAILBOX_NUM_WORDS);
+   printf("BRAM transfers: '%s'\n", DeviceBRAMXferBackendName(bram_xfer_backend)); fflush(stdout);
+
 // ********************************************************************************************************** 
    *CtrlRegA = ctrl_mask | (1 << OUT_CP_RESET); 
    *CtrlRegA = ctrl_mask;
@@ -272,6 +406,7 @@ int main(int argc, char *argv[])
    SHP.DB_design_index = design_index;
    SHP.DB_ChallengeSetName = ChallengeSetName;
    SHP.DB_ChallengeGen_seed = ChallengeGen_seed; 
+   SHP.chlng_rng_mode = chlng_rng_mode;
 #ifdef INCLUDE_DATABASE
 #endif
 
@@ -347,6 +482,7 @@ int main(int argc, char *argv[])
       { printf("ERROR: Failed to allocate storage for XOR_nonce!\n"); exit(EXIT_FAILURE); }
 
    SHP.vec_chunk_size = CHLNG_CHUNK_SIZE; 
+   SHP.chlng_stage_vecs = chlng_stage_vecs;
    SHP.XMR_val = XMR_VAL;
 
    memcpy((char *)SHP.AES_IV, (char *)AES_IV, AES_IV_NUM_BYTES);
@@ -436,13 +572,6 @@ else
    SHP.total_bits = 0; 
    SHP.iteration = 0;
 
-// 10_31_2021: We are now using a seed to specify the vector sequence on the device, TTP and verifier. When challenges are selected, we depend
-// on the sequence returned by rand() to be the same no matter where this routine runs, device, TT or verifier. The verifier and TTP are multi-threaded
-// and therefore it is possible that multiple threads call this routine simultaneously, interrupting the sequence generated by rand() (rand is NOT re-entrant).
-// If this occurs, then the vector challenges used by the, e.g., verifier and device will be different and the security function will fail. When the device
-// calls this function, the mutex is NULL. 
-   SHP.GenChallenge_mutex_ptr = NULL;
-
    SHP.do_COBRA = DO_COBRA;
 
    SHP.DUMP_BITSTRINGS = DUMP_BITSTRINGS;
@@ -455,33 +584,68 @@ else
    SHP.use_database_chlngs = 1;
 
    load_seed = 0;
-   authen_num = 0;
-   printf("\nAUTHENTICATION NUMBER %d\n", authen_num); fflush(stdout);
-
    SHP.do_COBRA = 0;
-   while ( OpenSocketClient(MAX_STRING_LEN, Bank_IP, port_number, &Bank_socket_desc) < 0 )
-      { printf("INFO: Waiting to connect to Bank to send MY ID!\n"); fflush(stdout); usleep(200000); }
-
-   if ( SockSendB((unsigned char *)"CLIENT-AUTHENTICATION", strlen("CLIENT-AUTHENTICATION") + 1, Bank_socket_desc) < 0 )
-      { printf("ERROR: Failed to send 'CLIENT-AUTHENTICATION' to Bank!\n"); exit(EXIT_FAILURE); }
-
-   sprintf(my_info_str, "%d %f %s %d", SHP.chip_num, command_line_SC, My_IP, my_bitstream);
-   if ( SockSendB((unsigned char *)my_info_str, strlen(my_info_str) + 1, Bank_socket_desc) < 0 )
-      { printf("ERROR: main(): Failed to send my IP and bitstream number to Bank!\n"); exit(EXIT_FAILURE); }
-   if ( SockGetB((unsigned char *)ack_str, MAX_STRING_LEN, Bank_socket_desc) != 4  )
-      { printf("ERROR: Failed to get 'ACK' from Bank!\n"); exit(EXIT_FAILURE); }
-   if ( strcmp(ack_str, "ACK") != 0 )
-      { printf("ERROR: Failed to match 'ACK' string from Bank!\n"); exit(EXIT_FAILURE); }
+   for ( authen_num = 0; authen_num < num_authens; authen_num++ )
+      {
+      printf("\nAUTHENTICATION NUMBER %d\n", authen_num); fflush(stdout);
+      gettimeofday(&t0, 0);
+
+      while ( OpenSocketClient(MAX_STRING_LEN, Bank_IP, port_number, &Bank_socket_desc) < 0 )
+         { printf("INFO: Waiting to connect to Bank to send MY ID!\n"); fflush(stdout); usleep(200000); }
+
+// Buffer the replies from the Bank and turn off Nagle. The request and the ID information go out together in one write.
+      SockReaderAttach(Bank_socket_desc);
+      SockSetNoDelay(Bank_socket_desc, 1);
+
+      sprintf(my_info_str, "%d %f %s %d", SHP.chip_num, command_line_SC, My_IP, my_bitstream);
+      unsigned char *request_frames[2] = { (unsigned char *)"CLIENT-AUTHENTICATION", (unsigned char *)my_info_str };
+      int request_frame_sizes[2] = { strlen("CLIENT-AUTHENTICATION") + 1, strlen(my_info_str) + 1 };
+      if ( SockSendFrames(2, request_frames, request_frame_sizes, Bank_socket_desc) < 0 )
+         { printf("ERROR: main(): Failed to send 'CLIENT-AUTHENTICATION' and my IP and bitstream number to Bank!\n"); exit(EXIT_FAILURE); }
+      if ( SockGetB((unsigned char *)ack_str, MAX_STRING_LEN, Bank_socket_desc) != 4  )
+         { printf("ERROR: Failed to get 'ACK' from Bank!\n"); exit(EXIT_FAILURE); }
+      if ( strcmp(ack_str, "ACK") != 0 )
+         { printf("ERROR: Failed to match 'ACK' string from Bank!\n"); exit(EXIT_FAILURE); }
 // -------------------
 
-   TRNG(MAX_STRING_LEN, &SHP, FUNC_INT_TRNG, load_seed, 0, NULL);
+      TRNG(MAX_STRING_LEN, &SHP, FUNC_INT_TRNG, load_seed, 0, NULL);
 
-   if ( KEK_ClientServerAuthen(MAX_STRING_LEN, &SHP, Bank_socket_desc) == 0 )
-      { printf("ERROR: SKE MODE: FAILED TO AUTHENICATE!\n"); exit(EXIT_FAILURE); }
+// The simulator keeps going so the failure rate can be measured.
+      if ( KEK_ClientServerAuthen(MAX_STRING_LEN, &SHP, Bank_socket_desc) == 0 )
+         {
+#ifdef DEVICE_SIM
+         num_failed_authens++;
+#else
+         printf("ERROR: SKE MODE: FAILED TO AUTHENICATE!\n"); exit(EXIT_FAILURE);
+#endif
+         }
 
-   close(Bank_socket_desc);
+      SockReaderDetach(Bank_socket_desc);
+      close(Bank_socket_desc);
+
+      gettimeofday(&t1, 0); elapsed = (t1.tv_sec-t0.tv_sec)*1000000 + t1.tv_usec-t0.tv_usec; 
+      if ( authen_num == 0 || elapsed < min_elapsed )
+         min_elapsed = elapsed;
+      if ( authen_num == 0 || elapsed > max_elapsed )
+         max_elapsed = elapsed;
+      tot_elapsed += elapsed;
+      }
+
+// One line summary, e.g., to compare builds of the verifier.
+   printf("SUMMARY: Authentications %d\tFailed %d\tLatency (us) min %ld avg %ld max %ld\tThroughput %.2f authentications/s\n", 
+      num_authens, num_failed_authens, min_elapsed, tot_elapsed/num_authens, max_elapsed, (float)num_authens * 1000000.0/(float)tot_elapsed); 
+   fflush(stdout);
+   DeviceHWWaitPrintStats("HW WAITS: ");
+   DeviceHWWaitClose();
+
+#ifdef DEVICE_SIM
+   DeviceSimPLClose(&SimPL);
+   SQLStmtCacheFinalize(DB_NAT);
+   sqlite3_close(DB_NAT);
+#endif
 
-// The Challenges DB is read-only.
+// The Challenges DB is read-only. Finalize the cached prepared statements before closing it.
+   SQLStmtCacheFinalize(DB_Challenges);
    sqlite3_close(DB_Challenges);
 
    fflush(stdout);
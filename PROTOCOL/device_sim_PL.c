@@ -0,0 +1,683 @@
+// ========================================================================================================
+// ========================================================================================================
+// ******************************************* device_sim_PL.c ********************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+//
+// Software model of the PL side for the host-native device simulator (make sim). It replaces the hardware at the level of
+// the device functions that talk to it: CollectPNs (PNs and nonce bytes), the SelectSetParams parameter transfer and the
+// LoadUnloadBRAM block transfers. Everything else in device_regen_funcs.c runs unchanged, including the socket protocol
+// with the verifier. The start pulses and the ready-bit waits go through device_hw_wait.c, which steps the model on every
+// poll (DeviceSimPLPoll). The vectors are the exception to the function-level model: CollectPNs() delivers them through
+// the register-level vector interface (DeviceSimPLArmVecs), and they are checked against the challenge before the PNs are
+// served.
+//
+// The PNs are the enrolled TimingVals of one PUFInstance in the NAT database, looked up with the challenge seed the
+// verifier sends, plus Gaussian noise rounded to the 1/16 resolution of the hardware. The SRF engine is the verifier's
+// fixed-point engine (verifier_SRF_fixed.c), which is bit-exact with the hardware datapath, and KEK SKE enrollment is
+// KEK_FSB_SKE() from common.c. Only the PopOnly SpreadFactor mode that KEK_DeviceAuthentication_SKE() uses is modelled.
+
+#include "common.h"
+#include "device_hardware.h"
+#include "device_common.h"
+#include "verifier_common.h"
+#include "verifier_SRF_fixed.h"
+#include "device_sim_PL.h"
+
+// ====================== DATABASE STUFF =========================
+#include <sqlite3.h>
+#include "commonDB.h"
+
+
+// ========================================================================================================
+// ========================================================================================================
+// xorshift64* generator for the noise and the nonce bytes. Each model has its own state so several simulated
+// devices can run in one process.
+
+static unsigned long long DeviceSimPLRand(DeviceSimPLStruct *SimPL_ptr)
+   {
+   SimPL_ptr->rng_state ^= SimPL_ptr->rng_state >> 12;
+   SimPL_ptr->rng_state ^= SimPL_ptr->rng_state << 25;
+   SimPL_ptr->rng_state ^= SimPL_ptr->rng_state >> 27;
+   return SimPL_ptr->rng_state * 2685821657736338717ULL;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Standard normal sample (Box-Muller). The uniform in the log is in (0, 1].
+
+static double DeviceSimPLGaussian(DeviceSimPLStruct *SimPL_ptr)
+   {
+   double u1, u2;
+
+   u1 = ((DeviceSimPLRand(SimPL_ptr) >> 11) + 1.0)/9007199254740992.0;
+   u2 = (DeviceSimPLRand(SimPL_ptr) >> 11)/9007199254740992.0;
+   return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Bind the model to 'PUF_instance_name' in the NAT timing database (the pattern MUST match exactly one
+// PUFInstance) and put the registers in the idle state, i.e., READY with no error bits set. DB_NAT is
+// only read and may be shared by several models.
+
+void DeviceSimPLOpen(int max_string_len, DeviceSimPLStruct *SimPL_ptr, sqlite3 *DB_NAT, int design_index,
+   char *ChallengeSetName, char *PUF_instance_name, float noise_sigma, unsigned int noise_seed, int debug_flag)
+   {
+   SQLIntStruct PUF_instance_index_struct;
+
+   memset(SimPL_ptr, 0, sizeof(DeviceSimPLStruct));
+
+   if ( noise_sigma < 0.0 )
+      { printf("ERROR: DeviceSimPLOpen(): Noise sigma %f MUST be >= 0.0!\n", noise_sigma); exit(EXIT_FAILURE); }
+
+   GetPUFInstanceIDsForInstanceName(max_string_len, DB_NAT, &PUF_instance_index_struct, PUF_instance_name);
+   if ( PUF_instance_index_struct.num_ints != 1 )
+      {
+      printf("ERROR: DeviceSimPLOpen(): PUFInstance name '%s' matches %d PUFInstances -- MUST match exactly one!\n",
+         PUF_instance_name, PUF_instance_index_struct.num_ints);
+      exit(EXIT_FAILURE);
+      }
+   SimPL_ptr->PUF_instance_index = PUF_instance_index_struct.int_arr[0];
+   free(PUF_instance_index_struct.int_arr);
+
+   SimPL_ptr->DB_NAT = DB_NAT;
+   SimPL_ptr->design_index = design_index;
+   StringCreateAndCopy(&(SimPL_ptr->ChallengeSetName), ChallengeSetName);
+   StringCreateAndCopy(&(SimPL_ptr->PUF_instance_name), PUF_instance_name);
+
+   SimPL_ptr->noise_sigma = noise_sigma;
+
+// xorshift MUST NOT start from 0.
+   SimPL_ptr->rng_state = 0x9E3779B97F4A7C15ULL ^ (unsigned long long)noise_seed;
+   SimPL_ptr->debug_flag = debug_flag;
+
+   SimPL_ptr->regs[0] = (1 << IN_SM_READY);
+
+   printf("DeviceSimPLOpen(): Simulating PUFInstance '%s' (ID %d)\tNoise sigma %.4f\tSeed %u\n", PUF_instance_name,
+      SimPL_ptr->PUF_instance_index, noise_sigma, noise_seed); fflush(stdout);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Free the model's storage. The NAT database belongs to the caller.
+
+void DeviceSimPLClose(DeviceSimPLStruct *SimPL_ptr)
+   {
+   if ( SimPL_ptr->ChallengeSetName != NULL )
+      free(SimPL_ptr->ChallengeSetName);
+   if ( SimPL_ptr->PUF_instance_name != NULL )
+      free(SimPL_ptr->PUF_instance_name);
+   if ( SimPL_ptr->vec_words != NULL )
+      free(SimPL_ptr->vec_words);
+   SimPL_ptr->ChallengeSetName = NULL;
+   SimPL_ptr->PUF_instance_name = NULL;
+   SimPL_ptr->vec_words = NULL;
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// The registers are the first field of the model, so the register pointer the device code carries around
+// is also the model.
+
+DeviceSimPLStruct *DeviceSimPLFromRegs(volatile unsigned int *DataRegA)
+   {
+   return (DeviceSimPLStruct *)DataRegA;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Microseconds since 't0'. The model's compute time is kept in PL_usecs.
+
+static long DeviceSimPLElapsed(struct timeval *t0)
+   {
+   struct timeval t1;
+
+   gettimeofday(&t1, 0); 
+   return (t1.tv_sec - t0->tv_sec)*1000000 + t1.tv_usec - t0->tv_usec;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Take the engine out of idle (IN_SM_READY low) for 'ready_latency_us'.
+
+static void DeviceSimPLBusy(DeviceSimPLStruct *SimPL_ptr)
+   {
+   SimPL_ptr->regs[0] &= ~(1 << IN_SM_READY);
+   gettimeofday(&(SimPL_ptr->busy_tv), 0);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Arm the word-level BRAM port for one block transfer through the GPIO handshake or the mailbox 'window'
+// (DEVICE_SIM_PORT_*), as the engine does when it is ready for a block. For unloads, 'data' holds the
+// 'num_words' words the device reads. Loaded words end up in 'port_data' with their number in 'port_index'.
+
+void DeviceSimPLArmPort(DeviceSimPLStruct *SimPL_ptr, int port_mode, unsigned short *data, int num_words)
+   {
+   int word_num;
+
+   if ( num_words < 0 || num_words > DEVICE_SIM_PORT_WORDS )
+      { printf("ERROR: DeviceSimPLArmPort(): Number of words %d MUST be between 0 and %d!\n", num_words, DEVICE_SIM_PORT_WORDS); exit(EXIT_FAILURE); }
+
+   SimPL_ptr->port_mode = port_mode;
+   SimPL_ptr->port_index = 0;
+   SimPL_ptr->port_num_words = 0;
+   if ( port_mode == DEVICE_SIM_PORT_GPIO_UNLOAD )
+      {
+      memcpy(SimPL_ptr->port_data, data, num_words*sizeof(unsigned short));
+      SimPL_ptr->port_num_words = num_words;
+      SimPL_ptr->regs[0] = (SimPL_ptr->regs[0] & 0xFFFF0000) | SimPL_ptr->port_data[0];
+      }
+   else if ( port_mode == DEVICE_SIM_PORT_MAILBOX_UNLOAD )
+      {
+      for ( word_num = 0; word_num < num_words; word_num++ )
+         SimPL_ptr->window[word_num] = data[word_num];
+      SimPL_ptr->port_num_words = num_words;
+      }
+
+// 'stopped': ready for the first word or the block.
+   SimPL_ptr->regs[0] |= (1 << IN_SM_HANDSHAKE);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// One step of the BRAM port. GPIO: a word is taken (load) or given (unload) when the device asserts
+// 'continue' while 'stopped' is high, and 'stopped' is raised again for the next word once 'continue' is
+// low. Mailbox: the block is taken when the device asserts 'continue', with the number of words in the low
+// 16 bits of CtrlRegA.
+
+static void DeviceSimPLStepPort(DeviceSimPLStruct *SimPL_ptr, unsigned int ctrl_val)
+   {
+   int stopped, num_words, word_num;
+
+   stopped = (SimPL_ptr->regs[0] & (1 << IN_SM_HANDSHAKE)) != 0;
+   if ( SimPL_ptr->port_mode == DEVICE_SIM_PORT_GPIO_LOAD || SimPL_ptr->port_mode == DEVICE_SIM_PORT_GPIO_UNLOAD )
+      {
+      if ( stopped == 1 && (ctrl_val & (1 << OUT_CP_HANDSHAKE)) != 0 )
+         {
+         if ( SimPL_ptr->port_mode == DEVICE_SIM_PORT_GPIO_LOAD && SimPL_ptr->port_index < DEVICE_SIM_PORT_WORDS )
+            SimPL_ptr->port_data[SimPL_ptr->port_index] = (unsigned short)(0x0000FFFF & ctrl_val);
+         SimPL_ptr->port_index++;
+         SimPL_ptr->regs[0] &= ~(1 << IN_SM_HANDSHAKE);
+         }
+      else if ( stopped == 0 && (ctrl_val & (1 << OUT_CP_HANDSHAKE)) == 0 )
+         {
+         if ( (ctrl_val & (1 << OUT_CP_LM_ULM_DONE)) != 0 ||
+            (SimPL_ptr->port_mode == DEVICE_SIM_PORT_GPIO_UNLOAD && SimPL_ptr->port_index >= SimPL_ptr->port_num_words) )
+            SimPL_ptr->port_mode = DEVICE_SIM_PORT_IDLE;
+         else
+            {
+            if ( SimPL_ptr->port_mode == DEVICE_SIM_PORT_GPIO_UNLOAD )
+               SimPL_ptr->regs[0] = (SimPL_ptr->regs[0] & 0xFFFF0000) | SimPL_ptr->port_data[SimPL_ptr->port_index];
+            SimPL_ptr->regs[0] |= (1 << IN_SM_HANDSHAKE);
+            }
+         }
+      }
+   else if ( stopped == 1 && (ctrl_val & (1 << OUT_CP_HANDSHAKE)) != 0 )
+      {
+      num_words = 0x0000FFFF & ctrl_val;
+      if ( num_words > DEVICE_SIM_PORT_WORDS )
+         num_words = DEVICE_SIM_PORT_WORDS;
+      if ( SimPL_ptr->port_mode == DEVICE_SIM_PORT_MAILBOX_LOAD )
+         for ( word_num = 0; word_num < num_words; word_num++ )
+            SimPL_ptr->port_data[word_num] = (unsigned short)(0x0000FFFF & SimPL_ptr->window[word_num]);
+      SimPL_ptr->port_index = num_words;
+      SimPL_ptr->port_mode = DEVICE_SIM_PORT_IDLE;
+      SimPL_ptr->regs[0] &= ~(1 << IN_SM_HANDSHAKE);
+      }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Arm the vector interface of the CollectPNs engine for 'num_vecs' challenges (plus masks when 'has_masks' is
+// 1) of 16-bit chunks, as the engine does once it is started: IN_SM_DONE_ALL_VECS goes low and the first
+// vector is requested.
+
+void DeviceSimPLArmVecs(DeviceSimPLStruct *SimPL_ptr, int num_vecs, int num_PIs, int num_POs, int has_masks)
+   {
+   SimPL_ptr->vec_words_per_vec = (2*num_PIs)/16;
+   if ( has_masks == 1 )
+      SimPL_ptr->vec_words_per_vec += num_POs/16;
+
+   if ( SimPL_ptr->vec_words != NULL )
+      free(SimPL_ptr->vec_words);
+   if ( (SimPL_ptr->vec_words = (unsigned short *)malloc(sizeof(unsigned short) * (num_vecs * SimPL_ptr->vec_words_per_vec + 1))) == NULL )
+      { printf("ERROR: DeviceSimPLArmVecs(): Failed to allocate storage for the vectors!\n"); exit(EXIT_FAILURE); }
+
+   SimPL_ptr->vec_num_vecs = num_vecs;
+   SimPL_ptr->vec_num = 0;
+   SimPL_ptr->vec_word_num = 0;
+   SimPL_ptr->vec_state = DEVICE_SIM_VEC_LOAD;
+   SimPL_ptr->regs[0] &= ~((1 << IN_SM_DONE_ALL_VECS) | (1 << IN_SM_DTO_DONE_READING));
+   SimPL_ptr->regs[0] |= (1 << IN_SM_LOAD_VEC_PAIR);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// One step of the vector interface. OUT_CP_DTO_RESTART rewinds the current vector. A chunk is latched on
+// 'data_ready' and acknowledged with 'done_reading', which drops with 'data_ready'. The last chunk ends the
+// request (the OUT_CP_DTO_VEC_LOADED pulse is written and cleared between two polls) and the vector is
+// measured for 'vec_latency_us' before the next request, or IN_SM_DONE_ALL_VECS after the last vector.
+
+static void DeviceSimPLStepVecs(DeviceSimPLStruct *SimPL_ptr, unsigned int ctrl_val)
+   {
+   int done_reading;
+
+   done_reading = (SimPL_ptr->regs[0] & (1 << IN_SM_DTO_DONE_READING)) != 0;
+   if ( SimPL_ptr->vec_state == DEVICE_SIM_VEC_LOAD )
+      {
+      if ( (ctrl_val & (1 << OUT_CP_DTO_RESTART)) != 0 )
+         SimPL_ptr->vec_word_num = 0;
+      else if ( done_reading == 0 && (ctrl_val & (1 << OUT_CP_DTO_DATA_READY)) != 0 )
+         {
+         if ( SimPL_ptr->vec_word_num == SimPL_ptr->vec_words_per_vec )
+            { printf("ERROR: DeviceSimPLStepVecs(): Vector %d has more than %d chunks!\n", SimPL_ptr->vec_num, SimPL_ptr->vec_words_per_vec); exit(EXIT_FAILURE); }
+         SimPL_ptr->vec_words[SimPL_ptr->vec_num*SimPL_ptr->vec_words_per_vec + SimPL_ptr->vec_word_num] = (unsigned short)(0x0000FFFF & ctrl_val);
+         SimPL_ptr->vec_word_num++;
+         SimPL_ptr->regs[0] |= (1 << IN_SM_DTO_DONE_READING);
+         }
+      else if ( done_reading == 1 && (ctrl_val & (1 << OUT_CP_DTO_DATA_READY)) == 0 )
+         {
+         SimPL_ptr->regs[0] &= ~(1 << IN_SM_DTO_DONE_READING);
+         if ( SimPL_ptr->vec_word_num == SimPL_ptr->vec_words_per_vec )
+            {
+            SimPL_ptr->regs[0] &= ~(1 << IN_SM_LOAD_VEC_PAIR);
+            SimPL_ptr->vec_num++;
+            SimPL_ptr->vec_state = DEVICE_SIM_VEC_MEASURE;
+            gettimeofday(&(SimPL_ptr->vec_tv), 0);
+            }
+         }
+      }
+   else if ( DeviceSimPLElapsed(&(SimPL_ptr->vec_tv)) >= SimPL_ptr->vec_latency_us )
+      {
+      if ( SimPL_ptr->vec_num == SimPL_ptr->vec_num_vecs )
+         {
+         SimPL_ptr->regs[0] |= (1 << IN_SM_DONE_ALL_VECS);
+         SimPL_ptr->vec_state = DEVICE_SIM_VEC_IDLE;
+         }
+      else
+         {
+         SimPL_ptr->vec_word_num = 0;
+         SimPL_ptr->regs[0] |= (1 << IN_SM_LOAD_VEC_PAIR);
+         SimPL_ptr->vec_state = DEVICE_SIM_VEC_LOAD;
+         }
+      }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// The vectors and masks received through the vector interface, split back into the first and second vector
+// of each challenge. The masks are only allocated when 'has_masks' is 1. Free with FreeVectorsAndMasks().
+
+void DeviceSimPLGetVecs(DeviceSimPLStruct *SimPL_ptr, int num_PIs, int num_POs, int has_masks, unsigned char ***first_vecs_b_ptr,
+   unsigned char ***second_vecs_b_ptr, unsigned char ***masks_b_ptr)
+   {
+   int num_vec_bytes = num_PIs/8;
+   int vec_num, byte_num;
+   unsigned short *words;
+   unsigned char byte;
+
+   if ( SimPL_ptr->vec_state != DEVICE_SIM_VEC_IDLE || SimPL_ptr->vec_num != SimPL_ptr->vec_num_vecs )
+      { printf("ERROR: DeviceSimPLGetVecs(): Received %d of %d vectors!\n", SimPL_ptr->vec_num, SimPL_ptr->vec_num_vecs); exit(EXIT_FAILURE); }
+
+   if ( (*first_vecs_b_ptr = (unsigned char **)malloc(sizeof(unsigned char *) * SimPL_ptr->vec_num_vecs)) == NULL ||
+      (*second_vecs_b_ptr = (unsigned char **)malloc(sizeof(unsigned char *) * SimPL_ptr->vec_num_vecs)) == NULL ||
+      (has_masks == 1 && (*masks_b_ptr = (unsigned char **)malloc(sizeof(unsigned char *) * SimPL_ptr->vec_num_vecs)) == NULL) )
+      { printf("ERROR: DeviceSimPLGetVecs(): Failed to allocate storage for the vectors!\n"); exit(EXIT_FAILURE); }
+   if ( has_masks == 0 )
+      *masks_b_ptr = NULL;
+
+   for ( vec_num = 0; vec_num < SimPL_ptr->vec_num_vecs; vec_num++ )
+      {
+      if ( ((*first_vecs_b_ptr)[vec_num] = (unsigned char *)malloc(num_vec_bytes)) == NULL ||
+         ((*second_vecs_b_ptr)[vec_num] = (unsigned char *)malloc(num_vec_bytes)) == NULL ||
+         (has_masks == 1 && ((*masks_b_ptr)[vec_num] = (unsigned char *)malloc(num_POs/8)) == NULL) )
+         { printf("ERROR: DeviceSimPLGetVecs(): Failed to allocate storage for vector %d!\n", vec_num); exit(EXIT_FAILURE); }
+
+// Chunks are low-order byte first. The challenge is the first vector followed by the second, then the mask.
+      words = SimPL_ptr->vec_words + vec_num*SimPL_ptr->vec_words_per_vec;
+      for ( byte_num = 0; byte_num < 2*num_vec_bytes + (has_masks == 1 ? num_POs/8 : 0); byte_num++ )
+         {
+         byte = (unsigned char)(words[byte_num/2] >> (8*(byte_num % 2)));
+         if ( byte_num < num_vec_bytes )
+            (*first_vecs_b_ptr)[vec_num][byte_num] = byte;
+         else if ( byte_num < 2*num_vec_bytes )
+            (*second_vecs_b_ptr)[vec_num][byte_num - num_vec_bytes] = byte;
+         else
+            (*masks_b_ptr)[vec_num][byte_num - 2*num_vec_bytes] = byte;
+         }
+      }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Called on every poll of DataRegA by the waits in device_hw_wait.c. A rising edge of OUT_CP_PUF_START takes
+// the engine out of idle, which acknowledges the start pulse, as does a run of the SRF engine. It returns to
+// idle 'ready_latency_us' later, standing in for the time the PL computes. An armed BRAM port or vector
+// interface takes a step.
+
+void DeviceSimPLPoll(DeviceSimPLStruct *SimPL_ptr)
+   {
+   unsigned int ctrl_val;
+
+   ctrl_val = SimPL_ptr->regs[2];
+   if ( SimPL_ptr->port_mode != DEVICE_SIM_PORT_IDLE )
+      DeviceSimPLStepPort(SimPL_ptr, ctrl_val);
+   if ( SimPL_ptr->vec_state != DEVICE_SIM_VEC_IDLE )
+      DeviceSimPLStepVecs(SimPL_ptr, ctrl_val);
+
+   if ( (ctrl_val & (1 << OUT_CP_PUF_START)) != 0 && (SimPL_ptr->last_ctrl & (1 << OUT_CP_PUF_START)) == 0 )
+      DeviceSimPLBusy(SimPL_ptr);
+   else if ( (SimPL_ptr->regs[0] & (1 << IN_SM_READY)) == 0 && DeviceSimPLElapsed(&(SimPL_ptr->busy_tv)) >= SimPL_ptr->ready_latency_us )
+      SimPL_ptr->regs[0] |= (1 << IN_SM_READY);
+   SimPL_ptr->last_ctrl = ctrl_val;
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// CollectPNs. Regenerate the challenge from the seed with the NAT database, check that it is the challenge
+// the device received (or generated from its own Challenges DB), and fetch the enrolled PNR/PNF of the
+// simulated PUFInstance for it. Add the noise, then fill 'device_n1' with the nonce bytes. Returns the
+// number of nonce bytes.
+
+int DeviceSimPLCollectPNs(int max_string_len, DeviceSimPLStruct *SimPL_ptr, unsigned int ChallengeGen_seed, int chlng_rng_mode,
+   int num_vecs, int num_PIs, int num_POs, unsigned char **first_vecs_b, unsigned char **second_vecs_b, unsigned char **masks_b,
+   int max_generated_nonce_bytes, unsigned char *device_n1)
+   {
+   VecPairPOStruct *challenge_vecpair_id_PO_arr = NULL;
+   int num_challenge_vecpair_id_PO = 0;
+   unsigned char **vecs1_b = NULL, **vecs2_b = NULL, **DB_masks_b = NULL;
+   int DB_num_vecs, DB_num_rise_vecs, vec_num, PN_num, num_n1_bytes;
+
+   float PNR[NUM_REQUIRED_PNDIFFS], PNF[NUM_REQUIRED_PNDIFFS];
+   float *PNR_ptr = PNR, *PNF_ptr = PNF;
+   int16_t *PN16;
+   int noisy;
+
+   struct timeval t0;
+   gettimeofday(&t0, 0);
+
+   GenChallengeDB(max_string_len, SimPL_ptr->DB_NAT, SimPL_ptr->design_index, SimPL_ptr->ChallengeSetName, ChallengeGen_seed, 0,
+      NULL, NULL, &vecs1_b, &vecs2_b, &DB_masks_b, &DB_num_vecs, &DB_num_rise_vecs, chlng_rng_mode, &num_challenge_vecpair_id_PO,
+      &challenge_vecpair_id_PO_arr);
+
+// Sanity checks. A mismatch means the device's Challenges DB and the NAT DB do not hold the same challenge set.
+   if ( DB_num_vecs != num_vecs )
+      { printf("ERROR: DeviceSimPLCollectPNs(): Device has %d vectors, NAT DB challenge has %d!\n", num_vecs, DB_num_vecs); exit(EXIT_FAILURE); }
+   for ( vec_num = 0; vec_num < num_vecs; vec_num++ )
+      if ( memcmp(vecs1_b[vec_num], first_vecs_b[vec_num], num_PIs/8) != 0 || memcmp(vecs2_b[vec_num], second_vecs_b[vec_num], num_PIs/8) != 0 ||
+         memcmp(DB_masks_b[vec_num], masks_b[vec_num], num_POs/8) != 0 )
+         { printf("ERROR: DeviceSimPLCollectPNs(): Device vector/mask %d does NOT match the NAT DB challenge!\n", vec_num); exit(EXIT_FAILURE); }
+   if ( num_challenge_vecpair_id_PO != 2*NUM_REQUIRED_PNDIFFS )
+      {
+      printf("ERROR: DeviceSimPLCollectPNs(): Challenge tests %d PNs -- expected %d!\n", num_challenge_vecpair_id_PO, 2*NUM_REQUIRED_PNDIFFS);
+      exit(EXIT_FAILURE);
+      }
+
+   GetPUFInstanceTimingInfoUsingVecPairPOStruct(max_string_len, SimPL_ptr->DB_NAT, SimPL_ptr->PUF_instance_index, 0,
+      challenge_vecpair_id_PO_arr, num_challenge_vecpair_id_PO, 0, &PNR_ptr, &PNF_ptr, NULL, 0, NULL, NULL, 0, 0);
+
+   FreeVectorsAndMasks(&DB_num_vecs, &DB_num_rise_vecs, &vecs1_b, &vecs2_b, &DB_masks_b);
+   free(challenge_vecpair_id_PO_arr);
+
+// The enrolled PNs are multiples of 1/16. Add the noise in the same units.
+   SRFFixedLoadPNs(NUM_REQUIRED_PNDIFFS, PNR, SimPL_ptr->PNR16);
+   SRFFixedLoadPNs(NUM_REQUIRED_PNDIFFS, PNF, SimPL_ptr->PNF16);
+   if ( SimPL_ptr->noise_sigma > 0.0 )
+      for ( PN_num = 0; PN_num < 2*NUM_REQUIRED_PNDIFFS; PN_num++ )
+         {
+         if ( PN_num < NUM_REQUIRED_PNDIFFS )
+            PN16 = &(SimPL_ptr->PNR16[PN_num]);
+         else
+            PN16 = &(SimPL_ptr->PNF16[PN_num - NUM_REQUIRED_PNDIFFS]);
+         noisy = *PN16 + (int)lround(DeviceSimPLGaussian(SimPL_ptr) * SimPL_ptr->noise_sigma * SRF_FIXED_ONE);
+         if ( noisy > INT16_MAX )
+            noisy = INT16_MAX;
+         if ( noisy < INT16_MIN )
+            noisy = INT16_MIN;
+         *PN16 = (int16_t)noisy;
+         }
+
+// The TRNG runs while the PNs are collected. Keep one word short of the end, as the CollectPNs() loop does.
+   num_n1_bytes = DEVICE_SIM_NUM_N1_BYTES;
+   if ( num_n1_bytes > max_generated_nonce_bytes - 2 )
+      num_n1_bytes = max_generated_nonce_bytes - 2;
+   for ( PN_num = 0; PN_num < num_n1_bytes; PN_num++ )
+      device_n1[PN_num] = (unsigned char)(DeviceSimPLRand(SimPL_ptr) >> 56);
+
+// New PNs: the engine waits for a new set of parameters.
+   SimPL_ptr->PNs_collected = 1;
+   SimPL_ptr->num_params_loaded = 0;
+   SimPL_ptr->SRF_done = 0;
+   SimPL_ptr->num_unloads = 0;
+   SimPL_ptr->num_authen_PN_sets++;
+
+   SimPL_ptr->PL_usecs += DeviceSimPLElapsed(&t0);
+   if ( SimPL_ptr->num_authen_PN_sets == 1 )
+      gettimeofday(&(SimPL_ptr->first_PNs_tv), 0);
+
+   if ( SimPL_ptr->debug_flag == 1 )
+      { printf("DeviceSimPLCollectPNs(): Seed %u\tNum vecs %d\tNum nonce bytes %d\n", ChallengeGen_seed, num_vecs, num_n1_bytes); fflush(stdout); }
+
+   return num_n1_bytes;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Run PNDiff, GPEVCal and AddSpreadFactors on the current PNs with the current parameters.
+
+static void DeviceSimPLRunSRF(DeviceSimPLStruct *SimPL_ptr)
+   {
+   int16_t largest_neg_PND16;
+
+   struct timeval t0;
+   gettimeofday(&t0, 0);
+
+   largest_neg_PND16 = SRFFixedPNDiffsTwoSeeds(NUM_REQUIRED_PNDIFFS, SimPL_ptr->PNR16, SimPL_ptr->PNF16, SimPL_ptr->PND16,
+      SimPL_ptr->params[DEVICE_SIM_PARAM_LFSR_SEED_LOW], SimPL_ptr->params[DEVICE_SIM_PARAM_LFSR_SEED_HIGH]);
+   SRFFixedGPEVCal(NUM_REQUIRED_PNDIFFS, SimPL_ptr->PND16, SimPL_ptr->PNDc16, RANGE_LOW_LIMIT, RANGE_HIGH_LIMIT, DIST_RANGE,
+      SimPL_ptr->params[DEVICE_SIM_PARAM_RANGE_CONSTANT], largest_neg_PND16);
+   SRFFixedAddSpreadFactors(NUM_REQUIRED_PNDIFFS, SimPL_ptr->PNDc16, SimPL_ptr->PNDco16, SimPL_ptr->SF16,
+      SimPL_ptr->params[DEVICE_SIM_PARAM_TRIMCODE_CONSTANT]);
+
+   SimPL_ptr->SRF_done = 1;
+   SimPL_ptr->num_unloads = 0;
+   SimPL_ptr->num_SRF_runs++;
+   DeviceSimPLBusy(SimPL_ptr);
+
+   SimPL_ptr->PL_usecs += DeviceSimPLElapsed(&t0);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// One parameter from SelectSetParams(). The engine starts once the last one arrives, unless it must wait for
+// the SpreadFactors. Unsupported modes set IN_PARAM_ERR, which SelectSetParams() checks.
+
+void DeviceSimPLSetParam(DeviceSimPLStruct *SimPL_ptr, int param_num, int val)
+   {
+   if ( param_num == 0 )
+      SimPL_ptr->num_params_loaded = 0;
+
+   if ( param_num != SimPL_ptr->num_params_loaded || param_num >= DEVICE_SIM_NUM_PARAMS )
+      { printf("ERROR: DeviceSimPLSetParam(): Parameter %d out of order -- expected %d!\n", param_num, SimPL_ptr->num_params_loaded); exit(EXIT_FAILURE); }
+
+   SimPL_ptr->params[param_num] = (unsigned short)(0x0000FFFF & val);
+   SimPL_ptr->num_params_loaded++;
+   SimPL_ptr->SRF_done = 0;
+
+   if ( SimPL_ptr->num_params_loaded < DEVICE_SIM_NUM_PARAMS )
+      return;
+
+// The model runs PopOnly SpreadFactors without scaling only, which is what KEK_DeviceAuthentication_SKE() uses.
+   if ( SimPL_ptr->PNs_collected == 0 || SimPL_ptr->params[DEVICE_SIM_PARAM_COMPUTE_PCR_PBD] != 0 ||
+      SimPL_ptr->params[DEVICE_SIM_PARAM_MODIFY_SF] != 0 || SimPL_ptr->params[DEVICE_SIM_PARAM_RANGE_CONSTANT] == 0 ||
+      SimPL_ptr->params[DEVICE_SIM_PARAM_SCALING_CONSTANT] != (1 << SCALING_PRECISION_NB) || (SimPL_ptr->params[DEVICE_SIM_PARAM_XMR] % 2) == 0 )
+      {
+      printf("ERROR: DeviceSimPLSetParam(): PNs collected %d\tCompute PCR/PBD %d\tModify SF %d\tRC %d\tScaling %d\tXMR %d -- NOT modelled!\n",
+         SimPL_ptr->PNs_collected, SimPL_ptr->params[DEVICE_SIM_PARAM_COMPUTE_PCR_PBD], SimPL_ptr->params[DEVICE_SIM_PARAM_MODIFY_SF],
+         SimPL_ptr->params[DEVICE_SIM_PARAM_RANGE_CONSTANT], SimPL_ptr->params[DEVICE_SIM_PARAM_SCALING_CONSTANT],
+         SimPL_ptr->params[DEVICE_SIM_PARAM_XMR]); fflush(stdout);
+      SimPL_ptr->regs[0] |= (1 << IN_PARAM_ERR);
+      return;
+      }
+
+   if ( SimPL_ptr->params[DEVICE_SIM_PARAM_LOAD_SF] == 0 )
+      {
+      memset(SimPL_ptr->SF16, 0, sizeof(SimPL_ptr->SF16));
+      DeviceSimPLRunSRF(SimPL_ptr);
+      }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// KEK SKE enrollment of the authentication nonce: SingleHelpBitGen with the Threshold, then encode as many
+// nonce bits as the strong bits allow with XMR redundancy.
+
+static void DeviceSimPLKEKEnroll(DeviceSimPLStruct *SimPL_ptr)
+   {
+   int num_nonce_bits;
+
+   struct timeval t0;
+   gettimeofday(&t0, 0);
+
+   memset(SimPL_ptr->SBG_SBS, 0, sizeof(SimPL_ptr->SBG_SBS));
+   SimPL_ptr->num_SBG_SBS_bits = SRFFixedHelpBitGen(NUM_REQUIRED_PNDIFFS, SimPL_ptr->PNDco16, SimPL_ptr->SBG_SBS, SimPL_ptr->SBG_SHD,
+      SimPL_ptr->params[DEVICE_SIM_PARAM_THRESHOLD]);
+
+   num_nonce_bits = SimPL_ptr->params[DEVICE_SIM_PARAM_NONCE_BITS_REMAINING];
+   if ( num_nonce_bits > KEK_AUTHEN_NUM_NONCE_BITS )
+      num_nonce_bits = KEK_AUTHEN_NUM_NONCE_BITS;
+
+// KEK_FSB_SKE() re-writes the encoded nonce bits into XMR_SBS.
+   memcpy(SimPL_ptr->XMR_SBS, SimPL_ptr->nonce, sizeof(SimPL_ptr->nonce));
+   SimPL_ptr->num_encoded_bits = KEK_FSB_SKE(NUM_REQUIRED_PNDIFFS, SimPL_ptr->params[DEVICE_SIM_PARAM_XMR], SimPL_ptr->SBG_SHD,
+      SimPL_ptr->SBG_SBS, SimPL_ptr->XMR_SHD, num_nonce_bits, SimPL_ptr->XMR_SBS, 0, 0, NULL, 0, NULL, NULL, 1, -1, -1, NULL);
+
+   if ( SimPL_ptr->debug_flag == 1 )
+      {
+      printf("DeviceSimPLKEKEnroll(): Strong bits %d\tNonce bits remaining %d\tEncoded %d\n", SimPL_ptr->num_SBG_SBS_bits,
+         num_nonce_bits, SimPL_ptr->num_encoded_bits); fflush(stdout);
+      }
+
+   SimPL_ptr->PL_usecs += DeviceSimPLElapsed(&t0);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// LoadUnloadBRAM(). Word loads are the SpreadFactors (which start the engine), word unloads the updated
+// SpreadFactors (unchanged in PopOnly mode), byte loads the authentication nonce (which starts KEK SKE
+// enrollment) and byte unloads SBG SHD, SBG SBS, XMR SHD and XMR SBS in that order. The SBS unloads leave the
+// bit count in the low 16 bits of DataRegA, where FetchTransSHD_SBS() reads it.
+
+void DeviceSimPLTransferBRAM(DeviceSimPLStruct *SimPL_ptr, int num_vals, unsigned char *ByteData, signed short *WordData,
+   int load_or_unload, int byte_or_word_data)
+   {
+   unsigned char *src;
+   int num_bits;
+
+   if ( SimPL_ptr->num_params_loaded != DEVICE_SIM_NUM_PARAMS )
+      { printf("ERROR: DeviceSimPLTransferBRAM(): BRAM transfer before the parameters were loaded!\n"); exit(EXIT_FAILURE); }
+
+// SpreadFactors
+   if ( byte_or_word_data == 1 )
+      {
+      if ( num_vals != NUM_REQUIRED_PNDIFFS )
+         { printf("ERROR: DeviceSimPLTransferBRAM(): Expected %d SpreadFactors -- got %d!\n", NUM_REQUIRED_PNDIFFS, num_vals); exit(EXIT_FAILURE); }
+      if ( load_or_unload == 0 )
+         {
+         memcpy(SimPL_ptr->SF16, WordData, sizeof(SimPL_ptr->SF16));
+         DeviceSimPLRunSRF(SimPL_ptr);
+         }
+      else
+         memcpy(WordData, SimPL_ptr->SF16, sizeof(SimPL_ptr->SF16));
+      return;
+      }
+
+   if ( SimPL_ptr->SRF_done == 0 )
+      { printf("ERROR: DeviceSimPLTransferBRAM(): Byte transfer before the SRF engine ran!\n"); exit(EXIT_FAILURE); }
+
+// Authentication nonce
+   if ( load_or_unload == 0 )
+      {
+      if ( num_vals > (int)sizeof(SimPL_ptr->nonce) )
+         { printf("ERROR: DeviceSimPLTransferBRAM(): Nonce of %d bytes larger than %d!\n", num_vals, (int)sizeof(SimPL_ptr->nonce)); exit(EXIT_FAILURE); }
+      memset(SimPL_ptr->nonce, 0, sizeof(SimPL_ptr->nonce));
+      memcpy(SimPL_ptr->nonce, ByteData, num_vals);
+      DeviceSimPLKEKEnroll(SimPL_ptr);
+      SimPL_ptr->num_unloads = 0;
+      return;
+      }
+
+// Helper data and strong bitstrings
+   if ( num_vals > NUM_REQUIRED_PNDIFFS/8 )
+      { printf("ERROR: DeviceSimPLTransferBRAM(): Unload of %d bytes larger than %d!\n", num_vals, NUM_REQUIRED_PNDIFFS/8); exit(EXIT_FAILURE); }
+
+   num_bits = -1;
+   if ( SimPL_ptr->num_unloads == 0 )
+      src = SimPL_ptr->SBG_SHD;
+   else if ( SimPL_ptr->num_unloads == 1 )
+      { src = SimPL_ptr->SBG_SBS; num_bits = SimPL_ptr->num_SBG_SBS_bits; }
+   else if ( SimPL_ptr->num_unloads == 2 )
+      src = SimPL_ptr->XMR_SHD;
+   else if ( SimPL_ptr->num_unloads == 3 )
+      { src = SimPL_ptr->XMR_SBS; num_bits = SimPL_ptr->num_encoded_bits; }
+   else
+      { printf("ERROR: DeviceSimPLTransferBRAM(): Unload %d -- only SBG SHD/SBS and XMR SHD/SBS are modelled!\n", SimPL_ptr->num_unloads); exit(EXIT_FAILURE); }
+
+   memcpy(ByteData, src, num_vals);
+   SimPL_ptr->num_unloads++;
+
+   if ( num_bits >= 0 )
+      SimPL_ptr->regs[0] = (SimPL_ptr->regs[0] & 0xFFFF0000) | (0x0000FFFF & num_bits);
+
+   return;
+   }
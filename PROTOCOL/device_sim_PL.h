@@ -0,0 +1,66 @@
+// ========================================================================================================
+// ========================================================================================================
+// ******************************************* device_sim_PL.h ********************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+
+#ifndef DEVICE_SIM_PL_INCLUDED
+
+// Number of nonce bytes the model's TRNG produces while the PNs are 'collected'. The hardware count varies from run
+// to run but is always well above NUM_XOR_NONCE_BYTES.
+#define DEVICE_SIM_NUM_N1_BYTES 32
+
+// Order of the parameters transferred by SelectSetParams().
+#define DEVICE_SIM_PARAM_LFSR_SEED_LOW 0
+#define DEVICE_SIM_PARAM_LFSR_SEED_HIGH 1
+#define DEVICE_SIM_PARAM_RANGE_CONSTANT 2
+#define DEVICE_SIM_PARAM_SPREAD_CONSTANT 3
+#define DEVICE_SIM_PARAM_THRESHOLD 4
+#define DEVICE_SIM_PARAM_XMR 5
+#define DEVICE_SIM_PARAM_NONCE_BITS_REMAINING 6
+#define DEVICE_SIM_PARAM_PCR_PBD_PO 7
+#define DEVICE_SIM_PARAM_LOAD_SF 8
+#define DEVICE_SIM_PARAM_COMPUTE_PCR_PBD 9
+#define DEVICE_SIM_PARAM_MODIFY_SF 10
+#define DEVICE_SIM_PARAM_DUMP_UPDATED_SF 11
+#define DEVICE_SIM_PARAM_TRIMCODE_CONSTANT 12
+#define DEVICE_SIM_PARAM_SCALING_CONSTANT 13
+
+// Modes of the word-level BRAM port (DeviceSimPLArmPort).
+#define DEVICE_SIM_PORT_IDLE 0
+#define DEVICE_SIM_PORT_GPIO_LOAD 1
+#define DEVICE_SIM_PORT_GPIO_UNLOAD 2
+#define DEVICE_SIM_PORT_MAILBOX_LOAD 3
+#define DEVICE_SIM_PORT_MAILBOX_UNLOAD 4
+
+// States of the vector interface of the CollectPNs engine (DeviceSimPLArmVecs).
+#define DEVICE_SIM_VEC_IDLE 0
+#define DEVICE_SIM_VEC_LOAD 1
+#define DEVICE_SIM_VEC_MEASURE 2
+
+#define DEVICE_SIM_PL_INCLUDED
+#endif
+
+void DeviceSimPLOpen(int max_string_len, DeviceSimPLStruct *SimPL_ptr, sqlite3 *DB_NAT, int design_index,
+   char *ChallengeSetName, char *PUF_instance_name, float noise_sigma, unsigned int noise_seed, int debug_flag);
+void DeviceSimPLClose(DeviceSimPLStruct *SimPL_ptr);
+DeviceSimPLStruct *DeviceSimPLFromRegs(volatile unsigned int *DataRegA);
+void DeviceSimPLPoll(DeviceSimPLStruct *SimPL_ptr);
+void DeviceSimPLArmPort(DeviceSimPLStruct *SimPL_ptr, int port_mode, unsigned short *data, int num_words);
+void DeviceSimPLArmVecs(DeviceSimPLStruct *SimPL_ptr, int num_vecs, int num_PIs, int num_POs, int has_masks);
+void DeviceSimPLGetVecs(DeviceSimPLStruct *SimPL_ptr, int num_PIs, int num_POs, int has_masks, unsigned char ***first_vecs_b_ptr,
+   unsigned char ***second_vecs_b_ptr, unsigned char ***masks_b_ptr);
+
+int DeviceSimPLCollectPNs(int max_string_len, DeviceSimPLStruct *SimPL_ptr, unsigned int ChallengeGen_seed, int chlng_rng_mode,
+   int num_vecs, int num_PIs, int num_POs, unsigned char **first_vecs_b, unsigned char **second_vecs_b, unsigned char **masks_b,
+   int max_generated_nonce_bytes, unsigned char *device_n1);
+void DeviceSimPLSetParam(DeviceSimPLStruct *SimPL_ptr, int param_num, int val);
+void DeviceSimPLTransferBRAM(DeviceSimPLStruct *SimPL_ptr, int num_vals, unsigned char *ByteData, signed short *WordData,
+   int load_or_unload, int byte_or_word_data);
@@ -0,0 +1,395 @@
+// ========================================================================================================
+// ========================================================================================================
+// ******************************************* rt_writer_test.c *******************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+//
+// Test of the background RunTime DB writer (RTBitstringWriterStruct, commonDB_RT.c) against a temporary RunTime.db
+// with the Bitstrings table. Rows are counted on a separate reader connection, as the analysis programs do.
+//
+//    Flush: several producer threads queue more records than RT_WRITER_QUEUE_SIZE. After RTBitstringWriterFlush()
+//    every row MUST be visible, exactly once and with its bitstring intact.
+//    Commit interval: fewer than batch_size records MUST NOT be visible right after they are queued and MUST be
+//    visible after commit_interval_ms, without a flush, in one transaction.
+//    Shutdown: records queued before RTBitstringWriterShutdown() MUST all be committed by it. Records queued after
+//    'stop' is set (the first step of the shutdown, done here by hand so the late adds land between it and the
+//    join) MUST be counted in num_rejected and freed, not inserted. The program is linked with free() wrapped to
+//    see the rejected records and their bitstrings freed.
+//
+// Usage: rt_writer_test [num_records_per_producer]
+
+#include "common.h"
+#include "verifier_common.h"
+#include "commonDB.h"
+#include "commonDB_RT.h"
+
+extern int usleep (__useconds_t __useconds);
+
+#define TEST_NUM_PRODUCERS 4
+#define TEST_BATCH_SIZE 64
+#define TEST_MAX_BITS 256
+#define TEST_NUM_REJECTED 10
+
+#define SQL_BSTRINGS_CREATE_CMD "CREATE TABLE Bitstrings (id INTEGER PRIMARY KEY, DesignIndex INTEGER, NetlistName TEXT, \
+SynthesisName TEXT, InstanceName TEXT, Dev TEXT, Placement TEXT, PUFInstanceID INTEGER, ChallengeSetName TEXT, CreationDate TEXT, \
+SecurityFunction TEXT, FixParams TEXT, LFSRSeedLow INTEGER, LFSRSeedHigh INTEGER, RangeConstant INTEGER, SpreadConstant INTEGER, \
+Threshold INTEGER, Bitstring TEXT)"
+
+typedef struct
+   {
+   RTBitstringWriterStruct *RTW_ptr;
+   int producer_num;
+   int num_records;
+   } ProducerStruct;
+
+void __real_free(void *ptr);
+
+// Pointers whose free() is being watched for, and how many of them have been freed.
+static pthread_mutex_t Watch_mutex = PTHREAD_MUTEX_INITIALIZER;
+static void *Watched_ptrs[2*TEST_NUM_REJECTED];
+static int Num_watched = 0;
+static int Num_watched_freed = 0;
+
+
+// ========================================================================================================
+// ========================================================================================================
+// free() wrapper. Counts the frees of the watched pointers. Called from the writer thread as well.
+
+void __wrap_free(void *ptr)
+   {
+   int watch_num;
+
+   if ( ptr != NULL )
+      {
+      pthread_mutex_lock(&Watch_mutex);
+      for ( watch_num = 0; watch_num < Num_watched; watch_num++ )
+         if ( Watched_ptrs[watch_num] == ptr )
+            {
+            Watched_ptrs[watch_num] = NULL;
+            Num_watched_freed++;
+            }
+      pthread_mutex_unlock(&Watch_mutex);
+      }
+   __real_free(ptr);
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// xorshift64 step.
+
+static unsigned int TestRand(unsigned long long *state_ptr)
+   {
+   *state_ptr ^= *state_ptr >> 12;
+   *state_ptr ^= *state_ptr << 25;
+   *state_ptr ^= *state_ptr >> 27;
+   return (unsigned int)((*state_ptr * 0x2545F4914F6CDD1DULL) >> 32);
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// The ASCII bitstring of record 'record_num' of producer 'producer_num', between 1 and TEST_MAX_BITS characters.
+
+static void MakeBitstring(int producer_num, int record_num, char *bitstring)
+   {
+   unsigned long long state;
+   int num_bits, bit_num;
+
+   state = 0x9E3779B97F4A7C15ULL ^ ((unsigned long long)(producer_num + 1) << 32) ^ (unsigned long long)(record_num + 1);
+   num_bits = 1 + (int)(TestRand(&state) % TEST_MAX_BITS);
+   for ( bit_num = 0; bit_num < num_bits; bit_num++ )
+      bitstring[bit_num] = '0' + (TestRand(&state) & 1);
+   bitstring[num_bits] = '\0';
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// An allocated record, as BuildDBBitstringRecord() makes it. The producer and record numbers are stored in
+// DesignIndex and PUFInstanceID.
+
+static RTBitstringRecordStruct *MakeRecord(int producer_num, int record_num)
+   {
+   RTBitstringRecordStruct *record_ptr;
+   char bitstring[TEST_MAX_BITS + 1];
+
+   if ( (record_ptr = (RTBitstringRecordStruct *)calloc(1, sizeof(RTBitstringRecordStruct))) == NULL )
+      { printf("ERROR: MakeRecord(): Failed to allocate storage for record!\n"); exit(EXIT_FAILURE); }
+   MakeBitstring(producer_num, record_num, bitstring);
+   if ( (record_ptr->Bitstring = (char *)malloc(strlen(bitstring) + 1)) == NULL )
+      { printf("ERROR: MakeRecord(): Failed to allocate storage for Bitstring!\n"); exit(EXIT_FAILURE); }
+   strcpy(record_ptr->Bitstring, bitstring);
+
+   record_ptr->design_index = producer_num;
+   record_ptr->PUFInstance_ID = record_num;
+   strcpy(record_ptr->Netlist_name, "rt_writer_test");
+   strcpy(record_ptr->InstanceName, "C0");
+   strcpy(record_ptr->SecurityFunction, "DA");
+   strcpy(record_ptr->FixParams, "N");
+
+   return record_ptr;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Producer thread. Queues its records in order.
+
+static void *ProducerThread(void *arg)
+   {
+   ProducerStruct *PS_ptr = (ProducerStruct *)arg;
+   int record_num;
+
+   for ( record_num = 0; record_num < PS_ptr->num_records; record_num++ )
+      RTBitstringWriterEnqueue(PS_ptr->RTW_ptr, MakeRecord(PS_ptr->producer_num, record_num));
+
+   return NULL;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Number of rows visible to the reader connection.
+
+static int CountRows(sqlite3 *db)
+   {
+   sqlite3_stmt *pStmt;
+   int num_rows;
+
+   if ( sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM Bitstrings", -1, &pStmt, NULL) != SQLITE_OK )
+      { printf("ERROR: CountRows(): %s\n", sqlite3_errmsg(db)); exit(EXIT_FAILURE); }
+   if ( sqlite3_step(pStmt) != SQLITE_ROW )
+      { printf("ERROR: CountRows(): %s\n", sqlite3_errmsg(db)); exit(EXIT_FAILURE); }
+   num_rows = sqlite3_column_int(pStmt, 0);
+   sqlite3_finalize(pStmt);
+
+   return num_rows;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Check that the rows of 'producer_num' are exactly records 0 to num_records - 1, once each and with their
+// bitstrings. Returns the number of errors.
+
+static int CheckRows(sqlite3 *db, int producer_num, int num_records)
+   {
+   char expected[TEST_MAX_BITS + 1];
+   sqlite3_stmt *pStmt;
+   int record_num, num_seen, num_errors;
+   char *seen;
+
+   if ( (seen = (char *)calloc(num_records, sizeof(char))) == NULL )
+      { printf("ERROR: CheckRows(): Failed to allocate storage for seen!\n"); exit(EXIT_FAILURE); }
+   if ( sqlite3_prepare_v2(db, "SELECT PUFInstanceID, Bitstring FROM Bitstrings WHERE DesignIndex = ?", -1, &pStmt, NULL) != SQLITE_OK )
+      { printf("ERROR: CheckRows(): %s\n", sqlite3_errmsg(db)); exit(EXIT_FAILURE); }
+   sqlite3_bind_int(pStmt, 1, producer_num);
+
+   num_errors = 0;
+   num_seen = 0;
+   while ( sqlite3_step(pStmt) == SQLITE_ROW )
+      {
+      record_num = sqlite3_column_int(pStmt, 0);
+      if ( record_num < 0 || record_num >= num_records || seen[record_num] == 1 )
+         { printf("\tProducer %d: unexpected or duplicate record %d!\n", producer_num, record_num); num_errors++; continue; }
+      seen[record_num] = 1;
+      num_seen++;
+      MakeBitstring(producer_num, record_num, expected);
+      if ( strcmp((char *)sqlite3_column_text(pStmt, 1), expected) != 0 )
+         { printf("\tProducer %d: bitstring of record %d differs!\n", producer_num, record_num); num_errors++; }
+      }
+   sqlite3_finalize(pStmt);
+   free(seen);
+
+   if ( num_seen != num_records )
+      { printf("\tProducer %d: %d of %d records in the table!\n", producer_num, num_seen, num_records); num_errors++; }
+
+   return num_errors;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Flush check. Returns the number of errors.
+
+static int CheckFlush(char *DB_name, sqlite3 *db, int num_records)
+   {
+   RTBitstringWriterStruct RTW;
+   ProducerStruct PS[TEST_NUM_PRODUCERS];
+   pthread_t threads[TEST_NUM_PRODUCERS];
+   int producer_num, num_rows, num_errors;
+
+   num_errors = 0;
+   RTBitstringWriterInit(&RTW, DB_name, TEST_BATCH_SIZE, 5);
+   for ( producer_num = 0; producer_num < TEST_NUM_PRODUCERS; producer_num++ )
+      {
+      PS[producer_num].RTW_ptr = &RTW;
+      PS[producer_num].producer_num = producer_num;
+      PS[producer_num].num_records = num_records;
+      if ( pthread_create(&(threads[producer_num]), NULL, ProducerThread, (void *)&(PS[producer_num])) != 0 )
+         { printf("ERROR: CheckFlush(): Failed to create producer %d!\n", producer_num); exit(EXIT_FAILURE); }
+      }
+   for ( producer_num = 0; producer_num < TEST_NUM_PRODUCERS; producer_num++ )
+      pthread_join(threads[producer_num], NULL);
+
+   RTBitstringWriterFlush(&RTW);
+   if ( (num_rows = CountRows(db)) != TEST_NUM_PRODUCERS * num_records )
+      { printf("\t%d rows after the flush, expected %d!\n", num_rows, TEST_NUM_PRODUCERS * num_records); num_errors++; }
+   for ( producer_num = 0; producer_num < TEST_NUM_PRODUCERS; producer_num++ )
+      num_errors += CheckRows(db, producer_num, num_records);
+   RTBitstringWriterShutdown(&RTW);
+
+   return num_errors;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Commit interval check. 'num_rows_before' rows are already in the table. Returns the number of errors.
+
+static int CheckCommitInterval(char *DB_name, sqlite3 *db, int num_rows_before)
+   {
+   RTBitstringWriterStruct RTW;
+   int commit_interval_ms = 500;
+   int num_records = TEST_BATCH_SIZE/2;
+   int record_num, num_rows, num_errors;
+   unsigned long num_commits;
+
+   num_errors = 0;
+   RTBitstringWriterInit(&RTW, DB_name, TEST_BATCH_SIZE, commit_interval_ms);
+   for ( record_num = 0; record_num < num_records; record_num++ )
+      RTBitstringWriterEnqueue(&RTW, MakeRecord(TEST_NUM_PRODUCERS, record_num));
+
+   if ( (num_rows = CountRows(db)) != num_rows_before )
+      { printf("\t%d rows right after queueing %d records, expected %d!\n", num_rows, num_records, num_rows_before); num_errors++; }
+
+   usleep(2*commit_interval_ms*1000);
+   if ( (num_rows = CountRows(db)) != num_rows_before + num_records )
+      { printf("\t%d rows after %d ms, expected %d!\n", num_rows, 2*commit_interval_ms, num_rows_before + num_records); num_errors++; }
+   num_errors += CheckRows(db, TEST_NUM_PRODUCERS, num_records);
+
+   pthread_mutex_lock(&(RTW.mutex));
+   num_commits = RTW.num_commits;
+   pthread_mutex_unlock(&(RTW.mutex));
+   if ( num_commits != 1 )
+      { printf("\t%lu transactions for %d records, expected 1!\n", num_commits, num_records); num_errors++; }
+   RTBitstringWriterShutdown(&RTW);
+
+   return num_errors;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Shutdown check. 'num_rows_before' rows are already in the table. Returns the number of errors.
+
+static int CheckShutdown(char *DB_name, sqlite3 *db, int num_rows_before)
+   {
+   RTBitstringWriterStruct RTW;
+   RTBitstringRecordStruct *record_ptr;
+   int num_records = 3*TEST_BATCH_SIZE + 5;
+   int record_num, num_rows, num_errors;
+
+   num_errors = 0;
+   RTBitstringWriterInit(&RTW, DB_name, TEST_BATCH_SIZE, 10000);
+   for ( record_num = 0; record_num < num_records; record_num++ )
+      RTBitstringWriterEnqueue(&RTW, MakeRecord(TEST_NUM_PRODUCERS + 1, record_num));
+
+// The first step of RTBitstringWriterShutdown(). The writer thread keeps running until the queue is empty.
+   pthread_mutex_lock(&(RTW.mutex));
+   RTW.stop = 1;
+   pthread_cond_signal(&(RTW.not_empty_cond));
+   pthread_cond_broadcast(&(RTW.not_full_cond));
+   pthread_mutex_unlock(&(RTW.mutex));
+
+   for ( record_num = 0; record_num < TEST_NUM_REJECTED; record_num++ )
+      {
+      record_ptr = MakeRecord(TEST_NUM_PRODUCERS + 2, record_num);
+      pthread_mutex_lock(&Watch_mutex);
+      Watched_ptrs[Num_watched++] = record_ptr;
+      Watched_ptrs[Num_watched++] = record_ptr->Bitstring;
+      pthread_mutex_unlock(&Watch_mutex);
+      RTBitstringWriterEnqueue(&RTW, record_ptr);
+      }
+
+   if ( RTW.num_rejected != TEST_NUM_REJECTED )
+      { printf("\t%lu records rejected after stop, expected %d!\n", RTW.num_rejected, TEST_NUM_REJECTED); num_errors++; }
+   pthread_mutex_lock(&Watch_mutex);
+   if ( Num_watched_freed != Num_watched )
+      { printf("\t%d of the %d rejected records and bitstrings freed!\n", Num_watched_freed, Num_watched); num_errors++; }
+   pthread_mutex_unlock(&Watch_mutex);
+
+   RTBitstringWriterShutdown(&RTW);
+
+   if ( (num_rows = CountRows(db)) != num_rows_before + num_records )
+      { printf("\t%d rows after the shutdown, expected %d!\n", num_rows, num_rows_before + num_records); num_errors++; }
+   num_errors += CheckRows(db, TEST_NUM_PRODUCERS + 1, num_records);
+   num_errors += CheckRows(db, TEST_NUM_PRODUCERS + 2, 0);
+
+   return num_errors;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+
+int main(int argc, char *argv[])
+   {
+   char dir_name[] = "/tmp/rt_writer_test.XXXXXX";
+   char DB_name[MAX_STRING_LEN], file_name[MAX_STRING_LEN];
+   sqlite3 *db;
+   int num_records, num_errors, check_errors;
+
+   num_records = 2000;
+   if ( argc > 1 )
+      num_records = atoi(argv[1]);
+   if ( num_records <= 0 )
+      { printf("Usage: rt_writer_test [num_records_per_producer]\n"); exit(EXIT_FAILURE); }
+
+   if ( mkdtemp(dir_name) == NULL )
+      { printf("ERROR: main(): Failed to create a temporary directory!\n"); exit(EXIT_FAILURE); }
+   sprintf(DB_name, "%s/RunTime.db", dir_name);
+
+// The reader connection, which also creates the table.
+   if ( sqlite3_open(DB_name, &db) != SQLITE_OK )
+      { printf("ERROR: main(): Failed to open '%s': %s\n", DB_name, sqlite3_errmsg(db)); exit(EXIT_FAILURE); }
+   if ( sqlite3_exec(db, SQL_BSTRINGS_CREATE_CMD, NULL, NULL, NULL) != SQLITE_OK )
+      { printf("ERROR: main(): %s\n", sqlite3_errmsg(db)); exit(EXIT_FAILURE); }
+
+   num_errors = 0;
+   check_errors = CheckFlush(DB_name, db, num_records);
+   printf("Flush          \t%d producers\t%d records each\t%s\n", TEST_NUM_PRODUCERS, num_records, (check_errors == 0) ? "PASS" : "FAIL");
+   num_errors += check_errors;
+
+   check_errors = CheckCommitInterval(DB_name, db, TEST_NUM_PRODUCERS * num_records);
+   printf("Commit interval\t%s\n", (check_errors == 0) ? "PASS" : "FAIL");
+   num_errors += check_errors;
+
+   check_errors = CheckShutdown(DB_name, db, TEST_NUM_PRODUCERS * num_records + TEST_BATCH_SIZE/2);
+   printf("Shutdown       \t%s\n", (check_errors == 0) ? "PASS" : "FAIL");
+   num_errors += check_errors;
+
+   sqlite3_close(db);
+   remove(DB_name);
+   sprintf(file_name, "%s-wal", DB_name);
+   remove(file_name);
+   sprintf(file_name, "%s-shm", DB_name);
+   remove(file_name);
+   rmdir(dir_name);
+
+   if ( num_errors != 0 )
+      { printf("ERROR: main(): %d checks FAILED!\n", num_errors); exit(EXIT_FAILURE); }
+   printf("All tests PASSED\n");
+
+   return 0;
+   }
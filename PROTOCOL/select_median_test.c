@@ -0,0 +1,324 @@
+// ========================================================================================================
+// ========================================================================================================
+// ****************************************** select_median_test.c ****************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+//
+// Randomized differential test of the selection routines in utility.c against a full qsort(). For random
+// sizes (including 1, 2 and 3) and data patterns (uniform, heavy duplicates, all equal, sorted, reversed,
+// organ pipe, sawtooth and the median-of-three killer that forces the qsort() fallback):
+//
+//    SelectKthFloat() and SelectKthInt() MUST return the k-th smallest value, leave a permutation of the input
+//    that is partitioned around vals[k].
+//    SelectTwoInt() MUST return both order statistics.
+//    ComputeMedianInPlace(), ComputeMedian() and ComputeColumnMedians() MUST return exactly the median the
+//    original code computed: qsort() and the average of the middle two values for an even count.
+//    ComputeMedian() MUST NOT modify its input.
+//
+// Usage: select_median_test [num_trials] [max_vals]
+
+#include "utility.h"
+
+#define PATTERN_UNIFORM 0
+#define PATTERN_DUPLICATES 1
+#define PATTERN_EQUAL 2
+#define PATTERN_SORTED 3
+#define PATTERN_REVERSED 4
+#define PATTERN_ORGAN_PIPE 5
+#define PATTERN_SAWTOOTH 6
+#define PATTERN_MO3_KILLER 7
+#define NUM_PATTERNS 8
+
+static char *Pattern_names[] = { "uniform", "duplicates", "equal", "sorted", "reversed", "organ pipe", "sawtooth", "mo3 killer" };
+static unsigned long long Test_rng_state = 0x2545F4914F6CDD1DULL;
+
+
+// ========================================================================================================
+// ========================================================================================================
+// xorshift64 for the test data.
+
+static unsigned int TestRand()
+   {
+   Test_rng_state ^= Test_rng_state >> 12;
+   Test_rng_state ^= Test_rng_state << 25;
+   Test_rng_state ^= Test_rng_state >> 27;
+   return (unsigned int)((Test_rng_state * 0x2545F4914F6CDD1DULL) >> 32);
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Integer test data in one of the patterns. The float data is derived from it.
+
+static void TestGenVals(int pattern, int num_vals, int *vals)
+   {
+   int val_num, half;
+
+   half = num_vals/2;
+   for ( val_num = 0; val_num < num_vals; val_num++ )
+      {
+      if ( pattern == PATTERN_UNIFORM )
+         vals[val_num] = (int)TestRand() - 0x7FFFFFFF/2;
+      else if ( pattern == PATTERN_DUPLICATES )
+         vals[val_num] = (int)(TestRand() % 5) - 2;
+      else if ( pattern == PATTERN_EQUAL )
+         vals[val_num] = 7;
+      else if ( pattern == PATTERN_SORTED )
+         vals[val_num] = val_num;
+      else if ( pattern == PATTERN_REVERSED )
+         vals[val_num] = num_vals - val_num;
+      else if ( pattern == PATTERN_ORGAN_PIPE )
+         vals[val_num] = val_num < half ? val_num : num_vals - val_num;
+      else if ( pattern == PATTERN_SAWTOOTH )
+         vals[val_num] = val_num % 17;
+
+// Odd positions of the first half get 1, 3, 5, ... and the rest follows, so the median-of-three pivot is
+// always close to the smallest value and the partitions degrade.
+      else if ( val_num < half )
+         vals[val_num] = val_num % 2 == 0 ? val_num + 1 : half + val_num;
+      else
+         vals[val_num] = 2*(val_num - half + 1);
+      }
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// The median as the original ComputeMedian() computed it.
+
+static float TestRefMedian(int num_vals, float *sorted_vals)
+   {
+   if ( num_vals % 2 == 0 )
+      return (sorted_vals[num_vals/2 - 1] + sorted_vals[num_vals/2])/2;
+   return sorted_vals[num_vals/2];
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// After selection, 'vals' MUST be a permutation of the sorted values and be partitioned around vals[k].
+// Both checks work on copies. Returns 0 when they hold.
+
+static int TestCheckFloatSelection(int num_vals, float *vals, float *sorted_vals, int k)
+   {
+   float check_vals[num_vals];
+   int val_num;
+
+   for ( val_num = 0; val_num < num_vals; val_num++ )
+      if ( (val_num < k && vals[val_num] > vals[k]) || (val_num > k && vals[val_num] < vals[k]) )
+         return 1;
+
+   memcpy(check_vals, vals, sizeof(float)*num_vals);
+   qsort(check_vals, num_vals, sizeof(float), MedianCompareFunc);
+   return memcmp(check_vals, sorted_vals, sizeof(float)*num_vals) != 0;
+   }
+
+static int TestIntCompareFunc(const void *v1, const void *v2)
+   {
+   return (*(int *)v1 > *(int *)v2) - (*(int *)v1 < *(int *)v2);
+   }
+
+static int TestCheckIntSelection(int num_vals, int *vals, int *sorted_vals, int k)
+   {
+   int check_vals[num_vals];
+   int val_num;
+
+   for ( val_num = 0; val_num < num_vals; val_num++ )
+      if ( (val_num < k && vals[val_num] > vals[k]) || (val_num > k && vals[val_num] < vals[k]) )
+         return 1;
+
+   memcpy(check_vals, vals, sizeof(int)*num_vals);
+   qsort(check_vals, num_vals, sizeof(int), TestIntCompareFunc);
+   return memcmp(check_vals, sorted_vals, sizeof(int)*num_vals) != 0;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// One trial on 'num_vals' values of 'pattern'. Returns the number of failed checks.
+
+static int TestTrial(int pattern, int num_vals)
+   {
+   int int_vals[num_vals], int_sorted[num_vals], int_work[num_vals];
+   float float_vals[num_vals], float_sorted[num_vals], float_work[num_vals];
+   int val_num, k, k_low, k_high, low_val, high_val, num_errors;
+   float median, ref_median;
+
+   TestGenVals(pattern, num_vals, int_vals);
+
+// Floats with fractions and both signs, keeping the duplicates of the integers.
+   for ( val_num = 0; val_num < num_vals; val_num++ )
+      float_vals[val_num] = (float)(int_vals[val_num] % 100000) * 0.37f - 1000.0f;
+
+   memcpy(int_sorted, int_vals, sizeof(int)*num_vals);
+   qsort(int_sorted, num_vals, sizeof(int), TestIntCompareFunc);
+   memcpy(float_sorted, float_vals, sizeof(float)*num_vals);
+   qsort(float_sorted, num_vals, sizeof(float), MedianCompareFunc);
+
+   num_errors = 0;
+
+// Random k plus the ends and the middle.
+   for ( val_num = 0; val_num < 5; val_num++ )
+      {
+      if ( val_num == 0 )
+         k = 0;
+      else if ( val_num == 1 )
+         k = num_vals - 1;
+      else if ( val_num == 2 )
+         k = num_vals/2;
+      else
+         k = (int)(TestRand() % num_vals);
+
+      memcpy(float_work, float_vals, sizeof(float)*num_vals);
+      if ( SelectKthFloat(num_vals, float_work, k) != float_sorted[k] || TestCheckFloatSelection(num_vals, float_work, float_sorted, k) != 0 )
+         {
+         printf("\t%s: %d values: SelectKthFloat() k %d returned %f -- expected %f\n", Pattern_names[pattern], num_vals, k, float_work[k],
+            float_sorted[k]);
+         num_errors++;
+         }
+
+      memcpy(int_work, int_vals, sizeof(int)*num_vals);
+      if ( SelectKthInt(num_vals, int_work, k) != int_sorted[k] || TestCheckIntSelection(num_vals, int_work, int_sorted, k) != 0 )
+         {
+         printf("\t%s: %d values: SelectKthInt() k %d returned %d -- expected %d\n", Pattern_names[pattern], num_vals, k, int_work[k],
+            int_sorted[k]);
+         num_errors++;
+         }
+      }
+
+   if ( num_vals > 1 )
+      {
+      k_high = 1 + (int)(TestRand() % (num_vals - 1));
+      k_low = (int)(TestRand() % k_high);
+      memcpy(int_work, int_vals, sizeof(int)*num_vals);
+      SelectTwoInt(num_vals, int_work, k_low, k_high, &low_val, &high_val);
+      if ( low_val != int_sorted[k_low] || high_val != int_sorted[k_high] )
+         {
+         printf("\t%s: %d values: SelectTwoInt() k %d and %d returned %d and %d -- expected %d and %d\n", Pattern_names[pattern], num_vals,
+            k_low, k_high, low_val, high_val, int_sorted[k_low], int_sorted[k_high]);
+         num_errors++;
+         }
+      }
+
+// The medians MUST be bit-for-bit the values of the original code.
+   ref_median = TestRefMedian(num_vals, float_sorted);
+   memcpy(float_work, float_vals, sizeof(float)*num_vals);
+   median = ComputeMedianInPlace(num_vals, float_work);
+   if ( memcmp(&median, &ref_median, sizeof(float)) != 0 )
+      {
+      printf("\t%s: %d values: ComputeMedianInPlace() returned %.9g -- expected %.9g\n", Pattern_names[pattern], num_vals, median, ref_median);
+      num_errors++;
+      }
+
+   memcpy(float_work, float_vals, sizeof(float)*num_vals);
+   median = ComputeMedian(num_vals, float_work);
+   if ( memcmp(&median, &ref_median, sizeof(float)) != 0 || memcmp(float_work, float_vals, sizeof(float)*num_vals) != 0 )
+      {
+      printf("\t%s: %d values: ComputeMedian() returned %.9g -- expected %.9g (or modified its input)\n", Pattern_names[pattern], num_vals,
+         median, ref_median);
+      num_errors++;
+      }
+
+   return num_errors;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// ComputeColumnMedians() on random rows MUST match the reference median of every column. Returns the number
+// of mismatching columns.
+
+static int TestColumnMedians(int num_rows, int num_cols)
+   {
+   float *rows[num_rows];
+   float medians[num_cols], column[num_rows];
+   int row_num, col_num, num_errors;
+   float ref_median;
+
+   for ( row_num = 0; row_num < num_rows; row_num++ )
+      {
+      if ( (rows[row_num] = (float *)malloc(sizeof(float) * num_cols)) == NULL )
+         { printf("ERROR: TestColumnMedians(): Failed to allocate row %d!\n", row_num); exit(EXIT_FAILURE); }
+      for ( col_num = 0; col_num < num_cols; col_num++ )
+         rows[row_num][col_num] = (float)((int)(TestRand() % 2001) - 1000)/16.0f;
+      }
+
+   ComputeColumnMedians(num_rows, num_cols, rows, medians);
+
+   num_errors = 0;
+   for ( col_num = 0; col_num < num_cols; col_num++ )
+      {
+      for ( row_num = 0; row_num < num_rows; row_num++ )
+         column[row_num] = rows[row_num][col_num];
+      qsort(column, num_rows, sizeof(float), MedianCompareFunc);
+      ref_median = TestRefMedian(num_rows, column);
+      if ( memcmp(&(medians[col_num]), &ref_median, sizeof(float)) != 0 )
+         num_errors++;
+      }
+
+   for ( row_num = 0; row_num < num_rows; row_num++ )
+      free(rows[row_num]);
+
+   return num_errors;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+
+int main(int argc, char *argv[])
+   {
+   int num_trials, max_vals;
+
+   int pattern, trial_num, num_vals, num_errors, num_failed, num_rows;
+
+   num_trials = 500;
+   max_vals = 5000;
+   if ( argc > 1 )
+      num_trials = atoi(argv[1]);
+   if ( argc > 2 )
+      max_vals = atoi(argv[2]);
+   if ( num_trials <= 0 || max_vals <= 3 )
+      { printf("ERROR: main(): Number of trials MUST be positive and the max number of values > 3!\n"); exit(EXIT_FAILURE); }
+
+   num_failed = 0;
+   for ( pattern = 0; pattern < NUM_PATTERNS; pattern++ )
+      {
+      num_errors = 0;
+      for ( trial_num = 0; trial_num < num_trials; trial_num++ )
+         {
+
+// Small sizes first, where the even/odd and two-value cases live, then random sizes up to 'max_vals'.
+         if ( trial_num < 16 )
+            num_vals = trial_num + 1;
+         else
+            num_vals = 1 + (int)(TestRand() % max_vals);
+         num_errors += TestTrial(pattern, num_vals);
+         }
+      if ( num_errors != 0 )
+         num_failed++;
+      printf("Pattern %-10s\t%d trials\t%s\n", Pattern_names[pattern], num_trials, num_errors == 0 ? "PASS" : "FAIL");
+      fflush(stdout);
+      }
+
+// Column medians, odd and even numbers of rows (chips).
+   num_errors = 0;
+   for ( num_rows = 1; num_rows <= 40; num_rows++ )
+      num_errors += TestColumnMedians(num_rows, NUM_REQUIRED_PNDIFFS/16);
+   if ( num_errors != 0 )
+      num_failed++;
+   printf("Column medians\t\t40 row counts\t%s\n", num_errors == 0 ? "PASS" : "FAIL");
+
+   if ( num_failed != 0 )
+      { printf("ERROR: main(): %d tests FAILED!\n", num_failed); exit(EXIT_FAILURE); }
+   printf("All tests PASSED\n");
+
+   return 0;
+   }
@@ -0,0 +1,316 @@
+// ========================================================================================================
+// ========================================================================================================
+// ****************************************** sock_loopback_bench.c ***************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+//
+// Loopback benchmark of the framed socket layer. A verifier thread and a device (main thread) replay the message
+// sequence of one KEK client authentication over a fresh TCP connection per authentication, using:
+//
+//    legacy  : header and payload in two send() calls, unbuffered recv() loops, Nagle enabled (the original SockSendB/SockGetB).
+//    framed  : SockSendB()/SockSendFrames() (one writev per frame or batch), SockGetB() with a reader attached, TCP_NODELAY.
+//    corked  : as 'framed' but consecutive frames are sent one SockSendB() at a time inside TCP_CORK/uncork.
+//
+// Usage: sock_loopback_bench [num_authentications] [port]
+
+#include "common.h"
+
+extern int usleep (__useconds_t __useconds);
+
+#define BENCH_MODE_LEGACY 0
+#define BENCH_MODE_FRAMED 1
+#define BENCH_MODE_CORKED 2
+
+#define BENCH_MAX_FRAMES_PER_STEP 4
+#define BENCH_MAX_FRAME_LEN 4096
+
+// One step of the exchange: 'num_frames' consecutive frames sent by the device (from_device = 1) or the verifier.
+typedef struct
+   {
+   int from_device;
+   int num_frames;
+   int frame_sizes[BENCH_MAX_FRAMES_PER_STEP];
+   } BenchStepStruct;
+
+// Frame sizes follow the defaults in verifier_regeneration.c (2048 PNDiffs, 1 byte per SpreadFactor, one XMR_SHD attempt).
+static BenchStepStruct Bench_steps[] =
+   {
+   { 1, 2, { 22, 40 } },             // "CLIENT-AUTHENTICATION", chip/IP/bitstream information
+   { 0, 1, { 4 } },                  // "ACK"
+   { 0, 1, { 8 } },                  // Verifier nonce n2
+   { 1, 1, { 8 } },                  // XOR nonce
+   { 0, 1, { 16 } },                 // KEK authentication nonce
+   { 0, 1, { 2048 } },               // SpreadFactors
+   { 1, 3, { 20, 2048, 256 } },      // "SPREAD_FACTORS DONE", device SpreadFactors, XMR_SHD
+   { 1, 1, { 4 } },                  // "ACK"
+   { 0, 1, { 8 } },                  // Authentication result
+   };
+
+typedef struct
+   {
+   int port_number;
+   int num_authens;
+   int mode;
+   } BenchServerStruct;
+
+
+// ========================================================================================================
+// ========================================================================================================
+// The original two-send framing.
+
+static int LegacySockSendB(unsigned char *buffer, int buffer_size, int socket_desc)
+   {
+   unsigned char num_bytes[3];
+
+   num_bytes[2] = (unsigned char)((buffer_size & 0x00FF0000) >> 16);
+   num_bytes[1] = (unsigned char)((buffer_size & 0x0000FF00) >> 8);
+   num_bytes[0] = (unsigned char)(buffer_size & 0x000000FF);
+   if ( send(socket_desc, num_bytes, 3, 0) < 0 )
+      return -1;
+   if ( send(socket_desc, buffer, buffer_size, 0) < 0 )
+      return -1;
+
+   return 0;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// The original unbuffered receive loop (with EOF detection added so a broken run cannot spin).
+
+static int LegacyRecvAll(unsigned char *buffer, int num_bytes, int socket_desc)
+   {
+   int tot_bytes_received, num_recv;
+
+   tot_bytes_received = 0;
+   while ( tot_bytes_received < num_bytes )
+      {
+      if ( (num_recv = recv(socket_desc, &buffer[tot_bytes_received], num_bytes - tot_bytes_received, 0)) <= 0 )
+         return -1;
+      tot_bytes_received += num_recv;
+      }
+
+   return tot_bytes_received;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+
+static int LegacySockGetB(unsigned char *buffer, int buffer_size, int socket_desc)
+   {
+   unsigned char buffer_num_bytes[3];
+   int target_num_bytes;
+
+   if ( LegacyRecvAll(buffer_num_bytes, 3, socket_desc) < 0 )
+      return -1;
+   target_num_bytes = (int)(buffer_num_bytes[2] << 16) + (int)(buffer_num_bytes[1] << 8) + (int)buffer_num_bytes[0];
+   if ( target_num_bytes > buffer_size )
+      return -1;
+
+   return LegacyRecvAll(buffer, target_num_bytes, socket_desc);
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Play one side of the exchange on 'socket_desc'. Steps sent by this side are transmitted, the others are received
+// and their lengths checked.
+
+static void RunExchange(int socket_desc, int is_device, int mode)
+   {
+   int num_steps = sizeof(Bench_steps)/sizeof(BenchStepStruct);
+   unsigned char frames[BENCH_MAX_FRAMES_PER_STEP][BENCH_MAX_FRAME_LEN];
+   unsigned char *frame_ptrs[BENCH_MAX_FRAMES_PER_STEP];
+   int step_num, frame_num, num_recv;
+   BenchStepStruct *step_ptr;
+
+   memset(frames, 'x', sizeof(frames));
+   for ( frame_num = 0; frame_num < BENCH_MAX_FRAMES_PER_STEP; frame_num++ )
+      frame_ptrs[frame_num] = frames[frame_num];
+
+   for ( step_num = 0; step_num < num_steps; step_num++ )
+      {
+      step_ptr = &Bench_steps[step_num];
+
+// Sender
+      if ( step_ptr->from_device == is_device )
+         {
+         if ( mode == BENCH_MODE_LEGACY )
+            {
+            for ( frame_num = 0; frame_num < step_ptr->num_frames; frame_num++ )
+               if ( LegacySockSendB(frames[frame_num], step_ptr->frame_sizes[frame_num], socket_desc) < 0 )
+                  { printf("ERROR: RunExchange(): Legacy send failed at step %d!\n", step_num); exit(EXIT_FAILURE); }
+            }
+         else if ( mode == BENCH_MODE_FRAMED )
+            {
+            if ( SockSendFrames(step_ptr->num_frames, frame_ptrs, step_ptr->frame_sizes, socket_desc) < 0 )
+               { printf("ERROR: RunExchange(): Framed send failed at step %d!\n", step_num); exit(EXIT_FAILURE); }
+            }
+         else
+            {
+            SockSetCork(socket_desc, 1);
+            for ( frame_num = 0; frame_num < step_ptr->num_frames; frame_num++ )
+               if ( SockSendB(frames[frame_num], step_ptr->frame_sizes[frame_num], socket_desc) < 0 )
+                  { printf("ERROR: RunExchange(): Corked send failed at step %d!\n", step_num); exit(EXIT_FAILURE); }
+            SockSetCork(socket_desc, 0);
+            }
+         }
+
+// Receiver
+      else
+         for ( frame_num = 0; frame_num < step_ptr->num_frames; frame_num++ )
+            {
+            if ( mode == BENCH_MODE_LEGACY )
+               num_recv = LegacySockGetB(frames[frame_num], BENCH_MAX_FRAME_LEN, socket_desc);
+            else
+               num_recv = SockGetB(frames[frame_num], BENCH_MAX_FRAME_LEN, socket_desc);
+            if ( num_recv != step_ptr->frame_sizes[frame_num] )
+               { printf("ERROR: RunExchange(): Step %d frame %d: received %d bytes, expected %d!\n", step_num, frame_num,
+                  num_recv, step_ptr->frame_sizes[frame_num]); exit(EXIT_FAILURE); }
+            }
+      }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Verifier side. Accepts one connection per authentication, the same way the epoll server hands device connections
+// to BankThread.
+
+static void *BenchServerThread(void *arg)
+   {
+   BenchServerStruct *BS_ptr = (BenchServerStruct *)arg;
+   int master_socket, socket_desc, authen_num;
+   struct sockaddr_in server_addr;
+   int opt = 1;
+
+   if ( (master_socket = socket(AF_INET, SOCK_STREAM, 0)) < 0 )
+      { perror("ERROR: BenchServerThread(): socket"); exit(EXIT_FAILURE); }
+   setsockopt(master_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+   memset(&server_addr, 0, sizeof(server_addr));
+   server_addr.sin_family = AF_INET;
+   server_addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+   server_addr.sin_port = htons(BS_ptr->port_number);
+   if ( bind(master_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0 )
+      { perror("ERROR: BenchServerThread(): bind"); exit(EXIT_FAILURE); }
+   if ( listen(master_socket, 16) < 0 )
+      { perror("ERROR: BenchServerThread(): listen"); exit(EXIT_FAILURE); }
+
+   for ( authen_num = 0; authen_num < BS_ptr->num_authens; authen_num++ )
+      {
+      if ( (socket_desc = accept(master_socket, NULL, NULL)) < 0 )
+         { perror("ERROR: BenchServerThread(): accept"); exit(EXIT_FAILURE); }
+      if ( BS_ptr->mode != BENCH_MODE_LEGACY )
+         {
+         SockReaderAttach(socket_desc);
+         SockSetNoDelay(socket_desc, 1);
+         }
+
+      RunExchange(socket_desc, 0, BS_ptr->mode);
+
+      SockReaderDetach(socket_desc);
+      close(socket_desc);
+      }
+
+   close(master_socket);
+   return NULL;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Run 'num_authens' authentications in 'mode' and print the per-authentication latency.
+
+static void RunBenchMode(int num_authens, int port_number, int mode, char *mode_name, int num_round_trips)
+   {
+   BenchServerStruct BS;
+   pthread_t server_thread;
+   struct timeval t0, t1;
+   double elapsed_us, tot_us, min_us, max_us;
+   int socket_desc, authen_num;
+
+   BS.port_number = port_number;
+   BS.num_authens = num_authens;
+   BS.mode = mode;
+   if ( pthread_create(&server_thread, NULL, BenchServerThread, &BS) != 0 )
+      { printf("ERROR: RunBenchMode(): Failed to create server thread!\n"); exit(EXIT_FAILURE); }
+
+   tot_us = 0.0;
+   min_us = -1.0;
+   max_us = 0.0;
+   for ( authen_num = 0; authen_num < num_authens; authen_num++ )
+      {
+      while ( OpenSocketClient(MAX_STRING_LEN, "127.0.0.1", port_number, &socket_desc) < 0 )
+         usleep(10000);
+
+      gettimeofday(&t0, 0);
+      if ( mode != BENCH_MODE_LEGACY )
+         {
+         SockReaderAttach(socket_desc);
+         SockSetNoDelay(socket_desc, 1);
+         }
+
+      RunExchange(socket_desc, 1, mode);
+
+      SockReaderDetach(socket_desc);
+      close(socket_desc);
+      gettimeofday(&t1, 0);
+
+      elapsed_us = (double)((t1.tv_sec - t0.tv_sec)*1000000 + t1.tv_usec - t0.tv_usec);
+      tot_us += elapsed_us;
+      if ( min_us < 0.0 || elapsed_us < min_us )
+         min_us = elapsed_us;
+      if ( elapsed_us > max_us )
+         max_us = elapsed_us;
+      }
+
+   pthread_join(server_thread, NULL);
+
+   printf("%-8s  authentications %5d\tround trips/authen %d\tave %9.1f us\tmin %9.1f us\tmax %9.1f us\tave/round trip %8.1f us\n",
+      mode_name, num_authens, num_round_trips, tot_us/num_authens, min_us, max_us, tot_us/num_authens/num_round_trips);
+   fflush(stdout);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+
+int main(int argc, char *argv[])
+   {
+   int num_steps = sizeof(Bench_steps)/sizeof(BenchStepStruct);
+   int num_authens, port_number, num_turns, step_num;
+
+   num_authens = 200;
+   port_number = 9876;
+   if ( argc > 1 )
+      num_authens = atoi(argv[1]);
+   if ( argc > 2 )
+      port_number = atoi(argv[2]);
+   if ( num_authens <= 0 )
+      { printf("ERROR: main(): Number of authentications must be positive!\n"); exit(EXIT_FAILURE); }
+
+// A round trip is a device-to-verifier turn followed by a verifier-to-device turn.
+   num_turns = 1;
+   for ( step_num = 1; step_num < num_steps; step_num++ )
+      if ( Bench_steps[step_num].from_device != Bench_steps[step_num - 1].from_device )
+         num_turns++;
+
+   RunBenchMode(num_authens, port_number, BENCH_MODE_LEGACY, "legacy", (num_turns + 1)/2);
+   RunBenchMode(num_authens, port_number + 1, BENCH_MODE_FRAMED, "framed", (num_turns + 1)/2);
+   RunBenchMode(num_authens, port_number + 2, BENCH_MODE_CORKED, "corked", (num_turns + 1)/2);
+
+   return 0;
+   }
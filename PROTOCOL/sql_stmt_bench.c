@@ -0,0 +1,344 @@
+// ========================================================================================================
+// ========================================================================================================
+// ******************************************** sql_stmt_bench.c ******************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+//
+// Microbenchmark of the prepared statement cache in commonDB.c over a synthetic NAT database held in memory
+// (VecPairs and TimingVals tables with the indexes of the SQLSchemaScripts). The same random lookups of the
+// TimingVals Ave and VecPairs R_F_str fields, the queries of the non-TVC verifier path, are run with:
+//
+//    exec    : SQL text built with sprintf(), run with sqlite3_exec() and the row parsed with sscanf() (the original helpers).
+//    prepare : sqlite3_prepare_v2(), bind, step and sqlite3_finalize() per query (typed accessors, no cache).
+//    cached  : GetTimingValsAveField() and GetVecPairsRiseFallStrField() (per-thread statement cache).
+//
+// Each mode is run by one thread and by 'num_threads' threads sharing the connection (SQLITE_OPEN_FULLMUTEX, as in the
+// verifier). The checksums of all modes MUST agree.
+//
+// Usage: sql_stmt_bench [num_queries] [num_threads] [num_chips] [num_vecpairs]
+
+#include "commonDB.h"
+
+#define BENCH_MODE_EXEC 0
+#define BENCH_MODE_PREPARE 1
+#define BENCH_MODE_CACHED 2
+
+#define BENCH_NUM_POS 16
+
+typedef struct
+   {
+   sqlite3 *db;
+   int mode;
+   int first_query;
+   int last_query;
+   int *chip_ids;
+   int *vecpair_ids;
+   int *PO_nums;
+   double checksum;
+   } BenchThreadStruct;
+
+static char *Bench_mode_names[] = { "exec", "prepare", "cached" };
+static unsigned long long Bench_rng_state = 0x2545F4914F6CDD1DULL;
+
+
+// ========================================================================================================
+// ========================================================================================================
+// xorshift64 for the synthetic data and the queries.
+
+static unsigned int BenchRand()
+   {
+   Bench_rng_state ^= Bench_rng_state >> 12;
+   Bench_rng_state ^= Bench_rng_state << 25;
+   Bench_rng_state ^= Bench_rng_state >> 27;
+   return (unsigned int)((Bench_rng_state * 0x2545F4914F6CDD1DULL) >> 32);
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Create and fill the synthetic NAT database. PUFInstance ids are 1 to num_chips and VecPairs ids 1 to
+// num_vecpairs. Every vector pair has BENCH_NUM_POS timing values per chip.
+
+static sqlite3 *BenchCreateDB(int num_chips, int num_vecpairs)
+   {
+   sqlite3 *db;
+   sqlite3_stmt *pStmt;
+   char *zErrMsg = 0;
+   int chip_num, vecpair_num, PO_num;
+
+   const char *schema =
+      "CREATE TABLE VecPairs (id INTEGER PRIMARY KEY, R_F_str TEXT NOT NULL, VA INTEGER NOT NULL, VB INTEGER NOT NULL, "
+      "NumPNs INTEGER NOT NULL, PUFDesign_id INTEGER NOT NULL);"
+      "CREATE UNIQUE INDEX VecPairs_VA_VB_PD_index ON VecPairs (VA, VB, PUFDesign_id);"
+      "CREATE TABLE TimingVals (id INTEGER PRIMARY KEY, VecPair INTEGER NOT NULL, PO INTEGER NOT NULL, Ave INTEGER NOT NULL, "
+      "TSig INTEGER NOT NULL, PUFInstance INTEGER NOT NULL);"
+      "CREATE UNIQUE INDEX TimingVals_PUFInst_VecPair_PO_Ave_index ON TimingVals (PUFInstance, VecPair, PO, Ave);";
+
+   if ( sqlite3_open_v2(":memory:", &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX, NULL) != SQLITE_OK )
+      { printf("ERROR: BenchCreateDB(): Failed to open the in-memory database!\n"); exit(EXIT_FAILURE); }
+   if ( sqlite3_exec(db, schema, NULL, 0, &zErrMsg) != SQLITE_OK )
+      { printf("ERROR: BenchCreateDB(): SQL ERROR: %s\n", zErrMsg); sqlite3_free(zErrMsg); exit(EXIT_FAILURE); }
+
+   SQLBeginTransaction(db);
+   pStmt = SQLStmtAcquire(db, "INSERT INTO VecPairs (id, R_F_str, VA, VB, NumPNs, PUFDesign_id) VALUES (?, ?, ?, ?, ?, 1);",
+      "BenchCreateDB()");
+   for ( vecpair_num = 1; vecpair_num <= num_vecpairs; vecpair_num++ )
+      {
+      SQLStmtBindInt(pStmt, 1, vecpair_num, "BenchCreateDB()");
+      SQLStmtBindText(pStmt, 2, (BenchRand() & 1) == 0 ? "R" : "F", "BenchCreateDB()");
+      SQLStmtBindInt(pStmt, 3, 2*vecpair_num, "BenchCreateDB()");
+      SQLStmtBindInt(pStmt, 4, 2*vecpair_num + 1, "BenchCreateDB()");
+      SQLStmtBindInt(pStmt, 5, BENCH_NUM_POS, "BenchCreateDB()");
+      SQLStmtStep(pStmt, "BenchCreateDB()");
+      sqlite3_reset(pStmt);
+      }
+   SQLStmtRelease(pStmt);
+
+   pStmt = SQLStmtAcquire(db, SQL_TimingVals_insert_into_cmd, "BenchCreateDB()");
+   for ( chip_num = 1; chip_num <= num_chips; chip_num++ )
+      for ( vecpair_num = 1; vecpair_num <= num_vecpairs; vecpair_num++ )
+         for ( PO_num = 0; PO_num < BENCH_NUM_POS; PO_num++ )
+            {
+            SQLStmtBindInt(pStmt, 1, vecpair_num, "BenchCreateDB()");
+            SQLStmtBindInt(pStmt, 2, PO_num, "BenchCreateDB()");
+            SQLStmtBindInt(pStmt, 3, 16*1000 + (int)(BenchRand() % (16*400)), "BenchCreateDB()");
+            SQLStmtBindInt(pStmt, 4, (int)(BenchRand() % 64), "BenchCreateDB()");
+            SQLStmtBindInt(pStmt, 5, chip_num, "BenchCreateDB()");
+            SQLStmtStep(pStmt, "BenchCreateDB()");
+            sqlite3_reset(pStmt);
+            }
+   SQLStmtRelease(pStmt);
+   SQLCommitTransaction(db);
+
+   return db;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// The original string-based lookups: sprintf(), sqlite3_exec() with the row callback and sscanf().
+
+static float BenchExecAve(sqlite3 *db, int chip_id, int vecpair_id, int PO_num)
+   {
+   SQLRowStringsStruct row_strings_struct;
+   char sql_command_str[MAX_STRING_LEN];
+   float ave_val;
+
+   sprintf(sql_command_str, "SELECT Ave FROM TimingVals WHERE PUFInstance = %d AND VecPair = %d AND PO = %d;", chip_id, vecpair_id, PO_num);
+   GetStringsDataForRow(MAX_STRING_LEN, db, sql_command_str, &row_strings_struct);
+   if ( row_strings_struct.num_cols != 1 || sscanf(row_strings_struct.ColStringVals[0], "%f", &ave_val) != 1 )
+      { printf("ERROR: BenchExecAve(): Failed to fetch Ave for %d %d %d!\n", chip_id, vecpair_id, PO_num); exit(EXIT_FAILURE); }
+   FreeStringsDataForRow(&row_strings_struct);
+
+   return ave_val/16.0;
+   }
+
+static int BenchExecRiseFall(sqlite3 *db, int vecpair_id)
+   {
+   SQLRowStringsStruct row_strings_struct;
+   char sql_command_str[MAX_STRING_LEN];
+   int rise_or_fall;
+
+   sprintf(sql_command_str, "SELECT R_F_str FROM VecPairs WHERE id = %d;", vecpair_id);
+   GetStringsDataForRow(MAX_STRING_LEN, db, sql_command_str, &row_strings_struct);
+   if ( row_strings_struct.num_cols != 1 )
+      { printf("ERROR: BenchExecRiseFall(): Failed to fetch R_F_str for %d!\n", vecpair_id); exit(EXIT_FAILURE); }
+   rise_or_fall = strcmp(row_strings_struct.ColStringVals[0], "R") == 0 ? 0 : 1;
+   FreeStringsDataForRow(&row_strings_struct);
+
+   return rise_or_fall;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Typed lookups with a statement compiled for each query.
+
+static float BenchPrepareAve(sqlite3 *db, int chip_id, int vecpair_id, int PO_num)
+   {
+   sqlite3_stmt *pStmt;
+   float ave_val;
+
+   if ( sqlite3_prepare_v2(db, SQL_TimingVals_get_Ave_cmd, -1, &pStmt, 0) != SQLITE_OK )
+      { printf("ERROR: BenchPrepareAve(): 'sqlite3_prepare_v2' failed: %s\n", sqlite3_errmsg(db)); exit(EXIT_FAILURE); }
+   SQLStmtBindInt(pStmt, 1, chip_id, "BenchPrepareAve()");
+   SQLStmtBindInt(pStmt, 2, vecpair_id, "BenchPrepareAve()");
+   SQLStmtBindInt(pStmt, 3, PO_num, "BenchPrepareAve()");
+   if ( SQLStmtStep(pStmt, "BenchPrepareAve()") == 0 )
+      { printf("ERROR: BenchPrepareAve(): Failed to fetch Ave for %d %d %d!\n", chip_id, vecpair_id, PO_num); exit(EXIT_FAILURE); }
+   ave_val = SQLStmtColumnFloat(pStmt, 0, "BenchPrepareAve()");
+   sqlite3_finalize(pStmt);
+
+   return ave_val/16.0;
+   }
+
+static int BenchPrepareRiseFall(sqlite3 *db, int vecpair_id)
+   {
+   sqlite3_stmt *pStmt;
+   char rise_fall_str[2];
+
+   if ( sqlite3_prepare_v2(db, SQL_VecPairs_get_R_F_str_cmd, -1, &pStmt, 0) != SQLITE_OK )
+      { printf("ERROR: BenchPrepareRiseFall(): 'sqlite3_prepare_v2' failed: %s\n", sqlite3_errmsg(db)); exit(EXIT_FAILURE); }
+   SQLStmtBindInt(pStmt, 1, vecpair_id, "BenchPrepareRiseFall()");
+   if ( SQLStmtStep(pStmt, "BenchPrepareRiseFall()") == 0 )
+      { printf("ERROR: BenchPrepareRiseFall(): Failed to fetch R_F_str for %d!\n", vecpair_id); exit(EXIT_FAILURE); }
+   SQLStmtColumnString(pStmt, 0, 1, 2, rise_fall_str, "BenchPrepareRiseFall()");
+   sqlite3_finalize(pStmt);
+
+   return rise_fall_str[0] == 'R' ? 0 : 1;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Run queries 'first_query' to 'last_query' - 1 in the thread's mode. Each query is one Ave lookup and one
+// R_F_str lookup.
+
+static void *BenchThread(void *arg)
+   {
+   BenchThreadStruct *BT_ptr = (BenchThreadStruct *)arg;
+   int query_num, chip_id, vecpair_id, PO_num;
+   double checksum;
+
+   checksum = 0.0;
+   for ( query_num = BT_ptr->first_query; query_num < BT_ptr->last_query; query_num++ )
+      {
+      chip_id = BT_ptr->chip_ids[query_num];
+      vecpair_id = BT_ptr->vecpair_ids[query_num];
+      PO_num = BT_ptr->PO_nums[query_num];
+      if ( BT_ptr->mode == BENCH_MODE_EXEC )
+         checksum += BenchExecAve(BT_ptr->db, chip_id, vecpair_id, PO_num) + BenchExecRiseFall(BT_ptr->db, vecpair_id);
+      else if ( BT_ptr->mode == BENCH_MODE_PREPARE )
+         checksum += BenchPrepareAve(BT_ptr->db, chip_id, vecpair_id, PO_num) + BenchPrepareRiseFall(BT_ptr->db, vecpair_id);
+      else
+         checksum += GetTimingValsAveField(MAX_STRING_LEN, BT_ptr->db, chip_id, vecpair_id, PO_num) +
+            GetVecPairsRiseFallStrField(MAX_STRING_LEN, BT_ptr->db, vecpair_id);
+      }
+   BT_ptr->checksum = checksum;
+
+   return NULL;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Run all queries in 'mode' split across 'num_threads' threads. Returns the elapsed time in microseconds and
+// the sum of the thread checksums in 'checksum_ptr'.
+
+static double BenchRun(sqlite3 *db, int mode, int num_threads, int num_queries, int *chip_ids, int *vecpair_ids, int *PO_nums,
+   double *checksum_ptr)
+   {
+   BenchThreadStruct BT_arr[num_threads];
+   pthread_t threads[num_threads];
+   struct timeval t0, t1;
+   int thread_num;
+
+   for ( thread_num = 0; thread_num < num_threads; thread_num++ )
+      {
+      BT_arr[thread_num].db = db;
+      BT_arr[thread_num].mode = mode;
+      BT_arr[thread_num].first_query = (int)((long)num_queries*thread_num/num_threads);
+      BT_arr[thread_num].last_query = (int)((long)num_queries*(thread_num + 1)/num_threads);
+      BT_arr[thread_num].chip_ids = chip_ids;
+      BT_arr[thread_num].vecpair_ids = vecpair_ids;
+      BT_arr[thread_num].PO_nums = PO_nums;
+      }
+
+   gettimeofday(&t0, 0);
+   for ( thread_num = 0; thread_num < num_threads; thread_num++ )
+      if ( pthread_create(&(threads[thread_num]), NULL, BenchThread, (void *)&(BT_arr[thread_num])) != 0 )
+         { printf("ERROR: BenchRun(): Failed to create thread %d!\n", thread_num); exit(EXIT_FAILURE); }
+   for ( thread_num = 0; thread_num < num_threads; thread_num++ )
+      pthread_join(threads[thread_num], NULL);
+   gettimeofday(&t1, 0);
+
+   *checksum_ptr = 0.0;
+   for ( thread_num = 0; thread_num < num_threads; thread_num++ )
+      *checksum_ptr += BT_arr[thread_num].checksum;
+
+   return (double)((t1.tv_sec - t0.tv_sec)*1000000 + t1.tv_usec - t0.tv_usec);
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+
+int main(int argc, char *argv[])
+   {
+   int num_queries, num_threads, num_chips, num_vecpairs;
+
+   int *chip_ids, *vecpair_ids, *PO_nums;
+   int query_num, mode, thread_cnt_num, num_failed;
+   int thread_cnts[2];
+   double elapsed_us, checksum, ref_checksum[2], exec_us[2];
+   sqlite3 *db;
+
+   num_queries = 100000;
+   num_threads = 4;
+   num_chips = 32;
+   num_vecpairs = 256;
+   if ( argc > 1 )
+      num_queries = atoi(argv[1]);
+   if ( argc > 2 )
+      num_threads = atoi(argv[2]);
+   if ( argc > 3 )
+      num_chips = atoi(argv[3]);
+   if ( argc > 4 )
+      num_vecpairs = atoi(argv[4]);
+   if ( num_queries <= 0 || num_threads <= 0 || num_chips <= 0 || num_vecpairs <= 0 )
+      { printf("ERROR: main(): All parameters must be positive!\n"); exit(EXIT_FAILURE); }
+
+   db = BenchCreateDB(num_chips, num_vecpairs);
+
+   if ( (chip_ids = (int *)malloc(sizeof(int) * num_queries)) == NULL || (vecpair_ids = (int *)malloc(sizeof(int) * num_queries)) == NULL ||
+      (PO_nums = (int *)malloc(sizeof(int) * num_queries)) == NULL )
+      { printf("ERROR: main(): Failed to allocate the queries!\n"); exit(EXIT_FAILURE); }
+   for ( query_num = 0; query_num < num_queries; query_num++ )
+      {
+      chip_ids[query_num] = 1 + (int)(BenchRand() % num_chips);
+      vecpair_ids[query_num] = 1 + (int)(BenchRand() % num_vecpairs);
+      PO_nums[query_num] = (int)(BenchRand() % BENCH_NUM_POS);
+      }
+
+   printf("PARAMETERS: Queries %d\tThreads %d\tChips %d\tVecPairs %d\tTimingVals rows %d\n", num_queries, num_threads, num_chips, num_vecpairs,
+      num_chips*num_vecpairs*BENCH_NUM_POS); fflush(stdout);
+
+   thread_cnts[0] = 1;
+   thread_cnts[1] = num_threads;
+   num_failed = 0;
+   for ( mode = BENCH_MODE_EXEC; mode <= BENCH_MODE_CACHED; mode++ )
+      for ( thread_cnt_num = 0; thread_cnt_num < 2; thread_cnt_num++ )
+         {
+         elapsed_us = BenchRun(db, mode, thread_cnts[thread_cnt_num], num_queries, chip_ids, vecpair_ids, PO_nums, &checksum);
+         if ( mode == BENCH_MODE_EXEC )
+            {
+            ref_checksum[thread_cnt_num] = checksum;
+            exec_us[thread_cnt_num] = elapsed_us;
+            }
+         else if ( checksum != ref_checksum[thread_cnt_num] )
+            num_failed++;
+
+         printf("%-8s threads %2d\t%8.2f us/query\t%10.0f queries/s\tspeedup %5.2fx\tchecksum %.4f\n", Bench_mode_names[mode],
+            thread_cnts[thread_cnt_num], elapsed_us/num_queries, num_queries*1000000.0/elapsed_us, exec_us[thread_cnt_num]/elapsed_us, checksum);
+         fflush(stdout);
+         }
+
+   free(chip_ids);
+   free(vecpair_ids);
+   free(PO_nums);
+   SQLStmtCacheFinalize(db);
+   sqlite3_close(db);
+
+   if ( num_failed != 0 )
+      { printf("ERROR: main(): %d runs returned different values than 'exec'!\n", num_failed); exit(EXIT_FAILURE); }
+   printf("All modes returned the same values\n");
+
+   return 0;
+   }
@@ -0,0 +1,285 @@
+// ========================================================================================================
+// ========================================================================================================
+// ******************************************* srf_fixed_diff.c *******************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+//
+// Differential test of the fixed-point SRF engine (verifier_SRF_fixed.c) against the float engine in
+// verifier_regen_funcs.c. Each PNR/PNF set is run through both engines with random parameters (LFSR seeds,
+// RangeConstant, TrimCodeConstant, Threshold and SpreadFactors) and the mismatches are reported per stage.
+//
+// The stages the two engines MUST agree on exactly are checked with the same input to both: PND and its most
+// negative value, the bounded range, AddSpreadFactors() on the same PNDc and SingleHelpBitGen() on the same PNDco.
+// GPEVCal is the one stage that differs by design: the float version can truncate to the wrong side of a multiple
+// of 1/16, so PNDc may differ by 1/16 and no more. Those differences are counted, and so is their effect on the
+// end-to-end PNDco, helper data and strong bitstring, but they are not failures.
+//
+// With no files, 'num_trials' random PNR/PNF sets are used, one parameter set each. Recorded PNR/PNF pairs (the
+// PNR_Chip_*.xy and PNF_Chip_*.xy files DoSRFComp() writes to DumpDir) are each run with 'num_trials' parameter sets.
+//
+// Usage: srf_fixed_diff [num_trials] [PNR_file PNF_file ...]
+
+#include "common.h"
+#include "verifier_common.h"
+#include "verifier_regen_funcs.h"
+#include "verifier_SRF_fixed.h"
+
+static unsigned long long Test_rng_state = 0x2545F4914F6CDD1DULL;
+
+// Totals over all trials.
+typedef struct
+   {
+   int num_trials;
+   int num_errors;
+   int num_PNDc_trials;
+   long num_PNDc_diffs;
+   long num_PNDco_diffs;
+   long num_SHD_diffs;
+   long num_SBS_diffs;
+   int num_SBS_size_diffs;
+   } DiffTotalsStruct;
+
+
+// ========================================================================================================
+// ========================================================================================================
+// xorshift64 for the test data.
+
+static unsigned int TestRand()
+   {
+   Test_rng_state ^= Test_rng_state >> 12;
+   Test_rng_state ^= Test_rng_state << 25;
+   Test_rng_state ^= Test_rng_state >> 27;
+   return (unsigned int)((Test_rng_state * 0x2545F4914F6CDD1DULL) >> 32);
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Random PNs, multiples of 1/16 like the TimingVals Ave column. The spread is kept well under DIST_RANGE so the
+// PND fit in the bounded range histogram.
+
+static void GenRandomPNs(int num_PNs, float *PNs)
+   {
+   int PN_num;
+
+   for ( PN_num = 0; PN_num < num_PNs; PN_num++ )
+      PNs[PN_num] = (float)(300*SRF_FIXED_ONE + (int)(TestRand() % (400*SRF_FIXED_ONE)))/(float)SRF_FIXED_ONE;
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Read a PNR or PNF file written by DoSRFComp(), one '<index>\t<value>' line per PN.
+
+static void ReadPNFile(char *infilename, int num_PNs, float *PNs)
+   {
+   FILE *INFILE;
+   int PN_num, index;
+   float val;
+
+   if ( (INFILE = fopen(infilename, "r")) == NULL )
+      { printf("ERROR: ReadPNFile(): Data file '%s' open failed for reading!\n", infilename); exit(EXIT_FAILURE); }
+
+   for ( PN_num = 0; PN_num < num_PNs; PN_num++ )
+      {
+      if ( fscanf(INFILE, "%d %f", &index, &val) != 2 || index != PN_num )
+         { printf("ERROR: ReadPNFile(): '%s' has fewer than %d PNs or is out of order at %d!\n", infilename, num_PNs, PN_num); exit(EXIT_FAILURE); }
+      PNs[PN_num] = val;
+      }
+   fclose(INFILE);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Run one PNR/PNF set through both engines with random parameters. Returns the number of exact-match
+// violations, which are printed. 'label' identifies the set in the output.
+
+static int TestTrial(char *label, int num_PNDiffs, float *PNR, float *PNF, DiffTotalsStruct *totals)
+   {
+   int16_t PNR16[num_PNDiffs], PNF16[num_PNDiffs], SF16[num_PNDiffs], PNDx16[num_PNDiffs];
+   int16_t PND16[num_PNDiffs], PNDc16[num_PNDiffs], PNDco16[num_PNDiffs];
+   float fPND[num_PNDiffs], fPNDc[num_PNDiffs], fPNDco[num_PNDiffs], fSF[num_PNDiffs];
+   unsigned char SBS_float[num_PNDiffs/8], SHD_float[num_PNDiffs/8], SBS_fixed[num_PNDiffs/8], SHD_fixed[num_PNDiffs/8];
+   int LFSR_seed_low, LFSR_seed_high, RangeConstant, TrimCodeConstant;
+   unsigned short Threshold;
+   float largest_neg_PND;
+   int16_t largest_neg_PND16;
+   int range_float, range_fixed, num_SBS_float, num_SBS_fixed, HD_num_bytes;
+   int num_diffs, num_errors, diff, max_diff, num_SHD_diffs;
+   int PND_num;
+
+   LFSR_seed_low = (int)(TestRand() % num_PNDiffs);
+   LFSR_seed_high = (int)(TestRand() % num_PNDiffs);
+   RangeConstant = 128 + (int)(TestRand() % 128);
+   TrimCodeConstant = 20 + 2*(int)(TestRand() % 23);
+   Threshold = (unsigned short)(TestRand() % (THRESHOLD_CONSTANT + 2));
+   for ( PND_num = 0; PND_num < num_PNDiffs; PND_num++ )
+      fSF[PND_num] = (float)((int)(TestRand() % (2*TrimCodeConstant*SRF_FIXED_ONE + 1)) - TrimCodeConstant*SRF_FIXED_ONE)/
+         (float)SRF_FIXED_ONE;
+
+   SRFFixedLoadPNs(num_PNDiffs, PNR, PNR16);
+   SRFFixedLoadPNs(num_PNDiffs, PNF, PNF16);
+   SRFFixedLoadPNs(num_PNDiffs, fSF, SF16);
+
+   num_errors = 0;
+
+// PND and the most negative PND: exact subtractions in both engines.
+   largest_neg_PND = ComputePNDiffsTwoSeeds(num_PNDiffs, PNR, PNF, fPND, LFSR_seed_low, LFSR_seed_high);
+   largest_neg_PND16 = SRFFixedPNDiffsTwoSeeds(num_PNDiffs, PNR16, PNF16, PND16, LFSR_seed_low, LFSR_seed_high);
+   SRFFixedLoadPNs(num_PNDiffs, fPND, PNDx16);
+   num_diffs = 0;
+   for ( PND_num = 0; PND_num < num_PNDiffs; PND_num++ )
+      if ( PNDx16[PND_num] != PND16[PND_num] )
+         num_diffs++;
+   if ( num_diffs != 0 || largest_neg_PND*(float)SRF_FIXED_ONE != (float)largest_neg_PND16 )
+      {
+      printf("\t%s: seeds %d/%d: %d PND differ, largest negative PND %.4f -- %d/16!\n", label, LFSR_seed_low, LFSR_seed_high,
+         num_diffs, largest_neg_PND, largest_neg_PND16);
+      num_errors++;
+      }
+
+// Bounded range on the same PND.
+   range_float = ComputeBoundedRange(num_PNDiffs, fPND, RANGE_LOW_LIMIT, RANGE_HIGH_LIMIT, DIST_RANGE, largest_neg_PND);
+   range_fixed = SRFFixedBoundedRange(num_PNDiffs, PND16, RANGE_LOW_LIMIT, RANGE_HIGH_LIMIT, DIST_RANGE, largest_neg_PND16);
+   if ( range_float != range_fixed )
+      {
+      printf("\t%s: seeds %d/%d: bounded range %d -- %d!\n", label, LFSR_seed_low, LFSR_seed_high, range_float, range_fixed);
+      num_errors++;
+      }
+
+// GPEVCal. The float truncation can land 1/16 off.
+   GPEVCal(num_PNDiffs, fPND, fPNDc, RANGE_LOW_LIMIT, RANGE_HIGH_LIMIT, DIST_RANGE, RangeConstant, largest_neg_PND);
+   SRFFixedGPEVCal(num_PNDiffs, PND16, PNDc16, RANGE_LOW_LIMIT, RANGE_HIGH_LIMIT, DIST_RANGE, RangeConstant, largest_neg_PND16);
+   SRFFixedLoadPNs(num_PNDiffs, fPNDc, PNDx16);
+   num_diffs = max_diff = 0;
+   for ( PND_num = 0; PND_num < num_PNDiffs; PND_num++ )
+      if ( (diff = abs((int)PNDx16[PND_num] - (int)PNDc16[PND_num])) != 0 )
+         {
+         num_diffs++;
+         if ( max_diff < diff )
+            max_diff = diff;
+         }
+   if ( num_diffs != 0 )
+      {
+      totals->num_PNDc_trials++;
+      totals->num_PNDc_diffs += num_diffs;
+      }
+   if ( max_diff > 1 )
+      {
+      printf("\t%s: RangeConstant %d: %d PNDc differ, max %d/16!\n", label, RangeConstant, num_diffs, max_diff);
+      num_errors++;
+      }
+
+// End-to-end: each engine carries on from its own PNDc.
+   AddSpreadFactors(num_PNDiffs, fPNDc, fPNDco, fSF, TrimCodeConstant, 0);
+   SRFFixedAddSpreadFactors(num_PNDiffs, PNDc16, PNDco16, SF16, TrimCodeConstant);
+   num_SBS_float = SingleHelpBitGen(num_PNDiffs, fPNDco, SBS_float, SHD_float, &HD_num_bytes, Threshold);
+   num_SBS_fixed = SRFFixedHelpBitGen(num_PNDiffs, PNDco16, SBS_fixed, SHD_fixed, Threshold);
+   SRFFixedLoadPNs(num_PNDiffs, fPNDco, PNDx16);
+   for ( PND_num = 0; PND_num < num_PNDiffs; PND_num++ )
+      if ( PNDx16[PND_num] != PNDco16[PND_num] )
+         totals->num_PNDco_diffs++;
+   totals->num_SHD_diffs += BitStringCountMismatches(SHD_float, 0, SHD_fixed, 0, num_PNDiffs);
+   if ( num_SBS_float != num_SBS_fixed )
+      totals->num_SBS_size_diffs++;
+   else if ( num_SBS_float > 0 )
+      totals->num_SBS_diffs += BitStringCountMismatches(SBS_float, 0, SBS_fixed, 0, num_SBS_float);
+
+// AddSpreadFactors on the SAME PNDc (the fixed-point one) MUST match.
+   SRFFixedToFloat(num_PNDiffs, PNDc16, fPNDc);
+   AddSpreadFactors(num_PNDiffs, fPNDc, fPNDco, fSF, TrimCodeConstant, 0);
+   SRFFixedLoadPNs(num_PNDiffs, fPNDco, PNDx16);
+   num_diffs = 0;
+   for ( PND_num = 0; PND_num < num_PNDiffs; PND_num++ )
+      if ( PNDx16[PND_num] != PNDco16[PND_num] )
+         num_diffs++;
+   if ( num_diffs != 0 )
+      {
+      printf("\t%s: TrimCodeConstant %d: %d PNDco differ for the same PNDc!\n", label, TrimCodeConstant, num_diffs);
+      num_errors++;
+      }
+
+// SingleHelpBitGen on the SAME PNDco MUST match.
+   SRFFixedToFloat(num_PNDiffs, PNDco16, fPNDco);
+   num_SBS_float = SingleHelpBitGen(num_PNDiffs, fPNDco, SBS_float, SHD_float, &HD_num_bytes, Threshold);
+   num_SHD_diffs = BitStringCountMismatches(SHD_float, 0, SHD_fixed, 0, num_PNDiffs);
+   num_diffs = 0;
+   if ( num_SBS_float == num_SBS_fixed && num_SBS_float > 0 )
+      num_diffs = BitStringCountMismatches(SBS_float, 0, SBS_fixed, 0, num_SBS_float);
+   if ( num_SHD_diffs != 0 || num_SBS_float != num_SBS_fixed || num_diffs != 0 )
+      {
+      printf("\t%s: Threshold %u: SHD diffs %d\tSBS diffs %d (sizes %d/%d) for the same PNDco!\n", label, Threshold, num_SHD_diffs,
+         num_diffs, num_SBS_float, num_SBS_fixed);
+      num_errors++;
+      }
+
+   totals->num_trials++;
+   totals->num_errors += num_errors;
+
+   return num_errors;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+
+int main(int argc, char *argv[])
+   {
+   int num_trials;
+
+   int num_PNDiffs = NUM_REQUIRED_PNDIFFS;
+   float PNR[NUM_REQUIRED_PNDIFFS], PNF[NUM_REQUIRED_PNDIFFS];
+   DiffTotalsStruct totals;
+   char label[MAX_STRING_LEN];
+   int trial_num, file_num;
+
+   num_trials = 200;
+   if ( argc > 1 )
+      num_trials = atoi(argv[1]);
+   if ( num_trials <= 0 || (argc > 2 && (argc % 2) != 0) )
+      { printf("Usage: srf_fixed_diff [num_trials] [PNR_file PNF_file ...]\n"); exit(EXIT_FAILURE); }
+
+   memset(&totals, 0, sizeof(DiffTotalsStruct));
+
+// Random PNs, a new set every trial.
+   if ( argc <= 2 )
+      for ( trial_num = 0; trial_num < num_trials; trial_num++ )
+         {
+         GenRandomPNs(num_PNDiffs, PNR);
+         GenRandomPNs(num_PNDiffs, PNF);
+         sprintf(label, "Random set %d", trial_num);
+         TestTrial(label, num_PNDiffs, PNR, PNF, &totals);
+         }
+
+// Recorded PNs, 'num_trials' parameter sets for each pair.
+   for ( file_num = 2; file_num + 1 < argc; file_num += 2 )
+      {
+      ReadPNFile(argv[file_num], num_PNDiffs, PNR);
+      ReadPNFile(argv[file_num + 1], num_PNDiffs, PNF);
+      snprintf(label, MAX_STRING_LEN, "%s", argv[file_num]);
+      for ( trial_num = 0; trial_num < num_trials; trial_num++ )
+         TestTrial(label, num_PNDiffs, PNR, PNF, &totals);
+      }
+
+   printf("Trials %d\tPNDc differ in %d trials (%ld values)\tEnd-to-end: PNDco diffs %ld\tSHD diffs %ld\tSBS diffs %ld\tSBS size diffs %d\n",
+      totals.num_trials, totals.num_PNDc_trials, totals.num_PNDc_diffs, totals.num_PNDco_diffs, totals.num_SHD_diffs,
+      totals.num_SBS_diffs, totals.num_SBS_size_diffs);
+
+   if ( totals.num_errors != 0 )
+      { printf("ERROR: main(): %d mismatches between the float and fixed-point engines!\n", totals.num_errors); exit(EXIT_FAILURE); }
+   printf("All tests PASSED\n");
+
+   return 0;
+   }
@@ -0,0 +1,489 @@
+// ========================================================================================================
+// ========================================================================================================
+// ****************************************** stats_writer_test.c *****************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+//
+// Multi-threaded test of the asynchronous stats writer (verifier_stats_writer.c) with STATS_WRITER_BLOCK. Several
+// producer threads, one per ring, add a header line and a bitstring of up to TEST_MAX_BITS bits (split across up to
+// 6 records) per entry to a shared file, and a line per entry to a second file that thread 0 truncates ('create')
+// halfway through. The first bits of each bitstring encode its thread and entry, and the rest are generated from them.
+// StatsWriterShutdown() is called as soon as the producers are done, so the last records are written by its final
+// drain. Three runs:
+//
+//    Free-running: the producers add concurrently. Every line of both files MUST be complete and exact, each
+//    thread's entries MUST appear in the order they were added and none MAY be missing (after the create for the
+//    second file).
+//    Serialized: the producers add under a test mutex, which fixes the seq order, and a transcript of the expected
+//    file contents is kept. The files MUST match the transcripts byte for byte.
+//    At shutdown: as serialized, with few entries and a flush interval longer than the run, so every record is
+//    still in the rings when StatsWriterShutdown() is called.
+//
+// In every run every record MUST be written, none dropped, and an add after StatsWriterShutdown() MUST be rejected.
+//
+// A producer preempted between taking its seq and publishing its record is rare in these runs, so the hold-back
+// check creates one: the test takes a seq on ring 0 the way StatsWriterPrintf() does but publishes the record only
+// after a record on ring 1 has been added and several flush intervals have passed. Nothing MAY be written before
+// the publish, and the file MUST then hold the two lines in seq order.
+//
+// Usage: stats_writer_test [num_entries]
+
+#include "common.h"
+#include "verifier_common.h"
+#include "verifier_stats_writer.h"
+
+extern int usleep (__useconds_t __useconds);
+
+#define TEST_NUM_PRODUCERS 8
+#define TEST_MAX_BITS 3000
+#define TEST_MAX_LINE_LEN (TEST_MAX_BITS + 64)
+
+typedef struct
+   {
+   StatsWriterStruct *SW_ptr;
+   int thread_num;
+   int num_entries;
+   int serialized;
+   char *bitstring_file;
+   char *line_file;
+   } ProducerStruct;
+
+// Transcripts of the serialized run, appended under Test_mutex.
+static pthread_mutex_t Test_mutex = PTHREAD_MUTEX_INITIALIZER;
+static char *Expected_bitstring_file;
+static int Expected_bitstring_len;
+static char *Expected_line_file;
+static int Expected_line_len;
+
+
+// ========================================================================================================
+// ========================================================================================================
+// xorshift64 step.
+
+static unsigned int TestRand(unsigned long long *state_ptr)
+   {
+   *state_ptr ^= *state_ptr >> 12;
+   *state_ptr ^= *state_ptr << 25;
+   *state_ptr ^= *state_ptr >> 27;
+   return (unsigned int)((*state_ptr * 0x2545F4914F6CDD1DULL) >> 32);
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// The bitstring of entry 'entry_num' of 'thread_num'. The first 16 bits hold the thread number and the next 16 the
+// entry number, low order bit first, and the length and the remaining bits follow from them. Returns the number of bits.
+
+static int MakeBitstring(int thread_num, int entry_num, unsigned char *bitstring)
+   {
+   unsigned long long state;
+   int num_bits, bit_num;
+
+   state = 0x9E3779B97F4A7C15ULL ^ ((unsigned long long)(thread_num + 1) << 32) ^ (unsigned long long)(entry_num + 1);
+   num_bits = 32 + (int)(TestRand(&state) % (TEST_MAX_BITS - 31));
+   memset(bitstring, 0, (num_bits + 7)/8);
+   for ( bit_num = 0; bit_num < num_bits; bit_num++ )
+      {
+      if ( bit_num < 16 )
+         SetBitInByte(&(bitstring[bit_num/8]), (thread_num >> bit_num) & 1, bit_num % 8);
+      else if ( bit_num < 32 )
+         SetBitInByte(&(bitstring[bit_num/8]), (entry_num >> (bit_num - 16)) & 1, bit_num % 8);
+      else
+         SetBitInByte(&(bitstring[bit_num/8]), TestRand(&state) & 1, bit_num % 8);
+      }
+
+   return num_bits;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// The ASCII line StatsWriterBitstring() writes for a bitstring, with the newline. Returns its length.
+
+static int BitstringToLine(int num_bits, unsigned char *bitstring, char *line)
+   {
+   int bit_num;
+
+   for ( bit_num = 0; bit_num < num_bits; bit_num++ )
+      line[bit_num] = '0' + GetBitFromByte(bitstring[bit_num/8], bit_num % 8);
+   line[num_bits] = '\n';
+   line[num_bits + 1] = '\0';
+
+   return num_bits + 1;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Number of records StatsWriterBitstring() uses for a bitstring.
+
+static int NumBitstringRecords(int num_bits)
+   {
+   return (num_bits + 1 + STATS_WRITER_MAX_TEXT_LEN - 2)/(STATS_WRITER_MAX_TEXT_LEN - 1);
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Producer thread. Each entry is a header and a bitstring for the first file and a line for the second one, which
+// thread 0 creates at the middle entry. In the serialized run each add and its transcript update are done under
+// Test_mutex.
+
+static void *ProducerThread(void *arg)
+   {
+   ProducerStruct *PS_ptr = (ProducerStruct *)arg;
+   unsigned char bitstring[(TEST_MAX_BITS + 7)/8];
+   char line[TEST_MAX_LINE_LEN];
+   int entry_num, num_bits, create, line_len;
+
+   for ( entry_num = 0; entry_num < PS_ptr->num_entries; entry_num++ )
+      {
+      num_bits = MakeBitstring(PS_ptr->thread_num, entry_num, bitstring);
+      create = (PS_ptr->thread_num == 0 && entry_num == PS_ptr->num_entries/2);
+
+      if ( PS_ptr->serialized == 1 )
+         pthread_mutex_lock(&Test_mutex);
+      StatsWriterPrintf(PS_ptr->SW_ptr, PS_ptr->thread_num, PS_ptr->bitstring_file, 0, "T %d E %d\n", PS_ptr->thread_num, entry_num);
+      if ( PS_ptr->serialized == 1 )
+         {
+         Expected_bitstring_len += sprintf(Expected_bitstring_file + Expected_bitstring_len, "T %d E %d\n", PS_ptr->thread_num, entry_num);
+         pthread_mutex_unlock(&Test_mutex);
+         pthread_mutex_lock(&Test_mutex);
+         }
+
+      StatsWriterBitstring(PS_ptr->SW_ptr, PS_ptr->thread_num, PS_ptr->bitstring_file, 0, num_bits, bitstring);
+      if ( PS_ptr->serialized == 1 )
+         {
+         line_len = BitstringToLine(num_bits, bitstring, line);
+         memcpy(Expected_bitstring_file + Expected_bitstring_len, line, line_len + 1);
+         Expected_bitstring_len += line_len;
+         pthread_mutex_unlock(&Test_mutex);
+         pthread_mutex_lock(&Test_mutex);
+         }
+
+      StatsWriterPrintf(PS_ptr->SW_ptr, PS_ptr->thread_num, PS_ptr->line_file, create, "L %d E %d\n", PS_ptr->thread_num, entry_num);
+      if ( PS_ptr->serialized == 1 )
+         {
+         if ( create == 1 )
+            Expected_line_len = 0;
+         Expected_line_len += sprintf(Expected_line_file + Expected_line_len, "L %d E %d\n", PS_ptr->thread_num, entry_num);
+         pthread_mutex_unlock(&Test_mutex);
+         }
+      }
+
+   return NULL;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Read a whole file into an allocated, NUL-terminated buffer. Returns its length.
+
+static int ReadFile(char *file_name, char **text_ptr)
+   {
+   FILE *INFILE;
+   long file_len;
+
+   if ( (INFILE = fopen(file_name, "r")) == NULL )
+      { printf("ERROR: ReadFile(): Could not open '%s'!\n", file_name); exit(EXIT_FAILURE); }
+   fseek(INFILE, 0, SEEK_END);
+   file_len = ftell(INFILE);
+   fseek(INFILE, 0, SEEK_SET);
+   if ( (*text_ptr = (char *)malloc(file_len + 1)) == NULL )
+      { printf("ERROR: ReadFile(): Failed to allocate storage for '%s'!\n", file_name); exit(EXIT_FAILURE); }
+   if ( fread(*text_ptr, 1, file_len, INFILE) != (size_t)file_len )
+      { printf("ERROR: ReadFile(): Failed to read '%s'!\n", file_name); exit(EXIT_FAILURE); }
+   (*text_ptr)[file_len] = '\0';
+   fclose(INFILE);
+
+   return (int)file_len;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Check the free-running run. Every line of the bitstring file MUST be a header followed, for the same thread, by
+// its exact bitstring (other threads' lines may come in between) and every entry MUST be there in order. In the line
+// file thread 0 MUST start with its create line, and every thread's lines MUST be consecutive entries ending with the
+// last one. Returns the number of errors.
+
+static int CheckFreeRunning(char *bitstring_file, char *line_file, int num_entries)
+   {
+   int next_entry[TEST_NUM_PRODUCERS], header_seen[TEST_NUM_PRODUCERS];
+   unsigned char bitstring[(TEST_MAX_BITS + 7)/8];
+   char expected_line[TEST_MAX_LINE_LEN];
+   char *text, *line, *line_end;
+   int thread_num, entry_num, num_bits, line_len, bit_num, first_line, num_errors;
+
+   num_errors = 0;
+   for ( thread_num = 0; thread_num < TEST_NUM_PRODUCERS; thread_num++ )
+      {
+      next_entry[thread_num] = 0;
+      header_seen[thread_num] = 0;
+      }
+
+   ReadFile(bitstring_file, &text);
+   for ( line = text; *line != '\0' && num_errors < 10; line = line_end + 1 )
+      {
+      if ( (line_end = strchr(line, '\n')) == NULL )
+         { printf("\tBitstring file: truncated last line!\n"); num_errors++; break; }
+      line_len = (int)(line_end - line) + 1;
+
+      if ( sscanf(line, "T %d E %d", &thread_num, &entry_num) == 2 )
+         {
+         if ( thread_num < 0 || thread_num >= TEST_NUM_PRODUCERS || entry_num != next_entry[thread_num] || header_seen[thread_num] == 1 )
+            { printf("\tBitstring file: header 'T %d E %d' out of order!\n", thread_num, entry_num); num_errors++; continue; }
+         header_seen[thread_num] = 1;
+         continue;
+         }
+
+// A bitstring line. Decode its thread and entry and compare it with the expected bitstring.
+      if ( line_len < 33 )
+         { printf("\tBitstring file: short line of %d characters!\n", line_len); num_errors++; continue; }
+      thread_num = entry_num = 0;
+      for ( bit_num = 0; bit_num < 16; bit_num++ )
+         {
+         thread_num |= (line[bit_num] == '1') << bit_num;
+         entry_num |= (line[16 + bit_num] == '1') << bit_num;
+         }
+      if ( thread_num >= TEST_NUM_PRODUCERS || entry_num != next_entry[thread_num] || header_seen[thread_num] == 0 )
+         { printf("\tBitstring file: bitstring of thread %d entry %d out of order!\n", thread_num, entry_num); num_errors++; continue; }
+      num_bits = MakeBitstring(thread_num, entry_num, bitstring);
+      if ( BitstringToLine(num_bits, bitstring, expected_line) != line_len || memcmp(line, expected_line, line_len) != 0 )
+         { printf("\tBitstring file: bitstring of thread %d entry %d is corrupt or truncated!\n", thread_num, entry_num); num_errors++; }
+      header_seen[thread_num] = 0;
+      next_entry[thread_num]++;
+      }
+   free(text);
+
+   for ( thread_num = 0; thread_num < TEST_NUM_PRODUCERS; thread_num++ )
+      if ( next_entry[thread_num] != num_entries || header_seen[thread_num] == 1 )
+         { printf("\tBitstring file: thread %d has %d of %d entries!\n", thread_num, next_entry[thread_num], num_entries); num_errors++; }
+
+// Line file. The lines before thread 0's create are gone, so each other thread starts at some entry.
+   for ( thread_num = 0; thread_num < TEST_NUM_PRODUCERS; thread_num++ )
+      next_entry[thread_num] = -1;
+   next_entry[0] = num_entries/2;
+
+   ReadFile(line_file, &text);
+   first_line = 1;
+   for ( line = text; *line != '\0' && num_errors < 10; line = line_end + 1 )
+      {
+      if ( (line_end = strchr(line, '\n')) == NULL )
+         { printf("\tLine file: truncated last line!\n"); num_errors++; break; }
+      if ( sscanf(line, "L %d E %d", &thread_num, &entry_num) != 2 || thread_num < 0 || thread_num >= TEST_NUM_PRODUCERS )
+         { printf("\tLine file: corrupt line!\n"); num_errors++; continue; }
+      if ( first_line == 1 && (thread_num != 0 || entry_num != num_entries/2) )
+         { printf("\tLine file: does not start with the create line of thread 0!\n"); num_errors++; }
+      first_line = 0;
+      if ( next_entry[thread_num] != -1 && entry_num != next_entry[thread_num] )
+         { printf("\tLine file: line 'L %d E %d' out of order!\n", thread_num, entry_num); num_errors++; }
+      next_entry[thread_num] = entry_num + 1;
+      }
+   free(text);
+
+   for ( thread_num = 0; thread_num < TEST_NUM_PRODUCERS; thread_num++ )
+      if ( next_entry[thread_num] != num_entries )
+         { printf("\tLine file: thread %d ends at entry %d of %d!\n", thread_num, next_entry[thread_num], num_entries); num_errors++; }
+
+   return num_errors;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Compare a file with its transcript. Returns the number of errors.
+
+static int CheckTranscript(char *file_name, char *expected, int expected_len)
+   {
+   char *text;
+   int text_len, char_num;
+
+   text_len = ReadFile(file_name, &text);
+   for ( char_num = 0; char_num < text_len && char_num < expected_len; char_num++ )
+      if ( text[char_num] != expected[char_num] )
+         break;
+   free(text);
+
+   if ( char_num != text_len || text_len != expected_len )
+      {
+      printf("\t'%s': %d characters, expected %d, first difference at %d!\n", file_name, text_len, expected_len, char_num);
+      return 1;
+      }
+   return 0;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// One run: start the writer, run the producers, shut down right away and check the files and counts. Returns the
+// number of errors.
+
+static int RunProducers(char *dir_name, int num_entries, int serialized, int flush_interval_ms)
+   {
+   StatsWriterStruct SW;
+   ProducerStruct PS[TEST_NUM_PRODUCERS];
+   pthread_t threads[TEST_NUM_PRODUCERS];
+   unsigned char bitstring[(TEST_MAX_BITS + 7)/8];
+   char bitstring_file[MAX_STRING_LEN], line_file[MAX_STRING_LEN];
+   unsigned long num_written, num_dropped, num_unused, num_records;
+   int thread_num, entry_num, num_errors;
+
+   sprintf(bitstring_file, "%s/bitstrings.txt", dir_name);
+   sprintf(line_file, "%s/lines.txt", dir_name);
+   remove(bitstring_file);
+   remove(line_file);
+   Expected_bitstring_len = 0;
+   Expected_line_len = 0;
+
+   StatsWriterInit(&SW, TEST_NUM_PRODUCERS, STATS_WRITER_BLOCK, flush_interval_ms);
+   for ( thread_num = 0; thread_num < TEST_NUM_PRODUCERS; thread_num++ )
+      {
+      PS[thread_num].SW_ptr = &SW;
+      PS[thread_num].thread_num = thread_num;
+      PS[thread_num].num_entries = num_entries;
+      PS[thread_num].serialized = serialized;
+      PS[thread_num].bitstring_file = bitstring_file;
+      PS[thread_num].line_file = line_file;
+      if ( pthread_create(&(threads[thread_num]), NULL, ProducerThread, (void *)&(PS[thread_num])) != 0 )
+         { printf("ERROR: RunProducers(): Failed to create producer %d!\n", thread_num); exit(EXIT_FAILURE); }
+      }
+   for ( thread_num = 0; thread_num < TEST_NUM_PRODUCERS; thread_num++ )
+      pthread_join(threads[thread_num], NULL);
+
+// Records are only dropped by the producers, so the count is final here. The rings are gone after the shutdown.
+   StatsWriterGetCounts(&SW, &num_unused, &num_dropped);
+   StatsWriterShutdown(&SW);
+   StatsWriterPrintf(&SW, 0, line_file, 1, "LATE\n");
+
+   num_errors = 0;
+   if ( serialized == 1 )
+      {
+      num_errors += CheckTranscript(bitstring_file, Expected_bitstring_file, Expected_bitstring_len);
+      num_errors += CheckTranscript(line_file, Expected_line_file, Expected_line_len);
+      }
+   else
+      num_errors += CheckFreeRunning(bitstring_file, line_file, num_entries);
+
+   num_records = 0;
+   for ( thread_num = 0; thread_num < TEST_NUM_PRODUCERS; thread_num++ )
+      for ( entry_num = 0; entry_num < num_entries; entry_num++ )
+         num_records += 2 + NumBitstringRecords(MakeBitstring(thread_num, entry_num, bitstring));
+   StatsWriterGetCounts(&SW, &num_written, &num_unused);
+
+   if ( num_written != num_records || num_dropped != 0 )
+      { printf("\t%lu records written and %lu dropped, expected %lu and 0!\n", num_written, num_dropped, num_records); num_errors++; }
+   if ( SW.num_rejected != 1 )
+      { printf("\t%lu adds rejected after shutdown, expected 1!\n", SW.num_rejected); num_errors++; }
+
+   remove(bitstring_file);
+   remove(line_file);
+
+   return num_errors;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// The hold-back check. The record on ring 0 is filled in and published exactly as in StatsWriterPrintf(), with the
+// 'num_active' count left out since no shutdown happens while it is held. Returns the number of errors.
+
+static int CheckHoldBack(char *dir_name)
+   {
+   StatsWriterStruct SW;
+   StatsRingStruct *ring_ptr;
+   StatsRecordStruct *rec_ptr;
+   char outfile_name[STATS_WRITER_MAX_NAME_LEN];
+   char *expected = "FIRST\nSECOND\n";
+   FILE *INFILE;
+   int num_errors;
+
+   snprintf(outfile_name, STATS_WRITER_MAX_NAME_LEN, "%s/hold_back.txt", dir_name);
+   remove(outfile_name);
+
+   StatsWriterInit(&SW, 2, STATS_WRITER_BLOCK, 1);
+
+   ring_ptr = &(SW.rings[0]);
+   rec_ptr = &(ring_ptr->records[ring_ptr->head % STATS_WRITER_RING_SIZE]);
+   rec_ptr->seq_num = __atomic_fetch_add(&(SW.next_seq_num), 1, __ATOMIC_RELAXED);
+   rec_ptr->create = 0;
+   snprintf(rec_ptr->outfile_name, STATS_WRITER_MAX_NAME_LEN, "%s", outfile_name);
+   snprintf(rec_ptr->text, STATS_WRITER_MAX_TEXT_LEN, "FIRST\n");
+
+   StatsWriterPrintf(&SW, 1, outfile_name, 0, "SECOND\n");
+   usleep(50*1000);
+
+   num_errors = 0;
+   if ( (INFILE = fopen(outfile_name, "r")) != NULL )
+      {
+      printf("\tThe record after an unpublished seq was written before it!\n");
+      fclose(INFILE);
+      num_errors++;
+      }
+
+   __atomic_store_n(&(ring_ptr->head), ring_ptr->head + 1, __ATOMIC_RELEASE);
+   StatsWriterShutdown(&SW);
+
+   num_errors += CheckTranscript(outfile_name, expected, (int)strlen(expected));
+   remove(outfile_name);
+
+   return num_errors;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+
+int main(int argc, char *argv[])
+   {
+   char dir_name[] = "/tmp/stats_writer_test.XXXXXX";
+   char *run_names[3] = {"Free-running", "Serialized", "At shutdown"};
+   int run_serialized[3] = {0, 1, 1};
+   int run_flush_interval_ms[3] = {5, 5, 1000};
+   int num_entries, run_num_entries, num_errors, run_errors, run_num;
+
+   num_entries = 400;
+   if ( argc > 1 )
+      num_entries = atoi(argv[1]);
+   if ( num_entries < 2 || num_entries > 65535 )
+      { printf("Usage: stats_writer_test [num_entries]\n"); exit(EXIT_FAILURE); }
+
+   if ( mkdtemp(dir_name) == NULL )
+      { printf("ERROR: main(): Failed to create a temporary directory!\n"); exit(EXIT_FAILURE); }
+
+   if ( (Expected_bitstring_file = (char *)malloc((size_t)TEST_NUM_PRODUCERS * num_entries * (TEST_MAX_LINE_LEN + 32))) == NULL ||
+      (Expected_line_file = (char *)malloc((size_t)TEST_NUM_PRODUCERS * num_entries * 32)) == NULL )
+      { printf("ERROR: main(): Failed to allocate storage for the transcripts!\n"); exit(EXIT_FAILURE); }
+
+// The 'At shutdown' entries MUST fit in a ring (at most 8 records each) so no producer waits for the flusher.
+   num_errors = 0;
+   for ( run_num = 0; run_num < 3; run_num++ )
+      {
+      run_num_entries = (run_num == 2) ? STATS_WRITER_RING_SIZE/8 : num_entries;
+      run_errors = RunProducers(dir_name, run_num_entries, run_serialized[run_num], run_flush_interval_ms[run_num]);
+      printf("%-12s\t%d producers\t%3d entries\tFlush interval %4d ms\t%s\n", run_names[run_num], TEST_NUM_PRODUCERS, run_num_entries,
+         run_flush_interval_ms[run_num], (run_errors == 0) ? "PASS" : "FAIL");
+      num_errors += run_errors;
+      }
+
+   run_errors = CheckHoldBack(dir_name);
+   printf("Hold-back   \t%s\n", (run_errors == 0) ? "PASS" : "FAIL");
+   num_errors += run_errors;
+
+   free(Expected_bitstring_file);
+   free(Expected_line_file);
+   rmdir(dir_name);
+
+   if ( num_errors != 0 )
+      { printf("ERROR: main(): %d checks FAILED!\n", num_errors); exit(EXIT_FAILURE); }
+   printf("All tests PASSED\n");
+
+   return 0;
+   }
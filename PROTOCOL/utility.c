@@ -13,6 +13,10 @@
 
 #include "utility.h"
 
+#if defined(__BMI2__) && defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 
 // ===========================================================================================================
 // ===========================================================================================================
@@ -58,13 +62,234 @@ int MedianCompareFunc(const void *v1, const void *v2)
 
 // ===========================================================================================================
 // ===========================================================================================================
-// Compute the median value by sorting and returning the value of the middle value.
+// Selection routines. SelectKthFloat() and SelectKthInt() partially reorder 'vals' in place so that vals[k] holds
+// the value it would have after a full ascending sort, with all values before it <= vals[k] and all values after 
+// it >= vals[k]. Quickselect with a median-of-three pivot, falling back to qsort() on the remaining sub-range if 
+// the partitions degrade (introselect), so the worst case is O(n log n) and the expected case O(n).
+
+int SelectDepthLimit(int num_vals)
+   {
+   int depth_limit = 0;
+
+   while ( num_vals > 1 )
+      {
+      num_vals >>= 1;
+      depth_limit += 2;
+      }
+   return depth_limit + 2;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// qsort: Ascending order for integers.
+
+int SelectIntCompareFunc(const void *v1, const void *v2)
+   {
+   if ( *(int *)v1 == *(int *)v2 )
+      return 0;
+   else if ( *(int *)v1 < *(int *)v2 )
+      return -1;
+   else 
+      return 1;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+
+float SelectKthFloat(int num_vals, float *vals, int k)
+   {
+   int left, right, mid, i, j, depth_limit;
+   float pivot, temp;
+
+   if ( k < 0 || k >= num_vals )
+      { printf("ERROR: SelectKthFloat(): k %d MUST be >= 0 and < num_vals %d!\n", k, num_vals); exit(EXIT_FAILURE); }
+
+   depth_limit = SelectDepthLimit(num_vals);
+   left = 0;
+   right = num_vals - 1;
+   while ( right > left )
+      {
+      if ( depth_limit-- == 0 )
+         {
+         qsort(&(vals[left]), right - left + 1, sizeof(float), MedianCompareFunc);
+         return vals[k];
+         }
+
+// Order vals[left], vals[mid] and vals[right], and use the middle one as the pivot. 
+      mid = left + (right - left)/2;
+      if ( vals[mid] < vals[left] ) 
+         { temp = vals[mid]; vals[mid] = vals[left]; vals[left] = temp; }
+      if ( vals[right] < vals[left] ) 
+         { temp = vals[right]; vals[right] = vals[left]; vals[left] = temp; }
+      if ( vals[right] < vals[mid] ) 
+         { temp = vals[right]; vals[right] = vals[mid]; vals[mid] = temp; }
+      pivot = vals[mid];
+
+// Hoare partition: afterwards vals[left..j] <= pivot and vals[i..right] >= pivot, with j < i.
+      i = left;
+      j = right;
+      while ( i <= j )
+         {
+         while ( vals[i] < pivot )
+            i++;
+         while ( vals[j] > pivot )
+            j--;
+         if ( i <= j )
+            {
+            temp = vals[i]; vals[i] = vals[j]; vals[j] = temp;
+            i++;
+            j--;
+            }
+         }
+
+      if ( k <= j )
+         right = j;
+      else if ( k >= i )
+         left = i;
+      else
+         break;
+      }
+
+   return vals[k];
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+
+int SelectKthInt(int num_vals, int *vals, int k)
+   {
+   int left, right, mid, i, j, depth_limit;
+   int pivot, temp;
+
+   if ( k < 0 || k >= num_vals )
+      { printf("ERROR: SelectKthInt(): k %d MUST be >= 0 and < num_vals %d!\n", k, num_vals); exit(EXIT_FAILURE); }
+
+   depth_limit = SelectDepthLimit(num_vals);
+   left = 0;
+   right = num_vals - 1;
+   while ( right > left )
+      {
+      if ( depth_limit-- == 0 )
+         {
+         qsort(&(vals[left]), right - left + 1, sizeof(int), SelectIntCompareFunc);
+         return vals[k];
+         }
+
+      mid = left + (right - left)/2;
+      if ( vals[mid] < vals[left] ) 
+         { temp = vals[mid]; vals[mid] = vals[left]; vals[left] = temp; }
+      if ( vals[right] < vals[left] ) 
+         { temp = vals[right]; vals[right] = vals[left]; vals[left] = temp; }
+      if ( vals[right] < vals[mid] ) 
+         { temp = vals[right]; vals[right] = vals[mid]; vals[mid] = temp; }
+      pivot = vals[mid];
+
+      i = left;
+      j = right;
+      while ( i <= j )
+         {
+         while ( vals[i] < pivot )
+            i++;
+         while ( vals[j] > pivot )
+            j--;
+         if ( i <= j )
+            {
+            temp = vals[i]; vals[i] = vals[j]; vals[j] = temp;
+            i++;
+            j--;
+            }
+         }
+
+      if ( k <= j )
+         right = j;
+      else if ( k >= i )
+         left = i;
+      else
+         break;
+      }
+
+   return vals[k];
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Return two order statistics, k_low < k_high, of 'vals' in one selection pass over the array plus one over the 
+// part below k_high. 'vals' is reordered.
+
+void SelectTwoInt(int num_vals, int *vals, int k_low, int k_high, int *low_val_ptr, int *high_val_ptr)
+   {
+   if ( k_low < 0 || k_low >= k_high )
+      { printf("ERROR: SelectTwoInt(): k_low %d MUST be >= 0 and < k_high %d!\n", k_low, k_high); exit(EXIT_FAILURE); }
+
+   *high_val_ptr = SelectKthInt(num_vals, vals, k_high);
+   *low_val_ptr = SelectKthInt(k_high, vals, k_low);
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Median of 'vals' computed in place, i.e., 'vals' is reordered. If even number, the average of the two middle 
+// values is returned, otherwise the middle value.
+
+float ComputeMedianInPlace(int num_vals, float *vals)
+   {
+   float upper, lower;
+   int i;
+
+   if ( num_vals == 0 )
+      { printf("ERROR: ComputeMedianInPlace(): Number of values MUST be > 0!\n"); exit(EXIT_FAILURE); }
+
+   upper = SelectKthFloat(num_vals, vals, num_vals/2);
+   if ( num_vals % 2 != 0 )
+      return upper;
+
+// After selection, the lower middle value is the largest of the values before the upper one.
+   lower = vals[0];
+   for ( i = 1; i < num_vals/2; i++ )
+      if ( vals[i] > lower )
+         lower = vals[i];
+
+   return (lower + upper)/2;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Compute the median of each column of a row-major set of 'num_rows' arrays of 'num_cols' values, e.g., the 
+// median of each PND across all chips. 'medians' gets 'num_cols' values.
+
+void ComputeColumnMedians(int num_rows, int num_cols, float **rows, float *medians)
+   {
+   int row_num, col_num;
+
+   if ( num_rows == 0 )
+      { printf("ERROR: ComputeColumnMedians(): Number of rows MUST be > 0!\n"); exit(EXIT_FAILURE); }
+
+// One value per row (chip), so the column copy is kept on the stack rather than the heap.
+   float column[num_rows];
+
+   for ( col_num = 0; col_num < num_cols; col_num++ )
+      {
+      for ( row_num = 0; row_num < num_rows; row_num++ )
+         column[row_num] = rows[row_num][col_num];
+      medians[col_num] = ComputeMedianInPlace(num_rows, column);
+      }
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Compute the median value by selecting the middle value(s) of a copy of the array. Numerically identical to 
+// sorting the copy and averaging the middle two values when 'num_vals' is even.
 
 float ComputeMedian(int num_vals, float *vals)
    {
    float *median_vals;
    float median;
-   int i;
 
    if ( num_vals == 0 )
       { printf("ERROR: ComputeMedian(): Number of values MUST be > 0!\n"); exit(EXIT_FAILURE); }
@@ -75,21 +300,12 @@ float ComputeMedian(int num_vals, float *vals)
    if ( (median_vals = (float *)malloc(num_vals*sizeof(float))) == NULL )
       { printf("ERROR: ComputeMedian(): Malloc FAILED!\n"); exit(EXIT_FAILURE); }
 
-// Copy  array to temporary array so we can sort it without disturbing the array passed in.
-   for ( i = 0; i < num_vals; i++ )
-      median_vals[i] = vals[i];
-
-   qsort(median_vals, num_vals, sizeof(float), MedianCompareFunc);
+// Copy  array to temporary array so we can reorder it without disturbing the array passed in.
+   memcpy(median_vals, vals, num_vals*sizeof(float));
 
-// If even number, compute average of two middle samples, otherwise return middle value;
-   if ( num_vals % 2 == 0 )
-      median = (median_vals[num_vals/2 - 1] + median_vals[num_vals/2])/2;
-   else
-      median = median_vals[num_vals/2];
+   median = ComputeMedianInPlace(num_vals, median_vals);
 
 #ifdef DEBUG
-   for ( i = 0; i < num_vals; i++ )
-      printf("\t%d) Median val %f\n", i, median_vals[i]);
    printf("MEDIAN => %f\n", median);
    fflush(stdout);
 #endif
@@ -143,6 +359,364 @@ void SetBitInByte(unsigned char *byte_ptr, int bit_val, int bit_pos)
    }
 
 
+// ===========================================================================================================
+// ===========================================================================================================
+// Word-level bitstring routines. Bitstrings are byte packed in the same order used by GetBitFromByte() and 
+// SetBitInByte(), i.e., bit i is stored in byte i/8 at position i % 8, so a little-endian 64-bit load of 8 
+// bytes returns 64 consecutive bits with the lowest numbered bit in the low order position. These let the 
+// helper data and nonce routines move up to 64 bits per operation instead of one.
+//
+// This routine returns 'num_bits' (1 to 64) bits starting at 'bit_pos' in the low order bits of the word. The 
+// remaining bits are zero. Only the bytes that hold the requested bits are read.
+
+uint64_t BitStringLoadBits(const unsigned char *bs, int bit_pos, int num_bits)
+   {
+   const unsigned char *byte_ptr;
+   int shift, num_bytes, i;
+   uint64_t word;
+
+   byte_ptr = bs + (bit_pos >> 3);
+   shift = bit_pos & 7;
+   num_bytes = (shift + num_bits + 7) >> 3;
+
+   if ( num_bytes >= 8 )
+      {
+      memcpy(&word, byte_ptr, 8);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+      word = __builtin_bswap64(word);
+#endif
+      }
+   else
+      {
+      word = 0;
+      for ( i = 0; i < num_bytes; i++ )
+         word |= (uint64_t)byte_ptr[i] << (8*i);
+      }
+   word >>= shift;
+
+// 64 bits that do NOT start on a byte boundary straddle 9 bytes.
+   if ( num_bytes == 9 )
+      word |= (uint64_t)byte_ptr[8] << (64 - shift);
+
+   if ( num_bits < 64 )
+      word &= ((uint64_t)1 << num_bits) - 1;
+
+   return word;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Overwrite 'num_bits' (1 to 64) bits starting at 'bit_pos' with the low order bits of 'bits'. All other bits
+// in the bytes touched are preserved.
+
+void BitStringStoreBits(unsigned char *bs, int bit_pos, int num_bits, uint64_t bits)
+   {
+   unsigned char *byte_ptr;
+   int shift, num_bytes, i;
+   uint64_t word, mask;
+
+   byte_ptr = bs + (bit_pos >> 3);
+   shift = bit_pos & 7;
+   num_bytes = (shift + num_bits + 7) >> 3;
+
+   mask = (num_bits < 64) ? ((uint64_t)1 << num_bits) - 1 : ~(uint64_t)0;
+   bits &= mask;
+
+   if ( num_bytes >= 8 )
+      {
+      memcpy(&word, byte_ptr, 8);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+      word = __builtin_bswap64(word);
+#endif
+      word = (word & ~(mask << shift)) | (bits << shift);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+      word = __builtin_bswap64(word);
+#endif
+      memcpy(byte_ptr, &word, 8);
+
+      if ( num_bytes == 9 )
+         byte_ptr[8] = (unsigned char)((byte_ptr[8] & ~(mask >> (64 - shift))) | (bits >> (64 - shift)));
+      }
+
+// Fewer than 8 bytes means shift + num_bits <= 56, so everything fits in the word.
+   else
+      {
+      word = 0;
+      for ( i = 0; i < num_bytes; i++ )
+         word |= (uint64_t)byte_ptr[i] << (8*i);
+      word = (word & ~(mask << shift)) | (bits << shift);
+      for ( i = 0; i < num_bytes; i++ )
+         byte_ptr[i] = (unsigned char)(word >> (8*i));
+      }
+
+   return;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Copy 'num_bits' bits from src_bs starting at 'src_bit_pos' into dest_bs starting at 'dest_bit_pos', 64 bits
+// at a time. The source and destination may be the same bitstring as long as dest_bit_pos <= src_bit_pos, i.e.,
+// bits are only ever moved toward position 0 (EliminatePackedBitsFromBS() relies on this).
+
+void BitStringCopyBits(unsigned char *dest_bs, int dest_bit_pos, const unsigned char *src_bs, int src_bit_pos, int num_bits)
+   {
+   int chunk;
+
+   while ( num_bits > 0 )
+      {
+      chunk = (num_bits < 64) ? num_bits : 64;
+      BitStringStoreBits(dest_bs, dest_bit_pos, chunk, BitStringLoadBits(src_bs, src_bit_pos, chunk));
+      dest_bit_pos += chunk;
+      src_bit_pos += chunk;
+      num_bits -= chunk;
+      }
+
+   return;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Zero 'num_bits' bits starting at 'bit_pos'.
+
+void BitStringClearBits(unsigned char *bs, int bit_pos, int num_bits)
+   {
+   int chunk;
+
+   while ( num_bits > 0 )
+      {
+      chunk = (num_bits < 64) ? num_bits : 64;
+      BitStringStoreBits(bs, bit_pos, chunk, 0);
+      bit_pos += chunk;
+      num_bits -= chunk;
+      }
+
+   return;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Portable parallel bit extract, the version BitStringExtractWord() uses without BMI2 (the ARM build and the 
+// default x86 build). Each run of consecutive 1's in the mask is moved with one shift. Always compiled so 
+// bitstring_test can check it in a -mbmi2 build too.
+
+uint64_t BitStringExtractWordPortable(uint64_t word, uint64_t mask)
+   {
+   uint64_t result, run_mask;
+   int start, run_len, out_pos;
+
+   result = 0;
+   out_pos = 0;
+   while ( mask != 0 )
+      {
+      start = __builtin_ctzll(mask);
+      run_len = (~(mask >> start) == 0) ? 64 : __builtin_ctzll(~(mask >> start));
+      run_mask = (run_len == 64) ? ~(uint64_t)0 : ((uint64_t)1 << run_len) - 1;
+      result |= ((word >> start) & run_mask) << out_pos;
+      out_pos += run_len;
+      mask &= ~(run_mask << start);
+      }
+   return result;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Parallel bit extract: gather the bits of 'word' at the positions where 'mask' is 1 and pack them into the low
+// order bits of the result, preserving their order. Uses the BMI2 PEXT instruction when the compiler targets it
+// (-mbmi2 or -march=native on x86), otherwise BitStringExtractWordPortable().
+
+uint64_t BitStringExtractWord(uint64_t word, uint64_t mask)
+   {
+#if defined(__BMI2__) && defined(__x86_64__)
+   return (uint64_t)_pext_u64(word, mask);
+#else
+   return BitStringExtractWordPortable(word, mask);
+#endif
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Masked compaction of a bitstring. The bits of src_bs at the positions where mask_bs is 1 (over the first 
+// 'num_bits' positions of both) are packed, in order, into dest_bs starting at 'dest_bit_pos'. Returns the number
+// of bits written, i.e., the number of 1's in the mask. This is how the strong bits are pulled out of a raw 
+// bitstring using the helper data.
+
+int BitStringExtractMasked(int num_bits, const unsigned char *src_bs, const unsigned char *mask_bs, unsigned char *dest_bs, 
+   int dest_bit_pos)
+   {
+   int bit_pos, chunk, num_set, num_extracted;
+   uint64_t mask_word;
+
+   num_extracted = 0;
+   for ( bit_pos = 0; bit_pos < num_bits; bit_pos += 64 )
+      {
+      chunk = (num_bits - bit_pos < 64) ? num_bits - bit_pos : 64;
+      if ( (mask_word = BitStringLoadBits(mask_bs, bit_pos, chunk)) == 0 )
+         continue;
+      num_set = __builtin_popcountll(mask_word);
+      BitStringStoreBits(dest_bs, dest_bit_pos + num_extracted, num_set, 
+         BitStringExtractWord(BitStringLoadBits(src_bs, bit_pos, chunk), mask_word));
+      num_extracted += num_set;
+      }
+
+   return num_extracted;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Count the number of positions where the 'num_bits' bits of bs1 starting at 'bit_pos1' differ from those of 
+// bs2 starting at 'bit_pos2' (the Hamming distance).
+
+int BitStringCountMismatches(const unsigned char *bs1, int bit_pos1, const unsigned char *bs2, int bit_pos2, int num_bits)
+   {
+   int chunk, num_mismatches;
+
+   num_mismatches = 0;
+   while ( num_bits > 0 )
+      {
+      chunk = (num_bits < 64) ? num_bits : 64;
+      num_mismatches += __builtin_popcountll(BitStringLoadBits(bs1, bit_pos1, chunk) ^ BitStringLoadBits(bs2, bit_pos2, chunk));
+      bit_pos1 += chunk;
+      bit_pos2 += chunk;
+      num_bits -= chunk;
+      }
+
+   return num_mismatches;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Same comparison as BitStringCountMismatches() but returns the offset (from bit_pos1/bit_pos2) of the first 
+// mismatching bit, or -1 if all 'num_bits' bits match.
+
+int BitStringFindFirstMismatch(const unsigned char *bs1, int bit_pos1, const unsigned char *bs2, int bit_pos2, int num_bits)
+   {
+   int chunk, offset;
+   uint64_t diff;
+
+   for ( offset = 0; offset < num_bits; offset += chunk )
+      {
+      chunk = (num_bits - offset < 64) ? num_bits - offset : 64;
+      diff = BitStringLoadBits(bs1, bit_pos1 + offset, chunk) ^ BitStringLoadBits(bs2, bit_pos2 + offset, chunk);
+      if ( diff != 0 )
+         return offset + __builtin_ctzll(diff);
+      }
+
+   return -1;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// XMR majority vote over packed words. copies_bs holds 'num_groups' groups of XMR consecutive bits starting at 
+// bit 0, and the majority value of group g is written to voted_bs at 'voted_bit_pos' + g. XMR MUST be odd so 
+// there are no ties. Groups are processed 64 at a time: copy c of each group is gathered into bit plane c with
+// a strided extract, and the majority is computed across the planes with a bit-sliced 'at least k of XMR' count.
+//
+// If num_minority_ptr is non-NULL, the number of copies that disagree with the majority is ADDED to it. If ref_bs
+// is also non-NULL, the number of copies that disagree with the reference bit for the group (ref_bs starting at 
+// 'ref_bit_pos') is ADDED to num_ref_mismatches_ptr. When the majority equals the reference bit that is the 
+// minority count, otherwise it is the complement, XMR - minority, as KEK_FSB_SKE() defines true minority bit flips.
+
+void BitStringMajorityVote(int XMR, int num_groups, const unsigned char *copies_bs, unsigned char *voted_bs, int voted_bit_pos, 
+   int *num_minority_ptr, const unsigned char *ref_bs, int ref_bit_pos, int *num_ref_mismatches_ptr)
+   {
+   uint64_t stride_masks[BITSTRING_MAX_XMR], planes[BITSTRING_MAX_XMR], at_least[BITSTRING_MAX_XMR/2 + 2];
+   uint64_t word, voted, valid_mask, ref_word;
+   int groups_per_word, majority, group_num, block_groups, sub_group, sub_groups;
+   int copy_num, group_cnt, k;
+
+   if ( XMR < 1 || XMR > BITSTRING_MAX_XMR || (XMR % 2) == 0 )
+      { printf("ERROR: BitStringMajorityVote(): XMR %d MUST be odd and between 1 and %d!\n", XMR, BITSTRING_MAX_XMR); exit(EXIT_FAILURE); }
+
+// Each 64-bit load covers 'groups_per_word' complete groups. stride_masks[c] selects copy c of each of them.
+   groups_per_word = 64/XMR;
+   for ( copy_num = 0; copy_num < XMR; copy_num++ )
+      {
+      stride_masks[copy_num] = 0;
+      for ( group_cnt = 0; group_cnt < groups_per_word; group_cnt++ )
+         stride_masks[copy_num] |= (uint64_t)1 << (group_cnt*XMR + copy_num);
+      }
+   majority = XMR/2 + 1;
+
+   for ( group_num = 0; group_num < num_groups; group_num += 64 )
+      {
+      block_groups = (num_groups - group_num < 64) ? num_groups - group_num : 64;
+      valid_mask = (block_groups < 64) ? ((uint64_t)1 << block_groups) - 1 : ~(uint64_t)0;
+
+// Transpose the block into XMR bit planes. Bits of the loaded word beyond the last group are zero.
+      for ( copy_num = 0; copy_num < XMR; copy_num++ )
+         planes[copy_num] = 0;
+      for ( sub_group = 0; sub_group < block_groups; sub_group += sub_groups )
+         {
+         sub_groups = (block_groups - sub_group < groups_per_word) ? block_groups - sub_group : groups_per_word;
+         word = BitStringLoadBits(copies_bs, (group_num + sub_group)*XMR, sub_groups*XMR);
+         for ( copy_num = 0; copy_num < XMR; copy_num++ )
+            planes[copy_num] |= BitStringExtractWord(word, stride_masks[copy_num]) << sub_group;
+         }
+
+// at_least[k] has a 1 for each group with at least k 1's among the planes seen so far.
+      at_least[0] = ~(uint64_t)0;
+      for ( k = 1; k <= majority; k++ )
+         at_least[k] = 0;
+      for ( copy_num = 0; copy_num < XMR; copy_num++ )
+         for ( k = (copy_num + 1 < majority) ? copy_num + 1 : majority; k >= 1; k-- )
+            at_least[k] |= at_least[k-1] & planes[copy_num];
+      voted = at_least[majority] & valid_mask;
+
+      BitStringStoreBits(voted_bs, voted_bit_pos + group_num, block_groups, voted);
+
+      if ( num_minority_ptr != NULL )
+         for ( copy_num = 0; copy_num < XMR; copy_num++ )
+            *num_minority_ptr += __builtin_popcountll((planes[copy_num] ^ voted) & valid_mask);
+
+      if ( ref_bs != NULL && num_ref_mismatches_ptr != NULL )
+         {
+         ref_word = BitStringLoadBits(ref_bs, ref_bit_pos + group_num, block_groups);
+         for ( copy_num = 0; copy_num < XMR; copy_num++ )
+            *num_ref_mismatches_ptr += __builtin_popcountll((planes[copy_num] ^ ref_word) & valid_mask);
+         }
+      }
+
+   return;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Print the memory footprint of the TVC for num_chips chips and num_TVC_arr qualified PNs, with the float layout 
+// (one float array per TVC element) and the compact layout (int16_t, contiguous per chip). The PNR/PNF arrays 
+// of num_chlng_PNs floats per chip that are allocated for every challenge are listed separately since both 
+// layouts convert to float on read. NOTE: The sizes are computed from the element counts and the structure 
+// sizes, not measured: malloc overhead and the resident set of the process are not included.
+
+void PrintTimingValsCacheFootprint(char *label, int num_TVC_arr, int num_chips, int num_chlng_PNs)
+   {
+   double keys_MB, float_MB, compact_MB, chlng_MB;
+
+   keys_MB = (double)num_TVC_arr * sizeof(TimingValCacheStruct)/(1024.0*1024.0);
+   float_MB = (double)num_TVC_arr * num_chips * sizeof(float)/(1024.0*1024.0);
+   compact_MB = (double)num_TVC_arr * num_chips * sizeof(int16_t)/(1024.0*1024.0);
+   chlng_MB = ((double)num_chips * num_chlng_PNs * sizeof(float) + 2.0 * num_chips * sizeof(float *))/(1024.0*1024.0);
+
+   printf("TVC footprint %s: %d chips x %d PNs\n", label, num_chips, num_TVC_arr);
+   printf("\tFloat layout:\t%10.2f MB (PNs %.2f MB + elements %.2f MB)\n", float_MB + keys_MB, float_MB, keys_MB);
+   printf("\tCompact layout:\t%10.2f MB (PNs %.2f MB + elements %.2f MB)\t%.1f%% of float\n", compact_MB + keys_MB, compact_MB, keys_MB, 
+      100.0*(compact_MB + keys_MB)/(float_MB + keys_MB));
+   printf("\tPer challenge PNR/PNF (both layouts): %.2f MB\n", chlng_MB);
+   fflush(stdout);
+
+   return;
+   }
+
+
 // ========================================================================================================
 // ========================================================================================================
 // ASCII '0'/'1' string to binary.
@@ -16,6 +16,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>  
+#include <stdint.h>
 #include <sys/mman.h>
 #include <math.h>
 
@@ -27,22 +28,60 @@ typedef struct
    char rise_or_fall;
    float *PNs;
    } TimingValCacheStruct;
+
+// Compact layout of the TVC PNs. The TimingVals Ave value (the PN times 16) is kept as an int16_t and the num_TVC_arr values of a 
+// chip are stored contiguously, i.e., PNs16[chip_num * num_TVC_arr + TVC_num], so fetching the PNs of one chip walks one block of 
+// memory. The TimingValCacheStruct array still holds the vecpair_id, PO_num and rise_or_fall of each element (its PNs are NULL).
+typedef struct
+   {
+   int num_TVC_arr;
+   int num_chips;
+   int16_t *PNs16;
+   } TimingValCacheCompactStruct;
 #define TIMING_STRUCTS
 #endif
 
+// Scale and missing PN marker of the compact TVC layout. TVC_COMPACT_MISSING is read back as -50000.0, the marker of the float layout.
+#define TVC_COMPACT_SCALE 16
+#define TVC_COMPACT_MISSING INT16_MIN
+
 // Scratch pad string size
 #define MAX_STRING_LEN 2048
 
+// Largest XMR (redundancy) handled by the word-level majority vote in BitStringMajorityVote(). 
+#define BITSTRING_MAX_XMR 63
+
 // HELP currently uses 2048 PNR and 2048 PNF to create 2048 PNDiffs. 
 #define NUM_REQUIRED_PNDIFFS 2048
 
 float Round(float d);
 float ComputeMean(int num_vals, float *vals);
 float ComputeMedian(int num_vals, float *vals);
+int MedianCompareFunc(const void *v1, const void *v2);
+float SelectKthFloat(int num_vals, float *vals, int k);
+int SelectKthInt(int num_vals, int *vals, int k);
+void SelectTwoInt(int num_vals, int *vals, int k_low, int k_high, int *low_val_ptr, int *high_val_ptr);
+float ComputeMedianInPlace(int num_vals, float *vals);
+void ComputeColumnMedians(int num_rows, int num_cols, float **rows, float *medians);
 float ComputeStdDev(int num_vals, float mean, float *vals);
 int GetBitFromByte(unsigned char byte, int bit_pos);
 void SetBitInByte(unsigned char *byte_ptr, int bit_val, int bit_pos);
 
+uint64_t BitStringLoadBits(const unsigned char *bs, int bit_pos, int num_bits);
+void BitStringStoreBits(unsigned char *bs, int bit_pos, int num_bits, uint64_t bits);
+void BitStringCopyBits(unsigned char *dest_bs, int dest_bit_pos, const unsigned char *src_bs, int src_bit_pos, int num_bits);
+void BitStringClearBits(unsigned char *bs, int bit_pos, int num_bits);
+uint64_t BitStringExtractWordPortable(uint64_t word, uint64_t mask);
+uint64_t BitStringExtractWord(uint64_t word, uint64_t mask);
+int BitStringExtractMasked(int num_bits, const unsigned char *src_bs, const unsigned char *mask_bs, unsigned char *dest_bs, 
+   int dest_bit_pos);
+int BitStringCountMismatches(const unsigned char *bs1, int bit_pos1, const unsigned char *bs2, int bit_pos2, int num_bits);
+int BitStringFindFirstMismatch(const unsigned char *bs1, int bit_pos1, const unsigned char *bs2, int bit_pos2, int num_bits);
+void BitStringMajorityVote(int XMR, int num_groups, const unsigned char *copies_bs, unsigned char *voted_bs, int voted_bit_pos, 
+   int *num_minority_ptr, const unsigned char *ref_bs, int ref_bit_pos, int *num_ref_mismatches_ptr);
+
+void PrintTimingValsCacheFootprint(char *label, int num_TVC_arr, int num_chips, int num_chlng_PNs);
+
 void ASCIIByteToBin(unsigned char *binary_byte_ptr, char *ascii_str);
 void BinByteToASCII(unsigned char binary_byte, char *ascii_str);
 
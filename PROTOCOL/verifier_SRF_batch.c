@@ -0,0 +1,406 @@
+// ========================================================================================================
+// ========================================================================================================
+// ***************************************** verifier_SRF_batch.c *****************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+//
+// Batched version of the software SRF engine (ComputePNDiffsTwoSeeds, GPEVCal, AddSpreadFactors, the optional
+// ScalingConstant and SingleHelpBitGen with Threshold 0) used by the device authentication database search. Instead
+// of running DoSRFComp() once per chip, SRF_BATCH_LANES chips are processed together in a structure-of-arrays tile
+// where each lane holds one chip. Every lane carries out EXACTLY the same sequence of float operations as the per-chip
+// routines (same order of the mean summation, same truncation to 4 binary digits, same TrimCodeConstant wrap), so the
+// raw bitstrings are bit-identical to the ones produced by DoSRFComp() + SingleHelpBitGen().
+//
+// AVX2 is used when the compiler targets it (-mavx2), SSE2 otherwise on x86-64 and plain C on everything else.
+
+#include "common.h"
+#include "verifier_common.h"
+#include "verifier_regen_funcs.h"
+#include "verifier_SRF_batch.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// ========================================================================================================
+// Vector operations used below. Lanes that do not need an update MUST be left untouched (select, NOT add 0.0),
+// otherwise -0.0 turns into +0.0 and the lanes would no longer follow the scalar code.
+
+#if defined(__AVX2__)
+
+#define SRF_VEC_WIDTH 8
+typedef __m256 srf_vec_t;
+typedef __m256 srf_mask_t;
+#define SRF_LOAD(p) _mm256_loadu_ps(p)
+#define SRF_STORE(p, v) _mm256_storeu_ps(p, v)
+#define SRF_SET1(f) _mm256_set1_ps(f)
+#define SRF_ADD(a, b) _mm256_add_ps(a, b)
+#define SRF_SUB(a, b) _mm256_sub_ps(a, b)
+#define SRF_MUL(a, b) _mm256_mul_ps(a, b)
+#define SRF_MIN(a, b) _mm256_min_ps(a, b)
+#define SRF_LT(a, b) _mm256_cmp_ps(a, b, _CMP_LT_OQ)
+#define SRF_GT(a, b) _mm256_cmp_ps(a, b, _CMP_GT_OQ)
+#define SRF_OR(a, b) _mm256_or_ps(a, b)
+#define SRF_SEL(m, a, b) _mm256_blendv_ps(b, a, m)
+#define SRF_MOVEMASK(m) _mm256_movemask_ps(m)
+#define SRF_FIX16(v) _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvttps_epi32(_mm256_mul_ps(v, _mm256_set1_ps(16.0)))), \
+   _mm256_set1_ps(0.0625))
+
+#elif defined(__SSE2__)
+
+#define SRF_VEC_WIDTH 4
+typedef __m128 srf_vec_t;
+typedef __m128 srf_mask_t;
+#define SRF_LOAD(p) _mm_loadu_ps(p)
+#define SRF_STORE(p, v) _mm_storeu_ps(p, v)
+#define SRF_SET1(f) _mm_set1_ps(f)
+#define SRF_ADD(a, b) _mm_add_ps(a, b)
+#define SRF_SUB(a, b) _mm_sub_ps(a, b)
+#define SRF_MUL(a, b) _mm_mul_ps(a, b)
+#define SRF_MIN(a, b) _mm_min_ps(a, b)
+#define SRF_LT(a, b) _mm_cmplt_ps(a, b)
+#define SRF_GT(a, b) _mm_cmpgt_ps(a, b)
+#define SRF_OR(a, b) _mm_or_ps(a, b)
+#define SRF_SEL(m, a, b) _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b))
+#define SRF_MOVEMASK(m) _mm_movemask_ps(m)
+#define SRF_FIX16(v) _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(v, _mm_set1_ps(16.0)))), _mm_set1_ps(0.0625))
+
+#else
+
+#define SRF_VEC_WIDTH 1
+typedef float srf_vec_t;
+typedef int srf_mask_t;
+#define SRF_LOAD(p) (*(p))
+#define SRF_STORE(p, v) (*(p) = (v))
+#define SRF_SET1(f) (f)
+#define SRF_ADD(a, b) ((a) + (b))
+#define SRF_SUB(a, b) ((a) - (b))
+#define SRF_MUL(a, b) ((a) * (b))
+#define SRF_MIN(a, b) ((a) < (b) ? (a) : (b))
+#define SRF_LT(a, b) ((a) < (b))
+#define SRF_GT(a, b) ((a) > (b))
+#define SRF_OR(a, b) ((a) | (b))
+#define SRF_SEL(m, a, b) ((m) ? (a) : (b))
+#define SRF_MOVEMASK(m) (m)
+#define SRF_FIX16(v) ((float)((int)((v)*16.0))/16.0)
+
+#endif
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Returns the name of the instruction set the engine was compiled for. Printed at startup.
+
+const char *SRFBatchISAName()
+   {
+#if defined(__AVX2__)
+   return "AVX2";
+#elif defined(__SSE2__)
+   return "SSE2";
+#else
+   return "scalar";
+#endif
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Allocate the tile and scratch storage for the batched SRF engine.
+
+void SRFBatchAlloc(SRFBatchStruct *SB_ptr, int num_PNDiffs)
+   {
+
+// Sanity check. The raw bitstrings are byte packed.
+   if ( num_PNDiffs <= 0 || (num_PNDiffs % 8) != 0 )
+      { printf("ERROR: SRFBatchAlloc(): num_PNDiffs %d MUST be a positive multiple of 8!\n", num_PNDiffs); exit(EXIT_FAILURE); }
+
+   SB_ptr->num_PNDiffs = num_PNDiffs;
+   if ( (SB_ptr->LFSR_low_seq = (uint16_t *)malloc(sizeof(uint16_t) * num_PNDiffs)) == NULL ||
+      (SB_ptr->LFSR_high_seq = (uint16_t *)malloc(sizeof(uint16_t) * num_PNDiffs)) == NULL ||
+      (SB_ptr->tile = (float *)malloc(sizeof(float) * num_PNDiffs * SRF_BATCH_LANES)) == NULL ||
+      (SB_ptr->column = (float *)malloc(sizeof(float) * num_PNDiffs)) == NULL ||
+      (SB_ptr->raw_SBS = (unsigned char *)calloc(num_PNDiffs/8 * SRF_BATCH_LANES, sizeof(unsigned char))) == NULL )
+      { printf("ERROR: SRFBatchAlloc(): Failed to allocate storage for batched SRF engine!\n"); exit(EXIT_FAILURE); }
+
+// Force SRFBatchSetLFSRSeeds() to generate the sequences on the first call.
+   SB_ptr->LFSR_seed_low = (unsigned int)-1;
+   SB_ptr->LFSR_seed_high = (unsigned int)-1;
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Free the storage allocated in SRFBatchAlloc().
+
+void SRFBatchFree(SRFBatchStruct *SB_ptr)
+   {
+   if ( SB_ptr->LFSR_low_seq != NULL )
+      free(SB_ptr->LFSR_low_seq);
+   if ( SB_ptr->LFSR_high_seq != NULL )
+      free(SB_ptr->LFSR_high_seq);
+   if ( SB_ptr->tile != NULL )
+      free(SB_ptr->tile);
+   if ( SB_ptr->column != NULL )
+      free(SB_ptr->column);
+   if ( SB_ptr->raw_SBS != NULL )
+      free(SB_ptr->raw_SBS);
+
+   SB_ptr->LFSR_low_seq = NULL;
+   SB_ptr->LFSR_high_seq = NULL;
+   SB_ptr->tile = NULL;
+   SB_ptr->column = NULL;
+   SB_ptr->raw_SBS = NULL;
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Run the two LFSRs once for the given seeds and store the index sequences. ComputePNDiffsTwoSeeds() does this
+// for every chip, but the sequences only depend on the seeds.
+
+void SRFBatchSetLFSRSeeds(SRFBatchStruct *SB_ptr, unsigned int LFSR_seed_low, unsigned int LFSR_seed_high)
+   {
+   uint16_t lfsr_val_low, lfsr_val_high;
+   int num_PNDiffs = SB_ptr->num_PNDiffs;
+   int PND_num;
+
+   if ( SB_ptr->LFSR_seed_low == LFSR_seed_low && SB_ptr->LFSR_seed_high == LFSR_seed_high )
+      return;
+
+// Sanity check: Don't allow this because first call uses the LFSR seed directly.
+   if ( (int)LFSR_seed_low >= num_PNDiffs || (int)LFSR_seed_high >= num_PNDiffs )
+      {
+      printf("ERROR: SRFBatchSetLFSRSeeds(): SEED for LFSR low %u or high %u larger than max %d!\n",
+         LFSR_seed_low, LFSR_seed_high, num_PNDiffs);
+      exit(EXIT_FAILURE);
+      }
+
+   LFSR_11_A_bits_low(1, (uint16_t)LFSR_seed_low, &lfsr_val_low);
+   LFSR_11_A_bits_high(1, (uint16_t)LFSR_seed_high, &lfsr_val_high);
+   for ( PND_num = 0; PND_num < num_PNDiffs; PND_num++ )
+      {
+
+// Sanity check
+      if ( (int)lfsr_val_low >= num_PNDiffs || (int)lfsr_val_high >= num_PNDiffs )
+         {
+         printf("ERROR: SRFBatchSetLFSRSeeds(): LFSR low %d or high %d larger than max %d!\n",
+            lfsr_val_low, lfsr_val_high, num_PNDiffs); exit(EXIT_FAILURE);
+         }
+
+      SB_ptr->LFSR_low_seq[PND_num] = lfsr_val_low;
+      SB_ptr->LFSR_high_seq[PND_num] = lfsr_val_high;
+
+      LFSR_11_A_bits_low(0, (uint16_t)0, &lfsr_val_low);
+      LFSR_11_A_bits_high(0, (uint16_t)0, &lfsr_val_high);
+      }
+
+   SB_ptr->LFSR_seed_low = LFSR_seed_low;
+   SB_ptr->LFSR_seed_high = LFSR_seed_high;
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Compute the raw bitstrings (Threshold 0) for up to SRF_BATCH_LANES chips listed in chip_nums using the
+// parameters and fSpreadFactors currently stored in SAP_ptr. The LFSR sequences MUST have been set for
+// SAP_ptr->param_LFSR_seed_low/high with SRFBatchSetLFSRSeeds(). On return, lane 'l' of SB_ptr->raw_SBS
+// (SB_ptr->raw_SBS + l*num_PNDiffs/8) holds what SingleHelpBitGen() would have stored in device_SBS for
+// chip_nums[l], and SB_ptr->tile holds the (optionally scaled) fPNDco. Unused lanes are filled with a copy of
+// lane 0 and should be ignored by the caller.
+
+void SRFBatchRawBitstrings(SRFAlgoParamsStruct *SAP_ptr, SRFBatchStruct *SB_ptr, int *chip_nums, int num_lanes,
+   int do_scaling)
+   {
+   float largest_neg_PND[SRF_BATCH_LANES], cur_mean[SRF_BATCH_LANES], range_conv[SRF_BATCH_LANES];
+   float scaling[SRF_BATCH_LANES];
+   int scale_lane[SRF_BATCH_LANES];
+   float *PNR_arr[SRF_BATCH_LANES], *PNF_arr[SRF_BATCH_LANES];
+   int num_PNDiffs, PND_num, lane, off, do_any_scaling;
+   float *tile, *vals;
+   float cur_range;
+   unsigned short TrimCodeConstant;
+   srf_vec_t v_vals, v_acc, v_mean, v_conv, v_hi, v_lo, v_TCC;
+   srf_mask_t m_lt, m_gt;
+
+   num_PNDiffs = SB_ptr->num_PNDiffs;
+   tile = SB_ptr->tile;
+
+// Sanity checks
+   if ( num_lanes < 1 || num_lanes > SRF_BATCH_LANES )
+      { printf("ERROR: SRFBatchRawBitstrings(): num_lanes %d MUST be between 1 and %d!\n", num_lanes, SRF_BATCH_LANES); exit(EXIT_FAILURE); }
+   if ( num_PNDiffs != SAP_ptr->num_required_PNDiffs )
+      { printf("ERROR: SRFBatchRawBitstrings(): num_PNDiffs %d NOT equal to %d!\n", num_PNDiffs, SAP_ptr->num_required_PNDiffs); exit(EXIT_FAILURE); }
+   if ( SB_ptr->LFSR_seed_low != SAP_ptr->param_LFSR_seed_low || SB_ptr->LFSR_seed_high != SAP_ptr->param_LFSR_seed_high )
+      { printf("ERROR: SRFBatchRawBitstrings(): LFSR sequences NOT set for current seeds!\n"); exit(EXIT_FAILURE); }
+
+// Unused lanes duplicate lane 0 so every lane carries valid data through the vector code.
+   do_any_scaling = 0;
+   for ( lane = 0; lane < SRF_BATCH_LANES; lane++ )
+      {
+      int chip_num = chip_nums[lane < num_lanes ? lane : 0];
+
+      PNR_arr[lane] = SAP_ptr->PNR[chip_num];
+      PNF_arr[lane] = SAP_ptr->PNF[chip_num];
+
+      scale_lane[lane] = 0;
+      scaling[lane] = 1.0;
+      if ( do_scaling == 1 && SAP_ptr->ChipScalingConstantNotifiedArr[chip_num] == 1 )
+         {
+         scale_lane[lane] = 1;
+         scaling[lane] = SAP_ptr->ChipScalingConstantArr[chip_num];
+         do_any_scaling = 1;
+         }
+      }
+
+// ****************************************
+// ***** Compute PND. Same as ComputePNDiffsTwoSeeds(), with the gather done once per PND for all lanes.
+   v_hi = SRF_SET1((float)LARGEST_POS_VAL);
+   v_lo = SRF_SET1((float)LARGEST_NEG_VAL);
+   for ( PND_num = 0; PND_num < num_PNDiffs; PND_num++ )
+      {
+      int lfsr_val_low = SB_ptr->LFSR_low_seq[PND_num];
+      int lfsr_val_high = SB_ptr->LFSR_high_seq[PND_num];
+      float *tile_row = &(tile[lfsr_val_low*SRF_BATCH_LANES]);
+
+      for ( lane = 0; lane < SRF_BATCH_LANES; lane++ )
+         tile_row[lane] = PNR_arr[lane][lfsr_val_low] - PNF_arr[lane][lfsr_val_high];
+
+      for ( off = 0; off < SRF_BATCH_LANES; off += SRF_VEC_WIDTH )
+         {
+         v_vals = SRF_LOAD(&(tile_row[off]));
+
+// Check for overflow that would happen in the hardware.
+         if ( SRF_MOVEMASK(SRF_OR(SRF_GT(v_vals, v_hi), SRF_LT(v_vals, v_lo))) != 0 )
+            {
+            printf("ERROR: SRFBatchRawBitstrings(): fPND larger than largest or smaller than smallest allowable value %d/%d!\n",
+               LARGEST_POS_VAL, LARGEST_NEG_VAL);
+            exit(EXIT_FAILURE);
+            }
+
+// Get largest neg PND so we can use it in ComputeBoundedRange. MIN(a, b) is (a < b ? a : b) which keeps the earlier value on ties.
+         if ( PND_num == 0 )
+            v_acc = v_vals;
+         else
+            v_acc = SRF_MIN(v_vals, SRF_LOAD(&(largest_neg_PND[off])));
+         SRF_STORE(&(largest_neg_PND[off]), v_acc);
+         }
+      }
+
+// ****************************************
+// ***** GPEVCal. The mean is accumulated in PND order for each lane, exactly as the scalar loop does it.
+   for ( off = 0; off < SRF_BATCH_LANES; off += SRF_VEC_WIDTH )
+      {
+      v_acc = SRF_SET1(0.0);
+      for ( PND_num = 0; PND_num < num_PNDiffs; PND_num++ )
+         v_acc = SRF_ADD(v_acc, SRF_LOAD(&(tile[PND_num*SRF_BATCH_LANES + off])));
+      SRF_STORE(&(cur_mean[off]), v_acc);
+      }
+
+// The bounded range uses a histogram, which does not vectorize across lanes. Copy each lane out and use the scalar routine.
+   vals = SB_ptr->column;
+   for ( lane = 0; lane < SRF_BATCH_LANES; lane++ )
+      {
+      cur_mean[lane] /= (float)num_PNDiffs;
+
+      for ( PND_num = 0; PND_num < num_PNDiffs; PND_num++ )
+         vals[PND_num] = tile[PND_num*SRF_BATCH_LANES + lane];
+      cur_range = ComputeBoundedRange(num_PNDiffs, vals, SAP_ptr->range_low_limit, SAP_ptr->range_high_limit, SAP_ptr->dist_range,
+         largest_neg_PND[lane]);
+      range_conv[lane] = (float)SAP_ptr->param_RangeConstant/cur_range;
+      }
+
+// Standardize, scale and trim to 4 binary digits of precision.
+   for ( off = 0; off < SRF_BATCH_LANES; off += SRF_VEC_WIDTH )
+      {
+      v_mean = SRF_LOAD(&(cur_mean[off]));
+      v_conv = SRF_LOAD(&(range_conv[off]));
+      for ( PND_num = 0; PND_num < num_PNDiffs; PND_num++ )
+         {
+         v_vals = SRF_LOAD(&(tile[PND_num*SRF_BATCH_LANES + off]));
+         v_vals = SRF_MUL(SRF_SUB(v_vals, v_mean), v_conv);
+         SRF_STORE(&(tile[PND_num*SRF_BATCH_LANES + off]), SRF_FIX16(v_vals));
+         }
+      }
+
+// ****************************************
+// ***** Add SpreadFactors. The fSpreadFactors are the same for every chip. Wrap by TrimCodeConstant until all lanes are
+// within +/- TrimCodeConstant/2.
+   TrimCodeConstant = SAP_ptr->param_TrimCodeConstant;
+   v_TCC = SRF_SET1((float)TrimCodeConstant);
+   v_lo = SRF_SET1((float)-TrimCodeConstant/2);
+   v_hi = SRF_SET1((float)TrimCodeConstant/2);
+   for ( PND_num = 0; PND_num < num_PNDiffs; PND_num++ )
+      {
+      srf_vec_t v_SF = SRF_SET1(SAP_ptr->fSpreadFactors[PND_num]);
+
+      for ( off = 0; off < SRF_BATCH_LANES; off += SRF_VEC_WIDTH )
+         {
+         v_vals = SRF_SUB(SRF_LOAD(&(tile[PND_num*SRF_BATCH_LANES + off])), v_SF);
+         while (1)
+            {
+            m_lt = SRF_LT(v_vals, v_lo);
+            m_gt = SRF_GT(v_vals, v_hi);
+            if ( SRF_MOVEMASK(SRF_OR(m_lt, m_gt)) == 0 )
+               break;
+            v_vals = SRF_SEL(m_lt, SRF_ADD(v_vals, v_TCC), v_vals);
+            v_vals = SRF_SEL(m_gt, SRF_SUB(v_vals, v_TCC), v_vals);
+            }
+         SRF_STORE(&(tile[PND_num*SRF_BATCH_LANES + off]), v_vals);
+         }
+      }
+
+// ****************************************
+// ***** Personalized ScalingConstants. Only lanes with a notified ScalingConstant are changed.
+   if ( do_any_scaling == 1 )
+      {
+      float scale_mask[SRF_BATCH_LANES];
+
+      for ( lane = 0; lane < SRF_BATCH_LANES; lane++ )
+         scale_mask[lane] = (float)scale_lane[lane];
+
+      for ( off = 0; off < SRF_BATCH_LANES; off += SRF_VEC_WIDTH )
+         {
+         srf_vec_t v_scale = SRF_LOAD(&(scaling[off]));
+         srf_mask_t m_scale = SRF_GT(SRF_LOAD(&(scale_mask[off])), SRF_SET1(0.0));
+
+         for ( PND_num = 0; PND_num < num_PNDiffs; PND_num++ )
+            {
+            v_vals = SRF_LOAD(&(tile[PND_num*SRF_BATCH_LANES + off]));
+            v_vals = SRF_SEL(m_scale, SRF_FIX16(SRF_MUL(v_vals, v_scale)), v_vals);
+            SRF_STORE(&(tile[PND_num*SRF_BATCH_LANES + off]), v_vals);
+            }
+         }
+      }
+
+// ****************************************
+// ***** SingleHelpBitGen with Threshold 0: every bit is strong and the bit is '1' unless fPNDco < 0.0.
+   memset(SB_ptr->raw_SBS, 0, num_PNDiffs/8 * SRF_BATCH_LANES);
+   for ( PND_num = 0; PND_num < num_PNDiffs; PND_num++ )
+      {
+      for ( off = 0; off < SRF_BATCH_LANES; off += SRF_VEC_WIDTH )
+         {
+         int neg_mask = SRF_MOVEMASK(SRF_LT(SRF_LOAD(&(tile[PND_num*SRF_BATCH_LANES + off])), SRF_SET1(0.0)));
+
+         for ( lane = 0; lane < SRF_VEC_WIDTH; lane++ )
+            if ( ((neg_mask >> lane) & 1) == 0 )
+               SB_ptr->raw_SBS[(off + lane)*num_PNDiffs/8 + PND_num/8] |= (1 << (PND_num % 8));
+         }
+      }
+
+   return;
+   }
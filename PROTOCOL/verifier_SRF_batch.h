@@ -0,0 +1,25 @@
+// ========================================================================================================
+// ========================================================================================================
+// ***************************************** verifier_SRF_batch.h *****************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+
+// SRF_BATCH_LANES and SRFBatchStruct are in verifier_common.h since the worker slab (WorkerSlabStruct) carries one.
+
+
+void SRFBatchAlloc(SRFBatchStruct *SB_ptr, int num_PNDiffs);
+void SRFBatchFree(SRFBatchStruct *SB_ptr);
+
+void SRFBatchSetLFSRSeeds(SRFBatchStruct *SB_ptr, unsigned int LFSR_seed_low, unsigned int LFSR_seed_high);
+
+void SRFBatchRawBitstrings(SRFAlgoParamsStruct *SAP_ptr, SRFBatchStruct *SB_ptr, int *chip_nums, int num_lanes,
+   int do_scaling);
+
+const char *SRFBatchISAName();
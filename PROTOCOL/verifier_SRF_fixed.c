@@ -0,0 +1,320 @@
+// ========================================================================================================
+// ========================================================================================================
+// ***************************************** verifier_SRF_fixed.c *****************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+//
+// Fixed-point version of the software SRF engine (ComputePNDiffsTwoSeeds, GPEVCal, AddSpreadFactors and
+// SingleHelpBitGen). All values are int16_t times 16 (SRF_FIXED_ONE), the format of the TimingVals Ave column and of
+// the hardware datapath, so PND, the bounded range, the TrimCodeConstant wrap and the bit/helper data decisions are
+// exact integer operations.
+//
+// The float GPEVCal rounds twice before it truncates to 4 binary digits: range_conv = RangeConstant/range is rounded
+// to a float and so is the product (PND - mean)*range_conv. When the exact result lands on (or within a float ulp of)
+// a multiple of 1/16, the float version can truncate to the wrong side. The version here computes the exact value
+// trunc(16*(PND - mean)*RangeConstant/range) with 64-bit integers, which is what a datapath with enough bits does.
+// srf_fixed_diff (make test) reports where the two engines disagree.
+
+#include "common.h"
+#include "verifier_common.h"
+#include "verifier_SRF_fixed.h"
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Convert float PNs (as stored in the PN cache, the TimingVals Ave column divided by 16) back to the int16_t
+// times 16 format. Every PN MUST be an exact multiple of 1/16.
+
+void SRFFixedLoadPNs(int num_PNs, float *PNs, int16_t *PNs16)
+   {
+   float scaled;
+   int PN_num, ival;
+
+   for ( PN_num = 0; PN_num < num_PNs; PN_num++ )
+      {
+      scaled = PNs[PN_num] * (float)SRF_FIXED_ONE;
+      ival = (int)scaled;
+      if ( (float)ival != scaled || ival > INT16_MAX || ival < INT16_MIN )
+         { printf("ERROR: SRFFixedLoadPNs(): PN %d value %f is NOT an int16 multiple of 1/%d!\n", PN_num, PNs[PN_num], SRF_FIXED_ONE); exit(EXIT_FAILURE); }
+      PNs16[PN_num] = (int16_t)ival;
+      }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Convert fixed-point values to float. Exact.
+
+void SRFFixedToFloat(int num_vals, int16_t *vals16, float *vals)
+   {
+   int val_num;
+
+   for ( val_num = 0; val_num < num_vals; val_num++ )
+      vals[val_num] = (float)vals16[val_num]/(float)SRF_FIXED_ONE;
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Compute the PND from the PNR/PNF, using two 11-bit LFSR seeds. Same as ComputePNDiffsTwoSeeds(). Returns the
+// largest negative PND.
+
+int16_t SRFFixedPNDiffsTwoSeeds(int num_PNDiffs, int16_t *PNR16, int16_t *PNF16, int16_t *PND16, int LFSR_seed_low,
+   int LFSR_seed_high)
+   {
+   uint16_t lfsr_val_low, lfsr_val_high;
+   int16_t largest_neg_PND16 = 0;
+   int PND_num, diff;
+
+// Sanity check: Don't allow this because first call uses the LFSR seed directly.
+   if ( LFSR_seed_low >= num_PNDiffs || LFSR_seed_high >= num_PNDiffs )
+      {
+      printf("ERROR: SRFFixedPNDiffsTwoSeeds(): SEED for LFSR low %d or high %d larger than max %d!\n",
+         LFSR_seed_low, LFSR_seed_high, num_PNDiffs);
+      exit(EXIT_FAILURE);
+      }
+
+   LFSR_11_A_bits_low(1, (uint16_t)LFSR_seed_low, &lfsr_val_low);
+   LFSR_11_A_bits_high(1, (uint16_t)LFSR_seed_high, &lfsr_val_high);
+   for ( PND_num = 0; PND_num < num_PNDiffs; PND_num++ )
+      {
+
+// Sanity check
+      if ( (int)lfsr_val_low >= num_PNDiffs || (int)lfsr_val_high >= num_PNDiffs )
+         {
+         printf("ERROR: SRFFixedPNDiffsTwoSeeds(): LFSR low %d or high %d larger than max %d!\n",
+            lfsr_val_low, lfsr_val_high, num_PNDiffs); exit(EXIT_FAILURE);
+         }
+
+// Check for overflow that would happen in the hardware.
+      diff = (int)PNR16[lfsr_val_low] - (int)PNF16[lfsr_val_high];
+      if ( diff > LARGEST_POS_VAL*SRF_FIXED_ONE || diff < LARGEST_NEG_VAL*SRF_FIXED_ONE )
+         {
+         printf("ERROR: SRFFixedPNDiffsTwoSeeds(): PND larger than largest or smaller than smallest allowable value %d/%d!\n",
+            LARGEST_POS_VAL, LARGEST_NEG_VAL);
+         exit(EXIT_FAILURE);
+         }
+      PND16[lfsr_val_low] = (int16_t)diff;
+
+      if ( PND_num == 0 || largest_neg_PND16 > PND16[lfsr_val_low] )
+         largest_neg_PND16 = PND16[lfsr_val_low];
+
+      LFSR_11_A_bits_low(0, (uint16_t)0, &lfsr_val_low);
+      LFSR_11_A_bits_high(0, (uint16_t)0, &lfsr_val_high);
+      }
+
+   return largest_neg_PND16;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Range of the PND between the range_low_limit and range_high_limit quantiles. Same histogram as
+// ComputeBoundedRange(): each PND, shifted by the largest negative PND, is rounded to the nearest integer
+// (halves up) and binned.
+
+int SRFFixedBoundedRange(int num_PNDiffs, int16_t *PND16, float range_low_limit, float range_high_limit, int DIST_range,
+   int16_t largest_neg_PND16)
+   {
+   int low_done, low_index = 0, high_index = 0;
+   int PND_num, shifted, bin_num;
+   int PN_bins[DIST_range];
+   int i, sum;
+
+   memset(PN_bins, 0, sizeof(int) * DIST_range);
+
+   for ( PND_num = 0; PND_num < num_PNDiffs; PND_num++ )
+      {
+      shifted = (int)PND16[PND_num] - (int)largest_neg_PND16;
+      bin_num = (shifted + SRF_FIXED_ONE/2) >> SRF_FIXED_FRAC_BITS;
+
+// Sanity check.
+      if ( shifted < 0 || bin_num >= DIST_range )
+         { printf("ERROR: SRFFixedBoundedRange(): Adjusted PNDIFF LESS THAN 0 or OUTSIDE of DIST_range => %d/%d\n", shifted, SRF_FIXED_ONE); exit(EXIT_FAILURE); }
+
+      PN_bins[bin_num]++;
+      }
+
+   sum = 0;
+   low_done = 0;
+   for ( i = 0; i < DIST_range; i++ )
+      {
+      sum += PN_bins[i];
+      if ( low_done == 0 && sum >= range_low_limit )
+         {
+         low_done = 1;
+         low_index = i;
+         }
+      if ( sum <= range_high_limit )
+         { high_index = i; }
+      else if ( low_done == 1 )
+         break;
+      }
+
+   return high_index - low_index;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// GPEVCal on fixed-point PND. With N PNDiffs, S the sum of PND16 and R the bounded range, the float version
+// computes trunc(((PND - mean)*RangeConstant/R)*16). In units of 1/16 this is exactly
+//
+//    PNDc16 = trunc((PND16*N - S)*RangeConstant / (N*R))
+//
+// The numerator needs about 40 bits, so use 64-bit integers. The quotient is estimated with a double reciprocal
+// and then corrected with integer multiplies, so it is the exact truncated (toward zero) quotient. PND16 and PNDc16
+// MAY BE THE SAME ARRAY.
+
+void SRFFixedGPEVCal(int num_PNDiffs, int16_t *PND16, int16_t *PNDc16, float range_low_limit, float range_high_limit,
+   int DIST_range, unsigned int RangeConstant, int16_t largest_neg_PND16)
+   {
+   int64_t sum, numer, denom, quot, rem;
+   double inv_denom;
+   int cur_range, val_num;
+
+   sum = 0;
+   for ( val_num = 0; val_num < num_PNDiffs; val_num++ )
+      sum += PND16[val_num];
+
+   cur_range = SRFFixedBoundedRange(num_PNDiffs, PND16, range_low_limit, range_high_limit, DIST_range, largest_neg_PND16);
+   if ( cur_range <= 0 )
+      { printf("ERROR: SRFFixedGPEVCal(): Bounded range %d MUST be > 0!\n", cur_range); exit(EXIT_FAILURE); }
+
+   denom = (int64_t)num_PNDiffs * cur_range;
+   inv_denom = 1.0/(double)denom;
+
+#ifdef DEBUG
+printf("\tSRFFixedGPEVCal(): Sum %lld\tRange %d\tRangeConstant %u\n", (long long)sum, cur_range, RangeConstant); fflush(stdout);
+#endif
+
+   for ( val_num = 0; val_num < num_PNDiffs; val_num++ )
+      {
+      numer = ((int64_t)PND16[val_num] * num_PNDiffs - sum) * (int64_t)RangeConstant;
+
+// The estimate is off by at most one. Fix it with the remainder, which for a quotient truncated toward zero is in
+// [0, denom) for positive numerators and in (-denom, 0] for negative ones.
+      quot = (int64_t)((double)numer * inv_denom);
+      rem = numer - quot * denom;
+      if ( numer >= 0 )
+         {
+         if ( rem < 0 )
+            quot--;
+         else if ( rem >= denom )
+            quot++;
+         }
+      else
+         {
+         if ( rem > 0 )
+            quot++;
+         else if ( rem <= -denom )
+            quot--;
+         }
+
+      if ( quot > INT16_MAX || quot < INT16_MIN )
+         { printf("ERROR: SRFFixedGPEVCal(): PNDc %lld/%d does NOT fit in 16 bits!\n", (long long)quot, SRF_FIXED_ONE); exit(EXIT_FAILURE); }
+      PNDc16[val_num] = (int16_t)quot;
+      }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Subtract the SpreadFactors and wrap by TrimCodeConstant into [-TrimCodeConstant/2, TrimCodeConstant/2]. Same
+// as AddSpreadFactors(). The bounds, TrimCodeConstant/2 in units of 1/16, are exact for odd TrimCodeConstant too.
+// The number of TrimCodeConstant steps the AddSpreadFactors() loop takes is computed directly. A value below 
+// -TrimCodeConstant/2 ends up at most TrimCodeConstant - 1/16 above it, i.e., never above TrimCodeConstant/2, and 
+// vice versa, so one adjustment gives the same result as the loop.
+
+void SRFFixedAddSpreadFactors(int num_PNDiffs, int16_t *PNDc16, int16_t *PNDco16, int16_t *SF16, int TrimCodeConstant)
+   {
+   int half_TCC16, TCC16, PND_num, val;
+
+   TCC16 = TrimCodeConstant * SRF_FIXED_ONE;
+   half_TCC16 = TrimCodeConstant * SRF_FIXED_ONE/2;
+   for ( PND_num = 0; PND_num < num_PNDiffs; PND_num++ )
+      {
+      val = (int)PNDc16[PND_num] - (int)SF16[PND_num];
+      if ( val < -half_TCC16 )
+         val += ((-half_TCC16 - val + TCC16 - 1)/TCC16) * TCC16;
+      else if ( val > half_TCC16 )
+         val -= ((val - half_TCC16 + TCC16 - 1)/TCC16) * TCC16;
+      PNDco16[PND_num] = (int16_t)val;
+      }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Compute the SBS and SHD from the fixed-point PNDco. Same as SingleHelpBitGen(): the bit is 0 for negative
+// PNDco and the bit is weak when -Threshold < PNDco < Threshold. Returns the number of strong bits.
+
+int SRFFixedHelpBitGen(int num_PNDiffs, int16_t *PNDco16, unsigned char *SBS, unsigned char *SHD, unsigned short Threshold)
+   {
+   int SBS_num_bits, PND_num, Threshold16;
+
+   Threshold16 = (int)Threshold * SRF_FIXED_ONE;
+
+   memset(SHD, 0, num_PNDiffs/8);
+   SBS_num_bits = 0;
+   for ( PND_num = 0; PND_num < num_PNDiffs; PND_num++ )
+      {
+      if ( PNDco16[PND_num] > -Threshold16 && PNDco16[PND_num] < Threshold16 )
+         continue;
+
+      SHD[PND_num/8] |= (1 << (PND_num % 8));
+
+      if ( (SBS_num_bits % 8) == 0 )
+         SBS[SBS_num_bits/8] = 0;
+      if ( PNDco16[PND_num] >= 0 )
+         SBS[SBS_num_bits/8] |= (1 << (SBS_num_bits % 8));
+      SBS_num_bits++;
+      }
+
+   return SBS_num_bits;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Run the fixed-point engine for SAP_ptr->chip_num with the parameters and fSpreadFactors currently stored in
+// SAP_ptr. The fixed-point results are returned in PND16, PNDc16 and PNDco16 (num_required_PNDiffs each) and
+// are ALSO converted into SAP_ptr->fPND, fPNDc and fPNDco so the rest of the verifier can use them as is.
+
+void SRFFixedDoSRFComp(SRFAlgoParamsStruct *SAP_ptr, int16_t *PND16, int16_t *PNDc16, int16_t *PNDco16)
+   {
+   int num_PNDiffs = SAP_ptr->num_required_PNDiffs;
+   int16_t PNR16[num_PNDiffs], PNF16[num_PNDiffs], SF16[num_PNDiffs];
+   int16_t largest_neg_PND16;
+
+   SRFFixedLoadPNs(num_PNDiffs, SAP_ptr->PNR[SAP_ptr->chip_num], PNR16);
+   SRFFixedLoadPNs(num_PNDiffs, SAP_ptr->PNF[SAP_ptr->chip_num], PNF16);
+   SRFFixedLoadPNs(num_PNDiffs, SAP_ptr->fSpreadFactors, SF16);
+
+   largest_neg_PND16 = SRFFixedPNDiffsTwoSeeds(num_PNDiffs, PNR16, PNF16, PND16, SAP_ptr->param_LFSR_seed_low,
+      SAP_ptr->param_LFSR_seed_high);
+   SRFFixedGPEVCal(num_PNDiffs, PND16, PNDc16, SAP_ptr->range_low_limit, SAP_ptr->range_high_limit, SAP_ptr->dist_range,
+      SAP_ptr->param_RangeConstant, largest_neg_PND16);
+   SRFFixedAddSpreadFactors(num_PNDiffs, PNDc16, PNDco16, SF16, SAP_ptr->param_TrimCodeConstant);
+
+   SRFFixedToFloat(num_PNDiffs, PND16, SAP_ptr->fPND);
+   SRFFixedToFloat(num_PNDiffs, PNDc16, SAP_ptr->fPNDc);
+   SRFFixedToFloat(num_PNDiffs, PNDco16, SAP_ptr->fPNDco);
+
+   return;
+   }
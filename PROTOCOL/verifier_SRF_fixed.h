@@ -0,0 +1,42 @@
+// ========================================================================================================
+// ========================================================================================================
+// ***************************************** verifier_SRF_fixed.h *****************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+
+#ifndef SRF_FIXED_INCLUDED
+
+#include <stdint.h>
+
+// PNs, PND, PNDc and PNDco are carried as int16_t with 4 binary digits of precision, i.e., the value times 16, which is
+// the format of the TimingVals Ave column and of the hardware datapath. The SpreadFactors use the same format.
+#define SRF_FIXED_FRAC_BITS 4
+#define SRF_FIXED_ONE (1 << SRF_FIXED_FRAC_BITS)
+
+// Values for SAP_ptr->SRF_fixed_point_mode, which selects the engine used by DoSRFComp().
+#define SRF_MODE_FLOAT 0
+#define SRF_MODE_FIXED 1
+
+#define SRF_FIXED_INCLUDED
+#endif
+
+void SRFFixedLoadPNs(int num_PNs, float *PNs, int16_t *PNs16);
+void SRFFixedToFloat(int num_vals, int16_t *vals16, float *vals);
+
+int16_t SRFFixedPNDiffsTwoSeeds(int num_PNDiffs, int16_t *PNR16, int16_t *PNF16, int16_t *PND16, int LFSR_seed_low,
+   int LFSR_seed_high);
+int SRFFixedBoundedRange(int num_PNDiffs, int16_t *PND16, float range_low_limit, float range_high_limit, int DIST_range,
+   int16_t largest_neg_PND16);
+void SRFFixedGPEVCal(int num_PNDiffs, int16_t *PND16, int16_t *PNDc16, float range_low_limit, float range_high_limit,
+   int DIST_range, unsigned int RangeConstant, int16_t largest_neg_PND16);
+void SRFFixedAddSpreadFactors(int num_PNDiffs, int16_t *PNDc16, int16_t *PNDco16, int16_t *SF16, int TrimCodeConstant);
+int SRFFixedHelpBitGen(int num_PNDiffs, int16_t *PNDco16, unsigned char *SBS, unsigned char *SHD, unsigned short Threshold);
+
+void SRFFixedDoSRFComp(SRFAlgoParamsStruct *SAP_ptr, int16_t *PND16, int16_t *PNDc16, int16_t *PNDco16);
@@ -14,6 +14,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>  
+#include <stdint.h>
 #include <sqlite3.h>
 #include "commonDB.h"
 #include "common.h"
@@ -29,6 +30,230 @@ typedef struct
    unsigned char *SHD;
    } HelpBitstringStruct;
 
+// Population (PopOnly) SpreadFactor cache. The enrollment data is static so the per-PND medians computed in ComputePxxSpreadFactors() 
+// depend only on the fields of PopSFCacheKeyStruct. Entries are replaced least recently used first. Shared by all workers.
+#define POPSF_CACHE_MAX_ENTRIES 256
+
+typedef struct
+   {
+   sqlite3 *timing_DB;
+   char *ChlngSetName;
+   int design_index;
+   unsigned int DB_ChallengeGen_seed;
+   int chlng_rng_mode;
+   int num_chips;
+   unsigned int LFSR_seed_low;
+   unsigned int LFSR_seed_high;
+   unsigned int RangeConstant;
+   int range_low_limit;
+   int range_high_limit;
+   int dist_range;
+   } PopSFCacheKeyStruct;
+
+typedef struct
+   {
+   PopSFCacheKeyStruct key;
+   float *medians;
+   unsigned long last_used;
+   } PopSFCacheEntryStruct;
+
+typedef struct
+   {
+   pthread_mutex_t mutex;
+   int num_PNDiffs;
+   int max_entries;
+   int num_entries;
+   PopSFCacheEntryStruct *entries;
+   unsigned long use_counter;
+   unsigned long num_hits;
+   unsigned long num_misses;
+   } PopSFCacheStruct;
+
+// Persistent helper threads for the device authentication search, shared by all BankThreads. A BankThread publishes its search on
+// 'job_list' (DASearchJobStruct is private to verifier_regen_funcs.c) and scores chunks of it along with the helpers. Protected by 'mutex'.
+typedef struct
+   {
+   pthread_mutex_t mutex;
+   pthread_cond_t work_cond;
+   pthread_cond_t done_cond;
+   int num_threads;
+   pthread_t *threads;
+   int num_SF_words;
+   int num_PNDiffs;
+   struct DASearchJobStruct *job_list;
+   int stop;
+   } DASearchPoolStruct;
+
+// Number of chips processed together by the batched SRF engine (verifier_SRF_batch.c). The tile arrays below are stored PND-major, 
+// chip-minor, i.e., tile[PND_num*SRF_BATCH_LANES + lane], so one vector load picks up the same PND for SRF_BATCH_LANES chips. Keep
+// this a multiple of 8 (the AVX2 vector width).
+#define SRF_BATCH_LANES 8
+
+typedef struct
+   {
+   int num_PNDiffs;
+
+// PND index sequences generated by the two 11-bit LFSRs for the current seeds. These are the same for every chip.
+   uint16_t *LFSR_low_seq;
+   uint16_t *LFSR_high_seq;
+   unsigned int LFSR_seed_low;
+   unsigned int LFSR_seed_high;
+
+// Structure-of-arrays tile, num_PNDiffs * SRF_BATCH_LANES. Holds PND, then PNDc and finally PNDco in place.
+   float *tile;
+
+// Scratch column handed to ComputeBoundedRange() and the raw bitstrings (Threshold 0) for each lane.
+   float *column;
+   unsigned char *raw_SBS;
+   } SRFBatchStruct;
+
+// Score of one chip in the device authentication search (KEK_DA_SKE_FindMatch()).
+typedef struct
+   {
+   int index; 
+   int NSB; 
+   float NMM;
+   float NMBF;
+   float NTBF;
+   float CC;
+   } AuthenDataStruct;
+
+// Scratch of the device authentication search for up to 'max_chips' chips (DASearchScratchAlloc()): the batched SRF engine, the 
+// per-chip search state of KEK_DA_SKE_BatchSearch() (DA_SEARCH_STATE_INTS ints per chip) and the strong bits extracted by KEK_FSB_SKE() 
+// (num_PNDiffs/8 bytes). Each search pool helper owns one and the worker slab owns one sized for every chip.
+#define DA_SEARCH_STATE_INTS 7
+
+typedef struct
+   {
+   int max_chips;
+   SRFBatchStruct SB;
+   int *chip_state;
+   unsigned char *strong_bits;
+   } DASearchScratchStruct;
+
+// Per-worker slab for the large buffers of an authentication: the PNR/PNF of all chips, the PopOnly PO_PNDc, the SpreadFactors and 
+// XMR_SHD received per target attempt and the device authentication search (the per-chip scores 'ADS' and 'DA_search'). 
+// AllocateWorkerScratch() sizes them from num_chips, num_required_PNDiffs and WORKER_SLAB_INIT_ATTEMPTS. The per-attempt buffers only 
+// ever grow, so once a worker has served its largest request these buffers cost no heap calls. 'num_grows' counts the reallocations 
+// after the initial allocation. NOT covered, and still allocating per attempt: the challenge vectors and masks (GenChallengeDB, 
+// FreeVectorsAndMasks), SQLite (including the PUFInstance lookup after a successful authentication) and the qsort() of ADS, which 
+// glibc may back with a malloc'ed buffer when num_chips is large. worker_slab_test (make test) counts the heap calls of the covered part.
+#define WORKER_SLAB_INIT_ATTEMPTS 32
+
+typedef struct
+   {
+   int num_chips;
+   int num_PNs;
+   float *PN_block;
+   float **PNR_rows;
+   float **PNF_rows;
+   float *PNDc_block;
+   float **PNDc_rows;
+   signed char *authen_SF;
+   int authen_SF_size;
+   unsigned char *authen_XMR_SHD;
+   int authen_XMR_SHD_size;
+   AuthenDataStruct *ADS;
+   DASearchScratchStruct DA_search;
+   int num_grows;
+   } WorkerSlabStruct;
+
+// Asynchronous writer for the ../ANALYSIS stats files (verifier_stats_writer.c). Each worker slot appends records to its own ring, 
+// advancing 'head', and a single flusher thread drains all rings every flush_interval_ms, advancing 'tail'. A ring has exactly one 
+// producer and one consumer, so no lock is taken. When a ring is full the record is either dropped and counted (STATS_WRITER_DROP) 
+// or the worker waits for the flusher (STATS_WRITER_BLOCK). 'create' truncates the file before the record's text is written. The 
+// records are written strictly in 'seq_num' order: 'next_flush_seq_num' is the first one not written yet. 'num_active' counts the 
+// producers inside an add and 'num_rejected' the adds made after 'stop'.
+#define STATS_WRITER_RING_SIZE 256
+#define STATS_WRITER_MAX_NAME_LEN 256
+#define STATS_WRITER_MAX_TEXT_LEN 512
+#define STATS_WRITER_DROP 0
+#define STATS_WRITER_BLOCK 1
+
+typedef struct
+   {
+   unsigned long seq_num;
+   int create;
+   char outfile_name[STATS_WRITER_MAX_NAME_LEN];
+   char text[STATS_WRITER_MAX_TEXT_LEN];
+   } StatsRecordStruct;
+
+typedef struct
+   {
+   StatsRecordStruct *records;
+   unsigned int head;
+   unsigned int tail;
+   unsigned long num_dropped;
+   } StatsRingStruct;
+
+typedef struct
+   {
+   int num_rings;
+   StatsRingStruct *rings;
+   int full_policy;
+   int flush_interval_ms;
+   unsigned long next_seq_num;
+   unsigned long next_flush_seq_num;
+   int stop;
+   int num_active;
+   unsigned long num_rejected;
+   pthread_t flusher_thread;
+   StatsRecordStruct **batch;
+   unsigned long num_written;
+   unsigned long num_batches;
+   } StatsWriterStruct;
+
+// One row of the RunTime DB Bitstrings table, filled in by BuildDBBitstringRecord() (commonDB_RT.c). 'Bitstring' is allocated.
+#define RT_BSTRING_NAME_LEN 500
+
+typedef struct
+   {
+   int design_index;
+   char Netlist_name[RT_BSTRING_NAME_LEN];
+   char Synthesis_name[RT_BSTRING_NAME_LEN];
+   char InstanceName[RT_BSTRING_NAME_LEN];
+   char Dev[RT_BSTRING_NAME_LEN];
+   char Placement[RT_BSTRING_NAME_LEN];
+   int PUFInstance_ID;
+   char ChallengeSetName[RT_BSTRING_NAME_LEN];
+   char CreationDate[RT_BSTRING_NAME_LEN];
+   char SecurityFunction[20];
+   char FixParams[20];
+   int LFSR_seed_low;
+   int LFSR_seed_high;
+   int RangeConstant;
+   int SpreadConstant;
+   int Threshold;
+   char *Bitstring;
+   } RTBitstringRecordStruct;
+
+// Background writer for the RunTime DB (commonDB_RT.c). Workers queue records and return. The writer thread owns its own WAL-mode 
+// connection and inserts the queued records with a prepared statement, one transaction per group of up to 'batch_size' records or 
+// every 'commit_interval_ms', whichever comes first. A worker waits only when all RT_WRITER_QUEUE_SIZE entries are pending. 
+// Records queued after 'stop' are freed and counted in 'num_rejected'. Protected by 'mutex'.
+#define RT_WRITER_QUEUE_SIZE 1024
+
+typedef struct
+   {
+   sqlite3 *db;
+   int batch_size;
+   int commit_interval_ms;
+   RTBitstringRecordStruct *queue[RT_WRITER_QUEUE_SIZE];
+   int head;
+   int num_queued;
+   int stop;
+   int num_flush_requests;
+   unsigned long num_enqueued;
+   unsigned long num_inserted;
+   unsigned long num_commits;
+   unsigned long num_rejected;
+   pthread_t writer_thread;
+   pthread_mutex_t mutex;
+   pthread_cond_t not_empty_cond;
+   pthread_cond_t not_full_cond;
+   pthread_cond_t inserted_cond;
+   } RTBitstringWriterStruct;
+
 typedef struct
    {
    char *DB_name_NAT;
@@ -36,10 +261,10 @@ typedef struct
    sqlite3 *database_NAT;
    sqlite3 *database_AT;
    sqlite3 *database_RT;
+   RTBitstringWriterStruct *RTW_ptr;
 
    pthread_mutex_t *RT_DB_mutex_ptr;
    pthread_mutex_t *FileStat_mutex_ptr;
-   pthread_mutex_t *GenChallenge_mutex_ptr; 
    pthread_mutex_t *Authentication_mutex_ptr; 
 
    pthread_mutex_t *PUFCash_WRec_DB_mutex_ptr;
@@ -57,11 +282,17 @@ typedef struct
 
    int use_database_chlngs;
    unsigned int DB_ChallengeGen_seed;
+   int chlng_rng_mode;
 
    int fix_params;
 
    float **PNR; 
    float **PNF;
+
+// Timing database and challenge set the PNR and PNF were fetched for, set in GenVecSeedChlngsTimingData(). Part of the PopOnly SF cache key.
+   sqlite3 *PNX_timing_DB;
+   char *PNX_ChlngSetName;
+   PopSFCacheStruct *PopSF_cache_ptr;
    float *fPND; 
    float *fPNDc; 
    float *fPNDco; 
@@ -95,6 +326,8 @@ typedef struct
    int do_save_PARCE_COBRA_file_stats;
    int do_save_COBRA_SHD;
    int do_save_SKE_SHD;
+   StatsWriterStruct *SW_ptr;
+   int SW_ring_num;
    unsigned char *DHD_HD; 
    unsigned char *verifier_DHD_SBS; 
    unsigned char *device_DHD_SBS; 
@@ -160,6 +393,16 @@ typedef struct
    int num_TVC_arr_NAT;
    TimingValCacheStruct *TVC_arr_AT;
    int num_TVC_arr_AT;
+   int use_TVC_compact;
+   int use_worker_slab;
+   WorkerSlabStruct slab;
+
+// When 1, BankThread attaches a SockGetB() receive buffer to each device connection and sets TCP_NODELAY on it.
+   int use_sock_buffered_io;
+   TimingValCacheCompactStruct TVCC_NAT;
+   TimingValCacheCompactStruct TVCC_AT;
+   TimingValCacheIndexStruct TVCI_NAT;
+   TimingValCacheIndexStruct TVCI_AT;
 
    HelpBitstringStruct *HBS_arr;
 
@@ -198,6 +441,12 @@ typedef struct
 // 7_4_2022: Used for POP
    int POP_LLK_num_bytes; 
 
+// Device authentication database search: shared helper threads (see KEK_DA_SKE_FindMatch). NULL to search in the BankThread only.
+   DASearchPoolStruct *DA_search_pool_ptr;
+
+// Engine used by DoSRFComp(): SRF_MODE_FLOAT or SRF_MODE_FIXED (verifier_SRF_fixed.c).
+   int SRF_fixed_point_mode;
+
    int DUMP_BITSTRINGS; 
    int DEBUG_FLAG; 
    } SRFAlgoParamsStruct;
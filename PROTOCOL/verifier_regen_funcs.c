@@ -14,18 +14,33 @@
 #include "common.h"
 #include "verifier_common.h"
 #include "verifier_regen_funcs.h"
+#include "verifier_SRF_batch.h"
+#include "verifier_SRF_fixed.h"
+#include "verifier_stats_writer.h"
 #include "commonDB_RT.h"
 #include <math.h>  
 
-typedef struct
+// One device authentication search published to the DASearchPoolStruct. 'SAP' is a snapshot of the BankThread's SAP taken before the
+// search starts: the helpers copy it and substitute their own SpreadFactor buffers. The fields below 'next_chip' are protected by the 
+// pool mutex. The job lives on the stack of the BankThread, which waits for num_scored to reach num_chips before returning.
+typedef struct DASearchJobStruct
    {
-   int index; 
-   int NSB; 
-   float NMM;
-   float NMBF;
-   float NTBF;
-   float CC;
-   } AuthenDataStruct;
+   struct DASearchJobStruct *next;
+   SRFAlgoParamsStruct SAP;
+   AuthenDataStruct *ADS;
+   int max_string_len;
+   int received_XMR_SHD_num_bytes;
+   unsigned char *SKE_authen_XMR_SHD;
+   signed char *authen_SpreadFactors_binary;
+   int current_function;
+   int do_scaling;
+   int PND_num_inspect;
+
+   int next_chip;
+   int num_chips;
+   int num_scored;
+   int balance_cnts[3];
+   } DASearchJobStruct;
 
 // Set to -1 to disable
 #define DO_DUMP_PN_DATA_CHIP_NUM -1
@@ -97,6 +112,114 @@ void FreeAllTimingValsForChallenge(int *num_PUF_instances_ptr, float ***PNR_ptr,
    }
 
 
+// ========================================================================================================
+// ========================================================================================================
+// Allocate the scratch of a device authentication search of up to max_chips chips. 
+
+void DASearchScratchAlloc(DASearchScratchStruct *DSS_ptr, int max_chips, int num_PNDiffs)
+   {
+   DSS_ptr->max_chips = max_chips;
+   SRFBatchAlloc(&(DSS_ptr->SB), num_PNDiffs);
+   if ( (DSS_ptr->chip_state = (int *)malloc(sizeof(int) * max_chips * DA_SEARCH_STATE_INTS)) == NULL )
+      { printf("ERROR: DASearchScratchAlloc(): Failed to allocate storage for chip_state!\n"); exit(EXIT_FAILURE); }
+   if ( (DSS_ptr->strong_bits = (unsigned char *)malloc(sizeof(unsigned char) * num_PNDiffs/8)) == NULL )
+      { printf("ERROR: DASearchScratchAlloc(): Failed to allocate storage for strong_bits!\n"); exit(EXIT_FAILURE); }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Free the storage allocated in DASearchScratchAlloc().
+
+void DASearchScratchFree(DASearchScratchStruct *DSS_ptr)
+   {
+   SRFBatchFree(&(DSS_ptr->SB));
+   if ( DSS_ptr->chip_state != NULL )
+      free(DSS_ptr->chip_state);
+   if ( DSS_ptr->strong_bits != NULL )
+      free(DSS_ptr->strong_bits);
+
+   DSS_ptr->chip_state = NULL;
+   DSS_ptr->strong_bits = NULL;
+   DSS_ptr->max_chips = 0;
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Allocate the per-worker slab. The PN block holds the PNR and PNF (2 * num_PNDiffs floats) of every chip and the 
+// PNDc block the PopOnly PO_PNDc of every chip. The SpreadFactors and XMR_SHD buffers are sized for num_attempts 
+// target attempts and grow in WorkerSlabGrow() if a device needs more.
+
+void WorkerSlabInit(WorkerSlabStruct *WS_ptr, int num_chips, int num_PNDiffs, int num_SF_words, int num_attempts)
+   {
+   int chip_num;
+
+   WS_ptr->num_chips = num_chips;
+   WS_ptr->num_PNs = 2 * num_PNDiffs;
+   WS_ptr->num_grows = 0;
+
+   if ( (WS_ptr->PN_block = (float *)malloc(sizeof(float) * (size_t)num_chips * WS_ptr->num_PNs)) == NULL )
+      { printf("ERROR: WorkerSlabInit(): Failed to allocate storage for PN_block!\n"); exit(EXIT_FAILURE); }
+   if ( (WS_ptr->PNR_rows = (float **)malloc(sizeof(float *) * num_chips)) == NULL )
+      { printf("ERROR: WorkerSlabInit(): Failed to allocate storage for PNR_rows!\n"); exit(EXIT_FAILURE); }
+   if ( (WS_ptr->PNF_rows = (float **)malloc(sizeof(float *) * num_chips)) == NULL )
+      { printf("ERROR: WorkerSlabInit(): Failed to allocate storage for PNF_rows!\n"); exit(EXIT_FAILURE); }
+
+   if ( (WS_ptr->PNDc_block = (float *)malloc(sizeof(float) * (size_t)num_chips * num_PNDiffs)) == NULL )
+      { printf("ERROR: WorkerSlabInit(): Failed to allocate storage for PNDc_block!\n"); exit(EXIT_FAILURE); }
+   if ( (WS_ptr->PNDc_rows = (float **)malloc(sizeof(float *) * num_chips)) == NULL )
+      { printf("ERROR: WorkerSlabInit(): Failed to allocate storage for PNDc_rows!\n"); exit(EXIT_FAILURE); }
+   for ( chip_num = 0; chip_num < num_chips; chip_num++ )
+      WS_ptr->PNDc_rows[chip_num] = &(WS_ptr->PNDc_block[(size_t)chip_num * num_PNDiffs]);
+
+   WS_ptr->authen_SF_size = num_attempts * num_SF_words;
+   if ( (WS_ptr->authen_SF = (signed char *)malloc(sizeof(signed char) * WS_ptr->authen_SF_size)) == NULL )
+      { printf("ERROR: WorkerSlabInit(): Failed to allocate storage for authen_SF!\n"); exit(EXIT_FAILURE); }
+   WS_ptr->authen_XMR_SHD_size = num_attempts * num_PNDiffs/8;
+   if ( (WS_ptr->authen_XMR_SHD = (unsigned char *)malloc(sizeof(unsigned char) * WS_ptr->authen_XMR_SHD_size)) == NULL )
+      { printf("ERROR: WorkerSlabInit(): Failed to allocate storage for authen_XMR_SHD!\n"); exit(EXIT_FAILURE); }
+
+   if ( (WS_ptr->ADS = (AuthenDataStruct *)malloc(sizeof(AuthenDataStruct) * num_chips)) == NULL )
+      { printf("ERROR: WorkerSlabInit(): Failed to allocate storage for ADS!\n"); exit(EXIT_FAILURE); }
+   DASearchScratchAlloc(&(WS_ptr->DA_search), num_chips, num_PNDiffs);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Return a slab buffer of at least num_bytes. The buffer is reallocated (doubled) only when it is too small, and 
+// the contents are preserved as with realloc.
+
+void *WorkerSlabGrow(WorkerSlabStruct *WS_ptr, void *buffer, int *size_ptr, int num_bytes, char *buffer_name)
+   {
+   int new_size;
+
+   if ( num_bytes <= *size_ptr )
+      return buffer;
+
+   new_size = 2 * (*size_ptr);
+   if ( new_size < num_bytes )
+      new_size = num_bytes;
+   if ( (buffer = realloc(buffer, new_size)) == NULL )
+      { printf("ERROR: WorkerSlabGrow(): Failed to grow '%s' to %d bytes!\n", buffer_name, new_size); exit(EXIT_FAILURE); }
+   *size_ptr = new_size;
+   WS_ptr->num_grows++;
+
+#ifdef DEBUG
+printf("WorkerSlabGrow(): Grew '%s' to %d bytes\n", buffer_name, new_size); fflush(stdout);
+#endif
+
+   return buffer;
+   }
+
+
 // ========================================================================================================
 // ========================================================================================================
 // Compute the PND from the PNR/PNF, using two 11-bit LFSR seeds. 
@@ -164,20 +287,23 @@ float ComputePNDiffsTwoSeeds(int num_PNDiffs, float *PNR, float *PNF, float *fPN
 // value in the distribution, subtract that from all values (shifting the distribution left for negative largest 
 // values and right for positive). The binning of values therefore starts at bin 0 and goes up through the largest 
 // positive value (minus the negative value). 
+//
+// Both quantiles are found with a counting select over the DIST_range bins. For 2048 values this is faster than 
+// running quickselect twice (SelectTwoInt()) on the rounded values, which returns the same bounds. The scan of the 
+// bins stops once the high quantile has been passed.
 
 int ComputeBoundedRange(int num_PNDiffs, float *fPND, float range_low_limit, float range_high_limit, int DIST_range, 
    float largest_neg_PND)
    {
    int low_done, low_index = 0, high_index = 0;
-   int PND_num, bin_num, PNDiff_int;
+   int PND_num, PNDiff_int;
    int PN_bins[DIST_range];
    float temp_float;
    int i, range;
-   float sum;
+   int sum;
 
 // Clear out the counts in the distribution bins. Note I double the FPA range to handle differences (negative values).
-   for ( bin_num = 0; bin_num < DIST_range; bin_num++ )
-      PN_bins[bin_num] = 0;
+   memset(PN_bins, 0, sizeof(int) * DIST_range);
 
    for ( PND_num = 0; PND_num < num_PNDiffs; PND_num++ ) 
       {
@@ -195,7 +321,7 @@ int ComputeBoundedRange(int num_PNDiffs, float *fPND, float range_low_limit, flo
       PN_bins[PNDiff_int]++; 
       }
 
-   sum = 0.0;
+   sum = 0;
    low_done = 0;
    for ( i = 0; i < DIST_range; i++ ) 
       { 
@@ -207,6 +333,10 @@ int ComputeBoundedRange(int num_PNDiffs, float *fPND, float range_low_limit, flo
          }
       if ( sum <= range_high_limit )
          { high_index = i; }
+
+// The cumulative count never decreases so neither index can change once both limits have been passed.
+      else if ( low_done == 1 )
+         break;
       }
 
 //   printf("ComputeBoundedRange():Low index %d\tHigh index %d\n", low_index, high_index);
@@ -369,8 +499,17 @@ printf("\tDoSRFComp(): LFSR seed low %u\tLFSR seed high %u\tRangeConstant %d\tSp
       gettimeofday(&t0, 0);
       }
 
-   largest_neg_PND = ComputePNDiffsTwoSeeds(SAP_ptr->num_required_PNDiffs, SAP_ptr->PNR[SAP_ptr->chip_num], SAP_ptr->PNF[SAP_ptr->chip_num], 
-      SAP_ptr->fPND, SAP_ptr->param_LFSR_seed_low, SAP_ptr->param_LFSR_seed_high);
+// The fixed-point engine runs all three steps here and fills in fPND, fPNDc and fPNDco. 
+   if ( SAP_ptr->SRF_fixed_point_mode == SRF_MODE_FIXED )
+      {
+      int16_t PND16[SAP_ptr->num_required_PNDiffs], PNDc16[SAP_ptr->num_required_PNDiffs], PNDco16[SAP_ptr->num_required_PNDiffs];
+
+      SRFFixedDoSRFComp(SAP_ptr, PND16, PNDc16, PNDco16);
+      largest_neg_PND = 0.0;
+      }
+   else
+      largest_neg_PND = ComputePNDiffsTwoSeeds(SAP_ptr->num_required_PNDiffs, SAP_ptr->PNR[SAP_ptr->chip_num], SAP_ptr->PNF[SAP_ptr->chip_num], 
+         SAP_ptr->fPND, SAP_ptr->param_LFSR_seed_low, SAP_ptr->param_LFSR_seed_high);
 
 // DEBUG
    if ( DO_DUMP_PN_DATA_CHIP_NUM != -1 && DO_DUMP_PN_DATA_CHIP_NUM == SAP_ptr->chip_num && do_dump == 1 )
@@ -397,8 +536,9 @@ printf("\tDoSRFComp(): LFSR seed low %u\tLFSR seed high %u\tRangeConstant %d\tSp
       gettimeofday(&t0, 0);
       }
 
-   GPEVCal(SAP_ptr->num_required_PNDiffs, SAP_ptr->fPND, SAP_ptr->fPNDc, SAP_ptr->range_low_limit, SAP_ptr->range_high_limit, SAP_ptr->dist_range, 
-      SAP_ptr->param_RangeConstant, largest_neg_PND);
+   if ( SAP_ptr->SRF_fixed_point_mode != SRF_MODE_FIXED )
+      GPEVCal(SAP_ptr->num_required_PNDiffs, SAP_ptr->fPND, SAP_ptr->fPNDc, SAP_ptr->range_low_limit, SAP_ptr->range_high_limit, 
+         SAP_ptr->dist_range, SAP_ptr->param_RangeConstant, largest_neg_PND);
 
 // DEBUG
    if ( DO_DUMP_PN_DATA_CHIP_NUM != -1 && DO_DUMP_PN_DATA_CHIP_NUM == SAP_ptr->chip_num && do_dump == 1 )
@@ -425,8 +565,9 @@ printf("\tDoSRFComp(): LFSR seed low %u\tLFSR seed high %u\tRangeConstant %d\tSp
       gettimeofday(&t0, 0);
       }
 
-   AddSpreadFactors(SAP_ptr->num_required_PNDiffs, SAP_ptr->fPNDc, SAP_ptr->fPNDco, SAP_ptr->fSpreadFactors, SAP_ptr->param_TrimCodeConstant,
-      SAP_ptr->chip_num);
+   if ( SAP_ptr->SRF_fixed_point_mode != SRF_MODE_FIXED )
+      AddSpreadFactors(SAP_ptr->num_required_PNDiffs, SAP_ptr->fPNDc, SAP_ptr->fPNDco, SAP_ptr->fSpreadFactors, SAP_ptr->param_TrimCodeConstant,
+         SAP_ptr->chip_num);
 
 // DEBUG
    if ( DO_DUMP_PN_DATA_CHIP_NUM != -1 && DO_DUMP_PN_DATA_CHIP_NUM == SAP_ptr->chip_num && do_dump == 1 )
@@ -640,6 +781,162 @@ fflush(stdout);
    }
 
 
+// ===========================================================================================================
+// ===========================================================================================================
+// Allocate the PopOnly SF cache. 'max_entries' medians arrays of 'num_PNDiffs' floats are allocated lazily.
+
+void PopSFCacheInit(PopSFCacheStruct *PSC_ptr, int max_entries, int num_PNDiffs)
+   {
+   if ( max_entries < 1 )
+      { printf("ERROR: PopSFCacheInit(): max_entries %d MUST be >= 1!\n", max_entries); exit(EXIT_FAILURE); }
+
+   if ( (PSC_ptr->entries = (PopSFCacheEntryStruct *)calloc(max_entries, sizeof(PopSFCacheEntryStruct))) == NULL )
+      { printf("ERROR: PopSFCacheInit(): Failed to allocate storage for entries!\n"); exit(EXIT_FAILURE); }
+
+   pthread_mutex_init(&(PSC_ptr->mutex), NULL);
+   PSC_ptr->num_PNDiffs = num_PNDiffs;
+   PSC_ptr->max_entries = max_entries;
+   PSC_ptr->num_entries = 0;
+   PSC_ptr->use_counter = 0;
+   PSC_ptr->num_hits = 0;
+   PSC_ptr->num_misses = 0;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Free the PopOnly SF cache.
+
+void PopSFCacheFree(PopSFCacheStruct *PSC_ptr)
+   {
+   int entry_num;
+
+   if ( PSC_ptr->entries == NULL )
+      return;
+
+   printf("PopSFCacheFree(): Hits %lu\tMisses %lu\tEntries %d\n", PSC_ptr->num_hits, PSC_ptr->num_misses, PSC_ptr->num_entries); 
+   fflush(stdout);
+
+   for ( entry_num = 0; entry_num < PSC_ptr->num_entries; entry_num++ )
+      free(PSC_ptr->entries[entry_num].medians);
+   free(PSC_ptr->entries);
+   PSC_ptr->entries = NULL;
+   PSC_ptr->num_entries = 0;
+   pthread_mutex_destroy(&(PSC_ptr->mutex));
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Build the cache key from the fields of SAP that determine the PopOnly SF medians.
+
+void PopSFCacheMakeKey(SRFAlgoParamsStruct *SAP_ptr, PopSFCacheKeyStruct *key_ptr)
+   {
+   key_ptr->timing_DB = SAP_ptr->PNX_timing_DB;
+   key_ptr->ChlngSetName = SAP_ptr->PNX_ChlngSetName;
+   key_ptr->design_index = SAP_ptr->design_index;
+   key_ptr->DB_ChallengeGen_seed = SAP_ptr->DB_ChallengeGen_seed;
+   key_ptr->chlng_rng_mode = SAP_ptr->chlng_rng_mode;
+   key_ptr->num_chips = SAP_ptr->num_chips;
+   key_ptr->LFSR_seed_low = SAP_ptr->param_LFSR_seed_low;
+   key_ptr->LFSR_seed_high = SAP_ptr->param_LFSR_seed_high;
+   key_ptr->RangeConstant = SAP_ptr->param_RangeConstant;
+   key_ptr->range_low_limit = SAP_ptr->range_low_limit;
+   key_ptr->range_high_limit = SAP_ptr->range_high_limit;
+   key_ptr->dist_range = SAP_ptr->dist_range;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Returns the index of the entry matching the key or -1. MUST be called with the cache mutex held.
+
+int PopSFCacheFind(PopSFCacheStruct *PSC_ptr, PopSFCacheKeyStruct *key_ptr)
+   {
+   PopSFCacheKeyStruct *entry_key_ptr;
+   int entry_num;
+
+   for ( entry_num = 0; entry_num < PSC_ptr->num_entries; entry_num++ )
+      {
+      entry_key_ptr = &(PSC_ptr->entries[entry_num].key);
+
+// Compare the fields most likely to differ first. The name strings are owned by the caller and may be distinct copies of the same name.
+      if ( entry_key_ptr->DB_ChallengeGen_seed == key_ptr->DB_ChallengeGen_seed && 
+         entry_key_ptr->LFSR_seed_low == key_ptr->LFSR_seed_low && entry_key_ptr->LFSR_seed_high == key_ptr->LFSR_seed_high &&
+         entry_key_ptr->timing_DB == key_ptr->timing_DB && entry_key_ptr->design_index == key_ptr->design_index && 
+         entry_key_ptr->chlng_rng_mode == key_ptr->chlng_rng_mode && entry_key_ptr->num_chips == key_ptr->num_chips && 
+         entry_key_ptr->RangeConstant == key_ptr->RangeConstant && entry_key_ptr->range_low_limit == key_ptr->range_low_limit && 
+         entry_key_ptr->range_high_limit == key_ptr->range_high_limit && entry_key_ptr->dist_range == key_ptr->dist_range &&
+         strcmp(entry_key_ptr->ChlngSetName, key_ptr->ChlngSetName) == 0 )
+         return entry_num;
+      }
+   return -1;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Copy the cached medians for the key into 'medians'. Returns 1 on a hit and 0 on a miss.
+
+int PopSFCacheLookup(PopSFCacheStruct *PSC_ptr, PopSFCacheKeyStruct *key_ptr, float *medians)
+   {
+   int entry_num;
+
+   pthread_mutex_lock(&(PSC_ptr->mutex));
+   if ( (entry_num = PopSFCacheFind(PSC_ptr, key_ptr)) >= 0 )
+      {
+      memcpy(medians, PSC_ptr->entries[entry_num].medians, sizeof(float) * PSC_ptr->num_PNDiffs);
+      PSC_ptr->entries[entry_num].last_used = ++(PSC_ptr->use_counter);
+      PSC_ptr->num_hits++;
+      }
+   else
+      PSC_ptr->num_misses++;
+   pthread_mutex_unlock(&(PSC_ptr->mutex));
+
+   return entry_num >= 0;
+   }
+
+
+// ===========================================================================================================
+// ===========================================================================================================
+// Add the medians for the key, replacing the least recently used entry when the cache is full. Another worker
+// may have inserted the same key while we were computing, in which case nothing is done.
+
+void PopSFCacheInsert(PopSFCacheStruct *PSC_ptr, PopSFCacheKeyStruct *key_ptr, float *medians)
+   {
+   PopSFCacheEntryStruct *entry_ptr;
+   int entry_num, LRU_entry_num;
+
+   pthread_mutex_lock(&(PSC_ptr->mutex));
+   if ( PopSFCacheFind(PSC_ptr, key_ptr) >= 0 )
+      {
+      pthread_mutex_unlock(&(PSC_ptr->mutex));
+      return;
+      }
+
+   if ( PSC_ptr->num_entries < PSC_ptr->max_entries )
+      {
+      entry_ptr = &(PSC_ptr->entries[PSC_ptr->num_entries]);
+      if ( (entry_ptr->medians = (float *)malloc(sizeof(float) * PSC_ptr->num_PNDiffs)) == NULL )
+         { printf("ERROR: PopSFCacheInsert(): Failed to allocate storage for medians!\n"); exit(EXIT_FAILURE); }
+      PSC_ptr->num_entries++;
+      }
+   else
+      {
+      LRU_entry_num = 0;
+      for ( entry_num = 1; entry_num < PSC_ptr->num_entries; entry_num++ )
+         if ( PSC_ptr->entries[entry_num].last_used < PSC_ptr->entries[LRU_entry_num].last_used )
+            LRU_entry_num = entry_num;
+      entry_ptr = &(PSC_ptr->entries[LRU_entry_num]);
+      }
+
+   entry_ptr->key = *key_ptr;
+   memcpy(entry_ptr->medians, medians, sizeof(float) * PSC_ptr->num_PNDiffs);
+   entry_ptr->last_used = ++(PSC_ptr->use_counter);
+   pthread_mutex_unlock(&(PSC_ptr->mutex));
+   }
+
+
 // ===========================================================================================================
 // ===========================================================================================================
 // Compute the PCR SpreadFactors. NOTE: YOU CAN NOT reseed srand with the same seed in this routine. In fact,
@@ -677,7 +974,8 @@ void ComputePxxSpreadFactors(int max_string_len, SRFAlgoParamsStruct *SAP_ptr, i
       int chip_num, PND_num;
       float largest_neg_PND;
       float **PO_PNDc; 
-      float *vals;
+      PopSFCacheKeyStruct PopSF_key;
+      int cache_hit;
 
 #ifdef DEBUG
 printf("Compute Pop SF\n"); fflush(stdout);
@@ -695,38 +993,59 @@ printf("Compute Pop SF\n"); fflush(stdout);
 //      else
          num_chips = SAP_ptr->num_chips;
 
-// Allocate space to compute the Median values.
-      if ( (PO_PNDc = (float **)malloc(sizeof(float *) * num_chips)) == NULL )
+// The medians depend only on the challenge and the SRF parameters, not on the device, so check the cache before 
+// touching the data of every chip.
+      cache_hit = 0;
+      if ( SAP_ptr->PopSF_cache_ptr != NULL )
+         {
+         PopSFCacheMakeKey(SAP_ptr, &PopSF_key);
+         cache_hit = PopSFCacheLookup(SAP_ptr->PopSF_cache_ptr, &PopSF_key, fSpreadFactors);
+         }
+
+// Per-chip PNDc are filled in below on a miss. On a hit, only the chip needed by FlipPO_SF() is computed. With the worker slab, the 
+// PNDc rows are already allocated.
+      if ( SAP_ptr->use_worker_slab == 1 )
+         {
+         if ( num_chips > SAP_ptr->slab.num_chips )
+            { 
+            printf("PROGRAM ERROR: ComputePxxSpreadFactors(): Number of chips %d exceeds worker slab size %d!\n", num_chips, SAP_ptr->slab.num_chips); 
+            exit(EXIT_FAILURE); 
+            }
+         PO_PNDc = SAP_ptr->slab.PNDc_rows;
+         }
+      else if ( (PO_PNDc = (float **)calloc(num_chips, sizeof(float *))) == NULL )
          { printf("ERROR: ComputePxxSpreadFactors(): failed to allocate temporary storage for 'PO_PNDc'!\n"); exit(EXIT_FAILURE); }
-      for ( chip_num = 0; chip_num < num_chips; chip_num++ )
-         if ( (PO_PNDc[chip_num] = (float *)malloc(sizeof(float) * SAP_ptr->num_required_PNDiffs)) == NULL )
-            { printf("ERROR: ComputePxxSpreadFactors(): failed to allocate temporary storage for 'PO_PNDc[chip_num]'!\n"); exit(EXIT_FAILURE); }
+
+      if ( cache_hit == 0 )
+         {
+
+// Allocate space to compute the Median values.
+         if ( SAP_ptr->use_worker_slab == 0 )
+            for ( chip_num = 0; chip_num < num_chips; chip_num++ )
+               if ( (PO_PNDc[chip_num] = (float *)malloc(sizeof(float) * SAP_ptr->num_required_PNDiffs)) == NULL )
+                  { printf("ERROR: ComputePxxSpreadFactors(): failed to allocate temporary storage for 'PO_PNDc[chip_num]'!\n"); exit(EXIT_FAILURE); }
 
 // ---------------------------------
 // Compute differences and calibrate
-      for ( chip_num = 0; chip_num < num_chips; chip_num++ )
-         {
+         for ( chip_num = 0; chip_num < num_chips; chip_num++ )
+            {
 // Compute the PND and PNDc for each chip
-         largest_neg_PND = ComputePNDiffsTwoSeeds(SAP_ptr->num_required_PNDiffs, SAP_ptr->PNR[chip_num], SAP_ptr->PNF[chip_num], PO_PNDc[chip_num], 
-            SAP_ptr->param_LFSR_seed_low, SAP_ptr->param_LFSR_seed_high);
+            largest_neg_PND = ComputePNDiffsTwoSeeds(SAP_ptr->num_required_PNDiffs, SAP_ptr->PNR[chip_num], SAP_ptr->PNF[chip_num], PO_PNDc[chip_num], 
+               SAP_ptr->param_LFSR_seed_low, SAP_ptr->param_LFSR_seed_high);
 
 // GPEVCal the PNDc for this chip. NOTE: Source and destination arrays are identical.
-         GPEVCal(SAP_ptr->num_required_PNDiffs, PO_PNDc[chip_num], PO_PNDc[chip_num], SAP_ptr->range_low_limit, SAP_ptr->range_high_limit, 
-            SAP_ptr->dist_range, SAP_ptr->param_RangeConstant, largest_neg_PND);
-         }
+            GPEVCal(SAP_ptr->num_required_PNDiffs, PO_PNDc[chip_num], PO_PNDc[chip_num], SAP_ptr->range_low_limit, SAP_ptr->range_high_limit, 
+               SAP_ptr->dist_range, SAP_ptr->param_RangeConstant, largest_neg_PND);
+            }
 
-// Allocate storage.
-      if ( (vals = (float *)malloc(sizeof(float) * num_chips)) == NULL )
-         { printf("ERROR: ComputePxxSpreadFactors(): failed to allocate temporary storage for 'vals'!\n"); exit(EXIT_FAILURE); }
+// For each PNDc, compute the median value across the chips.
+         ComputeColumnMedians(num_chips, SAP_ptr->num_required_PNDiffs, PO_PNDc, fSpreadFactors);
 
-// For each PNDc, compute the median value.
-      for ( PND_num = 0; PND_num < SAP_ptr->num_required_PNDiffs; PND_num++ )
-         {
-         for ( chip_num = 0; chip_num < num_chips; chip_num++ )
-            vals[chip_num] = PO_PNDc[chip_num][PND_num];
+         for ( PND_num = 0; PND_num < SAP_ptr->num_required_PNDiffs; PND_num++ )
+            {
 
 // These MUST be rounded to 4 binary digits for ReduceRawSF to work properly.
-         fSpreadFactors[PND_num] = (float)((int)(ComputeMedian(num_chips, vals)*16.0))/16.0;
+            fSpreadFactors[PND_num] = (float)((int)(fSpreadFactors[PND_num]*16.0))/16.0;
 
 // They will NOT fit until they are trimmed below by ReduceRawSF().
 //         iSpreadFactors[PND_num] = (signed short)(fSpreadFactors[PND_num] * (float)SAP_ptr->iSpreadFactorScaler);
@@ -754,6 +1073,10 @@ if ( PND_num < 10 )
    printf("\tPND %d\tnum chips %d\tnum_pos %d\tnum neg %d\tnum_zeros %d\n", PND_num, num_chips, num_pos_vals, num_neg_vals, num_zero_vals); fflush(stdout);
    }
 #endif
+            }
+
+         if ( SAP_ptr->PopSF_cache_ptr != NULL )
+            PopSFCacheInsert(SAP_ptr->PopSF_cache_ptr, &PopSF_key, fSpreadFactors);
          }
 
 // -----------------------------------------
@@ -783,18 +1106,33 @@ for ( j = 0; j < 10; j++ )
                SAP_ptr->chip_num, num_chips);
             }
          else
+            {
+
+// On a cache hit, compute the PNDc for just this chip.
+            if ( cache_hit == 1 )
+               {
+               if ( SAP_ptr->use_worker_slab == 0 )
+                  if ( (PO_PNDc[SAP_ptr->chip_num] = (float *)malloc(sizeof(float) * SAP_ptr->num_required_PNDiffs)) == NULL )
+                     { printf("ERROR: ComputePxxSpreadFactors(): failed to allocate temporary storage for 'PO_PNDc[chip_num]'!\n"); exit(EXIT_FAILURE); }
+               largest_neg_PND = ComputePNDiffsTwoSeeds(SAP_ptr->num_required_PNDiffs, SAP_ptr->PNR[SAP_ptr->chip_num], 
+                  SAP_ptr->PNF[SAP_ptr->chip_num], PO_PNDc[SAP_ptr->chip_num], SAP_ptr->param_LFSR_seed_low, SAP_ptr->param_LFSR_seed_high);
+               GPEVCal(SAP_ptr->num_required_PNDiffs, PO_PNDc[SAP_ptr->chip_num], PO_PNDc[SAP_ptr->chip_num], SAP_ptr->range_low_limit, 
+                  SAP_ptr->range_high_limit, SAP_ptr->dist_range, SAP_ptr->param_RangeConstant, largest_neg_PND);
+               }
             FlipPO_SF(max_string_len, PO_PNDc[SAP_ptr->chip_num], fSpreadFactors, iSpreadFactors, SAP_ptr->iSpreadFactorScaler, 
                SAP_ptr->num_required_PNDiffs, TrimCodeConstant);
+            }
          }
 
-// Free the space.
-      for ( chip_num = 0; chip_num < num_chips; chip_num++ )
-         if ( PO_PNDc[chip_num] != NULL )
-            free(PO_PNDc[chip_num]);
-      if ( PO_PNDc != NULL )
-         free(PO_PNDc); 
-      if ( vals != NULL )
-         free(vals);
+// Free the space (the slab rows are kept for the next challenge).
+      if ( SAP_ptr->use_worker_slab == 0 )
+         {
+         for ( chip_num = 0; chip_num < num_chips; chip_num++ )
+            if ( PO_PNDc[chip_num] != NULL )
+               free(PO_PNDc[chip_num]);
+         if ( PO_PNDc != NULL )
+            free(PO_PNDc); 
+         }
       return;
       }
 
@@ -1224,7 +1562,8 @@ printf("ComputeSendSpreadFactors(): Chip set for calculation of PCR SpreadFactor
 // from the timing DB and fetch the timing data into PNR and PNF arrays.
 
 void GenVecSeedChlngsTimingData(int max_string_len, SRFAlgoParamsStruct *SAP_ptr, sqlite3 *timing_DB,
-   char *ChlngSetName, TimingValCacheStruct *TVC_arr, int num_TVC_arr, int RANDOM)
+   char *ChlngSetName, TimingValCacheStruct *TVC_arr, int num_TVC_arr, TimingValCacheCompactStruct *TVCC_ptr, 
+   TimingValCacheIndexStruct *TVCI_ptr, int RANDOM)
    { 
 
 // If the user wants to randomize the challenge vectors by selecting a random seed (vs. what is stored in 
@@ -1252,7 +1591,7 @@ void GenVecSeedChlngsTimingData(int max_string_len, SRFAlgoParamsStruct *SAP_ptr
 
       GenChallengeDB(max_string_len, timing_DB, SAP_ptr->design_index, ChlngSetName, SAP_ptr->DB_ChallengeGen_seed, 0, 
          NULL, NULL, &(SAP_ptr->first_vecs_b), &(SAP_ptr->second_vecs_b), &(SAP_ptr->masks_b), &(SAP_ptr->num_vecs), 
-         &(SAP_ptr->num_rise_vecs), SAP_ptr->GenChallenge_mutex_ptr, &num_challenge_vecpair_id_PO, 
+         &(SAP_ptr->num_rise_vecs), SAP_ptr->chlng_rng_mode, &num_challenge_vecpair_id_PO, 
          &challenge_vecpair_id_PO_arr);
 
 printf("\tGenVecSeedChlngsTimingData(): Number of vectors read %d\tNumber of rising vectors %d\n", SAP_ptr->num_vecs, 
@@ -1265,8 +1604,27 @@ printf("\tGenVecSeedChlngsTimingData(): Number of vectors read %d\tNumber of ris
 // constructed by GenChallengeDB as the random challenge is generated and are guaranteed to match the PN tested by these 
 // challenge vectors/masks. Use '%' for * and '_' for ? in pattern match. The PNR and PNF are DYNAMICALLY allocated based 
 // on the challenge and will need to be freed once we are done with them.
-      GetAllPUFInstanceTimingValsForChallenge(max_string_len, timing_DB, challenge_vecpair_id_PO_arr, num_challenge_vecpair_id_PO, 
-         "%", &(SAP_ptr->PNR), &(SAP_ptr->PNF), &(SAP_ptr->num_chips), TVC_arr, num_TVC_arr, SAP_ptr->use_TVC_cache);
+// With the worker slab, the PNR and PNF rows are carved out of the slab PN block and nothing is allocated.
+      if ( SAP_ptr->use_worker_slab == 1 )
+         {
+         if ( num_challenge_vecpair_id_PO > SAP_ptr->slab.num_PNs )
+            { 
+            printf("PROGRAM ERROR: GenVecSeedChlngsTimingData(): Challenge with %d PNs exceeds worker slab size %d!\n", 
+               num_challenge_vecpair_id_PO, SAP_ptr->slab.num_PNs); 
+            exit(EXIT_FAILURE); 
+            }
+         SAP_ptr->PNR = SAP_ptr->slab.PNR_rows;
+         SAP_ptr->PNF = SAP_ptr->slab.PNF_rows;
+         GetAllPUFInstanceTimingValsForChallenge(max_string_len, timing_DB, challenge_vecpair_id_PO_arr, num_challenge_vecpair_id_PO, 
+            "%", &(SAP_ptr->PNR), &(SAP_ptr->PNF), &(SAP_ptr->num_chips), TVC_arr, num_TVC_arr, TVCC_ptr, 
+            TVCI_ptr, SAP_ptr->use_TVC_cache, SAP_ptr->slab.PN_block, SAP_ptr->slab.num_chips);
+         }
+      else
+         GetAllPUFInstanceTimingValsForChallenge(max_string_len, timing_DB, challenge_vecpair_id_PO_arr, num_challenge_vecpair_id_PO, 
+            "%", &(SAP_ptr->PNR), &(SAP_ptr->PNF), &(SAP_ptr->num_chips), TVC_arr, num_TVC_arr, TVCC_ptr, 
+            TVCI_ptr, SAP_ptr->use_TVC_cache, NULL, 0);
+      SAP_ptr->PNX_timing_DB = timing_DB;
+      SAP_ptr->PNX_ChlngSetName = ChlngSetName;
 
 // Free up the challenge_vecpair_id_PO_arr. We'll free the vectors and timing data in the caller if it isn't needed again 
 // for something else.
@@ -1301,7 +1659,7 @@ void CommonCore(int max_string_len, SRFAlgoParamsStruct *SAP_ptr, int device_soc
       {
 
       GenVecSeedChlngsTimingData(max_string_len, SAP_ptr, SAP_ptr->database_NAT, SAP_ptr->ChallengeSetName_NAT, SAP_ptr->TVC_arr_NAT, 
-         SAP_ptr->num_TVC_arr_NAT, RANDOM);
+         SAP_ptr->num_TVC_arr_NAT, &(SAP_ptr->TVCC_NAT), &(SAP_ptr->TVCI_NAT), RANDOM);
 
 // Receive 'GO' and send vectors and masks
       int wait_for_GO = 1;
@@ -1488,12 +1846,22 @@ int GenChlngDeliverSpreadFactorsToDevice(int max_string_len, SRFAlgoParamsStruct
 // ========================================================================================================
 // ========================================================================================================
 // We MUST save the individual curves to separate files here (unlike ZED analysis) because we keep adding to them as 
-// authentications progress. 
+// authentications progress. With the stats writer, the point is handed to the worker's ring and written by the flusher.
 
-void WriteAuthenPointToFile(int max_string_len, char *outfile_name, int authen_num, char *wfm_header_str, float fval)
+void WriteAuthenPointToFile(int max_string_len, SRFAlgoParamsStruct *SAP_ptr, char *outfile_name, int authen_num, char *wfm_header_str, 
+   float fval)
    {
    FILE *OUTFILE;
 
+   if ( SAP_ptr->SW_ptr != NULL )
+      {
+      if ( authen_num == 0 )
+         StatsWriterPrintf(SAP_ptr->SW_ptr, SAP_ptr->SW_ring_num, outfile_name, 1, "%s%d\t%f\n", wfm_header_str, authen_num, fval);
+      else
+         StatsWriterPrintf(SAP_ptr->SW_ptr, SAP_ptr->SW_ring_num, outfile_name, 0, "%d\t%f\n", authen_num, fval);
+      return;
+      }
+
    if ( authen_num == 0 && (OUTFILE = fopen(outfile_name, "w")) == NULL )
       { printf("ERROR: WriteAuthenPointToFile(): Data file '%s' open failed for writing!\n", outfile_name); exit(EXIT_FAILURE); }
    else if ( authen_num != 0 && (OUTFILE = fopen(outfile_name, "a")) == NULL )
@@ -1511,6 +1879,407 @@ void WriteAuthenPointToFile(int max_string_len, char *outfile_name, int authen_n
    }
 
 
+// ========================================================================================================
+// ========================================================================================================
+// Batched version of the chip search loop in KEK_DA_SKE_FindMatch() (check_all_chips = 1). The per-chip loop
+// calls CommonCore() and DoSRFComp() for every (chip, target_attempts) pair, even though the parameters, the LFSR
+// sequences and the SpreadFactors depend ONLY on target_attempts. Here the loops are swapped: for each target_attempts
+// we select parameters and restore the SpreadFactors once, and then run the SRF engine on SRF_BATCH_LANES chips at a
+// time with SRFBatchRawBitstrings(). The XMR matching and the statistics stored in ADS are identical to the per-chip
+// loop. Chips first_chip through last_chip - 1 are scored. balance_cnts gets the number of positive, negative and zero
+// fPNDco at PND_num_inspect on the first iteration (debug statistic of the caller). All buffers come from DSS_ptr.
+
+void KEK_DA_SKE_BatchSearch(int max_string_len, SRFAlgoParamsStruct *SAP_ptr, int received_XMR_SHD_num_bytes, 
+   unsigned char *SKE_authen_XMR_SHD, signed char *authen_SpreadFactors_binary, int current_function, int do_scaling, 
+   AuthenDataStruct *ADS, int first_chip, int last_chip, int PND_num_inspect, int *balance_cnts, DASearchScratchStruct *DSS_ptr)
+   {
+   unsigned char KEK_authentication_nonce_reproduced[SAP_ptr->num_KEK_authen_nonce_bits/8];
+   int *active_chips, *current_num_strong_bits, *bits_remaining, *num_mismatches; 
+   int *num_minority_bit_flips, *true_minority_bit_flips;
+   int num_active, num_still_active, target_attempts, num_strong_bits, num_lanes;
+   int chip_num, chip_cnt, lane, block, num_bits_to_check, i, j;
+   SRFBatchStruct *SB_ptr = &(DSS_ptr->SB);
+   unsigned char *raw_SBS;
+   float fPNDco;
+
+   int compute_SpreadFactors = 0;
+   int send_SpreadFactors = 0;
+   int compute_PCR_PBD_SF = 0;
+   int do_part_A_part_B_both = 1;
+   int set_threshold_to_zero = 0;
+
+   int num_search_chips = last_chip - first_chip;
+
+   if ( num_search_chips <= 0 )
+      return;
+
+// Sanity check.
+   if ( num_search_chips > DSS_ptr->max_chips || DSS_ptr->SB.num_PNDiffs != SAP_ptr->num_required_PNDiffs )
+      { printf("PROGRAM ERROR: KEK_DA_SKE_BatchSearch(): Search of %d chips (%d PNDiffs) exceeds scratch of %d chips (%d PNDiffs)!\n", 
+         num_search_chips, SAP_ptr->num_required_PNDiffs, DSS_ptr->max_chips, DSS_ptr->SB.num_PNDiffs); exit(EXIT_FAILURE); }
+
+// Per-chip state that the per-chip loop keeps in local variables. 
+   active_chips = DSS_ptr->chip_state;
+   current_num_strong_bits = active_chips + num_search_chips;
+   bits_remaining = current_num_strong_bits + num_search_chips;
+   num_mismatches = bits_remaining + num_search_chips;
+   num_minority_bit_flips = num_mismatches + num_search_chips;
+   true_minority_bit_flips = num_minority_bit_flips + num_search_chips;
+
+   for ( chip_cnt = 0; chip_cnt < num_search_chips; chip_cnt++ )
+      {
+      chip_num = first_chip + chip_cnt;
+
+// Sanity check.
+      if ( do_scaling == 1 && SAP_ptr->ChipScalingConstantNotifiedArr[chip_num] == 1 && SAP_ptr->ChipScalingConstantArr[chip_num] == 0.0 )
+         { printf("ERROR: KEK_DA_SKE_BatchSearch(): ChipScalingConstantNotifiedArr[x] is 1 but ChipScalingConstantArr[x] value is 0.0"); exit(EXIT_FAILURE); }
+
+      ADS[chip_num].index = chip_num;
+      ADS[chip_num].NSB = 0;
+      ADS[chip_num].NMM = 0.0;
+      ADS[chip_num].NMBF = 0.0;
+      ADS[chip_num].NTBF = 0.0;
+      ADS[chip_num].CC = 0.0;
+
+      active_chips[chip_cnt] = chip_num;
+      current_num_strong_bits[chip_cnt] = 0;
+      bits_remaining[chip_cnt] = SAP_ptr->num_KEK_authen_nonce_bits;
+      num_mismatches[chip_cnt] = 0;
+      num_minority_bit_flips[chip_cnt] = 0;
+      true_minority_bit_flips[chip_cnt] = 0;
+      }
+   num_active = num_search_chips;
+
+   target_attempts = 0;
+   while ( num_active > 0 )
+      {
+
+// Call CommonCore to reset the parameters (LFSR_seed_high) based on XOR_nonce and target_attempts. Do not compute or send SpreadFactors.
+// This is done ONCE for all chips.
+      CommonCore(max_string_len, SAP_ptr, 0, 0, set_threshold_to_zero, target_attempts, do_part_A_part_B_both, current_function, 
+         compute_SpreadFactors, send_SpreadFactors, compute_PCR_PBD_SF);
+
+// Use SpreadFactors already collected by parent. SAME server-generated SF is used for EVERY chip.
+      for ( i = 0, j = target_attempts * SAP_ptr->num_SF_words; i < SAP_ptr->num_SF_words; i++, j++ )
+         {
+         SAP_ptr->iSpreadFactors[i] = authen_SpreadFactors_binary[j];
+         SAP_ptr->fSpreadFactors[i] = (float)authen_SpreadFactors_binary[j]/(float)SAP_ptr->iSpreadFactorScaler;
+         }
+
+      SRFBatchSetLFSRSeeds(SB_ptr, SAP_ptr->param_LFSR_seed_low, SAP_ptr->param_LFSR_seed_high);
+
+// Sanity check. The number of iterations here should NEVER exceed what the device did to generate the received_XMR_SHD_num_bytes.
+      if ( target_attempts*SAP_ptr->num_required_PNDiffs/8 >= received_XMR_SHD_num_bytes )
+         { printf("ERROR: KEK_DA_SKE_BatchSearch(): server target attempts exceed size of SKE_authen_XMR_SHD!\n"); exit(EXIT_FAILURE); }
+
+      for ( block = 0; block < num_active; block += SRF_BATCH_LANES )
+         {
+         num_lanes = num_active - block;
+         if ( num_lanes > SRF_BATCH_LANES )
+            num_lanes = SRF_BATCH_LANES;
+
+// Run the SRF engine for this block of chips. Same result as DoSRFComp(), the ScalingConstant adjustment and SingleHelpBitGen() 
+// with Threshold 0 in the per-chip loop.
+         SRFBatchRawBitstrings(SAP_ptr, SB_ptr, &(active_chips[block]), num_lanes, do_scaling);
+
+         for ( lane = 0; lane < num_lanes; lane++ )
+            {
+            chip_num = active_chips[block + lane];
+            chip_cnt = chip_num - first_chip;
+            raw_SBS = SB_ptr->raw_SBS + lane*SAP_ptr->num_required_PNDiffs/8;
+
+            if ( target_attempts == 0 )
+               {
+               fPNDco = SB_ptr->tile[PND_num_inspect*SRF_BATCH_LANES + lane];
+               if ( fPNDco > 0.0 )
+                  balance_cnts[0]++;
+               if ( fPNDco < 0.0 )
+                  balance_cnts[1]++;
+               if ( fPNDco == 0.0 )
+                  balance_cnts[2]++;
+               }
+
+// Regenerate the next portion of the authentication nonce from the raw bitstring and the device's XMR helper data.
+            num_strong_bits = KEK_FSB_SKE(SAP_ptr->num_required_PNDiffs, SAP_ptr->XMR_val, 
+               SKE_authen_XMR_SHD + target_attempts*SAP_ptr->num_required_PNDiffs/8, raw_SBS, NULL, bits_remaining[chip_cnt], 
+               KEK_authentication_nonce_reproduced, 1, 1, &(num_minority_bit_flips[chip_cnt]), current_num_strong_bits[chip_cnt], 
+               SAP_ptr->KEK_authentication_nonce, &(true_minority_bit_flips[chip_cnt]), 1, chip_num, 0, DSS_ptr->strong_bits);
+            bits_remaining[chip_cnt] -= num_strong_bits;
+
+// Count the number of mismatches. Do NOT try to match bits beyond the last KEK_authentication_nonce bit.
+            num_bits_to_check = SAP_ptr->num_KEK_authen_nonce_bits - current_num_strong_bits[chip_cnt];
+            if ( num_bits_to_check > num_strong_bits )
+               num_bits_to_check = num_strong_bits;
+            if ( num_bits_to_check > 0 )
+               num_mismatches[chip_cnt] += BitStringCountMismatches(KEK_authentication_nonce_reproduced, 0, SAP_ptr->KEK_authentication_nonce, 
+                  current_num_strong_bits[chip_cnt], num_bits_to_check);
+
+            if ( num_strong_bits == 0 )
+               { printf("ERROR: Chip %d\tNumber of strong bits is 0!\n", chip_num); exit(EXIT_FAILURE); }
+
+// The per-chip loop also joins the reproduced bits into SAP_ptr->DA_nonce_reproduced, which is debug only. Just track the count.
+            current_num_strong_bits[chip_cnt] += num_strong_bits;
+
+// Keep updating these on multiple iterations.
+            ADS[chip_num].NSB = current_num_strong_bits[chip_cnt];
+            ADS[chip_num].NMM = (float)num_mismatches[chip_cnt];
+            ADS[chip_num].NMBF += (float)num_minority_bit_flips[chip_cnt];
+            ADS[chip_num].NTBF += (float)true_minority_bit_flips[chip_cnt];
+            ADS[chip_num].CC = ADS[chip_num].NTBF + ADS[chip_num].NMM;
+
+            if ( current_num_strong_bits[chip_cnt] >= SAP_ptr->num_KEK_authen_nonce_bits )
+               current_num_strong_bits[chip_cnt] = SAP_ptr->num_KEK_authen_nonce_bits;
+            }
+         }
+
+// Drop the chips that have reproduced the entire nonce. 
+      num_still_active = 0;
+      for ( i = 0; i < num_active; i++ )
+         if ( current_num_strong_bits[active_chips[i] - first_chip] < SAP_ptr->num_KEK_authen_nonce_bits )
+            active_chips[num_still_active++] = active_chips[i];
+      num_active = num_still_active;
+
+      target_attempts++;
+      }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Hand out the next chunk of DA_SEARCH_CHUNK_CHIPS chips of 'job_ptr'. The job is unlinked from the pool's list 
+// when its last chunk is handed out. Called with the pool mutex held.
+
+static void DASearchTakeChunk(DASearchPoolStruct *DSP_ptr, DASearchJobStruct *job_ptr, int *first_chip_ptr, int *last_chip_ptr)
+   {
+   DASearchJobStruct **link_ptr;
+
+   *first_chip_ptr = job_ptr->next_chip;
+   *last_chip_ptr = job_ptr->next_chip + DA_SEARCH_CHUNK_CHIPS;
+   if ( *last_chip_ptr > job_ptr->num_chips )
+      *last_chip_ptr = job_ptr->num_chips;
+   job_ptr->next_chip = *last_chip_ptr;
+
+   if ( job_ptr->next_chip == job_ptr->num_chips )
+      for ( link_ptr = &(DSP_ptr->job_list); *link_ptr != NULL; link_ptr = &((*link_ptr)->next) )
+         if ( *link_ptr == job_ptr )
+            {
+            *link_ptr = job_ptr->next;
+            break;
+            }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Add the results of a scored chunk to its job and wake up the BankThread when the last chunk is in. The ADS 
+// entries are written by the search itself (chunks never overlap). Called with the pool mutex held. 
+
+static void DASearchMergeChunk(DASearchPoolStruct *DSP_ptr, DASearchJobStruct *job_ptr, int first_chip, int last_chip, 
+   int *balance_cnts)
+   {
+   job_ptr->num_scored += last_chip - first_chip;
+   job_ptr->balance_cnts[0] += balance_cnts[0];
+   job_ptr->balance_cnts[1] += balance_cnts[1];
+   job_ptr->balance_cnts[2] += balance_cnts[2];
+   if ( job_ptr->num_scored == job_ptr->num_chips )
+      pthread_cond_broadcast(&(DSP_ptr->done_cond));
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Helper thread of the device authentication search pool. Scores chunks of whichever search is at the head of the 
+// job list, using a private copy of the search's SAP (CommonCore and the batched search overwrite the parameters and 
+// SpreadFactors) and its own search scratch, and sleeps when there is nothing to do. 
+
+static void *DASearchThread(void *arg)
+   {
+   DASearchPoolStruct *DSP_ptr = (DASearchPoolStruct *)arg;
+   DASearchJobStruct *job_ptr;
+   SRFAlgoParamsStruct SAP;
+   float *fSpreadFactors;
+   signed char *iSpreadFactors;
+   DASearchScratchStruct DA_search;
+   int first_chip, last_chip;
+   int balance_cnts[3];
+
+   DASearchScratchAlloc(&DA_search, DA_SEARCH_CHUNK_CHIPS, DSP_ptr->num_PNDiffs);
+   if ( (fSpreadFactors = (float *)calloc(DSP_ptr->num_SF_words, sizeof(float))) == NULL ||
+      (iSpreadFactors = (signed char *)calloc(DSP_ptr->num_SF_words, sizeof(signed char))) == NULL )
+      { printf("ERROR: DASearchThread(): Failed to allocate SpreadFactors!\n"); exit(EXIT_FAILURE); }
+
+   pthread_mutex_lock(&(DSP_ptr->mutex));
+   while (1)
+      {
+      job_ptr = DSP_ptr->job_list;
+      if ( job_ptr == NULL )
+         {
+         if ( DSP_ptr->stop == 1 )
+            break;
+         pthread_cond_wait(&(DSP_ptr->work_cond), &(DSP_ptr->mutex));
+         continue;
+         }
+      DASearchTakeChunk(DSP_ptr, job_ptr, &first_chip, &last_chip);
+      pthread_mutex_unlock(&(DSP_ptr->mutex));
+
+// Everything referenced through the SAP copy other than the SpreadFactors (PNR, PNF, XOR_nonce, KEK_authentication_nonce, 
+// ScalingConstant arrays) is only read by the search.
+      SAP = job_ptr->SAP;
+      SAP.fSpreadFactors = fSpreadFactors;
+      SAP.iSpreadFactors = iSpreadFactors;
+      SAP.DA_nonce_reproduced = NULL;
+
+      balance_cnts[0] = balance_cnts[1] = balance_cnts[2] = 0;
+      KEK_DA_SKE_BatchSearch(job_ptr->max_string_len, &SAP, job_ptr->received_XMR_SHD_num_bytes, job_ptr->SKE_authen_XMR_SHD, 
+         job_ptr->authen_SpreadFactors_binary, job_ptr->current_function, job_ptr->do_scaling, job_ptr->ADS, first_chip, last_chip, 
+         job_ptr->PND_num_inspect, balance_cnts, &DA_search);
+
+// The job may be gone as soon as the mutex is released after the last chunk is merged.
+      pthread_mutex_lock(&(DSP_ptr->mutex));
+      DASearchMergeChunk(DSP_ptr, job_ptr, first_chip, last_chip, balance_cnts);
+      }
+   pthread_mutex_unlock(&(DSP_ptr->mutex));
+
+   free(fSpreadFactors);
+   free(iSpreadFactors);
+   DASearchScratchFree(&DA_search);
+
+   return NULL;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Start the device authentication search pool. 'num_threads' helpers are shared by all BankThreads, each of which 
+// also scores chunks of its own search, so the threads are created once and not per authentication. 
+
+void DASearchPoolInit(DASearchPoolStruct *DSP_ptr, int num_threads, int num_SF_words, int num_PNDiffs)
+   {
+   int thread_num;
+
+   if ( num_threads < 1 )
+      { printf("ERROR: DASearchPoolInit(): num_threads %d MUST be >= 1!\n", num_threads); exit(EXIT_FAILURE); }
+
+   pthread_mutex_init(&(DSP_ptr->mutex), NULL);
+   pthread_cond_init(&(DSP_ptr->work_cond), NULL);
+   pthread_cond_init(&(DSP_ptr->done_cond), NULL);
+   DSP_ptr->num_threads = num_threads;
+   DSP_ptr->num_SF_words = num_SF_words;
+   DSP_ptr->num_PNDiffs = num_PNDiffs;
+   DSP_ptr->job_list = NULL;
+   DSP_ptr->stop = 0;
+
+   if ( (DSP_ptr->threads = (pthread_t *)calloc(num_threads, sizeof(pthread_t))) == NULL )
+      { printf("ERROR: DASearchPoolInit(): Failed to allocate threads!\n"); exit(EXIT_FAILURE); }
+   for ( thread_num = 0; thread_num < num_threads; thread_num++ )
+      if ( pthread_create(&(DSP_ptr->threads[thread_num]), NULL, DASearchThread, (void *)DSP_ptr) != 0 )
+         { printf("ERROR: DASearchPoolInit(): Failed to create search thread %d!\n", thread_num); exit(EXIT_FAILURE); }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Stop and join the helpers. No search may be in progress, i.e., call this only after the BankThreads are idle.
+
+void DASearchPoolShutdown(DASearchPoolStruct *DSP_ptr)
+   {
+   int thread_num;
+
+   pthread_mutex_lock(&(DSP_ptr->mutex));
+   DSP_ptr->stop = 1;
+   pthread_cond_broadcast(&(DSP_ptr->work_cond));
+   pthread_mutex_unlock(&(DSP_ptr->mutex));
+
+   for ( thread_num = 0; thread_num < DSP_ptr->num_threads; thread_num++ )
+      pthread_join(DSP_ptr->threads[thread_num], NULL);
+   free(DSP_ptr->threads);
+   DSP_ptr->threads = NULL;
+
+   pthread_cond_destroy(&(DSP_ptr->work_cond));
+   pthread_cond_destroy(&(DSP_ptr->done_cond));
+   pthread_mutex_destroy(&(DSP_ptr->mutex));
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Score all chips with the help of the search pool. The BankThread scores the first chunk with its own SAP before 
+// the job is published (so the SRF parameters the caller uses in the statistics file names are set exactly as in the 
+// single-threaded search) and keeps taking chunks until none are left. Every chip is scored, so the ranking is the 
+// same as with the single-threaded search. The BankThread's chunks use DSS_ptr.
+
+void KEK_DA_SKE_PoolSearch(int max_string_len, SRFAlgoParamsStruct *SAP_ptr, int received_XMR_SHD_num_bytes, 
+   unsigned char *SKE_authen_XMR_SHD, signed char *authen_SpreadFactors_binary, int current_function, int do_scaling, 
+   AuthenDataStruct *ADS, int num_chips, int PND_num_inspect, int *balance_cnts, DASearchScratchStruct *DSS_ptr)
+   {
+   DASearchPoolStruct *DSP_ptr = SAP_ptr->DA_search_pool_ptr;
+   DASearchJobStruct job;
+   int first_chip, last_chip;
+   int chunk_balance_cnts[3];
+
+   job.next = NULL;
+   job.SAP = *SAP_ptr;
+   job.ADS = ADS;
+   job.max_string_len = max_string_len;
+   job.received_XMR_SHD_num_bytes = received_XMR_SHD_num_bytes;
+   job.SKE_authen_XMR_SHD = SKE_authen_XMR_SHD;
+   job.authen_SpreadFactors_binary = authen_SpreadFactors_binary;
+   job.current_function = current_function;
+   job.do_scaling = do_scaling;
+   job.PND_num_inspect = PND_num_inspect;
+   job.next_chip = 0;
+   job.num_chips = num_chips;
+   job.num_scored = 0;
+   job.balance_cnts[0] = job.balance_cnts[1] = job.balance_cnts[2] = 0;
+
+// Claim the first chunk, then publish the rest (if any) to the helpers.
+   pthread_mutex_lock(&(DSP_ptr->mutex));
+   DASearchTakeChunk(DSP_ptr, &job, &first_chip, &last_chip);
+   if ( job.next_chip < num_chips )
+      {
+      job.next = DSP_ptr->job_list;
+      DSP_ptr->job_list = &job;
+      pthread_cond_broadcast(&(DSP_ptr->work_cond));
+      }
+   pthread_mutex_unlock(&(DSP_ptr->mutex));
+
+   while (1)
+      {
+      chunk_balance_cnts[0] = chunk_balance_cnts[1] = chunk_balance_cnts[2] = 0;
+      KEK_DA_SKE_BatchSearch(max_string_len, SAP_ptr, received_XMR_SHD_num_bytes, SKE_authen_XMR_SHD, authen_SpreadFactors_binary, 
+         current_function, do_scaling, ADS, first_chip, last_chip, PND_num_inspect, chunk_balance_cnts, DSS_ptr);
+
+      pthread_mutex_lock(&(DSP_ptr->mutex));
+      DASearchMergeChunk(DSP_ptr, &job, first_chip, last_chip, chunk_balance_cnts);
+      if ( job.next_chip == num_chips )
+         break;
+      DASearchTakeChunk(DSP_ptr, &job, &first_chip, &last_chip);
+      pthread_mutex_unlock(&(DSP_ptr->mutex));
+      }
+
+// Wait for the chunks still being scored by the helpers. 
+   while ( job.num_scored < num_chips )
+      pthread_cond_wait(&(DSP_ptr->done_cond), &(DSP_ptr->mutex));
+   pthread_mutex_unlock(&(DSP_ptr->mutex));
+
+   balance_cnts[0] = job.balance_cnts[0];
+   balance_cnts[1] = job.balance_cnts[1];
+   balance_cnts[2] = job.balance_cnts[2];
+
+   return;
+   }
+
+
 // ========================================================================================================
 // ========================================================================================================
 // Find a match in the database to the SAP_ptr->KEK_authentication_nonce using the XMR_SHD helper data sent
@@ -1529,9 +2298,11 @@ void KEK_DA_SKE_FindMatch(int max_string_len, SRFAlgoParamsStruct *SAP_ptr, int
    {
    int enroll_or_regen, SBS_num_bits, SHD_num_bytes, current_num_strong_bits, do_part_A_part_B_both, set_threshold_to_zero; 
    unsigned char KEK_authentication_nonce_reproduced[SAP_ptr->num_KEK_authen_nonce_bits/8];
+   DASearchScratchStruct DA_search, *DSS_ptr;
    int chip_num, target_attempts, num_strong_bits;
    int bits_remaining, num_minority_bit_flips;
    unsigned short Threshold;
+   int num_bits_to_check, first_mismatch;
    int i, j;
 
    int check_all_chips, num_mismatches, true_minority_bit_flips; 
@@ -1564,8 +2335,22 @@ void KEK_DA_SKE_FindMatch(int max_string_len, SRFAlgoParamsStruct *SAP_ptr, int
    if ( num_chips < 4 )
       { printf("ERROR: KEK_DA_SKE_FindMatch(): Must have at least 4 chips in the DB => %d!\n", num_chips); exit(EXIT_FAILURE); }
 
-   if ( (ADS = (AuthenDataStruct *)calloc(num_chips, sizeof(AuthenDataStruct))) == NULL )
-      { printf("ERROR: KEK_DA_SKE_FindMatch(): Failed to allocate ADS!\n"); exit(EXIT_FAILURE); }
+// The scores and the search scratch come from the worker slab (sized for every chip) when the worker has one.
+   if ( SAP_ptr->use_worker_slab == 1 )
+      {
+      if ( num_chips > SAP_ptr->slab.num_chips )
+         { printf("PROGRAM ERROR: KEK_DA_SKE_FindMatch(): num_chips %d exceeds slab size %d!\n", num_chips, SAP_ptr->slab.num_chips); exit(EXIT_FAILURE); }
+      ADS = SAP_ptr->slab.ADS;
+      memset(ADS, 0, sizeof(AuthenDataStruct) * num_chips);
+      DSS_ptr = &(SAP_ptr->slab.DA_search);
+      }
+   else
+      {
+      if ( (ADS = (AuthenDataStruct *)calloc(num_chips, sizeof(AuthenDataStruct))) == NULL )
+         { printf("ERROR: KEK_DA_SKE_FindMatch(): Failed to allocate ADS!\n"); exit(EXIT_FAILURE); }
+      DASearchScratchAlloc(&DA_search, num_chips, SAP_ptr->num_required_PNDiffs);
+      DSS_ptr = &DA_search;
+      }
 
 // Set this to 1 to do all comparisons, which is more robust authentication method but takes longer. If set to 0, then we break out of the
 // inner loop that searches chunks of the KEK_authentication_nonce_reproduced bitstring, AND we select the first chip that has 0 mismatches
@@ -1604,8 +2389,28 @@ PrintHeaderAndHexVals("ORIGINAL AUTHENTICATION NONCE:\n", SAP_ptr->num_KEK_authe
 
    int PND_num; 
 
+// Score all chips with the batched SRF engine when we check all of them. The per-chip loop below is still used when we stop at
+// the first matching chip or when PN data is being dumped for a chip in DoSRFComp(). With a search pool, the chips are split 
+// between this thread and the pool's helpers.
+   int num_batched_chips = 0;
+   if ( check_all_chips == 1 && DO_DUMP_PN_DATA_CHIP_NUM == -1 )
+      {
+      int balance_cnts[3] = {0, 0, 0};
+
+      if ( SAP_ptr->DA_search_pool_ptr != NULL )
+         KEK_DA_SKE_PoolSearch(max_string_len, SAP_ptr, received_XMR_SHD_num_bytes, SKE_authen_XMR_SHD, authen_SpreadFactors_binary, 
+            current_function, do_scaling, ADS, num_chips, PND_num_inspect, balance_cnts, DSS_ptr);
+      else
+         KEK_DA_SKE_BatchSearch(max_string_len, SAP_ptr, received_XMR_SHD_num_bytes, SKE_authen_XMR_SHD, authen_SpreadFactors_binary, 
+            current_function, do_scaling, ADS, 0, num_chips, PND_num_inspect, balance_cnts, DSS_ptr);
+      num_pos_vals = balance_cnts[0];
+      num_neg_vals = balance_cnts[1];
+      num_zero_vals = balance_cnts[2];
+      num_batched_chips = num_chips;
+      }
+
    enroll_or_regen = 1;
-   for ( chip_num = 0; chip_num < num_chips; chip_num++ )
+   for ( chip_num = num_batched_chips; chip_num < num_chips; chip_num++ )
       {
 
 // Run the SRF engine and compute the fPNDco for this chip. 
@@ -1736,7 +2541,7 @@ printf("Chip %3d\tScaled fPNDco with ScalingConstant %f\n", SAP_ptr->chip_num, S
          num_strong_bits = KEK_FSB_SKE(SAP_ptr->num_required_PNDiffs, SAP_ptr->XMR_val, 
             SKE_authen_XMR_SHD + target_attempts*SAP_ptr->num_required_PNDiffs/8, SAP_ptr->device_SBS, NULL, bits_remaining, 
             KEK_authentication_nonce_reproduced, enroll_or_regen, do_mismatch_count, &num_minority_bit_flips, current_num_strong_bits, 
-            SAP_ptr->KEK_authentication_nonce, &true_minority_bit_flips, FSB_or_SKE, chip_num, 0);
+            SAP_ptr->KEK_authentication_nonce, &true_minority_bit_flips, FSB_or_SKE, chip_num, 0, DSS_ptr->strong_bits);
          bits_remaining -= num_strong_bits;
 
 
@@ -1764,24 +2569,37 @@ fflush(stdout);
 PrintHeaderAndHexVals("ORIGINAL AUTHENTICATION NONCE:\n", SAP_ptr->num_KEK_authen_nonce_bits/8, (unsigned char *)SAP_ptr->KEK_authentication_nonce, 32);
 #endif
 
-// Count the number of mismatches. Do NOT try to match bits beyond the last KEK_authentication_nonce bit.
-         for ( i = current_num_strong_bits, j = 0; i < current_num_strong_bits + num_strong_bits && i < SAP_ptr->num_KEK_authen_nonce_bits; i++, j++ )
-            if ( GetBitFromByte(KEK_authentication_nonce_reproduced[j/8], j % 8) != GetBitFromByte(SAP_ptr->KEK_authentication_nonce[i/8], i % 8) )
-               {
-
-#ifdef DEBUG3
-//if ( chip_num == 0 )
-printf("\tMISMATCH for chip %d on bit %d\n", SAP_ptr->chip_num, i); 
-fflush(stdout);
-#endif
+// Count the number of mismatches. Do NOT try to match bits beyond the last KEK_authentication_nonce bit. When we are NOT checking all chips,
+// stop at the first mismatch. On exit, j is the number of bits compared and i the nonce bit position reached, as the bit-check loop left them.
+         num_bits_to_check = SAP_ptr->num_KEK_authen_nonce_bits - current_num_strong_bits;
+         if ( num_bits_to_check > num_strong_bits )
+            num_bits_to_check = num_strong_bits;
+         if ( num_bits_to_check < 0 )
+            num_bits_to_check = 0;
+         j = num_bits_to_check;
 
 // ***** NOTE: THE DEVICE IS STILL COMPUTING PCR AND COMPUTING XMR_SHD USING PCR OFFSETS EVEN THOUGH WE ARE USING POPULATION ONLY HERE ON THE 
 // SERVER -- WE WILL NOT BE ABLE TO GET 0 MISMATCHES BECAUSE OF THIS. I would need to disable disable PCR mode on the device by making 
 // some changes, e.g., do NOT invoke the DA authentication function in the hardware.
+         if ( check_all_chips == 0 )
+            {
+            if ( (first_mismatch = BitStringFindFirstMismatch(KEK_authentication_nonce_reproduced, 0, SAP_ptr->KEK_authentication_nonce, 
+               current_num_strong_bits, num_bits_to_check)) != -1 )
+               {
                num_mismatches++;
-               if ( check_all_chips == 0 )
-                  break;
+               j = first_mismatch;
                }
+            }
+         else
+            num_mismatches += BitStringCountMismatches(KEK_authentication_nonce_reproduced, 0, SAP_ptr->KEK_authentication_nonce, 
+               current_num_strong_bits, num_bits_to_check);
+         i = current_num_strong_bits + j;
+
+#ifdef DEBUG3
+if ( num_mismatches != 0 )
+   printf("\tMISMATCH for chip %d: %d mismatched bits so far\n", SAP_ptr->chip_num, num_mismatches); 
+fflush(stdout);
+#endif
 
 // DEBUG ONLY, BUT NEED TO KEEP TRACK of how many KEK_authentication_nonce bit have been reproduced (current_num_strong_bits). 
          current_num_strong_bits = JoinBytePackedBitStrings(current_num_strong_bits, &(SAP_ptr->DA_nonce_reproduced), num_strong_bits, 
@@ -2015,7 +2833,9 @@ fflush(stdout);
       char outfile_name[max_string_len];
       char wfm_header_str[max_string_len];
 
-      pthread_mutex_lock(SAP_ptr->FileStat_mutex_ptr);
+// The stats writer does not need the mutex. Each worker has its own ring.
+      if ( SAP_ptr->SW_ptr == NULL )
+         pthread_mutex_lock(SAP_ptr->FileStat_mutex_ptr);
 
 // The first file gives the smallest CC that was found. We don't know the authenticating chip number here (unlike the ZED TV analysis) --
 // actually we do now since I set the authenticating IP and bitstream number in the SAP structure. We print a message above and will need 
@@ -2025,19 +2845,19 @@ if ( 0 )
       sprintf(outfile_name, "%s/KEK_SKE_RC_%d_SF_%d_TH_%d_XMR_%d_first_smallest_CC.xy", KEK_Authen_base_dir, 
          SAP_ptr->param_RangeConstant, SAP_ptr->param_SpreadConstant, SAP_ptr->param_Threshold, SAP_ptr->XMR_val); 
       sprintf(wfm_header_str, "SKE_XMR_%d_first_smallest_CCs\n", SAP_ptr->XMR_val);
-      WriteAuthenPointToFile(max_string_len, outfile_name, authen_num, wfm_header_str, ADS[0].CC);
+      WriteAuthenPointToFile(max_string_len, SAP_ptr, outfile_name, authen_num, wfm_header_str, ADS[0].CC);
 
 // The second file gives the second smallest CC that was found.
       sprintf(outfile_name, "%s/KEK_SKE_RC_%d_SF_%d_TH_%d_XMR_%d_second_smallest_CC.xy", KEK_Authen_base_dir, 
          SAP_ptr->param_RangeConstant, SAP_ptr->param_SpreadConstant, SAP_ptr->param_Threshold, SAP_ptr->XMR_val); 
       sprintf(wfm_header_str, "SKE_XMR_%d_second_smallest_CCs\n", SAP_ptr->XMR_val);
-      WriteAuthenPointToFile(max_string_len, outfile_name, authen_num, wfm_header_str, ADS[1].CC);
+      WriteAuthenPointToFile(max_string_len, SAP_ptr, outfile_name, authen_num, wfm_header_str, ADS[1].CC);
 
 // The third file gives the third smallest CC that was found.
       sprintf(outfile_name, "%s/KEK_SKE_RC_%d_SF_%d_TH_%d_XMR_%d_third_smallest_CC.xy", KEK_Authen_base_dir, 
          SAP_ptr->param_RangeConstant, SAP_ptr->param_SpreadConstant, SAP_ptr->param_Threshold, SAP_ptr->XMR_val); 
       sprintf(wfm_header_str, "SKE_XMR_%d_third_smallest_CCs\n", SAP_ptr->XMR_val);
-      WriteAuthenPointToFile(max_string_len, outfile_name, authen_num, wfm_header_str, ADS[2].CC);
+      WriteAuthenPointToFile(max_string_len, SAP_ptr, outfile_name, authen_num, wfm_header_str, ADS[2].CC);
 
 // The fourth file gives the average CC. 
       float ave_CC = 0.0; 
@@ -2048,36 +2868,37 @@ if ( 0 )
       sprintf(outfile_name, "%s/KEK_SKE_RC_%d_SF_%d_TH_%d_XMR_%d_ave_CC.xy", KEK_Authen_base_dir, 
          SAP_ptr->param_RangeConstant, SAP_ptr->param_SpreadConstant, SAP_ptr->param_Threshold, SAP_ptr->XMR_val); 
       sprintf(wfm_header_str, "SKE_XMR_%d_ave_CCs\n", SAP_ptr->XMR_val);
-      WriteAuthenPointToFile(max_string_len, outfile_name, authen_num, wfm_header_str, ave_CC);
+      WriteAuthenPointToFile(max_string_len, SAP_ptr, outfile_name, authen_num, wfm_header_str, ave_CC);
    }
 
 // The fifth file gives the AE_PCC.
       sprintf(outfile_name, "%s/KEK_SKE_RC_%d_SF_%d_TH_%d_XMR_%d_AE_PCC.xy", KEK_Authen_base_dir, 
          SAP_ptr->param_RangeConstant, SAP_ptr->param_SpreadConstant, SAP_ptr->param_Threshold, SAP_ptr->XMR_val); 
       sprintf(wfm_header_str, "SKE_XMR_%d_AE_PCCs\n", SAP_ptr->XMR_val);
-//      WriteAuthenPointToFile(max_string_len, outfile_name, authen_num, wfm_header_str, AE_PCC);
-      WriteAuthenPointToFile(max_string_len, outfile_name, authen_num, wfm_header_str, AE_PCC);
+//      WriteAuthenPointToFile(max_string_len, SAP_ptr, outfile_name, authen_num, wfm_header_str, AE_PCC);
+      WriteAuthenPointToFile(max_string_len, SAP_ptr, outfile_name, authen_num, wfm_header_str, AE_PCC);
 
 // The sixth file gives the NE PCC.
       sprintf(outfile_name, "%s/KEK_SKE_RC_%d_SF_%d_TH_%d_XMR_%d_NE_PCC.xy", KEK_Authen_base_dir, 
          SAP_ptr->param_RangeConstant, SAP_ptr->param_SpreadConstant, SAP_ptr->param_Threshold, SAP_ptr->XMR_val); 
       sprintf(wfm_header_str, "SKE_XMR_%d_NE_PCCs\n", SAP_ptr->XMR_val);
-//      WriteAuthenPointToFile(max_string_len, outfile_name, authen_num, wfm_header_str, NE_PCC);
-      WriteAuthenPointToFile(max_string_len, outfile_name, authen_num, wfm_header_str, NE_PCC);
+//      WriteAuthenPointToFile(max_string_len, SAP_ptr, outfile_name, authen_num, wfm_header_str, NE_PCC);
+      WriteAuthenPointToFile(max_string_len, SAP_ptr, outfile_name, authen_num, wfm_header_str, NE_PCC);
 
       sprintf(outfile_name, "%s/KEK_SKE_RC_%d_SF_%d_TH_%d_XMR_%d_AE_NTBF.xy", KEK_Authen_base_dir, 
          SAP_ptr->param_RangeConstant, SAP_ptr->param_SpreadConstant, SAP_ptr->param_Threshold, SAP_ptr->XMR_val); 
       sprintf(wfm_header_str, "SKE_XMR_%d_AE_NTBFs\n", SAP_ptr->XMR_val);
-      WriteAuthenPointToFile(max_string_len, outfile_name, authen_num, wfm_header_str, ADS[0].NTBF);
+      WriteAuthenPointToFile(max_string_len, SAP_ptr, outfile_name, authen_num, wfm_header_str, ADS[0].NTBF);
 
 // The eigth file gives the NE number of mismatches.
       sprintf(outfile_name, "%s/KEK_SKE_RC_%d_SF_%d_TH_%d_XMR_%d_NE_NTBF.xy", KEK_Authen_base_dir, 
          SAP_ptr->param_RangeConstant, SAP_ptr->param_SpreadConstant, SAP_ptr->param_Threshold, SAP_ptr->XMR_val); 
       sprintf(wfm_header_str, "SKE_XMR_%d_NE_NTBFs\n", SAP_ptr->XMR_val);
-      WriteAuthenPointToFile(max_string_len, outfile_name, authen_num, wfm_header_str, ADS[1].NTBF);
+      WriteAuthenPointToFile(max_string_len, SAP_ptr, outfile_name, authen_num, wfm_header_str, ADS[1].NTBF);
 
 // Unlock mutex.
-      pthread_mutex_unlock(SAP_ptr->FileStat_mutex_ptr);
+      if ( SAP_ptr->SW_ptr == NULL )
+         pthread_mutex_unlock(SAP_ptr->FileStat_mutex_ptr);
       }
 
 // 10_18_2022: Save the SHD for the authenicating device ONLY. Be careful here -- this generates a lot of data. This is shared 'static' variable
@@ -2103,15 +2924,19 @@ if ( 0 )
 
 // Technically I do NOT need semaphores here because I write a file specific to each chip, and the chip can NOT be doing two
 // authentications at the same time. Leaving it in for now although it does slow things down a bit.
-         pthread_mutex_lock(SAP_ptr->FileStat_mutex_ptr);
-
          sprintf(outfile_name, "%s/Chip_%d_KEK_SKE_RC_%d_SF_%d_TH_%d_XMR_%d_SHD.txt", KEK_SHD_base_dir, SAP_ptr->chip_num, 
             SAP_ptr->param_RangeConstant, SAP_ptr->param_SpreadConstant, SAP_ptr->param_Threshold, SAP_ptr->XMR_val); 
-         WriteASCIIBitstringToFile(max_string_len, outfile_name, create_or_append[SAP_ptr->chip_num], received_XMR_SHD_num_bytes*8, 
-            SKE_authen_XMR_SHD);
+         if ( SAP_ptr->SW_ptr != NULL )
+            StatsWriterBitstring(SAP_ptr->SW_ptr, SAP_ptr->SW_ring_num, outfile_name, (create_or_append[SAP_ptr->chip_num] == 0), 
+               received_XMR_SHD_num_bytes*8, SKE_authen_XMR_SHD);
+         else
+            {
+            pthread_mutex_lock(SAP_ptr->FileStat_mutex_ptr);
+            WriteASCIIBitstringToFile(max_string_len, outfile_name, create_or_append[SAP_ptr->chip_num], received_XMR_SHD_num_bytes*8, 
+               SKE_authen_XMR_SHD);
+            pthread_mutex_unlock(SAP_ptr->FileStat_mutex_ptr);
+            }
          create_or_append[SAP_ptr->chip_num] = 1;
-
-         pthread_mutex_unlock(SAP_ptr->FileStat_mutex_ptr);
          }
       }
 
@@ -2120,8 +2945,11 @@ printf("\tKEK_DA_SKE_FindMatch(): DONE -- chip_num identified %d\n", SAP_ptr->ch
 #ifdef DEBUG
 #endif
 
-   if ( ADS != NULL )
+   if ( SAP_ptr->use_worker_slab == 0 )
+      {
       free(ADS);
+      DASearchScratchFree(&DA_search);
+      }
    ADS = NULL;
 
    authen_num++; 
@@ -2269,7 +3097,14 @@ printf("\tKEK_DeviceAuthentication_SKE(): Current number of target_attempts with
 #endif
 
 // This fetch is not needed if our mode is PopOnly, no flip (which is the current mode) since they are not changed by the device.
-      if ( (authen_SpreadFactors_binary = (signed char *)realloc(authen_SpreadFactors_binary, (target_attempts * SAP_ptr->num_SF_words) * 
+// With the worker slab, the buffer is re-used across authentications and only grows if the device needs more attempts than it holds.
+      if ( SAP_ptr->use_worker_slab == 1 )
+         {
+         SAP_ptr->slab.authen_SF = (signed char *)WorkerSlabGrow(&(SAP_ptr->slab), SAP_ptr->slab.authen_SF, &(SAP_ptr->slab.authen_SF_size), 
+            (target_attempts * SAP_ptr->num_SF_words) * sizeof(signed char), "authen_SF");
+         authen_SpreadFactors_binary = SAP_ptr->slab.authen_SF;
+         }
+      else if ( (authen_SpreadFactors_binary = (signed char *)realloc(authen_SpreadFactors_binary, (target_attempts * SAP_ptr->num_SF_words) * 
          sizeof(signed char))) == NULL )
          { printf("ERROR: Failed to allocate storage for authen_SpreadFactors_binary!\n"); exit(EXIT_FAILURE); }
 
@@ -2295,7 +3130,14 @@ printf("KEK_DeviceAuthentication_SKE(): Getting SKE_authen_XMR_SHD %d bytes from
 // In terms of statistics, the KEK_authentication_nonce is a random number so no need to store and analyze that in the RunTime database.
 // However, we might want to look at the SKE_authen_XMR_SHD. Fixed this with personalized range constants so that it DOES have equal numbers 
 // of 0's and 1's. 
-   if ( (SKE_authen_XMR_SHD = (unsigned char *)calloc((target_attempts * SAP_ptr->num_required_PNDiffs/8), sizeof(unsigned char))) == NULL )
+   if ( SAP_ptr->use_worker_slab == 1 )
+      {
+      SAP_ptr->slab.authen_XMR_SHD = (unsigned char *)WorkerSlabGrow(&(SAP_ptr->slab), SAP_ptr->slab.authen_XMR_SHD, 
+         &(SAP_ptr->slab.authen_XMR_SHD_size), target_attempts * SAP_ptr->num_required_PNDiffs/8, "authen_XMR_SHD");
+      SKE_authen_XMR_SHD = SAP_ptr->slab.authen_XMR_SHD;
+      memset(SKE_authen_XMR_SHD, 0, target_attempts * SAP_ptr->num_required_PNDiffs/8);
+      }
+   else if ( (SKE_authen_XMR_SHD = (unsigned char *)calloc((target_attempts * SAP_ptr->num_required_PNDiffs/8), sizeof(unsigned char))) == NULL )
       { printf("ERROR: KEK_DeviceAuthentication_SKE(): Allocation for 'SKE_authen_XMR_SHD' failed!\n"); exit(EXIT_FAILURE); }
 
 // NOTE: WE ALWAYS receive XMR here. 
@@ -2309,11 +3151,17 @@ printf("KEK_DeviceAuthentication_SKE(): Getting SKE_authen_XMR_SHD %d bytes from
 
 // Save design information and the XMR_SHD to the RunTime database if user requests it. WE ARE NOW STORING SHD to a seperate file for analysis by
 // a C program developed for the ZED experiments (which does NOT use a database). It could be done here too.
+// The RunTime DB writer queues the row without taking the mutex.
    if ( SAP_ptr->do_save_bitstrings_to_RT_DB == 1 )
       {
-      pthread_mutex_lock(SAP_ptr->RT_DB_mutex_ptr);
-      SaveDBBitstringInfo(max_string_len, SAP_ptr, SKE_authen_XMR_SHD, received_XMR_SHD_num_bytes, FUNC_DA);
-      pthread_mutex_unlock(SAP_ptr->RT_DB_mutex_ptr);
+      if ( SAP_ptr->RTW_ptr != NULL )
+         SaveDBBitstringInfo(max_string_len, SAP_ptr, SKE_authen_XMR_SHD, received_XMR_SHD_num_bytes, FUNC_DA);
+      else
+         {
+         pthread_mutex_lock(SAP_ptr->RT_DB_mutex_ptr);
+         SaveDBBitstringInfo(max_string_len, SAP_ptr, SKE_authen_XMR_SHD, received_XMR_SHD_num_bytes, FUNC_DA);
+         pthread_mutex_unlock(SAP_ptr->RT_DB_mutex_ptr);
+         }
       }
 
 // ****************************************
@@ -2326,7 +3174,7 @@ printf("KEK_DeviceAuthentication_SKE(): Getting SKE_authen_XMR_SHD %d bytes from
       current_function, do_scaling);
    
 // Free up temporary storage. 
-   if ( authen_SpreadFactors_binary != NULL )
+   if ( SAP_ptr->use_worker_slab == 0 && authen_SpreadFactors_binary != NULL )
       free(authen_SpreadFactors_binary); 
 
 // Check that at least one chip succeeded with 0 mismatches and number of matching bits larger than threshold
@@ -2353,7 +3201,7 @@ printf("KEK_DeviceAuthentication_SKE(): Getting SKE_authen_XMR_SHD %d bytes from
    fflush(stdout);
 
 // Free allocated storage
-   if ( SKE_authen_XMR_SHD != NULL )
+   if ( SAP_ptr->use_worker_slab == 0 && SKE_authen_XMR_SHD != NULL )
       free(SKE_authen_XMR_SHD); 
 
 // Reset to 'normal' values.
@@ -2411,7 +3259,14 @@ int KEK_ClientServerAuthen(int max_string_len, SRFAlgoParamsStruct *SAP_ptr, int
       if ( SAP_ptr->database_NAT != NULL )
          {
          FreeVectorsAndMasks(&(SAP_ptr->num_vecs), &(SAP_ptr->num_rise_vecs), &(SAP_ptr->first_vecs_b), &(SAP_ptr->second_vecs_b), &(SAP_ptr->masks_b));
-         FreeAllTimingValsForChallenge(&(SAP_ptr->num_chips), &(SAP_ptr->PNR), &(SAP_ptr->PNF));
+         if ( SAP_ptr->use_worker_slab == 1 )
+            {
+            SAP_ptr->PNR = NULL;
+            SAP_ptr->PNF = NULL;
+            SAP_ptr->num_chips = 0;
+            }
+         else
+            FreeAllTimingValsForChallenge(&(SAP_ptr->num_chips), &(SAP_ptr->PNR), &(SAP_ptr->PNF));
          }
 
       if ( SAP_ptr->chip_num != -1 )
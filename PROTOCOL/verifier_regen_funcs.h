@@ -14,13 +14,40 @@
 #include "commonDB.h"
 
 void FreeAllTimingValsForChallenge(int *num_PUF_instances_ptr, float ***PNR_ptr, float ***PNF_ptr);
+void DASearchScratchAlloc(DASearchScratchStruct *DSS_ptr, int max_chips, int num_PNDiffs);
+void DASearchScratchFree(DASearchScratchStruct *DSS_ptr);
+void WorkerSlabInit(WorkerSlabStruct *WS_ptr, int num_chips, int num_PNDiffs, int num_SF_words, int num_attempts);
+void *WorkerSlabGrow(WorkerSlabStruct *WS_ptr, void *buffer, int *size_ptr, int num_bytes, char *buffer_name);
 
+void PopSFCacheInit(PopSFCacheStruct *PSC_ptr, int max_entries, int num_PNDiffs);
+void PopSFCacheFree(PopSFCacheStruct *PSC_ptr);
+void PopSFCacheMakeKey(SRFAlgoParamsStruct *SAP_ptr, PopSFCacheKeyStruct *key_ptr);
+int PopSFCacheLookup(PopSFCacheStruct *PSC_ptr, PopSFCacheKeyStruct *key_ptr, float *medians);
+void PopSFCacheInsert(PopSFCacheStruct *PSC_ptr, PopSFCacheKeyStruct *key_ptr, float *medians);
+
+void DASearchPoolInit(DASearchPoolStruct *DSP_ptr, int num_threads, int num_SF_words, int num_PNDiffs);
+void DASearchPoolShutdown(DASearchPoolStruct *DSP_ptr);
+
+void ComputePxxSpreadFactors(int max_string_len, SRFAlgoParamsStruct *SAP_ptr, int do_part_A_or_B);
 void ComputeSendSpreadFactors(int max_string_len, SRFAlgoParamsStruct *SAP_ptr, int device_socket_desc, int current_function,
    int send_SpreadFactors, int compute_PCR_SF);
 
+float ComputePNDiffsTwoSeeds(int num_PNDiffs, float *PNR, float *PNF, float *fPND, int LFSR_seed_low, 
+   int LFSR_seed_high);
+int ComputeBoundedRange(int num_PNDiffs, float *fPND, float range_low_limit, float range_high_limit, int DIST_range, 
+   float largest_neg_PND);
+void GPEVCal(int num_PNDiffs, float *PND, float *PNDc, float range_low_limit, float range_high_limit, int DIST_range, 
+   unsigned int RangeConstant, float largest_neg_PND);
+void AddSpreadFactors(int max_PNDiffs, float *PNDc, float *PNDco, float *fSpreadFactors, int TrimCodeConstant, 
+   int chip_num);
+
 void DoSRFComp(int max_string_len, SRFAlgoParamsStruct *SAP_ptr, int do_dump);
 
 int SingleHelpBitGen(int max_PNDiffs, float *fPNDco, unsigned char *SBS, unsigned char *SHD, int *HD_num_bytes_ptr, 
    unsigned short Threshold);
 
+void KEK_DA_SKE_FindMatch(int max_string_len, SRFAlgoParamsStruct *SAP_ptr, int received_XMR_SHD_num_bytes, 
+   unsigned char *SKE_authen_XMR_SHD, signed char *authen_SpreadFactors_binary, int current_function,
+   int do_scaling);
+
 int KEK_ClientServerAuthen(int max_string_len, SRFAlgoParamsStruct *SAP_ptr, int client_socket_desc, int RANDOM);
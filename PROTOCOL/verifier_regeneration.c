@@ -15,6 +15,9 @@
 #include "common.h"
 #include "verifier_common.h"
 #include "verifier_regen_funcs.h"
+#include "verifier_SRF_batch.h"
+#include "verifier_SRF_fixed.h"
+#include "verifier_stats_writer.h"
 #include "commonDB_RT.h"
 #include <signal.h>
 
@@ -35,7 +38,6 @@ typedef struct
    int Device_socket_desc;
    int port_number;
    int RANDOM;
-   int in_use;
    int client_index;
    int *client_sockets; 
    int TTP_num; 
@@ -50,10 +52,38 @@ typedef struct
    int num_eCt_nonce_bytes;
    int *TTP_socket_descs;
    AccountStruct *Accounts_ptr;
-   pthread_mutex_t Thread_mutex;
-   pthread_cond_t Thread_cv;
+   EpollServerStruct *ES_ptr;
    } ThreadDataType;
 
+// Upper bound on the size of the worker pool, i.e., the number of ThreadDataArr/SAP_arr slots.
+#define MAX_THREADS 20
+
+// BankThread worker pool. Workers take requests from Work_queue. main() adds workers (up to max_workers) when requests queue up
+// and workers retire after sitting idle for idle_timeout_ms while there are more than min_workers. 'slot_alive' marks the 
+// ThreadDataArr/SAP_arr slots owned by a running worker and 'slot_initialized' the slots whose SAP buffers have been allocated. 
+// Protected by 'mutex'. 'exit_cond' is signalled when a worker exits after Work_queue is closed. The busy time and counters are 
+// reset by the metrics thread at the end of each interval.
+typedef struct
+   {
+   int min_workers;
+   int max_workers;
+   int idle_timeout_ms;
+   int num_workers;
+   int num_busy;
+   int peak_workers;
+   int slot_alive[MAX_THREADS];
+   int slot_initialized[MAX_THREADS];
+   long num_spawned;
+   long num_retired;
+   double busy_us;
+   struct timeval interval_start;
+   pthread_mutex_t mutex;
+   pthread_cond_t exit_cond;
+   } WorkerPoolStruct;
+
+WorkerPoolStruct Worker_pool = { .mutex = PTHREAD_MUTEX_INITIALIZER, .exit_cond = PTHREAD_COND_INITIALIZER };
+WorkQueueStruct Work_queue;
+
 
 // ========================================================================================================
 // ========================================================================================================
@@ -104,16 +134,16 @@ void BankThread(ThreadDataType *ThreadDataPtr)
    int TTP_request;
    int Device_socket_desc;
    int client_index;
-   int *client_sockets;
+   EpollServerStruct *ES_ptr;
    int max_string_len;
    int RANDOM;
 
    int task_num, iteration_cnt;
+   WorkItemStruct work_item;
 
 // Making this static here makes it global to all threads.
    static pthread_mutex_t RT_DB_mutex = PTHREAD_MUTEX_INITIALIZER;
    static pthread_mutex_t FileStat_mutex = PTHREAD_MUTEX_INITIALIZER;
-   static pthread_mutex_t GenChallenge_mutex = PTHREAD_MUTEX_INITIALIZER;
    static pthread_mutex_t Authentication_mutex = PTHREAD_MUTEX_INITIALIZER;
 
    static pthread_mutex_t PUFCash_WRec_DB_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -123,18 +153,54 @@ printf("BankThread: CALLED!\t(Task %d\tIterationCnt %d)\n", ThreadDataPtr->task_
 #ifdef DEBUG
 #endif
 
-// Threads never return
+// Workers run until they sit idle for the pool's idle timeout while the pool is above its minimum size, or until main() closes the
+// work queue and the queued requests are done.
+   task_num = ThreadDataPtr->task_num;
+   iteration_cnt = ThreadDataPtr->iteration_cnt;
    while (1)
       {
+      int pop_status;
 
-// Sleep waiting for the main program to receive connect request from Alice or a TTP, and assign a device_socket_desc
-// No CPU cycles are wasted here in a busy wait, which is important when we query TTPs for performance information.
-      pthread_mutex_lock(&(ThreadDataPtr->Thread_mutex));
-      while ( ThreadDataPtr->in_use == 0 )
-         pthread_cond_wait(&(ThreadDataPtr->Thread_cv), &(ThreadDataPtr->Thread_mutex));
-      pthread_mutex_unlock(&(ThreadDataPtr->Thread_mutex));
+// Sleep in the work queue waiting for the main program to receive a connect request from Alice or a TTP. No CPU cycles are wasted 
+// here in a busy wait, which is important when we query TTPs for performance information.
+      if ( (pop_status = WorkQueuePop(&Work_queue, &work_item, Worker_pool.idle_timeout_ms)) == -1 )
+         {
+         pthread_mutex_lock(&(Worker_pool.mutex));
+         Worker_pool.num_workers--;
+         Worker_pool.slot_alive[task_num] = 0;
+         pthread_cond_signal(&(Worker_pool.exit_cond));
+         pthread_mutex_unlock(&(Worker_pool.mutex));
+         break;
+         }
+      if ( pop_status == 0 )
+         {
+         int retire = 0;
+
+// Once slot_alive is cleared, main may hand this slot to a new worker, so do NOT touch ThreadDataPtr afterwards.
+         pthread_mutex_lock(&(Worker_pool.mutex));
+         if ( Worker_pool.num_workers > Worker_pool.min_workers )
+            {
+            Worker_pool.num_workers--;
+            Worker_pool.num_retired++;
+            Worker_pool.slot_alive[task_num] = 0;
+            retire = 1;
+            }
+         pthread_mutex_unlock(&(Worker_pool.mutex));
+         if ( retire == 1 )
+            break;
+         continue;
+         }
+
+      ThreadDataPtr->TTP_request = work_item.TTP_request;
+      ThreadDataPtr->Device_socket_desc = work_item.socket_desc;
+      ThreadDataPtr->client_index = work_item.client_index;
+      ThreadDataPtr->TTP_num = work_item.TTP_num;
+      ThreadDataPtr->iteration_cnt = work_item.iteration_cnt;
+
+      pthread_mutex_lock(&(Worker_pool.mutex));
+      Worker_pool.num_busy++;
+      pthread_mutex_unlock(&(Worker_pool.mutex));
 
-      task_num = ThreadDataPtr->task_num;
       iteration_cnt = ThreadDataPtr->iteration_cnt;
 
 // Get local copies/pointers from the data structure.
@@ -142,22 +208,26 @@ printf("BankThread: CALLED!\t(Task %d\tIterationCnt %d)\n", ThreadDataPtr->task_
       TTP_request = ThreadDataPtr->TTP_request;
       Device_socket_desc = ThreadDataPtr->Device_socket_desc;
       client_index = ThreadDataPtr->client_index;
-      client_sockets = ThreadDataPtr->client_sockets;
+      ES_ptr = ThreadDataPtr->ES_ptr;
       max_string_len = ThreadDataPtr->max_string_len;
       RANDOM = ThreadDataPtr->RANDOM;
 
-// If we set SAP_ptr->use_database_chlngs to 1, then we can NOT allow more than one thread to run GenChallengeDB() at the same time because we
-// call rand(). If the device or TTP is going to get the same set of random numbers as this verifier is than after srand() is seeded with 
-// SAP_ptr->DB_ChallengeGen_seed, we must block other threads until the vector sequence is completely generated, i.e., rand() is NOT re-entrant!
-// We can do this in main() or here once we've initialized the GenChallenge_mutex mutex above (it is static and therefore global to all threads).
+// Hand the thread the shared mutexes (static above and therefore global to all threads). Challenge generation needs none since 
+// GenChallengeDB() uses a reentrant generator seeded from SAP_ptr->DB_ChallengeGen_seed, so threads generate challenges in parallel.
       SAP_ptr->RT_DB_mutex_ptr = &RT_DB_mutex;
       SAP_ptr->FileStat_mutex_ptr = &FileStat_mutex;
-      SAP_ptr->GenChallenge_mutex_ptr = &GenChallenge_mutex;
       SAP_ptr->Authentication_mutex_ptr = &Authentication_mutex; 
 
       SAP_ptr->PUFCash_WRec_DB_mutex_ptr = &PUFCash_WRec_DB_mutex;
       SAP_ptr->PUFCash_POP_DB_mutex_ptr = &PUFCash_POP_DB_mutex;
 
+// Device connections are used by this thread only until it closes them, so they can be read through a SockGetB() buffer. 
+      if ( TTP_request == 0 && SAP_ptr->use_sock_buffered_io == 1 )
+         {
+         SockReaderAttach(Device_socket_desc);
+         SockSetNoDelay(Device_socket_desc, 1);
+         }
+
 // Get the request
       char client_request_str[max_string_len];
       int client_request;
@@ -214,38 +284,36 @@ printf("CLIENT-AUTHENTICATION: BankThread(): Request from socket %d at index %d!
 // Close the socket descriptor if the request is from Alice (do NOT close TTP socket descriptors).
       if ( TTP_request == 0 )
          {
+         SockReaderDetach(Device_socket_desc);
          close(Device_socket_desc);
 
-// Make the socket descriptor processed by this thread available again to 'select' in OpenMultipleServerSocket.
-// Note this is a shared array among the threads but no semaphore needed here because each thread updates a unique element
-// given by client_index.
-         client_sockets[client_index] = 0;
+// Make the slot processed by this thread available again to the epoll server. This also wakes up the server if it is
+// holding off new connections because the connection cap was reached.
+         EpollServerReleaseSlot(ES_ptr, client_index);
          }
 
 // If a TTP request, then restore activity on this socket_descriptor? Note that I assign a TTP socket descriptor to Device_socket_desc
 // when the request is from a TTP in main when this thread is spun up. I also 'disable' this TTP socket descriptor by assigning a -1
 // while this thread executes. At least this is what I can deduce on 10_29_2021.
       else
-         client_sockets[client_index] = Device_socket_desc;
+         EpollServerRearmSlot(ES_ptr, client_index, Device_socket_desc);
 
 gettimeofday(&t1, 0); elapsed = (t1.tv_sec-t2.tv_sec)*1000000 + t1.tv_usec-t2.tv_usec; printf("\tElapsed: For '%s' %ld us\tIterationCnt %d\n\n", 
    client_request_str, (long)elapsed, iteration_cnt);
 #ifdef DEBUG
 #endif
 
-// Indicate to the parent that this thread is available for reassignment.
-      pthread_mutex_lock(&(ThreadDataPtr->Thread_mutex));
-      ThreadDataPtr->in_use = 0;
-      pthread_mutex_unlock(&(ThreadDataPtr->Thread_mutex));
+// Indicate to the pool that this thread is available for the next request.
+      pthread_mutex_lock(&(Worker_pool.mutex));
+      Worker_pool.num_busy--;
+      Worker_pool.busy_us += (double)elapsed;
+      pthread_mutex_unlock(&(Worker_pool.mutex));
       }
 
-// Exit and clean up resources. Nope -- this generates some type of library required message -- an error. I'm not destroying threads
-// any longer -- they get created and run forever.
-//   pthread_exit(NULL);
-
-// NEVER GETS EXECUTED anyway
+// Retiring or shutting down. The thread is detached so its resources are freed on return. The SAP buffers stay with the slot for 
+// the next worker.
+printf("BankThread: RETIRED!\t(Task %d\tIterationCnt %d)\n", task_num, iteration_cnt); fflush(stdout);
 #ifdef DEBUG
-printf("TTPThread: DONE!\t(Task %d\tIterationCnt %d)\n", task_num, iteration_cnt); fflush(stdout);
 #endif
    return;
    }
@@ -259,37 +327,189 @@ printf("TTPThread: DONE!\t(Task %d\tIterationCnt %d)\n", task_num, iteration_cnt
 #define MAX_TTPS 20
 #define MAX_CUSTOMERS 20
 
-int client_sockets[MAX_CLIENTS];
+// Connection server. The slot array (client_sockets) is sized by 'max_connections' in main().
+EpollServerStruct Epoll_server;
 
 int TTP_socket_descs[MAX_TTPS]; 
 int TTP_socket_indexes[MAX_TTPS]; 
 unsigned char *TTP_session_keys[MAX_TTPS]; 
 
-#define MAX_THREADS 20
+// Worker slots. A slot's SAP buffers are allocated the first time a worker is started in it. 
 SRFAlgoParamsStruct SAP_arr[MAX_THREADS];
+ThreadDataType ThreadDataArr[MAX_THREADS];
+
+// Loaded once by main() and copied into a slot each time a worker is started.
+SRFAlgoParamsStruct SAP_template;
+ThreadDataType ThreadDataTemplate;
+
+typedef struct
+   {
+   char *filename;
+   int interval_ms;
+   } PoolMetricsStruct;
+
+PoolMetricsStruct PoolMetrics;
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Allocate the permanent per-thread buffers of a worker's SAP. The sizes come from the fields copied from the template.
+
+void AllocateWorkerScratch(SRFAlgoParamsStruct *SAP_ptr)
+   {
+   if ( (SAP_ptr->fPND = (float *)calloc(SAP_ptr->num_required_PNDiffs, sizeof(float))) == NULL )
+      { printf("ERROR: AllocateWorkerScratch(): Failed to allocate storage for fPND!\n"); exit(EXIT_FAILURE); }
+   if ( (SAP_ptr->fPNDc = (float *)calloc(SAP_ptr->num_required_PNDiffs, sizeof(float))) == NULL )
+      { printf("ERROR: AllocateWorkerScratch(): Failed to allocate storage for fPNDc!\n"); exit(EXIT_FAILURE); }
+   if ( (SAP_ptr->fPNDco = (float *)calloc(SAP_ptr->num_required_PNDiffs, sizeof(float))) == NULL )
+      { printf("ERROR: AllocateWorkerScratch(): Failed to allocate storage for fPNDco!\n"); exit(EXIT_FAILURE); }
+
+   if ( (SAP_ptr->fSpreadFactors = (float *)calloc(SAP_ptr->num_SF_words, sizeof(float))) == NULL )
+      { printf("ERROR: AllocateWorkerScratch(): Failed to allocate storage for fSpreadFactors!\n"); exit(EXIT_FAILURE); }
+   if ( (SAP_ptr->iSpreadFactors = (signed char *)calloc(SAP_ptr->num_SF_words, sizeof(signed char))) == NULL )
+      { printf("ERROR: AllocateWorkerScratch(): Failed to allocate storage for iSpreadFactors!\n"); exit(EXIT_FAILURE); }
+
+   if ( (SAP_ptr->verifier_SHD = (unsigned char *)calloc(SAP_ptr->num_required_PNDiffs/8, sizeof(unsigned char))) == NULL )
+      { printf("ERROR: AllocateWorkerScratch(): Failed to allocate storage for verifier_SHD!\n"); exit(EXIT_FAILURE); }
+   if ( (SAP_ptr->verifier_SBS = (unsigned char *)calloc(SAP_ptr->num_required_PNDiffs/8, sizeof(unsigned char))) == NULL )
+      { printf("ERROR: AllocateWorkerScratch(): Failed to allocate storage for verifier_SBS!\n"); exit(EXIT_FAILURE); }
+   if ( (SAP_ptr->device_SHD = (unsigned char *)calloc(SAP_ptr->num_required_PNDiffs/8, sizeof(unsigned char))) == NULL )
+      { printf("ERROR: AllocateWorkerScratch(): Failed to allocate storage for device_SHD!\n"); exit(EXIT_FAILURE); }
+   if ( (SAP_ptr->device_SBS = (unsigned char *)calloc(SAP_ptr->num_required_PNDiffs/8, sizeof(unsigned char))) == NULL )
+      { printf("ERROR: AllocateWorkerScratch(): Failed to allocate storage for device_SBS!\n"); exit(EXIT_FAILURE); }
+
+   if ( (SAP_ptr->DHD_HD = (unsigned char *)calloc(SAP_ptr->num_required_PNDiffs/8, sizeof(unsigned char))) == NULL )
+      { printf("ERROR: AllocateWorkerScratch(): Failed to allocate storage for DHD_HD!\n"); exit(EXIT_FAILURE); }
+   if ( (SAP_ptr->verifier_DHD_SBS = (unsigned char *)calloc(SAP_ptr->num_required_PNDiffs/8, sizeof(unsigned char))) == NULL )
+      { printf("ERROR: AllocateWorkerScratch(): Failed to allocate storage for verifier_DHD_SBS!\n"); exit(EXIT_FAILURE); }
+   if ( (SAP_ptr->device_DHD_SBS = (unsigned char *)calloc(SAP_ptr->num_required_PNDiffs/8, sizeof(unsigned char))) == NULL )
+      { printf("ERROR: AllocateWorkerScratch(): Failed to allocate storage for device_DHD_SBS!\n"); exit(EXIT_FAILURE); }
+
+   if ( (SAP_ptr->verifier_n2 = (unsigned char *)calloc(SAP_ptr->num_required_nonce_bytes, sizeof(unsigned char))) == NULL )
+      { printf("ERROR: AllocateWorkerScratch(): Failed to allocate storage for verifier_n2!\n"); exit(EXIT_FAILURE); }
+   if ( (SAP_ptr->XOR_nonce = (unsigned char *)calloc(SAP_ptr->num_required_nonce_bytes, sizeof(unsigned char))) == NULL )
+      { printf("ERROR: AllocateWorkerScratch(): Failed to allocate storage for XOR_nonce!\n"); exit(EXIT_FAILURE); }
+
+   if ( (SAP_ptr->KEK_authentication_nonce = (unsigned char *)calloc(SAP_ptr->num_KEK_authen_nonce_bits/8, sizeof(unsigned char))) == NULL )
+      { printf("ERROR: AllocateWorkerScratch(): Failed to allocate storage for KEK_authentication_nonce!\n"); exit(EXIT_FAILURE); }
+
+// XMR_SHD that is generated during KEK_VerifierAuthentication during each iteration (to be concatenated to a larger blob and sent to device).
+   if ( (SAP_ptr->KEK_authen_XMR_SHD_chunk = (unsigned char *)calloc(SAP_ptr->num_required_PNDiffs/8, sizeof(unsigned char))) == NULL )
+      { printf("ERROR: AllocateWorkerScratch(): Failed to allocate storage for KEK_authen_XMR_SHD_chunk!\n"); exit(EXIT_FAILURE); }
+
+// Per-worker slab for the timing data and the device authentication buffers. SAP_ptr->num_chips is still the template value here.
+   if ( SAP_ptr->use_worker_slab == 1 )
+      WorkerSlabInit(&(SAP_ptr->slab), SAP_ptr->num_chips, SAP_ptr->num_required_PNDiffs, SAP_ptr->num_SF_words, WORKER_SLAB_INIT_ATTEMPTS);
+
+   return;
+   }
 
-ThreadDataType ThreadDataArr[MAX_THREADS] = {
-   {0, 0, NULL, 0, -1, 0, 0, 0, 0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, 0, 0, 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-   {0, 0, NULL, 0, -1, 0, 0, 0, 0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, 0, 0, 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-   {0, 0, NULL, 0, -1, 0, 0, 0, 0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, 0, 0, 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-   {0, 0, NULL, 0, -1, 0, 0, 0, 0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, 0, 0, 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-   {0, 0, NULL, 0, -1, 0, 0, 0, 0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, 0, 0, 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-   {0, 0, NULL, 0, -1, 0, 0, 0, 0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, 0, 0, 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-   {0, 0, NULL, 0, -1, 0, 0, 0, 0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, 0, 0, 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-   {0, 0, NULL, 0, -1, 0, 0, 0, 0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, 0, 0, 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-   {0, 0, NULL, 0, -1, 0, 0, 0, 0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, 0, 0, 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-   {0, 0, NULL, 0, -1, 0, 0, 0, 0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, 0, 0, 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-   {0, 0, NULL, 0, -1, 0, 0, 0, 0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, 0, 0, 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-   {0, 0, NULL, 0, -1, 0, 0, 0, 0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, 0, 0, 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-   {0, 0, NULL, 0, -1, 0, 0, 0, 0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, 0, 0, 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-   {0, 0, NULL, 0, -1, 0, 0, 0, 0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, 0, 0, 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-   {0, 0, NULL, 0, -1, 0, 0, 0, 0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, 0, 0, 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-   {0, 0, NULL, 0, -1, 0, 0, 0, 0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, 0, 0, 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-   {0, 0, NULL, 0, -1, 0, 0, 0, 0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, 0, 0, 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-   {0, 0, NULL, 0, -1, 0, 0, 0, 0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, 0, 0, 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-   {0, 0, NULL, 0, -1, 0, 0, 0, 0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, 0, 0, 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-   {0, 0, NULL, 0, -1, 0, 0, 0, 0, NULL, 0, NULL, 0, NULL, 0, NULL, 0, 0, 0, 0, NULL, NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER},
-   };
+
+// ========================================================================================================
+// ========================================================================================================
+// Start a worker in a free slot. MUST be called with Worker_pool.mutex held. The first time a slot is used, its SAP is copied from
+// the template and its buffers are allocated. A slot released by a retired worker keeps its SAP (and buffers) as is. Returns the
+// slot number or -1 if there is no free slot or the thread could not be created.
+
+int SpawnBankThread(ThreadDataType *TDT_template_ptr)
+   {
+   pthread_attr_t attr;
+   pthread_t thread_id;
+   int slot, err;
+
+   for ( slot = 0; slot < MAX_THREADS; slot++ )
+      if ( Worker_pool.slot_alive[slot] == 0 )
+         break;
+   if ( slot == MAX_THREADS )
+      return -1;
+
+   if ( Worker_pool.slot_initialized[slot] == 0 )
+      {
+      SAP_arr[slot] = *(TDT_template_ptr->SAP_ptr);
+      SAP_arr[slot].SW_ring_num = slot;
+      AllocateWorkerScratch(&SAP_arr[slot]);
+      Worker_pool.slot_initialized[slot] = 1;
+      }
+
+   ThreadDataArr[slot] = *TDT_template_ptr;
+   ThreadDataArr[slot].task_num = slot;
+   ThreadDataArr[slot].SAP_ptr = &SAP_arr[slot];
+
+// Detach thread since we don't need to synchronize with it (no 'join' required). Also allows resources to be freed when the thread 
+// retires.
+   pthread_attr_init(&attr);
+   pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+   err = pthread_create(&thread_id, &attr, (void *)BankThread, (void *)&(ThreadDataArr[slot]));
+   pthread_attr_destroy(&attr);
+   if ( err != 0 )
+      { printf("Failed to create thread: %d\n", err); fflush(stdout); return -1; }
+
+   Worker_pool.slot_alive[slot] = 1;
+   Worker_pool.num_workers++;
+   Worker_pool.num_spawned++;
+   if ( Worker_pool.num_workers > Worker_pool.peak_workers )
+      Worker_pool.peak_workers = Worker_pool.num_workers;
+
+#ifdef DEBUG
+printf("SpawnBankThread(): Started worker in slot %d\tNumber of workers %d\tThread ID %lu\n", slot, Worker_pool.num_workers, 
+   (unsigned long int)thread_id); fflush(stdout);
+#endif
+
+   return slot;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Appends one line of queue and pool metrics to the metrics file every 'interval_ms'. Utilization is the busy time of the 
+// requests completed in the interval divided by the interval times the number of workers at the end of it. Wait time is 
+// the time a request spent in the work queue.
+
+void *PoolMetricsThread(void *arg)
+   {
+   PoolMetricsStruct *PM_ptr = (PoolMetricsStruct *)arg;
+   int depth, max_depth, num_workers, num_busy, peak_workers;
+   long num_popped, num_push_blocked, num_spawned, num_retired;
+   double ave_wait_us, max_wait_us, busy_us, interval_us, utilization;
+   struct timeval now;
+   FILE *OUTFILE;
+
+   if ( (OUTFILE = fopen(PM_ptr->filename, "a")) == NULL )
+      { printf("ERROR: PoolMetricsThread(): Could not open '%s' for appending!\n", PM_ptr->filename); exit(EXIT_FAILURE); }
+   fprintf(OUTFILE, "# time_s\tworkers\tbusy\tpeak\tspawned\tretired\tutil\tdepth\tmax_depth\tdequeued\tpush_blocked\tave_wait_us\tmax_wait_us\n");
+   fflush(OUTFILE);
+
+   while (1)
+      {
+      usleep(PM_ptr->interval_ms * 1000);
+
+      WorkQueueGetMetrics(&Work_queue, 1, &depth, &max_depth, &num_popped, &num_push_blocked, &ave_wait_us, &max_wait_us);
+
+      pthread_mutex_lock(&(Worker_pool.mutex));
+      gettimeofday(&now, NULL);
+      interval_us = (double)(now.tv_sec - Worker_pool.interval_start.tv_sec)*1000000.0 + (double)(now.tv_usec - Worker_pool.interval_start.tv_usec);
+      num_workers = Worker_pool.num_workers;
+      num_busy = Worker_pool.num_busy;
+      peak_workers = Worker_pool.peak_workers;
+      num_spawned = Worker_pool.num_spawned;
+      num_retired = Worker_pool.num_retired;
+      busy_us = Worker_pool.busy_us;
+      Worker_pool.busy_us = 0.0;
+      Worker_pool.interval_start = now;
+      pthread_mutex_unlock(&(Worker_pool.mutex));
+
+      utilization = 0.0;
+      if ( interval_us > 0.0 && num_workers > 0 )
+         utilization = busy_us/(interval_us*num_workers);
+
+      fprintf(OUTFILE, "%ld.%03ld\t%d\t%d\t%d\t%ld\t%ld\t%.3f\t%d\t%d\t%ld\t%ld\t%.1f\t%.1f\n", (long)now.tv_sec, (long)now.tv_usec/1000, 
+         num_workers, num_busy, peak_workers, num_spawned, num_retired, utilization, depth, max_depth, num_popped, num_push_blocked, 
+         ave_wait_us, max_wait_us);
+      fflush(OUTFILE);
+      }
+
+   return NULL;
+   }
 
 
 // ============================================================================
@@ -326,7 +546,6 @@ int main(int argc, char *argv[])
    int rc;
 
 // Declare sockaddr_in structures 
-   int Bank_server_socket_desc = 0;
    int Device_socket_desc = 0;
 
    char **TTP_IPs = NULL;
@@ -339,8 +558,8 @@ int main(int argc, char *argv[])
    int num_customers;
 
    int client_index;
-   int first_time;
    int SD;
+   int max_connections;
 
    int port_number;
 
@@ -355,25 +574,46 @@ int main(int argc, char *argv[])
 
    int use_database_chlngs;
    unsigned int ChallengeGen_seed;
+   int chlng_rng_mode;
    unsigned int SpreadFactor_random_seed;
 
    int num_eCt_nonce_bytes; 
    int num_KEK_authen_nonce_bytes; 
 
    int use_TVC_cache; 
+   int use_TVC_snapshot; 
+   int use_TVC_compact; 
+   int use_PopSF_cache; 
+   int use_worker_slab;
+   PopSFCacheStruct PopSF_cache;
 
    int gen_random_challenge; 
 
    int do_save_bitstrings_to_RT_DB;
+   int use_RT_DB_writer;
+   int RT_DB_writer_batch_size;
+   int RT_DB_writer_commit_interval_ms;
+   RTBitstringWriterStruct RT_DB_writer;
    int do_save_PARCE_COBRA_file_stats;
    int do_save_COBRA_SHD;
    int do_save_SKE_SHD;
+   int use_stats_writer;
+   int stats_writer_full_policy;
+   int stats_writer_flush_interval_ms;
+   StatsWriterStruct Stats_writer;
+
+   int use_sock_buffered_io;
 
    int read_db_into_memory;
 
    int max_chips, chip_num;
 
-   int thread_num; 
+   int min_workers, max_workers;
+   int work_queue_capacity;
+   int worker_idle_timeout_ms;
+   int pool_metrics_interval_ms;
+   char *pool_metrics_filename;
+   WorkItemStruct work_item;
 
    int PCR_or_PBD_or_PO; 
 
@@ -382,6 +622,10 @@ int main(int argc, char *argv[])
 
    int do_PO_dist_flip; 
 
+   int num_DA_search_threads;
+   DASearchPoolStruct DA_search_pool;
+   int SRF_fixed_point_mode;
+
    Allocate1DString((char **)(&Bank_server_IP), MAX_STRING_LEN);
    Allocate1DString((char **)(&client_IP), MAX_STRING_LEN);
    Allocate1DString((char **)(&customer_IP_list_filename), MAX_STRING_LEN);
@@ -394,6 +638,7 @@ int main(int argc, char *argv[])
    Allocate1DString((char **)(&Synthesis_name), MAX_STRING_LEN);
    Allocate1DString((char **)(&ChallengeSetName_NAT), MAX_STRING_LEN);
    Allocate1DString((char **)(&ChallengeSetName_AT), MAX_STRING_LEN);
+   Allocate1DString((char **)(&pool_metrics_filename), MAX_STRING_LEN);
 
 // ===============================================================================
    if ( argc != 6 )
@@ -443,6 +688,29 @@ int main(int argc, char *argv[])
 // in memory copy.
    use_TVC_cache = 1;
 
+// Setting this to 1 saves the PN cache to a binary snapshot file next to the NAT/AT database, keyed by a hash of the database
+// contents and the ChallengeSetName. Later runs mmap the snapshot instead of querying the database, and verifier processes on
+// the same host share it in the page cache. A stale or corrupt snapshot is detected and rebuilt.
+   use_TVC_snapshot = 1;
+
+// Setting this to 1 stores the PN cache as int16_t (the TimingVals Ave value, i.e., the PN times 16) with the PNs of each chip
+// stored contiguously, which halves the footprint of the cache and of the snapshot. The PNs are converted to float as they are
+// fetched for a challenge. Set to 0 to keep one float array per cached PN.
+   use_TVC_compact = 1;
+
+// Setting this to 1 caches the PopOnly SpreadFactor medians computed across all enrolled chips, keyed by the challenge and the 
+// SRF parameters. Repeated challenge/LFSR seed combinations (e.g., fix_params or a fixed challenge seed) then skip the per-chip 
+// PND computation. Up to POPSF_CACHE_MAX_ENTRIES entries of num_required_PNDiffs floats each are kept.
+   use_PopSF_cache = 1;
+
+// Setting this to 1 gives each worker a slab, allocated once when its slot is first used, that holds the PNR/PNF and PopOnly PNDc
+// of every chip, the SpreadFactor and XMR_SHD buffers of WORKER_SLAB_INIT_ATTEMPTS target attempts and the scores and scratch of 
+// the device authentication search. Authentication then makes no heap calls for these buffers, but challenge generation 
+// (GenChallengeDB) still allocates the vectors and masks per attempt, SQLite allocates internally and glibc's qsort() of the 
+// per-chip scores may use a malloc'ed buffer for large chip counts. Requires the PN cache since the slab is sized from its number 
+// of chips.
+   use_worker_slab = 1;
+
    char AES_IV[AES_IV_NUM_BYTES] = {0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0x8, 0x9, 0xA, 0xB, 0xC, 0xD, 0xE, 0xF};
 
 // Copying this for now since I'm copy the Master_NAT.db to the Master_AT.db but eventually this will become a command line 
@@ -468,6 +736,14 @@ int main(int argc, char *argv[])
 // (SessionKeyGen) are available for saving. Not sure yet what can be done statistics-wise for the XMR_SHD.
    do_save_bitstrings_to_RT_DB = 0;
 
+// Setting this to 1 saves the bitstrings above through the RunTime DB writer. Workers queue the rows and a background thread inserts 
+// them into 'DB_name_RunTime' (opened in WAL mode on its own connection) with one transaction per 'RT_DB_writer_batch_size' rows or 
+// every 'RT_DB_writer_commit_interval_ms', whichever comes first. Queued rows are committed at shutdown. Only started when 
+// do_save_bitstrings_to_RT_DB is 1.
+   use_RT_DB_writer = 1;
+   RT_DB_writer_batch_size = 64;
+   RT_DB_writer_commit_interval_ms = 200;
+
 // NORMALLY 0
 // Setting this to 1 writes a lot of data to an (x,y) file I can use for plotting to determine PARCE distinguishability.
 // FOR PERFORMANCE MEASUREMENT, THIS SHOULD BE DISABLED. The stats files contains data sets for each authentication where
@@ -484,6 +760,19 @@ int main(int argc, char *argv[])
    do_save_COBRA_SHD = 0;
    do_save_SKE_SHD = 0;
 
+// Setting this to 1 writes the stats and SHD files above through the asynchronous stats writer: each worker adds its lines to its own
+// ring and a flusher thread writes them every 'stats_writer_flush_interval_ms', so authentications do not wait on the filesystem or the 
+// FileStat mutex. With STATS_WRITER_DROP, lines are dropped (and counted) when a worker's ring is full; STATS_WRITER_BLOCK makes the 
+// worker wait for the flusher instead. Only started when one of the save flags above is set.
+   use_stats_writer = 1;
+   stats_writer_full_policy = STATS_WRITER_BLOCK;
+   stats_writer_flush_interval_ms = 100;
+
+// Setting this to 1 gives each device connection a receive buffer so SockGetB() fetches several small frames (nonces, 'SPREAD_FACTORS DONE', 
+// SpreadFactors, ACKs) with one recv(), and sets TCP_NODELAY so the reply frames are not held back by Nagle while the device waits on them. 
+// The wire format is unchanged. TTP connections stay unbuffered because they are re-armed in epoll between requests.
+   use_sock_buffered_io = 1;
+
 // NOTE: ASSUMPTION:
 //    NUM_XOR_NONCE_BYTES   <=  num_eCt_nonce_bytes   <=   SE_TARGET_NUM_KEY_BITS/8   <=   NUM_REQUIRED_PNDIFFS/8
 //           8                         16                            32                              256
@@ -501,21 +790,57 @@ int main(int argc, char *argv[])
 // it generates the same output as 1 -- must be illegal.
    ChallengeGen_seed = 1;
 
+// Generator used by GenChallengeDB() to select the challenge from the seed. The devices and TTPs MUST use the same mode. Use
+// CHLNG_RNG_GLIBC_COMPAT (the original srand()/rand() sequence) for already-deployed devices and CHLNG_RNG_XOSHIRO otherwise.
+   chlng_rng_mode = CHLNG_RNG_GLIBC_COMPAT;
+
 // Default seed assignment used in PCR mode. We will occasionally need to reseed because there are occasions where we require
 // the same SpreadFactors to be generated twice (VerifierAuthentication and SessionKeyGen).
    SpreadFactor_random_seed = 0;
 
    port_number = 8888;
 
+// Maximum number of device/TTP connections that are open at the same time, i.e., accepted and not yet closed by a BankThread.
+// Further connection requests wait in the kernel listen queue.
+   max_connections = EPOLL_SERVER_MAX_CONNECTIONS;
+
+// BankThread worker pool. 'min_workers' threads are started up front and the pool grows to 'max_workers' (<= MAX_THREADS) when 
+// requests arrive faster than the idle workers can take them. A worker idle for 'worker_idle_timeout_ms' retires while there are more 
+// than 'min_workers'. Requests wait in a queue of 'work_queue_capacity' entries. Setting min_workers equal to max_workers gives a fixed 
+// pool. 'pool_metrics_interval_ms' > 0 appends queue depth, queue wait time and utilization to 'pool_metrics_filename' at that interval.
+   min_workers = 2;
+   max_workers = MAX_THREADS;
+   work_queue_capacity = 64;
+   worker_idle_timeout_ms = 30000;
+   pool_metrics_interval_ms = 0;
+   strcpy(pool_metrics_filename, "WorkerPool_metrics.txt");
+
 // Set this to the maximum number of chips that are to be preserved in the 'in-memory' database. NOTE: 'read_db_into_memory'
 // MUST be set to 1 for this to work. Setting to -1 disables any deletions, i.e., ALL chips from the database are kept
 // in the in-memory version. DOES NOT WORK ANY LONGER (Must be set to -1) after adding the AT database. See note below.
    max_chips = -1;
 
+// Number of threads searching the chip database in one device authentication (KEK_DA_SKE_FindMatch): the BankThread plus 
+// num_DA_search_threads - 1 helpers of a search pool started once here and shared by all BankThreads. The chips are split into 
+// chunks of DA_SEARCH_CHUNK_CHIPS that the threads pick up as they finish. Set to 1 to search in the BankThread only (no pool).
+   num_DA_search_threads = 4;
+
+// Engine used for the software SRF computations (DoSRFComp). SRF_MODE_FLOAT is the original float version. SRF_MODE_FIXED uses 
+// the fixed-point version in verifier_SRF_fixed.c, which works on the x16 PNs and computes GPEVCal exactly. srf_fixed_diff 
+// (make test) compares the two. 
+   SRF_fixed_point_mode = SRF_MODE_FLOAT;
+
 // Debug parameters that control the amount of output generated.
    DUMP_BITSTRINGS = 0;
    DEBUG_FLAG = 0;
 // ====================================================== PARAMETERS ====================================================
+// Sanity check on the worker pool bounds.
+   if ( min_workers < 1 || min_workers > max_workers || max_workers > MAX_THREADS || work_queue_capacity < 1 )
+      { 
+      printf("ERROR: main(): Worker pool requires 1 <= min_workers %d <= max_workers %d <= MAX_THREADS %d and work_queue_capacity %d >= 1\n", 
+         min_workers, max_workers, MAX_THREADS, work_queue_capacity); exit(EXIT_FAILURE); 
+      }
+
 // Sanity check. With SF stored in (signed char) now, we can NOT allow TrimCodeConstant to be any larger than 64. See
 // log notes on 1_1_2022.
    if ( TRIMCODE_CONSTANT > 64 )
@@ -710,13 +1035,10 @@ if (0)
    if ( (RANDOM = open("/dev/urandom", O_RDONLY)) == -1 )
       { printf("ERROR: Could not open /dev/urandom\n"); exit(EXIT_FAILURE); }
    printf("\tSuccessfully open '/dev/urandom'\n");
+   printf("\tBatched SRF engine for device authentication uses %s\n", SRFBatchISAName());
 
-// Initialize all client_sockets to 0. We do NOT DO THIS any longer in the call to OpenMultipleSocketServer below.
-// We needed to remove this because ttp.c needs to set a client_socket after opening the connection to the Bank (this
-// code). 
-   int client_num;
-   for ( client_num = 0; client_num < MAX_CLIENTS; client_num++) 
-      { client_sockets[client_num] = 0; }
+// Open the listen socket. The epoll server allocates the client_sockets slot array (all zero) with one slot per connection. 
+   EpollServerOpen(&Epoll_server, Bank_server_IP, port_number, max_connections);
 
 // =====================================================================================================================================
 // =====================================================================================================================================
@@ -783,390 +1105,384 @@ printf("Created Account Number %3d for PUFInstance %3d for %5s, %10s, %5s, with
 
 
 // -------------------------------------------
-// Load up verifier data structure for the thread.
-   for ( thread_num = 0; thread_num < MAX_THREADS; thread_num++ )
-      {
-      ThreadDataArr[thread_num].task_num = thread_num;
-
-// Set the SAP_ptr to one of the static array elements. We need separate data structures for the SAP structure because it has fields
-// that store data during authentication/session key generation. These don't need to be shared (and protected with a mutex).
-      ThreadDataArr[thread_num].SAP_ptr = &SAP_arr[thread_num];
+// Load up the template that SpawnBankThread() copies for each worker. We need separate data structures for the SAP structure because it 
+// has fields that store data during authentication/session key generation. These don't need to be shared (and protected with a mutex).
+   ThreadDataTemplate.task_num = -1;
+   ThreadDataTemplate.SAP_ptr = &SAP_template;
 
 // Non-anonymous database
-      ThreadDataArr[thread_num].SAP_ptr->database_NAT = DB_NAT;
-      if ( (ThreadDataArr[thread_num].SAP_ptr->DB_name_NAT = (char *)malloc(sizeof(char) * strlen(DB_name_NAT) + 1)) == NULL )
-         { printf("ERROR: Failed to allocate storage for DB_name_NAT!\n"); exit(EXIT_FAILURE); }
-      strcpy(ThreadDataArr[thread_num].SAP_ptr->DB_name_NAT, DB_name_NAT);
+   SAP_template.database_NAT = DB_NAT;
+   if ( (SAP_template.DB_name_NAT = (char *)malloc(sizeof(char) * strlen(DB_name_NAT) + 1)) == NULL )
+      { printf("ERROR: Failed to allocate storage for DB_name_NAT!\n"); exit(EXIT_FAILURE); }
+   strcpy(SAP_template.DB_name_NAT, DB_name_NAT);
 
 // Anonymous database
-      ThreadDataArr[thread_num].SAP_ptr->database_AT = DB_AT;
-      if ( (ThreadDataArr[thread_num].SAP_ptr->DB_name_AT = (char *)malloc(sizeof(char) * strlen(DB_name_AT) + 1)) == NULL )
-         { printf("ERROR: Failed to allocate storage for DB_name_AT!\n"); exit(EXIT_FAILURE); }
-      strcpy(ThreadDataArr[thread_num].SAP_ptr->DB_name_AT, DB_name_AT);
+   SAP_template.database_AT = DB_AT;
+   if ( (SAP_template.DB_name_AT = (char *)malloc(sizeof(char) * strlen(DB_name_AT) + 1)) == NULL )
+      { printf("ERROR: Failed to allocate storage for DB_name_AT!\n"); exit(EXIT_FAILURE); }
+   strcpy(SAP_template.DB_name_AT, DB_name_AT);
 
 // Runtime database for storing info during protocol runs.
-      ThreadDataArr[thread_num].SAP_ptr->database_RT = NULL;
+   SAP_template.database_RT = NULL;
 
 // PeerTrust
 if (0)
-   {
-      ThreadDataArr[thread_num].SAP_ptr->DB_MAKE_PT_AT = DB_MAKE_PT_AT;
-      if ( (ThreadDataArr[thread_num].SAP_ptr->DB_name_MAKE_PT_AT = (char *)malloc(sizeof(char) * strlen(DB_name_MAKE_PT_AT) + 1)) == NULL )
-         { printf("ERROR: Failed to allocate storage for DB_name_MAKE_PT_AT!\n"); exit(EXIT_FAILURE); }
-      strcpy(ThreadDataArr[thread_num].SAP_ptr->DB_name_MAKE_PT_AT, DB_name_MAKE_PT_AT);
+{
+   SAP_template.DB_MAKE_PT_AT = DB_MAKE_PT_AT;
+   if ( (SAP_template.DB_name_MAKE_PT_AT = (char *)malloc(sizeof(char) * strlen(DB_name_MAKE_PT_AT) + 1)) == NULL )
+      { printf("ERROR: Failed to allocate storage for DB_name_MAKE_PT_AT!\n"); exit(EXIT_FAILURE); }
+   strcpy(SAP_template.DB_name_MAKE_PT_AT, DB_name_MAKE_PT_AT);
 
 // PUF-Cash V3.0
-      ThreadDataArr[thread_num].SAP_ptr->DB_PUFCash_V3 = DB_PUFCash_V3;
-      if ( (ThreadDataArr[thread_num].SAP_ptr->DB_name_PUFCash_V3 = (char *)malloc(sizeof(char) * strlen(DB_name_PUFCash_V3) + 1)) == NULL )
-         { printf("ERROR: Failed to allocate storage for DB_name_PUFCash_V3!\n"); exit(EXIT_FAILURE); }
-      strcpy(ThreadDataArr[thread_num].SAP_ptr->DB_name_PUFCash_V3, DB_name_PUFCash_V3);
-   }
+   SAP_template.DB_PUFCash_V3 = DB_PUFCash_V3;
+   if ( (SAP_template.DB_name_PUFCash_V3 = (char *)malloc(sizeof(char) * strlen(DB_name_PUFCash_V3) + 1)) == NULL )
+      { printf("ERROR: Failed to allocate storage for DB_name_PUFCash_V3!\n"); exit(EXIT_FAILURE); }
+   strcpy(SAP_template.DB_name_PUFCash_V3, DB_name_PUFCash_V3);
+}
 else
-   {
-      ThreadDataArr[thread_num].SAP_ptr->DB_MAKE_PT_AT = NULL;
-      ThreadDataArr[thread_num].SAP_ptr->DB_PUFCash_V3 = NULL;
-   }
+{
+   SAP_template.DB_MAKE_PT_AT = NULL;
+   SAP_template.DB_PUFCash_V3 = NULL;
+}
 
-      ThreadDataArr[thread_num].SAP_ptr->design_index = design_index;
-      ThreadDataArr[thread_num].SAP_ptr->num_PIs = num_PIs;
-      ThreadDataArr[thread_num].SAP_ptr->num_POs = num_POs;
+   SAP_template.design_index = design_index;
+   SAP_template.num_PIs = num_PIs;
+   SAP_template.num_POs = num_POs;
 
-      if ( (ThreadDataArr[thread_num].SAP_ptr->ChallengeSetName_NAT = (char *)malloc(sizeof(char) * strlen(ChallengeSetName_NAT) + 1)) == NULL )
-         { printf("ERROR: Failed to allocate storage for ChallengeSetName_NAT!\n"); exit(EXIT_FAILURE); }
-      strcpy(ThreadDataArr[thread_num].SAP_ptr->ChallengeSetName_NAT, ChallengeSetName_NAT);
-      if ( (ThreadDataArr[thread_num].SAP_ptr->ChallengeSetName_AT = (char *)malloc(sizeof(char) * strlen(ChallengeSetName_AT) + 1)) == NULL )
-         { printf("ERROR: Failed to allocate storage for ChallengeSetName_AT!\n"); exit(EXIT_FAILURE); }
-      strcpy(ThreadDataArr[thread_num].SAP_ptr->ChallengeSetName_AT, ChallengeSetName_AT);
+   if ( (SAP_template.ChallengeSetName_NAT = (char *)malloc(sizeof(char) * strlen(ChallengeSetName_NAT) + 1)) == NULL )
+      { printf("ERROR: Failed to allocate storage for ChallengeSetName_NAT!\n"); exit(EXIT_FAILURE); }
+   strcpy(SAP_template.ChallengeSetName_NAT, ChallengeSetName_NAT);
+   if ( (SAP_template.ChallengeSetName_AT = (char *)malloc(sizeof(char) * strlen(ChallengeSetName_AT) + 1)) == NULL )
+      { printf("ERROR: Failed to allocate storage for ChallengeSetName_AT!\n"); exit(EXIT_FAILURE); }
+   strcpy(SAP_template.ChallengeSetName_AT, ChallengeSetName_AT);
 
-      ThreadDataArr[thread_num].SAP_ptr->gen_random_challenge = gen_random_challenge; 
+   SAP_template.gen_random_challenge = gen_random_challenge; 
 
-      ThreadDataArr[thread_num].SAP_ptr->use_database_chlngs = use_database_chlngs;
-      ThreadDataArr[thread_num].SAP_ptr->DB_ChallengeGen_seed = ChallengeGen_seed;
-      ThreadDataArr[thread_num].SAP_ptr->SpreadFactor_random_seed = SpreadFactor_random_seed;
+   SAP_template.use_database_chlngs = use_database_chlngs;
+   SAP_template.DB_ChallengeGen_seed = ChallengeGen_seed;
+   SAP_template.chlng_rng_mode = chlng_rng_mode;
+   SAP_template.SpreadFactor_random_seed = SpreadFactor_random_seed;
 
-      ThreadDataArr[thread_num].SAP_ptr->fix_params = fix_params;
+   SAP_template.fix_params = fix_params;
 
 // Fill in the data structure with the parameters associated SRF algorithm. Get the PUF design characteristics from the database. 
-      if ( (ThreadDataArr[thread_num].SAP_ptr->Netlist_name = (char *)malloc(sizeof(char) * strlen(Netlist_name) + 1)) == NULL )
-         { printf("ERROR: Failed to allocate storage for Netlist_name!\n"); exit(EXIT_FAILURE); }
-      strcpy(ThreadDataArr[thread_num].SAP_ptr->Netlist_name, Netlist_name);
+   if ( (SAP_template.Netlist_name = (char *)malloc(sizeof(char) * strlen(Netlist_name) + 1)) == NULL )
+      { printf("ERROR: Failed to allocate storage for Netlist_name!\n"); exit(EXIT_FAILURE); }
+   strcpy(SAP_template.Netlist_name, Netlist_name);
 
-      if ( (ThreadDataArr[thread_num].SAP_ptr->Synthesis_name = (char *)malloc(sizeof(char) * strlen(Synthesis_name) + 1)) == NULL )
-         { printf("ERROR: Failed to allocate storage for Synthesis_name!\n"); exit(EXIT_FAILURE); }
-      strcpy(ThreadDataArr[thread_num].SAP_ptr->Synthesis_name, Synthesis_name);
+   if ( (SAP_template.Synthesis_name = (char *)malloc(sizeof(char) * strlen(Synthesis_name) + 1)) == NULL )
+      { printf("ERROR: Failed to allocate storage for Synthesis_name!\n"); exit(EXIT_FAILURE); }
+   strcpy(SAP_template.Synthesis_name, Synthesis_name);
 
 // SRF algorithm currently configured to process 2048 values.
-      ThreadDataArr[thread_num].SAP_ptr->num_required_PNDiffs = NUM_REQUIRED_PNDIFFS;
+   SAP_template.num_required_PNDiffs = NUM_REQUIRED_PNDIFFS;
 
 // Allocated dynamically and freed during execution.
-      ThreadDataArr[thread_num].SAP_ptr->PNR = NULL;
-      ThreadDataArr[thread_num].SAP_ptr->PNF = NULL;
+   SAP_template.PNR = NULL;
+   SAP_template.PNF = NULL;
+   SAP_template.PNX_timing_DB = NULL;
+   SAP_template.PNX_ChlngSetName = NULL;
+
+// The PopOnly SF cache is shared by all workers through the template.
+   SAP_template.PopSF_cache_ptr = NULL;
+   if ( use_PopSF_cache == 1 )
+      {
+      PopSFCacheInit(&PopSF_cache, POPSF_CACHE_MAX_ENTRIES, SAP_template.num_required_PNDiffs);
+      SAP_template.PopSF_cache_ptr = &PopSF_cache;
+      }
 
-// Allocate permanent storage
-      if ( (ThreadDataArr[thread_num].SAP_ptr->fPND = (float *)calloc(ThreadDataArr[thread_num].SAP_ptr->num_required_PNDiffs, sizeof(float))) == NULL )
-         { printf("ERROR: Failed to allocate storage for fPND!\n"); exit(EXIT_FAILURE); }
-      if ( (ThreadDataArr[thread_num].SAP_ptr->fPNDc = (float *)calloc(ThreadDataArr[thread_num].SAP_ptr->num_required_PNDiffs, sizeof(float))) == NULL )
-         { printf("ERROR: Failed to allocate storage for fPNDc!\n"); exit(EXIT_FAILURE); }
-      if ( (ThreadDataArr[thread_num].SAP_ptr->fPNDco = (float *)calloc(ThreadDataArr[thread_num].SAP_ptr->num_required_PNDiffs, sizeof(float))) == NULL )
-         { printf("ERROR: Failed to allocate storage for fPNDco!\n"); exit(EXIT_FAILURE); }
+// The permanent per-thread buffers (fPND, SpreadFactors, bitstrings, nonces) are NOT allocated here. AllocateWorkerScratch() allocates
+// them the first time a worker slot is used, from the sizes recorded in this template.
 
 
 // These are currently not used -- I do not support fast population SpreadFactor method. If I do eventually, we may need to add NAT 
 // and AT versions here.
-      ThreadDataArr[thread_num].SAP_ptr->MedianPNR = NULL;
-      ThreadDataArr[thread_num].SAP_ptr->MedianPNF = NULL;
-      ThreadDataArr[thread_num].SAP_ptr->num_qualified_rise_PNs = 0;
-      ThreadDataArr[thread_num].SAP_ptr->num_qualified_fall_PNs = 0;
+   SAP_template.MedianPNR = NULL;
+   SAP_template.MedianPNF = NULL;
+   SAP_template.num_qualified_rise_PNs = 0;
+   SAP_template.num_qualified_fall_PNs = 0;
 
 
 // Although the PopOnly SF are ALWAYS restricted to values less than the TrimCodeConstant, e.g., 5-bit for TrimCodeConstant of 32, the PCR SF can get
 // larger and smaller (negative). When the TrimCodeConstant is 32, we will require one extra positive bit to represent numbers >= 32 and one extra bit 
 // for negative numbers. So 7 bits will be needed, so only one bit of precision for TrimCodeConstant of 32. Max TrimCodeConstant is 64, which would 
 // use all 8 bits of a 'signed char'.
-      ThreadDataArr[thread_num].SAP_ptr->num_SF_bytes = NUM_REQUIRED_PNDIFFS * SF_WORDS_TO_BYTES_MULT;
-      ThreadDataArr[thread_num].SAP_ptr->num_SF_words = NUM_REQUIRED_PNDIFFS; 
+   SAP_template.num_SF_bytes = NUM_REQUIRED_PNDIFFS * SF_WORDS_TO_BYTES_MULT;
+   SAP_template.num_SF_words = NUM_REQUIRED_PNDIFFS; 
 
 // 1_1_2022: If TRIMCODE_CONSTANT is <= 32, then we can preserve one precision bit in the iSpreadFactors for the device, else we cannot preserve any.
-      if ( TRIMCODE_CONSTANT <= 32 )
-         ThreadDataArr[thread_num].SAP_ptr->iSpreadFactorScaler = 2;
-      else
-         ThreadDataArr[thread_num].SAP_ptr->iSpreadFactorScaler = 1;
-
-      if ( (ThreadDataArr[thread_num].SAP_ptr->fSpreadFactors = (float *)calloc(ThreadDataArr[thread_num].SAP_ptr->num_SF_words, sizeof(float))) == NULL )
-         { printf("ERROR: Failed to allocate storage for fSpreadFactors!\n"); exit(EXIT_FAILURE); }
-      if ( (ThreadDataArr[thread_num].SAP_ptr->iSpreadFactors = (signed char *)calloc(ThreadDataArr[thread_num].SAP_ptr->num_SF_words, sizeof(signed char))) == NULL )
-         { printf("ERROR: Failed to allocate storage for iSpreadFactors!\n"); exit(EXIT_FAILURE); }
-
-      if ( (ThreadDataArr[thread_num].SAP_ptr->verifier_SHD = (unsigned char *)calloc(ThreadDataArr[thread_num].SAP_ptr->num_required_PNDiffs/8, sizeof(unsigned char))) == NULL )
-         { printf("ERROR: Failed to allocate storage for verifier_SHD!\n"); exit(EXIT_FAILURE); }
-      if ( (ThreadDataArr[thread_num].SAP_ptr->verifier_SBS = (unsigned char *)calloc(ThreadDataArr[thread_num].SAP_ptr->num_required_PNDiffs/8, sizeof(unsigned char))) == NULL )
-         { printf("ERROR: Failed to allocate storage for verifier_SBS!\n"); exit(EXIT_FAILURE); }
-      if ( (ThreadDataArr[thread_num].SAP_ptr->device_SHD = (unsigned char *)calloc(ThreadDataArr[thread_num].SAP_ptr->num_required_PNDiffs/8, sizeof(unsigned char))) == NULL )
-         { printf("ERROR: Failed to allocate storage for device_SHD!\n"); exit(EXIT_FAILURE); }
-      if ( (ThreadDataArr[thread_num].SAP_ptr->device_SBS = (unsigned char *)calloc(ThreadDataArr[thread_num].SAP_ptr->num_required_PNDiffs/8, sizeof(unsigned char))) == NULL )
-         { printf("ERROR: Failed to allocate storage for device_SBS!\n"); exit(EXIT_FAILURE); }
-      ThreadDataArr[thread_num].SAP_ptr->verifier_SHD_num_bytes = 0;
-      ThreadDataArr[thread_num].SAP_ptr->verifier_SBS_num_bytes = 0;
-      ThreadDataArr[thread_num].SAP_ptr->device_SHD_num_bytes = 0;
-      ThreadDataArr[thread_num].SAP_ptr->device_SBS_num_bytes = 0; 
-
-      ThreadDataArr[thread_num].SAP_ptr->do_save_bitstrings_to_RT_DB = do_save_bitstrings_to_RT_DB;
-      ThreadDataArr[thread_num].SAP_ptr->do_save_PARCE_COBRA_file_stats = do_save_PARCE_COBRA_file_stats;
-      ThreadDataArr[thread_num].SAP_ptr->do_save_COBRA_SHD = do_save_COBRA_SHD;
-      ThreadDataArr[thread_num].SAP_ptr->do_save_SKE_SHD = do_save_SKE_SHD;
-
-      if ( (ThreadDataArr[thread_num].SAP_ptr->DHD_HD = (unsigned char *)calloc(ThreadDataArr[thread_num].SAP_ptr->num_required_PNDiffs/8, sizeof(unsigned char))) == NULL )
-         { printf("ERROR: Failed to allocate storage for DHD_HD!\n"); exit(EXIT_FAILURE); }
-      if ( (ThreadDataArr[thread_num].SAP_ptr->verifier_DHD_SBS = (unsigned char *)calloc(ThreadDataArr[thread_num].SAP_ptr->num_required_PNDiffs/8, sizeof(unsigned char))) == NULL )
-         { printf("ERROR: Failed to allocate storage for verifier_DHD_SBS!\n"); exit(EXIT_FAILURE); }
-      if ( (ThreadDataArr[thread_num].SAP_ptr->device_DHD_SBS = (unsigned char *)calloc(ThreadDataArr[thread_num].SAP_ptr->num_required_PNDiffs/8, sizeof(unsigned char))) == NULL )
-         { printf("ERROR: Failed to allocate storage for device_DHD_SBS!\n"); exit(EXIT_FAILURE); }
-      ThreadDataArr[thread_num].SAP_ptr->DHD_SBS_num_bits = 0;
-
-      ThreadDataArr[thread_num].SAP_ptr->nonce_base_address = 0;
+   if ( TRIMCODE_CONSTANT <= 32 )
+      SAP_template.iSpreadFactorScaler = 2;
+   else
+      SAP_template.iSpreadFactorScaler = 1;
+
+
+   SAP_template.verifier_SHD_num_bytes = 0;
+   SAP_template.verifier_SBS_num_bytes = 0;
+   SAP_template.device_SHD_num_bytes = 0;
+   SAP_template.device_SBS_num_bytes = 0; 
+
+   SAP_template.do_save_bitstrings_to_RT_DB = do_save_bitstrings_to_RT_DB;
+
+   SAP_template.RTW_ptr = NULL;
+   if ( use_RT_DB_writer == 1 && do_save_bitstrings_to_RT_DB == 1 )
+      {
+      RTBitstringWriterInit(&RT_DB_writer, DB_name_RunTime, RT_DB_writer_batch_size, RT_DB_writer_commit_interval_ms);
+      SAP_template.RTW_ptr = &RT_DB_writer;
+      }
+   SAP_template.do_save_PARCE_COBRA_file_stats = do_save_PARCE_COBRA_file_stats;
+   SAP_template.do_save_COBRA_SHD = do_save_COBRA_SHD;
+   SAP_template.do_save_SKE_SHD = do_save_SKE_SHD;
+
+// Ring numbers are the worker slots (set in SpawnBankThread()).
+   SAP_template.SW_ptr = NULL;
+   SAP_template.SW_ring_num = -1;
+   if ( use_stats_writer == 1 && (do_save_PARCE_COBRA_file_stats == 1 || do_save_SKE_SHD == 1) )
+      {
+      StatsWriterInit(&Stats_writer, MAX_THREADS, stats_writer_full_policy, stats_writer_flush_interval_ms);
+      SAP_template.SW_ptr = &Stats_writer;
+      }
+
+   SAP_template.DHD_SBS_num_bits = 0;
+
+   SAP_template.nonce_base_address = 0;
 
 // Size of the nonce used to SRF's SelectParams, which is currently set to 8 bytes.
-      ThreadDataArr[thread_num].SAP_ptr->num_required_nonce_bytes = NUM_XOR_NONCE_BYTES;
-      if ( (ThreadDataArr[thread_num].SAP_ptr->verifier_n2 = (unsigned char *)calloc(ThreadDataArr[thread_num].SAP_ptr->num_required_nonce_bytes, sizeof(unsigned char))) == NULL )
-         { printf("ERROR: Failed to allocate storage for verifier_n2!\n"); exit(EXIT_FAILURE); }
-      if ( (ThreadDataArr[thread_num].SAP_ptr->XOR_nonce = (unsigned char *)calloc(ThreadDataArr[thread_num].SAP_ptr->num_required_nonce_bytes, sizeof(unsigned char))) == NULL )
-         { printf("ERROR: Failed to allocate storage for XOR_nonce!\n"); exit(EXIT_FAILURE); }
+   SAP_template.num_required_nonce_bytes = NUM_XOR_NONCE_BYTES;
 
-      ThreadDataArr[thread_num].SAP_ptr->dist_range = DIST_RANGE; 
-      ThreadDataArr[thread_num].SAP_ptr->range_low_limit = RANGE_LOW_LIMIT; 
-      ThreadDataArr[thread_num].SAP_ptr->range_high_limit = RANGE_HIGH_LIMIT; 
+   SAP_template.dist_range = DIST_RANGE; 
+   SAP_template.range_low_limit = RANGE_LOW_LIMIT; 
+   SAP_template.range_high_limit = RANGE_HIGH_LIMIT; 
 
-      ThreadDataArr[thread_num].SAP_ptr->vec_chunk_size = CHLNG_CHUNK_SIZE; 
-      ThreadDataArr[thread_num].SAP_ptr->XMR_val = XMR_VAL;
+   SAP_template.vec_chunk_size = CHLNG_CHUNK_SIZE; 
+   SAP_template.XMR_val = XMR_VAL;
 
-      memcpy((char *)ThreadDataArr[thread_num].SAP_ptr->AES_IV, (char *)AES_IV, AES_IV_NUM_BYTES);
+   memcpy((char *)SAP_template.AES_IV, (char *)AES_IV, AES_IV_NUM_BYTES);
 
 // The key fields are assigned dynamic storage during execution and will be freed once the app finishes using the key.
-      ThreadDataArr[thread_num].SAP_ptr->SE_target_num_key_bits = SE_TARGET_NUM_KEY_BITS; 
-      ThreadDataArr[thread_num].SAP_ptr->SE_final_key = NULL;
-      ThreadDataArr[thread_num].SAP_ptr->authen_min_bitstring_size = AUTHEN_MIN_BITSTRING_SIZE;
-      ThreadDataArr[thread_num].SAP_ptr->DA_cobra_key = NULL;
-      ThreadDataArr[thread_num].SAP_ptr->DA_nonce_reproduced = NULL;
+   SAP_template.SE_target_num_key_bits = SE_TARGET_NUM_KEY_BITS; 
+   SAP_template.SE_final_key = NULL;
+   SAP_template.authen_min_bitstring_size = AUTHEN_MIN_BITSTRING_SIZE;
+   SAP_template.DA_cobra_key = NULL;
+   SAP_template.DA_nonce_reproduced = NULL;
 
 // We do NOT have the KEK key on the verifier, ONLY ON THE DEVICE. But we can use this field to get statistics on the KEK key by having
 // the device transmit it to the verifier and then store it in the statistics database.
-      ThreadDataArr[thread_num].SAP_ptr->KEK_target_num_key_bits = KEK_TARGET_NUM_KEY_BITS;
-      ThreadDataArr[thread_num].SAP_ptr->KEK_final_enroll_key = NULL;
+   SAP_template.KEK_target_num_key_bits = KEK_TARGET_NUM_KEY_BITS;
+   SAP_template.KEK_final_enroll_key = NULL;
 
-      if ( (ThreadDataArr[thread_num].SAP_ptr->KEK_authentication_nonce = (unsigned char *)calloc(num_KEK_authen_nonce_bytes, sizeof(unsigned char))) == NULL )
-         { printf("ERROR: Failed to allocate storage for KEK_authentication_nonce!\n"); exit(EXIT_FAILURE); }
-      ThreadDataArr[thread_num].SAP_ptr->num_KEK_authen_nonce_bits = num_KEK_authen_nonce_bytes*8;
-
-// XMR_SHD that is generated during KEK_VerifierAuthentication during each iteration (to be concatenated to a larger blob and sent to device).
-      if ( (ThreadDataArr[thread_num].SAP_ptr->KEK_authen_XMR_SHD_chunk = (unsigned char *)calloc(ThreadDataArr[thread_num].SAP_ptr->num_required_PNDiffs/8, 
-         sizeof(unsigned char))) == NULL )
-         { printf("ERROR: Failed to allocate storage for KEK_authen_XMR_SHD_chunk!\n"); exit(EXIT_FAILURE); }
+   SAP_template.num_KEK_authen_nonce_bits = num_KEK_authen_nonce_bytes*8;
 
 // These are filled in by the verifier. 
-      ThreadDataArr[thread_num].SAP_ptr->num_chips = 0;
-      ThreadDataArr[thread_num].SAP_ptr->num_vecs = 0;
-      ThreadDataArr[thread_num].SAP_ptr->num_rise_vecs = 0;;
+   SAP_template.num_chips = 0;
+   SAP_template.num_vecs = 0;
+   SAP_template.num_rise_vecs = 0;;
 
 // THIS MUST BE 1
-      ThreadDataArr[thread_num].SAP_ptr->has_masks = 1;
+   SAP_template.has_masks = 1;
 
 // Allocated dynamically and freed during execution.
-      ThreadDataArr[thread_num].SAP_ptr->first_vecs_b = NULL;
-      ThreadDataArr[thread_num].SAP_ptr->second_vecs_b = NULL;
-      ThreadDataArr[thread_num].SAP_ptr->masks_b = NULL;
+   SAP_template.first_vecs_b = NULL;
+   SAP_template.second_vecs_b = NULL;
+   SAP_template.masks_b = NULL;
 
-      ThreadDataArr[thread_num].SAP_ptr->chip_num = 0;
+   SAP_template.chip_num = 0;
 
-      ThreadDataArr[thread_num].SAP_ptr->param_LFSR_seed_low = 0;
-      ThreadDataArr[thread_num].SAP_ptr->param_LFSR_seed_high = 0;
-      ThreadDataArr[thread_num].SAP_ptr->param_RangeConstant = RANGE_CONSTANT;
-      ThreadDataArr[thread_num].SAP_ptr->param_SpreadConstant = SPREAD_CONSTANT;
-      ThreadDataArr[thread_num].SAP_ptr->param_Threshold = THRESHOLD_CONSTANT;
-      ThreadDataArr[thread_num].SAP_ptr->param_TrimCodeConstant = TRIMCODE_CONSTANT;
+   SAP_template.param_LFSR_seed_low = 0;
+   SAP_template.param_LFSR_seed_high = 0;
+   SAP_template.param_RangeConstant = RANGE_CONSTANT;
+   SAP_template.param_SpreadConstant = SPREAD_CONSTANT;
+   SAP_template.param_Threshold = THRESHOLD_CONSTANT;
+   SAP_template.param_TrimCodeConstant = TRIMCODE_CONSTANT;
 
-      ThreadDataArr[thread_num].SAP_ptr->param_PCR_or_PBD_or_PO = PCR_or_PBD_or_PO;
+   SAP_template.param_PCR_or_PBD_or_PO = PCR_or_PBD_or_PO;
 
-      ThreadDataArr[thread_num].SAP_ptr->do_PO_dist_flip = do_PO_dist_flip;
+   SAP_template.do_PO_dist_flip = do_PO_dist_flip;
 
-      ThreadDataArr[thread_num].SAP_ptr->HBS_arr = NULL;
+   SAP_template.HBS_arr = NULL;
 
-      ThreadDataArr[thread_num].SAP_ptr->first_chip_num = 0;
-      ThreadDataArr[thread_num].SAP_ptr->first_num_match_bits = 0;
-      ThreadDataArr[thread_num].SAP_ptr->first_num_mismatch_bits = 0;
-      ThreadDataArr[thread_num].SAP_ptr->second_chip_num = 0;
-      ThreadDataArr[thread_num].SAP_ptr->second_num_match_bits = 0;
-      ThreadDataArr[thread_num].SAP_ptr->second_num_mismatch_bits = 0;
+   SAP_template.first_chip_num = 0;
+   SAP_template.first_num_match_bits = 0;
+   SAP_template.first_num_mismatch_bits = 0;
+   SAP_template.second_chip_num = 0;
+   SAP_template.second_num_match_bits = 0;
+   SAP_template.second_num_mismatch_bits = 0;
 
 // Set to 0 to ENABLE SKE and 1 to ENABLE COBRA during device authentication. SKE compares the nonce reproduced using the device helper data with the one it sent
 // to the device, counting bit-flips (failure) and minority bit flips. For COBRA, the device sends ONLY XMR SHD to the server, and where the server runs KEK FSB
 // enrollment The XMR SHD bitstring from the device and server are then correlated, where we count the number of mismatches and threshold them to decide to accept
 // or reject.
-      ThreadDataArr[thread_num].SAP_ptr->do_COBRA = DO_COBRA;
-      ThreadDataArr[thread_num].SAP_ptr->COBRA_AND_correlation_results = 0;
-      ThreadDataArr[thread_num].SAP_ptr->COBRA_XNOR_correlation_results = 0;
+   SAP_template.do_COBRA = DO_COBRA;
+   SAP_template.COBRA_AND_correlation_results = 0;
+   SAP_template.COBRA_XNOR_correlation_results = 0;
 
 // Only for testing the KEK SKE and FSB authentication primitives.
-      ThreadDataArr[thread_num].SAP_ptr->my_chip_num = -1;
-      ThreadDataArr[thread_num].SAP_ptr->my_scaling_constant = -1.0;
-      ThreadDataArr[thread_num].SAP_ptr->my_IP = NULL;
-      ThreadDataArr[thread_num].SAP_ptr->my_bitstream = -1;
+   SAP_template.my_chip_num = -1;
+   SAP_template.my_scaling_constant = -1.0;
+   SAP_template.my_IP = NULL;
+   SAP_template.my_bitstream = -1;
 
 // 11_1_2021: MAKE protocol. 
-      ThreadDataArr[thread_num].SAP_ptr->MAT_LLK_num_bytes = SE_TARGET_NUM_KEY_BITS/8;
+   SAP_template.MAT_LLK_num_bytes = SE_TARGET_NUM_KEY_BITS/8;
 
 // 11_21_2021: PeerTrust protocol. This must also match the length of KEK_TARGET_NUM_KEY_BITS/8. Might make more sense to just set it to that even 
 // though we use KEK session key generation to generate the PHK_A_nonce.
-      ThreadDataArr[thread_num].SAP_ptr->PHK_A_num_bytes = SE_TARGET_NUM_KEY_BITS/8;
+   SAP_template.PHK_A_num_bytes = SE_TARGET_NUM_KEY_BITS/8;
 
 // 11_12_2021: PUF-Cash V3.0
-      ThreadDataArr[thread_num].SAP_ptr->eCt_num_bytes = ECT_NUM_BYTES;
+   SAP_template.eCt_num_bytes = ECT_NUM_BYTES;
 
 // 7_4_2022: Added when updating GenPOPLLKs
-      ThreadDataArr[thread_num].SAP_ptr->POP_LLK_num_bytes = KEK_TARGET_NUM_KEY_BITS/8;
+   SAP_template.POP_LLK_num_bytes = KEK_TARGET_NUM_KEY_BITS/8;
+
+   SAP_template.DA_search_pool_ptr = NULL;
+   if ( num_DA_search_threads > 1 )
+      {
+      DASearchPoolInit(&DA_search_pool, num_DA_search_threads - 1, SAP_template.num_SF_words, SAP_template.num_required_PNDiffs);
+      SAP_template.DA_search_pool_ptr = &DA_search_pool;
+      }
+   SAP_template.SRF_fixed_point_mode = SRF_fixed_point_mode;
 
-      ThreadDataArr[thread_num].SAP_ptr->DEBUG_FLAG = DEBUG_FLAG;
-      ThreadDataArr[thread_num].SAP_ptr->DUMP_BITSTRINGS = DUMP_BITSTRINGS;
+   SAP_template.DEBUG_FLAG = DEBUG_FLAG;
+   SAP_template.DUMP_BITSTRINGS = DUMP_BITSTRINGS;
 
 // If the user chooses to use the PN cache, then the qualifing PNs (according to the ChallengeSetName_NAT and ChallengeSetName_AT) for all chips are 
 // read out of the database and stored in the TimingValCacheStruct array for very quick access. 
-      ThreadDataArr[thread_num].SAP_ptr->use_TVC_cache = use_TVC_cache;
-      ThreadDataArr[thread_num].SAP_ptr->TVC_arr_NAT = NULL;
-      ThreadDataArr[thread_num].SAP_ptr->num_TVC_arr_NAT = 0;
-      ThreadDataArr[thread_num].SAP_ptr->TVC_arr_AT = NULL;
-      ThreadDataArr[thread_num].SAP_ptr->num_TVC_arr_AT = 0;
+   SAP_template.use_TVC_cache = use_TVC_cache;
+   SAP_template.TVC_arr_NAT = NULL;
+   SAP_template.num_TVC_arr_NAT = 0;
+   SAP_template.TVC_arr_AT = NULL;
+   SAP_template.num_TVC_arr_AT = 0;
+   SAP_template.use_TVC_compact = use_TVC_compact;
+   SAP_template.use_worker_slab = use_worker_slab;
+   SAP_template.use_sock_buffered_io = use_sock_buffered_io;
+   memset(&(SAP_template.slab), 0, sizeof(WorkerSlabStruct));
+   memset(&(SAP_template.TVCC_NAT), 0, sizeof(TimingValCacheCompactStruct));
+   memset(&(SAP_template.TVCC_AT), 0, sizeof(TimingValCacheCompactStruct));
+   memset(&(SAP_template.TVCI_NAT), 0, sizeof(TimingValCacheIndexStruct));
+   memset(&(SAP_template.TVCI_AT), 0, sizeof(TimingValCacheIndexStruct));
 
 // Do this if the cache is enabled. YOU MUST DO THIS FOR THE AT database too.
-      if ( ThreadDataArr[thread_num].SAP_ptr->use_TVC_cache == 1 )
-         {
-         int check_num_chips;
+   if ( SAP_template.use_TVC_cache == 1 )
+      {
+      int check_num_chips;
 
-// Do this on the first iteration ONLY
-         if ( thread_num == 0 )
-            {
-// Use '%' for * and '_' for ?
-            ThreadDataArr[thread_num].SAP_ptr->num_chips = CreateTimingValsCacheFromChallengeSet(MAX_STRING_LEN, ThreadDataArr[thread_num].SAP_ptr->database_NAT, 
-               ThreadDataArr[thread_num].SAP_ptr->design_index, ThreadDataArr[thread_num].SAP_ptr->ChallengeSetName_NAT, "%", &(ThreadDataArr[thread_num].SAP_ptr->TVC_arr_NAT), 
-               &(ThreadDataArr[thread_num].SAP_ptr->num_TVC_arr_NAT));
+// Use '%' for * and '_' for ?. The cache data structures are READ-ONLY and shared by all workers through the template. As noted 
+// elsewhere, SAP_ptr->num_chips is used during challenge generation to record the number of DVR/DVF and is zero'ed out afterwards 
+// when the data is freed, so each worker's copy of this assignment cannot be depended on to remain.
+      SAP_template.num_chips = CreateOrLoadTimingValsCache(MAX_STRING_LEN, SAP_template.database_NAT, 
+         DB_name_NAT, SAP_template.design_index, SAP_template.ChallengeSetName_NAT, "%", 
+         &(SAP_template.TVC_arr_NAT), &(SAP_template.num_TVC_arr_NAT), use_TVC_snapshot, 
+         (use_TVC_compact == 1) ? &(SAP_template.TVCC_NAT) : NULL, &(SAP_template.TVCI_NAT));
 
-            check_num_chips = CreateTimingValsCacheFromChallengeSet(MAX_STRING_LEN, ThreadDataArr[thread_num].SAP_ptr->database_AT, 
-               ThreadDataArr[thread_num].SAP_ptr->design_index, ThreadDataArr[thread_num].SAP_ptr->ChallengeSetName_AT, "%", &(ThreadDataArr[thread_num].SAP_ptr->TVC_arr_AT), 
-               &(ThreadDataArr[thread_num].SAP_ptr->num_TVC_arr_AT));
+      check_num_chips = CreateOrLoadTimingValsCache(MAX_STRING_LEN, SAP_template.database_AT, 
+         DB_name_AT, SAP_template.design_index, SAP_template.ChallengeSetName_AT, "%", 
+         &(SAP_template.TVC_arr_AT), &(SAP_template.num_TVC_arr_AT), use_TVC_snapshot, 
+         (use_TVC_compact == 1) ? &(SAP_template.TVCC_AT) : NULL, &(SAP_template.TVCI_AT));
 
 // Sanity check. These databases MUST have the same number of chips. They also must have the same SynthesisName and NetlistName, which is not checked here.
-            if ( ThreadDataArr[thread_num].SAP_ptr->num_chips != check_num_chips )
-               { printf("ERROR: NAT and AT databases must have the same number of chips %d vs %d\n", ThreadDataArr[thread_num].SAP_ptr->num_chips, check_num_chips); exit(EXIT_FAILURE); }
-            }
+      if ( SAP_template.num_chips != check_num_chips )
+         { printf("ERROR: NAT and AT databases must have the same number of chips %d vs %d\n", SAP_template.num_chips, check_num_chips); exit(EXIT_FAILURE); }
 
-// Else copy pointers to these cache data structures. They are READ-ONLY.
-         else
-            {
-
-// As noted elsewhere, SAP_ptr->num_chips is used during challenge generation to record the number of DVR/DVF and is zero'ed out afterwards when the data is freed,
-// so this assignment cannot be depended on to remain.
-            ThreadDataArr[thread_num].SAP_ptr->num_chips = ThreadDataArr[0].SAP_ptr->num_chips; 
-            ThreadDataArr[thread_num].SAP_ptr->TVC_arr_NAT = ThreadDataArr[0].SAP_ptr->TVC_arr_NAT;
-            ThreadDataArr[thread_num].SAP_ptr->num_TVC_arr_NAT = ThreadDataArr[0].SAP_ptr->num_TVC_arr_NAT;
-            ThreadDataArr[thread_num].SAP_ptr->TVC_arr_AT = ThreadDataArr[0].SAP_ptr->TVC_arr_AT;
-            ThreadDataArr[thread_num].SAP_ptr->num_TVC_arr_AT = ThreadDataArr[0].SAP_ptr->num_TVC_arr_AT;
-            }
+      PrintTimingValsCacheFootprint("NAT", SAP_template.num_TVC_arr_NAT, SAP_template.num_chips, NUM_REQUIRED_PNS);
+      PrintTimingValsCacheFootprint("AT", SAP_template.num_TVC_arr_AT, SAP_template.num_chips, NUM_REQUIRED_PNS);
 
 // Force this to 1 if the timing data has been read into arrays because fast population SpreadFactor method requested (which NOT currently supported).
-         ThreadDataArr[thread_num].SAP_ptr->use_TVC_cache = 1;
-         }
+      SAP_template.use_TVC_cache = 1;
+      }
 
 // Else, no cache is being used. NULL out the fields.
-      else
-         {
-         ThreadDataArr[thread_num].SAP_ptr->num_chips = 0;
-         ThreadDataArr[thread_num].SAP_ptr->TVC_arr_NAT = NULL;
-         ThreadDataArr[thread_num].SAP_ptr->num_TVC_arr_NAT = 0;
-         ThreadDataArr[thread_num].SAP_ptr->TVC_arr_AT = NULL;
-         ThreadDataArr[thread_num].SAP_ptr->num_TVC_arr_AT = 0;
-         }
+   else
+      {
+      SAP_template.num_chips = 0;
+      SAP_template.TVC_arr_NAT = NULL;
+      SAP_template.num_TVC_arr_NAT = 0;
+      SAP_template.TVC_arr_AT = NULL;
+      SAP_template.num_TVC_arr_AT = 0;
+      }
+
+// The worker slab is sized from the number of chips in the PN cache.
+   if ( SAP_template.use_worker_slab == 1 && SAP_template.num_chips == 0 )
+      {
+      printf("WARNING: Worker slab requires the PN cache -- disabling worker slab!\n"); fflush(stdout);
+      SAP_template.use_worker_slab = 0;
+      }
 
 // ============================================================================
 // Additional fields beyond SAP needed by the thread.
-      ThreadDataArr[thread_num].TTP_request = 0;
-      ThreadDataArr[thread_num].Device_socket_desc = -1;
-      ThreadDataArr[thread_num].port_number = port_number;
-      ThreadDataArr[thread_num].RANDOM = RANDOM;
-      ThreadDataArr[thread_num].in_use = 0;
-      ThreadDataArr[thread_num].client_index = -1;
-      ThreadDataArr[thread_num].client_sockets = client_sockets;
-      ThreadDataArr[thread_num].TTP_num = -1;
-      ThreadDataArr[thread_num].TTP_session_keys = TTP_session_keys;
-      ThreadDataArr[thread_num].num_TTPs = num_TTPs;
-      ThreadDataArr[thread_num].TTP_IPs = TTP_IPs;
-      ThreadDataArr[thread_num].num_customers = num_customers;
-      ThreadDataArr[thread_num].customer_IPs = customer_IPs;
-      ThreadDataArr[thread_num].ip_length = IP_LENGTH;
-
-      ThreadDataArr[thread_num].max_string_len = MAX_STRING_LEN;
-      ThreadDataArr[thread_num].num_eCt_nonce_bytes = num_eCt_nonce_bytes;
-
-      ThreadDataArr[thread_num].TTP_socket_descs = TTP_socket_descs;
+   ThreadDataTemplate.TTP_request = 0;
+   ThreadDataTemplate.Device_socket_desc = -1;
+   ThreadDataTemplate.port_number = port_number;
+   ThreadDataTemplate.RANDOM = RANDOM;
+   ThreadDataTemplate.client_index = -1;
+   ThreadDataTemplate.client_sockets = Epoll_server.client_sockets;
+   ThreadDataTemplate.ES_ptr = &Epoll_server;
+   ThreadDataTemplate.TTP_num = -1;
+   ThreadDataTemplate.TTP_session_keys = TTP_session_keys;
+   ThreadDataTemplate.num_TTPs = num_TTPs;
+   ThreadDataTemplate.TTP_IPs = TTP_IPs;
+   ThreadDataTemplate.num_customers = num_customers;
+   ThreadDataTemplate.customer_IPs = customer_IPs;
+   ThreadDataTemplate.ip_length = IP_LENGTH;
+
+   ThreadDataTemplate.max_string_len = MAX_STRING_LEN;
+   ThreadDataTemplate.num_eCt_nonce_bytes = num_eCt_nonce_bytes;
+
+   ThreadDataTemplate.TTP_socket_descs = TTP_socket_descs;
 
 // This will need to be protected by a mutex.
-      ThreadDataArr[thread_num].Accounts_ptr = &Accounts;
+   ThreadDataTemplate.Accounts_ptr = &Accounts;
 
 // ******************************************************
-// Create a set of static threads -- thread memory management on the Cora/Zybo seems to have problems. Pass to each a copy
-// of DeviceDataArr structure. The loop below will update Device_socket_desc, client_index and in_use if Alice/Bob else it
-// will be a TTP. The Thread will use the Device_socket_desc or the TTP_socket_desc as the new communication channel. The 
-// client_index refers to the element in the client_sockets array that is in use during the message processing -- the 
-// processing thread will set this back to client_sockets[client_index] back to 0 before finishing. The Threads are in an 
-// infinite loop testing the in_use field. The parent here sets this to 1 when a new message is to be processed.
-//
-// We need to call pthread_cancel() to have the pthread free resources (I think pthread_detach also frees resources). If I
-// try to use pthread_cancel, I get a library complaint that some part of the thread library is missing -- need a newer version,
-// or whatever. Since I create all these threads statically I don't need to create and destroy them so no need for these functions
-// anyway.
-      int err;
-      pthread_t thread_id;
-      if ( (err = pthread_create((pthread_t *)&thread_id, NULL, (void *)BankThread, (void *)&(ThreadDataArr[thread_num]))) != 0 )
-         { printf("Failed to create thread: %d\n", err); fflush(stdout); }
-
-// Detach thread since we don't need to synchronize with it (no 'join' required). Also allows resources to be freed when thread 
-// terminates.
-//      pthread_detach(thread_id);
-
+// Start the minimum number of workers. The pool grows up to max_workers in the loop below when requests queue up faster than the idle 
+// workers can take them, and workers that sit idle for worker_idle_timeout_ms retire until min_workers are left. Threads are created
+// detached since we never 'join' them. The SAP buffers of a slot are allocated the first time it is used and kept for reuse when a 
+// worker retires, so a small host that never needs more than a few workers never pays for MAX_THREADS copies.
+   WorkQueueInit(&Work_queue, work_queue_capacity);
+
+   pthread_mutex_lock(&(Worker_pool.mutex));
+   Worker_pool.min_workers = min_workers;
+   Worker_pool.max_workers = max_workers;
+   Worker_pool.idle_timeout_ms = worker_idle_timeout_ms;
+   gettimeofday(&(Worker_pool.interval_start), NULL);
+   while ( Worker_pool.num_workers < min_workers )
+      if ( SpawnBankThread(&ThreadDataTemplate) == -1 )
+         { printf("ERROR: main(): Failed to start the minimum number of workers %d!\n", min_workers); exit(EXIT_FAILURE); }
+   pthread_mutex_unlock(&(Worker_pool.mutex));
+
+printf("Number of threads created: %d (pool bounds %d to %d, queue capacity %d)\n", min_workers, min_workers, max_workers, work_queue_capacity); fflush(stdout);
 #ifdef DEBUG
-printf("Thread ID %lu\n", (unsigned long int)thread_id); fflush(stdout);
 #endif
 
-printf("Number of threads created: %d\n", thread_num + 1); fflush(stdout);
-#ifdef DEBUG
-#endif
-      }
-
-// NOT USED
-   for ( thread_num = 1; thread_num < MAX_THREADS; thread_num++ )
+// Periodically append the queue and pool metrics to 'pool_metrics_filename'.
+   if ( pool_metrics_interval_ms > 0 )
       {
-      SAP_arr[thread_num].ChipScalingConstantArr = NULL;
-      SAP_arr[thread_num].ChipScalingConstantNotifiedArr = NULL;
-      }
+      int err;
+      pthread_t thread_id;
 
+      PoolMetrics.filename = pool_metrics_filename;
+      PoolMetrics.interval_ms = pool_metrics_interval_ms;
+      if ( (err = pthread_create(&thread_id, NULL, PoolMetricsThread, (void *)&PoolMetrics)) != 0 )
+         { printf("ERROR: main(): Failed to create pool metrics thread: %d\n", err); exit(EXIT_FAILURE); }
+      pthread_detach(thread_id);
+      }
 
 // ********************************************************************************
 // ********************************************************************************
 // LOOP
-   first_time = 1;
    for ( iteration = 0; (iteration < num_iterations || num_iterations == -1); iteration++ )
       {
 
-// Note: If NOT a new connection, 'client_IP' is NOT filled in by OpenMultipleSocketServer(). 'client_IP' is NOT filled in
-// for repeated communications from a TTP since we do NOT close this socket. NOTE: On FIRST call, client_sockets array is
-// initialized to ALL zeros.
+// Sleep in epoll_wait() until a new connection arrives or a re-armed TTP socket has a message. 'client_IP' is filled in with 
+// the peer address in both cases. 
       strcpy(client_IP, "");
       client_index = -1;
       Device_socket_desc = -1;
-      SD = OpenMultipleSocketServer(MAX_STRING_LEN, &Bank_server_socket_desc, Bank_server_IP, port_number, client_IP,
-         MAX_CLIENTS, client_sockets, &client_index, first_time);
-      first_time = 0;
+      SD = EpollServerWait(&Epoll_server, client_IP, &client_index);
 
 // Sanity check. 
       if ( client_index == -1 )
-         { printf("ERROR: Failed to find an empty slot in client_sockets -- increase MAX_CLIENTS!\n"); exit(EXIT_FAILURE); }
+         { printf("ERROR: Failed to find an empty slot in client_sockets -- increase max_connections!\n"); exit(EXIT_FAILURE); }
 
 
 struct timeval tv;
@@ -1184,8 +1500,8 @@ milliseconds = tv.tv_usec/1000;
 
 //printf("ITERATION %d\tDate: %s.%06ld\n", iteration, time_string, milliseconds); fflush(stdout);
 printf("ITERATION %d\tDate: %s.%03ld.%03ld\t%s\n", iteration, time_string, milliseconds, tv.tv_usec - milliseconds*1000, client_IP); fflush(stdout);
-printf("\tSD and Client_IP returned by OpenMultipleSocketServer %d and %s\tClient index %d\tClient socket %d\tIterationCnt %d!\n", 
-   SD, client_IP, client_index, client_sockets[client_index], iteration); fflush(stdout);
+printf("\tSD and Client_IP returned by EpollServerWait %d and %s\tClient index %d\tIterationCnt %d!\n", 
+   SD, client_IP, client_index, iteration); fflush(stdout);
 #ifdef DEBUG
 #endif
 
@@ -1242,43 +1558,44 @@ printf("\tTTP REQUEST: TTP %d with IP %s has connected with TTP_socket_desc %d a
 printf("Client socket descriptor %d, client index %d from IP '%s'\n", SD, client_index, client_IP); fflush(stdout);
 #endif
 
-      int found_one = 0;
-      while ( found_one == 0 )
-         {
-         for ( thread_num = 0; thread_num < MAX_THREADS; thread_num++ )
-            {
-            pthread_mutex_lock(&(ThreadDataArr[thread_num].Thread_mutex));
-            if ( ThreadDataArr[thread_num].in_use == 0 )
-               {
-               ThreadDataArr[thread_num].TTP_request = TTP_request;
-               if ( TTP_request == 1 )
-                  ThreadDataArr[thread_num].Device_socket_desc = TTP_socket_descs[TTP_num];
-               else
-                  ThreadDataArr[thread_num].Device_socket_desc = Device_socket_desc;
-               ThreadDataArr[thread_num].client_index = client_index;
-               ThreadDataArr[thread_num].iteration_cnt = iteration;
-               ThreadDataArr[thread_num].in_use = 1;
-               ThreadDataArr[thread_num].TTP_num = TTP_num;
-               found_one = 1;
-
-// Make further activity on this socket descriptors ignored by OpenMultipleSocketServer() until the thread restores the 
-// client_socket value when it completes communication with a TTP.
-               client_sockets[client_index] = -1;
-
-               pthread_cond_signal(&(ThreadDataArr[thread_num].Thread_cv));
-               }
-            pthread_mutex_unlock(&(ThreadDataArr[thread_num].Thread_mutex));
-            if ( found_one == 1 )
-               break;
-            }
-         }
+// Mark the slot as in use by a worker. The worker releases it (device) or re-arms it (TTP) when it is done. Workers update the
+// slots concurrently, so take the server mutex.
+      pthread_mutex_lock(&(Epoll_server.mutex));
+      Epoll_server.client_sockets[client_index] = -1;
+      pthread_mutex_unlock(&(Epoll_server.mutex));
+
+      work_item.TTP_request = TTP_request;
+      if ( TTP_request == 1 )
+         work_item.socket_desc = TTP_socket_descs[TTP_num];
+      else
+         work_item.socket_desc = Device_socket_desc;
+      work_item.client_index = client_index;
+      work_item.TTP_num = TTP_num;
+      work_item.iteration_cnt = iteration;
+
+// Grow the pool if this request would otherwise wait behind the ones already queued. The push below blocks only when the pool is at 
+// max_workers and the queue is full, in which case new connections wait in the kernel listen queue.
+      pthread_mutex_lock(&(Worker_pool.mutex));
+      if ( WorkQueueDepth(&Work_queue) + 1 > Worker_pool.num_workers - Worker_pool.num_busy && Worker_pool.num_workers < Worker_pool.max_workers )
+         SpawnBankThread(&ThreadDataTemplate);
+      pthread_mutex_unlock(&(Worker_pool.mutex));
+
+      WorkQueuePush(&Work_queue, &work_item);
        
-printf("\tTasking Thread %d\n", thread_num); fflush(stdout);
+printf("\tQueued request (queue depth %d)\n", WorkQueueDepth(&Work_queue)); fflush(stdout);
 #ifdef DEBUG
 #endif
 
       }
 
+// Stop accepting requests and let the workers finish the ones already queued. Every worker exits once the queue is empty, so after
+// this no BankThread uses the search pool, the caches, the writers or the databases shut down below.
+   WorkQueueClose(&Work_queue);
+   pthread_mutex_lock(&(Worker_pool.mutex));
+   while ( Worker_pool.num_workers > 0 )
+      pthread_cond_wait(&(Worker_pool.exit_cond), &(Worker_pool.mutex));
+   pthread_mutex_unlock(&(Worker_pool.mutex));
+
 // PERFORMANCE EVAL ONLY: If we read the database into memory, and updated it (by deleting elements because of 'max_chips'), then check to 
 // see if we need to store it. This will only store the non-anonmous database. Since 5/20/2019, I've added a second database.
    if ( read_db_into_memory == 1 && max_chips != -1 )
@@ -1303,7 +1620,26 @@ printf("\tTasking Thread %d\n", thread_num); fflush(stdout);
          }
       }
 
-// Close the databases.
+   if ( SAP_template.DA_search_pool_ptr != NULL )
+      DASearchPoolShutdown(SAP_template.DA_search_pool_ptr);
+
+   if ( SAP_template.PopSF_cache_ptr != NULL )
+      PopSFCacheFree(SAP_template.PopSF_cache_ptr);
+
+// The PN cache indexes (empty when the cache is not used). Every worker has stopped so nothing is still looking up.
+   FreeTimingValsCacheIndex(&(SAP_template.TVCI_NAT));
+   FreeTimingValsCacheIndex(&(SAP_template.TVCI_AT));
+
+// Write out any stats still in the rings. The workers, the only producers, have all exited above, so the rings can be freed. 
+   if ( SAP_template.SW_ptr != NULL )
+      StatsWriterShutdown(SAP_template.SW_ptr);
+
+// Commit the bitstrings still queued for the RunTime DB.
+   if ( SAP_template.RTW_ptr != NULL )
+      RTBitstringWriterShutdown(SAP_template.RTW_ptr);
+
+// Close the databases. The cached prepared statements MUST be finalized first or sqlite3_close() fails with SQLITE_BUSY.
+   SQLStmtCacheFinalize(NULL);
    sqlite3_close(DB_NAT);
    sqlite3_close(DB_AT);
 if (0)
@@ -1322,7 +1658,7 @@ if (0)
       }
 
 // Close server sockets
-   close(Bank_server_socket_desc);
+   close(Epoll_server.master_socket);
 
 if (0)
    {
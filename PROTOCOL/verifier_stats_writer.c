@@ -0,0 +1,407 @@
+// ========================================================================================================
+// ========================================================================================================
+// *************************************** verifier_stats_writer.c ****************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+//
+// Asynchronous writer for the authentication stats files under ../ANALYSIS. The workers used to fopen/fprintf/fclose
+// these files under the global FileStat mutex, so every authentication waited on the filesystem and on each other.
+// Here a worker formats its text into a record in its own ring and returns. A single flusher thread wakes up every
+// flush_interval_ms, takes every record published so far, orders them by file and sequence number and writes each file
+// with one fopen/fclose. The text written is exactly what the synchronous path writes, so the files are unchanged.
+//
+// Each ring has one producer (the worker owning the slot) and one consumer (the flusher). The producer fills the slot at
+// 'head' and then publishes it with a release store of head+1. The flusher reads 'head' with an acquire load, writes the
+// records and then frees the slots with a release store of 'tail'.
+//
+// Every logical entry takes a contiguous range of sequence numbers from a shared atomic counter, after its slots are
+// reserved, so a seq is never taken by a record that is later dropped. The flusher writes records strictly in seq order
+// across batches: it writes only the run that continues from 'next_flush_seq_num' without a gap and holds back the rest
+// (a worker that took a seq but has not published it yet) for a later pass. A multi-record bitstring is therefore never
+// interleaved with another worker's lines and a 'create' record never truncates lines added before it.
+//
+// Producers count themselves in 'num_active' while they add and give up once 'stop' is set, so StatsWriterShutdown() 
+// frees the rings only after every producer is out.
+
+#include "common.h"
+#include "verifier_common.h"
+#include "verifier_stats_writer.h"
+#include <stdarg.h>
+
+extern int usleep (__useconds_t __useconds);
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Order records by sequence number, the order they were added in.
+
+static int StatsRecordSeqCompareFunc(const void *a, const void *b)
+   {
+   StatsRecordStruct *rec_a = *(StatsRecordStruct **)a;
+   StatsRecordStruct *rec_b = *(StatsRecordStruct **)b;
+
+   if ( rec_a->seq_num < rec_b->seq_num )
+      return -1;
+   if ( rec_a->seq_num > rec_b->seq_num )
+      return 1;
+   return 0;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Order records by file and then by sequence number so each file is written with one open, in the order its
+// records were added.
+
+static int StatsRecordCompareFunc(const void *a, const void *b)
+   {
+   StatsRecordStruct *rec_a = *(StatsRecordStruct **)a;
+   StatsRecordStruct *rec_b = *(StatsRecordStruct **)b;
+   int cmp;
+
+   if ( (cmp = strcmp(rec_a->outfile_name, rec_b->outfile_name)) != 0 )
+      return cmp;
+   if ( rec_a->seq_num < rec_b->seq_num )
+      return -1;
+   if ( rec_a->seq_num > rec_b->seq_num )
+      return 1;
+   return 0;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Write the records published so far whose seqs continue from 'next_flush_seq_num' without a gap. Records after a gap
+// stay in their rings for a later pass. Returns the number of records written.
+
+static int StatsWriterDrain(StatsWriterStruct *SW_ptr)
+   {
+   unsigned int ring_heads[SW_ptr->num_rings], ring_tails[SW_ptr->num_rings];
+   StatsRingStruct *ring_ptr;
+   FILE *OUTFILE = NULL;
+   int ring_num, num_recs, num_ready, rec_num, start_num, end_num;
+   unsigned long end_seq_num;
+   unsigned int pos;
+
+// Take a snapshot of each ring. Records published after this are picked up on the next pass.
+   num_recs = 0;
+   for ( ring_num = 0; ring_num < SW_ptr->num_rings; ring_num++ )
+      {
+      ring_ptr = &(SW_ptr->rings[ring_num]);
+      ring_heads[ring_num] = __atomic_load_n(&(ring_ptr->head), __ATOMIC_ACQUIRE);
+      for ( pos = ring_ptr->tail; pos != ring_heads[ring_num]; pos++ )
+         SW_ptr->batch[num_recs++] = &(ring_ptr->records[pos % STATS_WRITER_RING_SIZE]);
+      }
+
+   if ( num_recs == 0 )
+      return 0;
+
+// Keep only the run of seqs that follows the last record written. A missing seq belongs to a worker that has not
+// published it yet, so it and everything after it waits.
+   qsort(SW_ptr->batch, num_recs, sizeof(StatsRecordStruct *), StatsRecordSeqCompareFunc);
+   for ( num_ready = 0; num_ready < num_recs; num_ready++ )
+      if ( SW_ptr->batch[num_ready]->seq_num != SW_ptr->next_flush_seq_num + (unsigned long)num_ready )
+         break;
+
+   if ( num_ready == 0 )
+      return 0;
+   end_seq_num = SW_ptr->next_flush_seq_num + (unsigned long)num_ready;
+
+// A ring's seqs increase from tail to head, so the records it gives up are the ones at its tail below 'end_seq_num'.
+   for ( ring_num = 0; ring_num < SW_ptr->num_rings; ring_num++ )
+      {
+      ring_ptr = &(SW_ptr->rings[ring_num]);
+      for ( pos = ring_ptr->tail; pos != ring_heads[ring_num]; pos++ )
+         if ( ring_ptr->records[pos % STATS_WRITER_RING_SIZE].seq_num >= end_seq_num )
+            break;
+      ring_tails[ring_num] = pos;
+      }
+
+// Group the run by file, keeping seq order within each file, and open each file once. When the run has a 'create'
+// record for a file, the lines before it would be truncated anyway, so the file is opened "w" at the last one.
+   qsort(SW_ptr->batch, num_ready, sizeof(StatsRecordStruct *), StatsRecordCompareFunc);
+   for ( start_num = 0; start_num < num_ready; start_num = end_num )
+      {
+      StatsRecordStruct *rec_ptr = SW_ptr->batch[start_num];
+      int create_num = -1;
+
+      for ( end_num = start_num; end_num < num_ready; end_num++ )
+         {
+         if ( strcmp(SW_ptr->batch[end_num]->outfile_name, rec_ptr->outfile_name) != 0 )
+            break;
+         if ( SW_ptr->batch[end_num]->create == 1 )
+            create_num = end_num;
+         }
+
+      if ( (OUTFILE = fopen(rec_ptr->outfile_name, (create_num != -1) ? "w" : "a")) == NULL )
+         { printf("ERROR: StatsWriterDrain(): Data file '%s' open failed for writing!\n", rec_ptr->outfile_name); exit(EXIT_FAILURE); }
+      for ( rec_num = (create_num != -1) ? create_num : start_num; rec_num < end_num; rec_num++ )
+         fputs(SW_ptr->batch[rec_num]->text, OUTFILE);
+      fclose(OUTFILE);
+      }
+
+// Hand the slots back to the workers.
+   for ( ring_num = 0; ring_num < SW_ptr->num_rings; ring_num++ )
+      __atomic_store_n(&(SW_ptr->rings[ring_num].tail), ring_tails[ring_num], __ATOMIC_RELEASE);
+
+   SW_ptr->next_flush_seq_num = end_seq_num;
+   __atomic_add_fetch(&(SW_ptr->num_written), (unsigned long)num_ready, __ATOMIC_RELAXED);
+   SW_ptr->num_batches++;
+
+   return num_ready;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Flusher thread. Drains the rings every flush_interval_ms until StatsWriterShutdown() sets 'stop', then drains
+// whatever is left. No producer is active by then, so every seq taken has been published and no gap is left.
+
+static void *StatsWriterFlusherThread(void *arg)
+   {
+   StatsWriterStruct *SW_ptr = (StatsWriterStruct *)arg;
+
+   while ( __atomic_load_n(&(SW_ptr->stop), __ATOMIC_ACQUIRE) == 0 )
+      {
+      usleep(SW_ptr->flush_interval_ms * 1000);
+      StatsWriterDrain(SW_ptr);
+      }
+   while ( StatsWriterDrain(SW_ptr) > 0 );
+
+   return NULL;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Allocate one ring per worker slot and start the flusher thread.
+
+void StatsWriterInit(StatsWriterStruct *SW_ptr, int num_rings, int full_policy, int flush_interval_ms)
+   {
+   int ring_num, err;
+
+   if ( full_policy != STATS_WRITER_DROP && full_policy != STATS_WRITER_BLOCK )
+      { printf("ERROR: StatsWriterInit(): Unknown full_policy %d!\n", full_policy); exit(EXIT_FAILURE); }
+   if ( flush_interval_ms < 1 )
+      { printf("ERROR: StatsWriterInit(): flush_interval_ms %d MUST be >= 1!\n", flush_interval_ms); exit(EXIT_FAILURE); }
+
+   SW_ptr->num_rings = num_rings;
+   SW_ptr->full_policy = full_policy;
+   SW_ptr->flush_interval_ms = flush_interval_ms;
+   SW_ptr->next_seq_num = 0;
+   SW_ptr->next_flush_seq_num = 0;
+   SW_ptr->stop = 0;
+   SW_ptr->num_active = 0;
+   SW_ptr->num_rejected = 0;
+   SW_ptr->num_written = 0;
+   SW_ptr->num_batches = 0;
+
+   if ( (SW_ptr->rings = (StatsRingStruct *)calloc(num_rings, sizeof(StatsRingStruct))) == NULL )
+      { printf("ERROR: StatsWriterInit(): Failed to allocate storage for rings!\n"); exit(EXIT_FAILURE); }
+   for ( ring_num = 0; ring_num < num_rings; ring_num++ )
+      if ( (SW_ptr->rings[ring_num].records = (StatsRecordStruct *)malloc(sizeof(StatsRecordStruct) * STATS_WRITER_RING_SIZE)) == NULL )
+         { printf("ERROR: StatsWriterInit(): Failed to allocate storage for ring %d!\n", ring_num); exit(EXIT_FAILURE); }
+   if ( (SW_ptr->batch = (StatsRecordStruct **)malloc(sizeof(StatsRecordStruct *) * num_rings * STATS_WRITER_RING_SIZE)) == NULL )
+      { printf("ERROR: StatsWriterInit(): Failed to allocate storage for batch!\n"); exit(EXIT_FAILURE); }
+
+   if ( (err = pthread_create(&(SW_ptr->flusher_thread), NULL, StatsWriterFlusherThread, (void *)SW_ptr)) != 0 )
+      { printf("ERROR: StatsWriterInit(): Failed to create flusher thread: %d\n", err); exit(EXIT_FAILURE); }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Refuse new records, wait for the producers still adding one, stop the flusher after it has written every record
+// still in the rings, report the counts and free the rings. 'stop' stays set, so a late add is rejected without
+// touching the freed rings.
+
+void StatsWriterShutdown(StatsWriterStruct *SW_ptr)
+   {
+   unsigned long num_written, num_dropped, num_held;
+   int ring_num;
+
+// Sequentially consistent with the producers' increment of 'num_active' and load of 'stop' in StatsWriterEnter(), so 
+// either the producer sees 'stop' or this sees the producer.
+   __atomic_store_n(&(SW_ptr->stop), 1, __ATOMIC_SEQ_CST);
+   while ( __atomic_load_n(&(SW_ptr->num_active), __ATOMIC_SEQ_CST) > 0 )
+      usleep(STATS_WRITER_BLOCK_WAIT_US);
+   pthread_join(SW_ptr->flusher_thread, NULL);
+
+   num_held = 0;
+   for ( ring_num = 0; ring_num < SW_ptr->num_rings; ring_num++ )
+      num_held += SW_ptr->rings[ring_num].head - SW_ptr->rings[ring_num].tail;
+   if ( num_held != 0 )
+      { printf("ERROR: StatsWriterShutdown(): %lu records were never written!\n", num_held); exit(EXIT_FAILURE); }
+
+   StatsWriterGetCounts(SW_ptr, &num_written, &num_dropped);
+   printf("StatsWriterShutdown(): %lu records written in %lu batches, %lu dropped, %lu rejected after stop\n", num_written, 
+      SW_ptr->num_batches, num_dropped, SW_ptr->num_rejected); 
+   fflush(stdout);
+
+   for ( ring_num = 0; ring_num < SW_ptr->num_rings; ring_num++ )
+      free(SW_ptr->rings[ring_num].records);
+   free(SW_ptr->rings);
+   free(SW_ptr->batch);
+   SW_ptr->rings = NULL;
+   SW_ptr->batch = NULL;
+   SW_ptr->num_rings = 0;
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Count the calling producer in 'num_active'. Returns 0, with the add counted as rejected, once StatsWriterShutdown() 
+// has set 'stop'.
+
+static int StatsWriterEnter(StatsWriterStruct *SW_ptr)
+   {
+   __atomic_add_fetch(&(SW_ptr->num_active), 1, __ATOMIC_SEQ_CST);
+   if ( __atomic_load_n(&(SW_ptr->stop), __ATOMIC_SEQ_CST) == 1 )
+      {
+      __atomic_sub_fetch(&(SW_ptr->num_active), 1, __ATOMIC_SEQ_CST);
+      __atomic_add_fetch(&(SW_ptr->num_rejected), 1, __ATOMIC_RELAXED);
+      return 0;
+      }
+   return 1;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Wait (STATS_WRITER_BLOCK) or give up (STATS_WRITER_DROP) until 'num_recs' slots are free in the ring. Returns 1 when
+// the records can be added. A multi-record entry is dropped as a whole so a file never gets a partial line.
+
+static int StatsWriterReserve(StatsWriterStruct *SW_ptr, StatsRingStruct *ring_ptr, int num_recs)
+   {
+   unsigned int head = ring_ptr->head;
+
+   if ( num_recs > STATS_WRITER_RING_SIZE )
+      { printf("ERROR: StatsWriterReserve(): Entry of %d records exceeds STATS_WRITER_RING_SIZE %d!\n", num_recs, STATS_WRITER_RING_SIZE); exit(EXIT_FAILURE); }
+
+   while ( head - __atomic_load_n(&(ring_ptr->tail), __ATOMIC_ACQUIRE) + num_recs > STATS_WRITER_RING_SIZE )
+      {
+      if ( SW_ptr->full_policy == STATS_WRITER_DROP )
+         {
+         __atomic_add_fetch(&(ring_ptr->num_dropped), (unsigned long)num_recs, __ATOMIC_RELAXED);
+         return 0;
+         }
+      usleep(STATS_WRITER_BLOCK_WAIT_US);
+      }
+
+   return 1;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Add a formatted line (or lines) of text for 'outfile_name'. Called only by the worker that owns 'ring_num'. 'create'
+// truncates the file first. The text is cut at STATS_WRITER_MAX_TEXT_LEN - 1 characters.
+
+void StatsWriterPrintf(StatsWriterStruct *SW_ptr, int ring_num, char *outfile_name, int create, const char *format, ...)
+   {
+   StatsRingStruct *ring_ptr;
+   StatsRecordStruct *rec_ptr;
+   va_list args;
+
+   if ( StatsWriterEnter(SW_ptr) == 0 )
+      return;
+   ring_ptr = &(SW_ptr->rings[ring_num]);
+   if ( StatsWriterReserve(SW_ptr, ring_ptr, 1) == 0 )
+      {
+      __atomic_sub_fetch(&(SW_ptr->num_active), 1, __ATOMIC_SEQ_CST);
+      return;
+      }
+
+   rec_ptr = &(ring_ptr->records[ring_ptr->head % STATS_WRITER_RING_SIZE]);
+   rec_ptr->seq_num = __atomic_fetch_add(&(SW_ptr->next_seq_num), 1, __ATOMIC_RELAXED);
+   rec_ptr->create = create;
+   snprintf(rec_ptr->outfile_name, STATS_WRITER_MAX_NAME_LEN, "%s", outfile_name);
+   va_start(args, format);
+   vsnprintf(rec_ptr->text, STATS_WRITER_MAX_TEXT_LEN, format, args);
+   va_end(args);
+
+   __atomic_store_n(&(ring_ptr->head), ring_ptr->head + 1, __ATOMIC_RELEASE);
+   __atomic_sub_fetch(&(SW_ptr->num_active), 1, __ATOMIC_SEQ_CST);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Add a bitstring as one line of ASCII '0'/'1' characters, the format of WriteASCIIBitstringToFile(). Long bitstrings
+// are split across records with consecutive seqs, which the flusher writes back to back.
+
+void StatsWriterBitstring(StatsWriterStruct *SW_ptr, int ring_num, char *outfile_name, int create, int num_bits,
+   unsigned char *bitstring_binary)
+   {
+   StatsRingStruct *ring_ptr;
+   StatsRecordStruct *rec_ptr;
+   int chars_per_rec = STATS_WRITER_MAX_TEXT_LEN - 1;
+   int num_recs, rec_num, bit_num, char_num;
+   unsigned long seq_num;
+   unsigned int head;
+
+   if ( StatsWriterEnter(SW_ptr) == 0 )
+      return;
+   ring_ptr = &(SW_ptr->rings[ring_num]);
+
+// The trailing newline is one more character.
+   num_recs = (num_bits + 1 + chars_per_rec - 1)/chars_per_rec;
+   if ( StatsWriterReserve(SW_ptr, ring_ptr, num_recs) == 0 )
+      {
+      __atomic_sub_fetch(&(SW_ptr->num_active), 1, __ATOMIC_SEQ_CST);
+      return;
+      }
+
+// One range of seqs for the whole line so no other worker's record can land between its pieces.
+   seq_num = __atomic_fetch_add(&(SW_ptr->next_seq_num), (unsigned long)num_recs, __ATOMIC_RELAXED);
+   head = ring_ptr->head;
+   bit_num = 0;
+   for ( rec_num = 0; rec_num < num_recs; rec_num++ )
+      {
+      rec_ptr = &(ring_ptr->records[(head + rec_num) % STATS_WRITER_RING_SIZE]);
+      rec_ptr->seq_num = seq_num + (unsigned long)rec_num;
+      rec_ptr->create = (rec_num == 0) ? create : 0;
+      snprintf(rec_ptr->outfile_name, STATS_WRITER_MAX_NAME_LEN, "%s", outfile_name);
+      for ( char_num = 0; char_num < chars_per_rec && bit_num < num_bits; char_num++, bit_num++ )
+         rec_ptr->text[char_num] = '0' + GetBitFromByte(bitstring_binary[bit_num/8], bit_num % 8);
+      if ( bit_num == num_bits && char_num < chars_per_rec )
+         rec_ptr->text[char_num++] = '\n';
+      rec_ptr->text[char_num] = '\0';
+      }
+
+// Publish all the records at once so the flusher never sees part of the line.
+   __atomic_store_n(&(ring_ptr->head), head + num_recs, __ATOMIC_RELEASE);
+   __atomic_sub_fetch(&(SW_ptr->num_active), 1, __ATOMIC_SEQ_CST);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Number of records written so far and dropped because a ring was full.
+
+void StatsWriterGetCounts(StatsWriterStruct *SW_ptr, unsigned long *num_written_ptr, unsigned long *num_dropped_ptr)
+   {
+   int ring_num;
+
+   *num_written_ptr = __atomic_load_n(&(SW_ptr->num_written), __ATOMIC_RELAXED);
+   *num_dropped_ptr = 0;
+   for ( ring_num = 0; ring_num < SW_ptr->num_rings; ring_num++ )
+      *num_dropped_ptr += __atomic_load_n(&(SW_ptr->rings[ring_num].num_dropped), __ATOMIC_RELAXED);
+
+   return;
+   }
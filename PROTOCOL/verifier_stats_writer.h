@@ -0,0 +1,27 @@
+// ========================================================================================================
+// ========================================================================================================
+// *************************************** verifier_stats_writer.h ****************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+
+#ifndef STATS_WRITER_INCLUDED
+
+// How long a worker sleeps between checks of a full ring under STATS_WRITER_BLOCK.
+#define STATS_WRITER_BLOCK_WAIT_US 1000
+
+#define STATS_WRITER_INCLUDED
+#endif
+
+void StatsWriterInit(StatsWriterStruct *SW_ptr, int num_rings, int full_policy, int flush_interval_ms);
+void StatsWriterShutdown(StatsWriterStruct *SW_ptr);
+void StatsWriterPrintf(StatsWriterStruct *SW_ptr, int ring_num, char *outfile_name, int create, const char *format, ...);
+void StatsWriterBitstring(StatsWriterStruct *SW_ptr, int ring_num, char *outfile_name, int create, int num_bits,
+   unsigned char *bitstring_binary);
+void StatsWriterGetCounts(StatsWriterStruct *SW_ptr, unsigned long *num_written_ptr, unsigned long *num_dropped_ptr);
@@ -0,0 +1,406 @@
+// ========================================================================================================
+// ========================================================================================================
+// ****************************************** worker_slab_test.c ******************************************
+// ========================================================================================================
+// ========================================================================================================
+//
+//--------------------------------------------------------------------------------
+// Company: IC-Safety, LLC and University of New Mexico
+// Engineer: Professor Jim Plusquellic
+// Exclusive License: IC-Safety, LLC
+// Copyright: Univ. of New Mexico
+//--------------------------------------------------------------------------------
+//
+// Malloc-counting test of the per-worker slab (WorkerSlabStruct). The program is linked with malloc, calloc,
+// realloc and free wrapped (-Wl,--wrap=...), so every heap call made by the verifier code is counted. Over a
+// synthetic PN cache (float and compact layouts), each trial does what one authentication attempt does with the
+// slab once the challenge is known: GetAllPUFInstanceTimingValsForChallenge() into the slab PN block, the PopOnly
+// SpreadFactors in ComputePxxSpreadFactors() with the PO distribution flip, the per-attempt SpreadFactor and
+// XMR_SHD buffers from WorkerSlabGrow(), the device authentication search in KEK_DA_SKE_FindMatch() over the
+// received (here random) SpreadFactors and XMR_SHD, and the release at the end of the attempt in 
+// KEK_ClientServerAuthen(). After a warm-up trial that sizes the slab for the largest number of target attempts, 
+// these MUST make 0 heap calls. The same trials without the slab MUST make heap calls (so the counting works) and 
+// produce identical SpreadFactors and search results.
+//
+// The challenge itself is selected here, outside the counted region. GenChallengeDB(), FreeVectorsAndMasks()
+// and the SQLite calls, including the PUFInstance lookup after a successful authentication (my_chip_num is set
+// to a chip that does not exist so the search never succeeds), are not covered by the slab and still allocate 
+// on every attempt. So does glibc's qsort() of the per-chip scores for large chip counts (not with 20 chips).
+//
+// Usage: worker_slab_test [num_trials]
+
+#include "common.h"
+#include "verifier_common.h"
+#include "verifier_regen_funcs.h"
+
+#define TEST_NUM_CHIPS 20
+#define TEST_NUM_VECPAIRS 96
+#define TEST_NUM_POS 64
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t num, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static int Count_heap_calls = 0;
+static long Num_heap_calls = 0;
+
+static unsigned long long Test_rng_state = 0x2545F4914F6CDD1DULL;
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Heap call counters, active while Count_heap_calls is 1. The test is single-threaded.
+
+void *__wrap_malloc(size_t size)
+   {
+   if ( Count_heap_calls == 1 )
+      Num_heap_calls++;
+   return __real_malloc(size);
+   }
+
+void *__wrap_calloc(size_t num, size_t size)
+   {
+   if ( Count_heap_calls == 1 )
+      Num_heap_calls++;
+   return __real_calloc(num, size);
+   }
+
+void *__wrap_realloc(void *ptr, size_t size)
+   {
+   if ( Count_heap_calls == 1 )
+      Num_heap_calls++;
+   return __real_realloc(ptr, size);
+   }
+
+void __wrap_free(void *ptr)
+   {
+   if ( Count_heap_calls == 1 )
+      Num_heap_calls++;
+   __real_free(ptr);
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// xorshift64 for the test data.
+
+static unsigned int TestRand()
+   {
+   Test_rng_state ^= Test_rng_state >> 12;
+   Test_rng_state ^= Test_rng_state << 25;
+   Test_rng_state ^= Test_rng_state >> 27;
+   return (unsigned int)((Test_rng_state * 0x2545F4914F6CDD1DULL) >> 32);
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Synthetic PN cache: TEST_NUM_VECPAIRS VecPairs (the first half rising) with TEST_NUM_POS POs each, stored in a
+// shuffled order like the cache built from the database. The PNs are multiples of 1/16 with a spread well under
+// DIST_RANGE.
+
+static void BuildCache(TimingValCacheStruct **TVC_arr_ptr, int *num_TVC_arr_ptr)
+   {
+   TimingValCacheStruct temp_TVC;
+   int TVC_num, swap_num, chip_num, num_TVC_arr;
+
+   num_TVC_arr = TEST_NUM_VECPAIRS * TEST_NUM_POS;
+   if ( (*TVC_arr_ptr = (TimingValCacheStruct *)malloc(sizeof(TimingValCacheStruct) * num_TVC_arr)) == NULL )
+      { printf("ERROR: BuildCache(): Failed to allocate storage for TVC_arr!\n"); exit(EXIT_FAILURE); }
+
+   for ( TVC_num = 0; TVC_num < num_TVC_arr; TVC_num++ )
+      {
+      (*TVC_arr_ptr)[TVC_num].vecpair_id = 1 + TVC_num/TEST_NUM_POS;
+      (*TVC_arr_ptr)[TVC_num].PO_num = TVC_num % TEST_NUM_POS;
+      (*TVC_arr_ptr)[TVC_num].rise_or_fall = (TVC_num/TEST_NUM_POS >= TEST_NUM_VECPAIRS/2);
+      if ( ((*TVC_arr_ptr)[TVC_num].PNs = (float *)malloc(sizeof(float) * TEST_NUM_CHIPS)) == NULL )
+         { printf("ERROR: BuildCache(): Failed to allocate storage for PNs!\n"); exit(EXIT_FAILURE); }
+      for ( chip_num = 0; chip_num < TEST_NUM_CHIPS; chip_num++ )
+         (*TVC_arr_ptr)[TVC_num].PNs[chip_num] = (float)(300*16 + (int)(TestRand() % (400*16)))/16.0f;
+      }
+
+   for ( TVC_num = num_TVC_arr - 1; TVC_num > 0; TVC_num-- )
+      {
+      swap_num = (int)(TestRand() % (TVC_num + 1));
+      temp_TVC = (*TVC_arr_ptr)[TVC_num];
+      (*TVC_arr_ptr)[TVC_num] = (*TVC_arr_ptr)[swap_num];
+      (*TVC_arr_ptr)[swap_num] = temp_TVC;
+      }
+
+   *num_TVC_arr_ptr = num_TVC_arr;
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// In-memory database with the PUFInstance table only. Without the slab, GetAllPUFInstanceTimingValsForChallenge()
+// looks up the PUFInstance IDs, one per chip of the cache.
+
+static sqlite3 *OpenInstanceDB()
+   {
+   char sql_command_str[MAX_STRING_LEN];
+   sqlite3 *db;
+   int chip_num;
+
+   if ( sqlite3_open(":memory:", &db) != SQLITE_OK )
+      { printf("ERROR: OpenInstanceDB(): Failed to open in-memory database!\n"); exit(EXIT_FAILURE); }
+   if ( sqlite3_exec(db, "CREATE TABLE PUFInstance (ID INTEGER PRIMARY KEY, Instance_name TEXT);", NULL, NULL, NULL) != SQLITE_OK )
+      { printf("ERROR: OpenInstanceDB(): %s\n", sqlite3_errmsg(db)); exit(EXIT_FAILURE); }
+   for ( chip_num = 0; chip_num < TEST_NUM_CHIPS; chip_num++ )
+      {
+      sprintf(sql_command_str, "INSERT INTO PUFInstance (Instance_name) VALUES ('C%d');", chip_num);
+      if ( sqlite3_exec(db, sql_command_str, NULL, NULL, NULL) != SQLITE_OK )
+         { printf("ERROR: OpenInstanceDB(): %s\n", sqlite3_errmsg(db)); exit(EXIT_FAILURE); }
+      }
+
+   return db;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// Random challenge of NUM_REQUIRED_PNS distinct (vecpair, PO), the rise PNs first. Stands in for GenChallengeDB().
+
+static void SelectChallenge(VecPairPOStruct *challenge_vecpair_id_PO_arr)
+   {
+   int rise_fall, rec_num, num_PNs, pick_num, PN_num, temp_PN;
+   int PN_nums[TEST_NUM_VECPAIRS/2 * TEST_NUM_POS];
+
+   num_PNs = TEST_NUM_VECPAIRS/2 * TEST_NUM_POS;
+   rec_num = 0;
+   for ( rise_fall = 0; rise_fall < 2; rise_fall++ )
+      {
+      for ( PN_num = 0; PN_num < num_PNs; PN_num++ )
+         PN_nums[PN_num] = rise_fall * num_PNs + PN_num;
+      for ( pick_num = 0; pick_num < NUM_REQUIRED_PNS/2; pick_num++ )
+         {
+         PN_num = pick_num + (int)(TestRand() % (num_PNs - pick_num));
+         temp_PN = PN_nums[pick_num];
+         PN_nums[pick_num] = PN_nums[PN_num];
+         PN_nums[PN_num] = temp_PN;
+         challenge_vecpair_id_PO_arr[rec_num].vecpair_id = 1 + PN_nums[pick_num]/TEST_NUM_POS;
+         challenge_vecpair_id_PO_arr[rec_num].PO_num = PN_nums[pick_num] % TEST_NUM_POS;
+         rec_num++;
+         }
+      }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// The fields of SRFAlgoParamsStruct used by the timing fetch, the PopOnly SpreadFactors and the device
+// authentication search (fixed parameters, no scaling, no stats files and no search pool).
+
+static void InitSAP(SRFAlgoParamsStruct *SAP_ptr, int use_worker_slab, unsigned char *KEK_authentication_nonce)
+   {
+   memset(SAP_ptr, 0, sizeof(SRFAlgoParamsStruct));
+   SAP_ptr->num_required_PNDiffs = NUM_REQUIRED_PNDIFFS;
+   SAP_ptr->num_SF_words = NUM_REQUIRED_PNDIFFS;
+   SAP_ptr->iSpreadFactorScaler = 2;
+   SAP_ptr->dist_range = DIST_RANGE;
+   SAP_ptr->range_low_limit = RANGE_LOW_LIMIT;
+   SAP_ptr->range_high_limit = RANGE_HIGH_LIMIT;
+   SAP_ptr->use_TVC_cache = 1;
+   SAP_ptr->do_PO_dist_flip = 1;
+   SAP_ptr->use_worker_slab = use_worker_slab;
+   SAP_ptr->fix_params = 1;
+   SAP_ptr->XMR_val = XMR_VAL;
+   SAP_ptr->num_KEK_authen_nonce_bits = KEK_AUTHEN_NUM_NONCE_BITS;
+   SAP_ptr->KEK_authentication_nonce = KEK_authentication_nonce;
+   SAP_ptr->my_chip_num = TEST_NUM_CHIPS;
+   SAP_ptr->DA_search_pool_ptr = NULL;
+
+   if ( (SAP_ptr->fPNDco = (float *)calloc(SAP_ptr->num_required_PNDiffs, sizeof(float))) == NULL )
+      { printf("ERROR: InitSAP(): Failed to allocate storage for fPNDco!\n"); exit(EXIT_FAILURE); }
+   if ( (SAP_ptr->fSpreadFactors = (float *)calloc(SAP_ptr->num_SF_words, sizeof(float))) == NULL )
+      { printf("ERROR: InitSAP(): Failed to allocate storage for fSpreadFactors!\n"); exit(EXIT_FAILURE); }
+   if ( (SAP_ptr->iSpreadFactors = (signed char *)calloc(SAP_ptr->num_SF_words, sizeof(signed char))) == NULL )
+      { printf("ERROR: InitSAP(): Failed to allocate storage for iSpreadFactors!\n"); exit(EXIT_FAILURE); }
+
+   if ( use_worker_slab == 1 )
+      WorkerSlabInit(&(SAP_ptr->slab), TEST_NUM_CHIPS, SAP_ptr->num_required_PNDiffs, SAP_ptr->num_SF_words, WORKER_SLAB_INIT_ATTEMPTS);
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+// One authentication attempt on a known challenge, following GenVecSeedChlngsTimingData(), the PopOnly part of
+// ComputeSendSpreadFactors(), KEK_DeviceAuthentication_SKE() for 'num_attempts' target attempts and the release
+// in KEK_ClientServerAuthen(). 'db' is only read without the slab. The device sends 'received_SF' and 'received_SHD'.
+// The PopOnly SpreadFactors are copied to PO_fSF and PO_iSF before the search overwrites them.
+
+static void RunAttempt(SRFAlgoParamsStruct *SAP_ptr, sqlite3 *db, VecPairPOStruct *challenge_vecpair_id_PO_arr, TimingValCacheStruct *TVC_arr,
+   int num_TVC_arr, TimingValCacheCompactStruct *TVCC_ptr, TimingValCacheIndexStruct *TVCI_ptr, int num_attempts, signed char *received_SF,
+   unsigned char *received_SHD, float *PO_fSF, signed char *PO_iSF)
+   {
+   int SF_num_bytes, SHD_num_bytes;
+
+   signed char *authen_SF;
+   unsigned char *authen_XMR_SHD;
+
+   if ( SAP_ptr->use_worker_slab == 1 )
+      {
+      SAP_ptr->PNR = SAP_ptr->slab.PNR_rows;
+      SAP_ptr->PNF = SAP_ptr->slab.PNF_rows;
+      GetAllPUFInstanceTimingValsForChallenge(MAX_STRING_LEN, db, challenge_vecpair_id_PO_arr, NUM_REQUIRED_PNS, "%",
+         &(SAP_ptr->PNR), &(SAP_ptr->PNF), &(SAP_ptr->num_chips), TVC_arr, num_TVC_arr, TVCC_ptr, TVCI_ptr, 1,
+         SAP_ptr->slab.PN_block, SAP_ptr->slab.num_chips);
+      }
+   else
+      GetAllPUFInstanceTimingValsForChallenge(MAX_STRING_LEN, db, challenge_vecpair_id_PO_arr, NUM_REQUIRED_PNS, "%",
+         &(SAP_ptr->PNR), &(SAP_ptr->PNF), &(SAP_ptr->num_chips), TVC_arr, num_TVC_arr, TVCC_ptr, TVCI_ptr, 1, NULL, 0);
+
+   ComputePxxSpreadFactors(MAX_STRING_LEN, SAP_ptr, 0);
+   memcpy(PO_fSF, SAP_ptr->fSpreadFactors, sizeof(float) * SAP_ptr->num_SF_words);
+   memcpy(PO_iSF, SAP_ptr->iSpreadFactors, SAP_ptr->num_SF_words);
+
+   SF_num_bytes = num_attempts * SAP_ptr->num_SF_words;
+   SHD_num_bytes = num_attempts * SAP_ptr->num_required_PNDiffs/8;
+   if ( SAP_ptr->use_worker_slab == 1 )
+      {
+      SAP_ptr->slab.authen_SF = (signed char *)WorkerSlabGrow(&(SAP_ptr->slab), SAP_ptr->slab.authen_SF, &(SAP_ptr->slab.authen_SF_size),
+         SF_num_bytes, "authen_SF");
+      SAP_ptr->slab.authen_XMR_SHD = (unsigned char *)WorkerSlabGrow(&(SAP_ptr->slab), SAP_ptr->slab.authen_XMR_SHD,
+         &(SAP_ptr->slab.authen_XMR_SHD_size), SHD_num_bytes, "authen_XMR_SHD");
+      memcpy(SAP_ptr->slab.authen_SF, received_SF, SF_num_bytes);
+      memcpy(SAP_ptr->slab.authen_XMR_SHD, received_SHD, SHD_num_bytes);
+
+      KEK_DA_SKE_FindMatch(MAX_STRING_LEN, SAP_ptr, SHD_num_bytes, SAP_ptr->slab.authen_XMR_SHD, SAP_ptr->slab.authen_SF, 
+         FUNC_DA, 0);
+
+      SAP_ptr->PNR = NULL;
+      SAP_ptr->PNF = NULL;
+      SAP_ptr->num_chips = 0;
+      }
+   else
+      {
+      if ( (authen_SF = (signed char *)malloc(SF_num_bytes)) == NULL )
+         { printf("ERROR: RunAttempt(): Failed to allocate storage for authen_SF!\n"); exit(EXIT_FAILURE); }
+      if ( (authen_XMR_SHD = (unsigned char *)malloc(SHD_num_bytes)) == NULL )
+         { printf("ERROR: RunAttempt(): Failed to allocate storage for authen_XMR_SHD!\n"); exit(EXIT_FAILURE); }
+      memcpy(authen_SF, received_SF, SF_num_bytes);
+      memcpy(authen_XMR_SHD, received_SHD, SHD_num_bytes);
+
+      KEK_DA_SKE_FindMatch(MAX_STRING_LEN, SAP_ptr, SHD_num_bytes, authen_XMR_SHD, authen_SF, FUNC_DA, 0);
+
+      free(authen_SF);
+      free(authen_XMR_SHD);
+
+      FreeAllTimingValsForChallenge(&(SAP_ptr->num_chips), &(SAP_ptr->PNR), &(SAP_ptr->PNF));
+      }
+
+   return;
+   }
+
+
+// ========================================================================================================
+// ========================================================================================================
+
+int main(int argc, char *argv[])
+   {
+   int num_trials;
+
+   SRFAlgoParamsStruct SAP_slab, SAP_heap;
+   TimingValCacheStruct *TVC_arr;
+   TimingValCacheCompactStruct TVCC;
+   TimingValCacheIndexStruct TVCI;
+   VecPairPOStruct challenge_vecpair_id_PO_arr[NUM_REQUIRED_PNS];
+   TimingValCacheCompactStruct *TVCC_ptr;
+   sqlite3 *db;
+   unsigned char KEK_authentication_nonce[KEK_AUTHEN_NUM_NONCE_BITS/8];
+   signed char *received_SF, slab_PO_iSF[NUM_REQUIRED_PNDIFFS], heap_PO_iSF[NUM_REQUIRED_PNDIFFS];
+   float slab_PO_fSF[NUM_REQUIRED_PNDIFFS], heap_PO_fSF[NUM_REQUIRED_PNDIFFS];
+   unsigned char *received_SHD;
+   long num_slab_calls, num_heap_calls;
+   int num_TVC_arr, trial_num, num_attempts, max_attempts, num_errors, i;
+
+   num_trials = 40;
+   if ( argc > 1 )
+      num_trials = atoi(argv[1]);
+   if ( num_trials <= 0 )
+      { printf("Usage: worker_slab_test [num_trials]\n"); exit(EXIT_FAILURE); }
+
+   db = OpenInstanceDB();
+   BuildCache(&TVC_arr, &num_TVC_arr);
+   CreateTimingValsCacheIndex(TVC_arr, num_TVC_arr, &TVCI);
+   CreateTimingValsCacheCompact(TVC_arr, num_TVC_arr, TEST_NUM_CHIPS, &TVCC);
+
+   InitSAP(&SAP_slab, 1, KEK_authentication_nonce);
+   InitSAP(&SAP_heap, 0, KEK_authentication_nonce);
+
+   num_errors = 0;
+   max_attempts = 2*WORKER_SLAB_INIT_ATTEMPTS;
+   if ( (received_SF = (signed char *)malloc(max_attempts * NUM_REQUIRED_PNDIFFS)) == NULL ||
+      (received_SHD = (unsigned char *)malloc(max_attempts * NUM_REQUIRED_PNDIFFS/8)) == NULL )
+      { printf("ERROR: main(): Failed to allocate storage for the received SpreadFactors and XMR_SHD!\n"); exit(EXIT_FAILURE); }
+   for ( trial_num = 0; trial_num <= num_trials; trial_num++ )
+      {
+
+// Trial 0 is the warm-up. It asks for the most target attempts so the slab buffers grow once.
+      SelectChallenge(challenge_vecpair_id_PO_arr);
+      TVCC_ptr = (trial_num % 2 == 0) ? NULL : &TVCC;
+// The search needs 2 target attempts with random XMR_SHD (about half the bits strong) to reproduce the nonce, so ask for at least 4.
+      num_attempts = (trial_num == 0) ? max_attempts : 4 + (int)(TestRand() % (max_attempts - 3));
+      for ( i = 0; i < num_attempts * NUM_REQUIRED_PNDIFFS; i++ )
+         received_SF[i] = (signed char)((int)(TestRand() % 33) - 16);
+      for ( i = 0; i < num_attempts * NUM_REQUIRED_PNDIFFS/8; i++ )
+         received_SHD[i] = (unsigned char)TestRand();
+      for ( i = 0; i < KEK_AUTHEN_NUM_NONCE_BITS/8; i++ )
+         KEK_authentication_nonce[i] = (unsigned char)TestRand();
+
+      SAP_slab.param_LFSR_seed_low = SAP_heap.param_LFSR_seed_low = TestRand() % NUM_REQUIRED_PNDIFFS;
+      SAP_slab.param_LFSR_seed_high = SAP_heap.param_LFSR_seed_high = TestRand() % NUM_REQUIRED_PNDIFFS;
+      SAP_slab.param_RangeConstant = SAP_heap.param_RangeConstant = RANGE_CONSTANT;
+      SAP_slab.param_SpreadConstant = SAP_heap.param_SpreadConstant = SPREAD_CONSTANT;
+      SAP_slab.param_TrimCodeConstant = SAP_heap.param_TrimCodeConstant = TRIMCODE_CONSTANT;
+      SAP_slab.chip_num = SAP_heap.chip_num = (int)(TestRand() % TEST_NUM_CHIPS);
+
+      Num_heap_calls = 0;
+      Count_heap_calls = 1;
+      RunAttempt(&SAP_slab, db, challenge_vecpair_id_PO_arr, TVC_arr, num_TVC_arr, TVCC_ptr, &TVCI, num_attempts, received_SF, received_SHD,
+         slab_PO_fSF, slab_PO_iSF);
+      Count_heap_calls = 0;
+      num_slab_calls = Num_heap_calls;
+
+      Num_heap_calls = 0;
+      Count_heap_calls = 1;
+      RunAttempt(&SAP_heap, db, challenge_vecpair_id_PO_arr, TVC_arr, num_TVC_arr, TVCC_ptr, &TVCI, num_attempts, received_SF, received_SHD,
+         heap_PO_fSF, heap_PO_iSF);
+      Count_heap_calls = 0;
+      num_heap_calls = Num_heap_calls;
+
+      printf("Trial %3d\t%s cache\tAttempts %2d\tHeap calls with slab %ld\twithout %ld\n", trial_num, (TVCC_ptr == NULL) ? "float  " : "compact",
+         num_attempts, num_slab_calls, num_heap_calls);
+
+      if ( trial_num > 0 && num_slab_calls != 0 )
+         { printf("\tTrial %d: %ld heap calls with the slab after warm-up!\n", trial_num, num_slab_calls); num_errors++; }
+      if ( num_heap_calls == 0 )
+         { printf("\tTrial %d: no heap calls counted without the slab!\n", trial_num); num_errors++; }
+      if ( memcmp(slab_PO_fSF, heap_PO_fSF, sizeof(float) * NUM_REQUIRED_PNDIFFS) != 0 || memcmp(slab_PO_iSF, heap_PO_iSF, NUM_REQUIRED_PNDIFFS) != 0 )
+         { printf("\tTrial %d: SpreadFactors differ with and without the slab!\n", trial_num); num_errors++; }
+      if ( SAP_slab.chip_num != -1 || SAP_heap.chip_num != -1 || SAP_slab.param_LFSR_seed_high != SAP_heap.param_LFSR_seed_high )
+         { printf("\tTrial %d: search results differ with and without the slab (or a chip was authenticated)!\n", trial_num); num_errors++; }
+      }
+
+   if ( SAP_slab.slab.num_grows != 2 )
+      { printf("\tSlab buffers grew %d times, expected 2 (warm-up only)!\n", SAP_slab.slab.num_grows); num_errors++; }
+
+   free(received_SF);
+   free(received_SHD);
+
+   SQLStmtCacheFinalize(NULL);
+   sqlite3_close(db);
+
+   if ( num_errors != 0 )
+      { printf("ERROR: main(): %d checks FAILED!\n", num_errors); exit(EXIT_FAILURE); }
+   printf("All tests PASSED\n");
+
+   return 0;
+   }